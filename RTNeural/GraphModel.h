@@ -0,0 +1,449 @@
+#pragma once
+
+#include "model_loader.h"
+#include <algorithm>
+#include <map>
+#include <memory>
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ *  A dynamic neural network model, where each node computes its outputs
+ *  from the outputs of one or more of the previous nodes, so that the
+ *  model can have parallel branches and skip connections:
+ *  ```
+ *  GraphModel<float> model(4);
+ *  auto conv = model.addLayer(new Conv1D<float>(4, 4, 3, 1), GraphModel<float>::input_node);
+ *  auto act = model.addLayer(new TanhActivation<float>(4), conv);
+ *  auto res = model.addAdd({ act, GraphModel<float>::input_node });
+ *  model.setOutput(model.addLayer(new Dense<float>(4, 1), res));
+ *  model.prepare();
+ *  ```
+ *
+ *  Besides layers, the nodes can add or multiply the outputs of other nodes
+ *  element-wise, concatenate them, or split a slice out of them.
+ *
+ *  Before running the model, prepare() plans the buffers for the node
+ *  outputs: a node's buffer is given to a later node once all of the nodes
+ *  that read it have run, so the branches of the model share memory where
+ *  their lifetimes allow.
+ *
+ *  Instances of this class are typically created with `json_parser::parseGraphJson`.
+ *  Layers that change the frame rate (e.g. StridedConv1D) are not supported.
+ */
+template <typename T>
+class GraphModel
+{
+public:
+    /** The node ID of the model input. */
+    static constexpr int input_node = 0;
+
+    /** The operation computed by a node. */
+    enum class NodeType
+    {
+        Input,
+        Layer,
+        Add,
+        Multiply,
+        Concat,
+        Split,
+    };
+
+    /** Constructs a graph model for a given input size. */
+    explicit GraphModel(int in_size)
+        : in_size(in_size)
+    {
+        nodes.push_back({ NodeType::Input, nullptr, {}, in_size, 0, -1 });
+    }
+
+    /** Returns the model's input size */
+    int getInSize() const noexcept { return in_size; }
+
+    /** Returns the model's output size */
+    int getOutSize() const noexcept { return nodes[(size_t)output_node].size; }
+
+    /** Returns the number of nodes in the model, including the input node. */
+    int getNumNodes() const noexcept { return (int)nodes.size(); }
+
+    /** Returns the output size of a node. */
+    int getNodeSize(int node) const noexcept { return nodes[(size_t)node].size; }
+
+    /** Returns the layer computed by a node, or nullptr if the node doesn't compute a layer. */
+    Layer<T>* getLayer(int node) const noexcept { return nodes[(size_t)node].layer.get(); }
+
+    /**
+     * Adds a node that runs a layer on the outputs of another node, and
+     * returns the ID of the new node. The model takes ownership of the layer.
+     */
+    int addLayer(Layer<T>* layer, int input)
+    {
+        return addNode({ NodeType::Layer, std::unique_ptr<Layer<T>>(layer), { input }, layer->out_size, 0, -1 });
+    }
+
+    /** Adds a node that adds the outputs of some nodes (of the same size) element-wise. */
+    int addAdd(const std::vector<int>& inputs)
+    {
+        return addNode({ NodeType::Add, nullptr, inputs, getNodeSize(inputs.front()), 0, -1 });
+    }
+
+    /** Adds a node that multiplies the outputs of some nodes (of the same size) element-wise. */
+    int addMultiply(const std::vector<int>& inputs)
+    {
+        return addNode({ NodeType::Multiply, nullptr, inputs, getNodeSize(inputs.front()), 0, -1 });
+    }
+
+    /** Adds a node that concatenates the outputs of some nodes. */
+    int addConcat(const std::vector<int>& inputs)
+    {
+        int size = 0;
+        for(auto input : inputs)
+            size += getNodeSize(input);
+        return addNode({ NodeType::Concat, nullptr, inputs, size, 0, -1 });
+    }
+
+    /** Adds a node that outputs the values [offset, offset + size) of the outputs of another node. */
+    int addSplit(int input, int offset, int size)
+    {
+        return addNode({ NodeType::Split, nullptr, { input }, size, offset, -1 });
+    }
+
+    /** Sets the node whose outputs are the model outputs (by default, the last node). */
+    void setOutput(int node) noexcept { output_node = node; }
+
+    /** Returns the node whose outputs are the model outputs. */
+    int getOutput() const noexcept { return output_node; }
+
+    /**
+     * Plans the buffers for the node outputs, and allocates them.
+     * This must be called after the last node is added, and before
+     * running the model.
+     */
+    void prepare()
+    {
+        // the last node that reads the outputs of each node
+        std::vector<int> last_use(nodes.size());
+        for(size_t i = 0; i < nodes.size(); ++i)
+        {
+            last_use[i] = (int)i;
+            for(auto input : nodes[i].inputs)
+                last_use[(size_t)input] = (int)i;
+        }
+        last_use[(size_t)output_node] = (int)nodes.size();
+
+        std::vector<int> capacities;
+        std::vector<int> free_buffers;
+        for(size_t i = 1; i < nodes.size(); ++i)
+        {
+            auto& node = nodes[i];
+
+            // the smallest free buffer that fits the node outputs, or else the largest free buffer, grown to fit
+            auto best = free_buffers.end();
+            for(auto it = free_buffers.begin(); it != free_buffers.end(); ++it)
+            {
+                const auto fits = capacities[(size_t)*it] >= node.size;
+                if(best == free_buffers.end())
+                {
+                    best = it;
+                    continue;
+                }
+
+                const auto best_fits = capacities[(size_t)*best] >= node.size;
+                if((fits && (!best_fits || capacities[(size_t)*it] < capacities[(size_t)*best]))
+                    || (!fits && !best_fits && capacities[(size_t)*it] > capacities[(size_t)*best]))
+                    best = it;
+            }
+
+            if(best == free_buffers.end())
+            {
+                node.buffer = (int)capacities.size();
+                capacities.push_back(node.size);
+            }
+            else
+            {
+                node.buffer = *best;
+                capacities[(size_t)node.buffer] = std::max(capacities[(size_t)node.buffer], node.size);
+                free_buffers.erase(best);
+            }
+
+            // the buffers of the node inputs are only given away once the node has read them
+            for(size_t j = 1; j <= i; ++j)
+            {
+                if(last_use[j] == (int)i && nodes[j].buffer >= 0
+                    && std::find(free_buffers.begin(), free_buffers.end(), nodes[j].buffer) == free_buffers.end())
+                    free_buffers.push_back(nodes[j].buffer);
+            }
+        }
+
+        buffers.clear();
+        for(auto capacity : capacities)
+            buffers.push_back(vec_type((size_t)capacity, (T)0));
+    }
+
+    /** Returns the number of buffers used for the node outputs. */
+    int getNumBuffers() const noexcept { return (int)buffers.size(); }
+
+    /** Resets the state of the network layers. */
+    RTNEURAL_REALTIME void reset()
+    {
+        for(auto& node : nodes)
+            if(node.layer != nullptr)
+                node.layer->reset();
+    }
+
+    /** Performs forward propagation for this model. */
+    RTNEURAL_REALTIME inline T forward(const T* input) noexcept
+    {
+        for(size_t i = 1; i < nodes.size(); ++i)
+        {
+            const auto& node = nodes[i];
+            auto* out = buffers[(size_t)node.buffer].data();
+            const auto* in = getNodeOutputs(node.inputs[0], input);
+
+            switch(node.type)
+            {
+            case NodeType::Layer:
+                node.layer->forward(in, out);
+                break;
+            case NodeType::Add:
+                std::copy(in, in + node.size, out);
+                for(size_t j = 1; j < node.inputs.size(); ++j)
+                {
+                    const auto* in_j = getNodeOutputs(node.inputs[j], input);
+                    for(int k = 0; k < node.size; ++k)
+                        out[k] += in_j[k];
+                }
+                break;
+            case NodeType::Multiply:
+                std::copy(in, in + node.size, out);
+                for(size_t j = 1; j < node.inputs.size(); ++j)
+                {
+                    const auto* in_j = getNodeOutputs(node.inputs[j], input);
+                    for(int k = 0; k < node.size; ++k)
+                        out[k] *= in_j[k];
+                }
+                break;
+            case NodeType::Concat:
+                for(auto input_node_j : node.inputs)
+                {
+                    const auto* in_j = getNodeOutputs(input_node_j, input);
+                    out = std::copy(in_j, in_j + getNodeSize(input_node_j), out);
+                }
+                break;
+            case NodeType::Split:
+                std::copy(in + node.offset, in + node.offset + node.size, out);
+                break;
+            case NodeType::Input:
+                break;
+            }
+        }
+
+        return getOutputs()[0];
+    }
+
+    /** Returns a pointer to the outputs of the model's output node. */
+    RTNEURAL_REALTIME inline const T* getOutputs() const noexcept
+    {
+        return buffers[(size_t)nodes[(size_t)output_node].buffer].data();
+    }
+
+private:
+    struct Node
+    {
+        NodeType type;
+        std::unique_ptr<Layer<T>> layer;
+        std::vector<int> inputs;
+        int size;
+        int offset;
+        int buffer;
+    };
+
+    int addNode(Node&& node)
+    {
+        nodes.push_back(std::move(node));
+        output_node = (int)nodes.size() - 1;
+        return output_node;
+    }
+
+    RTNEURAL_REALTIME inline const T* getNodeOutputs(int node, const T* input) const noexcept
+    {
+        return node == input_node ? input : buffers[(size_t)nodes[(size_t)node].buffer].data();
+    }
+
+#if RTNEURAL_USE_XSIMD
+    using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
+#elif RTNEURAL_USE_EIGEN
+    using vec_type = std::vector<T, Eigen::aligned_allocator<T>>;
+#else
+    using vec_type = std::vector<T>;
+#endif
+
+    const int in_size;
+    std::vector<Node> nodes;
+    int output_node = input_node;
+    std::vector<vec_type> buffers;
+};
+
+namespace json_parser
+{
+    /** Returns true if the json layer is a graph operation (rather than a layer). */
+    inline bool isGraphOperation(const std::string& type)
+    {
+        return type == "add" || type == "multiply" || type == "concat" || type == "split";
+    }
+
+    /**
+     * Creates a graph model from a json stream.
+     *
+     * The json has the same format as for `parseJson()`, except that each
+     * layer may have a "name", and a list of "inputs", naming the layers
+     * whose outputs it takes as inputs ("input" is the model input). A layer
+     * without "inputs" takes the outputs of the previous layer. As well as
+     * the usual layers, the "add", "multiply", and "concat" layers combine
+     * the outputs of all of their inputs, and a "split" layer outputs the
+     * values [offset, offset + size) of its input, where "offset" is given,
+     * and the size is the layer shape. The model outputs are the outputs of
+     * the layer named by "output", or else of the last layer:
+     * ```
+     * {
+     *   "in_shape": [null, null, 4],
+     *   "layers": [
+     *     { "type": "conv1d", "name": "conv", "activation": "tanh", ... },
+     *     { "type": "add", "name": "res", "inputs": ["conv", "input"], "shape": [null, null, 4] },
+     *     { "type": "dense", "inputs": ["res"], ... }
+     *   ]
+     * }
+     * ```
+     */
+    template <typename T, typename MathsProvider = DefaultMathsProvider>
+    std::unique_ptr<GraphModel<T>> parseGraphJson(const nlohmann::json& parent, const bool debug = false)
+    {
+        const auto shape = parent.at("in_shape");
+        const auto layers = parent.at("layers");
+        if(!shape.is_array() || !layers.is_array())
+            return {};
+
+        const int nDims = shape.size() == 4 ? shape[2].get<int>() * shape[3].get<int>() : shape.back().get<int>();
+        debug_print("# dimensions: " + std::to_string(nDims), debug);
+
+        auto model = std::make_unique<GraphModel<T>>(nDims);
+        std::map<std::string, int> node_names { { "input", GraphModel<T>::input_node } };
+
+        int prev_node = GraphModel<T>::input_node;
+        for(size_t idx = 0; idx < layers.size(); ++idx)
+        {
+            const auto& l = layers.at(idx);
+            const auto type = l.at("type").get<std::string>();
+            const auto name = l.value("name", std::to_string(idx));
+            debug_print("Layer: " + type + " (" + name + ")", debug);
+
+            std::vector<int> inputs;
+            if(l.contains("inputs"))
+            {
+                for(const auto& input_name : l.at("inputs"))
+                {
+                    const auto input = node_names.find(input_name.get<std::string>());
+                    if(input == node_names.end())
+                    {
+                        debug_print("Unknown input: " + input_name.get<std::string>(), debug);
+                        return {};
+                    }
+                    inputs.push_back(input->second);
+                }
+            }
+            else
+            {
+                inputs.push_back(prev_node);
+            }
+
+            const auto layerShape = l.at("shape");
+            const int layerDims = layerShape.size() == 4 ? layerShape[2].get<int>() * layerShape[3].get<int>() : layerShape.back().get<int>();
+            debug_print("  Dims: " + std::to_string(layerDims), debug);
+
+            int node = prev_node;
+            if(isGraphOperation(type))
+            {
+                if(type == "split")
+                {
+                    const auto offset = l.value("offset", 0);
+                    if(inputs.size() != 1 || offset < 0 || offset + layerDims > model->getNodeSize(inputs[0]))
+                    {
+                        debug_print("Wrong split dimensions!", debug);
+                        return {};
+                    }
+                    node = model->addSplit(inputs[0], offset, layerDims);
+                }
+                else if(type == "concat")
+                {
+                    node = model->addConcat(inputs);
+                }
+                else
+                {
+                    for(auto input : inputs)
+                    {
+                        if(model->getNodeSize(input) != layerDims)
+                        {
+                            debug_print("Wrong layer size! Expected: " + std::to_string(model->getNodeSize(input)), debug);
+                            return {};
+                        }
+                    }
+                    node = type == "add" ? model->addAdd(inputs) : model->addMultiply(inputs);
+                }
+
+                if(model->getNodeSize(node) != layerDims)
+                {
+                    debug_print("Wrong layer size! Expected: " + std::to_string(model->getNodeSize(node)), debug);
+                    return {};
+                }
+            }
+            else
+            {
+                if(inputs.size() != 1)
+                {
+                    debug_print("Layers must have a single input!", debug);
+                    return {};
+                }
+
+                // the layer (and its activation) are created as a sequential model
+                nlohmann::json layer_json;
+                layer_json["in_shape"] = { nullptr, nullptr, model->getNodeSize(inputs[0]) };
+                layer_json["layers"] = { l };
+                auto layer_model = parseJson<T, MathsProvider>(layer_json, debug);
+                if(layer_model == nullptr)
+                    return {};
+
+                node = inputs[0];
+                for(auto*& layer : layer_model->layers)
+                {
+                    if(layer->getDecimationFactor() != 1 || layer->getInterpolationFactor() != 1)
+                    {
+                        debug_print("Multi-rate layers are not supported in graph models!", debug);
+                        return {};
+                    }
+
+                    node = model->addLayer(layer, node);
+                    layer = nullptr;
+                }
+                layer_model->layers.clear();
+            }
+
+            node_names[name] = node;
+            prev_node = node;
+        }
+
+        if(parent.contains("output"))
+        {
+            const auto output = node_names.find(parent.at("output").get<std::string>());
+            if(output == node_names.end())
+            {
+                debug_print("Unknown output: " + parent.at("output").get<std::string>(), debug);
+                return {};
+            }
+            model->setOutput(output->second);
+        }
+
+        model->prepare();
+        return std::move(model);
+    }
+} // namespace json_parser
+} // namespace RTNEURAL_NAMESPACE
@@ -0,0 +1,610 @@
+#pragma once
+
+#include "GraphModel.h"
+#include "ModelT.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+
+#ifndef DOXYGEN
+/**
+ * Some utilities for the nodes of static graph models.
+ *
+ * Note that this API may change at any time,
+ * so probably don't use any of this directly.
+ */
+namespace graph_detail
+{
+    /** Returns true if `node` is one of the given inputs. */
+    constexpr bool contains(int) noexcept { return false; }
+
+    template <typename... Ints>
+    constexpr bool contains(int node, int input, Ints... inputs) noexcept
+    {
+        return node == input || contains(node, inputs...);
+    }
+
+    /** Returns the largest of the given inputs. */
+    constexpr int maxOf(int input) noexcept { return input; }
+
+    template <typename... Ints>
+    constexpr int maxOf(int input, Ints... inputs) noexcept
+    {
+        return input > maxOf(inputs...) ? input : maxOf(inputs...);
+    }
+
+    /** Returns the sum of the given sizes. */
+    constexpr int sumOf() noexcept { return 0; }
+
+    template <typename... Ints>
+    constexpr int sumOf(int size, Ints... sizes) noexcept
+    {
+        return size + sumOf(sizes...);
+    }
+
+    /** Returns true if all of the given sizes are equal to `size`. */
+    constexpr bool allEqual(int) noexcept { return true; }
+
+    template <typename... Ints>
+    constexpr bool allEqual(int size, int first, Ints... sizes) noexcept
+    {
+        return size == first && allEqual(size, sizes...);
+    }
+
+    /** The node with ID `Node` of a static graph model (0 is the model input). */
+    template <int Node, typename... Nodes>
+    struct NodeInfo
+    {
+        using type = std::tuple_element_t<Node - 1, std::tuple<Nodes...>>;
+        static constexpr bool uses_buffer = type::uses_buffer;
+        static constexpr int out_size = type::out_size;
+    };
+
+    template <typename... Nodes>
+    struct NodeInfo<0, Nodes...>
+    {
+        static constexpr bool uses_buffer = false;
+        static constexpr int out_size = 0;
+    };
+
+    /** The buffers for the outputs of the operation nodes of a static graph model. */
+    template <int num_nodes>
+    struct BufferPlan
+    {
+        int buffer[num_nodes + 1]; // the buffer used by each node, or -1 for the input and layer nodes
+        int offset[num_nodes + 1]; // the offset of each node's buffer in the buffer storage
+        int num_buffers;
+        int storage_size;
+    };
+
+    /** Returns the ID of the last node that reads the outputs of a node. */
+    template <typename... Nodes, size_t... Ix>
+    constexpr int lastUse(int node, std::index_sequence<Ix...>) noexcept
+    {
+        const int readers[] = { node, (Nodes::readsNode(node) ? (int)Ix + 1 : 0)... };
+        int last = node;
+        for(auto reader : readers)
+            last = reader > last ? reader : last;
+        return last;
+    }
+
+    /**
+     * Plans the buffers for the outputs of the operation nodes, in the same
+     * way as GraphModel::prepare(): a node's buffer is given to a later node
+     * once all of the nodes that read it have run. The layer nodes keep their
+     * outputs in the layers, so they don't need buffers.
+     */
+    template <typename T, typename... Nodes>
+    constexpr BufferPlan<(int)sizeof...(Nodes)> planBuffers() noexcept
+    {
+        constexpr auto num_nodes = (int)sizeof...(Nodes);
+        const int sizes[] = { 0, Nodes::out_size... };
+        const bool uses_buffer[] = { false, Nodes::uses_buffer... };
+
+        // the outputs of the last node are the model outputs, so its buffer is never given away
+        int last_use[num_nodes + 1] {};
+        for(int i = 0; i <= num_nodes; ++i)
+            last_use[i] = lastUse<Nodes...>(i, std::index_sequence_for<Nodes...> {});
+        last_use[num_nodes] = num_nodes + 1;
+
+        BufferPlan<num_nodes> plan {};
+        int capacities[num_nodes + 1] {};
+        bool is_free[num_nodes + 1] {};
+        plan.buffer[0] = -1;
+        for(int i = 1; i <= num_nodes; ++i)
+        {
+            plan.buffer[i] = -1;
+            if(uses_buffer[i])
+            {
+                // the smallest free buffer that fits the node outputs, or else the largest free buffer, grown to fit
+                int best = -1;
+                for(int b = 0; b < plan.num_buffers; ++b)
+                {
+                    if(!is_free[b])
+                        continue;
+
+                    if(best < 0)
+                    {
+                        best = b;
+                        continue;
+                    }
+
+                    const auto fits = capacities[b] >= sizes[i];
+                    const auto best_fits = capacities[best] >= sizes[i];
+                    if((fits && (!best_fits || capacities[b] < capacities[best]))
+                        || (!fits && !best_fits && capacities[b] > capacities[best]))
+                        best = b;
+                }
+
+                if(best < 0)
+                    best = plan.num_buffers++;
+
+                capacities[best] = capacities[best] > sizes[i] ? capacities[best] : sizes[i];
+                is_free[best] = false;
+                plan.buffer[i] = best;
+            }
+
+            // the buffers of the node inputs are only given away once the node has read them
+            for(int j = 1; j <= i; ++j)
+            {
+                if(last_use[j] == i && plan.buffer[j] >= 0)
+                    is_free[plan.buffer[j]] = true;
+            }
+        }
+
+        int buffer_offsets[num_nodes + 1] {};
+        for(int b = 0; b < plan.num_buffers; ++b)
+        {
+            buffer_offsets[b] = plan.storage_size;
+            plan.storage_size += padded_size<T>(capacities[b]);
+        }
+
+        for(int i = 0; i <= num_nodes; ++i)
+            plan.offset[i] = plan.buffer[i] < 0 ? 0 : buffer_offsets[plan.buffer[i]];
+
+        return plan;
+    }
+
+    /** Returns a tuple of references to the layers of a node (none, for an operation node). */
+    template <typename NodeType>
+    std::tuple<> getLayerRefs(NodeType&)
+    {
+        return {};
+    }
+} // namespace graph_detail
+#endif // DOXYGEN
+
+/**
+ * A node of a static graph model, which runs a layer on the
+ * outputs of the node with the ID `input` (0 is the model input).
+ */
+template <typename LayerType, int input>
+class GraphLayerT
+{
+public:
+    static constexpr auto input_node = input;
+    static constexpr auto out_size = LayerType::out_size;
+
+    /** The outputs of a layer node are stored in the layer. */
+    static constexpr bool uses_buffer = false;
+
+    /** Returns true if this node reads the outputs of the given node. */
+    static constexpr bool readsNode(int node) noexcept { return node == input; }
+
+    /** Returns the largest ID of the nodes that this node reads. */
+    static constexpr int lastInput() noexcept { return input; }
+
+    /** Performs forward propagation for this node. */
+    template <typename Model>
+    RTNEURAL_REALTIME inline void forward(const Model& model) noexcept
+    {
+        static_assert(Model::template getNodeSize<input>() == LayerType::in_size, "The layer input size must match the size of its input node!");
+        layer.forward(model.template getNodeOutputs<input>());
+    }
+
+    /** Resets the state of the layer. */
+    RTNEURAL_REALTIME void reset() { layer.reset(); }
+
+    /** Returns the outputs of the layer. */
+    RTNEURAL_REALTIME const auto& getOutputs() const noexcept { return layer.outs; }
+
+    LayerType layer;
+};
+
+/** A node of a static graph model, which adds the outputs of some nodes (of the same size) element-wise. */
+template <typename T, int size, int... inputs>
+class GraphAddT
+{
+public:
+    static_assert(sizeof...(inputs) > 0, "An add node must have at least one input!");
+    static constexpr auto out_size = size;
+
+    /** The outputs of an operation node are stored in a buffer planned by the model. */
+    static constexpr bool uses_buffer = true;
+
+    /** Returns true if this node reads the outputs of the given node. */
+    static constexpr bool readsNode(int node) noexcept { return graph_detail::contains(node, inputs...); }
+
+    /** Returns the largest ID of the nodes that this node reads. */
+    static constexpr int lastInput() noexcept { return graph_detail::maxOf(inputs...); }
+
+    /** Performs forward propagation for this node. */
+    template <typename Model>
+    RTNEURAL_REALTIME inline void forward(const Model& model, T* out) noexcept
+    {
+        static_assert(graph_detail::allEqual(size, Model::template getNodeSize<inputs>()...), "The inputs of an add node must have the same size as the node!");
+        const T* ins[] = { model.template getNodeData<inputs>()... };
+        std::copy(ins[0], ins[0] + size, out);
+        for(size_t j = 1; j < sizeof...(inputs); ++j)
+        {
+            for(int i = 0; i < size; ++i)
+                out[i] += ins[j][i];
+        }
+    }
+
+    RTNEURAL_REALTIME void reset() { }
+};
+
+/** A node of a static graph model, which multiplies the outputs of some nodes (of the same size) element-wise. */
+template <typename T, int size, int... inputs>
+class GraphMultiplyT
+{
+public:
+    static_assert(sizeof...(inputs) > 0, "A multiply node must have at least one input!");
+    static constexpr auto out_size = size;
+
+    /** The outputs of an operation node are stored in a buffer planned by the model. */
+    static constexpr bool uses_buffer = true;
+
+    /** Returns true if this node reads the outputs of the given node. */
+    static constexpr bool readsNode(int node) noexcept { return graph_detail::contains(node, inputs...); }
+
+    /** Returns the largest ID of the nodes that this node reads. */
+    static constexpr int lastInput() noexcept { return graph_detail::maxOf(inputs...); }
+
+    /** Performs forward propagation for this node. */
+    template <typename Model>
+    RTNEURAL_REALTIME inline void forward(const Model& model, T* out) noexcept
+    {
+        static_assert(graph_detail::allEqual(size, Model::template getNodeSize<inputs>()...), "The inputs of a multiply node must have the same size as the node!");
+        const T* ins[] = { model.template getNodeData<inputs>()... };
+        std::copy(ins[0], ins[0] + size, out);
+        for(size_t j = 1; j < sizeof...(inputs); ++j)
+        {
+            for(int i = 0; i < size; ++i)
+                out[i] *= ins[j][i];
+        }
+    }
+
+    RTNEURAL_REALTIME void reset() { }
+};
+
+/**
+ * A node of a static graph model, which concatenates the outputs of some nodes,
+ * where `size` is the total size of the inputs.
+ */
+template <typename T, int size, int... inputs>
+class GraphConcatT
+{
+public:
+    static_assert(sizeof...(inputs) > 0, "A concat node must have at least one input!");
+    static constexpr auto out_size = size;
+
+    /** The outputs of an operation node are stored in a buffer planned by the model. */
+    static constexpr bool uses_buffer = true;
+
+    /** Returns true if this node reads the outputs of the given node. */
+    static constexpr bool readsNode(int node) noexcept { return graph_detail::contains(node, inputs...); }
+
+    /** Returns the largest ID of the nodes that this node reads. */
+    static constexpr int lastInput() noexcept { return graph_detail::maxOf(inputs...); }
+
+    /** Performs forward propagation for this node. */
+    template <typename Model>
+    RTNEURAL_REALTIME inline void forward(const Model& model, T* out) noexcept
+    {
+        static_assert(graph_detail::sumOf(Model::template getNodeSize<inputs>()...) == size, "The size of a concat node must be the total size of its inputs!");
+        const T* ins[] = { model.template getNodeData<inputs>()... };
+        const int sizes[] = { Model::template getNodeSize<inputs>()... };
+        for(size_t j = 0; j < sizeof...(inputs); ++j)
+            out = std::copy(ins[j], ins[j] + sizes[j], out);
+    }
+
+    RTNEURAL_REALTIME void reset() { }
+};
+
+/** A node of a static graph model, which outputs the values [offset, offset + size) of the outputs of another node. */
+template <typename T, int offset, int size, int input>
+class GraphSplitT
+{
+public:
+    static constexpr auto out_size = size;
+
+    /** The outputs of an operation node are stored in a buffer planned by the model. */
+    static constexpr bool uses_buffer = true;
+
+    /** Returns true if this node reads the outputs of the given node. */
+    static constexpr bool readsNode(int node) noexcept { return node == input; }
+
+    /** Returns the largest ID of the nodes that this node reads. */
+    static constexpr int lastInput() noexcept { return input; }
+
+    /** Performs forward propagation for this node. */
+    template <typename Model>
+    RTNEURAL_REALTIME inline void forward(const Model& model, T* out) noexcept
+    {
+        static_assert(offset >= 0 && offset + size <= Model::template getNodeSize<input>(), "A split node must be within the outputs of its input node!");
+        const auto* in = model.template getNodeData<input>();
+        std::copy(in + offset, in + offset + size, out);
+    }
+
+    RTNEURAL_REALTIME void reset() { }
+};
+
+#ifndef DOXYGEN
+namespace graph_detail
+{
+    template <typename LayerType, int input>
+    std::tuple<LayerType&> getLayerRefs(GraphLayerT<LayerType, input>& node)
+    {
+        return std::tie(node.layer);
+    }
+} // namespace graph_detail
+#endif // DOXYGEN
+
+/**
+ *  A static graph neural network model, the compile-time
+ *  counterpart of GraphModel.
+ *
+ *  The nodes are defined at compile-time, where each node names
+ *  the IDs of the nodes that it takes inputs from: the ID of the
+ *  model input is 0, and the n-th node in the list has ID n. A node
+ *  may only take inputs from the nodes before it, and the last node
+ *  computes the model outputs:
+ *  ```
+ *  GraphModelT<float, 4, 1,
+ *      GraphLayerT<Conv1DT<float, 4, 4, 3, 1>, 0>, // 1
+ *      GraphLayerT<TanhActivationT<float, 4>, 1>, // 2
+ *      GraphAddT<float, 4, 2, 0>, // 3
+ *      GraphLayerT<DenseT<float, 4, 1>, 3> // 4
+ *  > model;
+ *  ```
+ *
+ *  The layer nodes keep their outputs in the layers, so they can be read
+ *  by any of the later nodes without copying. The outputs of the operation
+ *  nodes (add, multiply, concat, split) are stored in buffers that are
+ *  planned at compile-time, in the same way as GraphModel::prepare(),
+ *  so the operation nodes share memory where their lifetimes allow.
+ *  Layers that change the frame rate (e.g. StridedConv1DT) are not supported.
+ */
+template <typename T, int in_size, int out_size, typename... Nodes>
+class GraphModelT
+{
+public:
+    static constexpr auto input_size = in_size;
+    static constexpr auto output_size = out_size;
+    static constexpr auto n_nodes = (int)sizeof...(Nodes);
+
+    static_assert(n_nodes > 0, "A graph model must have at least one node!");
+    static_assert(graph_detail::NodeInfo<n_nodes, Nodes...>::out_size == out_size, "The size of the last node must match the model output size!");
+
+    GraphModelT()
+#if RTNEURAL_USE_EIGEN
+        : v_ins(ins_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_in_size; ++i)
+            v_ins[i] = v_type((T)0);
+#endif
+    }
+
+    /** Get a reference to the node with ID `Node` (from 1 to the number of nodes). */
+    template <int Node>
+    RTNEURAL_REALTIME auto& get() noexcept
+    {
+        return std::get<Node - 1>(nodes);
+    }
+
+    /** Get a reference to the node with ID `Node` (from 1 to the number of nodes). */
+    template <int Node>
+    RTNEURAL_REALTIME const auto& get() const noexcept
+    {
+        return std::get<Node - 1>(nodes);
+    }
+
+    /** Returns the output size of the node with ID `Node` (0 is the model input). */
+    template <int Node>
+    static constexpr int getNodeSize() noexcept
+    {
+        return Node == 0 ? in_size : graph_detail::NodeInfo<Node, Nodes...>::out_size;
+    }
+
+    /** Returns the number of buffers used for the outputs of the operation nodes. */
+    static constexpr int getNumBuffers() noexcept { return getBufferPlan().num_buffers; }
+
+    /** Returns the outputs of the node with ID `Node` (0 is the model input). */
+    template <int Node>
+    RTNEURAL_REALTIME inline decltype(auto) getNodeOutputs() const noexcept
+    {
+        return getOutputsOf<Node>(std::integral_constant<bool, graph_detail::NodeInfo<Node, Nodes...>::uses_buffer> {});
+    }
+
+    /** Returns a pointer to the outputs of the node with ID `Node` (0 is the model input). */
+    template <int Node>
+    RTNEURAL_REALTIME inline const T* getNodeData() const noexcept
+    {
+        return getDataOf<Node>(std::integral_constant<bool, graph_detail::NodeInfo<Node, Nodes...>::uses_buffer> {});
+    }
+
+    /** Resets the state of the network layers. */
+    RTNEURAL_REALTIME void reset()
+    {
+        modelt_detail::forEachInTuple([&](auto& node, size_t)
+            { node.reset(); },
+            nodes);
+    }
+
+    /** Performs forward propagation for this model. */
+    RTNEURAL_REALTIME inline T forward(const T* input) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        RTNEURAL_IF_CONSTEXPR(in_size == 1)
+        {
+            v_ins[0] = (v_type)input[0];
+        }
+        else
+        {
+            for(int i = 0; i < v_in_size; ++i)
+                v_ins[i] = xsimd::load_aligned(input + i * v_size);
+        }
+#else
+        std::copy(input, input + in_size, &v_ins[0]);
+#endif
+
+        modelt_detail::forEachInTuple([this](auto& node, auto index)
+            { this->forwardNode<(int)decltype(index)::value + 1>(node); },
+            nodes);
+
+        return getOutputs()[0];
+    }
+
+    /** Returns a pointer to the outputs of the final node in the network. */
+    RTNEURAL_REALTIME inline const T* getOutputs() const noexcept
+    {
+        return getNodeData<n_nodes>();
+    }
+
+    /**
+     * Loads neural network model weights from a json stream.
+     *
+     * The json has the same format as for `json_parser::parseGraphJson()`,
+     * but the layer entries are loaded in order into the layer nodes, as for
+     * a sequential model, since the connections between the nodes are fixed
+     * at compile-time. The "inputs" of each layer are not checked, and the
+     * "add", "multiply", "concat", and "split" entries are skipped.
+     */
+    void parseJson(const nlohmann::json& parent, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    {
+        auto layers_json = parent;
+        auto& json_layers = layers_json.at("layers");
+        json_layers = nlohmann::json::array();
+        for(const auto& l : parent.at("layers"))
+        {
+            if(!json_parser::isGraphOperation(l.at("type").get<std::string>()))
+                json_layers.push_back(l);
+        }
+
+        auto layers = getLayerRefs(std::index_sequence_for<Nodes...> {});
+        modelt_detail::parseJson<T, in_size>(layers_json, layers, debug, custom_layers);
+    }
+
+    /** Loads neural network model weights from a json stream. */
+    void parseJson(std::ifstream& jsonStream, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    {
+        nlohmann::json parent;
+        jsonStream >> parent;
+        return parseJson(parent, debug, custom_layers);
+    }
+
+private:
+    static constexpr graph_detail::BufferPlan<n_nodes> getBufferPlan() noexcept
+    {
+        return graph_detail::planBuffers<T, Nodes...>();
+    }
+
+    static constexpr auto buffers_size = getBufferPlan().storage_size > 0 ? getBufferPlan().storage_size : 1;
+
+    template <int Node, typename NodeType>
+    RTNEURAL_REALTIME inline void forwardNode(NodeType& node) noexcept
+    {
+        static_assert(NodeType::lastInput() < Node, "A node may only take inputs from the nodes before it!");
+        forwardNode<Node>(node, std::integral_constant<bool, NodeType::uses_buffer> {});
+    }
+
+    template <int Node, typename NodeType>
+    RTNEURAL_REALTIME inline void forwardNode(NodeType& node, std::false_type) noexcept
+    {
+        node.forward(*this);
+    }
+
+    template <int Node, typename NodeType>
+    RTNEURAL_REALTIME inline void forwardNode(NodeType& node, std::true_type) noexcept
+    {
+        constexpr auto offset = getBufferPlan().offset[Node];
+        node.forward(*this, buffers + offset);
+
+#if RTNEURAL_USE_XSIMD
+        // a buffer may have held larger outputs before, so clear the padding of the SIMD registers
+        std::fill(buffers + offset + NodeType::out_size, buffers + offset + padded_size<T>(NodeType::out_size), (T)0);
+#endif
+    }
+
+    template <int Node>
+    RTNEURAL_REALTIME inline const auto& getOutputsOf(std::false_type) const noexcept
+    {
+        return getLayerOutputsOf(std::integral_constant<int, Node> {});
+    }
+
+    template <int Node>
+    RTNEURAL_REALTIME inline decltype(auto) getOutputsOf(std::true_type) const noexcept
+    {
+        constexpr auto offset = getBufferPlan().offset[Node];
+        constexpr auto size = getNodeSize<Node>();
+#if RTNEURAL_USE_XSIMD
+        return reinterpret_cast<const v_type(&)[ceil_div(size, v_size)]>(buffers[offset]);
+#elif RTNEURAL_USE_EIGEN
+        return Eigen::Map<const Eigen::Matrix<T, size, 1>, RTNeuralEigenAlignment>(buffers + offset);
+#else
+        return reinterpret_cast<const T(&)[size]>(buffers[offset]);
+#endif
+    }
+
+    RTNEURAL_REALTIME inline const auto& getLayerOutputsOf(std::integral_constant<int, 0>) const noexcept
+    {
+        return v_ins;
+    }
+
+    template <int Node>
+    RTNEURAL_REALTIME inline const auto& getLayerOutputsOf(std::integral_constant<int, Node>) const noexcept
+    {
+        return std::get<Node - 1>(nodes).getOutputs();
+    }
+
+    template <int Node>
+    RTNEURAL_REALTIME inline const T* getDataOf(std::false_type) const noexcept
+    {
+        return reinterpret_cast<const T*>(&getLayerOutputsOf(std::integral_constant<int, Node> {})[0]);
+    }
+
+    template <int Node>
+    RTNEURAL_REALTIME inline const T* getDataOf(std::true_type) const noexcept
+    {
+        return buffers + getBufferPlan().offset[Node];
+    }
+
+    template <size_t... Ix>
+    auto getLayerRefs(std::index_sequence<Ix...>)
+    {
+        return std::tuple_cat(graph_detail::getLayerRefs(std::get<Ix>(nodes))...);
+    }
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = (int)v_type::size;
+    static constexpr auto v_in_size = ceil_div(in_size, v_size);
+    v_type v_ins[v_in_size];
+#elif RTNEURAL_USE_EIGEN
+    Eigen::Map<Eigen::Matrix<T, in_size, 1>, RTNeuralEigenAlignment> v_ins;
+    T ins_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size] {};
+#else // RTNEURAL_USE_STL
+    T v_ins alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size] {};
+#endif
+
+    // the outputs of the operation nodes, at the offsets given by getBufferPlan()
+    T buffers alignas(RTNEURAL_DEFAULT_ALIGNMENT)[buffers_size] {};
+
+    std::tuple<Nodes...> nodes;
+};
+
+} // namespace RTNEURAL_NAMESPACE
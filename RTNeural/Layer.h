@@ -30,6 +30,26 @@ public:
     /** Implements the forward propagation step for this layer. */
     virtual void forward(const T* input, T* out) noexcept = 0;
 
+    /**
+     * Returns the number of input frames that this layer consumes for
+     * each output frame it computes (e.g. the stride of a StridedConv1D).
+     */
+    virtual int getDecimationFactor() const noexcept { return 1; }
+
+    /**
+     * Returns the number of output frames that this layer writes for each
+     * input frame (e.g. the stride of a ConvTranspose1D). The frames are
+     * written one after the other, each with out_size / getInterpolationFactor()
+     * values.
+     */
+    virtual int getInterpolationFactor() const noexcept { return 1; }
+
+    /**
+     * For decimating layers, returns true if the last call to forward()
+     * computed a new output frame, or false if it only held the previous one.
+     */
+    virtual bool hasNewOutput() const noexcept { return true; }
+
     const int in_size;
     const int out_size;
 };
@@ -5,6 +5,9 @@
 
 #include "Layer.h"
 #include "activation/activation.h"
+#include "attention/attention.h"
+#include "attention/layer_norm.h"
+#include "attention/transformer_block.h"
 #include "batchnorm/batchnorm.h"
 #include "batchnorm/batchnorm.tpp"
 #include "batchnorm/batchnorm2d.h"
@@ -12,14 +15,19 @@
 #include "config.h"
 #include "conv1d/conv1d.h"
 #include "conv1d/conv1d.tpp"
+#include "conv1d/conv_transpose1d.h"
 #include "conv1d/strided_conv1d.h"
 #include "conv2d/conv2d.h"
 #include "conv2d/conv2d.tpp"
 #include "dense/dense.h"
+#include "dense/dense_low_rank.h"
+#include "dense/dense_sparse.h"
 #include "gru/gru.h"
 #include "gru/gru.tpp"
 #include "lstm/lstm.h"
 #include "lstm/lstm.tpp"
+#include "tcn/tcn_block.h"
+#include "wavenet/wavenet.h"
 
 namespace RTNEURAL_NAMESPACE
 {
@@ -29,6 +37,13 @@ namespace RTNEURAL_NAMESPACE
  *
  *  Instances of this class should typically be created
  *  `json_parser::parseJson`.
+ *
+ *  Models may contain layers that change the frame rate: the layers after
+ *  a decimating layer (e.g. a StridedConv1D) only run when it computes a
+ *  new output frame, and the layers after an interpolating layer (e.g. a
+ *  ConvTranspose1D) run once for each of its output frames. In between,
+ *  the model's outputs hold their previous values, and getNumOutputFrames()
+ *  returns the number of output frames written by the last call to forward().
  */
 template <typename T>
 class Model
@@ -53,8 +68,8 @@ public:
     /** Returns the model's input size */
     int getInSize() const { return layers.front()->in_size; }
 
-    /** Returns the model's output size */
-    int getOutSize() const { return layers.back()->out_size; }
+    /** Returns the model's output size, for each output frame */
+    int getOutSize() const { return layers.back()->out_size / layers.back()->getInterpolationFactor(); }
 
     /** Returns the required input size for the next layer being added to the network. */
     int getNextInSize() const
@@ -62,7 +77,7 @@ public:
         if(layers.empty())
             return in_size;
 
-        return layers.back()->out_size;
+        return getOutSize();
     }
 
     /** Adds a new layer to the sequential model. */
@@ -70,6 +85,16 @@ public:
     {
         layers.push_back(layer);
         outs.push_back(vec_type(layer->out_size, (T)0));
+
+        decimationFactors.push_back(layer->getDecimationFactor());
+        interpolationFactors.push_back(layer->getInterpolationFactor());
+        frameOuts.push_back(vec_type(interpolationFactors.back() > 1 ? getOutSize() : 0, (T)0));
+        isMultiRate = isMultiRate || decimationFactors.back() > 1 || interpolationFactors.back() > 1;
+
+        maxOutputFrames *= interpolationFactors.back();
+        outputFrameSize = getOutSize();
+        if(maxOutputFrames > 1)
+            outputFrames.assign((size_t)(maxOutputFrames * outputFrameSize), (T)0);
     }
 
     /** Resets the state of the network layers. */
@@ -82,6 +107,13 @@ public:
     /** Performs forward propagation for this model. */
     RTNEURAL_REALTIME inline T forward(const T* input)
     {
+        if(isMultiRate)
+        {
+            numOutputFrames = 0;
+            forwardFrom(0, input);
+            return getOutputs()[0];
+        }
+
         layers[0]->forward(input, outs[0].data());
 
         for(int i = 1; i < (int)layers.size(); ++i)
@@ -92,10 +124,24 @@ public:
         return outs.back()[0];
     }
 
-    /** Returns a pointer to the output of the final layer in the network. */
+    /**
+     * Returns a pointer to the output of the final layer in the network.
+     *
+     * If the model interpolates, the output frames written by the last
+     * call to forward() are stored one after the other.
+     */
     RTNEURAL_REALTIME inline const T* getOutputs() const noexcept
     {
-        return outs.back().data();
+        return maxOutputFrames > 1 ? outputFrames.data() : outs.back().data();
+    }
+
+    /**
+     * Returns the number of output frames written by the last call to forward().
+     * This is always 1, unless the model contains decimating or interpolating layers.
+     */
+    RTNEURAL_REALTIME int getNumOutputFrames() const noexcept
+    {
+        return isMultiRate ? numOutputFrames : 1;
     }
 
     /** A vector storing the network layers in sequential order. */
@@ -110,8 +156,48 @@ private:
     using vec_type = std::vector<T>;
 #endif
 
+    /** Runs the layers from layer `i` onwards, on one input frame for that layer. */
+    RTNEURAL_REALTIME void forwardFrom(int i, const T* input) noexcept
+    {
+        for(; i < (int)layers.size(); ++i)
+        {
+            layers[i]->forward(input, outs[i].data());
+
+            // the following layers run at the decimated rate
+            if(decimationFactors[(size_t)i] > 1 && !layers[i]->hasNewOutput())
+                return;
+
+            if(interpolationFactors[(size_t)i] > 1)
+            {
+                // the frames are copied so that the following layers get aligned inputs
+                auto& frameOut = frameOuts[(size_t)i];
+                for(int frame = 0; frame < interpolationFactors[(size_t)i]; ++frame)
+                {
+                    std::copy(outs[i].begin() + frame * (int)frameOut.size(), outs[i].begin() + (frame + 1) * (int)frameOut.size(), frameOut.begin());
+                    forwardFrom(i + 1, frameOut.data());
+                }
+                return;
+            }
+
+            input = outs[i].data();
+        }
+
+        if(maxOutputFrames > 1)
+            std::copy(input, input + outputFrameSize, outputFrames.begin() + numOutputFrames * outputFrameSize);
+        numOutputFrames++;
+    }
+
     const int in_size;
     std::vector<vec_type> outs;
+
+    std::vector<int> decimationFactors;
+    std::vector<int> interpolationFactors;
+    std::vector<vec_type> frameOuts;
+    bool isMultiRate = false;
+    int maxOutputFrames = 1;
+    int outputFrameSize = 0;
+    int numOutputFrames = 1;
+    vec_type outputFrames;
 };
 
 } // namespace RTNEURAL_NAMESPACE
@@ -71,14 +71,121 @@ namespace modelt_detail
         static void call(T&) { }
     };
 
+    template <typename... Ts>
+    struct make_void
+    {
+        using type = void;
+    };
+
+    /** Decimating layers define a decimation_factor (input frames per output frame) */
+    template <typename LayerType, typename = void>
+    struct decimation_factor : std::integral_constant<int, 1>
+    {
+    };
+
+    template <typename LayerType>
+    struct decimation_factor<LayerType, typename make_void<decltype(LayerType::decimation_factor)>::type>
+        : std::integral_constant<int, LayerType::decimation_factor>
+    {
+    };
+
+    /** Interpolating layers define an interpolation_factor (output frames per input frame) */
+    template <typename LayerType, typename = void>
+    struct interpolation_factor : std::integral_constant<int, 1>
+    {
+    };
+
+    template <typename LayerType>
+    struct interpolation_factor<LayerType, typename make_void<decltype(LayerType::interpolation_factor)>::type>
+        : std::integral_constant<int, LayerType::interpolation_factor>
+    {
+    };
+
+    constexpr int product() { return 1; }
+
+    template <typename... Ints>
+    constexpr int product(int x, Ints... xs) { return x * product(xs...); }
+
+    /**
+     * Rate-aware forward inferencing, starting from layer idx:
+     * the layers after a decimating layer only run when it computes
+     * a new output frame, and the layers after an interpolating layer
+     * run once for each of its output frames. The model's output frames
+     * are passed to `output`.
+     */
+    template <size_t idx, size_t n_layers>
+    struct forward_from
+    {
+        template <typename LayersTuple, typename Inputs, typename OutputFn>
+        static void call(LayersTuple& t, const Inputs& ins, OutputFn& output)
+        {
+            using LayerType = std::tuple_element_t<idx, LayersTuple>;
+            auto& layer = std::get<idx>(t);
+            layer.forward(ins);
+            next(t, layer, output,
+                std::integral_constant<bool, (decimation_factor<LayerType>::value > 1)> {},
+                std::integral_constant<bool, (interpolation_factor<LayerType>::value > 1)> {});
+        }
+
+    private:
+        template <typename LayersTuple, typename LayerType, typename OutputFn>
+        static void next(LayersTuple& t, LayerType& layer, OutputFn& output, std::false_type, std::false_type)
+        {
+            forward_from<idx + 1, n_layers>::call(t, layer.outs, output);
+        }
+
+        template <typename LayersTuple, typename LayerType, typename OutputFn>
+        static void next(LayersTuple& t, LayerType& layer, OutputFn& output, std::true_type, std::false_type)
+        {
+            if(layer.hasNewOutput())
+                forward_from<idx + 1, n_layers>::call(t, layer.outs, output);
+        }
+
+        template <typename LayersTuple, typename LayerType, typename OutputFn>
+        static void next(LayersTuple& t, LayerType& layer, OutputFn& output, std::false_type, std::true_type)
+        {
+            for(int frame = 0; frame < interpolation_factor<LayerType>::value; ++frame)
+            {
+                layer.loadOutputFrame(frame);
+                forward_from<idx + 1, n_layers>::call(t, layer.frame_outs, output);
+            }
+        }
+    };
+
+    template <size_t n_layers>
+    struct forward_from<n_layers, n_layers>
+    {
+        template <typename LayersTuple, typename Inputs, typename OutputFn>
+        static void call(LayersTuple&, const Inputs& ins, OutputFn& output)
+        {
+            output(ins);
+        }
+    };
+
+    /** Detects batchnorm layers, which can load the identity weights of a folded batchnorm. */
+    template <typename LayerType>
+    struct is_batch_norm : std::false_type
+    {
+    };
+
+    template <typename T, int size, bool affine>
+    struct is_batch_norm<BatchNorm1DT<T, size, affine>> : std::true_type
+    {
+    };
+
+    template <typename T, int num_filters, int num_features, bool affine>
+    struct is_batch_norm<BatchNorm2DT<T, num_filters, num_features, affine>> : std::true_type
+    {
+    };
+
     template <typename T, typename LayerType>
     void loadLayer(LayerType&, int&, const nlohmann::json&, const std::string&, int, bool debug)
     {
         json_parser::debug_print("Loading a no-op layer!", debug);
     }
 
-    template <typename T, int in_size, int out_size, bool has_bias>
-    void loadLayer(DenseT<T, in_size, out_size, has_bias>& dense, int& json_stream_idx, const nlohmann::json& l,
+    template <typename T, int in_size, int out_size, bool has_bias, typename FusedActivation, bool block_sparse>
+    void loadLayer(DenseT<T, in_size, out_size, has_bias, FusedActivation, block_sparse>& dense, int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
     {
         using namespace json_parser;
@@ -102,8 +209,48 @@ namespace modelt_detail
         }
     }
 
-    template <typename T, int in_size, int out_size, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-    void loadLayer(Conv1DT<T, in_size, out_size, kernel_size, dilation_rate, groups, dynamic_state>& conv, int& json_stream_idx, const nlohmann::json& l,
+    template <typename T, int in_size, int out_size, int rank, bool has_bias>
+    void loadLayer(LowRankDenseT<T, in_size, out_size, rank, has_bias>& dense, int& json_stream_idx, const nlohmann::json& l,
+        const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+        const auto& weights = l["weights"];
+
+        if(checkDense<T>(dense, type, layerDims, debug))
+        {
+            if(l.contains("rank"))
+            {
+                if(l["rank"].get<int>() == rank)
+                    loadLowRankDense<T>(dense, weights);
+                else
+                    debug_print("Wrong rank! Expected: " + std::to_string(rank), debug);
+            }
+            else
+            {
+                // full-rank weights are approximated by their rank-r factors
+                const auto factors = low_rank::factorizeWithRank(getDenseWeights<T>(in_size, out_size, weights), rank);
+                debug_print("  low-rank approximation error: " + std::to_string(factors.error), debug);
+                loadLowRankDense<T>(dense, factors, weights);
+            }
+        }
+
+        if(!l.contains("activation"))
+        {
+            json_stream_idx++;
+        }
+        else
+        {
+            const auto activationType = l["activation"].get<std::string>();
+            if(activationType.empty())
+                json_stream_idx++;
+        }
+    }
+
+    template <typename T, int in_size, int out_size, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+    void loadLayer(Conv1DT<T, in_size, out_size, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>& conv, int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
     {
         using namespace json_parser;
@@ -129,10 +276,70 @@ namespace modelt_detail
                 json_stream_idx++;
         }
     }
+    template <typename T, int in_size, int out_size, int kernel_size, int dilation_rate, int stride, int groups, bool dynamic_state>
+    void loadLayer(StridedConv1DT<T, in_size, out_size, kernel_size, dilation_rate, stride, groups, dynamic_state>& conv, int& json_stream_idx,
+        const nlohmann::json& l, const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+        const auto& l_weights = l["weights"];
+        const auto l_kernel = l["kernel_size"].back().get<int>();
+        const auto l_dilation = l["dilation"].back().get<int>();
+        const auto l_stride = l.contains("strides") ? l["strides"].back().get<int>() : 1;
+        const auto l_groups = l.value("groups", 1);
+
+        if(l_stride != stride)
+            debug_print("Wrong stride! Expected: " + std::to_string(stride), debug);
+        else if(checkConv1D<T>(conv, type, layerDims, l_kernel, l_dilation, l_groups, debug))
+            loadConv1D<T>(conv, l_kernel, l_dilation, l_weights);
+
+        if(!l.contains("activation"))
+        {
+            json_stream_idx++;
+        }
+        else
+        {
+            const auto activationType = l["activation"].get<std::string>();
+            if(activationType.empty())
+                json_stream_idx++;
+        }
+    }
+
+    template <typename T, int in_size, int out_channels, int kernel_size, int dilation_rate, int stride, int groups, bool dynamic_state>
+    void loadLayer(ConvTranspose1DT<T, in_size, out_channels, kernel_size, dilation_rate, stride, groups, dynamic_state>& conv, int& json_stream_idx,
+        const nlohmann::json& l, const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+        const auto& l_weights = l["weights"];
+        const auto l_kernel = l["kernel_size"].back().get<int>();
+        const auto l_dilation = l["dilation"].back().get<int>();
+        const auto l_stride = l["strides"].back().get<int>();
+        const auto l_groups = l.value("groups", 1);
+
+        if(checkConvTranspose1D<T>(conv, type, layerDims, l_kernel, l_dilation, l_stride, l_groups, debug))
+            loadConvTranspose1D<T>(conv, l_kernel, l_weights);
+
+        if(!l.contains("activation"))
+        {
+            json_stream_idx++;
+        }
+        else
+        {
+            const auto activationType = l["activation"].get<std::string>();
+            if(activationType.empty())
+                json_stream_idx++;
+        }
+    }
+
     template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t,
-        int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
+        int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation>
     void loadLayer(Conv2DT<T, num_filters_in_t, num_filters_out_t, num_features_in_t, kernel_size_time_t,
-                       kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t>& conv,
+                       kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t, FusedActivation>& conv,
         int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
     {
@@ -163,8 +370,8 @@ namespace modelt_detail
         }
     }
 
-    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider>
-    void loadLayer(GRULayerT<T, in_size, out_size, mode, MathsProvider>& gru, int& json_stream_idx, const nlohmann::json& l,
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void loadLayer(GRULayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& gru, int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
     {
         using namespace json_parser;
@@ -179,8 +386,8 @@ namespace modelt_detail
         json_stream_idx++;
     }
 
-    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider>
-    void loadLayer(LSTMLayerT<T, in_size, out_size, mode, MathsProvider>& lstm, int& json_stream_idx, const nlohmann::json& l,
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void loadLayer(LSTMLayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& lstm, int& json_stream_idx, const nlohmann::json& l,
         const std::string& type, int layerDims, bool debug)
     {
         using namespace json_parser;
@@ -249,13 +456,151 @@ namespace modelt_detail
         json_stream_idx++;
     }
 
+    template <typename T, int size, bool rms>
+    void loadLayer(LayerNormT<T, size, rms>& norm, int& json_stream_idx, const nlohmann::json& l,
+        const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+
+        if(checkLayerNorm<T>(norm, type, layerDims, debug))
+            loadLayerNorm<T>(norm, l);
+
+        json_stream_idx++;
+    }
+
+    template <typename T, int embed_dim, int num_heads, int context_length, typename MathsProvider>
+    void loadLayer(MultiHeadAttentionT<T, embed_dim, num_heads, context_length, MathsProvider>& attention, int& json_stream_idx,
+        const nlohmann::json& l, const std::string& type, int layerDims, bool debug)
+    {
+        using namespace json_parser;
+
+        debug_print("Layer: " + type, debug);
+        debug_print("  Dims: " + std::to_string(layerDims), debug);
+
+        if(checkAttention<T>(attention, type, layerDims, l, debug))
+            loadAttention<T>(attention, l["weights"]);
+
+        json_stream_idx++;
+    }
+
+    /** Checks if a layer has a (non-identity) fused activation. */
+    template <typename LayerType, typename = void>
+    struct has_fused_activation : std::false_type
+    {
+    };
+
+    template <typename LayerType>
+    struct has_fused_activation<LayerType, std::enable_if_t<!LayerType::activation_type::is_identity>> : std::true_type
+    {
+    };
+
+    /** Checks if a fused activation has per-output parameters (i.e. PReLU). */
+    template <typename ActivationType>
+    struct is_fused_prelu : std::false_type
+    {
+    };
+
+    template <typename T, int size, int num_features>
+    struct is_fused_prelu<fused_activation::PReLU<T, size, num_features>> : std::true_type
+    {
+    };
+
+    /** Most layers don't have a fused activation to load. */
+    template <typename T, typename LayerType>
+    void loadFusedActivation(LayerType&, int&, const nlohmann::json&, const nlohmann::json&, bool, std::false_type)
+    {
+    }
+
+    /** Element-wise activations are attached to the Dense, Conv1D, or Conv2D layer in the json representation. */
+    template <typename T, typename ActivationType>
+    void loadFusedActivationImpl(ActivationType&, int& json_stream_idx, const nlohmann::json& l,
+        const nlohmann::json&, bool debug, std::false_type)
+    {
+        using namespace json_parser;
+
+        const auto activationType = l.value("activation", std::string {});
+        if(activationType != ActivationType::getName())
+        {
+            debug_print("Fused activation mismatch! Expected: " + ActivationType::getName(), debug);
+            return;
+        }
+
+        debug_print("  fused activation: " + activationType, debug);
+        json_stream_idx++;
+    }
+
+    /** A PReLU activation is the next layer in the json representation. */
+    template <typename T, typename ActivationType>
+    void loadFusedActivationImpl(ActivationType& prelu, int& json_stream_idx, const nlohmann::json& l,
+        const nlohmann::json& json_layers, bool debug, std::true_type)
+    {
+        using namespace json_parser;
+
+        if(!l.value("activation", std::string {}).empty() || json_stream_idx >= (int)json_layers.size())
+        {
+            debug_print("Fused activation mismatch! Expected: prelu", debug);
+            return;
+        }
+
+        const auto& prelu_l = json_layers.at(json_stream_idx);
+        const auto preluShape = prelu_l["shape"];
+        const int preluDims = preluShape.size() == 4 ? preluShape[2].get<int>() * preluShape[3].get<int>() : preluShape.back().get<int>();
+
+        debug_print("  fused activation: prelu", debug);
+        if(checkPReLU<T>(prelu, prelu_l["type"].get<std::string>(), preluDims, debug))
+            loadPReLU<T>(prelu, prelu_l["weights"]);
+
+        json_stream_idx++;
+    }
+
+    /** Loads the activation fused into a Dense, Conv1D, or Conv2D layer. */
+    template <typename T, typename LayerType>
+    void loadFusedActivation(LayerType& layer, int& json_stream_idx, const nlohmann::json& l,
+        const nlohmann::json& json_layers, bool debug, std::true_type)
+    {
+        using ActivationType = typename LayerType::activation_type;
+        loadFusedActivationImpl<T>(layer.getActivation(), json_stream_idx, l, json_layers, debug, is_fused_prelu<ActivationType> {});
+    }
+
+    /** Factorizing the weights is a no-op for most layers. */
+    template <typename T, typename LayerType>
+    void factorizeLayer(LayerType&, const nlohmann::json&, const std::string&, int, double, bool)
+    {
+    }
+
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void factorizeLayer(GRULayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& gru, const nlohmann::json& l,
+        const std::string& type, int layerDims, double tolerance, bool debug)
+    {
+        using namespace json_parser;
+
+        if(checkGRU<T>(gru, type, layerDims, false))
+            factorizeRecurrentWeights<T>(gru, l["weights"], tolerance, debug);
+    }
+
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void factorizeLayer(LSTMLayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& lstm, const nlohmann::json& l,
+        const std::string& type, int layerDims, double tolerance, bool debug)
+    {
+        using namespace json_parser;
+
+        if(checkLSTM<T>(lstm, type, layerDims, false))
+            factorizeRecurrentWeights<T>(lstm, l["weights"], tolerance, debug);
+    }
+
     template <typename T, int in_size, typename... Layers>
-    void parseJson(const nlohmann::json& parent, std::tuple<Layers...>& layers, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    void parseJson(const nlohmann::json& parent, std::tuple<Layers...>& layers, const bool debug = false,
+        std::initializer_list<std::string> custom_layers = {}, const double low_rank_tolerance = 0.0)
     {
         using namespace json_parser;
 
-        auto shape = parent["in_shape"];
-        auto json_layers = parent["layers"];
+        // batchnorm layers are folded into the previous layer where possible
+        const nlohmann::json folded = foldBatchNorms<T>(parent, debug);
+        auto shape = folded["in_shape"];
+        auto json_layers = folded["layers"];
 
         if(!shape.is_array() || !json_layers.is_array())
             return;
@@ -274,6 +619,12 @@ namespace modelt_detail
         int json_stream_idx = 0;
         modelt_detail::forEachInTuple([&](auto& layer, size_t)
             {
+                // the model may leave out the layers for folded batchnorms
+                using LayerType = std::decay_t<decltype(layer)>;
+                while(json_stream_idx < (int)json_layers.size() && !is_batch_norm<LayerType>::value
+                    && isFoldedBatchNorm(json_layers.at(json_stream_idx)))
+                    json_stream_idx++;
+
                 if(json_stream_idx >= (int)json_layers.size())
                 {
                     debug_print("Too many layers!", debug);
@@ -313,7 +664,11 @@ namespace modelt_detail
                     return;
                 }
 
-                modelt_detail::loadLayer<T>(layer, json_stream_idx, l, type, layerDims, debug); },
+                modelt_detail::loadLayer<T>(layer, json_stream_idx, l, type, layerDims, debug);
+                modelt_detail::loadFusedActivation<T>(layer, json_stream_idx, l, json_layers, debug, has_fused_activation<LayerType> {});
+
+                if(low_rank_tolerance > 0.0)
+                    modelt_detail::factorizeLayer<T>(layer, l, type, layerDims, low_rank_tolerance, debug); },
             layers);
     }
 } // namespace modelt_detail
@@ -330,6 +685,13 @@ namespace modelt_detail
  *      DenseT<double, 8, 1>
  *  > model;
  *  ```
+ *
+ *  Models may contain layers that change the frame rate: the layers after
+ *  a decimating layer (e.g. a StridedConv1DT) only run when it computes a
+ *  new output frame, and the layers after an interpolating layer (e.g. a
+ *  ConvTranspose1DT) run once for each of its output frames. In that case,
+ *  `out_size` is the size of each output frame, and getNumOutputFrames()
+ *  returns the number of output frames written by the last call to forward().
  */
 template <typename T, int in_size, int out_size, typename... Layers>
 class ModelT
@@ -338,14 +700,21 @@ public:
     static constexpr auto input_size = in_size;
     static constexpr auto output_size = out_size;
 
+    /** The largest number of output frames that the model can write for each input frame. */
+    static constexpr auto max_output_frames = modelt_detail::product(modelt_detail::interpolation_factor<Layers>::value...);
+
     ModelT()
     {
 #if RTNEURAL_USE_XSIMD
         for(int i = 0; i < v_in_size; ++i)
             v_ins[i] = v_type((T)0);
 #elif RTNEURAL_USE_EIGEN
-        auto& layer_outs = get<n_layers - 1>().outs;
-        new(&layer_outs) Eigen::Map<Eigen::Matrix<T, out_size, 1>, RTNeuralEigenAlignment>(outs);
+        // the final layer writes its outputs straight into the model outputs
+        RTNEURAL_IF_CONSTEXPR(max_output_frames == 1)
+        {
+            auto& layer_outs = get<n_layers - 1>().outs;
+            new(&layer_outs) Eigen::Map<Eigen::Matrix<T, out_size, 1>, RTNeuralEigenAlignment>(outs);
+        }
 #endif
     }
 
@@ -384,17 +753,7 @@ public:
 #else // RTNEURAL_USE_STL
         std::copy(input, input + in_size, v_ins);
 #endif
-        std::get<0>(layers).forward(v_ins);
-        modelt_detail::forward_unroll<1, n_layers - 1>::call(layers);
-
-#if RTNEURAL_USE_XSIMD
-        for(int i = 0; i < v_out_size; ++i)
-            xsimd::store_aligned(outs + i * v_size, get<n_layers - 1>().outs[i]);
-#elif RTNEURAL_USE_EIGEN
-#else // RTNEURAL_USE_STL
-        auto& layer_outs = get<n_layers - 1>().outs;
-        std::copy(layer_outs, layer_outs + out_size, outs);
-#endif
+        forwardLayers(v_ins);
         return outs[0];
     }
 
@@ -411,38 +770,51 @@ public:
         v_ins[0] = input[0];
 #endif
 
-        std::get<0>(layers).forward(v_ins);
-        modelt_detail::forward_unroll<1, n_layers - 1>::call(layers);
-
-#if RTNEURAL_USE_XSIMD
-        for(int i = 0; i < v_out_size; ++i)
-            xsimd::store_aligned(outs + i * v_size, get<n_layers - 1>().outs[i]);
-#elif RTNEURAL_USE_EIGEN
-#else // RTNEURAL_USE_STL
-        auto& layer_outs = get<n_layers - 1>().outs;
-        std::copy(layer_outs, layer_outs + out_size, outs);
-#endif
+        forwardLayers(v_ins);
         return outs[0];
     }
 
-    /** Returns a pointer to the output of the final layer in the network. */
+    /**
+     * Returns a pointer to the output of the final layer in the network.
+     *
+     * If the model interpolates, the output frames written by the last
+     * call to forward() are stored one after the other.
+     */
     RTNEURAL_REALTIME inline const T* getOutputs() const noexcept
     {
         return outs;
     }
 
-    /** Loads neural network model weights from a json stream. */
-    void parseJson(const nlohmann::json& parent, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    /**
+     * Returns the number of output frames written by the last call to forward().
+     * This is always 1, unless the model contains decimating or interpolating layers.
+     */
+    RTNEURAL_REALTIME int getNumOutputFrames() const noexcept
     {
-        modelt_detail::parseJson<T, in_size>(parent, layers, debug, custom_layers);
+        return num_output_frames;
+    }
+
+    /**
+     * Loads neural network model weights from a json stream.
+     *
+     * If low_rank_tolerance is greater than zero, the recurrent weights of
+     * any GRU or LSTM layers are approximated with low-rank factors, as long
+     * as the relative error of the approximation is within the tolerance,
+     * and the rank is at most max_recurrent_rank.
+     */
+    void parseJson(const nlohmann::json& parent, const bool debug = false, std::initializer_list<std::string> custom_layers = {},
+        const double low_rank_tolerance = 0.0)
+    {
+        modelt_detail::parseJson<T, in_size>(parent, layers, debug, custom_layers, low_rank_tolerance);
     }
 
     /** Loads neural network model weights from a json stream. */
-    void parseJson(std::ifstream& jsonStream, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    void parseJson(std::ifstream& jsonStream, const bool debug = false, std::initializer_list<std::string> custom_layers = {},
+        const double low_rank_tolerance = 0.0)
     {
         nlohmann::json parent;
         jsonStream >> parent;
-        return parseJson(parent, debug, custom_layers);
+        return parseJson(parent, debug, custom_layers, low_rank_tolerance);
     }
 
     /** Returns a reference to a tuple containing the model layers */
@@ -452,6 +824,43 @@ public:
     }
 
 private:
+    template <typename Inputs>
+    RTNEURAL_REALTIME inline void forwardLayers(const Inputs& ins) noexcept
+    {
+        num_output_frames = 0;
+        auto store_output = [this](const auto& frame)
+        { storeOutputFrame(frame); };
+        modelt_detail::forward_from<0, n_layers>::call(layers, ins, store_output);
+    }
+
+    /** Stores an output frame of the final layer in the model outputs. */
+    template <typename Frame>
+    RTNEURAL_REALTIME inline void storeOutputFrame(const Frame& frame) noexcept
+    {
+        auto* frame_outs = outs + num_output_frames * out_size;
+        num_output_frames++;
+
+#if RTNEURAL_USE_XSIMD
+        RTNEURAL_IF_CONSTEXPR(max_output_frames == 1)
+        {
+            for(int i = 0; i < v_out_size; ++i)
+                xsimd::store_aligned(outs + i * v_size, frame[i]);
+        }
+        else
+        {
+            T frame_store alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+            for(int i = 0; i < v_out_size; ++i)
+                xsimd::store_aligned(frame_store + i * v_size, frame[i]);
+            std::copy(frame_store, frame_store + out_size, frame_outs);
+        }
+#elif RTNEURAL_USE_EIGEN
+        RTNEURAL_IF_CONSTEXPR(max_output_frames > 1)
+            std::copy(frame.data(), frame.data() + out_size, frame_outs);
+#else // RTNEURAL_USE_STL
+        std::copy(frame, frame + out_size, frame_outs);
+#endif
+    }
+
 #if RTNEURAL_USE_XSIMD
     using v_type = xsimd::simd_type<T>;
     static constexpr auto v_size = (int)v_type::size;
@@ -465,10 +874,11 @@ private:
 #endif
 
 #if RTNEURAL_USE_XSIMD
-    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[(max_output_frames - 1) * out_size + v_out_size * v_size] {};
 #else
-    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_output_frames * out_size] {};
 #endif
+    int num_output_frames = 1;
 
     std::tuple<Layers...> layers;
     static constexpr size_t n_layers = sizeof...(Layers);
@@ -537,7 +947,7 @@ public:
             alignas(RTNEURAL_DEFAULT_ALIGNMENT) T load_arr[v_size * v_num_filters_in] {};
             std::copy(input + feature_index * num_filters_in, input + feature_index * num_filters_in + num_filters_in, std::begin(load_arr));
             for(int i = 0; i < v_num_filters_in; ++i)
-                v_ins[feature_index * num_filters_in + i] = xsimd::load_aligned(load_arr + i * v_size);
+                v_ins[feature_index * v_num_filters_in + i] = xsimd::load_aligned(load_arr + i * v_size);
         }
         std::get<0>(layers).forward(v_ins);
         modelt_detail::forward_unroll<1, n_layers - 1>::call(layers);
@@ -546,7 +956,7 @@ public:
         {
             alignas(RTNEURAL_DEFAULT_ALIGNMENT) T store_arr[v_size * v_num_filters_out] {};
             for(int i = 0; i < v_num_filters_out; ++i)
-                xsimd::store_aligned(store_arr + i * v_size, get<n_layers - 1>().outs[feature_index * num_filters_out + i]);
+                xsimd::store_aligned(store_arr + i * v_size, get<n_layers - 1>().outs[feature_index * v_num_filters_out + i]);
             std::copy(std::begin(store_arr), std::begin(store_arr) + num_filters_out, outs + feature_index * num_filters_out);
         }
 
@@ -559,18 +969,27 @@ public:
         return outs;
     }
 
-    /** Loads neural network model weights from a json stream. */
-    void parseJson(const nlohmann::json& parent, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
-    {
-        modelt_detail::parseJson<T, input_size>(parent, layers, debug, custom_layers);
+    /**
+     * Loads neural network model weights from a json stream.
+     *
+     * If low_rank_tolerance is greater than zero, the recurrent weights of
+     * any GRU or LSTM layers are approximated with low-rank factors, as long
+     * as the relative error of the approximation is within the tolerance,
+     * and the rank is at most max_recurrent_rank.
+     */
+    void parseJson(const nlohmann::json& parent, const bool debug = false, std::initializer_list<std::string> custom_layers = {},
+        const double low_rank_tolerance = 0.0)
+    {
+        modelt_detail::parseJson<T, input_size>(parent, layers, debug, custom_layers, low_rank_tolerance);
     }
 
     /** Loads neural network model weights from a json stream. */
-    void parseJson(std::ifstream& jsonStream, const bool debug = false, std::initializer_list<std::string> custom_layers = {})
+    void parseJson(std::ifstream& jsonStream, const bool debug = false, std::initializer_list<std::string> custom_layers = {},
+        const double low_rank_tolerance = 0.0)
     {
         nlohmann::json parent;
         jsonStream >> parent;
-        return parseJson(parent, debug, custom_layers);
+        return parseJson(parent, debug, custom_layers, low_rank_tolerance);
     }
 
 private:
@@ -7,8 +7,12 @@
 
 // RTNeural includes:
 #include "config.h"
+#include "cpu_features.h"
 
 #include "Model.h"
 #include "ModelT.h"
+#include "GraphModel.h"
+#include "GraphModelT.h"
 #include "model_loader.h"
+#include "model_optimizer.h"
 #include "torch_helpers.h"
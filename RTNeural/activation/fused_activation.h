@@ -0,0 +1,139 @@
+#ifndef FUSED_ACTIVATION_H_INCLUDED
+#define FUSED_ACTIVATION_H_INCLUDED
+
+#include "../config.h"
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if RTNEURAL_USE_EIGEN
+#include "fused_activation_eigen.h"
+#elif RTNEURAL_USE_XSIMD
+#include "fused_activation_xsimd.h"
+#else
+#include "../maths/maths_stl.h"
+#include <algorithm>
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Activation functions that the static Dense, Conv1D, and Conv2D layers
+ * can apply to their outputs as they are computed, in place of a separate
+ * activation layer:
+ * ```
+ * DenseT<float, 8, 8, true, fused_activation::Tanh<>>
+ * ```
+ * Each activation computes `activation(x, i)` for output channel i.
+ */
+namespace fused_activation
+{
+    /** No activation. */
+    struct Identity
+    {
+        static constexpr bool is_identity = true;
+        static std::string getName() { return ""; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return x; }
+    };
+
+    /** Fused tanh activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Tanh
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "tanh"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return MathsProvider::tanh(x); }
+    };
+
+    /** Fused ReLU activation. */
+    struct ReLu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "relu"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return std::max(x, (V)0); }
+    };
+
+    /** Fused sigmoid activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Sigmoid
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "sigmoid"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return MathsProvider::sigmoid(x); }
+    };
+
+    /** Fused elu activation (with alpha = 1). */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct ELu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "elu"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept
+        {
+            return x > (V)0 ? x : (MathsProvider::exp(x) - (V)1);
+        }
+    };
+
+    /**
+     * Fused PReLU activation, with an alpha value for each of the layer's outputs.
+     * For a Conv2DT layer, num_features must be the layer's number of output features.
+     */
+    template <typename T, int size, int num_features = 1>
+    struct PReLU
+    {
+        static constexpr bool is_identity = false;
+        static constexpr auto out_size = size;
+        static std::string getName() { return "prelu"; }
+
+        PReLU()
+        {
+            std::fill(alpha, alpha + size, (T)0);
+        }
+
+        RTNEURAL_REALTIME inline T operator()(T x, int i) const noexcept
+        {
+            return x >= (T)0 ? x : (x * alpha[i]);
+        }
+
+        RTNEURAL_REALTIME void setAlphaVals(const std::vector<T>& alphaVals)
+        {
+            if(alphaVals.size() == 1)
+                std::fill(alpha, alpha + size, alphaVals[0]);
+            else
+                std::copy(alphaVals.begin(), alphaVals.end(), alpha);
+        }
+
+        T alpha[size];
+    };
+} // namespace fused_activation
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // RTNEURAL_USE_STL
+
+namespace RTNEURAL_NAMESPACE
+{
+namespace fused_activation
+{
+    /** The number of output features of a fused PReLU activation, or 0 for other activations. */
+    template <typename ActivationType>
+    struct prelu_num_features : std::integral_constant<int, 0>
+    {
+    };
+
+    template <typename T, int size, int num_features>
+    struct prelu_num_features<PReLU<T, size, num_features>> : std::integral_constant<int, num_features>
+    {
+    };
+} // namespace fused_activation
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // FUSED_ACTIVATION_H_INCLUDED
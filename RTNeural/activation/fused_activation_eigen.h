@@ -0,0 +1,117 @@
+#ifndef FUSED_ACTIVATIONEIGEN_H_INCLUDED
+#define FUSED_ACTIVATIONEIGEN_H_INCLUDED
+
+#include "../common.h"
+#include "../config.h"
+#include "../maths/maths_eigen.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Activation functions that the static Dense, Conv1D, and Conv2D layers
+ * can apply to their outputs as they are computed, in place of a separate
+ * activation layer:
+ * ```
+ * DenseT<float, 8, 8, true, fused_activation::Tanh<>>
+ * ```
+ * Each activation is applied in-place to the layer's output vector.
+ */
+namespace fused_activation
+{
+    /** No activation. */
+    struct Identity
+    {
+        static constexpr bool is_identity = true;
+        static std::string getName() { return ""; }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector&) const noexcept { }
+    };
+
+    /** Fused tanh activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Tanh
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "tanh"; }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector& v) const noexcept { v = MathsProvider::tanh(v); }
+    };
+
+    /** Fused ReLU activation. */
+    struct ReLu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "relu"; }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector& v) const noexcept
+        {
+            using T = typename Vector::Scalar;
+            v = v.array().max((T)0);
+        }
+    };
+
+    /** Fused sigmoid activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Sigmoid
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "sigmoid"; }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector& v) const noexcept { v = MathsProvider::sigmoid(v); }
+    };
+
+    /** Fused elu activation (with alpha = 1). */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct ELu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "elu"; }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector& v) const noexcept
+        {
+            using T = typename Vector::Scalar;
+            v = (v.array() > (T)0).select(v, MathsProvider::exp(v) - (T)1);
+        }
+    };
+
+    /**
+     * Fused PReLU activation, with an alpha value for each of the layer's outputs.
+     * For a Conv2DT layer, num_features must be the layer's number of output features.
+     */
+    template <typename T, int size, int num_features = 1>
+    struct PReLU
+    {
+        static constexpr bool is_identity = false;
+        static constexpr auto out_size = size;
+        static std::string getName() { return "prelu"; }
+
+        PReLU()
+        {
+            alpha = Eigen::Matrix<T, size, 1>::Zero();
+        }
+
+        template <typename Vector>
+        RTNEURAL_REALTIME inline void apply(Vector& v) const noexcept
+        {
+            v = (v.array() >= (T)0).select(v, alpha.cwiseProduct(v));
+        }
+
+        RTNEURAL_REALTIME void setAlphaVals(const std::vector<T>& alphaVals)
+        {
+            if(alphaVals.size() == 1)
+                alpha.setConstant(alphaVals[0]);
+            else
+                std::copy(alphaVals.begin(), alphaVals.end(), alpha.data());
+        }
+
+        Eigen::Matrix<T, size, 1> alpha;
+    };
+} // namespace fused_activation
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // FUSED_ACTIVATIONEIGEN_H_INCLUDED
@@ -0,0 +1,141 @@
+#ifndef FUSED_ACTIVATIONXSIMD_H_INCLUDED
+#define FUSED_ACTIVATIONXSIMD_H_INCLUDED
+
+#include "../common.h"
+#include "../config.h"
+#include "../maths/maths_xsimd.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Activation functions that the static Dense, Conv1D, and Conv2D layers
+ * can apply to their outputs as they are computed, in place of a separate
+ * activation layer:
+ * ```
+ * DenseT<float, 8, 8, true, fused_activation::Tanh<>>
+ * ```
+ * Each activation computes `activation(x, i)` for the i-th SIMD batch of
+ * outputs, or for the i-th output if x is a scalar.
+ */
+namespace fused_activation
+{
+    /** No activation. */
+    struct Identity
+    {
+        static constexpr bool is_identity = true;
+        static std::string getName() { return ""; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return x; }
+    };
+
+    /** Fused tanh activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Tanh
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "tanh"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return MathsProvider::tanh(x); }
+    };
+
+    /** Fused ReLU activation. */
+    struct ReLu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "relu"; }
+
+        template <typename T>
+        RTNEURAL_REALTIME inline T operator()(T x, int) const noexcept { return std::max(x, (T)0); }
+
+        template <typename T, typename A>
+        RTNEURAL_REALTIME inline xsimd::batch<T, A> operator()(const xsimd::batch<T, A>& x, int) const noexcept
+        {
+            return xsimd::max(x, xsimd::batch<T, A>((T)0));
+        }
+    };
+
+    /** Fused sigmoid activation. */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct Sigmoid
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "sigmoid"; }
+
+        template <typename V>
+        RTNEURAL_REALTIME inline V operator()(V x, int) const noexcept { return MathsProvider::sigmoid(x); }
+    };
+
+    /** Fused elu activation (with alpha = 1). */
+    template <typename MathsProvider = DefaultMathsProvider>
+    struct ELu
+    {
+        static constexpr bool is_identity = false;
+        static std::string getName() { return "elu"; }
+
+        template <typename T>
+        RTNEURAL_REALTIME inline T operator()(T x, int) const noexcept
+        {
+            return x > (T)0 ? x : (MathsProvider::exp(x) - (T)1);
+        }
+
+        template <typename T, typename A>
+        RTNEURAL_REALTIME inline xsimd::batch<T, A> operator()(const xsimd::batch<T, A>& x, int) const noexcept
+        {
+            return xsimd::select(x > (T)0, x, MathsProvider::exp(x) - (T)1);
+        }
+    };
+
+    /**
+     * Fused PReLU activation, with an alpha value for each of the layer's outputs.
+     * For a Conv2DT layer, num_features must be the layer's number of output features.
+     */
+    template <typename T, int size, int num_features = 1>
+    struct PReLU
+    {
+        static_assert(size % num_features == 0, "The PReLU size must be a multiple of the number of features");
+
+        using v_type = xsimd::simd_type<T>;
+        static constexpr auto v_size = (int)v_type::size;
+
+        // the alpha values of each feature are padded to a whole number of
+        // SIMD registers, to match the (SIMD-padded) layer outputs
+        static constexpr auto num_filters = size / num_features;
+        static constexpr auto num_filters_padded = ceil_div(num_filters, v_size) * v_size;
+        static constexpr auto v_alpha_size = num_features * num_filters_padded;
+
+        static constexpr bool is_identity = false;
+        static constexpr auto out_size = size;
+        static std::string getName() { return "prelu"; }
+
+        PReLU()
+        {
+            std::fill(alpha, alpha + v_alpha_size, (T)0);
+        }
+
+        RTNEURAL_REALTIME inline T operator()(T x, int i) const noexcept
+        {
+            return x >= (T)0 ? x : (x * alpha[(i / num_filters) * num_filters_padded + i % num_filters]);
+        }
+
+        RTNEURAL_REALTIME inline v_type operator()(const v_type& x, int i) const noexcept
+        {
+            return xsimd::select(x >= (T)0, x, x * xsimd::load_aligned(alpha + i * v_size));
+        }
+
+        RTNEURAL_REALTIME void setAlphaVals(const std::vector<T>& alphaVals)
+        {
+            for(int j = 0; j < num_features; ++j)
+            {
+                for(int k = 0; k < num_filters; ++k)
+                    alpha[j * num_filters_padded + k] = alphaVals.size() == 1 ? alphaVals[0] : alphaVals[(size_t)(j * num_filters + k)];
+            }
+        }
+
+        T alpha alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_alpha_size];
+    };
+} // namespace fused_activation
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // FUSED_ACTIVATIONXSIMD_H_INCLUDED
@@ -0,0 +1,436 @@
+#pragma once
+
+#include "../Layer.h"
+#include "../common.h"
+#include "../config.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#if RTNEURAL_USE_EIGEN
+#include "../maths/maths_eigen.h"
+#elif RTNEURAL_USE_XSIMD
+#include "../maths/maths_xsimd.h"
+#else
+#include "../maths/maths_stl.h"
+#endif
+
+namespace RTNEURAL_NAMESPACE
+{
+#ifndef DOXYGEN
+namespace attention_detail
+{
+    /**
+     * Computes a numerically stable softmax over the first `dim` values of an
+     * aligned array of scores (in place), by subtracting the maximum score,
+     * and then using the SIMD softmax kernel where one is available.
+     */
+    template <typename T, typename MathsProvider>
+    inline void softmax(T* scores, T* probs, int dim) noexcept
+    {
+        const auto max_score = *std::max_element(scores, scores + dim);
+        for(int i = 0; i < dim; ++i)
+            scores[i] -= max_score;
+
+#if RTNEURAL_USE_XSIMD
+        RTNEURAL_NAMESPACE::softmax<T, MathsProvider>(scores, probs, dim);
+#elif RTNEURAL_USE_EIGEN
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        auto probs_vec = Eigen::Map<Vector, RTNeuralEigenAlignment>(probs, dim);
+        probs_vec.array() = MathsProvider::exp(Eigen::Map<const Vector, RTNeuralEigenAlignment>(scores, dim));
+        probs_vec *= (T)1 / probs_vec.sum();
+#else
+        T exp_sum = 0;
+        for(int i = 0; i < dim; ++i)
+        {
+            probs[i] = MathsProvider::exp(scores[i]);
+            exp_sum += probs[i];
+        }
+
+        const auto exp_sum_recip = (T)1 / exp_sum;
+        for(int i = 0; i < dim; ++i)
+            probs[i] *= exp_sum_recip;
+#endif
+    }
+
+    /** Returns the number of packed weights used by an attention layer. */
+    template <typename T>
+    constexpr int attentionWeightsSize(int embed_dim, int num_heads) noexcept
+    {
+        return (embed_dim + 1) * 3 * padded_size<T>(embed_dim) // input projections and biases
+            + (num_heads * padded_size<T>(embed_dim / num_heads) + 1) * padded_size<T>(embed_dim); // output projection and bias
+    }
+
+    /** Returns the size of the key/value cache of an attention layer. */
+    template <typename T>
+    constexpr int attentionStateSize(int embed_dim, int num_heads, int context_length) noexcept
+    {
+        return embed_dim * padded_size<T>(context_length) // keys
+            + num_heads * context_length * padded_size<T>(embed_dim / num_heads); // values
+    }
+
+    /** Returns the size of the scratch buffers used by an attention layer. */
+    template <typename T>
+    constexpr int attentionScratchSize(int embed_dim, int num_heads, int context_length) noexcept
+    {
+        return 4 * padded_size<T>(embed_dim) + 2 * padded_size<T>(context_length) + num_heads * padded_size<T>(embed_dim / num_heads);
+    }
+
+    /** The weights, state, and scratch buffers of a dynamic layer, in aligned vectors. */
+    template <typename T>
+    struct DynamicStorage
+    {
+#if RTNEURAL_USE_XSIMD
+        using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
+#elif RTNEURAL_USE_EIGEN
+        using vec_type = std::vector<T, Eigen::aligned_allocator<T>>;
+#else
+        using vec_type = std::vector<T>;
+#endif
+
+        DynamicStorage(int weights_size, int state_size, int scratch_size)
+            : storage_weights((size_t)weights_size, (T)0)
+            , storage_state((size_t)state_size, (T)0)
+            , storage_scratch((size_t)scratch_size, (T)0)
+        {
+        }
+
+        vec_type storage_weights;
+        vec_type storage_state;
+        vec_type storage_scratch;
+    };
+
+    /** The weights, state, and scratch buffers of a static layer, in fixed-size aligned arrays. */
+    template <typename T, int weights_size, int state_size, int scratch_size>
+    struct FixedStorage
+    {
+        T storage_weights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[weights_size] {};
+        T storage_state alignas(RTNEURAL_DEFAULT_ALIGNMENT)[state_size] {};
+        T storage_scratch alignas(RTNEURAL_DEFAULT_ALIGNMENT)[scratch_size] {};
+    };
+} // namespace attention_detail
+#endif // DOXYGEN
+
+/**
+ * The packed weights and key/value cache of a causal multi-head self-attention
+ * layer, which processes one frame at a time. For each input frame x, the layer
+ * computes:
+ * ```
+ * q, k, v = W_q x + b_q, W_k x + b_k, W_v x + b_v
+ * append k, v to the cache (dropping the oldest frame, once the cache is full)
+ * for each head h:
+ *     o_h = softmax(q_h . K_h / sqrt(head_dim)) V_h
+ * y = W_o [o_1, ..., o_num_heads] + b_o
+ * ```
+ * so every output frame attends to itself, and to the previous
+ * `context_length - 1` frames.
+ *
+ * The cache is a ring buffer. The keys of each head are stored transposed
+ * (one row of `context_length` values for each key dimension), so that the
+ * attention scores for the whole cache are computed as one matrix-vector
+ * product, with no horizontal reductions. Since the attention is invariant
+ * to the order of the cached frames, the ring buffer never needs to be
+ * unwrapped. The 1 / sqrt(head_dim) scale is folded into the query weights.
+ *
+ * The weights, cache, and scratch buffers are owned by the layer that uses
+ * the attention (in aligned vectors for the dynamic layers, and in fixed-size
+ * member arrays for the static layers), which hands them to the attention
+ * when it is constructed.
+ */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class CausalAttention
+{
+public:
+    /**
+     * The storage for an attention layer, with the sizes given by
+     * attention_detail::attentionWeightsSize(), etc.
+     */
+    struct Storage
+    {
+        T* weights;
+        T* state;
+        T* scratch;
+    };
+
+    /**
+     * Constructs a causal attention layer for the given dimensions.
+     *
+     * @param embed_dim: the input and output size of the layer
+     * @param num_heads: the number of attention heads (which must divide embed_dim)
+     * @param context_length: the number of frames that each output can attend to
+     * @param storage: the storage for the layer
+     */
+    CausalAttention(int embed_dim, int num_heads, int context_length, Storage storage)
+        : embed_dim(embed_dim)
+        , num_heads(num_heads)
+        , head_dim(embed_dim / num_heads)
+        , context_length(context_length)
+        , embed_padded(padded_size<T>(embed_dim))
+        , head_padded(padded_size<T>(head_dim))
+        , context_padded(padded_size<T>(context_length))
+    {
+        const auto allocate = [](T*& data, int size)
+        {
+            auto* result = data;
+            data += size;
+            return result;
+        };
+
+        qkv_weights = allocate(storage.weights, embed_dim * 3 * embed_padded);
+        qkv_bias = allocate(storage.weights, 3 * embed_padded);
+        out_weights = allocate(storage.weights, num_heads * head_padded * embed_padded);
+        out_bias = allocate(storage.weights, embed_padded);
+
+        keys = allocate(storage.state, num_heads * head_dim * context_padded);
+        values = allocate(storage.state, num_heads * context_length * head_padded);
+
+        qkv = allocate(storage.scratch, 3 * embed_padded);
+        scores = allocate(storage.scratch, context_padded);
+        probs = allocate(storage.scratch, context_padded);
+        heads = allocate(storage.scratch, num_heads * head_padded);
+        outputs = allocate(storage.scratch, embed_padded);
+    }
+
+    CausalAttention(const CausalAttention&) = delete;
+    CausalAttention& operator=(const CausalAttention&) = delete;
+
+    /** Clears the key/value cache. */
+    RTNEURAL_REALTIME void resetState()
+    {
+        std::fill(keys, keys + num_heads * head_dim * context_padded, (T)0);
+        std::fill(values, values + num_heads * context_length * head_padded, (T)0);
+        cache_pos = 0;
+        cache_frames = 0;
+    }
+
+    /** Computes the layer outputs for one input frame. */
+    RTNEURAL_REALTIME inline void process(const T* x, T* y) noexcept
+    {
+        std::copy(qkv_bias, qkv_bias + 3 * embed_padded, qkv);
+        vMatVecAccum(qkv_weights, x, qkv, embed_dim, 3 * embed_padded);
+
+        const auto* q = qkv;
+        const auto* k = qkv + embed_padded;
+        const auto* v = qkv + 2 * embed_padded;
+
+        // write the new key and value into the cache
+        for(int h = 0; h < num_heads; ++h)
+        {
+            auto* head_keys = keys + h * head_dim * context_padded + cache_pos;
+            for(int i = 0; i < head_dim; ++i)
+                head_keys[i * context_padded] = k[h * head_dim + i];
+
+            auto* head_values = values + (h * context_length + cache_pos) * head_padded;
+            std::copy(v + h * head_dim, v + (h + 1) * head_dim, head_values);
+        }
+
+        cache_frames = std::min(cache_frames + 1, context_length);
+        cache_pos = cache_pos + 1 == context_length ? 0 : cache_pos + 1;
+
+        // until the cache is full, the cached frames are at the start of the ring buffer
+        std::fill(heads, heads + num_heads * head_padded, (T)0);
+        for(int h = 0; h < num_heads; ++h)
+        {
+            std::fill(scores, scores + context_padded, (T)0);
+            vMatVecAccum(keys + h * head_dim * context_padded, q + h * head_dim, scores, head_dim, context_padded);
+
+            attention_detail::softmax<T, MathsProvider>(scores, probs, cache_frames);
+            vMatVecAccum(values + h * context_length * head_padded, probs, heads + h * head_padded, cache_frames, head_padded);
+        }
+
+        std::copy(out_bias, out_bias + embed_padded, outputs);
+        vMatVecAccum(out_weights, heads, outputs, num_heads * head_padded, embed_padded);
+        std::copy(outputs, outputs + embed_dim, y);
+    }
+
+    /**
+     * Sets the query, key, and value projection weights, in the same layout
+     * as PyTorch's MultiheadAttention "in_proj_weight" and "in_proj_bias".
+     *
+     * The weights vector must have size weights[3 * embed_dim][embed_dim],
+     * and the bias vector must have size bias[3 * embed_dim], where the
+     * first `embed_dim` rows are the query weights, followed by the key
+     * weights, and the value weights.
+     */
+    void setInputWeights(const std::vector<std::vector<T>>& inputWeights, const std::vector<T>& bias)
+    {
+        const auto q_scale = (T)1 / std::sqrt((T)head_dim);
+        for(int i = 0; i < 3 * embed_dim; ++i)
+        {
+            const auto row = (i / embed_dim) * embed_padded + i % embed_dim;
+            const auto scale = i < embed_dim ? q_scale : (T)1;
+            for(int j = 0; j < embed_dim; ++j)
+                qkv_weights[j * 3 * embed_padded + row] = inputWeights[(size_t)i][(size_t)j] * scale;
+            qkv_bias[row] = bias[(size_t)i] * scale;
+        }
+    }
+
+    /**
+     * Sets the output projection weights.
+     *
+     * The weights vector must have size weights[embed_dim][embed_dim],
+     * and the bias vector must have size bias[embed_dim].
+     */
+    void setOutputWeights(const std::vector<std::vector<T>>& outputWeights, const std::vector<T>& bias)
+    {
+        for(int i = 0; i < embed_dim; ++i)
+        {
+            for(int j = 0; j < embed_dim; ++j)
+            {
+                const auto col = (j / head_dim) * head_padded + j % head_dim;
+                out_weights[col * embed_padded + i] = outputWeights[(size_t)i][(size_t)j];
+            }
+            out_bias[i] = bias[(size_t)i];
+        }
+    }
+
+    /** Returns the number of attention heads. */
+    int getNumHeads() const noexcept { return num_heads; }
+
+    /** Returns the number of frames that each output can attend to. */
+    int getContextLength() const noexcept { return context_length; }
+
+private:
+    const int embed_dim;
+    const int num_heads;
+    const int head_dim;
+    const int context_length;
+
+    const int embed_padded;
+    const int head_padded;
+    const int context_padded;
+
+    T* qkv_weights;
+    T* qkv_bias;
+    T* out_weights;
+    T* out_bias;
+
+    T* keys;
+    T* values;
+    int cache_pos = 0;
+    int cache_frames = 0;
+
+    T* qkv;
+    T* scores;
+    T* probs;
+    T* heads;
+    T* outputs;
+};
+
+/** Dynamic implementation of a causal multi-head self-attention layer (see CausalAttention). */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class MultiHeadAttention final : public Layer<T>,
+                                 private attention_detail::DynamicStorage<T>,
+                                 public CausalAttention<T, MathsProvider>
+{
+    using Buffers = attention_detail::DynamicStorage<T>;
+    using Attention = CausalAttention<T, MathsProvider>;
+
+public:
+    /**
+     * Constructs a multi-head attention layer for the given dimensions.
+     *
+     * @param embed_dim: the input and output size of the layer
+     * @param num_heads: the number of attention heads (which must divide embed_dim)
+     * @param context_length: the number of frames that each output can attend to
+     */
+    MultiHeadAttention(int embed_dim, int num_heads, int context_length)
+        : Layer<T>(embed_dim, embed_dim)
+        , Buffers(attention_detail::attentionWeightsSize<T>(embed_dim, num_heads),
+              attention_detail::attentionStateSize<T>(embed_dim, num_heads, context_length),
+              attention_detail::attentionScratchSize<T>(embed_dim, num_heads, context_length))
+        , Attention(embed_dim, num_heads, context_length, { this->storage_weights.data(), this->storage_state.data(), this->storage_scratch.data() })
+    {
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "attention"; }
+
+    /** Clears the key/value cache. */
+    RTNEURAL_REALTIME void reset() override { this->resetState(); }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        this->process(input, out);
+    }
+};
+
+//====================================================
+/**
+ * Static implementation of a causal multi-head self-attention layer (see CausalAttention).
+ *
+ * @param embed_dim: the input and output size of the layer
+ * @param num_heads: the number of attention heads (which must divide embed_dim)
+ * @param context_length: the number of frames that each output can attend to
+ */
+template <typename T, int embed_dim, int num_heads, int context_length, typename MathsProvider = DefaultMathsProvider>
+class MultiHeadAttentionT : private attention_detail::FixedStorage<T,
+                                attention_detail::attentionWeightsSize<T>(embed_dim, num_heads),
+                                attention_detail::attentionStateSize<T>(embed_dim, num_heads, context_length),
+                                attention_detail::attentionScratchSize<T>(embed_dim, num_heads, context_length)>,
+                            public CausalAttention<T, MathsProvider>
+{
+    static_assert(embed_dim % num_heads == 0, "The embedding size must be a multiple of the number of heads!");
+
+    using Attention = CausalAttention<T, MathsProvider>;
+
+public:
+    static constexpr auto in_size = embed_dim;
+    static constexpr auto out_size = embed_dim;
+
+    MultiHeadAttentionT()
+        : Attention(embed_dim, num_heads, context_length, { this->storage_weights, this->storage_state, this->storage_scratch })
+#if RTNEURAL_USE_EIGEN
+        , outs(outs_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_size; ++i)
+            outs[i] = v_type((T)0);
+#endif
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "attention"; }
+
+    /** Returns false since attention is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Clears the key/value cache. */
+    RTNEURAL_REALTIME void reset() { this->resetState(); }
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = ceil_div(embed_dim, (int)v_type::size);
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const v_type (&ins)[v_size]) noexcept
+    {
+        this->process(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs));
+    }
+
+    v_type outs[v_size];
+#elif RTNEURAL_USE_EIGEN
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, embed_dim, 1>& ins) noexcept
+    {
+        this->process(ins.data(), outs.data());
+    }
+
+    Eigen::Map<Eigen::Matrix<T, embed_dim, 1>, RTNeuralEigenAlignment> outs;
+
+private:
+    T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[embed_dim];
+#else
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T (&ins)[embed_dim]) noexcept
+    {
+        this->process(ins, outs);
+    }
+
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[embed_dim] {};
+#endif
+};
+
+} // namespace RTNEURAL_NAMESPACE
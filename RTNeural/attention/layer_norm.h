@@ -0,0 +1,297 @@
+#pragma once
+
+#include "../Layer.h"
+#include "../common.h"
+#include "../config.h"
+#include <cmath>
+#include <vector>
+
+namespace RTNEURAL_NAMESPACE
+{
+#ifndef DOXYGEN
+namespace layer_norm_detail
+{
+    /** Returns the sum of the values of a vector. */
+    template <typename T>
+    inline T sum(const T* x, int size) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        b_type sum_vec((T)0);
+        const auto vec_size = size - size % inc;
+        for(int i = 0; i < vec_size; i += inc)
+            sum_vec += xsimd::load_unaligned(x + i);
+
+        auto result = xsimd::reduce_add(sum_vec);
+        for(int i = vec_size; i < size; ++i)
+            result += x[i];
+        return result;
+#elif RTNEURAL_USE_EIGEN
+        return Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>>(x, size).sum();
+#else
+        T result = (T)0;
+        for(int i = 0; i < size; ++i)
+            result += x[i];
+        return result;
+#endif
+    }
+
+    /** Returns the sum of the squared differences between the values of a vector and a mean value. */
+    template <typename T>
+    inline T sumSquaredDeviations(const T* x, int size, T mean) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        b_type sum_vec((T)0);
+        const auto vec_size = size - size % inc;
+        for(int i = 0; i < vec_size; i += inc)
+        {
+            const auto d_vec = xsimd::load_unaligned(x + i) - mean;
+            sum_vec = xsimd::fma(d_vec, d_vec, sum_vec);
+        }
+
+        auto result = xsimd::reduce_add(sum_vec);
+        for(int i = vec_size; i < size; ++i)
+            result += (x[i] - mean) * (x[i] - mean);
+        return result;
+#elif RTNEURAL_USE_EIGEN
+        return (Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, 1>>(x, size).array() - mean).square().sum();
+#else
+        T result = (T)0;
+        for(int i = 0; i < size; ++i)
+            result += (x[i] - mean) * (x[i] - mean);
+        return result;
+#endif
+    }
+
+    /** Computes out = (x - mean) * scale * gamma + beta. */
+    template <typename T>
+    inline void normalize(const T* x, T* out, const T* gamma, const T* beta, int size, T mean, T scale) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        const auto vec_size = size - size % inc;
+        for(int i = 0; i < vec_size; i += inc)
+        {
+            const auto x_vec = (xsimd::load_unaligned(x + i) - mean) * scale;
+            xsimd::store_unaligned(out + i, xsimd::fma(x_vec, xsimd::load_unaligned(gamma + i), xsimd::load_unaligned(beta + i)));
+        }
+
+        for(int i = vec_size; i < size; ++i)
+            out[i] = (x[i] - mean) * scale * gamma[i] + beta[i];
+#elif RTNEURAL_USE_EIGEN
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        Eigen::Map<Vector>(out, size).array() = (Eigen::Map<const Vector>(x, size).array() - mean) * scale
+                * Eigen::Map<const Vector>(gamma, size).array()
+            + Eigen::Map<const Vector>(beta, size).array();
+#else
+        for(int i = 0; i < size; ++i)
+            out[i] = (x[i] - mean) * scale * gamma[i] + beta[i];
+#endif
+    }
+
+    /**
+     * Computes a layer norm, or an RMS norm (where the mean is not
+     * subtracted, and beta is all zeros) of a vector.
+     * The input and output may be the same array.
+     */
+    template <typename T>
+    inline void layerNorm(const T* x, T* out, const T* gamma, const T* beta, int size, T epsilon, bool rms) noexcept
+    {
+        // the variance is computed in a second pass, since computing it from
+        // the sum of squares loses precision for inputs with a large mean
+        const auto mean = rms ? (T)0 : sum(x, size) / (T)size;
+        const auto variance = sumSquaredDeviations(x, size, mean) / (T)size;
+        normalize(x, out, gamma, beta, size, mean, (T)1 / std::sqrt(variance + epsilon));
+    }
+} // namespace layer_norm_detail
+#endif // DOXYGEN
+
+/**
+ * Dynamic implementation of a layer normalization layer:
+ * ```
+ * y = (x - mean(x)) / sqrt(var(x) + epsilon) * gamma + beta
+ * ```
+ * where the mean and variance are taken over the layer inputs.
+ */
+template <typename T>
+class LayerNorm final : public Layer<T>
+{
+public:
+    /** Constructs a layer norm layer for a given size. */
+    explicit LayerNorm(int size)
+        : Layer<T>(size, size)
+        , gamma((size_t)size, (T)1)
+        , beta((size_t)size, (T)0)
+    {
+    }
+
+    LayerNorm(std::initializer_list<int> sizes)
+        : LayerNorm(*sizes.begin())
+    {
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "layernorm"; }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        layer_norm_detail::layerNorm(input, out, gamma.data(), beta.data(), Layer<T>::out_size, epsilon, false);
+    }
+
+    /** Sets the layer "gamma" values (the scale). */
+    void setGamma(const std::vector<T>& gammaVals) { std::copy(gammaVals.begin(), gammaVals.end(), gamma.begin()); }
+
+    /** Sets the layer "beta" values (the shift). */
+    void setBeta(const std::vector<T>& betaVals) { std::copy(betaVals.begin(), betaVals.end(), beta.begin()); }
+
+    /** Sets the layer "epsilon" value. */
+    void setEpsilon(T newEpsilon) { epsilon = newEpsilon; }
+
+private:
+    std::vector<T> gamma;
+    std::vector<T> beta;
+    T epsilon = (T)1.0e-5;
+};
+
+/**
+ * Dynamic implementation of a root-mean-square normalization layer:
+ * ```
+ * y = x / sqrt(mean(x^2) + epsilon) * gamma
+ * ```
+ */
+template <typename T>
+class RMSNorm final : public Layer<T>
+{
+public:
+    /** Constructs an RMS norm layer for a given size. */
+    explicit RMSNorm(int size)
+        : Layer<T>(size, size)
+        , gamma((size_t)size, (T)1)
+        , beta((size_t)size, (T)0)
+    {
+    }
+
+    RMSNorm(std::initializer_list<int> sizes)
+        : RMSNorm(*sizes.begin())
+    {
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "rmsnorm"; }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        layer_norm_detail::layerNorm(input, out, gamma.data(), beta.data(), Layer<T>::out_size, epsilon, true);
+    }
+
+    /** Sets the layer "gamma" values (the scale). */
+    void setGamma(const std::vector<T>& gammaVals) { std::copy(gammaVals.begin(), gammaVals.end(), gamma.begin()); }
+
+    /** Sets the layer "epsilon" value. */
+    void setEpsilon(T newEpsilon) { epsilon = newEpsilon; }
+
+private:
+    std::vector<T> gamma;
+    std::vector<T> beta; // always zero
+    T epsilon = (T)1.0e-6;
+};
+
+//====================================================
+/**
+ * Static implementation of a layer normalization layer,
+ * or an RMS normalization layer (if `rms` is true).
+ */
+template <typename T, int size, bool rms = false>
+class LayerNormT
+{
+public:
+    static constexpr auto in_size = size;
+    static constexpr auto out_size = size;
+
+    LayerNormT()
+#if RTNEURAL_USE_EIGEN
+        : outs(outs_internal)
+#endif
+    {
+        std::fill(std::begin(gamma), std::end(gamma), (T)1);
+        std::fill(std::begin(beta), std::end(beta), (T)0);
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_size; ++i)
+            outs[i] = v_type((T)0);
+#endif
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return rms ? "rmsnorm" : "layernorm"; }
+
+    /** Returns false since layer norm is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset() { }
+
+    /** Sets the layer "gamma" values (the scale). */
+    void setGamma(const std::vector<T>& gammaVals) { std::copy(gammaVals.begin(), gammaVals.end(), std::begin(gamma)); }
+
+    /** Sets the layer "beta" values (the shift). Ignored for RMS norm layers. */
+    void setBeta(const std::vector<T>& betaVals)
+    {
+        if(!rms)
+            std::copy(betaVals.begin(), betaVals.end(), std::begin(beta));
+    }
+
+    /** Sets the layer "epsilon" value. */
+    void setEpsilon(T newEpsilon) { epsilon = newEpsilon; }
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = ceil_div(size, (int)v_type::size);
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const v_type (&ins)[v_size]) noexcept
+    {
+        layer_norm_detail::layerNorm(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs), gamma, beta, size, epsilon, rms);
+    }
+
+    v_type outs[v_size];
+#elif RTNEURAL_USE_EIGEN
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, size, 1>& ins) noexcept
+    {
+        layer_norm_detail::layerNorm(ins.data(), outs.data(), gamma, beta, size, epsilon, rms);
+    }
+
+    Eigen::Map<Eigen::Matrix<T, size, 1>, RTNeuralEigenAlignment> outs;
+
+private:
+    T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[size];
+#else
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T (&ins)[size]) noexcept
+    {
+        layer_norm_detail::layerNorm(ins, outs, gamma, beta, size, epsilon, rms);
+    }
+
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[size] {};
+#endif
+
+private:
+    T gamma alignas(RTNEURAL_DEFAULT_ALIGNMENT)[size];
+    T beta alignas(RTNEURAL_DEFAULT_ALIGNMENT)[size];
+    T epsilon = rms ? (T)1.0e-6 : (T)1.0e-5;
+};
+
+/** Static implementation of a root-mean-square normalization layer. */
+template <typename T, int size>
+using RMSNormT = LayerNormT<T, size, true>;
+
+} // namespace RTNEURAL_NAMESPACE
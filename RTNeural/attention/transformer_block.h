@@ -0,0 +1,370 @@
+#pragma once
+
+#include "attention.h"
+#include "layer_norm.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+#ifndef DOXYGEN
+namespace attention_detail
+{
+    /** Returns the number of packed weights used by a transformer block. */
+    template <typename T>
+    constexpr int transformerWeightsSize(int embed_dim, int num_heads, int ff_dim) noexcept
+    {
+        return attentionWeightsSize<T>(embed_dim, num_heads)
+            + 4 * padded_size<T>(embed_dim) // norms
+            + (embed_dim + 1) * padded_size<T>(ff_dim) // first feed-forward layer and bias
+            + (ff_dim + 1) * padded_size<T>(embed_dim); // second feed-forward layer and bias
+    }
+
+    /** Returns the size of the scratch buffers used by a transformer block. */
+    template <typename T>
+    constexpr int transformerScratchSize(int embed_dim, int num_heads, int ff_dim, int context_length) noexcept
+    {
+        return attentionScratchSize<T>(embed_dim, num_heads, context_length) + 3 * padded_size<T>(embed_dim) + padded_size<T>(ff_dim);
+    }
+} // namespace attention_detail
+#endif // DOXYGEN
+
+/**
+ * The packed weights and state of a causal transformer encoder block, shared
+ * by the TransformerBlock and TransformerBlockT layers. With pre-normalization
+ * (`norm_first`), the block computes:
+ * ```
+ * h = x + attention(norm1(x))
+ * y = h + feed_forward(norm2(h))
+ * ```
+ * and otherwise (like PyTorch's TransformerEncoderLayer, by default):
+ * ```
+ * h = norm1(x + attention(x))
+ * y = norm2(h + feed_forward(h))
+ * ```
+ * where `attention` is a causal multi-head self-attention layer (see
+ * CausalAttention), `feed_forward(x) = W_2 relu(W_1 x + b_1) + b_2` is
+ * applied to each frame on its own, and the norms are layer norms, or
+ * RMS norms (with `rms_norm`).
+ *
+ * The feed-forward weights are packed column-major, like the attention
+ * weights. The state of the block is the key/value cache of the attention
+ * (see attention_detail::attentionStateSize()), and like the attention,
+ * the block is handed its weights and buffers by the layer that owns them.
+ */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class CausalTransformer
+{
+public:
+    /**
+     * Constructs a transformer block for the given dimensions.
+     *
+     * @param embed_dim: the input and output size of the block
+     * @param num_heads: the number of attention heads (which must divide embed_dim)
+     * @param ff_dim: the hidden size of the feed-forward network
+     * @param context_length: the number of frames that each output can attend to
+     * @param norm_first: true if the norms are applied to the inputs of the attention and feed-forward layers
+     * @param rms_norm: true to use RMS norms instead of layer norms
+     * @param storage: the storage for the block
+     */
+    CausalTransformer(int embed_dim, int num_heads, int ff_dim, int context_length, bool norm_first, bool rms_norm,
+        typename CausalAttention<T, MathsProvider>::Storage storage)
+        : attention(embed_dim, num_heads, context_length, storage)
+        , embed_dim(embed_dim)
+        , ff_dim(ff_dim)
+        , norm_first(norm_first)
+        , rms_norm(rms_norm)
+        , embed_padded(padded_size<T>(embed_dim))
+        , ff_padded(padded_size<T>(ff_dim))
+    {
+        const auto allocate = [](T*& data, int size)
+        {
+            auto* result = data;
+            data += size;
+            return result;
+        };
+
+        storage.weights += attention_detail::attentionWeightsSize<T>(embed_dim, num_heads);
+        storage.scratch += attention_detail::attentionScratchSize<T>(embed_dim, num_heads, context_length);
+
+        norm1_gamma = allocate(storage.weights, embed_padded);
+        norm1_beta = allocate(storage.weights, embed_padded);
+        norm2_gamma = allocate(storage.weights, embed_padded);
+        norm2_beta = allocate(storage.weights, embed_padded);
+        ff1_weights = allocate(storage.weights, embed_dim * ff_padded);
+        ff1_bias = allocate(storage.weights, ff_padded);
+        ff2_weights = allocate(storage.weights, ff_dim * embed_padded);
+        ff2_bias = allocate(storage.weights, embed_padded);
+
+        a = allocate(storage.scratch, embed_padded);
+        h = allocate(storage.scratch, embed_padded);
+        f = allocate(storage.scratch, ff_padded);
+        outputs = allocate(storage.scratch, embed_padded);
+
+        std::fill(norm1_gamma, norm1_gamma + embed_dim, (T)1);
+        std::fill(norm2_gamma, norm2_gamma + embed_dim, (T)1);
+    }
+
+    CausalTransformer(const CausalTransformer&) = delete;
+    CausalTransformer& operator=(const CausalTransformer&) = delete;
+
+    /** Clears the key/value cache of the attention layer. */
+    RTNEURAL_REALTIME void resetState() { attention.resetState(); }
+
+    /** Computes the block outputs for one input frame. */
+    RTNEURAL_REALTIME inline void process(const T* x, T* y) noexcept
+    {
+        if(norm_first)
+        {
+            norm(x, a, norm1_gamma, norm1_beta);
+            attention.process(a, h);
+            for(int i = 0; i < embed_dim; ++i)
+                h[i] += x[i];
+
+            norm(h, a, norm2_gamma, norm2_beta);
+            feedForward(a);
+            for(int i = 0; i < embed_dim; ++i)
+                y[i] = h[i] + outputs[i];
+        }
+        else
+        {
+            attention.process(x, h);
+            for(int i = 0; i < embed_dim; ++i)
+                h[i] += x[i];
+            norm(h, h, norm1_gamma, norm1_beta);
+
+            feedForward(h);
+            for(int i = 0; i < embed_dim; ++i)
+                outputs[i] += h[i];
+            norm(outputs, y, norm2_gamma, norm2_beta);
+        }
+    }
+
+    /** Sets the attention input projection weights (see CausalAttention::setInputWeights()). */
+    void setAttentionInputWeights(const std::vector<std::vector<T>>& inputWeights, const std::vector<T>& bias)
+    {
+        attention.setInputWeights(inputWeights, bias);
+    }
+
+    /** Sets the attention output projection weights (see CausalAttention::setOutputWeights()). */
+    void setAttentionOutputWeights(const std::vector<std::vector<T>>& outputWeights, const std::vector<T>& bias)
+    {
+        attention.setOutputWeights(outputWeights, bias);
+    }
+
+    /**
+     * Sets the weights of the first (index 0) or second (index 1) norm.
+     * The beta values are ignored for RMS norms.
+     */
+    void setNormWeights(int index, const std::vector<T>& gamma, const std::vector<T>& beta)
+    {
+        std::copy(gamma.begin(), gamma.end(), index == 0 ? norm1_gamma : norm2_gamma);
+        if(!rms_norm)
+            std::copy(beta.begin(), beta.end(), index == 0 ? norm1_beta : norm2_beta);
+    }
+
+    /** Sets the "epsilon" value of the norms. */
+    void setNormEpsilon(T newEpsilon) { epsilon = newEpsilon; }
+
+    /**
+     * Sets the feed-forward network weights.
+     *
+     * The weights vectors must have size weights1[ff_dim][embed_dim] and
+     * weights2[embed_dim][ff_dim], and the bias vectors must have size
+     * bias1[ff_dim] and bias2[embed_dim].
+     */
+    void setFeedForwardWeights(const std::vector<std::vector<T>>& weights1, const std::vector<T>& bias1,
+        const std::vector<std::vector<T>>& weights2, const std::vector<T>& bias2)
+    {
+        for(int i = 0; i < ff_dim; ++i)
+            for(int j = 0; j < embed_dim; ++j)
+                ff1_weights[j * ff_padded + i] = weights1[(size_t)i][(size_t)j];
+        std::copy(bias1.begin(), bias1.end(), ff1_bias);
+
+        for(int i = 0; i < embed_dim; ++i)
+            for(int j = 0; j < ff_dim; ++j)
+                ff2_weights[j * embed_padded + i] = weights2[(size_t)i][(size_t)j];
+        std::copy(bias2.begin(), bias2.end(), ff2_bias);
+    }
+
+    /** Returns the number of attention heads. */
+    int getNumHeads() const noexcept { return attention.getNumHeads(); }
+
+    /** Returns the number of frames that each output can attend to. */
+    int getContextLength() const noexcept { return attention.getContextLength(); }
+
+    /** Returns the hidden size of the feed-forward network. */
+    int getFeedForwardSize() const noexcept { return ff_dim; }
+
+    /** Returns true if the norms are applied to the inputs of the attention and feed-forward layers. */
+    bool isNormFirst() const noexcept { return norm_first; }
+
+private:
+    void norm(const T* x, T* out, const T* gamma, const T* beta) noexcept
+    {
+        layer_norm_detail::layerNorm(x, out, gamma, beta, embed_dim, epsilon, rms_norm);
+    }
+
+    /** Computes the feed-forward network outputs (into `outputs`). */
+    void feedForward(const T* x) noexcept
+    {
+        std::copy(ff1_bias, ff1_bias + ff_padded, f);
+        vMatVecAccum(ff1_weights, x, f, embed_dim, ff_padded);
+        for(int i = 0; i < ff_padded; ++i)
+            f[i] = std::max(f[i], (T)0);
+
+        std::copy(ff2_bias, ff2_bias + embed_padded, outputs);
+        vMatVecAccum(ff2_weights, f, outputs, ff_dim, embed_padded);
+    }
+
+    CausalAttention<T, MathsProvider> attention;
+
+    const int embed_dim;
+    const int ff_dim;
+    const bool norm_first;
+    const bool rms_norm;
+
+    const int embed_padded;
+    const int ff_padded;
+
+    T* norm1_gamma;
+    T* norm1_beta;
+    T* norm2_gamma;
+    T* norm2_beta;
+    T epsilon = (T)1.0e-5;
+
+    T* ff1_weights;
+    T* ff1_bias;
+    T* ff2_weights;
+    T* ff2_bias;
+
+    T* a;
+    T* h;
+    T* f;
+    T* outputs;
+};
+
+/** Dynamic implementation of a causal transformer encoder block (see CausalTransformer). */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class TransformerBlock final : public Layer<T>,
+                               private attention_detail::DynamicStorage<T>,
+                               public CausalTransformer<T, MathsProvider>
+{
+    using Buffers = attention_detail::DynamicStorage<T>;
+    using Transformer = CausalTransformer<T, MathsProvider>;
+
+public:
+    /**
+     * Constructs a transformer block for the given dimensions.
+     *
+     * @param embed_dim: the input and output size of the block
+     * @param num_heads: the number of attention heads (which must divide embed_dim)
+     * @param ff_dim: the hidden size of the feed-forward network
+     * @param context_length: the number of frames that each output can attend to
+     * @param norm_first: true if the norms are applied to the inputs of the attention and feed-forward layers
+     * @param rms_norm: true to use RMS norms instead of layer norms
+     */
+    TransformerBlock(int embed_dim, int num_heads, int ff_dim, int context_length, bool norm_first = true, bool rms_norm = false)
+        : Layer<T>(embed_dim, embed_dim)
+        , Buffers(attention_detail::transformerWeightsSize<T>(embed_dim, num_heads, ff_dim),
+              attention_detail::attentionStateSize<T>(embed_dim, num_heads, context_length),
+              attention_detail::transformerScratchSize<T>(embed_dim, num_heads, ff_dim, context_length))
+        , Transformer(embed_dim, num_heads, ff_dim, context_length, norm_first, rms_norm,
+              { this->storage_weights.data(), this->storage_state.data(), this->storage_scratch.data() })
+    {
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "transformer_block"; }
+
+    /** Clears the key/value cache of the attention layer. */
+    RTNEURAL_REALTIME void reset() override { this->resetState(); }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        this->process(input, out);
+    }
+};
+
+//====================================================
+/**
+ * Static implementation of a causal transformer encoder block (see CausalTransformer).
+ *
+ * @param embed_dim: the input and output size of the block
+ * @param num_heads: the number of attention heads (which must divide embed_dim)
+ * @param ff_dim: the hidden size of the feed-forward network
+ * @param context_length: the number of frames that each output can attend to
+ * @param norm_first: true if the norms are applied to the inputs of the attention and feed-forward layers
+ * @param rms_norm: true to use RMS norms instead of layer norms
+ */
+template <typename T, int embed_dim, int num_heads, int ff_dim, int context_length, bool norm_first = true, bool rms_norm = false,
+    typename MathsProvider = DefaultMathsProvider>
+class TransformerBlockT : private attention_detail::FixedStorage<T,
+                              attention_detail::transformerWeightsSize<T>(embed_dim, num_heads, ff_dim),
+                              attention_detail::attentionStateSize<T>(embed_dim, num_heads, context_length),
+                              attention_detail::transformerScratchSize<T>(embed_dim, num_heads, ff_dim, context_length)>,
+                          public CausalTransformer<T, MathsProvider>
+{
+    static_assert(embed_dim % num_heads == 0, "The embedding size must be a multiple of the number of heads!");
+
+    using Transformer = CausalTransformer<T, MathsProvider>;
+
+public:
+    static constexpr auto in_size = embed_dim;
+    static constexpr auto out_size = embed_dim;
+
+    TransformerBlockT()
+        : Transformer(embed_dim, num_heads, ff_dim, context_length, norm_first, rms_norm,
+            { this->storage_weights, this->storage_state, this->storage_scratch })
+#if RTNEURAL_USE_EIGEN
+        , outs(outs_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_size; ++i)
+            outs[i] = v_type((T)0);
+#endif
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "transformer_block"; }
+
+    /** Returns false since the transformer block is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Clears the key/value cache of the attention layer. */
+    RTNEURAL_REALTIME void reset() { this->resetState(); }
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = ceil_div(embed_dim, (int)v_type::size);
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const v_type (&ins)[v_size]) noexcept
+    {
+        this->process(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs));
+    }
+
+    v_type outs[v_size];
+#elif RTNEURAL_USE_EIGEN
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, embed_dim, 1>& ins) noexcept
+    {
+        this->process(ins.data(), outs.data());
+    }
+
+    Eigen::Map<Eigen::Matrix<T, embed_dim, 1>, RTNeuralEigenAlignment> outs;
+
+private:
+    T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[embed_dim];
+#else
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T (&ins)[embed_dim]) noexcept
+    {
+        this->process(ins, outs);
+    }
+
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[embed_dim] {};
+#endif
+};
+
+} // namespace RTNEURAL_NAMESPACE
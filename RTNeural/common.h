@@ -30,6 +30,17 @@ constexpr T ceil_div(T num, T den)
     return (num + den - 1) / den;
 }
 
+/**
+ * Returns true if a grouped convolution should broadcast each input across
+ * the output channels of its group. This only pays off once a group has
+ * enough output channels, so smaller groups compute each output as a dot
+ * product over the inputs of its group. All of the backends use this test.
+ */
+constexpr bool useGroupedBroadcast(int groups, int channels_per_group) noexcept
+{
+    return groups > 1 && channels_per_group >= 8;
+}
+
 struct Empty
 {
 };
@@ -40,7 +51,9 @@ struct Empty
 
 namespace RTNEURAL_NAMESPACE
 {
-#if RTNEURAL_DEFAULT_ALIGNMENT == 32
+#if RTNEURAL_DEFAULT_ALIGNMENT == 64
+constexpr auto RTNeuralEigenAlignment = Eigen::Aligned64;
+#elif RTNEURAL_DEFAULT_ALIGNMENT == 32
 constexpr auto RTNeuralEigenAlignment = Eigen::Aligned32;
 #elif RTNEURAL_DEFAULT_ALIGNMENT == 16
 constexpr auto RTNeuralEigenAlignment = Eigen::Aligned16;
@@ -49,6 +62,35 @@ constexpr auto RTNeuralEigenAlignment = Eigen::Aligned8;
 #else
 #error "Unsupported alignment"
 #endif
+
+/**
+ * Returns the given dimension, rounded up so that an aligned array of that
+ * size keeps the array after it aligned (see vMatVecAccum()).
+ */
+template <typename T>
+constexpr int padded_size(int dim) noexcept
+{
+    return RTNEURAL_DEFAULT_ALIGNMENT > (int)sizeof(T)
+        ? ceil_div(dim, RTNEURAL_DEFAULT_ALIGNMENT / (int)sizeof(T)) * (RTNEURAL_DEFAULT_ALIGNMENT / (int)sizeof(T))
+        : dim;
+}
+
+/**
+ * Accumulates a matrix-vector product into an output vector (out += mat * vec).
+ *
+ * The matrix must be stored column-major, with each column zero-padded to
+ * `out_dim_padded` (see padded_size()), and the matrix and `out` must be
+ * aligned.
+ */
+template <typename T>
+static inline void vMatVecAccum(const T* mat, const T* vec, T* out,
+    int in_dim, int out_dim_padded) noexcept
+{
+    using Matrix = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+    using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    Eigen::Map<Vector, RTNeuralEigenAlignment>(out, out_dim_padded).noalias()
+        += Eigen::Map<const Matrix, RTNeuralEigenAlignment>(mat, out_dim_padded, in_dim) * Eigen::Map<const Vector>(vec, in_dim);
+}
 } // namespace RTNEURAL_NAMESPACE
 
 #elif RTNEURAL_USE_XSIMD
@@ -97,6 +139,205 @@ static inline T vMult(const T* arg1, const T* arg2, T* prod,
     return xsimd::reduce(prod, &prod[dim], (T)0);
 }
 
+/** Returns the given dimension, rounded up to a multiple of the SIMD register width. */
+template <typename T>
+static constexpr int simd_padded_size(int dim) noexcept
+{
+    return ceil_div(dim, (int)xsimd::simd_type<T>::size) * (int)xsimd::simd_type<T>::size;
+}
+
+/**
+ * Returns the given dimension, rounded up so that an aligned array of that
+ * size keeps the array after it aligned (see vMatVecAccum()).
+ */
+template <typename T>
+constexpr int padded_size(int dim) noexcept
+{
+    return simd_padded_size<T>(dim);
+}
+
+/**
+ * Accumulates a matrix-vector product into an output vector (out += mat * vec).
+ *
+ * The matrix must be stored column-major, with each column zero-padded to
+ * `out_dim_padded` (a multiple of the SIMD register width), and `out` must be
+ * an aligned array of size `out_dim_padded`. Each input value is broadcast
+ * against a column of the matrix, and accumulated with FMAs into a block of
+ * output registers, so that no horizontal reductions are needed.
+ */
+template <typename T>
+static inline void vMatVecAccum(const T* mat, const T* vec, T* out,
+    int in_dim, int out_dim_padded) noexcept
+{
+    using b_type = xsimd::simd_type<T>;
+    constexpr auto inc = (int)b_type::size;
+    constexpr auto block_size = 4 * inc;
+
+    int i = 0;
+    for(; i + block_size <= out_dim_padded; i += block_size)
+    {
+        auto acc0 = xsimd::load_aligned(&out[i]);
+        auto acc1 = xsimd::load_aligned(&out[i + inc]);
+        auto acc2 = xsimd::load_aligned(&out[i + 2 * inc]);
+        auto acc3 = xsimd::load_aligned(&out[i + 3 * inc]);
+
+        const T* col = &mat[i];
+        for(int k = 0; k < in_dim; ++k, col += out_dim_padded)
+        {
+            const auto x_vec = b_type(vec[k]);
+            acc0 = xsimd::fma(xsimd::load_aligned(col), x_vec, acc0);
+            acc1 = xsimd::fma(xsimd::load_aligned(col + inc), x_vec, acc1);
+            acc2 = xsimd::fma(xsimd::load_aligned(col + 2 * inc), x_vec, acc2);
+            acc3 = xsimd::fma(xsimd::load_aligned(col + 3 * inc), x_vec, acc3);
+        }
+
+        xsimd::store_aligned(&out[i], acc0);
+        xsimd::store_aligned(&out[i + inc], acc1);
+        xsimd::store_aligned(&out[i + 2 * inc], acc2);
+        xsimd::store_aligned(&out[i + 3 * inc], acc3);
+    }
+
+    for(; i < out_dim_padded; i += inc)
+    {
+        auto acc = xsimd::load_aligned(&out[i]);
+
+        const T* col = &mat[i];
+        for(int k = 0; k < in_dim; ++k, col += out_dim_padded)
+            acc = xsimd::fma(xsimd::load_aligned(col), b_type(vec[k]), acc);
+
+        xsimd::store_aligned(&out[i], acc);
+    }
+}
+
+/**
+ * Accumulates a matrix-matrix product into an output matrix (out += mat * in).
+ *
+ * `mat` is stored like in vMatVecAccum(), and `out` is an aligned column-major
+ * matrix with `num_cols` columns of size `out_dim_padded`. The columns of `in`
+ * are `in_dim` values long, and start `in_col_stride` values apart, so they may
+ * overlap (e.g. the sliding windows of a convolution). The output is computed
+ * one register and four columns at a time, so that each weight register that
+ * is loaded is used for four FMAs.
+ */
+template <typename T>
+static inline void vMatMulAccum(const T* mat, const T* in, T* out,
+    int in_dim, int out_dim_padded, int num_cols, int in_col_stride) noexcept
+{
+    using b_type = xsimd::simd_type<T>;
+    constexpr auto inc = (int)b_type::size;
+
+    int j = 0;
+    for(; j + 4 <= num_cols; j += 4)
+    {
+        const T* x0 = in + j * in_col_stride;
+        const T* x1 = x0 + in_col_stride;
+        const T* x2 = x1 + in_col_stride;
+        const T* x3 = x2 + in_col_stride;
+        T* out0 = out + j * out_dim_padded;
+
+        for(int i = 0; i < out_dim_padded; i += inc)
+        {
+            auto acc0 = xsimd::load_aligned(&out0[i]);
+            auto acc1 = xsimd::load_aligned(&out0[i + out_dim_padded]);
+            auto acc2 = xsimd::load_aligned(&out0[i + 2 * out_dim_padded]);
+            auto acc3 = xsimd::load_aligned(&out0[i + 3 * out_dim_padded]);
+
+            const T* col = &mat[i];
+            for(int k = 0; k < in_dim; ++k, col += out_dim_padded)
+            {
+                const auto w = xsimd::load_aligned(col);
+                acc0 = xsimd::fma(w, b_type(x0[k]), acc0);
+                acc1 = xsimd::fma(w, b_type(x1[k]), acc1);
+                acc2 = xsimd::fma(w, b_type(x2[k]), acc2);
+                acc3 = xsimd::fma(w, b_type(x3[k]), acc3);
+            }
+
+            xsimd::store_aligned(&out0[i], acc0);
+            xsimd::store_aligned(&out0[i + out_dim_padded], acc1);
+            xsimd::store_aligned(&out0[i + 2 * out_dim_padded], acc2);
+            xsimd::store_aligned(&out0[i + 3 * out_dim_padded], acc3);
+        }
+    }
+
+    for(; j < num_cols; ++j)
+        vMatVecAccum(mat, in + j * in_col_stride, out + j * out_dim_padded, in_dim, out_dim_padded);
+}
+
+/**
+ * Accumulates a matrix-matrix product into an output matrix, like
+ * vMatMulAccum(), for input columns that are scattered in memory
+ * (e.g. the recent inputs of a convolution, some of which are stored in
+ * its state). `in_cols` holds a pointer to each of the `num_cols` input
+ * columns, and the aligned output columns start `out_col_stride` values apart.
+ */
+template <typename T>
+static inline void vMatMulAccumColumns(const T* mat, const T* const* in_cols, T* out,
+    int in_dim, int out_dim_padded, int num_cols, int out_col_stride) noexcept
+{
+    using b_type = xsimd::simd_type<T>;
+    constexpr auto inc = (int)b_type::size;
+
+    int j = 0;
+    for(; j + 4 <= num_cols; j += 4)
+    {
+        const T* x0 = in_cols[j];
+        const T* x1 = in_cols[j + 1];
+        const T* x2 = in_cols[j + 2];
+        const T* x3 = in_cols[j + 3];
+        T* out0 = out + j * out_col_stride;
+
+        for(int i = 0; i < out_dim_padded; i += inc)
+        {
+            auto acc0 = xsimd::load_aligned(&out0[i]);
+            auto acc1 = xsimd::load_aligned(&out0[i + out_col_stride]);
+            auto acc2 = xsimd::load_aligned(&out0[i + 2 * out_col_stride]);
+            auto acc3 = xsimd::load_aligned(&out0[i + 3 * out_col_stride]);
+
+            const T* col = &mat[i];
+            for(int k = 0; k < in_dim; ++k, col += out_dim_padded)
+            {
+                const auto w = xsimd::load_aligned(col);
+                acc0 = xsimd::fma(w, b_type(x0[k]), acc0);
+                acc1 = xsimd::fma(w, b_type(x1[k]), acc1);
+                acc2 = xsimd::fma(w, b_type(x2[k]), acc2);
+                acc3 = xsimd::fma(w, b_type(x3[k]), acc3);
+            }
+
+            xsimd::store_aligned(&out0[i], acc0);
+            xsimd::store_aligned(&out0[i + out_col_stride], acc1);
+            xsimd::store_aligned(&out0[i + 2 * out_col_stride], acc2);
+            xsimd::store_aligned(&out0[i + 3 * out_col_stride], acc3);
+        }
+    }
+
+    for(; j < num_cols; ++j)
+        vMatVecAccum(mat, in_cols[j], out + j * out_col_stride, in_dim, out_dim_padded);
+}
+
+/**
+ * Accumulates an element-wise product into an output vector (out += in1 * in2).
+ *
+ * `in1` and `out` must be aligned, but `in2` may be unaligned.
+ */
+template <typename T>
+static inline void vProdAccum(const T* in1, const T* in2, T* out, int dim) noexcept
+{
+    using b_type = xsimd::simd_type<T>;
+    constexpr auto inc = (int)b_type::size;
+
+    // size for which the vectorization is possible
+    auto vec_size = dim - dim % inc;
+    for(int i = 0; i < vec_size; i += inc)
+    {
+        const auto acc = xsimd::fma(xsimd::load_aligned(&in1[i]), xsimd::load_unaligned(&in2[i]), xsimd::load_aligned(&out[i]));
+        xsimd::store_aligned(&out[i], acc);
+    }
+
+    // Remaining part that cannot be vectorized
+    for(auto i = vec_size; i < dim; ++i)
+        out[i] += in1[i] * in2[i];
+}
+
 template <typename T>
 static inline void vAdd(const T* in1, const T* in2, T* out,
     int dim) noexcept
@@ -258,6 +499,81 @@ static inline T vMult(const T* arg1, const T* arg2, int dim) noexcept
 {
     return std::inner_product(arg1, arg1 + dim, arg2, (T)0);
 }
+
+/**
+ * Returns the given dimension, rounded up so that an aligned array of that
+ * size keeps the array after it aligned.
+ */
+template <typename T>
+constexpr int padded_size(int dim) noexcept
+{
+    return RTNEURAL_DEFAULT_ALIGNMENT > (int)sizeof(T)
+        ? ceil_div(dim, RTNEURAL_DEFAULT_ALIGNMENT / (int)sizeof(T)) * (RTNEURAL_DEFAULT_ALIGNMENT / (int)sizeof(T))
+        : dim;
+}
+
+/**
+ * Accumulates a matrix-vector product into an output vector (out += mat * vec).
+ *
+ * The matrix must be stored column-major, so that each input value
+ * is multiplied against a contiguous column of the matrix.
+ */
+template <typename T>
+static inline void vMatVecAccum(const T* mat, const T* vec, T* out,
+    int in_dim, int out_dim) noexcept
+{
+    for(int k = 0; k < in_dim; ++k, mat += out_dim)
+    {
+        const auto x = vec[k];
+        for(int i = 0; i < out_dim; ++i)
+            out[i] += mat[i] * x;
+    }
+}
+
+/**
+ * Accumulates a matrix-matrix product into an output matrix (out += mat * in).
+ *
+ * `mat` is stored like in vMatVecAccum(), and `out` is a column-major matrix
+ * with `num_cols` columns of size `out_dim`. The columns of `in` are `in_dim`
+ * values long, and start `in_col_stride` values apart, so they may overlap
+ * (e.g. the sliding windows of a convolution). Four input values are
+ * accumulated at a time, so that each output column is loaded and stored
+ * once for every four columns of the matrix.
+ */
+template <typename T>
+static inline void vMatMulAccum(const T* mat, const T* in, T* out,
+    int in_dim, int out_dim, int num_cols, int in_col_stride) noexcept
+{
+    for(int j = 0; j < num_cols; ++j, in += in_col_stride, out += out_dim)
+    {
+        const T* col = mat;
+        int k = 0;
+        for(; k + 4 <= in_dim; k += 4, col += 4 * out_dim)
+        {
+            const auto x0 = in[k];
+            const auto x1 = in[k + 1];
+            const auto x2 = in[k + 2];
+            const auto x3 = in[k + 3];
+            for(int i = 0; i < out_dim; ++i)
+                out[i] += col[i] * x0 + col[out_dim + i] * x1 + col[2 * out_dim + i] * x2 + col[3 * out_dim + i] * x3;
+        }
+
+        for(; k < in_dim; ++k, col += out_dim)
+        {
+            const auto x = in[k];
+            for(int i = 0; i < out_dim; ++i)
+                out[i] += col[i] * x;
+        }
+    }
+}
+
+/** Accumulates an element-wise product into an output vector (out += in1 * in2). */
+template <typename T>
+static inline void vProdAccum(const T* in1, const T* in2, T* out, int dim) noexcept
+{
+    for(int i = 0; i < dim; ++i)
+        out[i] += in1[i] * in2[i];
+}
 } // namespace RTNEURAL_NAMESPACE
 
 #endif
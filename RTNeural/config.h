@@ -4,6 +4,17 @@
 #define RTNEURAL_NAMESPACE RTNeural
 #endif
 
+/**
+ * When RTNeural is built with RTNEURAL_RUNTIME_DISPATCH, this marks the entry
+ * points of a module compiled with rtneural_add_dispatch_library(), so that
+ * they can be found with RTNeural::DispatchModule::getFunction().
+ */
+#if defined(_WIN32)
+#define RTNEURAL_DISPATCH_EXPORT extern "C" __declspec(dllexport)
+#else
+#define RTNEURAL_DISPATCH_EXPORT extern "C" __attribute__((visibility("default")))
+#endif
+
 #ifndef RTNEURAL_DEFAULT_ALIGNMENT
 #if _MSC_VER
 #pragma message("RTNEURAL_DEFAULT_ALIGNMENT was not defined! Using default alignment = 16.")
@@ -13,6 +24,10 @@
 #define RTNEURAL_DEFAULT_ALIGNMENT 16
 #endif
 
+#if RTNEURAL_DEFAULT_ALIGNMENT != 8 && RTNEURAL_DEFAULT_ALIGNMENT != 16 && RTNEURAL_DEFAULT_ALIGNMENT != 32 && RTNEURAL_DEFAULT_ALIGNMENT != 64
+#error "Unsupported alignment! RTNEURAL_DEFAULT_ALIGNMENT must be 8, 16, 32, or 64."
+#endif
+
 #if defined(_MSVC_LANG)
 #define RTNEURAL_CPLUSPLUS _MSVC_LANG
 #elif defined(__cplusplus)
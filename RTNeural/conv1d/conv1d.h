@@ -9,8 +9,12 @@
 #include "conv1d_xsimd.tpp"
 #else
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../common.h"
 #include "../config.h"
+#include "conv1d_fft.h"
+#include <memory>
 #include <vector>
 
 namespace RTNEURAL_NAMESPACE
@@ -18,13 +22,16 @@ namespace RTNEURAL_NAMESPACE
 
 /**
  * Dynamic implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
  * to the layer. To ensure that the state is initialized to zero,
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
+ *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
  */
 template <typename T>
 class Conv1D final : public Layer<T>
@@ -37,8 +44,10 @@ public:
      * @param out_size: the output size for the layer
      * @param kernel_size: the size of the convolution kernel
      * @param dilation: the dilation rate to use for dilated convolution
+     * @param groups: controls connections between inputs and outputs
+     * @param use_fft: compute the tail of a long kernel with FFT convolution
      */
-    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1);
+    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1, bool use_fft = false);
     Conv1D(std::initializer_list<int> sizes);
     Conv1D(const Conv1D& other);
     Conv1D& operator=(const Conv1D& other);
@@ -53,71 +62,111 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const T* input)
     {
-        // insert input into a circular buffer
-        std::copy(input, input + Layer<T>::in_size, state[state_ptr]);
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
+        pushState(input);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        if(fft_tail.isActive())
+            fft_tail.skip(input);
     }
 
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        // insert input into a circular buffer
-        std::copy(input, input + Layer<T>::in_size, state[state_ptr]);
+        if(depthwise && kernel_size == 1)
+        {
+            // a depthwise convolution with a single tap is an element-wise scaling
+            std::copy(bias, bias + Layer<T>::out_size, h);
+            vProdAccum(group_weights.data(), input, h, Layer<T>::out_size);
+            if(activation != nullptr)
+                activation->forward(h, h);
+            return;
+        }
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        pushState(input);
 
-        if(groups == 1)
+        // perform multi-channel convolution, reading the kernel taps in-place
+        const auto* const* newest = state + state_ptr + state_size;
+        if(!vectorize_groups)
         {
-            // copy selected columns to a helper variable
-            for(int k = 0; k < kernel_size; ++k)
-            {
-                const auto& col = state[state_ptrs[k]];
-                std::copy(col, col + Layer<T>::in_size, state_cols[k]);
-            }
-
-            // perform multi-channel convolution
             for(int i = 0; i < Layer<T>::out_size; ++i)
             {
                 h[i] = bias[i];
-                for(int k = 0; k < kernel_size; ++k)
+                const auto ii = ((i / channels_per_group) * filters_per_group);
+                for(int k = 0; k < direct_kernel_size; ++k)
                     h[i] = std::inner_product(
                         weights[i][k],
                         weights[i][k] + filters_per_group,
-                        state_cols[k],
+                        *(newest - k * dilation_rate) + ii,
                         h[i]);
             }
         }
         else
         {
-            // perform multi-channel convolution
-            for(int i = 0; i < Layer<T>::out_size; ++i)
-            {
-                h[i] = bias[i];
-                const auto ii = ((i / channels_per_group) * filters_per_group);
-                for(int k = 0; k < kernel_size; ++k)
-                {
-                    // copy selected columns to a helper variable
-                    const auto& column = state[state_ptrs[k]];
+            std::copy(bias, bias + Layer<T>::out_size, h);
+            for(int k = 0; k < direct_kernel_size; ++k)
+                accumulateGroupedTap(k, *(newest - k * dilation_rate), h);
+        }
 
-                    const auto column_begin = column + ii;
-                    const auto column_end = column_begin + filters_per_group;
-                    std::copy(column_begin, column_end, state_cols[k]);
+        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
 
-                    h[i] = std::inner_product(
-                        weights[i][k],
-                        weights[i][k] + filters_per_group,
-                        state_cols[k],
-                        h[i]);
+        if(fft_tail.isActive())
+            fft_tail.process(input, h);
+
+        if(activation != nullptr)
+            activation->forward(h, h);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * The convolution is computed one kernel tap at a time over the whole
+     * block, so that the weights for each tap are re-used for every sample.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        const auto out_size = Layer<T>::out_size;
+        for(int n = 0; n < num_samples; ++n)
+            std::copy(bias, bias + out_size, output + n * out_size);
+
+        for(int k = 0; k < direct_kernel_size; ++k)
+        {
+            const auto delay = k * dilation_rate;
+            if(!vectorize_groups)
+            {
+                for(int i = 0; i < out_size; ++i)
+                {
+                    const auto ii = ((i / channels_per_group) * filters_per_group);
+                    const auto* w = weights[i][k];
+                    for(int n = 0; n < num_samples; ++n)
+                        output[n * out_size + i] = std::inner_product(w, w + filters_per_group,
+                            blockFrame(input, n - delay) + ii, output[n * out_size + i]);
                 }
             }
+            else
+            {
+                for(int n = 0; n < num_samples; ++n)
+                    accumulateGroupedTap(k, blockFrame(input, n - delay), output + n * out_size);
+            }
         }
 
-        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+        // only the most recent inputs are needed for the next block
+        for(int n = std::max(0, num_samples - state_size); n < num_samples; ++n)
+        {
+            pushState(input + n * Layer<T>::in_size);
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        if(fft_tail.isActive())
+            fft_tail.processBlock(input, output, num_samples);
+
+        if(activation != nullptr)
+        {
+            for(int n = 0; n < num_samples; ++n)
+                activation->forward(output + n * out_size, output + n * out_size);
+        }
     }
 
     /**
@@ -143,35 +192,89 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    bool usesFFT() const noexcept { return fft_tail.isActive(); }
+
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
 private:
     const int dilation_rate;
     const int kernel_size;
+    const int direct_kernel_size; // taps computed in direct form
     const int state_size;
     const int groups;
     const int filters_per_group;
     const int channels_per_group;
+    const bool depthwise; // groups == in_size == out_size
+
+    // depthwise convolutions, and grouped convolutions with enough output channels
+    // per group, are vectorized across the output channels of each group
+    const bool vectorize_groups;
 
     T*** weights;
     T* bias;
 
-    T** state;
-    T** state_cols;
+    // for vectorize_groups, the weights are also stored column-major for each kernel tap and group:
+    // group_weights[direct_kernel_size][groups][filters_per_group][channels_per_group]
+    std::vector<T> group_weights;
+
+    // computes the kernel taps after the first direct_kernel_size taps
+    FFTConvolution<T> fft_tail;
 
-    int* state_ptrs;
+    // mirrored circular buffer: state[n] and state[n + state_size] hold
+    // the same input, so the kernel taps (state_ptr + state_size - k * dilation_rate)
+    // can be read without wrapping around the end of the buffer.
+    T** state;
     int state_ptr = 0;
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
+    std::unique_ptr<Activation<T>> activation;
+
+    /** Inserts an input into the state buffer. */
+    inline void pushState(const T* input) noexcept
     {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
+        std::copy(input, input + Layer<T>::in_size, state[state_ptr]);
+        std::copy(input, input + Layer<T>::in_size, state[state_ptr + state_size]);
+    }
+
+    /**
+     * Returns the n-th input of a block, where negative indices refer
+     * to the inputs from before the block, stored in the state buffer.
+     */
+    inline const T* blockFrame(const T* input, int n) const noexcept
+    {
+        return n >= 0 ? input + n * Layer<T>::in_size : state[state_ptr + state_size + n];
+    }
+
+    /**
+     * Accumulates kernel tap k of a grouped convolution (h += W_k * x),
+     * with each input broadcast across the output channels of its group.
+     */
+    inline void accumulateGroupedTap(int k, const T* x, T* h) const noexcept
+    {
+        const auto* w = group_weights.data() + k * filters_per_group * Layer<T>::out_size;
+        if(depthwise)
+        {
+            vProdAccum(w, x, h, Layer<T>::out_size);
+            return;
+        }
+
+        for(int g = 0; g < groups; ++g, w += filters_per_group * channels_per_group)
+            vMatVecAccum(w, x + g * filters_per_group, h + g * channels_per_group, filters_per_group, channels_per_group);
     }
 };
 
 //====================================================
 /**
  * Static implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see fused_activation).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
@@ -179,25 +282,39 @@ private:
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
  *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
+ *
  * @param in_sizet: the input size for the layer
  * @param out_sizet: the output size for the layer
  * @param kernel_size: the size of the convolution kernel
  * @param dilation_rate: the dilation rate to use for dilated convolution
  * @param groups: controls connections between inputs and outputs
  * @param dynamic_state: use dynamically allocated layer state
+ * @param FusedActivation: an activation to apply to the layer outputs
+ * @param use_fft: compute the tail of a long kernel with FFT convolution
  */
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false>
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false,
+    typename FusedActivation = fused_activation::Identity, bool use_fft = false>
 class Conv1DT
 {
     static_assert((in_sizet % groups == 0) && (out_sizet % groups == 0), "in_size and out_size must be divisible by groups!");
 
-    static constexpr auto state_size = (kernel_size - 1) * dilation_rate + 1;
+    static constexpr auto direct_kernel_size = use_fft ? fft_conv::directKernelSize(kernel_size, dilation_rate) : kernel_size;
+    static constexpr auto state_size = (direct_kernel_size - 1) * dilation_rate + 1;
+    static constexpr bool has_fft_tail = direct_kernel_size < kernel_size;
+    static constexpr bool is_depthwise = groups > 1 && groups == in_sizet && groups == out_sizet;
+
+    // depthwise convolutions, and grouped convolutions with enough output channels
+    // per group, are vectorized across the output channels of each group
+    static constexpr bool vectorize_groups = is_depthwise || useGroupedBroadcast(groups, out_sizet / groups);
 
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
     static constexpr auto filters_per_group = in_size / groups;
     static constexpr auto channels_per_group = out_size / groups;
+    using activation_type = FusedActivation;
 
     Conv1DT();
 
@@ -213,80 +330,115 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const T (&ins)[in_size])
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
+        pushState(ins);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.skip(ins);
+        }
     }
 
-    template <int _groups = groups, std::enable_if_t<_groups == 1, bool> = true>
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T (&ins)[in_size]) noexcept
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
+        RTNEURAL_IF_CONSTEXPR(is_depthwise && kernel_size == 1)
+        {
+            // a depthwise convolution with a single tap is an element-wise scaling
+            std::copy(bias.begin(), bias.end(), outs);
+            vProdAccum(group_weights, ins, outs, out_size);
+            applyActivation(outs);
+            return;
+        }
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        pushState(ins);
 
-        // copy selected columns to a helper variable
-        for(int k = 0; k < kernel_size; ++k)
+        // perform multi-channel convolution, reading the kernel taps in-place
+        const auto newest = state_ptr + state_size;
+        RTNEURAL_IF_CONSTEXPR(!vectorize_groups)
         {
-            const auto& col = state[state_ptrs[k]];
-            std::copy(col.begin(), col.end(), state_cols[k].begin());
-        }
+            for(int i = 0; i < out_size; ++i)
+            {
+                outs[i] = bias[i];
 
-        // perform multi-channel convolution
-        for(int i = 0; i < out_size; ++i)
+                const auto ii = ((i / channels_per_group) * filters_per_group);
+                for(int k = 0; k < direct_kernel_size; ++k)
+                    outs[i] = std::inner_product(
+                        weights[i][k].begin(),
+                        weights[i][k].end(),
+                        state[newest - k * dilation_rate].begin() + ii,
+                        outs[i]);
+            }
+        }
+        else
         {
-            outs[i] = bias[i];
-            for(int k = 0; k < kernel_size; ++k)
-                outs[i] = std::inner_product(
-                    weights[i][k].begin(),
-                    weights[i][k].end(),
-                    state_cols[k].begin(),
-                    outs[i]);
+            std::copy(bias.begin(), bias.end(), outs);
+            for(int k = 0; k < direct_kernel_size; ++k)
+                accumulateGroupedTap(k, state[newest - k * dilation_rate].data(), outs);
         }
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(ins, outs);
+        }
+
+        applyActivation(outs);
     }
 
-    template <int _groups = groups, std::enable_if_t<_groups != 1, bool> = true>
-    /** Performs forward propagation for this layer. */
-    inline void forward(const T (&ins)[in_size]) noexcept
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * The convolution is computed one kernel tap at a time over the whole
+     * block, so that the weights for each tap are re-used for every sample.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        for(int n = 0; n < num_samples; ++n)
+            std::copy(bias.begin(), bias.end(), output + n * out_size);
 
-        // perform multi-channel convolution
-        for(int i = 0; i < out_size; ++i)
+        for(int k = 0; k < direct_kernel_size; ++k)
         {
-            outs[i] = bias[i];
-
-            const auto ii = ((i / channels_per_group) * filters_per_group);
-            for(int k = 0; k < kernel_size; ++k)
+            const auto delay = k * dilation_rate;
+            RTNEURAL_IF_CONSTEXPR(!vectorize_groups)
+            {
+                for(int i = 0; i < out_size; ++i)
+                {
+                    const auto ii = ((i / channels_per_group) * filters_per_group);
+                    for(int n = 0; n < num_samples; ++n)
+                        output[n * out_size + i] = std::inner_product(weights[i][k].begin(), weights[i][k].end(),
+                            blockFrame(input, n - delay) + ii, output[n * out_size + i]);
+                }
+            }
+            else
             {
-                // copy selected columns to a helper variable
-                const auto& column = state[state_ptrs[k]];
-                const auto column_begin = column.begin() + ii;
-                const auto column_end = column_begin + filters_per_group;
-                std::copy(column_begin, column_end, state_cols[k].begin());
-
-                outs[i] = std::inner_product(
-                    weights[i][k].begin(),
-                    weights[i][k].end(),
-                    state_cols[k].begin(),
-                    outs[i]);
+                for(int n = 0; n < num_samples; ++n)
+                    accumulateGroupedTap(k, blockFrame(input, n - delay), output + n * out_size);
             }
         }
 
-        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+        // only the most recent inputs are needed for the next block
+        for(int n = std::max(0, num_samples - state_size); n < num_samples; ++n)
+        {
+            std::copy(input + n * in_size, input + (n + 1) * in_size, state[state_ptr].begin());
+            std::copy(input + n * in_size, input + (n + 1) * in_size, state[state_ptr + state_size].begin());
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.processBlock(input, output, num_samples);
+        }
+
+        for(int n = 0; n < num_samples; ++n)
+            applyActivation(output + n * out_size);
+
+        if(num_samples > 0)
+            std::copy(output + (num_samples - 1) * out_size, output + num_samples * out_size, outs);
     }
 
     /**
@@ -312,36 +464,85 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    static constexpr bool usesFFT() noexcept { return has_fft_tail; }
+
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
 
 private:
     template <int DS = dynamic_state>
     typename std::enable_if<DS, void>::type resize_state()
     {
-        state.resize(state_size, {});
+        state.resize(2 * state_size, {});
     }
 
     template <int DS = dynamic_state>
     typename std::enable_if<!DS, void>::type resize_state() { }
 
-    using state_type = typename std::conditional<dynamic_state, std::vector<std::array<T, in_size>>, std::array<std::array<T, in_size>, state_size>>::type;
-    using weights_type = std::array<std::array<T, filters_per_group>, kernel_size>;
+    /** Inserts an input into both halves of the mirrored state buffer. */
+    inline void pushState(const T (&ins)[in_size]) noexcept
+    {
+        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
+        std::copy(std::begin(ins), std::end(ins), state[state_ptr + state_size].begin());
+    }
 
-    alignas(RTNEURAL_DEFAULT_ALIGNMENT) state_type state;
-    alignas(RTNEURAL_DEFAULT_ALIGNMENT) weights_type state_cols;
+    /**
+     * Returns the n-th input of a block, where negative indices refer
+     * to the inputs from before the block, stored in the state buffer.
+     */
+    inline const T* blockFrame(const T* input, int n) const noexcept
+    {
+        return n >= 0 ? input + n * in_size : state[state_ptr + state_size + n].data();
+    }
+
+    /** Applies the fused activation to a frame of outputs. */
+    inline void applyActivation(T* h) const noexcept
+    {
+        RTNEURAL_IF_CONSTEXPR(!FusedActivation::is_identity)
+        {
+            for(int i = 0; i < out_size; ++i)
+                h[i] = activation(h[i], i);
+        }
+    }
+
+    /**
+     * Accumulates kernel tap k of a grouped convolution (h += W_k * x),
+     * with each input broadcast across the output channels of its group.
+     */
+    inline void accumulateGroupedTap(int k, const T* x, T* h) const noexcept
+    {
+        const auto* w = group_weights + k * filters_per_group * out_size;
+        RTNEURAL_IF_CONSTEXPR(is_depthwise)
+        {
+            vProdAccum(w, x, h, out_size);
+            return;
+        }
 
+        for(int g = 0; g < groups; ++g, w += filters_per_group * channels_per_group)
+            vMatVecAccum(w, x + g * filters_per_group, h + g * channels_per_group, filters_per_group, channels_per_group);
+    }
+
+    using state_type = typename std::conditional<dynamic_state, std::vector<std::array<T, in_size>>, std::array<std::array<T, in_size>, 2 * state_size>>::type;
+    using weights_type = std::array<std::array<T, filters_per_group>, direct_kernel_size>;
+
+    // mirrored circular buffer, with state[n] == state[n + state_size]
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) state_type state;
     int state_ptr = 0;
-    std::array<int, kernel_size> state_ptrs;
 
     alignas(RTNEURAL_DEFAULT_ALIGNMENT) weights_type weights[out_size];
     alignas(RTNEURAL_DEFAULT_ALIGNMENT) std::array<T, out_size> bias;
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
-    {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
-    }
+    // for vectorize_groups, the weights are also stored column-major for each kernel tap and group:
+    // group_weights[direct_kernel_size][groups][filters_per_group][channels_per_group]
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) T group_weights[vectorize_groups ? direct_kernel_size * filters_per_group * out_size : 1] {};
+
+    // computes the kernel taps after the first direct_kernel_size taps
+    FFTConvolution<T> fft_tail { in_size, out_size, kernel_size, dilation_rate, groups, use_fft };
+
+    FusedActivation activation;
 };
 } // namespace RTNEURAL_NAMESPACE
 #endif
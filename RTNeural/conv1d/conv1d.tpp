@@ -6,20 +6,24 @@ namespace RTNEURAL_NAMESPACE
 #if !RTNEURAL_USE_EIGEN && !RTNEURAL_USE_XSIMD
 
 template <typename T>
-Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups)
+Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups, bool use_fft)
     : Layer<T>(in_size, out_size)
     , dilation_rate(dilation)
     , kernel_size(kernel_size)
-    , state_size((kernel_size - 1) * dilation + 1)
+    , direct_kernel_size(use_fft ? fft_conv::directKernelSize(kernel_size, dilation) : kernel_size)
+    , state_size((direct_kernel_size - 1) * dilation + 1)
     , groups(num_groups)
     , filters_per_group(in_size / groups)
     , channels_per_group(out_size / groups)
+    , depthwise(groups > 1 && groups == in_size && groups == out_size)
+    , vectorize_groups(depthwise || useGroupedBroadcast(groups, channels_per_group))
+    , fft_tail(in_size, out_size, kernel_size, dilation, num_groups, use_fft)
 {
     weights = new T**[out_size];
     for(int i = 0; i < out_size; ++i)
     {
-        weights[i] = new T*[kernel_size];
-        for(int k = 0; k < kernel_size; ++k)
+        weights[i] = new T*[direct_kernel_size];
+        for(int k = 0; k < direct_kernel_size; ++k)
         {
             weights[i][k] = new T[filters_per_group];
             std::fill(weights[i][k], weights[i][k] + filters_per_group, (T)0);
@@ -28,15 +32,12 @@ Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int
 
     bias = new T[out_size];
 
-    state = new T*[state_size];
-    for(int k = 0; k < state_size; ++k)
-        state[k] = new T[in_size];
-
-    state_cols = new T*[kernel_size];
-    for(int k = 0; k < kernel_size; ++k)
-        state_cols[k] = new T[filters_per_group];
+    if(vectorize_groups)
+        group_weights.resize((size_t)(direct_kernel_size * filters_per_group * out_size), (T)0);
 
-    state_ptrs = new int[kernel_size];
+    state = new T*[2 * state_size];
+    for(int k = 0; k < 2 * state_size; ++k)
+        state[k] = new T[in_size];
 }
 
 template <typename T>
@@ -48,7 +49,7 @@ Conv1D<T>::Conv1D(std::initializer_list<int> sizes)
 
 template <typename T>
 Conv1D<T>::Conv1D(const Conv1D<T>& other)
-    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate)
+    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate, other.groups, other.fft_tail.isActive())
 {
 }
 
@@ -66,7 +67,7 @@ Conv1D<T>::~Conv1D()
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
     {
-        for(int k = 0; k < kernel_size; ++k)
+        for(int k = 0; k < direct_kernel_size; ++k)
             delete[] weights[i][k];
 
         delete[] weights[i];
@@ -75,30 +76,19 @@ Conv1D<T>::~Conv1D()
     delete[] weights;
     delete[] bias;
 
-    for(int k = 0; k < state_size; ++k)
+    for(int k = 0; k < 2 * state_size; ++k)
         delete[] state[k];
     delete[] state;
-
-    for(int k = 0; k < kernel_size; ++k)
-        delete[] state_cols[k];
-    delete[] state_cols;
-
-    delete[] state_ptrs;
 }
 
 template <typename T>
 void Conv1D<T>::reset()
 {
-    for(int k = 0; k < state_size; ++k)
+    for(int k = 0; k < 2 * state_size; ++k)
         std::fill(state[k], state[k] + Layer<T>::in_size, (T)0);
 
-    for(int k = 0; k < kernel_size; ++k)
-        std::fill(state_cols[k], state_cols[k] + filters_per_group, (T)0);
-
-    for(int k = 0; k < kernel_size; ++k)
-        state_ptrs[k] = 0;
-
     state_ptr = 0;
+    fft_tail.reset();
 }
 
 template <typename T>
@@ -106,8 +96,18 @@ void Conv1D<T>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
         for(int k = 0; k < filters_per_group; ++k)
-            for(int j = 0; j < kernel_size; ++j)
+            for(int j = 0; j < direct_kernel_size; ++j)
                 weights[i][j][k] = ws[i][k][j];
+
+    if(vectorize_groups)
+    {
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+            for(int k = 0; k < filters_per_group; ++k)
+                for(int j = 0; j < direct_kernel_size; ++j)
+                    group_weights[(size_t)(((j * groups + i / channels_per_group) * filters_per_group + k) * channels_per_group + i % channels_per_group)] = ws[i][k][j];
+    }
+
+    fft_tail.setWeights(ws);
 }
 
 template <typename T>
@@ -118,11 +118,11 @@ void Conv1D<T>::setBias(const std::vector<T>& biasVals)
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::Conv1DT()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::Conv1DT()
 {
     for(int i = 0; i < out_size; ++i)
-        for(int j = 0; j < kernel_size; ++j)
+        for(int j = 0; j < direct_kernel_size; ++j)
             for(int k = 0; k < filters_per_group; ++k)
                 weights[i][j][k] = (T)0.0;
 
@@ -136,33 +136,38 @@ Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_stat
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::reset()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::reset()
 {
-    for(int i = 0; i < state_size; ++i)
+    for(int i = 0; i < 2 * state_size; ++i)
         for(int k = 0; k < in_size; ++k)
             state[i][k] = (T)0.0;
 
-    for(int i = 0; i < kernel_size; ++i)
-        for(int k = 0; k < filters_per_group; ++k)
-            state_cols[i][k] = (T)0.0;
-
     state_ptr = 0;
-    for(int i = 0; i < kernel_size; ++i)
-        state_ptrs[i] = 0;
+    fft_tail.reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
 {
     for(int i = 0; i < out_size; ++i)
         for(int k = 0; k < filters_per_group; ++k)
-            for(int j = 0; j < kernel_size; ++j)
+            for(int j = 0; j < direct_kernel_size; ++j)
                 weights[i][j][k] = ws[i][k][j];
+
+    RTNEURAL_IF_CONSTEXPR(vectorize_groups)
+    {
+        for(int i = 0; i < out_size; ++i)
+            for(int k = 0; k < filters_per_group; ++k)
+                for(int j = 0; j < direct_kernel_size; ++j)
+                    group_weights[((j * groups + i / channels_per_group) * filters_per_group + k) * channels_per_group + i % channels_per_group] = ws[i][k][j];
+    }
+
+    fft_tail.setWeights(ws);
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setBias(const std::vector<T>& biasVals)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setBias(const std::vector<T>& biasVals)
 {
     for(int i = 0; i < out_size; ++i)
         bias[i] = biasVals[i];
@@ -2,21 +2,28 @@
 #define CONV1DEIGEN_H_INCLUDED
 
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../config.h"
+#include "conv1d_fft.h"
 #include <Eigen/Dense>
+#include <memory>
 
 namespace RTNEURAL_NAMESPACE
 {
 
 /**
  * Dynamic implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
  * to the layer. To ensure that the state is initialized to zero,
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
+ *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
  */
 template <typename T>
 class Conv1D : public Layer<T>
@@ -29,8 +36,10 @@ public:
      * @param out_size: the output size for the layer
      * @param kernel_size: the size of the convolution kernel
      * @param dilation: the dilation rate to use for dilated convolution
+     * @param groups: controls connections between inputs and outputs
+     * @param use_fft: compute the tail of a long kernel with FFT convolution
      */
-    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1);
+    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1, bool use_fft = false);
     Conv1D(std::initializer_list<int> sizes);
     Conv1D(const Conv1D& other);
     Conv1D& operator=(const Conv1D& other);
@@ -45,51 +54,143 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const T* input)
     {
-        // insert input into a circular buffer
-        state.col(state_ptr) = Eigen::Map<const Eigen::Vector<T, Eigen::Dynamic>,
-            RTNeuralEigenAlignment>(input, Layer<T>::in_size);
-
-        // set state pointers to the particular columns of the buffer
-        setStatePointers();
-
+        pushState(input);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        if(fft_tail.isActive())
+            fft_tail.skip(input);
     }
 
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        // insert input into a circular buffer
-        state.col(state_ptr) = Eigen::Map<const Eigen::Vector<T, Eigen::Dynamic>,
-            RTNeuralEigenAlignment>(input, Layer<T>::in_size);
+        auto outVec = Eigen::Map<Eigen::Vector<T, Eigen::Dynamic>>(h, Layer<T>::out_size);
+        if(depthwise && kernel_size == 1)
+        {
+            // a depthwise convolution with a single tap is an element-wise scaling
+            const auto inVec = Eigen::Map<const Eigen::Vector<T, Eigen::Dynamic>, RTNeuralEigenAlignment>(input, Layer<T>::in_size);
+            outVec = tapWeights[0].col(0).cwiseProduct(inVec) + bias;
+            if(activation != nullptr)
+                activation->forward(h, h);
+            return;
+        }
 
-        // set state pointers to the particular columns of the buffer
-        setStatePointers();
+        pushState(input);
 
-        if(groups == 1)
-        {
-            // copy selected columns to a helper variable
-            for(int k = 0; k < kernel_size; ++k)
-                state_cols.col(k) = state.col(state_ptrs(k));
+        // the kernel taps, from oldest to newest, are every dilation_rate'th
+        // column of the buffer, starting after the current state pointer
+        const auto taps = Eigen::seqN(state_ptr + 1, direct_kernel_size, dilation_rate);
+        const auto newest = state_ptr + state_size;
 
+        if(depthwise)
+        {
+            // scale each channel by its own weight, one kernel tap at a time
+            outVec = bias;
+            for(int k = 0; k < direct_kernel_size; ++k)
+                outVec += tapWeights[k].col(0).cwiseProduct(state.col(newest - k * dilation_rate));
+        }
+        else if(vectorize_groups)
+        {
+            // with the outputs as a [channels_per_group x groups] matrix, and the inputs
+            // as a [filters_per_group x groups] matrix, each input row is broadcast
+            // down the output channels of its group
+            auto outMat = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>(h, channels_per_group, groups);
+            outVec = bias;
+            for(int k = 0; k < direct_kernel_size; ++k)
+            {
+                const auto inMat = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>>(
+                    state.col(newest - k * dilation_rate).data(), filters_per_group, groups);
+                for(int f = 0; f < filters_per_group; ++f)
+                    outMat.array() += groupWeights[k * filters_per_group + f].array().rowwise() * inMat.row(f).array();
+            }
+        }
+        else if(groups == 1)
+        {
             // perform a multichannel convolution
             for(int i = 0; i < Layer<T>::out_size; ++i)
-                h[i] = state_cols.cwiseProduct(kernelWeights[i]).sum() + bias(i);
+                h[i] = state(Eigen::placeholders::all, taps).cwiseProduct(kernelWeights[i]).sum() + bias(i);
         }
         else
         {
             // perform a multichannel convolution
             for(int i = 0; i < Layer<T>::out_size; ++i)
             {
-                // copy selected columns to a helper variable
                 const auto ii = ((i / channels_per_group) * filters_per_group);
-                for(int k = 0; k < kernel_size; ++k)
-                    state_cols.col(k) = state.col(state_ptrs(k))(Eigen::seqN(ii, filters_per_group));
-
-                h[i] = state_cols.cwiseProduct(kernelWeights[i]).sum() + bias(i);
+                h[i] = state(Eigen::seqN(ii, filters_per_group), taps).cwiseProduct(kernelWeights[i]).sum() + bias(i);
             }
         }
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        if(fft_tail.isActive())
+            fft_tail.process(input, h);
+
+        if(activation != nullptr)
+            activation->forward(h, h);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * Each kernel tap is applied to the whole block as a single matrix
+     * product, with the delayed inputs read in-place from the state buffer
+     * and the input block.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        using MatType = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>;
+        const auto inMat = Eigen::Map<const MatType>(input, Layer<T>::in_size, num_samples);
+        auto outMat = Eigen::Map<MatType>(output, Layer<T>::out_size, num_samples);
+
+        outMat.colwise() = bias;
+        for(int k = 0; k < direct_kernel_size; ++k)
+        {
+            // the first `delay` outputs read their tap from the state buffer
+            const auto delay = k * dilation_rate;
+            const auto num_from_state = std::min(num_samples, delay);
+            const auto num_from_input = num_samples - num_from_state;
+
+            if(depthwise)
+            {
+                // scale each channel by its own weight
+                const auto w = tapWeights[k].col(0).asDiagonal();
+                outMat.leftCols(num_from_state) += w * state.middleCols(state_ptr + state_size - delay, num_from_state);
+                outMat.rightCols(num_from_input) += w * inMat.leftCols(num_from_input);
+                continue;
+            }
+
+            for(int g = 0; g < groups; ++g)
+            {
+                const auto w = tapWeights[k].middleRows(g * channels_per_group, channels_per_group);
+                const auto in_rows = g * filters_per_group;
+                const auto out_rows = g * channels_per_group;
+
+                outMat.block(out_rows, 0, channels_per_group, num_from_state).noalias()
+                    += w * state.block(in_rows, state_ptr + state_size - delay, filters_per_group, num_from_state);
+                outMat.block(out_rows, num_from_state, channels_per_group, num_from_input).noalias()
+                    += w * inMat.block(in_rows, 0, filters_per_group, num_from_input);
+            }
+        }
+
+        // only the most recent inputs are needed for the next block
+        for(int n = std::max(0, num_samples - state_size); n < num_samples; ++n)
+        {
+            state.col(state_ptr) = inMat.col(n);
+            state.col(state_ptr + state_size) = inMat.col(n);
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        if(fft_tail.isActive())
+            fft_tail.processBlock(input, output, num_samples);
+
+        if(activation != nullptr)
+        {
+            for(int n = 0; n < num_samples; ++n)
+                activation->forward(output + n * Layer<T>::out_size, output + n * Layer<T>::out_size);
+        }
     }
 
     /**
@@ -115,34 +216,67 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    bool usesFFT() const noexcept { return fft_tail.isActive(); }
+
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
 private:
     const int dilation_rate;
     const int kernel_size;
+    const int direct_kernel_size; // taps computed in direct form
     const int state_size;
     const int groups;
     const int filters_per_group;
     const int channels_per_group;
+    const bool depthwise; // groups == in_size == out_size
 
+    // grouped convolutions with enough output channels per group
+    // are vectorized across the output channels of each group
+    const bool vectorize_groups;
+
+    // kernel weights, with the taps stored from oldest to newest
     std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> kernelWeights;
     Eigen::Vector<T, Eigen::Dynamic> bias;
 
+    // kernel weights as tapWeights[direct_kernel_size][out_size][filters_per_group],
+    // with tap k applied to the input delayed by k * dilation_rate
+    std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> tapWeights;
+
+    // for vectorize_groups, the weights as groupWeights[direct_kernel_size * filters_per_group][channels_per_group][groups]
+    std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> groupWeights;
+
+    // computes the kernel taps after the first direct_kernel_size taps
+    FFTConvolution<T> fft_tail;
+
+    // mirrored circular buffer: columns n and n + state_size hold the same
+    // input, so the kernel taps never wrap around the end of the buffer
     Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> state;
-    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> state_cols;
-    Eigen::VectorXi state_ptrs;
     int state_ptr = 0;
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
+    std::unique_ptr<Activation<T>> activation;
+
+    /** Inserts an input into both halves of the state buffer. */
+    inline void pushState(const T* input) noexcept
     {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
+        const auto inVec = Eigen::Map<const Eigen::Vector<T, Eigen::Dynamic>, RTNeuralEigenAlignment>(input, Layer<T>::in_size);
+        state.col(state_ptr) = inVec;
+        state.col(state_ptr + state_size) = inVec;
     }
 };
 
 //====================================================
 /**
  * Static implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see fused_activation).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
@@ -150,19 +284,27 @@ private:
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
  *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
+ *
  * @param in_sizet: the input size for the layer
  * @param out_sizet: the output size for the layer
  * @param kernel_size: the size of the convolution kernel
  * @param dilation_rate: the dilation rate to use for dilated convolution
  * @param dynamic_state: use dynamically allocated layer state
+ * @param FusedActivation: an activation to apply to the layer outputs
+ * @param use_fft: compute the tail of a long kernel with FFT convolution
  */
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false>
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false,
+    typename FusedActivation = fused_activation::Identity, bool use_fft = false>
 class Conv1DT
 {
     using vec_type = Eigen::Vector<T, out_sizet>;
 
     static_assert((in_sizet % groups == 0) && (out_sizet % groups == 0), "in_sizet and out_sizet must be divisible by groups!");
 
+    static constexpr bool is_depthwise = groups > 1 && groups == in_sizet && groups == out_sizet;
+
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
@@ -171,10 +313,11 @@ public:
     static constexpr auto filters_per_group = in_size / groups;
     static constexpr auto channels_per_group = out_size / groups;
 
-    static constexpr auto state_size = (kernel_size - 1) * dilation_rate + 1;
-    using state_type = Eigen::Matrix<T, in_sizet, dynamic_state ? Eigen::Dynamic : state_size>;
-    using weights_type = Eigen::Matrix<T, filters_per_group, kernel_size>;
-    using state_ptrs_type = Eigen::Vector<int, kernel_size>;
+    static constexpr auto direct_kernel_size = use_fft ? fft_conv::directKernelSize(kernel_size, dilation_rate) : kernel_size;
+    static constexpr auto state_size = (direct_kernel_size - 1) * dilation_rate + 1;
+    using state_type = Eigen::Matrix<T, in_sizet, dynamic_state ? Eigen::Dynamic : 2 * state_size>;
+    using weights_type = Eigen::Matrix<T, filters_per_group, direct_kernel_size>;
+    using activation_type = FusedActivation;
 
     Conv1DT();
 
@@ -190,58 +333,158 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const Eigen::Matrix<T, in_size, 1>& ins)
     {
-        // insert input into a circular buffer
-        state.col(state_ptr) = ins;
-
-        // set state pointers to the particular columns of the buffer
-        setStatePointers();
-
+        pushState(ins);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.skip(ins.data());
+        }
     }
 
     /** Performs forward propagation for this layer. */
     template <int _groups = groups, std::enable_if_t<_groups == 1, bool> = true>
     RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
     {
-        // insert input into a circular buffer
-        state.col(state_ptr) = ins;
+        pushState(ins);
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
-        // copy selected columns to a helper variable
-        for(int k = 0; k < kernel_length; ++k)
-            state_cols.col(k) = state.col(state_ptrs(k));
-
-        // perform a multichannel convolution
+        // perform a multichannel convolution, reading the kernel taps in-place
+        const auto taps = tapColumns();
         for(int i = 0; i < out_size; ++i)
-            outs(i) = state_cols.cwiseProduct(weights[i]).sum() + bias(i);
+            outs(i) = state(Eigen::placeholders::all, taps).cwiseProduct(weights[i]).sum() + bias(i);
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(ins.data(), outs.data());
+        }
+
+        activation.apply(outs);
     }
 
     /** Performs forward propagation for this layer (groups > 1). */
-    template <int _groups = groups, std::enable_if_t<_groups != 1, bool> = true>
+    template <int _groups = groups, std::enable_if_t<_groups != 1 && !(_groups == in_size && _groups == out_size), bool> = true>
     RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
     {
-        // insert input into a circular buffer
-        state.col(state_ptr) = ins;
+        pushState(ins);
+
+        RTNEURAL_IF_CONSTEXPR(!useGroupedBroadcast(groups, channels_per_group))
+        {
+            // small groups: compute each output as a reduction over the inputs of its group
+            const auto taps = tapColumns();
+            for(int i = 0; i < out_size; ++i)
+            {
+                const auto ii = ((i / channels_per_group) * filters_per_group);
+                outs(i) = state(Eigen::seqN(ii, Eigen::fix<filters_per_group>), taps).cwiseProduct(weights[i]).sum() + bias(i);
+            }
+        }
+        else
+        {
+            // perform a grouped convolution, one kernel tap and group at a time,
+            // with each input broadcast across the output channels of its group
+            const auto newest = state_ptr + state_size;
+            outs = bias;
+            for(int k = 0; k < direct_kernel_size; ++k)
+            {
+                const auto x = state.col(newest - k * dilation_rate);
+                for(int g = 0; g < groups; ++g)
+                {
+                    outs.template segment<channels_per_group>(g * channels_per_group).noalias()
+                        += tap_weights[k].template middleRows<channels_per_group>(g * channels_per_group)
+                        * x.template segment<filters_per_group>(g * filters_per_group);
+                }
+            }
+        }
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
 
-        // perform a multichannel convolution
-        for(int i = 0; i < out_size; ++i)
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
         {
-            // copy selected columns to a helper variable
-            const auto ii = ((i / channels_per_group) * filters_per_group);
-            for(int k = 0; k < kernel_length; ++k)
-                state_cols.col(k) = state.col(state_ptrs(k))(Eigen::seqN(ii, filters_per_group));
+            fft_tail.process(ins.data(), outs.data());
+        }
 
-            outs(i) = state_cols.cwiseProduct(weights[i]).sum() + bias(i);
+        activation.apply(outs);
+    }
+
+    /** Performs forward propagation for this layer (depthwise, groups == in_size == out_size). */
+    template <int _groups = groups, std::enable_if_t<_groups != 1 && _groups == in_size && _groups == out_size, bool> = true>
+    RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
+    {
+        RTNEURAL_IF_CONSTEXPR(kernel_size == 1)
+        {
+            // a depthwise convolution with a single tap is an element-wise scaling
+            outs = tap_weights[0].cwiseProduct(ins) + bias;
+            activation.apply(outs);
+            return;
         }
 
+        pushState(ins);
+
+        // scale each channel by its own weight, one kernel tap at a time
+        const auto newest = state_ptr + state_size;
+        outs = bias;
+        for(int k = 0; k < direct_kernel_size; ++k)
+            outs += tap_weights[k].cwiseProduct(state.col(newest - k * dilation_rate));
+
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(ins.data(), outs.data());
+        }
+
+        activation.apply(outs);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * Each kernel tap is applied to the whole block as a single matrix
+     * product, with the delayed inputs read in-place from the state buffer
+     * and the input block.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        const auto inMat = Eigen::Map<const Eigen::Matrix<T, in_size, Eigen::Dynamic>>(input, in_size, num_samples);
+        auto outMat = Eigen::Map<Eigen::Matrix<T, out_size, Eigen::Dynamic>>(output, out_size, num_samples);
+
+        outMat.colwise() = bias;
+        for(int k = 0; k < direct_kernel_size; ++k)
+        {
+            // the first `delay` outputs read their tap from the state buffer
+            const auto delay = k * dilation_rate;
+            const auto num_from_state = std::min(num_samples, delay);
+            const auto num_from_input = num_samples - num_from_state;
+
+            accumulateTap(k, state.middleCols(state_ptr + state_size - delay, num_from_state), outMat.leftCols(num_from_state));
+            accumulateTap(k, inMat.leftCols(num_from_input), outMat.rightCols(num_from_input));
+        }
+
+        // only the most recent inputs are needed for the next block
+        for(int n = std::max(0, num_samples - state_size); n < num_samples; ++n)
+        {
+            state.col(state_ptr) = inMat.col(n);
+            state.col(state_ptr + state_size) = inMat.col(n);
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.processBlock(input, output, num_samples);
+        }
+
+        for(int n = 0; n < num_samples; ++n)
+        {
+            auto frame = outMat.col(n);
+            activation.apply(frame);
+        }
+
+        if(num_samples > 0)
+            outs = outMat.col(num_samples - 1);
     }
 
     /**
@@ -267,31 +510,71 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    static constexpr bool usesFFT() noexcept { return has_fft_tail; }
+
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     Eigen::Map<vec_type, RTNeuralEigenAlignment> outs;
 
 private:
     void resize_state()
     {
-        state.resize(in_sizet, state_size);
+        state.resize(in_sizet, 2 * state_size);
+    }
+
+    /** Inserts an input into both halves of the mirrored state buffer. */
+    inline void pushState(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
+    {
+        state.col(state_ptr) = ins;
+        state.col(state_ptr + state_size) = ins;
+    }
+
+    /** Accumulates kernel tap k over a block of inputs (out += W_k * in), one group at a time. */
+    template <typename InBlock, typename OutBlock, bool DW = is_depthwise>
+    inline std::enable_if_t<!DW> accumulateTap(int k, const InBlock& in, OutBlock&& out) const noexcept
+    {
+        for(int g = 0; g < groups; ++g)
+        {
+            out.template middleRows<channels_per_group>(g * channels_per_group).noalias()
+                += tap_weights[k].template middleRows<channels_per_group>(g * channels_per_group)
+                * in.template middleRows<filters_per_group>(g * filters_per_group);
+        }
+    }
+
+    /** Accumulates kernel tap k over a block of inputs, scaling each channel by its own weight. */
+    template <typename InBlock, typename OutBlock, bool DW = is_depthwise>
+    inline std::enable_if_t<DW> accumulateTap(int k, const InBlock& in, OutBlock&& out) const noexcept
+    {
+        out += tap_weights[k].col(0).asDiagonal() * in;
+    }
+
+    /** Returns the state columns for the kernel taps, from oldest to newest. */
+    inline auto tapColumns() const noexcept
+    {
+        return Eigen::seqN(state_ptr + 1, Eigen::fix<direct_kernel_size>, Eigen::fix<dilation_rate>);
     }
 
     T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
 
+    // mirrored circular buffer, with state.col(n) == state.col(n + state_size)
     state_type state;
-    weights_type state_cols;
-
     int state_ptr = 0;
-    state_ptrs_type state_ptrs;
 
+    // kernel weights, with the taps stored from oldest to newest
     weights_type weights[out_size];
     vec_type bias;
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
-    {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
-    }
+    // kernel weights for block processing, with tap k applied
+    // to the input delayed by k * dilation_rate
+    Eigen::Matrix<T, out_size, filters_per_group> tap_weights[direct_kernel_size];
+
+    // computes the kernel taps after the first direct_kernel_size taps
+    static constexpr bool has_fft_tail = direct_kernel_size < kernel_size;
+    FFTConvolution<T> fft_tail { in_size, out_size, kernel_size, dilation_rate, groups, use_fft };
+
+    FusedActivation activation;
 };
 
 } // RTNEURAL_NAMESPACE
@@ -4,23 +4,36 @@ namespace RTNEURAL_NAMESPACE
 {
 
 template <typename T>
-Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups)
+Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups, bool use_fft)
     : Layer<T>(in_size, out_size)
     , dilation_rate(dilation)
     , kernel_size(kernel_size)
-    , state_size((kernel_size - 1) * dilation + 1)
+    , direct_kernel_size(use_fft ? fft_conv::directKernelSize(kernel_size, dilation) : kernel_size)
+    , state_size((direct_kernel_size - 1) * dilation + 1)
     , groups(num_groups)
     , filters_per_group(in_size / groups)
     , channels_per_group(out_size / groups)
+    , depthwise(groups > 1 && groups == in_size && groups == out_size)
+    , vectorize_groups(!depthwise && useGroupedBroadcast(groups, channels_per_group))
+    , fft_tail(in_size, out_size, kernel_size, dilation, num_groups, use_fft)
 {
     kernelWeights.resize(out_size);
     for(int i = 0; i < out_size; ++i)
-        kernelWeights[i] = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(filters_per_group, kernel_size);
+        kernelWeights[i] = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(filters_per_group, direct_kernel_size);
+
+    tapWeights.resize(direct_kernel_size);
+    for(int k = 0; k < direct_kernel_size; ++k)
+        tapWeights[k] = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(out_size, filters_per_group);
+
+    if(vectorize_groups)
+    {
+        groupWeights.resize(direct_kernel_size * filters_per_group);
+        for(auto& w : groupWeights)
+            w = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(channels_per_group, groups);
+    }
 
     bias = Eigen::Vector<T, Eigen::Dynamic>::Zero(out_size);
-    state = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, state_size);
-    state_cols = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(filters_per_group, kernel_size);
-    state_ptrs = Eigen::Vector<int, Eigen::Dynamic>::Zero(kernel_size);
+    state = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(in_size, 2 * state_size);
 }
 
 template <typename T>
@@ -32,7 +45,7 @@ Conv1D<T>::Conv1D(std::initializer_list<int> sizes)
 
 template <typename T>
 Conv1D<T>::Conv1D(const Conv1D<T>& other)
-    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate)
+    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate, other.groups, other.fft_tail.isActive())
 {
 }
 
@@ -49,9 +62,8 @@ template <typename T>
 void Conv1D<T>::reset()
 {
     state_ptr = 0;
-    state_ptrs.setZero();
-    state_cols.setZero();
     state.setZero();
+    fft_tail.reset();
 }
 
 template <typename T>
@@ -59,8 +71,21 @@ void Conv1D<T>::setWeights(const std::vector<std::vector<std::vector<T>>>& weigh
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
         for(int k = 0; k < filters_per_group; ++k)
-            for(int j = 0; j < kernel_size; ++j)
-                kernelWeights[i](k, j) = weights[i][k][j];
+            for(int j = 0; j < direct_kernel_size; ++j)
+            {
+                kernelWeights[i](k, direct_kernel_size - 1 - j) = weights[i][k][j];
+                tapWeights[j](i, k) = weights[i][k][j];
+            }
+
+    if(vectorize_groups)
+    {
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+            for(int k = 0; k < filters_per_group; ++k)
+                for(int j = 0; j < direct_kernel_size; ++j)
+                    groupWeights[j * filters_per_group + k](i % channels_per_group, i / channels_per_group) = weights[i][k][j];
+    }
+
+    fft_tail.setWeights(weights);
 }
 
 template <typename T>
@@ -71,39 +96,46 @@ void Conv1D<T>::setBias(const std::vector<T>& biasVals)
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::Conv1DT()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::Conv1DT()
     : outs(outs_internal)
 {
     for(int k = 0; k < out_size; ++k)
         weights[k] = weights_type::Zero();
 
+    for(int k = 0; k < direct_kernel_size; ++k)
+        tap_weights[k].setZero();
+
     bias = vec_type::Zero();
 
     resize_state();
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::reset()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::reset()
 {
     state.setZero();
-    state_cols = weights_type::Zero();
-    state_ptrs = state_ptrs_type::Zero();
     state_ptr = 0;
+    fft_tail.reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
 {
     for(int i = 0; i < out_size; ++i)
         for(int k = 0; k < filters_per_group; ++k)
-            for(int j = 0; j < kernel_size; ++j)
-                weights[i](k, j) = ws[i][k][j];
+            for(int j = 0; j < direct_kernel_size; ++j)
+            {
+                weights[i](k, direct_kernel_size - 1 - j) = ws[i][k][j];
+                tap_weights[j](i, k) = ws[i][k][j];
+            }
+
+    fft_tail.setWeights(ws);
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setBias(const std::vector<T>& biasVals)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setBias(const std::vector<T>& biasVals)
 {
     for(int i = 0; i < out_size; ++i)
         bias(i) = biasVals[i];
@@ -0,0 +1,512 @@
+#ifndef CONV1DFFT_H_INCLUDED
+#define CONV1DFFT_H_INCLUDED
+
+#include "../common.h"
+#include "../config.h"
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Utilities for computing long Conv1D kernels with uniformly-partitioned
+ * FFT convolution.
+ *
+ * The kernel is split into a "head", made up of the taps delayed by less
+ * than two partitions, and a "tail" made up of the remaining taps. The head
+ * is computed in direct form by the convolution layer, so the layer has no
+ * added latency, while the tail is computed in the frequency domain. Since
+ * the tail outputs for each partition of samples only depend on the inputs
+ * from two or more partitions before, the frequency-domain work for each
+ * partition is spread over the samples of the next partition.
+ *
+ * FFT convolution is opt-in (see the `use_fft` arguments of Conv1D and Conv1DT).
+ */
+namespace fft_conv
+{
+    /** Kernels with a shorter effective length (in samples) always use the direct form. */
+    constexpr int min_length = 256;
+
+    /** Returns the effective length of a dilated convolution kernel, in samples. */
+    constexpr int effectiveLength(int kernel_size, int dilation)
+    {
+        return (kernel_size - 1) * dilation + 1;
+    }
+
+    /** Returns the number of partitions in the tail of a kernel (the taps delayed by two or more partitions). */
+    constexpr int tailPartitions(int length, int partition_size)
+    {
+        return (length - 1) / partition_size - 1;
+    }
+
+    /**
+     * Returns the partition size to use for FFT convolution,
+     * or zero if the kernel should be computed in direct form.
+     *
+     * For each pair of input and output channels, the direct form costs
+     * kernel_size multiply-adds per sample, while the FFT convolution costs
+     * 2 * partition_size / dilation multiply-adds for the head, plus one complex
+     * multiply-add (4 real ones) per sample for each partition of the tail.
+     * The frequency-domain multiply-adds vectorize well, so the partition
+     * size is chosen close to sqrt(length), and the FFT convolution is only
+     * used when it's at least twice as cheap as the direct form, to cover
+     * the cost of the FFTs.
+     */
+    constexpr int partitionSize(int kernel_size, int dilation)
+    {
+        const auto length = effectiveLength(kernel_size, dilation);
+        if(length < min_length)
+            return 0;
+
+        int partition_size = 32;
+        while(partition_size < 1024 && partition_size * partition_size < length)
+            partition_size *= 2;
+
+        const auto head_cost = (2 * partition_size + dilation - 1) / dilation;
+        const auto num_partitions = tailPartitions(length, partition_size);
+        const auto tail_cost = 4 * num_partitions;
+        return num_partitions > 0 && 2 * (head_cost + tail_cost) <= kernel_size ? partition_size : 0;
+    }
+
+    /** Returns the number of kernel taps that should be computed in direct form, when FFT convolution is used. */
+    constexpr int directKernelSize(int kernel_size, int dilation)
+    {
+        return partitionSize(kernel_size, dilation) == 0
+            ? kernel_size
+            : std::min(kernel_size, (2 * partitionSize(kernel_size, dilation) + dilation - 1) / dilation);
+    }
+
+    /** Accumulates the product of two spectra (sum += a * b), stored as separate real and imaginary parts. */
+    template <typename T>
+    inline void complexMultiplyAccumulate(const T* a_re, const T* a_im, const T* b_re, const T* b_im, T* sum_re, T* sum_im, int size) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        const auto vec_size = size - size % inc;
+        for(int i = 0; i < vec_size; i += inc)
+        {
+            const auto ar = xsimd::load_unaligned(a_re + i);
+            const auto ai = xsimd::load_unaligned(a_im + i);
+            const auto br = xsimd::load_unaligned(b_re + i);
+            const auto bi = xsimd::load_unaligned(b_im + i);
+            xsimd::store_unaligned(sum_re + i, xsimd::fnma(ai, bi, xsimd::fma(ar, br, xsimd::load_unaligned(sum_re + i))));
+            xsimd::store_unaligned(sum_im + i, xsimd::fma(ai, br, xsimd::fma(ar, bi, xsimd::load_unaligned(sum_im + i))));
+        }
+
+        for(int i = vec_size; i < size; ++i)
+        {
+            sum_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+            sum_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+        }
+#elif RTNEURAL_USE_EIGEN
+        using Array = Eigen::Array<T, Eigen::Dynamic, 1>;
+        const Eigen::Map<const Array> ar(a_re, size), ai(a_im, size), br(b_re, size), bi(b_im, size);
+        Eigen::Map<Array>(sum_re, size) += ar * br - ai * bi;
+        Eigen::Map<Array>(sum_im, size) += ar * bi + ai * br;
+#else
+        for(int i = 0; i < size; ++i)
+        {
+            sum_re[i] += a_re[i] * b_re[i] - a_im[i] * b_im[i];
+            sum_im[i] += a_re[i] * b_im[i] + a_im[i] * b_re[i];
+        }
+#endif
+    }
+
+    /**
+     * Real-valued FFT, for power-of-two sizes, computed as a complex FFT
+     * of half the size. The spectra are stored as separate arrays of
+     * real and imaginary parts, with size / 2 + 1 bins.
+     */
+    template <typename T>
+    class RealFFT
+    {
+    public:
+        explicit RealFFT(int fft_size)
+            : size(fft_size)
+            , half_size(fft_size / 2)
+        {
+            if(size < 4)
+                return;
+
+            int num_bits = 0;
+            while((1 << num_bits) < half_size)
+                num_bits++;
+
+            bit_reverse.resize((size_t)half_size);
+            for(int i = 0; i < half_size; ++i)
+            {
+                int rev = 0;
+                for(int b = 0; b < num_bits; ++b)
+                    rev |= ((i >> b) & 1) << (num_bits - 1 - b);
+                bit_reverse[(size_t)i] = rev;
+            }
+
+            const auto two_pi = 2.0 * 3.14159265358979323846;
+            for(int k = 0; k < half_size / 2; ++k)
+            {
+                twiddle_re.push_back((T)std::cos(two_pi * k / half_size));
+                twiddle_im.push_back((T)-std::sin(two_pi * k / half_size));
+            }
+
+            for(int k = 0; k <= half_size; ++k)
+            {
+                post_re.push_back((T)std::cos(two_pi * k / size));
+                post_im.push_back((T)-std::sin(two_pi * k / size));
+            }
+
+            work_re.resize((size_t)half_size, (T)0);
+            work_im.resize((size_t)half_size, (T)0);
+        }
+
+        /** Computes the spectrum of input[size]. */
+        RTNEURAL_REALTIME void forward(const T* input, T* re, T* im) noexcept
+        {
+            // pack the even and odd samples into the real and imaginary parts
+            for(int n = 0; n < half_size; ++n)
+            {
+                work_re[n] = input[2 * n];
+                work_im[n] = input[2 * n + 1];
+            }
+
+            complexFFT(false);
+
+            // split the spectra of the even and odd samples, and combine them
+            for(int k = 0; k <= half_size; ++k)
+            {
+                const auto k1 = k == half_size ? 0 : k;
+                const auto k2 = k == 0 ? 0 : half_size - k;
+                const auto even_re = (T)0.5 * (work_re[k1] + work_re[k2]);
+                const auto even_im = (T)0.5 * (work_im[k1] - work_im[k2]);
+                const auto odd_re = (T)0.5 * (work_im[k1] + work_im[k2]);
+                const auto odd_im = (T)-0.5 * (work_re[k1] - work_re[k2]);
+
+                re[k] = even_re + post_re[k] * odd_re - post_im[k] * odd_im;
+                im[k] = even_im + post_re[k] * odd_im + post_im[k] * odd_re;
+            }
+        }
+
+        /** Computes output[size] from its spectrum, so that inverse(forward(x)) == x. */
+        RTNEURAL_REALTIME void inverse(const T* re, const T* im, T* output) noexcept
+        {
+            for(int k = 0; k < half_size; ++k)
+            {
+                const auto k2 = half_size - k;
+                const auto even_re = (T)0.5 * (re[k] + re[k2]);
+                const auto even_im = (T)0.5 * (im[k] - im[k2]);
+                const auto diff_re = (T)0.5 * (re[k] - re[k2]);
+                const auto diff_im = (T)0.5 * (im[k] + im[k2]);
+                const auto odd_re = diff_re * post_re[k] + diff_im * post_im[k];
+                const auto odd_im = diff_im * post_re[k] - diff_re * post_im[k];
+
+                work_re[k] = even_re - odd_im;
+                work_im[k] = even_im + odd_re;
+            }
+
+            complexFFT(true);
+
+            const auto scale = (T)1 / (T)half_size;
+            for(int n = 0; n < half_size; ++n)
+            {
+                output[2 * n] = work_re[n] * scale;
+                output[2 * n + 1] = work_im[n] * scale;
+            }
+        }
+
+    private:
+        /** In-place radix-2 complex FFT of the work buffers (unscaled). */
+        void complexFFT(bool inverse) noexcept
+        {
+            for(int i = 0; i < half_size; ++i)
+            {
+                const auto j = bit_reverse[i];
+                if(i < j)
+                {
+                    std::swap(work_re[i], work_re[j]);
+                    std::swap(work_im[i], work_im[j]);
+                }
+            }
+
+            const auto sign = inverse ? (T)-1 : (T)1;
+            for(int len = 2; len <= half_size; len *= 2)
+            {
+                const auto half_len = len / 2;
+                const auto step = half_size / len;
+                for(int start = 0; start < half_size; start += len)
+                {
+                    for(int k = 0; k < half_len; ++k)
+                    {
+                        const auto w_re = twiddle_re[k * step];
+                        const auto w_im = sign * twiddle_im[k * step];
+                        const auto a = start + k;
+                        const auto b = a + half_len;
+
+                        const auto t_re = w_re * work_re[b] - w_im * work_im[b];
+                        const auto t_im = w_re * work_im[b] + w_im * work_re[b];
+                        work_re[b] = work_re[a] - t_re;
+                        work_im[b] = work_im[a] - t_im;
+                        work_re[a] += t_re;
+                        work_im[a] += t_im;
+                    }
+                }
+            }
+        }
+
+        int size;
+        int half_size;
+
+        std::vector<int> bit_reverse;
+        std::vector<T> twiddle_re, twiddle_im; // exp(-2 pi i k / half_size)
+        std::vector<T> post_re, post_im; // exp(-2 pi i k / size)
+        std::vector<T> work_re, work_im;
+    };
+} // namespace fft_conv
+
+/**
+ * Computes the tail of a long 1-dimensional convolution kernel,
+ * with uniformly-partitioned overlap-save FFT convolution.
+ *
+ * The tail is made up of the kernel taps delayed by at least two partitions,
+ * so the tail outputs for each partition of samples only depend on the inputs
+ * from two or more partitions before. They are computed by multiplying the
+ * spectra of the past inputs (stored in a frequency-domain delay line) with
+ * the spectra of each partition of the kernel. The FFTs and multiply-adds for
+ * each partition of inputs are split into jobs (one for each input channel,
+ * then one for each output channel), which are spread evenly over the samples
+ * of the following partition, so the CPU load is even from sample to sample.
+ *
+ * If FFT convolution is not used (see fft_conv::partitionSize()),
+ * this class does nothing, and allocates no memory.
+ */
+template <typename T>
+class FFTConvolution
+{
+public:
+    /** Constructs the FFT convolution for the given Conv1D dimensions. */
+    FFTConvolution(int in_size, int out_size, int kernel_size, int dilation, int groups, bool use_fft)
+        : in_size(in_size)
+        , out_size(out_size)
+        , kernel_size(kernel_size)
+        , dilation(dilation)
+        , filters_per_group(in_size / groups)
+        , channels_per_group(out_size / groups)
+        , partition_size(use_fft ? fft_conv::partitionSize(kernel_size, dilation) : 0)
+        , first_tap(use_fft ? fft_conv::directKernelSize(kernel_size, dilation) : kernel_size)
+        , fft_size(2 * partition_size)
+        , num_bins(partition_size + 1)
+        , num_partitions(partition_size > 0 ? fft_conv::tailPartitions(fft_conv::effectiveLength(kernel_size, dilation), partition_size) : 0)
+        , num_jobs(in_size + out_size)
+        , fft(fft_size)
+    {
+        if(partition_size == 0)
+            return;
+
+        const auto spectrum_size = [this](int count)
+        { return (size_t)count * (size_t)num_bins; };
+
+        inputs.resize((size_t)in_size * fft_size, (T)0);
+        frozen_inputs.resize((size_t)in_size * fft_size, (T)0);
+        inputs_re.resize(spectrum_size(num_partitions * in_size), (T)0);
+        inputs_im.resize(spectrum_size(num_partitions * in_size), (T)0);
+        kernel_re.resize(spectrum_size(num_partitions * out_size * filters_per_group), (T)0);
+        kernel_im.resize(spectrum_size(num_partitions * out_size * filters_per_group), (T)0);
+        sums_re.resize((size_t)num_bins, (T)0);
+        sums_im.resize((size_t)num_bins, (T)0);
+        frame.resize((size_t)fft_size, (T)0);
+        tail.resize((size_t)partition_size * out_size, (T)0);
+        next_tail.resize((size_t)partition_size * out_size, (T)0);
+        reset();
+    }
+
+    /** Returns true if the convolution kernel has a tail to compute. */
+    bool isActive() const noexcept { return partition_size > 0; }
+
+    /** Returns the number of kernel taps to be computed in direct form. */
+    int getDirectKernelSize() const noexcept { return first_tap; }
+
+    /** Resets the state of the FFT convolution. */
+    RTNEURAL_REALTIME void reset() noexcept
+    {
+        std::fill(inputs.begin(), inputs.end(), (T)0);
+        std::fill(frozen_inputs.begin(), frozen_inputs.end(), (T)0);
+        std::fill(inputs_re.begin(), inputs_re.end(), (T)0);
+        std::fill(inputs_im.begin(), inputs_im.end(), (T)0);
+        std::fill(tail.begin(), tail.end(), (T)0);
+        std::fill(next_tail.begin(), next_tail.end(), (T)0);
+        input_ptr = 0;
+        spectrum_ptr = 0;
+        next_job = num_jobs; // no jobs pending
+    }
+
+    /**
+     * Sets the kernel weights, with size weights[out_size][filters_per_group][kernel_size].
+     * Only the tail taps are used.
+     */
+    RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& weights)
+    {
+        for(int p = 0; p < num_partitions; ++p)
+        {
+            // partition p holds the taps delayed by [(p + 2) * partition_size, (p + 3) * partition_size)
+            const auto start_delay = (p + 2) * partition_size;
+            const auto end_delay = start_delay + partition_size;
+            for(int i = 0; i < out_size; ++i)
+            {
+                for(int c = 0; c < filters_per_group; ++c)
+                {
+                    std::fill(frame.begin(), frame.end(), (T)0);
+                    for(int j = std::max(first_tap, (start_delay + dilation - 1) / dilation); j < kernel_size && j * dilation < end_delay; ++j)
+                        frame[j * dilation - start_delay] = weights[i][c][j];
+
+                    const auto idx = ((size_t)(p * out_size + i) * filters_per_group + c) * num_bins;
+                    fft.forward(frame.data(), &kernel_re[idx], &kernel_im[idx]);
+                }
+            }
+        }
+    }
+
+    /** Pushes an input into the FFT convolution, and adds the kernel tail to the output. */
+    RTNEURAL_REALTIME inline void process(const T* input, T* output) noexcept
+    {
+        for(int i = 0; i < out_size; ++i)
+            output[i] += tail[input_ptr * out_size + i];
+
+        skip(input);
+    }
+
+    /** Pushes an input into the FFT convolution, without computing an output. */
+    RTNEURAL_REALTIME inline void skip(const T* input) noexcept
+    {
+        for(int c = 0; c < in_size; ++c)
+            inputs[c * fft_size + partition_size + input_ptr] = input[c];
+
+        // run this sample's share of the jobs for the previous partition
+        runJobs((int)(((long long)(input_ptr + 1) * num_jobs + partition_size - 1) / partition_size));
+
+        if(++input_ptr == partition_size)
+        {
+            input_ptr = 0;
+            startPartition();
+        }
+    }
+
+    /**
+     * Processes a block of samples, with input[num_samples][in_size],
+     * and adds the kernel tail to output[num_samples][out_size].
+     */
+    RTNEURAL_REALTIME inline void processBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+            process(input + n * in_size, output + n * out_size);
+    }
+
+private:
+    /**
+     * Called at the end of each partition of inputs: the tail outputs computed
+     * during the partition are used for the next one, and the jobs for the
+     * partition of inputs that just ended are queued.
+     */
+    void startPartition() noexcept
+    {
+        runJobs(num_jobs); // only needed if the jobs couldn't be spread over the partition
+
+        std::swap(tail, next_tail);
+        std::swap(inputs, frozen_inputs);
+        spectrum_ptr = (spectrum_ptr == num_partitions - 1 ? 0 : spectrum_ptr + 1);
+        next_job = 0;
+    }
+
+    /** Runs the pending jobs, up to (but not including) the given job. */
+    void runJobs(int end_job) noexcept
+    {
+        for(; next_job < end_job; ++next_job)
+        {
+            if(next_job < in_size)
+                transformInput(next_job);
+            else
+                computeOutput(next_job - in_size);
+        }
+    }
+
+    /**
+     * Adds the spectrum of an input channel's latest frame to the frequency-domain delay line,
+     * and keeps the latest partition of inputs as the first half of the channel's next frame.
+     */
+    void transformInput(int c) noexcept
+    {
+        const auto* x = &frozen_inputs[(size_t)c * fft_size];
+        const auto idx = ((size_t)spectrum_ptr * in_size + c) * num_bins;
+        fft.forward(x, &inputs_re[idx], &inputs_im[idx]);
+        std::copy(x + partition_size, x + fft_size, &inputs[(size_t)c * fft_size]);
+    }
+
+    /** Computes the kernel tail outputs of an output channel, for the partition after the current one. */
+    void computeOutput(int i) noexcept
+    {
+        std::fill(sums_re.begin(), sums_re.end(), (T)0);
+        std::fill(sums_im.begin(), sums_im.end(), (T)0);
+
+        const auto ii = (i / channels_per_group) * filters_per_group;
+        for(int p = 0; p < num_partitions; ++p)
+        {
+            // partition p of the kernel is applied to the inputs from p partitions ago
+            const auto slot = spectrum_ptr >= p ? spectrum_ptr - p : spectrum_ptr - p + num_partitions;
+            for(int c = 0; c < filters_per_group; ++c)
+            {
+                const auto k_idx = ((size_t)(p * out_size + i) * filters_per_group + c) * num_bins;
+                const auto x_idx = ((size_t)slot * in_size + ii + c) * num_bins;
+                fft_conv::complexMultiplyAccumulate(&kernel_re[k_idx], &kernel_im[k_idx], &inputs_re[x_idx], &inputs_im[x_idx],
+                    sums_re.data(), sums_im.data(), num_bins);
+            }
+        }
+
+        // the second half of the output frame is free from circular aliasing
+        fft.inverse(sums_re.data(), sums_im.data(), frame.data());
+        for(int n = 0; n < partition_size; ++n)
+            next_tail[n * out_size + i] = frame[partition_size + n];
+    }
+
+    int in_size;
+    int out_size;
+    int kernel_size;
+    int dilation;
+    int filters_per_group;
+    int channels_per_group;
+
+    int partition_size;
+    int first_tap;
+    int fft_size;
+    int num_bins;
+    int num_partitions;
+    int num_jobs;
+
+    fft_conv::RealFFT<T> fft;
+
+    // inputs[in_size][fft_size], with the previous partition of inputs
+    // in the first half, and the current partition in the second half
+    std::vector<T> inputs;
+    int input_ptr = 0;
+
+    // the input frames of the previous partition, waiting to be transformed
+    std::vector<T> frozen_inputs;
+    int next_job = 0;
+
+    // frequency-domain delay line of input spectra, inputs_re[num_partitions][in_size][num_bins]
+    std::vector<T> inputs_re, inputs_im;
+    int spectrum_ptr = 0;
+
+    // kernel spectra, kernel_re[num_partitions][out_size][filters_per_group][num_bins]
+    std::vector<T> kernel_re, kernel_im;
+
+    std::vector<T> sums_re, sums_im;
+    std::vector<T> frame;
+
+    // kernel tail outputs for the current partition, tail[partition_size][out_size],
+    // and for the next partition, which are computed during the current one
+    std::vector<T> tail;
+    std::vector<T> next_tail;
+};
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // CONV1DFFT_H_INCLUDED
@@ -2,9 +2,13 @@
 #define CONV1DXSIMD_H_INCLUDED
 
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../common.h"
 #include "../config.h"
+#include "conv1d_fft.h"
 #include <iostream>
+#include <memory>
 #include <numeric>
 #include <vector>
 
@@ -13,13 +17,16 @@ namespace RTNEURAL_NAMESPACE
 
 /**
  * Dynamic implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
  * to the layer. To ensure that the state is initialized to zero,
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
+ *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
  */
 template <typename T>
 class Conv1D : public Layer<T>
@@ -32,8 +39,10 @@ public:
      * @param out_size: the output size for the layer
      * @param kernel_size: the size of the convolution kernel
      * @param dilation: the dilation rate to use for dilated convolution
+     * @param groups: controls connections between inputs and outputs
+     * @param use_fft: compute the tail of a long kernel with FFT convolution
      */
-    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1);
+    Conv1D(int in_size, int out_size, int kernel_size, int dilation, int groups = 1, bool use_fft = false);
     Conv1D(std::initializer_list<int> sizes);
     Conv1D(const Conv1D& other);
     Conv1D& operator=(const Conv1D& other);
@@ -48,62 +57,165 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const T* input)
     {
-        // insert input into a circular buffer
-        vCopy(input, state[state_ptr].data(), Layer<T>::in_size);
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
+        pushState(input);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        if(fft_tail.isActive())
+            fft_tail.skip(input);
     }
 
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        // insert input into a circular buffer
-        vCopy(input, state[state_ptr].data(), Layer<T>::in_size);
+        if(depthwise && kernel_size == 1)
+        {
+            // a depthwise convolution with a single tap is an element-wise scaling
+            vCopy(channel_bias.data(), sums.data(), Layer<T>::out_size);
+            vProdAccum(channel_weights.data(), input, sums.data(), Layer<T>::out_size);
+            std::copy(sums.begin(), sums.begin() + Layer<T>::out_size, h);
+            if(activation != nullptr)
+                activation->forward(h, h);
+            return;
+        }
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        pushState(input);
 
-        if(groups == 1)
+        const auto newest = state_ptr + state_size;
+        if(depthwise)
+        {
+            // scale each channel by its own weight, one kernel tap at a time
+            vCopy(channel_bias.data(), sums.data(), Layer<T>::out_size);
+            for(int k = 0; k < direct_kernel_size; ++k)
+                vProdAccum(&channel_weights[k * out_size_padded], state[newest - k * dilation_rate].data(), sums.data(), Layer<T>::out_size);
+            std::copy(sums.begin(), sums.begin() + Layer<T>::out_size, h);
+        }
+        else if(groups > 1 && !useGroupedBroadcast(groups, channels_per_group))
         {
-            // copy selected columns to a helper variable
-            for(int k = 0; k < kernel_size; ++k)
+            // small groups: compute each output as a dot product over the inputs of its group
+            for(int i = 0; i < Layer<T>::out_size; ++i)
             {
-                const auto& col = state[state_ptrs[k]];
-                vCopy(col.data(), state_cols[k].data(), Layer<T>::in_size);
+                const auto g = i / channels_per_group;
+                const auto ch = i % channels_per_group;
+                auto sum = bias[g * channels_per_group_padded + ch];
+                for(int k = 0; k < direct_kernel_size; ++k)
+                {
+                    const auto* column = state[newest - k * dilation_rate].data() + g * filters_per_group;
+                    const auto* w = &weights[(g * direct_kernel_size + k) * filters_per_group * channels_per_group_padded + ch];
+                    for(int f = 0; f < filters_per_group; ++f)
+                        sum += w[f * channels_per_group_padded] * column[f];
+                }
+                h[i] = sum;
             }
+        }
+        else
+        {
+            // perform multi-channel convolution, one group at a time
+            for(int g = 0; g < groups; ++g)
+            {
+                vCopy(&bias[g * channels_per_group_padded], sums.data(), channels_per_group_padded);
+                for(int k = 0; k < direct_kernel_size; ++k)
+                {
+                    const auto* column = state[newest - k * dilation_rate].data() + g * filters_per_group;
+                    vMatVecAccum(&weights[(g * direct_kernel_size + k) * filters_per_group * channels_per_group_padded],
+                        column,
+                        sums.data(),
+                        filters_per_group,
+                        channels_per_group_padded);
+                }
 
-            // perform multi-channel convolution
-            vCopy(bias.data(), h, Layer<T>::out_size);
-            for(int i = 0; i < Layer<T>::out_size; ++i)
+                std::copy(sums.begin(), sums.begin() + channels_per_group, h + g * channels_per_group);
+            }
+        }
+
+        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        if(fft_tail.isActive())
+            fft_tail.process(input, h);
+
+        if(activation != nullptr)
+            activation->forward(h, h);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * The block is processed in chunks of max_block_frames samples. For each
+     * group and kernel tap, the outputs for the whole chunk are computed with
+     * vMatMulAccumColumns(), which uses each weight register that it loads
+     * for four samples at a time.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        if(depthwise)
+        {
+            // scale each channel by its own weight, one sample at a time
+            for(int n = 0; n < num_samples; ++n)
             {
-                for(int k = 0; k < kernel_size; ++k)
-                    h[i] += vMult(weights[i][k].data(), state_cols[k].data(), prod_state.data(), Layer<T>::in_size);
+                vCopy(channel_bias.data(), sums.data(), Layer<T>::out_size);
+                for(int k = 0; k < direct_kernel_size; ++k)
+                    vProdAccum(&channel_weights[k * out_size_padded], blockFrame(input, n - k * dilation_rate), sums.data(), Layer<T>::out_size);
+                std::copy(sums.begin(), sums.begin() + Layer<T>::out_size, output + n * Layer<T>::out_size);
             }
         }
         else
         {
-            // perform multi-channel convolution
-            vCopy(bias.data(), h, Layer<T>::out_size);
-            for(int i = 0; i < Layer<T>::out_size; ++i)
+            const auto frame_sums_size = groups * channels_per_group_padded;
+            for(int n0 = 0; n0 < num_samples; n0 += max_block_frames)
             {
-                const auto ii = ((i / channels_per_group) * filters_per_group);
-                for(int k = 0; k < kernel_size; ++k)
+                const auto num_frames = num_samples - n0 < max_block_frames ? num_samples - n0 : (int)max_block_frames;
+                for(int n = 0; n < num_frames; ++n)
+                    std::copy(bias.begin(), bias.end(), block_sums.begin() + n * frame_sums_size);
+
+                for(int g = 0; g < groups; ++g)
                 {
-                    // copy selected columns to a helper variable
-                    const auto& column = state[state_ptrs[k]];
-                    const auto column_begin = column.begin() + ii;
-                    const auto column_end = column_begin + filters_per_group;
-                    std::copy(column_begin, column_end, state_cols[k].begin());
+                    for(int k = 0; k < direct_kernel_size; ++k)
+                    {
+                        const T* frames[max_block_frames];
+                        for(int n = 0; n < num_frames; ++n)
+                            frames[n] = blockFrame(input, n0 + n - k * dilation_rate) + g * filters_per_group;
+
+                        vMatMulAccumColumns(&weights[(g * direct_kernel_size + k) * filters_per_group * channels_per_group_padded],
+                            frames,
+                            &block_sums[g * channels_per_group_padded],
+                            filters_per_group,
+                            channels_per_group_padded,
+                            num_frames,
+                            frame_sums_size);
+                    }
+                }
 
-                    h[i] += vMult(weights[i][k].data(), state_cols[k].data(), prod_state.data(), filters_per_group);
+                for(int n = 0; n < num_frames; ++n)
+                {
+                    for(int g = 0; g < groups; ++g)
+                    {
+                        const auto* frame_sums = &block_sums[n * frame_sums_size + g * channels_per_group_padded];
+                        std::copy(frame_sums, frame_sums + channels_per_group, output + (n0 + n) * Layer<T>::out_size + g * channels_per_group);
+                    }
                 }
             }
         }
 
-        state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+        // only the most recent inputs are needed for the next block
+        // (the block inputs may not be aligned, so they can't be copied with vCopy)
+        for(int n = std::max(0, num_samples - state_size); n < num_samples; ++n)
+        {
+            const auto* x = input + n * Layer<T>::in_size;
+            std::copy(x, x + Layer<T>::in_size, state[state_ptr].begin());
+            std::copy(x, x + Layer<T>::in_size, state[state_ptr + state_size].begin());
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        if(fft_tail.isActive())
+            fft_tail.processBlock(input, output, num_samples);
+
+        if(activation != nullptr)
+        {
+            for(int n = 0; n < num_samples; ++n)
+                activation->forward(output + n * Layer<T>::out_size, output + n * Layer<T>::out_size);
+        }
     }
 
     /**
@@ -129,41 +241,79 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    bool usesFFT() const noexcept { return fft_tail.isActive(); }
+
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
 private:
     using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
     using vec2_type = std::vector<vec_type>;
-    using vec3_type = std::vector<vec2_type>;
+
+    /** Maximum number of samples processed together by forwardBlock(). */
+    static constexpr int max_block_frames = 16;
 
     const int dilation_rate;
     const int kernel_size;
+    const int direct_kernel_size; // taps computed in direct form
     const int state_size;
     const int groups;
     const int filters_per_group;
     const int channels_per_group;
+    const int channels_per_group_padded;
+    const bool depthwise; // groups == in_size == out_size
+    const int out_size_padded;
 
-    vec3_type weights;
+    // weights are stored column-major for each group and kernel tap:
+    // weights[groups][direct_kernel_size][filters_per_group][channels_per_group_padded]
+    vec_type weights;
     vec_type bias;
+    vec_type sums;
 
-    vec2_type state;
-    vec2_type state_cols;
+    // depthwise weights and bias, stored as channel_weights[direct_kernel_size][out_size_padded]
+    vec_type channel_weights;
+    vec_type channel_bias;
+    vec_type block_sums; // block_sums[max_block_frames][groups][channels_per_group_padded]
 
+    // computes the kernel taps after the first direct_kernel_size taps
+    FFTConvolution<T> fft_tail;
+
+    // mirrored circular buffer: state[n] and state[n + state_size] hold the
+    // same input, so every kernel tap can be read in-place, without wrapping
+    vec2_type state;
     int state_ptr = 0;
-    std::vector<int> state_ptrs;
 
-    vec_type prod_state;
+    std::unique_ptr<Activation<T>> activation;
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
+    /** Inserts an input into both halves of the state buffer. */
+    inline void pushState(const T* input) noexcept
     {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
+        vCopy(input, state[state_ptr].data(), Layer<T>::in_size);
+        vCopy(input, state[state_ptr + state_size].data(), Layer<T>::in_size);
+    }
+
+    /**
+     * Returns the n-th input of a block, where negative indices refer
+     * to the inputs from before the block, stored in the state buffer.
+     */
+    inline const T* blockFrame(const T* input, int n) const noexcept
+    {
+        return n >= 0 ? input + n * Layer<T>::in_size : state[state_ptr + state_size + n].data();
     }
 };
 
 //====================================================
 /**
  * Static implementation of a 1-dimensional convolution layer
- * with no activation.
+ * with an optional fused activation (see fused_activation).
  *
  * This implementation was designed to be used for "temporal
  * convolution", so the layer has a "state" made up of past inputs
@@ -171,20 +321,29 @@ private:
  * please make sure to call `reset()` before your first call to
  * the `forward()` method.
  *
+ * If `use_fft` is true, and the kernel is long enough (see fft_conv::partitionSize()),
+ * the taps delayed by two or more partitions are computed with FFT convolution.
+ *
  * @param in_sizet: the input size for the layer
  * @param out_sizet: the output size for the layer
  * @param kernel_size: the size of the convolution kernel
  * @param dilation_rate: the dilation rate to use for dilated convolution
  * @param dynamic_state: use dynamically allocated layer state
+ * @param FusedActivation: an activation to apply to the layer outputs
+ * @param use_fft: compute the tail of a long kernel with FFT convolution
  */
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false>
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups = 1, bool dynamic_state = false,
+    typename FusedActivation = fused_activation::Identity, bool use_fft = false>
 class Conv1DT
 {
     using v_type = xsimd::simd_type<T>;
     static constexpr auto v_size = (int)v_type::size;
-    static constexpr auto state_size = (kernel_size - 1) * dilation_rate + 1;
+    static constexpr auto direct_kernel_size = use_fft ? fft_conv::directKernelSize(kernel_size, dilation_rate) : kernel_size;
+    static constexpr auto state_size = (direct_kernel_size - 1) * dilation_rate + 1;
+    static constexpr bool has_fft_tail = direct_kernel_size < kernel_size;
     static constexpr auto v_in_size = ceil_div(in_sizet, v_size);
     static constexpr auto v_out_size = ceil_div(out_sizet, v_size);
+    static constexpr bool is_depthwise = groups > 1 && groups == in_sizet && groups == out_sizet;
 
     static_assert((in_sizet % groups == 0) && (out_sizet % groups == 0), "in_size and out_size must be divisible by groups!");
 
@@ -194,6 +353,7 @@ public:
     static constexpr auto filters_per_group = in_size / groups;
     static constexpr auto channels_per_group = out_size / groups;
     static constexpr auto v_filters_per_group = ceil_div(filters_per_group, v_size);
+    using activation_type = FusedActivation;
 
     Conv1DT();
 
@@ -209,117 +369,113 @@ public:
     /** Performs a stride step for this layer. */
     RTNEURAL_REALTIME inline void skip(const v_type (&ins)[v_in_size])
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
+        pushState(ins);
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.skip(reinterpret_cast<const T*>(ins));
+        }
     }
 
-    /** Performs forward propagation for this layer. */
+    /** Performs forward propagation for this layer (groups > 1). */
     template <int G = groups>
-    RTNEURAL_REALTIME inline typename std::enable_if<(G > 1), void>::type
+    RTNEURAL_REALTIME inline typename std::enable_if<(G > 1 && !(G == in_size && G == out_size)), void>::type
     forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
+        pushState(ins);
 
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
-        // perform multi-channel convolution
-        for(int i = 0; i < v_out_size; ++i)
+        const auto newest = state_ptr + state_size;
+        RTNEURAL_IF_CONSTEXPR(!useGroupedBroadcast(groups, channels_per_group))
         {
-            alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_sum[v_size] {};
-            for(int k = 0; k < v_size && (i * v_size + k) < out_size; ++k)
+            // small groups: compute each output as a dot product over the inputs of its group
+            auto* out = reinterpret_cast<T*>(outs);
+            for(int i = 0; i < out_size; ++i)
             {
-                assert(i * v_size + k < out_size);
-                const auto& subWeights = weights[i * v_size + k];
-                v_type accum {};
-
-                const auto ii = (((i * v_size + k) / channels_per_group) * filters_per_group);
-                for(int j = 0; j < kernel_size; ++j)
+                const auto ii = (i / channels_per_group) * filters_per_group;
+                out[i] = block_bias[(i / channels_per_group) * channels_per_group_padded + (i % channels_per_group)];
+                for(int k = 0; k < direct_kernel_size; ++k)
                 {
-                    // copy selected columns to a helper variable
-                    // @TODO: I'm not sure the reinterpret_casts are 100% safe here, but they seem to work in testing!
-                    const auto& column = reinterpret_cast<std::array<T, in_size>&>(state[state_ptrs[j]]);
-                    const auto column_begin = column.begin() + ii;
-                    const auto column_end = column_begin + filters_per_group;
-                    std::copy(column_begin, column_end, reinterpret_cast<std::array<T, filters_per_group>&>(state_cols[j]).begin());
-
-                    accum += std::inner_product(
-                        subWeights[j].begin(),
-                        subWeights[j].end(),
-                        state_cols[j].begin(),
-                        v_type {});
+                    const auto* w = reinterpret_cast<const T*>(weights[i][k].data());
+                    out[i] = std::inner_product(w, w + filters_per_group, reinterpret_cast<const T*>(state[newest - k * dilation_rate].data()) + ii, out[i]);
                 }
-                out_sum[k] = xsimd::reduce_add(accum);
             }
+        }
+        else
+        {
+            // perform multi-channel convolution, one group at a time, with each
+            // input broadcast across the output channels of its group
+            for(int g = 0; g < groups; ++g)
+            {
+                auto* sums = block_sums + g * channels_per_group_padded;
+                std::copy(block_bias + g * channels_per_group_padded, block_bias + (g + 1) * channels_per_group_padded, sums);
+                for(int k = 0; k < direct_kernel_size; ++k)
+                {
+                    vMatVecAccum(block_weights + (g * direct_kernel_size + k) * filters_per_group * channels_per_group_padded,
+                        reinterpret_cast<const T*>(state[newest - k * dilation_rate].data()) + g * filters_per_group,
+                        sums,
+                        (int)filters_per_group,
+                        (int)channels_per_group_padded);
+                }
 
-            outs[i] = xsimd::load_aligned(out_sum) + bias[i];
+                std::copy(sums, sums + channels_per_group, reinterpret_cast<T*>(outs) + g * channels_per_group);
+            }
         }
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs));
+        }
+
+        applyActivation();
     }
 
-    /** Performs forward propagation for this layer. */
-    template <int DR = dilation_rate, int G = groups>
-    RTNEURAL_REALTIME inline typename std::enable_if<(DR > 1 && G == 1), void>::type
+    /** Performs forward propagation for this layer (depthwise, groups == in_size == out_size). */
+    template <int G = groups>
+    RTNEURAL_REALTIME inline typename std::enable_if<(G > 1 && G == in_size && G == out_size), void>::type
     forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
-
-        // copy selected columns to a helper variable
-        for(int k = 0; k < kernel_size; ++k)
+        RTNEURAL_IF_CONSTEXPR(kernel_size == 1)
         {
-            const auto& col = state[state_ptrs[k]];
-            std::copy(col.begin(), col.end(), state_cols[k].begin());
+            // a depthwise convolution with a single tap is an element-wise scaling
+            for(int i = 0; i < v_out_size; ++i)
+                outs[i] = activation(xsimd::fma(channel_weights[0][i], ins[i], bias[i]), i);
+            return;
         }
 
-        // perform multi-channel convolution
+        pushState(ins);
+
+        // scale each channel by its own weight, one kernel tap at a time
+        const auto newest = state_ptr + state_size;
         for(int i = 0; i < v_out_size; ++i)
         {
-            alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_sum[v_size] {};
-            for(int k = 0; k < v_size && (i * v_size + k) < out_size; ++k)
-            {
-                assert(i * v_size + k < out_size);
-                const auto& subWeights = weights[i * v_size + k];
-                v_type accum {};
-                for(int j = 0; j < kernel_size; ++j)
-                {
-                    accum += std::inner_product(
-                        subWeights[j].begin(),
-                        subWeights[j].end(),
-                        state_cols[j].begin(),
-                        v_type {});
-                }
-                out_sum[k] = xsimd::reduce_add(accum);
-            }
-
-            outs[i] = xsimd::load_aligned(out_sum) + bias[i];
+            auto accum = bias[i];
+            for(int k = 0; k < direct_kernel_size; ++k)
+                accum = xsimd::fma(channel_weights[k][i], state[newest - k * dilation_rate][i], accum);
+            outs[i] = accum;
         }
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs));
+        }
+
+        applyActivation();
     }
 
     /** Performs forward propagation for this layer. */
-    template <int DR = dilation_rate, int KS = kernel_size, int G = groups>
-    RTNEURAL_REALTIME inline typename std::enable_if<(DR == 1 && KS > 1 && G == 1), void>::type
+    template <int KS = kernel_size, int G = groups>
+    RTNEURAL_REALTIME inline typename std::enable_if<(KS > 1 && G == 1), void>::type
     forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        // insert input into a circular buffer
-        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
-
-        // set state pointers to particular columns of the buffer
-        setStatePointers();
+        pushState(ins);
 
-        // perform multi-channel convolution
+        // perform multi-channel convolution, reading the kernel taps in-place
+        const auto newest = state_ptr + state_size;
         for(int i = 0; i < v_out_size; ++i)
         {
             alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_sum[v_size] {};
@@ -327,12 +483,12 @@ public:
             {
                 const auto& subWeights = weights[i * v_size + k];
                 v_type accum {};
-                for(int j = 0; j < kernel_size; ++j)
+                for(int j = 0; j < direct_kernel_size; ++j)
                 {
                     accum += std::inner_product(
                         subWeights[j].begin(),
                         subWeights[j].end(),
-                        state[(state_ptr + state_size - j) % state_size].begin(),
+                        state[newest - j * dilation_rate].begin(),
                         v_type {});
                 }
                 out_sum[k] = xsimd::reduce_add(accum);
@@ -342,6 +498,13 @@ public:
         }
 
         state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1); // iterate state pointer forwards
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.process(reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs));
+        }
+
+        applyActivation();
     }
 
     /** Performs forward propagation for this layer. */
@@ -362,8 +525,95 @@ public:
                 out_sum[k] = xsimd::reduce_add(accum);
             }
 
-            outs[i] = xsimd::load_aligned(out_sum) + bias[i];
+            outs[i] = activation(xsimd::load_aligned(out_sum) + bias[i], i);
+        }
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     *
+     * The block is processed in chunks of max_block_frames samples. For each
+     * group and kernel tap, the outputs for the whole chunk are computed with
+     * vMatMulAccumColumns(), which uses each weight register that it loads
+     * for four samples at a time.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        RTNEURAL_IF_CONSTEXPR(is_depthwise)
+        {
+            // scale each channel by its own weight, one sample at a time
+            for(int n = 0; n < num_samples; ++n)
+            {
+                std::copy(reinterpret_cast<const T*>(bias), reinterpret_cast<const T*>(bias) + out_size, block_sums);
+                for(int k = 0; k < direct_kernel_size; ++k)
+                    vProdAccum(reinterpret_cast<const T*>(channel_weights[k]), blockFrame(input, n - k * dilation_rate), block_sums, (int)out_size);
+                std::copy(block_sums, block_sums + out_size, output + n * out_size);
+            }
         }
+        else
+        {
+            constexpr auto frame_sums_size = groups * channels_per_group_padded;
+            for(int n0 = 0; n0 < num_samples; n0 += max_block_frames)
+            {
+                const auto num_frames = num_samples - n0 < max_block_frames ? num_samples - n0 : (int)max_block_frames;
+                for(int n = 0; n < num_frames; ++n)
+                    std::copy(std::begin(block_bias), std::end(block_bias), block_sums + n * frame_sums_size);
+
+                for(int g = 0; g < groups; ++g)
+                {
+                    for(int k = 0; k < direct_kernel_size; ++k)
+                    {
+                        const T* frames[max_block_frames];
+                        for(int n = 0; n < num_frames; ++n)
+                            frames[n] = blockFrame(input, n0 + n - k * dilation_rate) + g * filters_per_group;
+
+                        vMatMulAccumColumns(block_weights + (g * direct_kernel_size + k) * filters_per_group * channels_per_group_padded,
+                            frames,
+                            block_sums + g * channels_per_group_padded,
+                            (int)filters_per_group,
+                            (int)channels_per_group_padded,
+                            num_frames,
+                            (int)frame_sums_size);
+                    }
+                }
+
+                for(int n = 0; n < num_frames; ++n)
+                {
+                    for(int g = 0; g < groups; ++g)
+                    {
+                        const auto* frame_sums = block_sums + n * frame_sums_size + g * channels_per_group_padded;
+                        std::copy(frame_sums, frame_sums + channels_per_group, output + (n0 + n) * out_size + g * channels_per_group);
+                    }
+                }
+            }
+        }
+
+        // only the most recent inputs are needed for the next block
+        for(int n = num_samples > state_size ? num_samples - state_size : 0; n < num_samples; ++n)
+        {
+            const auto* x = input + n * in_size;
+            std::copy(x, x + in_size, reinterpret_cast<T*>(state[state_ptr].data()));
+            std::copy(x, x + in_size, reinterpret_cast<T*>(state[state_ptr + state_size].data()));
+            state_ptr = (state_ptr == state_size - 1 ? 0 : state_ptr + 1);
+        }
+
+        RTNEURAL_IF_CONSTEXPR(has_fft_tail)
+        {
+            fft_tail.processBlock(input, output, num_samples);
+        }
+
+        RTNEURAL_IF_CONSTEXPR(!FusedActivation::is_identity)
+        {
+            for(int n = 0; n < num_samples; ++n)
+                for(int i = 0; i < out_size; ++i)
+                    output[n * out_size + i] = activation(output[n * out_size + i], i);
+        }
+
+        if(num_samples > 0)
+            std::copy(output + (num_samples - 1) * out_size, output + num_samples * out_size, reinterpret_cast<T*>(outs));
     }
 
     /**
@@ -389,37 +639,77 @@ public:
     /** Returns the number of "groups" in the convolution. */
     int getGroups() const noexcept { return groups; }
 
+    /** Returns true if the tail of the kernel is computed with FFT convolution. */
+    static constexpr bool usesFFT() noexcept { return has_fft_tail; }
+
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     v_type outs[v_out_size];
 
 private:
     template <int DS = dynamic_state>
     typename std::enable_if<DS, void>::type resize_state()
     {
-        state.resize(state_size, {});
+        state.resize(2 * state_size, {});
     }
 
     template <int DS = dynamic_state>
     typename std::enable_if<!DS, void>::type resize_state() { }
 
+    /** Inserts an input into both halves of the mirrored state buffer. */
+    inline void pushState(const v_type (&ins)[v_in_size]) noexcept
+    {
+        std::copy(std::begin(ins), std::end(ins), state[state_ptr].begin());
+        std::copy(std::begin(ins), std::end(ins), state[state_ptr + state_size].begin());
+    }
+
+    /**
+     * Returns the n-th input of a block, where negative indices refer
+     * to the inputs from before the block, stored in the state buffer.
+     */
+    inline const T* blockFrame(const T* input, int n) const noexcept
+    {
+        return n >= 0 ? input + n * in_size : reinterpret_cast<const T*>(state[state_ptr + state_size + n].data());
+    }
+
+    /** Applies the fused activation to the layer outputs. */
+    inline void applyActivation() noexcept
+    {
+        RTNEURAL_IF_CONSTEXPR(!FusedActivation::is_identity)
+        {
+            for(int i = 0; i < v_out_size; ++i)
+                outs[i] = activation(outs[i], i);
+        }
+    }
+
     using state_col_type = std::array<v_type, v_in_size>;
-    using state_type = typename std::conditional<dynamic_state, std::vector<state_col_type, xsimd::aligned_allocator<state_col_type>>, std::array<state_col_type, state_size>>::type;
-    using weights_type = std::array<std::array<v_type, v_filters_per_group>, kernel_size>;
+    using state_type = typename std::conditional<dynamic_state, std::vector<state_col_type, xsimd::aligned_allocator<state_col_type>>, std::array<state_col_type, 2 * state_size>>::type;
+    using weights_type = std::array<std::array<v_type, v_filters_per_group>, direct_kernel_size>;
 
+    // mirrored circular buffer, with state[n] == state[n + state_size]
     state_type state {};
-    weights_type state_cols {};
-
     int state_ptr = 0;
-    std::array<int, kernel_size> state_ptrs {};
 
     weights_type weights[out_size] {};
     v_type bias[v_out_size] {};
 
-    /** Sets pointers to state array columns. */
-    inline void setStatePointers()
-    {
-        for(int k = 0; k < kernel_size; ++k)
-            state_ptrs[k] = (state_ptr + state_size - k * dilation_rate) % state_size;
-    }
+    // depthwise weights, stored as channel_weights[direct_kernel_size][v_out_size]
+    v_type channel_weights[is_depthwise ? direct_kernel_size : 1][v_out_size] {};
+
+    // weights and bias for the grouped forward() and for forwardBlock(), stored column-major
+    // for each group and kernel tap, so that each output register can be computed with FMAs:
+    // block_weights[groups][direct_kernel_size][filters_per_group][channels_per_group_padded]
+    static constexpr int max_block_frames = 16;
+    static constexpr auto channels_per_group_padded = ceil_div(channels_per_group, v_size) * v_size;
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) T block_weights[groups * direct_kernel_size * filters_per_group * channels_per_group_padded] {};
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) T block_bias[groups * channels_per_group_padded] {};
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) T block_sums[max_block_frames * groups * channels_per_group_padded] {};
+
+    // computes the kernel taps after the first direct_kernel_size taps
+    FFTConvolution<T> fft_tail { in_size, out_size, kernel_size, dilation_rate, groups, use_fft };
+
+    FusedActivation activation;
 };
 } // namespace RTNEURAL_NAMESPACE
 
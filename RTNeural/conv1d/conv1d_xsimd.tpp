@@ -4,21 +4,31 @@ namespace RTNEURAL_NAMESPACE
 {
 
 template <typename T>
-Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups)
+Conv1D<T>::Conv1D(int in_size, int out_size, int kernel_size, int dilation, int num_groups, bool use_fft)
     : Layer<T>(in_size, out_size)
     , dilation_rate(dilation)
     , kernel_size(kernel_size)
-    , state_size((kernel_size - 1) * dilation + 1)
+    , direct_kernel_size(use_fft ? fft_conv::directKernelSize(kernel_size, dilation) : kernel_size)
+    , state_size((direct_kernel_size - 1) * dilation + 1)
     , groups(num_groups)
     , filters_per_group(in_size / groups)
     , channels_per_group(out_size / groups)
+    , channels_per_group_padded(simd_padded_size<T>(channels_per_group))
+    , depthwise(groups > 1 && groups == in_size && groups == out_size)
+    , out_size_padded(simd_padded_size<T>(out_size))
+    , fft_tail(in_size, out_size, kernel_size, dilation, num_groups, use_fft)
 {
-    weights = vec3_type(out_size, vec2_type(kernel_size, vec_type(filters_per_group, (T)0)));
-    bias.resize(out_size, (T)0);
-    state = vec2_type(state_size, vec_type(in_size, (T)0));
-    state_cols = vec2_type(kernel_size, vec_type(filters_per_group, (T)0));
-    state_ptrs.resize(kernel_size);
-    prod_state.resize(filters_per_group);
+    weights.resize(groups * direct_kernel_size * filters_per_group * channels_per_group_padded, (T)0);
+    bias.resize(groups * channels_per_group_padded, (T)0);
+    sums.resize(depthwise ? out_size_padded : channels_per_group_padded, (T)0);
+    if(depthwise)
+    {
+        channel_weights.resize(direct_kernel_size * out_size_padded, (T)0);
+        channel_bias.resize(out_size_padded, (T)0);
+    }
+
+    block_sums.resize(max_block_frames * groups * channels_per_group_padded, (T)0);
+    state = vec2_type(2 * state_size, vec_type(in_size, (T)0));
 }
 
 template <typename T>
@@ -30,7 +40,7 @@ Conv1D<T>::Conv1D(std::initializer_list<int> sizes)
 
 template <typename T>
 Conv1D<T>::Conv1D(const Conv1D<T>& other)
-    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate)
+    : Conv1D<T>(other.in_size, other.out_size, other.kernel_size, other.dilation_rate, other.groups, other.fft_tail.isActive())
 {
 }
 
@@ -46,38 +56,51 @@ Conv1D<T>::~Conv1D() = default;
 template <typename T>
 void Conv1D<T>::reset()
 {
-    for(int k = 0; k < state_size; ++k)
-        std::fill(state[k].begin(), state[k].end(), (T)0);
+    for(auto& col : state)
+        std::fill(col.begin(), col.end(), (T)0);
 
-    for(int k = 0; k < kernel_size; ++k)
-        std::fill(state_cols[k].begin(), state_cols[k].end(), (T)0);
-
-    std::fill(state_ptrs.begin(), state_ptrs.end(), 0);
     state_ptr = 0;
+    fft_tail.reset();
 }
 
 template <typename T>
 void Conv1D<T>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
+    {
+        const auto g = i / channels_per_group;
+        const auto ch = i % channels_per_group;
         for(int k = 0; k < filters_per_group; ++k)
-            for(int j = 0; j < kernel_size; ++j)
-                weights[i][j][k] = ws[i][k][j];
+            for(int j = 0; j < direct_kernel_size; ++j)
+                weights[((g * direct_kernel_size + j) * filters_per_group + k) * channels_per_group_padded + ch] = ws[i][k][j];
+    }
+
+    if(depthwise)
+    {
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+            for(int j = 0; j < direct_kernel_size; ++j)
+                channel_weights[j * out_size_padded + i] = ws[i][0][j];
+    }
+
+    fft_tail.setWeights(ws);
 }
 
 template <typename T>
 void Conv1D<T>::setBias(const std::vector<T>& biasVals)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
-        bias[i] = biasVals[i];
+        bias[(i / channels_per_group) * channels_per_group_padded + (i % channels_per_group)] = biasVals[i];
+
+    if(depthwise)
+        std::copy(biasVals.begin(), biasVals.begin() + Layer<T>::out_size, channel_bias.begin());
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::Conv1DT()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::Conv1DT()
 {
     for(int i = 0; i < out_size; ++i)
-        for(int j = 0; j < kernel_size; ++j)
+        for(int j = 0; j < direct_kernel_size; ++j)
             for(int k = 0; k < v_filters_per_group; ++k)
                 weights[i][j][k] = v_type((T)0.0);
 
@@ -91,43 +114,58 @@ Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_stat
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::reset()
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::reset()
 {
-    for(int i = 0; i < state_size; ++i)
+    for(int i = 0; i < 2 * state_size; ++i)
         for(int k = 0; k < v_in_size; ++k)
             state[i][k] = v_type((T)0.0);
 
-    for(int i = 0; i < kernel_size; ++i)
-        for(int k = 0; k < v_filters_per_group; ++k)
-            state_cols[i][k] = v_type((T)0.0);
-
     state_ptr = 0;
-    for(int i = 0; i < kernel_size; ++i)
-        state_ptrs[i] = 0;
+    fft_tail.reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setWeights(const std::vector<std::vector<std::vector<T>>>& ws)
 {
     for(int i = 0; i < out_size; ++i)
     {
+        const auto g = i / channels_per_group;
+        const auto ch = i % channels_per_group;
         for(int k = 0; k < filters_per_group; ++k)
         {
-            for(int j = 0; j < kernel_size; ++j)
+            for(int j = 0; j < direct_kernel_size; ++j)
             {
                 auto& w = weights[i][j][k / v_size];
                 w = set_value(w, k % v_size, ws[i][k][j]);
+                block_weights[((g * direct_kernel_size + j) * filters_per_group + k) * channels_per_group_padded + ch] = ws[i][k][j];
             }
         }
     }
+
+    RTNEURAL_IF_CONSTEXPR(is_depthwise)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            for(int j = 0; j < direct_kernel_size; ++j)
+            {
+                auto& w = channel_weights[j][i / v_size];
+                w = set_value(w, i % v_size, ws[i][0][j]);
+            }
+        }
+    }
+
+    fft_tail.setWeights(ws);
 }
 
-template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state>
-void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state>::setBias(const std::vector<T>& biasVals)
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int groups, bool dynamic_state, typename FusedActivation, bool use_fft>
+void Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, groups, dynamic_state, FusedActivation, use_fft>::setBias(const std::vector<T>& biasVals)
 {
     for(int i = 0; i < out_size; ++i)
+    {
         bias[i / v_size] = set_value(bias[i / v_size], i % v_size, biasVals[i]);
+        block_bias[(i / channels_per_group) * channels_per_group_padded + (i % channels_per_group)] = biasVals[i];
+    }
 }
 
 } // namespace RTNEURAL_NAMESPACE
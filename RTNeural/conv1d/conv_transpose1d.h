@@ -0,0 +1,350 @@
+#ifndef CONVTRANSPOSE1D_H_INCLUDED
+#define CONVTRANSPOSE1D_H_INCLUDED
+
+#include "conv1d.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+#ifndef DOXYGEN
+namespace conv_transpose1d_detail
+{
+    /** Returns the kernel size of the polyphase convolution, in input frames. */
+    constexpr int polyphaseKernelSize(int kernel_size, int dilation, int stride)
+    {
+        return (kernel_size - 1) * dilation / stride + 1;
+    }
+
+    /**
+     * Rearranges the weights of a transposed convolution into the weights of
+     * the equivalent polyphase convolution, with one group of out_size output
+     * channels for each output phase.
+     *
+     * Tap k of the transposed convolution contributes to output phase
+     * (k * dilation) % stride, from the input frame (k * dilation) / stride
+     * frames back.
+     */
+    template <typename T>
+    std::vector<std::vector<std::vector<T>>> polyphaseWeights(const std::vector<std::vector<std::vector<T>>>& weights,
+        int in_size, int out_size, int kernel_size, int dilation, int stride, int groups)
+    {
+        const auto filters_per_group = in_size / groups;
+        const auto channels_per_group = out_size / groups;
+        const auto poly_kernel_size = polyphaseKernelSize(kernel_size, dilation, stride);
+
+        std::vector<std::vector<std::vector<T>>> polyWeights((size_t)(stride * out_size),
+            std::vector<std::vector<T>>((size_t)in_size, std::vector<T>((size_t)poly_kernel_size, (T)0)));
+
+        for(int k = 0; k < kernel_size; ++k)
+        {
+            const auto phase = (k * dilation) % stride;
+            const auto delay = (k * dilation) / stride;
+
+            for(int i = 0; i < out_size; ++i)
+            {
+                const auto ii = (i / channels_per_group) * filters_per_group;
+                for(int j = 0; j < filters_per_group; ++j)
+                    polyWeights[(size_t)(phase * out_size + i)][(size_t)(ii + j)][(size_t)delay] = weights[(size_t)i][(size_t)j][(size_t)k];
+            }
+        }
+
+        return polyWeights;
+    }
+
+    /** Repeats the bias for each output phase. */
+    template <typename T>
+    std::vector<T> polyphaseBias(const std::vector<T>& bias, int out_size, int stride)
+    {
+        std::vector<T> polyBias((size_t)(stride * out_size));
+        for(int p = 0; p < stride; ++p)
+            std::copy(bias.begin(), bias.begin() + out_size, polyBias.begin() + p * out_size);
+        return polyBias;
+    }
+} // namespace conv_transpose1d_detail
+#endif // DOXYGEN
+
+/**
+ * Dynamic implementation of a streaming 1-dimensional transposed
+ * convolution layer (i.e. PyTorch's ConvTranspose1d).
+ *
+ * A transposed convolution with a stride is the same as a regular
+ * convolution of the input stream with `stride - 1` zeros inserted
+ * after every input frame. Rather than convolving the zeros, the layer
+ * is computed in polyphase form: each call to forward() consumes one
+ * input frame and writes the `stride` output frames that follow it,
+ * one after the other, so the layer's out_size is `stride * out_channels`.
+ * All of the phases are computed by a single Conv1D, with one group of
+ * output channels per phase, and taps that only multiply the inserted
+ * zeros are never computed.
+ *
+ * Like the other streaming convolutions, the layer is causal: the
+ * `padding` of a PyTorch ConvTranspose1d corresponds to discarding the
+ * first `padding` output frames.
+ */
+template <typename T>
+class ConvTranspose1D final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a transposed convolution layer for the given dimensions.
+     *
+     * @param in_size: the input size for the layer
+     * @param out_channels: the number of output channels, for each output frame
+     * @param kernel_size: the size of the convolution kernel
+     * @param dilation: the dilation rate to use for dilated convolution
+     * @param stride: the stride of the convolution (the number of output frames per input frame)
+     * @param groups: controls connections between inputs and outputs
+     */
+    ConvTranspose1D(int in_size, int out_channels, int kernel_size, int dilation, int stride, int groups = 1)
+        : Layer<T>(in_size, stride * out_channels)
+        , internal(in_size, stride * out_channels, conv_transpose1d_detail::polyphaseKernelSize(kernel_size, dilation, stride), 1, 1)
+        , out_channels(out_channels)
+        , kernel_size(kernel_size)
+        , dilation_rate(dilation)
+        , stride(stride)
+        , groups(groups)
+    {
+    }
+
+    ConvTranspose1D(std::initializer_list<int> sizes)
+        : ConvTranspose1D<T>(*sizes.begin(), *(sizes.begin() + 1), *(sizes.begin() + 2),
+            *(sizes.begin() + 3), *(sizes.begin() + 4), *(sizes.begin() + 5))
+    {
+    }
+
+    ConvTranspose1D(const ConvTranspose1D& other) = default;
+    ConvTranspose1D& operator=(const ConvTranspose1D& other) = default;
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset() override
+    {
+        internal.reset();
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "convtranspose1d"; }
+
+    /** Pushes an input frame into the layer state, without computing any outputs. */
+    RTNEURAL_REALTIME inline void skip(const T* input)
+    {
+        internal.skip(input);
+    }
+
+    /** Performs forward propagation for this layer, writing `stride` output frames. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
+    {
+        internal.forward(input, h);
+    }
+
+    /**
+     * Sets the layer weights.
+     *
+     * The weights vector must have size weights[out_channels][in_size / groups][kernel_size],
+     * where tap k multiplies the input frame that was received k * dilation output frames ago.
+     * The weights are rearranged into a temporary (allocated) polyphase kernel.
+     */
+    void setWeights(const std::vector<std::vector<std::vector<T>>>& weights)
+    {
+        internal.setWeights(conv_transpose1d_detail::polyphaseWeights(weights, Layer<T>::in_size, out_channels,
+            kernel_size, dilation_rate, stride, groups));
+    }
+
+    /**
+     * Sets the layer biases.
+     *
+     * The bias vector must have size bias[out_channels]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        internal.setBias(conv_transpose1d_detail::polyphaseBias(biasVals, out_channels, stride));
+    }
+
+    /** Returns the number of output frames per input frame (the convolution stride). */
+    int getInterpolationFactor() const noexcept override { return stride; }
+
+    /** Returns the number of output channels, for each output frame. */
+    int getOutChannels() const noexcept { return out_channels; }
+
+    /** Returns the size of the convolution kernel. */
+    RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
+
+    /** Returns the convolution dilation rate. */
+    RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate; }
+
+    /** Returns the convolution stride. */
+    RTNEURAL_REALTIME int getStride() const noexcept { return stride; }
+
+    /** Returns the number of "groups" in the convolution. */
+    int getGroups() const noexcept { return groups; }
+
+private:
+    Conv1D<T> internal;
+
+    int out_channels;
+    int kernel_size;
+    int dilation_rate;
+    int stride;
+    int groups;
+};
+
+//====================================================
+/**
+ * Static implementation of a streaming 1-dimensional transposed
+ * convolution layer, computed in polyphase form (see ConvTranspose1D).
+ *
+ * Each call to forward() consumes one input frame and writes `stride`
+ * output frames, one after the other, so the layer's out_size is
+ * `stride * out_channels`. loadOutputFrame() copies one of those frames
+ * into `frame_outs`, which is how ModelT passes the frames on to the
+ * following layers, one at a time.
+ *
+ * @param in_sizet: the input size for the layer
+ * @param out_channels_t: the number of output channels, for each output frame
+ * @param kernel_size: the size of the convolution kernel
+ * @param dilation_rate: the dilation rate to use for dilated convolution
+ * @param stride: the stride of the convolution (the number of output frames per input frame)
+ * @param groups: controls connections between inputs and outputs
+ * @param dynamic_state: use dynamically allocated layer state
+ */
+template <typename T, int in_sizet, int out_channels_t, int kernel_size, int dilation_rate, int stride, int groups = 1, bool dynamic_state = false>
+class ConvTranspose1DT
+{
+    static constexpr auto poly_kernel_size = conv_transpose1d_detail::polyphaseKernelSize(kernel_size, dilation_rate, stride);
+
+    Conv1DT<T, in_sizet, stride * out_channels_t, poly_kernel_size, 1, 1, dynamic_state> internal;
+
+public:
+    static constexpr auto in_size = in_sizet;
+    static constexpr auto out_channels = out_channels_t;
+    static constexpr auto out_size = stride * out_channels_t;
+    static constexpr auto interpolation_factor = stride;
+
+    ConvTranspose1DT()
+        : outs(internal.outs)
+#if RTNEURAL_USE_EIGEN
+        , frame_outs(frame_outs_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(auto& x : frame_outs)
+            x = v_type((T)0);
+#elif RTNEURAL_USE_EIGEN
+        frame_outs.setZero();
+#else
+        std::fill(std::begin(frame_outs), std::end(frame_outs), (T)0);
+#endif
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "convtranspose1d"; }
+
+    /** Returns false since convolution is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset()
+    {
+        internal.reset();
+    }
+
+    /** Pushes an input frame into the layer state, without computing any outputs. */
+    template <typename Inputs>
+    RTNEURAL_REALTIME inline void skip(const Inputs& ins) noexcept
+    {
+        internal.skip(ins);
+    }
+
+    /** Performs forward propagation for this layer, writing `stride` output frames. */
+    template <typename Inputs>
+    RTNEURAL_REALTIME inline void forward(const Inputs& ins) noexcept
+    {
+        internal.forward(ins);
+
+#if RTNEURAL_USE_XSIMD
+        // the frames are not aligned to the SIMD batches
+        for(int i = 0; i < v_out_size; ++i)
+            internal.outs[i].store_aligned(flat_outs + i * v_size);
+#endif
+    }
+
+    /** Copies output frame `frame` (of the `stride` frames written by forward()) into `frame_outs`. */
+    RTNEURAL_REALTIME inline void loadOutputFrame(int frame) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        std::copy(flat_outs + frame * out_channels, flat_outs + (frame + 1) * out_channels, frame_flat);
+        for(int i = 0; i < v_frame_size; ++i)
+            frame_outs[i] = xsimd::load_aligned(frame_flat + i * v_size);
+#elif RTNEURAL_USE_EIGEN
+        frame_outs = internal.outs.template segment<out_channels_t>(frame * out_channels_t);
+#else
+        std::copy(internal.outs + frame * out_channels, internal.outs + (frame + 1) * out_channels, frame_outs);
+#endif
+    }
+
+    /**
+     * Sets the layer weights.
+     *
+     * The weights vector must have size weights[out_channels][in_size / groups][kernel_size],
+     * where tap k multiplies the input frame that was received k * dilation output frames ago.
+     * The weights are rearranged into a temporary (allocated) polyphase kernel.
+     */
+    void setWeights(const std::vector<std::vector<std::vector<T>>>& weights)
+    {
+        internal.setWeights(conv_transpose1d_detail::polyphaseWeights(weights, in_size, out_channels,
+            kernel_size, dilation_rate, stride, groups));
+    }
+
+    /**
+     * Sets the layer biases.
+     *
+     * The bias vector must have size bias[out_channels]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        internal.setBias(conv_transpose1d_detail::polyphaseBias(biasVals, out_channels, stride));
+    }
+
+    /** Returns the number of output channels, for each output frame. */
+    int getOutChannels() const noexcept { return out_channels; }
+
+    /** Returns the size of the convolution kernel. */
+    RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
+
+    /** Returns the convolution dilation rate. */
+    RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate; }
+
+    /** Returns the convolution stride. */
+    RTNEURAL_REALTIME int getStride() const noexcept { return stride; }
+
+    /** Returns the number of "groups" in the convolution. */
+    int getGroups() const noexcept { return groups; }
+
+    /** Reference to the internal layer outputs. */
+    decltype(internal.outs)& outs;
+
+#if RTNEURAL_USE_XSIMD
+private:
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = (int)v_type::size;
+    static constexpr auto v_out_size = ceil_div(out_size, v_size);
+    static constexpr auto v_frame_size = ceil_div(out_channels_t, v_size);
+
+    T flat_outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size] {};
+    T frame_flat alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_frame_size * v_size] {};
+
+public:
+    /** The output frame loaded by loadOutputFrame(). */
+    v_type frame_outs[v_frame_size];
+#elif RTNEURAL_USE_EIGEN
+    /** The output frame loaded by loadOutputFrame(). */
+    Eigen::Map<Eigen::Matrix<T, out_channels_t, 1>, RTNeuralEigenAlignment> frame_outs;
+
+private:
+    T frame_outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_channels_t];
+#else
+    /** The output frame loaded by loadOutputFrame(). */
+    T frame_outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_channels_t];
+#endif
+};
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // CONVTRANSPOSE1D_H_INCLUDED
@@ -74,6 +74,16 @@ public:
         strides_counter = (strides_counter == stride - 1) ? 0 : strides_counter + 1;
     }
 
+    /** Returns the stride of the convolution. */
+    int getDecimationFactor() const noexcept override { return stride; }
+
+    /** Returns true if the last call to forward() computed a new output frame. */
+    bool hasNewOutput() const noexcept override
+    {
+        // the counter has already moved on from the computed step
+        return strides_counter == 1 % stride;
+    }
+
     /**
      * Sets the layer weights.
      *
@@ -138,6 +148,7 @@ public:
     static constexpr auto out_size = out_sizet;
     static constexpr auto filters_per_group = in_size / groups;
     static constexpr auto channels_per_group = out_size / groups;
+    static constexpr auto decimation_factor = stride;
 
     StridedConv1DT()
         : outs(internal.outs)
@@ -153,6 +164,7 @@ public:
     /** Resets the layer state. */
     RTNEURAL_REALTIME void reset()
     {
+        strides_counter = 0;
         internal.reset();
     }
 
@@ -175,6 +187,13 @@ public:
         strides_counter = (strides_counter == stride - 1) ? 0 : strides_counter + 1;
     }
 
+    /** Returns true if the last call to forward() computed a new output frame. */
+    RTNEURAL_REALTIME bool hasNewOutput() const noexcept
+    {
+        // the counter has already moved on from the computed step
+        return strides_counter == 1 % stride;
+    }
+
     /**
      * Sets the layer weights.
      *
@@ -9,7 +9,9 @@
 #include "conv1d_stateless_xsimd.tpp"
 #else
 #include "../Layer.h"
+#include "../common.h"
 #include "../config.h"
+#include <vector>
 
 namespace RTNEURAL_NAMESPACE
 {
@@ -18,6 +20,11 @@ namespace RTNEURAL_NAMESPACE
  * This implementation was designed to be used for a single frame of features, fully available at each forward call.
  * So the layer has a NO internal "state"
  *
+ * The convolution is computed "im2col"-style, as a single matrix product
+ * between the weights and the sliding windows of the input. Since the
+ * input features are stored contiguously, each window is read in place,
+ * and only "same" padding needs a (zero-padded) copy of the input.
+ *
  * @tparam T Type of the layer (float, double, int ...)
  */
 template <typename T>
@@ -77,68 +84,14 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* output) noexcept override
     {
-        if(valid_pad)
+        const T* windows = input;
+        if(pad_left + pad_right > 0)
         {
-            for(int out_row_idx = 0; out_row_idx < num_filters_out; ++out_row_idx)
-            {
-                for(int out_col_idx = 0; out_col_idx < num_features_out; ++out_col_idx)
-                {
-                    T sum {};
-                    for(int in_col_idx = out_col_idx * stride; in_col_idx < out_col_idx * stride + kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - out_col_idx * stride;
-                        for(int in_row_idx = 0; in_row_idx < num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (input[in_col_idx * num_filters_in + in_row_idx]);
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-            }
-        }
-        else
-        {
-            for(int out_row_idx = 0; out_row_idx < num_filters_out; ++out_row_idx)
-            {
-                int out_col_idx = 0;
-
-                for(; out_col_idx * stride < pad_left; ++out_col_idx)
-                {
-                    T sum {};
-                    const int eff_kernel_size = kernel_size - pad_left + out_col_idx * stride;
-                    for(int in_col_idx = 0; in_col_idx < eff_kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx + (kernel_size - eff_kernel_size);
-                        for(int in_row_idx = 0; in_row_idx < num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (input[in_col_idx * num_filters_in + in_row_idx]);
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-
-                for(; out_col_idx * stride - pad_left + kernel_size < num_features_in; ++out_col_idx)
-                {
-                    T sum {};
-                    for(int in_col_idx = out_col_idx * stride - pad_left; in_col_idx < out_col_idx * stride - pad_left + kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (out_col_idx * stride - pad_left);
-                        for(int in_row_idx = 0; in_row_idx < num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (input[in_col_idx * num_filters_in + in_row_idx]);
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-
-                for(; out_col_idx * stride - pad_left + kernel_size <= num_features_in + pad_right; ++out_col_idx)
-                {
-                    T sum {};
-                    const int eff_kernel_size = num_features_in - (out_col_idx * stride - pad_left);
-                    for(int in_col_idx = (num_features_in - eff_kernel_size); in_col_idx < num_features_in; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (num_features_in - eff_kernel_size);
-                        for(int in_row_idx = 0; in_row_idx < num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (input[in_col_idx * num_filters_in + in_row_idx]);
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-            }
+            std::copy(input, input + num_features_in * num_filters_in, paddedInput.begin() + pad_left * num_filters_in);
+            windows = paddedInput.data();
         }
+
+        vMatMulAccum(kernelWeights.data(), windows, output, kernel_size * num_filters_in, num_filters_out, num_features_out, stride * num_filters_in);
     }
 
     /**
@@ -148,6 +101,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /** Returns the size of the convolution kernel. */
     RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
 
@@ -165,8 +125,11 @@ private:
     const int pad_left;
     const int pad_right;
 
-    using Matrix = std::vector<std::vector<T>>;
-    std::vector<Matrix> kernelWeights;
+    // column-major, with kernelWeights[kernel_size * num_filters_in][num_filters_out]
+    std::vector<T> kernelWeights;
+
+    // input with pad_left and pad_right columns of zeros (only for "same" padding)
+    std::vector<T> paddedInput;
 };
 
 //====================================================
@@ -192,7 +155,8 @@ class Conv1DStatelessT
     static constexpr int pad_left = Conv1DStateless<T>::computePadLeft(num_features_in_t, kernel_size_t, stride_t, valid_pad_t);
     static constexpr int pad_right = Conv1DStateless<T>::computePadRight(num_features_in_t, kernel_size_t, stride_t, valid_pad_t);
 
-    using weights_type = std::array<std::array<T, kernel_size_t>, num_filters_in_t>;
+    static constexpr int windows_size = kernel_size_t * num_filters_in_t;
+    static constexpr int padded_input_size = (pad_left + num_features_in_t + pad_right) * num_filters_in_t;
 
 public:
     Conv1DStatelessT();
@@ -211,20 +175,7 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<isValid, void>::type
     forward(const T (&inMatrix)[num_features_in_t * num_filters_in_t]) noexcept
     {
-        for(int out_row_idx = 0; out_row_idx < num_filters_out_t; ++out_row_idx)
-        {
-            for(int out_col_idx = 0; out_col_idx < num_features_out; ++out_col_idx)
-            {
-                T sum {};
-                for(int in_col_idx = out_col_idx * stride_t; in_col_idx < out_col_idx * stride_t + kernel_size_t; ++in_col_idx)
-                {
-                    const auto kernel_col_idx = in_col_idx - out_col_idx * stride_t;
-                    for(int in_row_idx = 0; in_row_idx < num_filters_in_t; ++in_row_idx)
-                        sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (inMatrix[in_col_idx * num_filters_in_t + in_row_idx]);
-                }
-                outs[out_col_idx * num_filters_out_t + out_row_idx] += sum;
-            }
-        }
+        vMatMulAccum(kernelWeights, inMatrix, outs, windows_size, num_filters_out_t, num_features_out, stride_t * num_filters_in_t);
     }
 
     /** Performs forward propagation for this layer if pad is "same" */
@@ -232,48 +183,9 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<!isValid, void>::type
     forward(const T (&inMatrix)[num_features_in_t * num_filters_in_t]) noexcept
     {
-        for(int out_row_idx = 0; out_row_idx < num_filters_out_t; ++out_row_idx)
-        {
-            int out_col_idx = 0;
-
-            for(; out_col_idx * stride_t < pad_left; ++out_col_idx)
-            {
-                T sum {};
-                const int eff_kernel_size = kernel_size_t - pad_left + out_col_idx * stride_t;
-                for(int in_col_idx = 0; in_col_idx < eff_kernel_size; ++in_col_idx)
-                {
-                    const auto kernel_col_idx = in_col_idx + (kernel_size_t - eff_kernel_size);
-                    for(int in_row_idx = 0; in_row_idx < num_filters_in_t; ++in_row_idx)
-                        sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (inMatrix[in_col_idx * num_filters_in_t + in_row_idx]);
-                }
-                outs[out_col_idx * num_filters_out_t + out_row_idx] = sum;
-            }
-
-            for(; out_col_idx * stride_t - pad_left + kernel_size_t < num_features_in_t; ++out_col_idx)
-            {
-                T sum {};
-                for(int in_col_idx = out_col_idx * stride_t - pad_left; in_col_idx < out_col_idx * stride_t - pad_left + kernel_size_t; ++in_col_idx)
-                {
-                    const auto kernel_col_idx = in_col_idx - (out_col_idx * stride_t - pad_left);
-                    for(int in_row_idx = 0; in_row_idx < num_filters_in_t; ++in_row_idx)
-                        sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (inMatrix[in_col_idx * num_filters_in_t + in_row_idx]);
-                }
-                outs[out_col_idx * num_filters_out_t + out_row_idx] = sum;
-            }
-
-            for(; out_col_idx * stride_t - pad_left + kernel_size_t <= num_features_in_t + pad_right; ++out_col_idx)
-            {
-                T sum {};
-                const int eff_kernel_size = num_features_in_t - (out_col_idx * stride_t - pad_left);
-                for(int in_col_idx = (num_features_in_t - eff_kernel_size); in_col_idx < num_features_in_t; ++in_col_idx)
-                {
-                    const auto kernel_col_idx = in_col_idx - (num_features_in_t - eff_kernel_size);
-                    for(int in_row_idx = 0; in_row_idx < num_filters_in_t; ++in_row_idx)
-                        sum += kernelWeights[out_row_idx][in_row_idx][kernel_col_idx] * (inMatrix[in_col_idx * num_filters_in_t + in_row_idx]);
-                }
-                outs[out_col_idx * num_filters_out_t + out_row_idx] = sum;
-            }
-        }
+        std::copy(std::begin(inMatrix), std::end(inMatrix), std::begin(paddedInput) + pad_left * num_filters_in_t);
+        std::fill(std::begin(outs), std::end(outs), (T)0);
+        vMatMulAccum(kernelWeights, paddedInput, outs, windows_size, num_filters_out_t, num_features_out, stride_t * num_filters_in_t);
     }
 
     /**
@@ -283,6 +195,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /**
      * Sets the layer weights.
      *
@@ -299,7 +218,11 @@ public:
     T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_out_t * num_features_out] {};
 
 private:
-    weights_type kernelWeights[num_filters_out_t];
+    // column-major, with kernelWeights[kernel_size_t * num_filters_in_t][num_filters_out_t]
+    T kernelWeights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[windows_size * num_filters_out_t];
+
+    // input with pad_left and pad_right columns of zeros (only for "same" padding)
+    T paddedInput alignas(RTNEURAL_DEFAULT_ALIGNMENT)[valid_pad_t ? 1 : padded_input_size] {};
 };
 
 } // RTNEURAL
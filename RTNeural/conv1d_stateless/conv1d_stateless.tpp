@@ -15,13 +15,10 @@ Conv1DStateless<T>::Conv1DStateless(int in_num_filters_in, int in_num_features_i
     , pad_right(computePadRight(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
     , Layer<T>(in_num_filters_in * in_num_features_in, in_num_filters_out * computeNumFeaturesOut(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
 {
-    kernelWeights.resize(num_filters_out);
-    for(auto& kw : kernelWeights)
-    {
-        kw.resize(num_filters_in);
-        for(auto& col : kw)
-            col.resize(kernel_size, (T)0);
-    }
+    kernelWeights.resize((size_t)(kernel_size * num_filters_in * num_filters_out), (T)0);
+
+    if(pad_left + pad_right > 0)
+        paddedInput.resize((size_t)((pad_left + num_features_in + pad_right) * num_filters_in), (T)0);
 }
 
 template <typename T>
@@ -45,10 +42,16 @@ Conv1DStateless<T>& Conv1DStateless<T>::operator=(const Conv1DStateless<T>& othe
 template <typename T>
 void Conv1DStateless<T>::setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights)
 {
-    for(int i = 0; i < num_filters_out; ++i)
+    setFilterWeights(inWeights, 0, num_filters_out);
+}
+
+template <typename T>
+void Conv1DStateless<T>::setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters)
+{
+    for(int i = 0; i < num_filters; ++i)
         for(int k = 0; k < num_filters_in; ++k)
             for(int j = 0; j < kernel_size; ++j)
-                kernelWeights[i][k][j] = inWeights.at(i).at(k).at(j);
+                kernelWeights[(size_t)((j * num_filters_in + k) * num_filters_out + first_filter + i)] = inWeights.at(i).at(k).at(j);
 }
 
 //====================================================
@@ -56,18 +59,22 @@ void Conv1DStateless<T>::setWeights(const std::vector<std::vector<std::vector<T>
 template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
 Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::Conv1DStatelessT()
 {
-    for(int i = 0; i < num_filters_out_t; ++i)
-        for(int k = 0; k < num_filters_in_t; ++k)
-            std::fill(std::begin(kernelWeights[i][k]), std::end(kernelWeights[i][k]), (T)0);
+    std::fill(std::begin(kernelWeights), std::end(kernelWeights), (T)0);
 }
 
 template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
 void Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights)
 {
-    for(int i = 0; i < num_filters_out_t; ++i)
+    setFilterWeights(inWeights, 0, num_filters_out_t);
+}
+
+template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
+void Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters)
+{
+    for(int i = 0; i < num_filters; ++i)
         for(int k = 0; k < num_filters_in_t; ++k)
             for(int j = 0; j < kernel_size_t; ++j)
-                kernelWeights[i][k][j] = inWeights.at(i).at(k).at(j);
+                kernelWeights[(j * num_filters_in_t + k) * num_filters_out_t + first_filter + i] = inWeights.at(i).at(k).at(j);
 }
 
 template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
@@ -76,6 +83,6 @@ void Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t,
     for(int i = 0; i < num_filters_out_t; ++i)
         for(int k = 0; k < num_filters_in_t; ++k)
             for(int j = 0; j < kernel_size_t; ++j)
-                kernelWeights[i][k][j] = inWeights.at(j).at(k).at(i);
+                kernelWeights[(j * num_filters_in_t + k) * num_filters_out_t + i] = inWeights.at(j).at(k).at(i);
 }
 } // RTNEURAL_NAMESPACE
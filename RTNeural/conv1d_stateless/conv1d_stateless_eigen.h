@@ -13,6 +13,12 @@ namespace RTNEURAL_NAMESPACE
  * This implementation was designed to be used for a single frame of features, fully available at each forward call.
  * So the layer has a NO internal "state"
  *
+ * The convolution is computed "im2col"-style, as a single matrix product
+ * between the weights and the sliding windows of the input. Since the
+ * input features are stored contiguously, the windows are mapped in place
+ * (with an outer stride of `stride` columns), and only "same" padding needs
+ * a (zero-padded) copy of the input.
+ *
  * @tparam T Type of the layer (float, double, int ...)
  */
 template <typename T>
@@ -72,40 +78,23 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* output) noexcept override
     {
-        auto inMatrix = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>,
-            RTNeuralEigenAlignment>(input, num_filters_in, num_features_in);
-
         auto outMatrix = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>,
             RTNeuralEigenAlignment>(output, num_filters_out, num_features_out);
 
-        if(valid_pad)
+        const T* windows = input;
+        if(pad_left + pad_right > 0)
         {
-            for(int i = 0; i < num_filters_out; i++)
-                for(int j = 0; j < num_features_out; j++)
-                    outMatrix(i, j) += kernelWeights[i].cwiseProduct(inMatrix.middleCols(j * stride, kernel_size)).sum();
-        }
-        else
-        {
-            for(int i = 0; i < num_filters_out; i++)
-            {
-                int j = 0;
-
-                for(; j * stride < pad_left; j++)
-                {
-                    const int eff_kernel_size = kernel_size - pad_left + j * stride;
-                    outMatrix(i, j) += kernelWeights[i].rightCols(eff_kernel_size).cwiseProduct(inMatrix.leftCols(eff_kernel_size)).sum();
-                }
-
-                for(; j * stride - pad_left + kernel_size < num_features_in; j++)
-                    outMatrix(i, j) += kernelWeights[i].cwiseProduct(inMatrix.middleCols(j * stride - pad_left, kernel_size)).sum();
-
-                for(; j * stride - pad_left + kernel_size <= num_features_in + pad_right; j++)
-                {
-                    const int eff_kernel_size = num_features_in - (j * stride - pad_left);
-                    outMatrix(i, j) += kernelWeights[i].leftCols(eff_kernel_size).cwiseProduct(inMatrix.rightCols(eff_kernel_size)).sum();
-                }
-            }
+            paddedInput.middleCols(pad_left, num_features_in) = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>,
+                RTNeuralEigenAlignment>(input, num_filters_in, num_features_in);
+            windows = paddedInput.data();
         }
+
+        const auto inWindows = Eigen::Map<const Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>, Eigen::Unaligned, Eigen::OuterStride<>>(
+            windows, kernel_size * num_filters_in, num_features_out, Eigen::OuterStride<>(stride * num_filters_in));
+
+        // computed as out^T = windows^T * weights^T, which makes the output
+        // features (rather than the output filters) the rows of the product
+        outMatrix.transpose().noalias() += inWindows.transpose() * kernelWeights.transpose();
     }
 
     /**
@@ -115,6 +104,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /** Returns the size of the convolution kernel. */
     RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
 
@@ -132,7 +128,11 @@ private:
     const int pad_left;
     const int pad_right;
 
-    std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> kernelWeights;
+    // kernelWeights(i, j * num_filters_in + k) = weights[i][k][j]
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> kernelWeights;
+
+    // input with pad_left and pad_right columns of zeros (only for "same" padding)
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> paddedInput;
 };
 
 //====================================================
@@ -158,9 +158,14 @@ class Conv1DStatelessT
     static constexpr int pad_left = Conv1DStateless<T>::computePadLeft(num_features_in_t, kernel_size_t, stride_t, valid_pad_t);
     static constexpr int pad_right = Conv1DStateless<T>::computePadRight(num_features_in_t, kernel_size_t, stride_t, valid_pad_t);
 
-    using weights_type = Eigen::Matrix<T, num_filters_in_t, kernel_size_t>;
+    static constexpr int windows_size = kernel_size_t * num_filters_in_t;
+    static constexpr int padded_num_features = pad_left + num_features_in_t + pad_right;
+
+    using weights_type = Eigen::Matrix<T, num_filters_out_t, windows_size>;
     using input_type = Eigen::Matrix<T, num_filters_in_t, num_features_in_t>;
     using output_type = Eigen::Matrix<T, num_filters_out_t, num_features_out>;
+    using padded_input_type = Eigen::Matrix<T, num_filters_in_t, padded_num_features>;
+    using windows_type = Eigen::Map<const Eigen::Matrix<T, windows_size, num_features_out>, Eigen::Unaligned, Eigen::OuterStride<stride_t * num_filters_in_t>>;
 
 public:
     Conv1DStatelessT();
@@ -179,15 +184,8 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<isValid, void>::type
     forward(const input_type& inMatrix) noexcept
     {
-        // perform a multichannel convolution
-        for(int i = 0; i < num_filters_out_t; i++)
-        {
-            for(int j = 0; j < num_features_out; j++)
-            {
-                // TODO: manage to use middleCols<kernel_size>(j*stride)
-                outs(i, j) = kernelWeights[i].cwiseProduct(inMatrix.middleCols(j * stride_t, kernel_size_t)).sum();
-            }
-        }
+        // computed as out^T = windows^T * weights^T (see Conv1DStateless::forward())
+        outs.transpose().noalias() = windows_type(inMatrix.data()).transpose() * Eigen::Map<const weights_type, RTNeuralEigenAlignment>(kernelWeights).transpose();
     }
 
     /** Performs forward propagation for this layer if pad is "same" */
@@ -195,27 +193,10 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<!isValid, void>::type
     forward(const input_type& inMatrix) noexcept
     {
-        // perform a multichannel convolution
-        for(int i = 0; i < num_filters_out_t; i++)
-        {
-            int j = 0;
-
-            for(; j * stride_t < pad_left; j++)
-            {
-                const int eff_kernel_size = kernel_size_t - pad_left + j * stride_t;
-                outs(i, j) = kernelWeights[i].rightCols(eff_kernel_size).cwiseProduct(inMatrix.leftCols(eff_kernel_size)).sum();
-            }
-
-            for(; j * stride_t - pad_left + kernel_size_t < num_features_in_t; j++)
-                // TODO: manage to use middleCols<kernel_size>(j*stride)
-                outs(i, j) = kernelWeights[i].cwiseProduct(inMatrix.middleCols(j * stride_t - pad_left, kernel_size_t)).sum();
-
-            for(; j * stride_t - pad_left + kernel_size_t <= num_features_in_t + pad_right; j++)
-            {
-                const int eff_kernel_size = num_features_in_t - (j * stride_t - pad_left);
-                outs(i, j) = kernelWeights[i].leftCols(eff_kernel_size).cwiseProduct(inMatrix.rightCols(eff_kernel_size)).sum();
-            }
-        }
+        auto paddedMatrix = Eigen::Map<padded_input_type, RTNeuralEigenAlignment>(paddedInput);
+        paddedMatrix.template middleCols<num_features_in_t>(pad_left) = inMatrix;
+
+        outs.transpose().noalias() = windows_type(paddedInput).transpose() * Eigen::Map<const weights_type, RTNeuralEigenAlignment>(kernelWeights).transpose();
     }
 
     /**
@@ -225,6 +206,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /**
      * Sets the layer weights.
      *
@@ -243,7 +231,11 @@ public:
 private:
     T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_out_t * num_features_out];
 
-    weights_type kernelWeights[num_filters_out_t];
+    // stored as a weights_type matrix, with kernelWeights(i, j * num_filters_in_t + k) = weights[i][k][j]
+    T kernelWeights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_out_t * windows_size];
+
+    // input with pad_left and pad_right columns of zeros (only for "same" padding)
+    T paddedInput alignas(RTNEURAL_DEFAULT_ALIGNMENT)[valid_pad_t ? 1 : num_filters_in_t * padded_num_features] {};
 };
 
 } // RTNEURAL
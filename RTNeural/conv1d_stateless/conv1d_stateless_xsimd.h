@@ -2,6 +2,7 @@
 #define RTNEURAL_CONV1D_STATELESS_XSIMD_H
 
 #include "../Layer.h"
+#include "../common.h"
 #include "../config.h"
 #include <xsimd/xsimd.hpp>
 
@@ -12,6 +13,11 @@ namespace RTNEURAL_NAMESPACE
  * This implementation was designed to be used for a single frame of features, fully available at each forward call.
  * So the layer has a NO internal "state"
  *
+ * The convolution is computed "im2col"-style, as a single matrix product
+ * between the weights and the sliding windows of the input. Since the
+ * input features are stored contiguously, each window is read in place,
+ * and only "same" padding needs a (zero-padded) copy of the input.
+ *
  * @tparam T Type of the layer (float, double, int ...)
  */
 template <typename T>
@@ -71,88 +77,19 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* output) noexcept override
     {
-        if(valid_pad)
-        {
-            for(int out_row_idx = 0; out_row_idx < num_filters_out; ++out_row_idx)
-            {
-                for(int out_col_idx = 0; out_col_idx < num_features_out; ++out_col_idx)
-                {
-                    T sum {};
-                    for(int in_col_idx = out_col_idx * stride; in_col_idx < out_col_idx * stride + kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - out_col_idx * stride;
-                        xsimd::transform(kernelWeights[out_row_idx][kernel_col_idx].begin(),
-                            kernelWeights[out_row_idx][kernel_col_idx].end(),
-                            input + in_col_idx * num_filters_in,
-                            scratch.begin(),
-                            [](auto a, auto b)
-                            { return a * b; });
-                        sum += xsimd::reduce(scratch.begin(), scratch.end(), T {});
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-            }
-        }
-        else
+        const T* windows = input;
+        if(pad_left + pad_right > 0)
         {
-            for(int out_row_idx = 0; out_row_idx < num_filters_out; ++out_row_idx)
-            {
-                int out_col_idx = 0;
-
-                for(; out_col_idx * stride < pad_left; ++out_col_idx)
-                {
-                    T sum {};
-                    const int eff_kernel_size = kernel_size - pad_left + out_col_idx * stride;
-                    for(int in_col_idx = 0; in_col_idx < eff_kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx + (kernel_size - eff_kernel_size);
-                        xsimd::transform(kernelWeights[out_row_idx][kernel_col_idx].begin(),
-                            kernelWeights[out_row_idx][kernel_col_idx].end(),
-                            input + in_col_idx * num_filters_in,
-                            scratch.begin(),
-                            [](auto a, auto b)
-                            { return a * b; });
-                        sum += xsimd::reduce(scratch.begin(), scratch.end(), T {});
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-
-                for(; out_col_idx * stride - pad_left + kernel_size < num_features_in; ++out_col_idx)
-                {
-                    T sum {};
-                    for(int in_col_idx = out_col_idx * stride - pad_left; in_col_idx < out_col_idx * stride - pad_left + kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (out_col_idx * stride - pad_left);
-                        xsimd::transform(kernelWeights[out_row_idx][kernel_col_idx].begin(),
-                            kernelWeights[out_row_idx][kernel_col_idx].end(),
-                            input + in_col_idx * num_filters_in,
-                            scratch.begin(),
-                            [](auto a, auto b)
-                            { return a * b; });
-                        sum += xsimd::reduce(scratch.begin(), scratch.end(), T {});
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-
-                for(; out_col_idx * stride - pad_left + kernel_size <= num_features_in + pad_right; ++out_col_idx)
-                {
-                    T sum {};
-                    const int eff_kernel_size = num_features_in - (out_col_idx * stride - pad_left);
-                    for(int in_col_idx = (num_features_in - eff_kernel_size); in_col_idx < num_features_in; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (num_features_in - eff_kernel_size);
-                        xsimd::transform(kernelWeights[out_row_idx][kernel_col_idx].begin(),
-                            kernelWeights[out_row_idx][kernel_col_idx].end(),
-                            input + in_col_idx * num_filters_in,
-                            scratch.begin(),
-                            [](auto a, auto b)
-                            { return a * b; });
-                        sum += xsimd::reduce(scratch.begin(), scratch.end(), T {});
-                    }
-                    output[out_col_idx * num_filters_out + out_row_idx] += sum;
-                }
-            }
+            std::copy(input, input + num_features_in * num_filters_in, paddedInput.begin() + pad_left * num_filters_in);
+            windows = paddedInput.data();
         }
+
+        std::fill(sums.begin(), sums.end(), (T)0);
+        vMatMulAccum(kernelWeights.data(), windows, sums.data(), kernel_size * num_filters_in, num_filters_out_padded, num_features_out, stride * num_filters_in);
+
+        for(int j = 0; j < num_features_out; ++j)
+            for(int i = 0; i < num_filters_out; ++i)
+                output[j * num_filters_out + i] += sums[(size_t)(j * num_filters_out_padded + i)];
     }
 
     /**
@@ -162,6 +99,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /** Returns the size of the convolution kernel. */
     RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
 
@@ -178,11 +122,16 @@ private:
     const bool valid_pad;
     const int pad_left;
     const int pad_right;
+    const int num_filters_out_padded;
 
-    using Matrix = std::vector<std::vector<T, xsimd::aligned_allocator<T>>>;
-    std::vector<Matrix> kernelWeights;
+    // column-major, with kernelWeights[kernel_size * num_filters_in][num_filters_out_padded]
+    std::vector<T, xsimd::aligned_allocator<T>> kernelWeights;
 
-    std::vector<T, xsimd::aligned_allocator<T>> scratch;
+    // input with pad_left and pad_right columns of zeros (only for "same" padding)
+    std::vector<T> paddedInput;
+
+    // sums[num_features_out][num_filters_out_padded]
+    std::vector<T, xsimd::aligned_allocator<T>> sums;
 };
 
 //====================================================
@@ -215,7 +164,13 @@ class Conv1DStatelessT
     static constexpr auto v_in_size = v_num_filters_in * num_features_in_t;
     static constexpr auto v_out_size = v_num_filters_out * num_features_out;
 
-    using weights_type = std::array<std::array<v_type, v_num_filters_in>, kernel_size_t>;
+    static constexpr int windows_size = kernel_size_t * num_filters_in_t;
+    static constexpr int num_filters_out_padded = v_num_filters_out * v_size;
+
+    // The input filters are padded to a multiple of the SIMD width, so the windows can
+    // only be read in place if there is no padding, either in the filters or the features.
+    static constexpr bool needs_input_copy = num_filters_in_t % v_size != 0 || pad_left + pad_right > 0;
+    static constexpr int padded_input_size = (pad_left + num_features_in_t + pad_right) * num_filters_in_t;
 
 public:
     Conv1DStatelessT();
@@ -229,101 +184,20 @@ public:
     /** Empty function, this layer has no state */
     RTNEURAL_REALTIME void reset() { }
 
-    /** Performs forward propagation for this layer if pad is "valid". */
-    template <bool isValid = valid_pad_t>
-    RTNEURAL_REALTIME inline typename std::enable_if<isValid, void>::type
-    forward(const v_type (&inMatrix)[v_in_size]) noexcept
-    {
-        // @TODO: can we vectorize in the other direction if num_filters == 1?
-        for(int out_col_idx = 0; out_col_idx < num_features_out; ++out_col_idx)
-        {
-            for(int out_row_idx = 0; out_row_idx < v_num_filters_out; ++out_row_idx)
-            {
-                alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_temp[v_size] {};
-                for(int i = 0; i < v_size; ++i)
-                {
-                    v_type sum {};
-                    for(int in_col_idx = out_col_idx * stride_t; in_col_idx < out_col_idx * stride_t + kernel_size_t; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - out_col_idx * stride_t;
-                        for(int in_row_idx = 0; in_row_idx < v_num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx * v_size + i][kernel_col_idx][in_row_idx] * (inMatrix[in_col_idx * v_num_filters_in + in_row_idx]);
-                    }
-                    out_temp[i] = xsimd::reduce_add(sum);
-                }
-                outs[out_col_idx * v_num_filters_out + out_row_idx] += xsimd::load_aligned(out_temp);
-            }
-        }
-    }
-
-    /** Performs forward propagation for this layer if pad is "same" */
-    template <bool isValid = valid_pad_t>
-    RTNEURAL_REALTIME inline typename std::enable_if<!isValid, void>::type
-    forward(const v_type (&inMatrix)[v_in_size]) noexcept
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const v_type (&inMatrix)[v_in_size]) noexcept
     {
-        int out_col_idx = 0;
-
-        for(; out_col_idx * stride_t < pad_left; ++out_col_idx)
-        {
-            for(int out_row_idx = 0; out_row_idx < v_num_filters_out; ++out_row_idx)
-            {
-                alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_temp[v_size] {};
-                for(int i = 0; i < v_size; ++i)
-                {
-                    v_type sum {};
-                    const int eff_kernel_size = kernel_size_t - pad_left + out_col_idx * stride_t;
-                    for(int in_col_idx = 0; in_col_idx < eff_kernel_size; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx + (kernel_size_t - eff_kernel_size);
-                        for(int in_row_idx = 0; in_row_idx < v_num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx * v_size + i][kernel_col_idx][in_row_idx] * (inMatrix[in_col_idx * v_num_filters_in + in_row_idx]);
-                    }
-                    out_temp[i] = xsimd::reduce_add(sum);
-                }
-                outs[out_col_idx * v_num_filters_out + out_row_idx] += xsimd::load_aligned(out_temp);
-            }
-        }
-
-        for(; out_col_idx * stride_t - pad_left + kernel_size_t < num_features_in_t; ++out_col_idx)
+        const T* windows = reinterpret_cast<const T*>(inMatrix);
+        RTNEURAL_IF_CONSTEXPR(needs_input_copy)
         {
-            for(int out_row_idx = 0; out_row_idx < v_num_filters_out; ++out_row_idx)
-            {
-                alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_temp[v_size] {};
-                for(int i = 0; i < v_size; ++i)
-                {
-                    v_type sum {};
-                    for(int in_col_idx = out_col_idx * stride_t - pad_left; in_col_idx < out_col_idx * stride_t - pad_left + kernel_size_t; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (out_col_idx * stride_t - pad_left);
-                        for(int in_row_idx = 0; in_row_idx < v_num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx * v_size + i][kernel_col_idx][in_row_idx] * (inMatrix[in_col_idx * v_num_filters_in + in_row_idx]);
-                    }
-                    out_temp[i] = xsimd::reduce_add(sum);
-                }
-                outs[out_col_idx * v_num_filters_out + out_row_idx] += xsimd::load_aligned(out_temp);
-            }
+            for(int j = 0; j < num_features_in_t; ++j)
+                std::copy(windows + j * v_num_filters_in * v_size,
+                    windows + j * v_num_filters_in * v_size + num_filters_in_t,
+                    paddedInput + (pad_left + j) * num_filters_in_t);
+            windows = paddedInput;
         }
 
-        for(; out_col_idx * stride_t - pad_left + kernel_size_t <= num_features_in_t + pad_right; ++out_col_idx)
-        {
-            for(int out_row_idx = 0; out_row_idx < v_num_filters_out; ++out_row_idx)
-            {
-                alignas(RTNEURAL_DEFAULT_ALIGNMENT) T out_temp[v_size] {};
-                for(int i = 0; i < v_size; ++i)
-                {
-                    v_type sum {};
-                    const int eff_kernel_size = num_features_in_t - (out_col_idx * stride_t - pad_left);
-                    for(int in_col_idx = (num_features_in_t - eff_kernel_size); in_col_idx < num_features_in_t; ++in_col_idx)
-                    {
-                        const auto kernel_col_idx = in_col_idx - (num_features_in_t - eff_kernel_size);
-                        for(int in_row_idx = 0; in_row_idx < v_num_filters_in; ++in_row_idx)
-                            sum += kernelWeights[out_row_idx * v_size + i][kernel_col_idx][in_row_idx] * (inMatrix[in_col_idx * v_num_filters_in + in_row_idx]);
-                    }
-                    out_temp[i] = xsimd::reduce_add(sum);
-                }
-                outs[out_col_idx * v_num_filters_out + out_row_idx] += xsimd::load_aligned(out_temp);
-            }
-        }
+        vMatMulAccum(kernelWeights, windows, reinterpret_cast<T*>(outs), windows_size, num_filters_out_padded, num_features_out, stride_t * num_filters_in_t);
     }
 
     /**
@@ -333,6 +207,13 @@ public:
      */
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights);
 
+    /**
+     * Sets the weights of `num_filters` output filters, starting from `first_filter`.
+     *
+     * The weights vector must have size weights[num_filters][num_filters_in][kernel_size]
+     */
+    RTNEURAL_REALTIME void setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters);
+
     /** Returns the size of the convolution kernel. */
     RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size_t; }
 
@@ -342,7 +223,11 @@ public:
     v_type outs[v_out_size];
 
 private:
-    weights_type kernelWeights[num_filters_out_t];
+    // column-major, with kernelWeights[kernel_size_t * num_filters_in_t][num_filters_out_padded]
+    T kernelWeights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[windows_size * num_filters_out_padded];
+
+    // input without the SIMD padding, and with pad_left and pad_right columns of zeros
+    T paddedInput[needs_input_copy ? padded_input_size : 1] {};
 };
 
 } // RTNEURAL
@@ -13,17 +13,15 @@ Conv1DStateless<T>::Conv1DStateless(int in_num_filters_in, int in_num_features_i
     , num_features_out(computeNumFeaturesOut(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
     , pad_left(computePadLeft(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
     , pad_right(computePadRight(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
+    , num_filters_out_padded(simd_padded_size<T>(in_num_filters_out))
     , Layer<T>(in_num_filters_in * in_num_features_in, in_num_filters_out * computeNumFeaturesOut(in_num_features_in, in_kernel_size, in_stride, in_valid_pad))
 {
-    kernelWeights.resize(num_filters_out);
-    for(auto& kw : kernelWeights)
-    {
-        kw.resize(kernel_size);
-        for(auto& col : kw)
-            col.resize(num_filters_in, (T)0);
-    }
+    kernelWeights.resize((size_t)(kernel_size * num_filters_in * num_filters_out_padded), (T)0);
 
-    scratch.resize(num_filters_in, (T)0);
+    if(pad_left + pad_right > 0)
+        paddedInput.resize((size_t)((pad_left + num_features_in + pad_right) * num_filters_in), (T)0);
+
+    sums.resize((size_t)(num_features_out * num_filters_out_padded), (T)0);
 }
 
 template <typename T>
@@ -47,10 +45,16 @@ Conv1DStateless<T>& Conv1DStateless<T>::operator=(const Conv1DStateless<T>& othe
 template <typename T>
 void Conv1DStateless<T>::setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights)
 {
-    for(int i = 0; i < num_filters_out; ++i)
+    setFilterWeights(inWeights, 0, num_filters_out);
+}
+
+template <typename T>
+void Conv1DStateless<T>::setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters)
+{
+    for(int i = 0; i < num_filters; ++i)
         for(int k = 0; k < num_filters_in; ++k)
             for(int j = 0; j < kernel_size; ++j)
-                kernelWeights[i][j][k] = inWeights.at(i).at(k).at(j);
+                kernelWeights[(size_t)((j * num_filters_in + k) * num_filters_out_padded + first_filter + i)] = inWeights.at(i).at(k).at(j);
 }
 
 //====================================================
@@ -58,17 +62,21 @@ void Conv1DStateless<T>::setWeights(const std::vector<std::vector<std::vector<T>
 template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
 Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::Conv1DStatelessT()
 {
-    for(int i = 0; i < num_filters_out_t; ++i)
-        for(int k = 0; k < num_filters_in_t; ++k)
-            std::fill(std::begin(kernelWeights[i][k]), std::end(kernelWeights[i][k]), (T)0);
+    std::fill(std::begin(kernelWeights), std::end(kernelWeights), (T)0);
 }
 
 template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
 void Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::setWeights(const std::vector<std::vector<std::vector<T>>>& inWeights)
 {
-    for(int i = 0; i < num_filters_out_t; ++i)
+    setFilterWeights(inWeights, 0, num_filters_out_t);
+}
+
+template <typename T, int num_filters_in_t, int num_features_in_t, int num_filters_out_t, int kernel_size_t, int stride_t, bool valid_pad_t>
+void Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_t, stride_t, valid_pad_t>::setFilterWeights(const std::vector<std::vector<std::vector<T>>>& inWeights, int first_filter, int num_filters)
+{
+    for(int i = 0; i < num_filters; ++i)
         for(int k = 0; k < num_filters_in_t; ++k)
             for(int j = 0; j < kernel_size_t; ++j)
-                kernelWeights[i][j][k / v_size] = set_value(kernelWeights[i][j][k / v_size], k % v_size, inWeights.at(i).at(k).at(j));
+                kernelWeights[(j * num_filters_in_t + k) * num_filters_out_padded + first_filter + i] = inWeights.at(i).at(k).at(j);
 }
 } // RTNEURAL_NAMESPACE
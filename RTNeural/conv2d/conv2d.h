@@ -9,14 +9,18 @@
 #include "conv2d_xsimd.tpp"
 #else
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../common.h"
 #include "../config.h"
 #include "../conv1d_stateless/conv1d_stateless.h"
+#include <memory>
 
 namespace RTNEURAL_NAMESPACE
 {
 /**
- * Dynamic implementation of a 2-dimensional convolution layer with no activation.
+ * Dynamic implementation of a 2-dimensional convolution layer,
+ * with an optional fused activation (see setActivation()).
  *
  * @tparam T Type of the layer (float, double, int ...)
  */
@@ -60,23 +64,41 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* output) noexcept override
     {
-        for(int i = 0; i < kernel_size_time; ++i)
+        // one feature-axis convolution computes every time tap of this frame
+        std::fill(tapOutputs.begin(), tapOutputs.end(), (T)0);
+        featureConv.forward(input, tapOutputs.data());
+
+        const auto num_taps_out = kernel_size_time * num_filters_out;
+        for(int i = 0; i < kernel_size_time - 1; ++i)
         {
-            int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
+            const int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
+            auto* stateFrame = state[state_idx_to_use].data();
 
-            conv1dLayers[i].forward(input, state[state_idx_to_use].data());
+            for(int j = 0; j < num_features_out; ++j)
+            {
+                const auto* tapCol = tapOutputs.data() + j * num_taps_out + i * num_filters_out;
+                auto* stateCol = stateFrame + j * num_filters_out;
+                for(int k = 0; k < num_filters_out; ++k)
+                    stateCol[k] += tapCol[k];
+            }
         }
 
-        for(int i = 0; i < num_features_out; ++i)
+        // the last tap is applied to the current frame
+        const auto* lastTap = tapOutputs.data() + (kernel_size_time - 1) * num_filters_out;
+        const auto* stateFrame = state[state_index].data();
+        for(int j = 0; j < num_features_out; ++j)
         {
-            for(int j = 0; j < num_filters_out; ++j)
+            for(int k = 0; k < num_filters_out; ++k)
             {
-                output[i * num_filters_out + j] = state[state_index][i * num_filters_out + j] + bias[j];
+                output[j * num_filters_out + k] = stateFrame[j * num_filters_out + k] + lastTap[j * num_taps_out + k] + bias[k];
             }
         }
 
         std::fill(state[state_index].begin(), state[state_index].end(), (T)0);
         state_index = state_index == receptive_field - 1 ? 0 : state_index + 1;
+
+        if(activation != nullptr)
+            activation->forward(output, output);
     }
 
     /**
@@ -105,6 +127,16 @@ public:
     /** Returns the convolution dilation rate (time axis) */
     RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate; }
 
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
     const int num_filters_in;
     const int num_features_in;
     const int num_filters_out;
@@ -117,19 +149,24 @@ public:
     const bool valid_pad;
 
 private:
-    std::vector<Conv1DStateless<T>> conv1dLayers;
+    // the time taps stacked along the filter axis: filter (i * num_filters_out + k) is tap i of filter k
+    Conv1DStateless<T> featureConv;
+    std::vector<T> tapOutputs;
 
     std::vector<std::vector<T>> state;
 
     int state_index = 0;
 
     std::vector<T> bias;
+
+    std::unique_ptr<Activation<T>> activation;
 };
 
 //====================================================
 
 /**
- * Static implementation of a 2-dimensional convolution layer with no activation.
+ * Static implementation of a 2-dimensional convolution layer,
+ * with an optional fused activation (see fused_activation).
  *
  * @tparam T Type of the layer (float, double, int ...)
  * @tparam num_filters_in_t number of input filters (channels)
@@ -140,9 +177,10 @@ private:
  * @tparam dilation_rate_t dilation_rate (time axis)
  * @tparam stride_t convolution stride (feature axis)
  * @tparam valid_pad_t if true: pad is "valid". if false: pad is "same"
+ * @tparam FusedActivation an activation to apply to the layer outputs
  */
 template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t,
-    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
+    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation = fused_activation::Identity>
 class Conv2DT
 {
 public:
@@ -162,6 +200,11 @@ public:
     static constexpr int dilation_rate = dilation_rate_t;
     static constexpr int stride = stride_t;
     static constexpr bool valid_pad = valid_pad_t;
+    using activation_type = FusedActivation;
+
+    static_assert(fused_activation::prelu_num_features<FusedActivation>::value == 0
+            || fused_activation::prelu_num_features<FusedActivation>::value == num_features_out,
+        "A fused PReLU activation must be declared as PReLU<T, out_size, num_features_out>");
 
     Conv2DT();
 
@@ -185,22 +228,31 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T (&ins)[in_size]) noexcept
     {
-        for(int i = 0; i < kernel_size_time; ++i)
-        {
-            int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
+        // one feature-axis convolution computes every time tap of this frame
+        std::fill(std::begin(featureConv.outs), std::end(featureConv.outs), (T)0);
+        featureConv.forward(ins);
 
-            std::fill(std::begin(conv1dLayers[i].outs), std::end(conv1dLayers[i].outs), (T)0);
-            conv1dLayers[i].forward(ins);
+        for(int i = 0; i < kernel_size_time - 1; ++i)
+        {
+            const int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
+            auto& stateFrame = state[state_idx_to_use];
 
-            for(int j = 0; j < state[state_idx_to_use].size(); ++j)
-                state[state_idx_to_use][j] += conv1dLayers[i].outs[j];
+            for(int j = 0; j < num_features_out; ++j)
+            {
+                for(int k = 0; k < num_filters_out; ++k)
+                    stateFrame[j * num_filters_out + k] += featureConv.outs[j * num_taps_out + i * num_filters_out + k];
+            }
         }
 
-        for(int i = 0; i < num_features_out; ++i)
+        // the last tap is applied to the current frame
+        constexpr auto last_tap_offset = (kernel_size_time - 1) * num_filters_out;
+        for(int j = 0; j < num_features_out; ++j)
         {
-            for(int j = 0; j < num_filters_out; ++j)
+            for(int k = 0; k < num_filters_out; ++k)
             {
-                outs[i * num_filters_out + j] = state[state_index][i * num_filters_out + j] + bias[j];
+                outs[j * num_filters_out + k] = activation(state[state_index][j * num_filters_out + k]
+                        + featureConv.outs[j * num_taps_out + last_tap_offset + k] + bias[k],
+                    j * num_filters_out + k);
             }
         }
 
@@ -234,18 +286,24 @@ public:
     /** Returns the convolution dilation rate */
     RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate_t; }
 
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_out_t * num_features_out];
 
 private:
-    std::array<Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_feature_t, stride_t, valid_pad_t>,
-        kernel_size_time_t>
-        conv1dLayers;
+    static constexpr int num_taps_out = kernel_size_time_t * num_filters_out_t;
+
+    // the time taps stacked along the filter axis: filter (i * num_filters_out + k) is tap i of filter k
+    Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_taps_out, kernel_size_feature_t, stride_t, valid_pad_t> featureConv;
 
     std::array<output_type, receptive_field> state;
 
     int state_index = 0;
 
     alignas(RTNEURAL_DEFAULT_ALIGNMENT) bias_type bias;
+
+    FusedActivation activation;
 };
 
 } // RTNEURAL
@@ -2,15 +2,19 @@
 #define CONV2D_EIGEN_H_INCLUDED
 
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../common.h"
 #include "../config.h"
 #include "../conv1d_stateless/conv1d_stateless.h"
 #include <Eigen/Dense>
+#include <memory>
 
 namespace RTNEURAL_NAMESPACE
 {
 /**
- * Dynamic implementation of a 2-dimensional convolution layer with no activation.
+ * Dynamic implementation of a 2-dimensional convolution layer,
+ * with an optional fused activation (see setActivation()).
  *
  * @tparam T Type of the layer (float, double, int ...)
  */
@@ -60,17 +64,25 @@ public:
         auto outMatrix = Eigen::Map<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>,
             RTNeuralEigenAlignment>(output, num_filters_out, num_features_out);
 
-        for(int i = 0; i < kernel_size_time; i++)
+        // one feature-axis convolution computes every time tap of this frame
+        tapOutputs.setZero();
+        featureConv.forward(inMatrix.data(), tapOutputs.data());
+
+        for(int i = 0; i < kernel_size_time - 1; i++)
         {
             int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
 
-            conv1dLayers[i].forward(inMatrix.data(), state[state_idx_to_use].data());
+            state[state_idx_to_use].noalias() += tapOutputs.middleRows(i * num_filters_out, num_filters_out);
         }
 
-        outMatrix = state[state_index].colwise() + bias;
+        // the last tap is applied to the current frame
+        outMatrix = (state[state_index] + tapOutputs.bottomRows(num_filters_out)).colwise() + bias;
 
         state[state_index].setZero();
         state_index = state_index == receptive_field - 1 ? 0 : state_index + 1;
+
+        if(activation != nullptr)
+            activation->forward(output, output);
     }
 
     /**
@@ -99,6 +111,16 @@ public:
     /** Returns the convolution dilation rate (time axis) */
     RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate; }
 
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
     const int num_filters_in;
     const int num_features_in;
     const int num_filters_out;
@@ -111,19 +133,24 @@ public:
     const bool valid_pad;
 
 private:
-    std::vector<Conv1DStateless<T>> conv1dLayers;
+    // the time taps stacked along the filter axis: filter (i * num_filters_out + k) is tap i of filter k
+    Conv1DStateless<T> featureConv;
+    Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> tapOutputs;
 
     std::vector<Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>> state;
 
     int state_index = 0;
 
     Eigen::Vector<T, Eigen::Dynamic> bias;
+
+    std::unique_ptr<Activation<T>> activation;
 };
 
 //====================================================
 
 /**
- * Static implementation of a 2-dimensional convolution layer with no activation.
+ * Static implementation of a 2-dimensional convolution layer,
+ * with an optional fused activation (see fused_activation).
  *
  * @tparam T Type of the layer (float, double, int ...)
  * @tparam num_filters_in_t number of input filters (channels)
@@ -134,9 +161,10 @@ private:
  * @tparam dilation_rate_t dilation_rate (time axis)
  * @tparam stride_t convolution stride (feature axis)
  * @tparam valid_pad_t if true: pad is "valid". if false: pad is "same"
+ * @tparam FusedActivation an activation to apply to the layer outputs
  */
 template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t,
-    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
+    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation = fused_activation::Identity>
 class Conv2DT
 {
 public:
@@ -159,6 +187,11 @@ public:
     static constexpr int dilation_rate = dilation_rate_t;
     static constexpr int stride = stride_t;
     static constexpr bool valid_pad = valid_pad_t;
+    using activation_type = FusedActivation;
+
+    static_assert(fused_activation::prelu_num_features<FusedActivation>::value == 0
+            || fused_activation::prelu_num_features<FusedActivation>::value == num_features_out,
+        "A fused PReLU activation must be declared as PReLU<T, out_size, num_features_out>");
 
     Conv2DT();
 
@@ -185,16 +218,19 @@ public:
         const auto inMatrixReshaped = Eigen::Map<const input_type, RTNeuralEigenAlignment>(inMatrix.data());
         auto outMatrix = Eigen::Map<output_type, RTNeuralEigenAlignment>(outs.data());
 
-        for(int i = 0; i < kernel_size_time_t; i++)
+        // one feature-axis convolution computes every time tap of this frame
+        featureConv.forward(inMatrixReshaped);
+
+        for(int i = 0; i < kernel_size_time_t - 1; i++)
         {
             int state_idx_to_use = (state_index + (receptive_field - 1) - i * dilation_rate) % receptive_field;
 
-            conv1dLayers[i].forward(inMatrixReshaped);
-
-            state[state_idx_to_use] += Eigen::Map<output_type, RTNeuralEigenAlignment>(conv1dLayers[i].outs);
+            state[state_idx_to_use] += featureConv.outs.template middleRows<num_filters_out_t>(i * num_filters_out_t);
         }
 
-        outMatrix = state[state_index].colwise() + bias;
+        // the last tap is applied to the current frame
+        outMatrix = (state[state_index] + featureConv.outs.template bottomRows<num_filters_out_t>()).colwise() + bias;
+        activation.apply(outs);
 
         state[state_index].setZero();
         state_index = state_index == receptive_field - 1 ? 0 : state_index + 1;
@@ -226,20 +262,24 @@ public:
     /** Returns the convolution dilation rate */
     RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate_t; }
 
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     Eigen::Map<output_type_flat, RTNeuralEigenAlignment> outs;
 
 private:
     T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_out_t * num_features_out];
 
-    std::array<Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, num_filters_out_t, kernel_size_feature_t, stride_t, valid_pad_t>,
-        kernel_size_time_t>
-        conv1dLayers;
+    // the time taps stacked along the filter axis: filter (i * num_filters_out + k) is tap i of filter k
+    Conv1DStatelessT<T, num_filters_in_t, num_features_in_t, kernel_size_time_t * num_filters_out_t, kernel_size_feature_t, stride_t, valid_pad_t> featureConv;
 
     std::array<output_type, receptive_field> state;
 
     int state_index = 0;
 
     bias_type bias;
+
+    FusedActivation activation;
 };
 
 } // RTNEURAL
@@ -15,9 +15,10 @@ Conv2D<T>::Conv2D(int in_num_filters_in, int in_num_filters_out, int in_num_feat
     , num_features_out(Conv1DStateless<T>::computeNumFeaturesOut(in_num_features_in, in_kernel_size_feature, in_stride, in_valid_pad))
     , receptive_field(1 + (in_kernel_size_time - 1) * in_dilation_rate) // See "Dilated (atrous) convolution" note here: https://distill.pub/2019/computing-receptive-fields/
     , valid_pad(in_valid_pad)
+    , featureConv(in_num_filters_in, in_num_features_in, in_kernel_size_time * in_num_filters_out, in_kernel_size_feature, in_stride, in_valid_pad)
     , Layer<T>(in_num_features_in * in_num_filters_in, Conv1DStateless<T>::computeNumFeaturesOut(in_num_features_in, in_kernel_size_feature, in_stride, in_valid_pad) * in_num_filters_out)
 {
-    conv1dLayers.resize(kernel_size_time, Conv1DStateless<T>(num_filters_in, num_features_in, num_filters_out, kernel_size_feature, stride, valid_pad));
+    tapOutputs = Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(kernel_size_time * num_filters_out, num_features_out);
     bias = Eigen::Vector<T, Eigen::Dynamic>::Zero(num_filters_out);
 
     state.resize(receptive_field, Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic>::Zero(num_filters_out, num_features_out));
@@ -46,10 +47,9 @@ Conv2D<T>& Conv2D<T>::operator=(const Conv2D& other)
 template <typename T>
 void Conv2D<T>::setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& inWeights)
 {
+    // stack the time taps along the filter axis
     for(int i = 0; i < kernel_size_time; i++)
-    {
-        conv1dLayers[i].setWeights(inWeights[i]);
-    }
+        featureConv.setFilterWeights(inWeights[i], i * num_filters_out, num_filters_out);
 }
 
 template <typename T>
@@ -61,27 +61,26 @@ void Conv2D<T>::setBias(const std::vector<T>& inBias)
     }
 }
 
-template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t, int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
-Conv2DT<T, num_filters_in_t, num_filters_out_t, num_features_in_t, kernel_size_time_t, kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t>::Conv2DT()
+template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t, int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation>
+Conv2DT<T, num_filters_in_t, num_filters_out_t, num_features_in_t, kernel_size_time_t, kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t, FusedActivation>::Conv2DT()
     : outs(outs_internal)
 {
 }
 
 template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t,
-    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
+    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation>
 void Conv2DT<T, num_filters_in_t, num_filters_out_t, num_features_in_t, kernel_size_time_t, kernel_size_feature_t,
-    dilation_rate_t, stride_t, valid_pad_t>::setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& inWeights)
+    dilation_rate_t, stride_t, valid_pad_t, FusedActivation>::setWeights(const std::vector<std::vector<std::vector<std::vector<T>>>>& inWeights)
 {
+    // stack the time taps along the filter axis
     for(int i = 0; i < kernel_size_time_t; i++)
-    {
-        conv1dLayers[i].setWeights(inWeights[i]);
-    }
+        featureConv.setFilterWeights(inWeights[i], i * num_filters_out_t, num_filters_out_t);
 }
 
 template <typename T, int num_filters_in_t, int num_filters_out_t, int num_features_in_t, int kernel_size_time_t,
-    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t>
+    int kernel_size_feature_t, int dilation_rate_t, int stride_t, bool valid_pad_t, typename FusedActivation>
 void Conv2DT<T, num_filters_in_t, num_filters_out_t, num_features_in_t, kernel_size_time_t,
-    kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t>::setBias(const std::vector<T>& inBias)
+    kernel_size_feature_t, dilation_rate_t, stride_t, valid_pad_t, FusedActivation>::setBias(const std::vector<T>& inBias)
 {
     for(int i = 0; i < num_filters_out_t; i++)
     {
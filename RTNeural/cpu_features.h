@@ -0,0 +1,150 @@
+#pragma once
+
+#include "config.h"
+#include <initializer_list>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <immintrin.h>
+#include <intrin.h>
+#define RTNEURAL_X86_MSVC 1
+#elif defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RTNEURAL_X86_GNUC 1
+#endif
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/** The SIMD instruction sets supported by the host CPU, as detected at runtime. */
+struct CPUFeatures
+{
+    bool sse4_1 = false;
+    bool avx2 = false; // AVX2 and FMA
+    bool avx512 = false; // AVX-512 F, BW, DQ, and VL
+};
+
+/** Detects the SIMD instruction sets supported by the host CPU (and operating system). */
+inline CPUFeatures getCPUFeatures() noexcept
+{
+    CPUFeatures features;
+
+#if RTNEURAL_X86_GNUC
+    __builtin_cpu_init();
+    features.sse4_1 = __builtin_cpu_supports("sse4.1");
+    features.avx2 = __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+    features.avx512 = __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512bw")
+        && __builtin_cpu_supports("avx512dq") && __builtin_cpu_supports("avx512vl");
+#elif RTNEURAL_X86_MSVC
+    int regs[4] {};
+    __cpuid(regs, 0);
+    const auto max_leaf = regs[0];
+
+    __cpuid(regs, 1);
+    const auto ecx1 = regs[2];
+    features.sse4_1 = (ecx1 & (1 << 19)) != 0;
+
+    // the OS must save the AVX (and AVX-512) registers on context switches
+    const bool os_xsave = (ecx1 & (1 << 27)) != 0;
+    const auto xcr0 = os_xsave ? _xgetbv(0) : 0;
+    const bool os_avx = (xcr0 & 0x6) == 0x6;
+    const bool os_avx512 = (xcr0 & 0xe6) == 0xe6;
+
+    if(max_leaf >= 7)
+    {
+        __cpuidex(regs, 7, 0);
+        const auto ebx7 = regs[1];
+        features.avx2 = os_avx && (ebx7 & (1 << 5)) != 0 && (ecx1 & (1 << 12)) != 0;
+        features.avx512 = os_avx512 && (ebx7 & (1 << 16)) != 0 // F
+            && (ebx7 & (1 << 17)) != 0 // DQ
+            && (ebx7 & (1 << 30)) != 0 // BW
+            && (ebx7 & (1 << 31)) != 0; // VL
+    }
+#endif
+
+    return features;
+}
+
+/** The SIMD instruction sets that RTNeural can be compiled for. */
+enum class SIMDArch
+{
+    Default, // the compiler's default instruction set (e.g. SSE2 on x86-64)
+    SSE4_1,
+    AVX2, // AVX2 and FMA
+    AVX512, // AVX-512 F, BW, DQ, and VL
+};
+
+/** Returns the name of the given SIMD instruction set. */
+constexpr const char* getArchName(SIMDArch arch) noexcept
+{
+    return arch == SIMDArch::AVX512 ? "AVX-512"
+        : arch == SIMDArch::AVX2   ? "AVX2"
+        : arch == SIMDArch::SSE4_1 ? "SSE4.1"
+                                   : "default";
+}
+
+/** Returns the SIMD instruction set that RTNeural was compiled for. */
+constexpr SIMDArch getCompiledArch() noexcept
+{
+#if RTNEURAL_AVX512_ENABLED
+    return SIMDArch::AVX512;
+#elif RTNEURAL_AVX_ENABLED
+    return SIMDArch::AVX2;
+#elif RTNEURAL_SSE4_1_ENABLED
+    return SIMDArch::SSE4_1;
+#else
+    return SIMDArch::Default;
+#endif
+}
+
+/** Returns the name of the SIMD instruction set that RTNeural was compiled for. */
+constexpr const char* getCompiledArchName() noexcept
+{
+    return getArchName(getCompiledArch());
+}
+
+/** Returns true if the host CPU supports the given SIMD instruction set. */
+inline bool isArchSupported(SIMDArch arch, const CPUFeatures& features = getCPUFeatures()) noexcept
+{
+    switch(arch)
+    {
+    case SIMDArch::AVX512:
+        return features.avx512;
+    case SIMDArch::AVX2:
+        return features.avx2;
+    case SIMDArch::SSE4_1:
+        return features.sse4_1;
+    default:
+        return true;
+    }
+}
+
+/**
+ * Returns the fastest SIMD instruction set supported by the host CPU.
+ *
+ * When RTNeural is built with RTNEURAL_RUNTIME_DISPATCH, this can be used
+ * to choose which of the compiled code paths to use (see README.md).
+ */
+inline SIMDArch getBestSupportedArch(const CPUFeatures& features = getCPUFeatures()) noexcept
+{
+    for(auto arch : { SIMDArch::AVX512, SIMDArch::AVX2, SIMDArch::SSE4_1 })
+    {
+        if(isArchSupported(arch, features))
+            return arch;
+    }
+
+    return SIMDArch::Default;
+}
+
+/**
+ * Returns true if the host CPU supports the SIMD instruction set that
+ * RTNeural was compiled for (see RTNEURAL_USE_AVX and RTNEURAL_USE_AVX512).
+ *
+ * Running RTNeural code compiled for an unsupported instruction set will
+ * crash with an illegal instruction, so applications (and tests) can use
+ * this check to fall back to a different code path.
+ */
+inline bool isCompiledArchSupported() noexcept
+{
+    return isArchSupported(getCompiledArch());
+}
+
+} // namespace RTNEURAL_NAMESPACE
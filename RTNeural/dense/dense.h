@@ -11,7 +11,10 @@
 #include "dense_xsimd.h"
 #else
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../config.h"
+#include <memory>
 
 namespace RTNEURAL_NAMESPACE
 {
@@ -57,7 +60,7 @@ private:
 
 /**
  * Dynamic implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  */
 template <typename T>
 class Dense final : public Layer<T>
@@ -105,6 +108,21 @@ public:
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
             out[i] = subLayers[i]->forward(input);
+
+        if(activation != nullptr)
+            activation->forward(out, out);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+            forward(input + n * Layer<T>::in_size, output + n * Layer<T>::out_size);
     }
 
     /**
@@ -150,16 +168,30 @@ public:
     /** Returns the bias value at the given index. */
     RTNEURAL_REALTIME T getBias(int i) const noexcept { return subLayers[i]->getBias(); }
 
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
 private:
     Dense1<T>** subLayers;
+    std::unique_ptr<Activation<T>> activation;
 };
 
 //====================================================
 /**
  * Static implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see fused_activation).
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
-template <typename T, int in_sizet, int out_sizet, bool has_bias = true>
+template <typename T, int in_sizet, int out_sizet, bool has_bias = true, typename FusedActivation = fused_activation::Identity, bool block_sparse = false>
 class DenseT
 {
     static constexpr auto weights_size = in_sizet * out_sizet;
@@ -168,6 +200,7 @@ public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
     static constexpr bool dense_has_bias = has_bias;
+    using activation_type = FusedActivation;
 
     DenseT()
     {
@@ -195,7 +228,7 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<b>::type forward(const T (&ins)[in_size]) noexcept
     {
         for(int i = 0; i < out_size; ++i)
-            outs[i] = std::inner_product(ins, ins + in_size, &weights[i * in_size], bias[i]);
+            outs[i] = activation(std::inner_product(ins, ins + in_size, &weights[i * in_size], bias[i]), i);
     }
 
     /** Performs forward propagation for this layer (no bias). */
@@ -203,7 +236,7 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<!b>::type forward(const T (&ins)[in_size]) noexcept
     {
         for(int i = 0; i < out_size; ++i)
-            outs[i] = std::inner_product(ins, ins + in_size, &weights[i * in_size], (T)0);
+            outs[i] = activation(std::inner_product(ins, ins + in_size, &weights[i * in_size], (T)0), i);
     }
 
     /**
@@ -252,11 +285,16 @@ public:
             bias[i] = b[i];
     }
 
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
 
 private:
     T bias[out_size];
     T weights[weights_size];
+
+    FusedActivation activation;
 };
 
 } // namespace RTNEURAL_NAMESPACE
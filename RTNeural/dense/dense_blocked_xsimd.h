@@ -0,0 +1,242 @@
+#ifndef DENSEBLOCKEDXSIMD_H_INCLUDED
+#define DENSEBLOCKEDXSIMD_H_INCLUDED
+
+#include "../common.h"
+#include "../config.h"
+#include <algorithm>
+#include <vector>
+#include <xsimd/xsimd.hpp>
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ * Cache-blocked matrix-vector (GEMV) and small-batch matrix-matrix (GEMM)
+ * products, used internally by large Dense layers.
+ *
+ * The weights are packed into panels of `panel_width` output rows. Each panel
+ * stores the weights for every input contiguously (panel[in_size][panel_width]),
+ * so that a panel can be streamed linearly from memory, while the output
+ * accumulators for the panel stay in registers.
+ *
+ * For the GEMM path, the panels are further split into blocks of `k_block`
+ * inputs, so that each block of weights stays in the L1 cache while it is
+ * re-used for a batch of up to `max_batch_block` input frames.
+ */
+template <typename T>
+class BlockedGemv
+{
+    using b_type = xsimd::simd_type<T>;
+    using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
+    static constexpr auto inc = (int)b_type::size;
+
+public:
+    /** Number of output rows in each packed panel (4 SIMD registers). */
+    static constexpr int panel_width = 4 * inc;
+
+    /** Number of inputs in each cache block of a panel. */
+    static constexpr int k_block = 128;
+
+    /** Maximum number of frames processed together by the GEMM kernel. */
+    static constexpr int max_batch_block = 8;
+
+    BlockedGemv(int in_size, int out_size)
+        : in_size(in_size)
+        , out_size(out_size)
+        , num_panels(ceil_div(out_size, panel_width))
+    {
+        panels.resize((size_t)num_panels * in_size * panel_width, (T)0);
+        bias.resize((size_t)num_panels * panel_width, (T)0);
+    }
+
+    /** Sets the weight connecting input k to output i. */
+    void setWeight(int i, int k, T value) noexcept { panels[weightIndex(i, k)] = value; }
+
+    /** Returns the weight connecting input k to output i. */
+    T getWeight(int i, int k) const noexcept { return panels[weightIndex(i, k)]; }
+
+    /** Sets the bias for output i. */
+    void setBias(int i, T value) noexcept { bias[i] = value; }
+
+    /** Returns the bias for output i. */
+    T getBias(int i) const noexcept { return bias[i]; }
+
+    /** Computes out[out_size] = weights * input[in_size] + bias. */
+    inline void gemv(const T* input, T* out) const noexcept
+    {
+        T acc_buffer alignas(RTNEURAL_DEFAULT_ALIGNMENT)[panel_width];
+
+        for(int p = 0; p < num_panels; ++p)
+        {
+            const T* panel = &panels[(size_t)p * in_size * panel_width];
+            const T* panel_bias = &bias[p * panel_width];
+
+            auto acc0 = xsimd::load_aligned(panel_bias);
+            auto acc1 = xsimd::load_aligned(panel_bias + inc);
+            auto acc2 = xsimd::load_aligned(panel_bias + 2 * inc);
+            auto acc3 = xsimd::load_aligned(panel_bias + 3 * inc);
+
+            const T* row = panel;
+            for(int k = 0; k < in_size; ++k, row += panel_width)
+            {
+                prefetch(row + prefetch_distance * panel_width);
+
+                const auto x_vec = b_type(input[k]);
+                acc0 = xsimd::fma(xsimd::load_aligned(row), x_vec, acc0);
+                acc1 = xsimd::fma(xsimd::load_aligned(row + inc), x_vec, acc1);
+                acc2 = xsimd::fma(xsimd::load_aligned(row + 2 * inc), x_vec, acc2);
+                acc3 = xsimd::fma(xsimd::load_aligned(row + 3 * inc), x_vec, acc3);
+            }
+
+            xsimd::store_aligned(acc_buffer, acc0);
+            xsimd::store_aligned(acc_buffer + inc, acc1);
+            xsimd::store_aligned(acc_buffer + 2 * inc, acc2);
+            xsimd::store_aligned(acc_buffer + 3 * inc, acc3);
+            storePanel(acc_buffer, out, p);
+        }
+    }
+
+    /**
+     * Computes out[num_frames][out_size] = weights * input[num_frames][in_size] + bias,
+     * for each of the input frames.
+     */
+    inline void gemm(const T* input, T* out, int num_frames) const noexcept
+    {
+        T acc_buffer alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_batch_block][panel_width];
+
+        for(int f0 = 0; f0 < num_frames; f0 += max_batch_block)
+        {
+            const auto batch_size = std::min((int)max_batch_block, num_frames - f0);
+            const T* batch_input = input + (size_t)f0 * in_size;
+            T* batch_out = out + (size_t)f0 * out_size;
+
+            for(int p = 0; p < num_panels; ++p)
+            {
+                const T* panel = &panels[(size_t)p * in_size * panel_width];
+                for(int f = 0; f < batch_size; ++f)
+                    std::copy(&bias[p * panel_width], &bias[(p + 1) * panel_width], acc_buffer[f]);
+
+                for(int k0 = 0; k0 < in_size; k0 += k_block)
+                {
+                    const auto k1 = std::min(k0 + k_block, in_size);
+
+                    int f = 0;
+                    for(; f + 2 <= batch_size; f += 2)
+                    {
+                        const T* x = batch_input + (size_t)f * in_size;
+                        accumulateTwoFrames(panel, x, x + in_size, acc_buffer[f], acc_buffer[f + 1], k0, k1);
+                    }
+
+                    for(; f < batch_size; ++f)
+                        accumulateOneFrame(panel, batch_input + (size_t)f * in_size, acc_buffer[f], k0, k1);
+                }
+
+                for(int f = 0; f < batch_size; ++f)
+                    storePanel(acc_buffer[f], batch_out + (size_t)f * out_size, p);
+            }
+        }
+    }
+
+private:
+    /** Number of panel rows to prefetch ahead of the current row. */
+    static constexpr int prefetch_distance = 8;
+
+    inline size_t weightIndex(int i, int k) const noexcept
+    {
+        return ((size_t)(i / panel_width) * in_size + k) * panel_width + i % panel_width;
+    }
+
+    static inline void prefetch(const T* ptr) noexcept
+    {
+#if defined(__GNUC__) || defined(__clang__)
+        constexpr int cache_line_size = 64;
+        for(int offset = 0; offset < panel_width * (int)sizeof(T); offset += cache_line_size)
+            __builtin_prefetch(reinterpret_cast<const char*>(ptr) + offset, 0, 3);
+#else
+        (void)ptr;
+#endif
+    }
+
+    inline void storePanel(const T* acc, T* out, int p) const noexcept
+    {
+        const auto start = p * panel_width;
+        const auto count = std::min((int)panel_width, out_size - start);
+        std::copy(acc, acc + count, out + start);
+    }
+
+    static inline void accumulateOneFrame(const T* panel, const T* x, T* acc, int k0, int k1) noexcept
+    {
+        auto acc0 = xsimd::load_aligned(acc);
+        auto acc1 = xsimd::load_aligned(acc + inc);
+        auto acc2 = xsimd::load_aligned(acc + 2 * inc);
+        auto acc3 = xsimd::load_aligned(acc + 3 * inc);
+
+        const T* row = panel + (size_t)k0 * panel_width;
+        for(int k = k0; k < k1; ++k, row += panel_width)
+        {
+            const auto x_vec = b_type(x[k]);
+            acc0 = xsimd::fma(xsimd::load_aligned(row), x_vec, acc0);
+            acc1 = xsimd::fma(xsimd::load_aligned(row + inc), x_vec, acc1);
+            acc2 = xsimd::fma(xsimd::load_aligned(row + 2 * inc), x_vec, acc2);
+            acc3 = xsimd::fma(xsimd::load_aligned(row + 3 * inc), x_vec, acc3);
+        }
+
+        xsimd::store_aligned(acc, acc0);
+        xsimd::store_aligned(acc + inc, acc1);
+        xsimd::store_aligned(acc + 2 * inc, acc2);
+        xsimd::store_aligned(acc + 3 * inc, acc3);
+    }
+
+    static inline void accumulateTwoFrames(const T* panel, const T* xA, const T* xB, T* accA, T* accB, int k0, int k1) noexcept
+    {
+        auto accA0 = xsimd::load_aligned(accA);
+        auto accA1 = xsimd::load_aligned(accA + inc);
+        auto accA2 = xsimd::load_aligned(accA + 2 * inc);
+        auto accA3 = xsimd::load_aligned(accA + 3 * inc);
+        auto accB0 = xsimd::load_aligned(accB);
+        auto accB1 = xsimd::load_aligned(accB + inc);
+        auto accB2 = xsimd::load_aligned(accB + 2 * inc);
+        auto accB3 = xsimd::load_aligned(accB + 3 * inc);
+
+        const T* row = panel + (size_t)k0 * panel_width;
+        for(int k = k0; k < k1; ++k, row += panel_width)
+        {
+            const auto w0 = xsimd::load_aligned(row);
+            const auto w1 = xsimd::load_aligned(row + inc);
+            const auto w2 = xsimd::load_aligned(row + 2 * inc);
+            const auto w3 = xsimd::load_aligned(row + 3 * inc);
+
+            const auto xA_vec = b_type(xA[k]);
+            accA0 = xsimd::fma(w0, xA_vec, accA0);
+            accA1 = xsimd::fma(w1, xA_vec, accA1);
+            accA2 = xsimd::fma(w2, xA_vec, accA2);
+            accA3 = xsimd::fma(w3, xA_vec, accA3);
+
+            const auto xB_vec = b_type(xB[k]);
+            accB0 = xsimd::fma(w0, xB_vec, accB0);
+            accB1 = xsimd::fma(w1, xB_vec, accB1);
+            accB2 = xsimd::fma(w2, xB_vec, accB2);
+            accB3 = xsimd::fma(w3, xB_vec, accB3);
+        }
+
+        xsimd::store_aligned(accA, accA0);
+        xsimd::store_aligned(accA + inc, accA1);
+        xsimd::store_aligned(accA + 2 * inc, accA2);
+        xsimd::store_aligned(accA + 3 * inc, accA3);
+        xsimd::store_aligned(accB, accB0);
+        xsimd::store_aligned(accB + inc, accB1);
+        xsimd::store_aligned(accB + 2 * inc, accB2);
+        xsimd::store_aligned(accB + 3 * inc, accB3);
+    }
+
+    const int in_size;
+    const int out_size;
+    const int num_panels;
+
+    vec_type panels; // packed weights: panels[num_panels][in_size][panel_width]
+    vec_type bias; // padded bias: bias[num_panels * panel_width]
+};
+
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // DENSEBLOCKEDXSIMD_H_INCLUDED
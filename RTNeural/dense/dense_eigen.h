@@ -2,16 +2,19 @@
 #define DENSEEIGEN_H_INCLUDED
 
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
 #include "../common.h"
 #include "../config.h"
 #include <Eigen/Dense>
+#include <memory>
 
 namespace RTNEURAL_NAMESPACE
 {
 
 /**
  * Dynamic implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  */
 template <typename T>
 class Dense : public Layer<T>
@@ -65,6 +68,21 @@ public:
 
         for(int i = 0; i < Layer<T>::out_size; ++i)
             out[i] = outVec(i, 0);
+
+        if(activation != nullptr)
+            activation->forward(out, out);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+            forward(input + n * Layer<T>::in_size, output + n * Layer<T>::out_size);
     }
 
     /**
@@ -109,19 +127,34 @@ public:
     /** Returns the bias value at the given index. */
     RTNEURAL_REALTIME T getBias(int i) const noexcept { return weights(i, Layer<T>::in_size); }
 
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
+
 private:
     Eigen::Matrix<T, Eigen::Dynamic, Eigen::Dynamic> weights;
 
     Eigen::Matrix<T, Eigen::Dynamic, 1> inVec;
     Eigen::Matrix<T, Eigen::Dynamic, 1> outVec;
+
+    std::unique_ptr<Activation<T>> activation;
 };
 
 //====================================================
 /**
  * Static implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see fused_activation).
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
-template <typename T, int in_sizet, int out_sizet, bool has_bias = true>
+template <typename T, int in_sizet, int out_sizet, bool has_bias = true, typename FusedActivation = fused_activation::Identity, bool block_sparse = false>
 class DenseT
 {
     using out_vec_type = Eigen::Matrix<T, out_sizet, 1>;
@@ -136,6 +169,7 @@ public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
     static constexpr bool dense_has_bias = has_bias;
+    using activation_type = FusedActivation;
 
     DenseT()
         : outs(outs_internal)
@@ -170,6 +204,7 @@ public:
          *                 | 1     |
          */
         outs.noalias() = weights * ins_internal;
+        activation.apply(outs);
     }
 
     /** Performs forward propagation for this layer (no bias). */
@@ -177,6 +212,7 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<!b>::type forward(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
     {
         outs.noalias() = weights * ins;
+        activation.apply(outs);
     }
 
     /**
@@ -220,6 +256,9 @@ public:
             weights(i, in_size) = bias_vals[i];
     }
 
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     Eigen::Map<out_vec_type, RTNeuralEigenAlignment> outs;
 
 private:
@@ -227,6 +266,8 @@ private:
     in_vec_type ins_internal;
 
     mat_type weights;
+
+    FusedActivation activation;
 };
 
 } // namespace RTNEURAL_NAMESPACE
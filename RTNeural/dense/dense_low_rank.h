@@ -0,0 +1,178 @@
+#ifndef DENSELOWRANK_H_INCLUDED
+#define DENSELOWRANK_H_INCLUDED
+
+#include "dense.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ * Dynamic implementation of a fully-connected (dense) layer,
+ * with no activation, where the weights matrix is stored as
+ * low-rank factors: weights[out_size][in_size] = left[out_size][rank] * right[rank][in_size].
+ *
+ * The layer is computed as a projection down to `rank` values, followed
+ * by a dense layer back up to `out_size` outputs, so the cost of the
+ * forward pass is (in_size + out_size) * rank, rather than in_size * out_size.
+ */
+template <typename T>
+class LowRankDense final : public Layer<T>
+{
+public:
+    static constexpr bool dense_has_bias = true;
+
+    /** Constructs a low-rank dense layer for a given input size, output size, and rank. */
+    LowRankDense(int in_size, int out_size, int rank)
+        : Layer<T>(in_size, out_size)
+        , projection(in_size, rank)
+        , expansion(rank, out_size)
+        , projection_outs((size_t)rank, (T)0)
+    {
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "dense"; }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        projection.forward(input, projection_outs.data());
+        expansion.forward(projection_outs.data(), out);
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+            forward(input + n * Layer<T>::in_size, output + n * Layer<T>::out_size);
+    }
+
+    /**
+     * Sets the layer weights from low-rank factors, such that
+     * weights[out_size][in_size] = left[out_size][rank] * right[rank][in_size]
+     */
+    RTNEURAL_REALTIME void setFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        projection.setWeights(right);
+        expansion.setWeights(left);
+    }
+
+    /**
+     * Sets the layer bias from a given array of size
+     * bias[out_size]
+     */
+    RTNEURAL_REALTIME void setBias(const T* b) { expansion.setBias(b); }
+
+    /** Returns the bias value at the given index. */
+    RTNEURAL_REALTIME T getBias(int i) const noexcept { return expansion.getBias(i); }
+
+    /** Returns the rank of the layer weights. */
+    int getRank() const noexcept { return (int)projection_outs.size(); }
+
+private:
+    Dense<T> projection; // right[rank][in_size], with no bias
+    Dense<T> expansion; // left[out_size][rank]
+    std::vector<T> projection_outs;
+};
+
+//====================================================
+/**
+ * Static implementation of a fully-connected (dense) layer,
+ * with no activation, where the weights matrix is stored as
+ * low-rank factors: weights[out_size][in_size] = left[out_size][rank] * right[rank][in_size].
+ */
+template <typename T, int in_sizet, int out_sizet, int rankt, bool has_bias = true>
+class LowRankDenseT
+{
+    using projection_type = DenseT<T, in_sizet, rankt, false>;
+    using expansion_type = DenseT<T, rankt, out_sizet, has_bias>;
+
+public:
+    static constexpr auto in_size = in_sizet;
+    static constexpr auto out_size = out_sizet;
+    static constexpr auto rank = rankt;
+    static constexpr bool dense_has_bias = has_bias;
+
+    LowRankDenseT()
+#if RTNEURAL_USE_EIGEN
+        : outs(outs_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_out_size; ++i)
+            outs[i] = v_type((T)0);
+#elif RTNEURAL_USE_EIGEN
+        outs = Eigen::Matrix<T, out_size, 1>::Zero();
+#else
+        std::fill(std::begin(outs), std::end(outs), (T)0);
+#endif
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "dense"; }
+
+    /** Returns false since dense is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Reset is a no-op, since Dense does not have state. */
+    RTNEURAL_REALTIME void reset() { }
+
+    /** Performs forward propagation for this layer. */
+    template <typename InVec>
+    RTNEURAL_REALTIME inline void forward(const InVec& ins) noexcept
+    {
+        projection.forward(ins);
+        expansion.forward(projection.outs);
+
+        // the outputs are copied out of the expansion layer, so that
+        // a ModelT can point them at the model outputs
+#if RTNEURAL_USE_EIGEN
+        outs = expansion.outs;
+#else
+        std::copy(std::begin(expansion.outs), std::end(expansion.outs), std::begin(outs));
+#endif
+    }
+
+    /**
+     * Sets the layer weights from low-rank factors, such that
+     * weights[out_size][in_size] = left[out_size][rank] * right[rank][in_size]
+     */
+    RTNEURAL_REALTIME void setFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        projection.setWeights(right);
+        expansion.setWeights(left);
+    }
+
+    /**
+     * Sets the layer bias from a given array of size
+     * bias[out_size]
+     */
+    RTNEURAL_REALTIME void setBias(const T* b) { expansion.setBias(b); }
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_out_size = ceil_div(out_size, (int)v_type::size);
+
+    v_type outs[v_out_size];
+#elif RTNEURAL_USE_EIGEN
+    Eigen::Map<Eigen::Matrix<T, out_size, 1>, RTNeuralEigenAlignment> outs;
+
+private:
+    T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+#else
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+#endif
+
+private:
+    projection_type projection; // right[rank][in_size], with no bias
+    expansion_type expansion; // left[out_size][rank]
+};
+
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // DENSELOWRANK_H_INCLUDED
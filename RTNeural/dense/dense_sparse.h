@@ -0,0 +1,185 @@
+#ifndef DENSESPARSE_H_INCLUDED
+#define DENSESPARSE_H_INCLUDED
+
+#include "../Layer.h"
+#include "../config.h"
+#include <algorithm>
+#include <vector>
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ * When loading a model, dense layers with at least this fraction
+ * of zero-valued weights are created as SparseDense layers.
+ *
+ * The sparse layer is scalar code, so with the SIMD backends it only
+ * catches up with the (vectorized) Dense layer for very sparse weights.
+ */
+#if RTNEURAL_USE_EIGEN || RTNEURAL_USE_XSIMD
+constexpr double default_sparsity_threshold = 0.95;
+#else
+constexpr double default_sparsity_threshold = 0.6;
+#endif
+
+/**
+ * Dynamic implementation of a fully-connected (dense) layer,
+ * with no activation, for layers with mostly zero-valued weights.
+ *
+ * The non-zero weights are stored in compressed sparse row (CSR)
+ * format, so the cost of the forward pass is proportional to the
+ * number of non-zero weights, rather than in_size * out_size.
+ */
+template <typename T>
+class SparseDense final : public Layer<T>
+{
+public:
+    static constexpr bool dense_has_bias = true;
+
+    /** Constructs a sparse dense layer for a given input and output size. */
+    SparseDense(int in_size, int out_size)
+        : Layer<T>(in_size, out_size)
+        , bias((size_t)out_size, (T)0)
+        , row_starts((size_t)out_size + 1, 0)
+    {
+    }
+
+    SparseDense(std::initializer_list<int> sizes)
+        : SparseDense(*sizes.begin(), *(sizes.begin() + 1))
+    {
+    }
+
+    SparseDense(const SparseDense& other) = default;
+    SparseDense& operator=(const SparseDense& other) = default;
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "dense"; }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        const auto* w = values.data();
+        const auto* cols = columns.data();
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+        {
+            // several accumulators, to break up the dependency chain along the row
+            T sum0 = bias[(size_t)i];
+            T sum1 = (T)0;
+            T sum2 = (T)0;
+            T sum3 = (T)0;
+
+            int j = row_starts[(size_t)i];
+            const int row_end = row_starts[(size_t)i + 1];
+            for(; j + 3 < row_end; j += 4)
+            {
+                sum0 += w[j] * input[cols[j]];
+                sum1 += w[j + 1] * input[cols[j + 1]];
+                sum2 += w[j + 2] * input[cols[j + 2]];
+                sum3 += w[j + 3] * input[cols[j + 3]];
+            }
+            for(; j < row_end; ++j)
+                sum0 += w[j] * input[cols[j]];
+
+            out[i] = (sum0 + sum1) + (sum2 + sum3);
+        }
+    }
+
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+            forward(input + n * Layer<T>::in_size, output + n * Layer<T>::out_size);
+    }
+
+    /**
+     * Sets the layer weights from a given vector.
+     *
+     * The dimension of the weights vector must be
+     * weights[out_size][in_size]
+     */
+    void setWeights(const std::vector<std::vector<T>>& newWeights)
+    {
+        setWeightsInternal([&newWeights](int i, int k)
+            { return newWeights[(size_t)i][(size_t)k]; });
+    }
+
+    /**
+     * Sets the layer weights from a given array.
+     *
+     * The dimension of the weights array must be
+     * weights[out_size][in_size]
+     */
+    void setWeights(T** newWeights)
+    {
+        setWeightsInternal([newWeights](int i, int k)
+            { return newWeights[i][k]; });
+    }
+
+    /**
+     * Sets the layer bias from a given array of size
+     * bias[out_size]
+     */
+    RTNEURAL_REALTIME void setBias(const T* b)
+    {
+        std::copy(b, b + Layer<T>::out_size, bias.begin());
+    }
+
+    /** Returns the weights value at the given indices. */
+    T getWeight(int i, int k) const noexcept
+    {
+        const auto row_begin = columns.begin() + row_starts[(size_t)i];
+        const auto row_end = columns.begin() + row_starts[(size_t)i + 1];
+        const auto col = std::lower_bound(row_begin, row_end, k);
+        if(col == row_end || *col != k)
+            return (T)0;
+
+        return values[(size_t)(col - columns.begin())];
+    }
+
+    /** Returns the bias value at the given index. */
+    RTNEURAL_REALTIME T getBias(int i) const noexcept { return bias[(size_t)i]; }
+
+    /** Returns the number of non-zero weights stored by this layer. */
+    int getNumNonZeros() const noexcept { return (int)values.size(); }
+
+private:
+    template <typename WeightsGetter>
+    void setWeightsInternal(WeightsGetter&& getWeightValue)
+    {
+        values.clear();
+        columns.clear();
+
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+        {
+            row_starts[(size_t)i] = (int)values.size();
+            for(int k = 0; k < Layer<T>::in_size; ++k)
+            {
+                const auto w = getWeightValue(i, k);
+                if(w == (T)0)
+                    continue;
+
+                values.push_back(w);
+                columns.push_back(k);
+            }
+        }
+        row_starts[(size_t)Layer<T>::out_size] = (int)values.size();
+    }
+
+    std::vector<T> bias;
+
+    // CSR weights: the non-zero weights for output i are
+    // values[row_starts[i]:row_starts[i + 1]], with the input
+    // indices for those weights stored in columns.
+    std::vector<T> values;
+    std::vector<int> columns;
+    std::vector<int> row_starts;
+};
+
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // DENSESPARSE_H_INCLUDED
@@ -0,0 +1,103 @@
+#ifndef DENSESPARSEXSIMD_H_INCLUDED
+#define DENSESPARSEXSIMD_H_INCLUDED
+
+#include "../common.h"
+#include "../config.h"
+#include <xsimd/xsimd.hpp>
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ * Index of the non-zero blocks in a column-major weights matrix
+ * mat[num_rows][v_num_cols], used internally by the templated layers
+ * to skip the zeros in pruned weights.
+ *
+ * Each block is one SIMD register, holding the weights from a single
+ * input to v_size consecutive outputs. The index is only enabled when
+ * at least `sparse_blocks_threshold` of the blocks are zero, since
+ * the indirection costs more than it saves for denser weights.
+ *
+ * The index is empty for layers that are not block-sparse (block_sparse = false).
+ */
+template <typename T, int num_rows, int v_num_cols, bool block_sparse = true>
+class SparseBlockIndexT
+{
+    using v_type = xsimd::simd_type<T>;
+
+public:
+    static constexpr double sparse_blocks_threshold = 0.5;
+
+    /** Rebuilds the index for the given weights. */
+    void update(const v_type (&mat)[num_rows][v_num_cols]) noexcept
+    {
+        int num_blocks = 0;
+        for(int i = 0; i < v_num_cols; ++i)
+        {
+            block_starts[i] = num_blocks;
+            for(int k = 0; k < num_rows; ++k)
+            {
+                if(xsimd::any(mat[k][i] != v_type((T)0)))
+                    block_rows[num_blocks++] = k;
+            }
+        }
+        block_starts[v_num_cols] = num_blocks;
+
+        constexpr int total_blocks = num_rows * v_num_cols;
+        enabled = (double)(total_blocks - num_blocks) >= sparse_blocks_threshold * (double)total_blocks;
+    }
+
+    /** Returns true if the weights are sparse enough to use the index. */
+    bool isEnabled() const noexcept { return enabled; }
+
+    /** Returns the number of non-zero blocks in the weights. */
+    int getNumBlocks() const noexcept { return block_starts[v_num_cols]; }
+
+    /**
+     * Computes out += mat^T * in, skipping the zero blocks,
+     * where the input is a scalar array of size in[num_rows].
+     */
+    inline void accumulate(const T* in, const v_type (&mat)[num_rows][v_num_cols], v_type (&out)[v_num_cols]) const noexcept
+    {
+        for(int i = 0; i < v_num_cols; ++i)
+        {
+            v_type sum0 = out[i];
+            v_type sum1 = (T)0;
+
+            int b = block_starts[i];
+            for(; b + 1 < block_starts[i + 1]; b += 2)
+            {
+                sum0 = xsimd::fma(mat[block_rows[b]][i], v_type(in[block_rows[b]]), sum0);
+                sum1 = xsimd::fma(mat[block_rows[b + 1]][i], v_type(in[block_rows[b + 1]]), sum1);
+            }
+            if(b < block_starts[i + 1])
+                sum0 = xsimd::fma(mat[block_rows[b]][i], v_type(in[block_rows[b]]), sum0);
+
+            out[i] = sum0 + sum1;
+        }
+    }
+
+private:
+    // the non-zero blocks in column i are in rows
+    // block_rows[block_starts[i]:block_starts[i + 1]]
+    int block_rows[num_rows * v_num_cols] {};
+    int block_starts[v_num_cols + 1] {};
+    bool enabled = false;
+};
+
+#ifndef DOXYGEN
+template <typename T, int num_rows, int v_num_cols>
+class SparseBlockIndexT<T, num_rows, v_num_cols, false>
+{
+    using v_type = xsimd::simd_type<T>;
+
+public:
+    void update(const v_type (&)[num_rows][v_num_cols]) noexcept { }
+    constexpr bool isEnabled() const noexcept { return false; }
+    inline void accumulate(const T*, const v_type (&)[num_rows][v_num_cols], v_type (&)[v_num_cols]) const noexcept { }
+};
+#endif
+
+} // namespace RTNEURAL_NAMESPACE
+
+#endif // DENSESPARSEXSIMD_H_INCLUDED
@@ -2,7 +2,13 @@
 #define DENSEXSIMD_H_INCLUDED
 
 #include "../Layer.h"
+#include "../activation/activation.h"
+#include "../activation/fused_activation.h"
+#include "../common.h"
 #include "../config.h"
+#include "dense_blocked_xsimd.h"
+#include "dense_sparse_xsimd.h"
+#include <memory>
 #include <xsimd/xsimd.hpp>
 
 namespace RTNEURAL_NAMESPACE
@@ -10,7 +16,7 @@ namespace RTNEURAL_NAMESPACE
 
 /**
  * Dynamic implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see setActivation()).
  */
 template <typename T>
 class Dense : public Layer<T>
@@ -18,15 +24,25 @@ class Dense : public Layer<T>
 public:
     static constexpr bool dense_has_bias = true;
 
+    /**
+     * Layers with at least this many weights use the cache-blocked
+     * GEMV engine, since their weights will not fit in the L2 cache.
+     */
+    static constexpr int blocked_weights_threshold = 1 << 16;
+
     /** Constructs a dense layer for a given input and output size. */
     Dense(int in_size, int out_size)
         : Layer<T>(in_size, out_size)
+        , out_size_padded(simd_padded_size<T>(out_size))
+        , use_blocked(in_size * out_size >= blocked_weights_threshold)
+        , blocked(use_blocked ? in_size : 0, use_blocked ? out_size : 0)
     {
-        prod.resize(in_size, (T)0);
-        weights = vec2_type(out_size, vec_type(in_size, (T)0));
+        if(use_blocked)
+            return;
 
-        bias.resize(out_size, (T)0);
-        sums.resize(out_size, (T)0);
+        weights.resize(in_size * out_size_padded, (T)0);
+        bias.resize(out_size_padded, (T)0);
+        sums.resize(out_size_padded, (T)0);
     }
 
     Dense(std::initializer_list<int> sizes)
@@ -52,15 +68,44 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
     {
-        for(int l = 0; l < Layer<T>::out_size; ++l)
+        if(use_blocked)
+        {
+            blocked.gemv(input, out);
+        }
+        else
         {
-            xsimd::transform(input, &input[Layer<T>::in_size], weights[l].data(), prod.data(),
-                [](auto const& a, auto const& b)
-                { return a * b; });
+            vCopy(bias.data(), sums.data(), out_size_padded);
+            vMatVecAccum(weights.data(), input, sums.data(), Layer<T>::in_size, out_size_padded);
+            std::copy(sums.begin(), sums.begin() + Layer<T>::out_size, out);
+        }
+
+        if(activation != nullptr)
+            activation->forward(out, out);
+    }
 
-            auto sum = xsimd::reduce(prod.begin(), prod.begin() + Layer<T>::in_size, (T)0);
-            out[l] = sum + bias[l];
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size]. For large
+     * layers, each block of weights is re-used for several samples while
+     * it is still in cache.
+     */
+    RTNEURAL_REALTIME inline void forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        if(use_blocked)
+        {
+            blocked.gemm(input, output, num_samples);
+            if(activation != nullptr)
+            {
+                for(int n = 0; n < num_samples; ++n)
+                    activation->forward(output + n * Layer<T>::out_size, output + n * Layer<T>::out_size);
+            }
+            return;
         }
+
+        for(int n = 0; n < num_samples; ++n)
+            forward(input + n * Layer<T>::in_size, output + n * Layer<T>::out_size);
     }
 
     /**
@@ -73,7 +118,7 @@ public:
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
             for(int k = 0; k < Layer<T>::in_size; ++k)
-                weights[i][k] = newWeights[i][k];
+                setWeight(i, k, newWeights[i][k]);
     }
 
     /**
@@ -86,7 +131,7 @@ public:
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
             for(int k = 0; k < Layer<T>::in_size; ++k)
-                weights[i][k] = newWeights[i][k];
+                setWeight(i, k, newWeights[i][k]);
     }
 
     /**
@@ -96,31 +141,67 @@ public:
     RTNEURAL_REALTIME void setBias(const T* b)
     {
         for(int i = 0; i < Layer<T>::out_size; ++i)
-            bias[i] = b[i];
+        {
+            if(use_blocked)
+                blocked.setBias(i, b[i]);
+            else
+                bias[i] = b[i];
+        }
     }
 
     /** Returns the weights value at the given indices. */
-    RTNEURAL_REALTIME T getWeight(int i, int k) const noexcept { return weights[i][k]; }
+    RTNEURAL_REALTIME T getWeight(int i, int k) const noexcept
+    {
+        return use_blocked ? blocked.getWeight(i, k) : weights[k * out_size_padded + i];
+    }
 
     /** Returns the bias value at the given index. */
-    RTNEURAL_REALTIME T getBias(int i) const noexcept { return bias[i]; }
+    RTNEURAL_REALTIME T getBias(int i) const noexcept { return use_blocked ? blocked.getBias(i) : bias[i]; }
+
+    /**
+     * Sets an activation to apply to the layer outputs, in place of
+     * a separate activation layer. The activation is computed in-place,
+     * so it must be an element-wise activation.
+     */
+    void setActivation(std::unique_ptr<Activation<T>> newActivation) { activation = std::move(newActivation); }
+
+    /** Returns the fused activation, or nullptr if the layer has no activation. */
+    Activation<T>* getActivation() const noexcept { return activation.get(); }
 
 private:
     using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
-    using vec2_type = std::vector<vec_type>;
 
+    inline void setWeight(int i, int k, T value) noexcept
+    {
+        if(use_blocked)
+            blocked.setWeight(i, k, value);
+        else
+            weights[k * out_size_padded + i] = value;
+    }
+
+    const int out_size_padded;
+
+    // small layers
     vec_type bias;
-    vec2_type weights;
-    vec_type prod;
+    vec_type weights; // column-major: weights[in_size][out_size_padded]
     vec_type sums;
+
+    // large layers
+    const bool use_blocked;
+    BlockedGemv<T> blocked;
+
+    std::unique_ptr<Activation<T>> activation;
 };
 
 //====================================================
 /**
  * Static implementation of a fully-connected (dense) layer,
- * with no activation.
+ * with an optional fused activation (see fused_activation).
+ *
+ * If `block_sparse` is true, the layer skips the all-zero SIMD-width blocks
+ * in its (pruned) weights, once at least half of the blocks are zero.
  */
-template <typename T, int in_sizet, int out_sizet, bool has_bias = true>
+template <typename T, int in_sizet, int out_sizet, bool has_bias = true, typename FusedActivation = fused_activation::Identity, bool block_sparse = false>
 class DenseT
 {
     using v_type = xsimd::simd_type<T>;
@@ -132,6 +213,7 @@ public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
     static constexpr bool dense_has_bias = has_bias;
+    using activation_type = FusedActivation;
 
     DenseT()
     {
@@ -162,14 +244,25 @@ public:
     template <bool b = has_bias>
     RTNEURAL_REALTIME inline typename std::enable_if<b>::type forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        static constexpr auto v_size_inner = std::min(v_size, in_size);
-
         for(int i = 0; i < v_out_size; ++i)
             outs[i] = bias[i];
 
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
+        {
+            if(sparse_index.isEnabled())
+            {
+                sparse_accumulate(ins);
+                applyActivation();
+                return;
+            }
+        }
+
         T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
         for(int k = 0; k < v_in_size; ++k)
         {
+            // the last block of inputs may be partially filled
+            const auto v_size_inner = in_size - k * v_size < v_size ? in_size - k * v_size : v_size;
+
             ins[k].store_aligned(scalar_in);
             for(int i = 0; i < v_out_size; ++i)
             {
@@ -177,20 +270,33 @@ public:
                     outs[i] += scalar_in[j] * weights[k * v_size + j][i];
             }
         }
+
+        applyActivation();
     }
 
     /** Performs forward propagation for this layer (no bias). */
     template <bool b = has_bias>
     RTNEURAL_REALTIME inline typename std::enable_if<!b>::type forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        static constexpr auto v_size_inner = std::min(v_size, in_size);
-
         for(int i = 0; i < v_out_size; ++i)
             outs[i] = v_type((T)0.0);
 
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
+        {
+            if(sparse_index.isEnabled())
+            {
+                sparse_accumulate(ins);
+                applyActivation();
+                return;
+            }
+        }
+
         T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
         for(int k = 0; k < v_in_size; ++k)
         {
+            // the last block of inputs may be partially filled
+            const auto v_size_inner = in_size - k * v_size < v_size ? in_size - k * v_size : v_size;
+
             ins[k].store_aligned(scalar_in);
             for(int i = 0; i < v_out_size; ++i)
             {
@@ -198,6 +304,8 @@ public:
                     outs[i] += scalar_in[j] * weights[k * v_size + j][i];
             }
         }
+
+        applyActivation();
     }
 
     /**
@@ -215,6 +323,8 @@ public:
                 weights[k][i / v_size] = set_value(weights[k][i / v_size], i % v_size, newWeights[i][k]);
             }
         }
+
+        sparse_index.update(weights);
     }
 
     /**
@@ -232,6 +342,8 @@ public:
                 weights[k][i / v_size] = set_value(weights[k][i / v_size], i % v_size, newWeights[i][k]);
             }
         }
+
+        sparse_index.update(weights);
     }
 
     /**
@@ -249,23 +361,52 @@ public:
             bias[i / v_size] = set_value(bias[i / v_size], i % v_size, bias_vals[i]);
     }
 
+    /** Returns true if the layer is skipping the zero blocks in its (pruned) weights. */
+    bool isSparse() const noexcept { return sparse_index.isEnabled(); }
+
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     v_type outs[v_out_size];
 
 private:
+    inline void applyActivation() noexcept
+    {
+        RTNEURAL_IF_CONSTEXPR(!FusedActivation::is_identity)
+        {
+            for(int i = 0; i < v_out_size; ++i)
+                outs[i] = activation(outs[i], i);
+        }
+    }
+
+    inline void sparse_accumulate(const v_type (&ins)[v_in_size]) noexcept
+    {
+        T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size];
+        for(int k = 0; k < v_in_size; ++k)
+            ins[k].store_aligned(&scalar_in[k * v_size]);
+
+        sparse_index.accumulate(scalar_in, weights, outs);
+    }
+
 #if RTNEURAL_HAS_CPP17
     std::conditional_t<has_bias, v_type[v_out_size], Empty> bias;
 #else
     v_type bias[v_out_size];
 #endif
     v_type weights[in_size][v_out_size];
+    SparseBlockIndexT<T, in_size, v_out_size, block_sparse> sparse_index;
+
+    FusedActivation activation;
 };
 
 /**
  * Static implementation of a fully-connected (dense) layer,
  * optimized for out_size=1.
+ *
+ * These weights are too small to benefit from `block_sparse`, so it is ignored.
  */
-template <typename T, int in_sizet, bool has_bias>
-class DenseT<T, in_sizet, 1, has_bias>
+template <typename T, int in_sizet, bool has_bias, typename FusedActivation, bool block_sparse>
+class DenseT<T, in_sizet, 1, has_bias, FusedActivation, block_sparse>
 {
     using v_type = xsimd::simd_type<T>;
     static constexpr auto v_size = (int)v_type::size;
@@ -275,6 +416,7 @@ public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = 1;
     static constexpr bool dense_has_bias = has_bias;
+    using activation_type = FusedActivation;
 
     DenseT()
     {
@@ -296,7 +438,7 @@ public:
         for(int k = 0; k < v_in_size; ++k)
             y += ins[k] * weights[k];
 
-        outs[0] = v_type(xsimd::reduce_add(y) + bias);
+        outs[0] = v_type(activation(xsimd::reduce_add(y) + bias, 0));
     }
 
     template <bool b = has_bias>
@@ -306,7 +448,7 @@ public:
         for(int k = 0; k < v_in_size; ++k)
             y += ins[k] * weights[k];
 
-        outs[0] = v_type(xsimd::reduce_add(y));
+        outs[0] = v_type(activation(xsimd::reduce_add(y), 0));
     }
 
     RTNEURAL_REALTIME void setWeights(const std::vector<std::vector<T>>& newWeights)
@@ -343,6 +485,8 @@ public:
         bias = bias_vals[0];
     }
 
+    FusedActivation& getActivation() noexcept { return activation; }
+
     v_type outs[1];
 
 private:
@@ -352,14 +496,18 @@ private:
     T bias {};
 #endif
     v_type weights[v_in_size];
+
+    FusedActivation activation;
 };
 
 /**
  * Static implementation of a fully-connected (dense) layer,
  * optimized for in_size=1.
+ *
+ * These weights are too small to benefit from `block_sparse`, so it is ignored.
  */
-template <typename T, int out_sizet, bool has_bias>
-class DenseT<T, 1, out_sizet, has_bias>
+template <typename T, int out_sizet, bool has_bias, typename FusedActivation, bool block_sparse>
+class DenseT<T, 1, out_sizet, has_bias, FusedActivation, block_sparse>
 {
     using v_type = xsimd::simd_type<T>;
     static constexpr auto v_size = (int)v_type::size;
@@ -369,6 +517,7 @@ public:
     static constexpr auto in_size = 1;
     static constexpr auto out_size = out_sizet;
     static constexpr bool dense_has_bias = has_bias;
+    using activation_type = FusedActivation;
 
     DenseT()
     {
@@ -398,12 +547,9 @@ public:
     template <bool b = has_bias>
     RTNEURAL_REALTIME inline typename std::enable_if<b>::type forward(const v_type (&ins)[1]) noexcept
     {
-        for(int i = 0; i < v_out_size; ++i)
-            outs[i] = bias[i];
-
         const auto in = ins[0].get(0);
         for(int i = 0; i < v_out_size; ++i)
-            outs[i] += in * weights[i];
+            outs[i] = activation(bias[i] + in * weights[i], i);
     }
 
     /** Performs forward propagation for this layer (no bias). */
@@ -412,7 +558,7 @@ public:
     {
         const auto in = ins[0].get(0);
         for(int i = 0; i < v_out_size; ++i)
-            outs[i] = in * weights[i];
+            outs[i] = activation(in * weights[i], i);
     }
 
     /**
@@ -454,6 +600,9 @@ public:
             bias[i / v_size] = set_value(bias[i / v_size], i % v_size, bias_vals[i]);
     }
 
+    /** Returns the activation that is fused into this layer. */
+    FusedActivation& getActivation() noexcept { return activation; }
+
     v_type outs[v_out_size];
 
 private:
@@ -463,6 +612,8 @@ private:
     v_type bias[v_out_size];
 #endif
     v_type weights[v_out_size];
+
+    FusedActivation activation;
 };
 
 } // namespace RTNEURAL_NAMESPACE
@@ -0,0 +1,113 @@
+#pragma once
+
+#include "cpu_features.h"
+#include <string>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <dlfcn.h>
+#endif
+
+namespace RTNEURAL_NAMESPACE
+{
+
+/**
+ * Returns the suffix that rtneural_add_dispatch_library() gives to
+ * the module compiled for the given SIMD instruction set.
+ */
+constexpr const char* getArchModuleSuffix(SIMDArch arch) noexcept
+{
+    return arch == SIMDArch::AVX512 ? "_avx512"
+        : arch == SIMDArch::AVX2   ? "_avx2"
+        : arch == SIMDArch::SSE4_1 ? "_sse4_1"
+                                   : "_default";
+}
+
+/**
+ * One of the shared modules compiled by rtneural_add_dispatch_library(),
+ * loaded at runtime. Each module is compiled for one SIMD instruction set,
+ * and only exports its entry points (see RTNEURAL_DISPATCH_EXPORT), so the
+ * modules for several instruction sets can be loaded at the same time.
+ *
+ * A module is only loaded if the host CPU supports its instruction set.
+ */
+class DispatchModule
+{
+public:
+    /**
+     * Loads a dispatch module.
+     *
+     * @param directory: the directory containing the modules
+     * @param name: the name of the modules (the TARGET passed to rtneural_add_dispatch_library())
+     * @param arch: the instruction set of the module to load
+     */
+    DispatchModule(const std::string& directory, const std::string& name, SIMDArch arch = getBestSupportedArch())
+        : arch(arch)
+    {
+        if(!isArchSupported(arch))
+            return;
+
+        const auto path = getModulePath(directory, name, arch);
+#if defined(_WIN32)
+        handle = (void*)LoadLibraryA(path.c_str());
+#else
+        handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+    }
+
+    ~DispatchModule()
+    {
+        if(handle == nullptr)
+            return;
+
+#if defined(_WIN32)
+        FreeLibrary((HMODULE)handle);
+#else
+        dlclose(handle);
+#endif
+    }
+
+    DispatchModule(const DispatchModule&) = delete;
+    DispatchModule& operator=(const DispatchModule&) = delete;
+
+    /** Returns true if the module was loaded. */
+    bool isLoaded() const noexcept { return handle != nullptr; }
+
+    /** Returns the instruction set that the module was compiled for. */
+    SIMDArch getArch() const noexcept { return arch; }
+
+    /** Returns one of the module's entry points, or nullptr if it was not found. */
+    template <typename FunctionType>
+    FunctionType* getFunction(const char* functionName) const noexcept
+    {
+        if(handle == nullptr)
+            return nullptr;
+
+#if defined(_WIN32)
+        return reinterpret_cast<FunctionType*>(GetProcAddress((HMODULE)handle, functionName));
+#else
+        return reinterpret_cast<FunctionType*>(dlsym(handle, functionName));
+#endif
+    }
+
+    /** Returns the path of the module compiled for a given instruction set. */
+    static std::string getModulePath(const std::string& directory, const std::string& name, SIMDArch arch)
+    {
+#if defined(_WIN32)
+        const auto* extension = ".dll";
+#else
+        const auto* extension = ".so";
+#endif
+        return directory + "/" + name + getArchModuleSuffix(arch) + extension;
+    }
+
+private:
+    const SIMDArch arch;
+    void* handle = nullptr;
+};
+
+} // namespace RTNEURAL_NAMESPACE
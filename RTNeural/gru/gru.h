@@ -13,6 +13,7 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../low_rank.h"
 #include "../maths/maths_stl.h"
 #include <vector>
 
@@ -153,16 +154,22 @@ protected:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class GRULayerT
 {
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     GRULayerT();
 
     /** Returns the name of this layer. */
@@ -189,20 +196,22 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<(N > 1), void>::type
     forward(const T (&ins)[in_size]) noexcept
     {
+        recurrent_projection(outs);
+
         // compute zt
-        recurrent_mat_mul(outs, Uz, zt);
+        recurrent_mat_mul(outs, Uz, Uz_right, zt);
         kernel_mat_mul(ins, Wz, kernel_outs);
         for(int i = 0; i < out_size; ++i)
             zt[i] = MathsProvider::sigmoid(zt[i] + bz[i] + kernel_outs[i]);
 
         // compute rt
-        recurrent_mat_mul(outs, Ur, rt);
+        recurrent_mat_mul(outs, Ur, Ur_right, rt);
         kernel_mat_mul(ins, Wr, kernel_outs);
         for(int i = 0; i < out_size; ++i)
             rt[i] = MathsProvider::sigmoid(rt[i] + br[i] + kernel_outs[i]);
 
         // compute h_hat
-        recurrent_mat_mul(outs, Uh, ct);
+        recurrent_mat_mul(outs, Uh, Uh_right, ct);
         kernel_mat_mul(ins, Wh, kernel_outs);
         for(int i = 0; i < out_size; ++i)
             ht[i] = MathsProvider::tanh(rt[i] * (ct[i] + bh1[i]) + bh0[i] + kernel_outs[i]);
@@ -215,24 +224,45 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<N == 1, void>::type
     forward(const T (&ins)[in_size]) noexcept
     {
+        recurrent_projection(outs);
+
         // compute zt
-        recurrent_mat_mul(outs, Uz, zt);
+        recurrent_mat_mul(outs, Uz, Uz_right, zt);
         for(int i = 0; i < out_size; ++i)
             zt[i] = MathsProvider::sigmoid(zt[i] + bz[i] + (Wz_1[i] * ins[0]));
 
         // compute rt
-        recurrent_mat_mul(outs, Ur, rt);
+        recurrent_mat_mul(outs, Ur, Ur_right, rt);
         for(int i = 0; i < out_size; ++i)
             rt[i] = MathsProvider::sigmoid(rt[i] + br[i] + (Wr_1[i] * ins[0]));
 
         // compute h_hat
-        recurrent_mat_mul(outs, Uh, ct);
+        recurrent_mat_mul(outs, Uh, Uh_right, ct);
         for(int i = 0; i < out_size; ++i)
             ht[i] = MathsProvider::tanh(rt[i] * (ct[i] + bh1[i]) + bh0[i] + (Wh_1[i] * ins[0]));
 
         computeOutput();
     }
 
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size];
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(input + n * in_size, input + (n + 1) * in_size, x);
+            forward(x);
+            std::copy(outs, outs + out_size, output + n * out_size);
+        }
+    }
+
     /**
      * Sets the layer kernel weights.
      *
@@ -247,6 +277,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][3 * out_size] = left[out_size][rank] * right[rank][3 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -303,8 +345,21 @@ private:
         }
     }
 
-    static inline void recurrent_mat_mul(const T (&vec)[out_size], const T (&mat)[out_size][out_size], T (&out)[out_size]) noexcept
+    inline void recurrent_projection(const T (&vec)[out_size]) noexcept
+    {
+        for(int k = 0; k < recurrent_rank; ++k)
+            recurrent_proj[k] = std::inner_product(U_left[k], U_left[k] + out_size, vec, (T)0);
+    }
+
+    inline void recurrent_mat_mul(const T (&vec)[out_size], const T (&mat)[out_size][out_size], const T (&mat_right)[out_size][max_recurrent_rank], T (&out)[out_size]) noexcept
     {
+        if(recurrent_rank > 0)
+        {
+            for(int j = 0; j < out_size; ++j)
+                out[j] = std::inner_product(mat_right[j], mat_right[j] + recurrent_rank, recurrent_proj, (T)0);
+            return;
+        }
+
         for(int j = 0; j < out_size; ++j)
             out[j] = std::inner_product(mat[j], mat[j] + out_size, vec, (T)0);
     }
@@ -331,6 +386,14 @@ private:
     T Ur alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
     T Uh alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
 
+    // low-rank recurrent weights, with Uz = Uz_right * U_left (and likewise for Ur, Uh)
+    int recurrent_rank = 0;
+    T U_left alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_recurrent_rank][out_size] {};
+    T Uz_right alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][max_recurrent_rank] {};
+    T Ur_right alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][max_recurrent_rank] {};
+    T Uh_right alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][max_recurrent_rank] {};
+    T recurrent_proj alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_recurrent_rank] {};
+
     // biases
     T bz alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
     T br alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
@@ -4,6 +4,7 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../low_rank.h"
 #include "../maths/maths_eigen.h"
 
 namespace RTNEURAL_NAMESPACE
@@ -162,10 +163,13 @@ private:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class GRULayerT
 {
     using in_type = Eigen::Matrix<T, in_sizet, 1>;
@@ -173,6 +177,9 @@ class GRULayerT
     using out_type = Eigen::Matrix<T, out_sizet, 1>;
     using extended_out_type = Eigen::Matrix<T, out_sizet + 1, 1>;
 
+    // the sample-rate correction delay lines need an aligned allocator, since out_type may be over-aligned
+    using delay_vec_type = std::vector<out_type, Eigen::aligned_allocator<out_type>>;
+
     using w_k_type = Eigen::Matrix<T, out_sizet * 3, in_sizet + 1>;
     using u_k_type = Eigen::Matrix<T, out_sizet * 3, out_sizet + 1>;
 
@@ -183,6 +190,9 @@ public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     GRULayerT();
 
     /** Returns the name of this layer. */
@@ -220,9 +230,24 @@ public:
          *        | Uz bz[1] |   | h(t-1) |   | Uz * h(t-1) + bz[1] |
          * beta = | Ur br[1] | * | 1      | = | Ur * h(t-1) + br[1] |
          *        | Uc bc[1] |                | Uc * h(t-1) + bc[1] |
+         *
+         * The recurrent products are evaluated as lazy (coefficient-based)
+         * products, since the fixed-size products are small enough not to
+         * need Eigen's GEMV kernel, which GCC mis-analyses at -O3
+         * (-Waggressive-loop-optimizations).
          */
         alphaVec.noalias() = wCombinedWeights * extendedInVec;
-        betaVec.noalias() = uCombinedWeights * extendedHt1;
+        if(recurrent_rank > 0)
+        {
+            // beta = U_right * (U_left^T * h(t-1)) + b[1]
+            recurrentProj.head(recurrent_rank).noalias() = recurrentLeft.topRows(recurrent_rank).lazyProduct(extendedHt1.template head<out_sizet>());
+            betaVec = uCombinedWeights.col(out_sizet);
+            betaVec.noalias() += recurrentRight.leftCols(recurrent_rank).lazyProduct(recurrentProj.head(recurrent_rank));
+        }
+        else
+        {
+            betaVec.noalias() = uCombinedWeights.lazyProduct(extendedHt1);
+        }
 
         /**
          * gamma = sigmoid( | z |   = sigmoid(alpha[0 : 2*out_sizet] + beta[0 : 2*out_sizet])
@@ -247,6 +272,25 @@ public:
         computeOutput();
     }
 
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        if(recurrent_rank > 0)
+        {
+            forwardSamples(input, output, num_samples);
+            return;
+        }
+
+        processBlock(input, output, num_samples);
+    }
+
     /**
      * Sets the layer kernel weights.
      *
@@ -261,6 +305,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][3 * out_size] = left[out_size][rank] * right[rank][3 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -283,6 +339,45 @@ private:
         }
     }
 
+    inline void forwardSamples(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+        {
+            forward(Eigen::Map<const in_type>(input + n * in_sizet));
+            Eigen::Map<out_type>(output + n * out_sizet) = outs;
+        }
+    }
+
+    inline void processBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        // the layer state is kept in local variables for the whole block,
+        // and written back to the layer once all the samples are processed
+        extended_in_type x = extendedInVec;
+        extended_out_type h = extendedHt1;
+        three_out_type alpha, beta;
+        two_out_type gamma;
+        out_type c;
+
+        for(int n = 0; n < num_samples; ++n)
+        {
+            x.template segment<in_sizet>(0) = Eigen::Map<const in_type>(input + n * in_sizet);
+
+            alpha.noalias() = wCombinedWeights * x;
+            beta.noalias() = uCombinedWeights.lazyProduct(h);
+
+            gamma = MathsProvider::sigmoid(alpha.template segment<2 * out_sizet>(0) + beta.template segment<2 * out_sizet>(0));
+            c.noalias() = alpha.template segment<out_sizet>(2 * out_sizet) + gamma.template segment<out_sizet>(out_sizet).cwiseProduct(beta.template segment<out_sizet>(2 * out_sizet));
+            c = MathsProvider::tanh(c);
+            h.template segment<out_sizet>(0) = c + gamma.template segment<out_sizet>(0).cwiseProduct(h.template segment<out_sizet>(0) - c);
+
+            Eigen::Map<out_type>(output + n * out_sizet) = h.template segment<out_sizet>(0);
+        }
+
+        extendedInVec = x;
+        extendedHt1 = h;
+        outs = h.template segment<out_sizet>(0);
+    }
+
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr != SampleRateCorrectionMode::None, void>
     computeOutput() noexcept
@@ -302,7 +397,7 @@ private:
 
     template <typename OutVec, SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-    processDelay(std::vector<out_type>& delayVec, OutVec& out, int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, OutVec& out, int delayWriteIndex) noexcept
     {
         out = delayVec[0];
 
@@ -312,7 +407,7 @@ private:
 
     template <typename OutVec, SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-    processDelay(std::vector<out_type>& delayVec, OutVec& out, int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, OutVec& out, int delayWriteIndex) noexcept
     {
         out = delayPlus1Mult * delayVec[0] + delayMult * delayVec[1];
 
@@ -324,6 +419,12 @@ private:
     w_k_type wCombinedWeights;
     u_k_type uCombinedWeights;
 
+    // low-rank recurrent weights, with U = (recurrentRight * recurrentLeft)^T
+    int recurrent_rank = 0;
+    Eigen::Matrix<T, max_recurrent_rank, out_sizet> recurrentLeft;
+    Eigen::Matrix<T, 3 * out_sizet, max_recurrent_rank> recurrentRight;
+    Eigen::Matrix<T, max_recurrent_rank, 1> recurrentProj;
+
     // scratch memory
     three_out_type alphaVec;
     three_out_type betaVec;
@@ -335,7 +436,7 @@ private:
     extended_out_type extendedHt1;
 
     // needed for delays when doing sample rate correction
-    std::vector<out_type> outs_delayed;
+    delay_vec_type outs_delayed;
     int delayWriteIdx = 0;
     T delayMult = (T)1;
     T delayPlus1Mult = (T)0;
@@ -136,8 +136,8 @@ T GRULayer<T, MathsProvider>::getBVal(int i, int k) const noexcept
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::GRULayerT()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::GRULayerT()
     : outs(outs_internal)
 {
     wCombinedWeights = w_k_type::Zero();
@@ -155,10 +155,10 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::GRULayerT()
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int delaySamples)
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(int delaySamples)
 {
     delayWriteIdx = delaySamples - 1;
     outs_delayed.resize(delayWriteIdx + 1, {});
@@ -166,10 +166,10 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int de
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T delaySamples)
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(T delaySamples)
 {
     const auto delayOffFactor = delaySamples - std::floor(delaySamples);
     delayMult = (T)1 - delayOffFactor;
@@ -181,8 +181,8 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T dela
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::reset()
 {
     if(sampleRateCorr != SampleRateCorrectionMode::None)
     {
@@ -199,8 +199,8 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
 }
 
 // kernel weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < in_size; ++i)
     {
@@ -212,8 +212,8 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(
 }
 
 // recurrent weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     for(int i = 0; i < out_size; ++i)
     {
@@ -222,11 +222,35 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(
             uCombinedWeights(k, i) = uVals[i][k];
         }
     }
+
+    recurrent_rank = 0;
+}
+
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+{
+    const auto rank = (int)right.size();
+    if(rank > max_recurrent_rank)
+    {
+        setUVals(low_rank::multiply(left, right));
+        return;
+    }
+
+    for(int r = 0; r < rank; ++r)
+    {
+        for(int i = 0; i < out_size; ++i)
+            recurrentLeft(r, i) = left[i][r];
+
+        for(int k = 0; k < out_size * 3; ++k)
+            recurrentRight(k, r) = right[r][k];
+    }
+
+    recurrent_rank = rank;
 }
 
 // biases
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setBVals(const std::vector<std::vector<T>>& bVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setBVals(const std::vector<std::vector<T>>& bVals)
 {
     for(int k = 0; k < out_size * 3; ++k)
     {
@@ -4,7 +4,10 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../dense/dense_sparse_xsimd.h"
+#include "../low_rank.h"
 #include "../maths/maths_xsimd.h"
+#include <algorithm>
 #include <vector>
 namespace RTNEURAL_NAMESPACE
 {
@@ -42,34 +45,32 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        for(int i = 0; i < Layer<T>::out_size; ++i)
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        // compute all three gates with a single pass over each weight matrix
+        vCopy(bias[0].data(), kernel_outs.data(), 3 * out_size_padded);
+        vMatVecAccum(W.data(), input, kernel_outs.data(), Layer<T>::in_size, 3 * out_size_padded);
+
+        vCopy(bias[1].data(), recurrent_outs.data(), 3 * out_size_padded);
+        vMatVecAccum(U.data(), ht1.data(), recurrent_outs.data(), Layer<T>::out_size, 3 * out_size_padded);
+
+        const auto* kz = kernel_outs.data();
+        const auto* kr = kz + out_size_padded;
+        const auto* kc = kr + out_size_padded;
+        const auto* rz = recurrent_outs.data();
+        const auto* rr = rz + out_size_padded;
+        const auto* rc = rr + out_size_padded;
+        for(int i = 0; i < out_size_padded; i += inc)
         {
-            zVec[i] = vMult(zWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(zWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-            rVec[i] = vMult(rWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(rWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-            cVec[i] = vMult(cWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size);
-            cTmp[i] = vMult(cWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
+            const auto zt = MathsProvider::sigmoid(xsimd::load_aligned(&kz[i]) + xsimd::load_aligned(&rz[i]));
+            const auto rt = MathsProvider::sigmoid(xsimd::load_aligned(&kr[i]) + xsimd::load_aligned(&rr[i]));
+            const auto ct = MathsProvider::tanh(xsimd::fma(rt, xsimd::load_aligned(&rc[i]), xsimd::load_aligned(&kc[i])));
+            const auto ht = xsimd::fma(zt, xsimd::load_aligned(&ht1[i]) - ct, ct);
+            xsimd::store_aligned(&ht1[i], ht);
         }
 
-        vAdd(zVec.data(), zWeights.b[0].data(), zVec.data(), Layer<T>::out_size);
-        vAdd(zVec.data(), zWeights.b[1].data(), zVec.data(), Layer<T>::out_size);
-        sigmoid<T, MathsProvider>(zVec.data(), zVec.data(), Layer<T>::out_size);
-
-        vAdd(rVec.data(), rWeights.b[0].data(), rVec.data(), Layer<T>::out_size);
-        vAdd(rVec.data(), rWeights.b[1].data(), rVec.data(), Layer<T>::out_size);
-        sigmoid<T, MathsProvider>(rVec.data(), rVec.data(), Layer<T>::out_size);
-
-        vAdd(cTmp.data(), cWeights.b[1].data(), cTmp.data(), Layer<T>::out_size);
-        vProd(cTmp.data(), rVec.data(), cTmp.data(), Layer<T>::out_size);
-        vAdd(cTmp.data(), cVec.data(), cVec.data(), Layer<T>::out_size);
-        vAdd(cVec.data(), cWeights.b[0].data(), cVec.data(), Layer<T>::out_size);
-        tanh<T, MathsProvider>(cVec.data(), cVec.data(), Layer<T>::out_size);
-
-        vSub(ones.data(), zVec.data(), h, Layer<T>::out_size);
-        vProd(h, cVec.data(), h, Layer<T>::out_size);
-        vProd(zVec.data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-        vAdd(h, prod_out.data(), h, Layer<T>::out_size);
-
-        vCopy(h, ht1.data(), Layer<T>::out_size);
+        std::copy(ht1.begin(), ht1.begin() + Layer<T>::out_size, h);
     }
 
     /**
@@ -125,33 +126,25 @@ public:
 
 protected:
     using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
-    using vec2_type = std::vector<vec_type>;
+
+    /** Returns the index of a gate weight in a packed [z | r | c] column. */
+    inline int gateIndex(int k) const noexcept
+    {
+        return (k / Layer<T>::out_size) * out_size_padded + (k % Layer<T>::out_size);
+    }
+
+    const int out_size_padded;
 
     vec_type ht1;
 
-    struct WeightSet
-    {
-        WeightSet(int in_size, int out_size);
-        ~WeightSet();
-
-        vec2_type W; // kernel weights
-        vec2_type U; // recurrent weights
-        vec_type b[2]; // bias
-        const int out_size;
-    };
-
-    WeightSet zWeights;
-    WeightSet rWeights;
-    WeightSet cWeights;
-
-    vec_type zVec;
-    vec_type rVec;
-    vec_type cVec;
-    vec_type cTmp;
-
-    vec_type prod_in;
-    vec_type prod_out;
-    vec_type ones;
+    // weights are stored column-major, with the z, r, and c
+    // gates packed into each (padded) column: [z | r | c]
+    vec_type W; // kernel weights: W[in_size][3 * out_size_padded]
+    vec_type U; // recurrent weights: U[out_size][3 * out_size_padded]
+    vec_type bias[2]; // kernel and recurrent biases
+
+    vec_type kernel_outs;
+    vec_type recurrent_outs;
 };
 
 //====================================================
@@ -167,10 +160,13 @@ protected:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * If `block_sparse` is true, the layer skips the all-zero SIMD-width blocks
+ * in its (pruned) weights, once at least half of the blocks are zero.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class GRULayerT
 {
     using v_type = xsimd::simd_type<T>;
@@ -178,10 +174,17 @@ class GRULayerT
     static constexpr auto v_in_size = ceil_div(in_sizet, v_size);
     static constexpr auto v_out_size = ceil_div(out_sizet, v_size);
 
+    // storage for the sample-rate correction delay lines (SIMD registers must be heap-allocated with an aligned allocator)
+    using delay_type = std::array<v_type, v_out_size>;
+    using delay_vec_type = std::vector<delay_type, xsimd::aligned_allocator<delay_type>>;
+
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     GRULayerT();
 
     /** Returns the name of this layer. */
@@ -208,21 +211,23 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<(N > 1), void>::type
     forward(const v_type (&ins)[v_in_size]) noexcept
     {
+        recurrent_projection(outs);
+
         // compute zt
-        recurrent_mat_mul(outs, Uz, zt);
-        kernel_mat_mul(ins, Wz, kernel_outs);
+        recurrent_mat_mul(outs, Uz, Uz_index, Uz_right, zt);
+        kernel_mat_mul(ins, Wz, Wz_index, kernel_outs);
         for(int i = 0; i < v_out_size; ++i)
             zt[i] = MathsProvider::sigmoid(zt[i] + bz[i] + kernel_outs[i]);
 
         // compute rt
-        recurrent_mat_mul(outs, Ur, rt);
-        kernel_mat_mul(ins, Wr, kernel_outs);
+        recurrent_mat_mul(outs, Ur, Ur_index, Ur_right, rt);
+        kernel_mat_mul(ins, Wr, Wr_index, kernel_outs);
         for(int i = 0; i < v_out_size; ++i)
             rt[i] = MathsProvider::sigmoid(rt[i] + br[i] + kernel_outs[i]);
 
         // compute h_hat
-        recurrent_mat_mul(outs, Uh, ct);
-        kernel_mat_mul(ins, Wh, kernel_outs);
+        recurrent_mat_mul(outs, Uh, Uh_index, Uh_right, ct);
+        kernel_mat_mul(ins, Wh, Wh_index, kernel_outs);
         for(int i = 0; i < v_out_size; ++i)
             ht[i] = MathsProvider::tanh(xsimd::fma(rt[i], ct[i] + bh1[i], bh0[i] + kernel_outs[i]));
 
@@ -234,24 +239,61 @@ public:
     RTNEURAL_REALTIME inline typename std::enable_if<N == 1, void>::type
     forward(const v_type (&ins)[v_in_size]) noexcept
     {
+        recurrent_projection(outs);
+
         // compute zt
-        recurrent_mat_mul(outs, Uz, zt);
+        recurrent_mat_mul(outs, Uz, Uz_index, Uz_right, zt);
         for(int i = 0; i < v_out_size; ++i)
             zt[i] = MathsProvider::sigmoid(xsimd::fma(Wz_1[i], ins[0], zt[i] + bz[i]));
 
         // compute rt
-        recurrent_mat_mul(outs, Ur, rt);
+        recurrent_mat_mul(outs, Ur, Ur_index, Ur_right, rt);
         for(int i = 0; i < v_out_size; ++i)
             rt[i] = MathsProvider::sigmoid(xsimd::fma(Wr_1[i], ins[0], rt[i] + br[i]));
 
         // compute h_hat
-        recurrent_mat_mul(outs, Uh, ct);
+        recurrent_mat_mul(outs, Uh, Uh_index, Uh_right, ct);
         for(int i = 0; i < v_out_size; ++i)
             ht[i] = MathsProvider::tanh(xsimd::fma(rt[i], ct[i] + bh1[i], xsimd::fma(Wh_1[i], ins[0], bh0[i])));
 
         computeOutput();
     }
 
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        T x_scalar alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size] {};
+        T h_scalar alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+        v_type x[v_in_size];
+        for(int n = 0; n < num_samples; ++n)
+        {
+            RTNEURAL_IF_CONSTEXPR(in_size == 1)
+            {
+                // single inputs are broadcast, like in ModelT::forward()
+                x[0] = v_type(input[n]);
+            }
+            else
+            {
+                std::copy(input + n * in_size, input + (n + 1) * in_size, x_scalar);
+                for(int i = 0; i < v_in_size; ++i)
+                    x[i] = xsimd::load_aligned(&x_scalar[i * v_size]);
+            }
+
+            forward(x);
+
+            for(int i = 0; i < v_out_size; ++i)
+                outs[i].store_aligned(&h_scalar[i * v_size]);
+            std::copy(h_scalar, h_scalar + out_size, output + n * out_size);
+        }
+    }
+
     /**
      * Sets the layer kernel weights.
      *
@@ -266,6 +308,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][3 * out_size] = left[out_size][rank] * right[rank][3 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -273,9 +327,18 @@ public:
      */
     RTNEURAL_REALTIME void setBVals(const std::vector<std::vector<T>>& bVals);
 
+    /** Returns true if the layer is skipping the zero blocks in any of its (pruned) weights. */
+    bool isSparse() const noexcept
+    {
+        return Wz_index.isEnabled() || Wr_index.isEnabled() || Wh_index.isEnabled()
+            || Uz_index.isEnabled() || Ur_index.isEnabled() || Uh_index.isEnabled();
+    }
+
     v_type outs[v_out_size];
 
 private:
+    static constexpr auto v_max_recurrent_rank = ceil_div(max_recurrent_rank, v_size);
+
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
     computeOutput() noexcept
@@ -296,7 +359,7 @@ private:
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-    processDelay(std::vector<std::array<v_type, v_out_size>>& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = delayVec[0][i];
@@ -310,7 +373,7 @@ private:
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-    processDelay(std::vector<std::array<v_type, v_out_size>>& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = delayPlus1Mult * delayVec[0][i] + delayMult * delayVec[1][i];
@@ -322,35 +385,107 @@ private:
         }
     }
 
-    static inline void recurrent_mat_mul(const v_type (&vec)[v_out_size], const v_type (&mat)[out_size][v_out_size], v_type (&out)[v_out_size]) noexcept
+    using kernel_index_type = SparseBlockIndexT<T, in_size, v_out_size, block_sparse>;
+    using recurrent_index_type = SparseBlockIndexT<T, out_size, v_out_size, block_sparse>;
+
+    inline void recurrent_projection(const v_type (&vec)[v_out_size]) noexcept
+    {
+        if(recurrent_rank == 0)
+            return;
+
+        T scalar_vec alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+        for(int k = 0; k < v_out_size; ++k)
+            vec[k].store_aligned(&scalar_vec[k * v_size]);
+
+        const auto v_rank = ceil_div(recurrent_rank, v_size);
+        v_type proj[v_max_recurrent_rank];
+        for(int i = 0; i < v_rank; ++i)
+            proj[i] = v_type((T)0);
+
+        for(int k = 0; k < out_size; ++k)
+        {
+            const v_type x_k(scalar_vec[k]);
+            for(int i = 0; i < v_rank; ++i)
+                proj[i] = xsimd::fma(U_left[k][i], x_k, proj[i]);
+        }
+
+        for(int i = 0; i < v_rank; ++i)
+            proj[i].store_aligned(&recurrent_proj[i * v_size]);
+    }
+
+    inline void recurrent_mat_mul(const v_type (&vec)[v_out_size], const v_type (&mat)[out_size][v_out_size], const recurrent_index_type& index,
+        const v_type (&mat_right)[max_recurrent_rank][v_out_size], v_type (&out)[v_out_size]) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = v_type(0);
 
+        if(recurrent_rank > 0)
+        {
+            for(int k = 0; k < recurrent_rank; ++k)
+            {
+                const v_type p_k(recurrent_proj[k]);
+                for(int i = 0; i < v_out_size; ++i)
+                    out[i] = xsimd::fma(mat_right[k][i], p_k, out[i]);
+            }
+            return;
+        }
+
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
+        {
+            if(index.isEnabled())
+            {
+                T scalar_vec alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+                for(int k = 0; k < v_out_size; ++k)
+                    vec[k].store_aligned(&scalar_vec[k * v_size]);
+
+                index.accumulate(scalar_vec, mat, out);
+                return;
+            }
+        }
+
         T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
         for(int k = 0; k < v_out_size; ++k)
         {
+            // the last block of the vector may be partially filled
+            const auto v_size_inner = out_size - k * v_size < v_size ? out_size - k * v_size : v_size;
+
             vec[k].store_aligned(scalar_in);
             for(int i = 0; i < v_out_size; ++i)
             {
-                for(int j = 0; j < v_size; ++j)
+                for(int j = 0; j < v_size_inner; ++j)
                     out[i] += scalar_in[j] * mat[k * v_size + j][i];
             }
         }
     }
 
-    static inline void kernel_mat_mul(const v_type (&vec)[v_in_size], const v_type (&mat)[in_size][v_out_size], v_type (&out)[v_out_size]) noexcept
+    static inline void kernel_mat_mul(const v_type (&vec)[v_in_size], const v_type (&mat)[in_size][v_out_size], const kernel_index_type& index, v_type (&out)[v_out_size]) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = v_type(0);
 
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
+        {
+            if(index.isEnabled())
+            {
+                T scalar_vec alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size];
+                for(int k = 0; k < v_in_size; ++k)
+                    vec[k].store_aligned(&scalar_vec[k * v_size]);
+
+                index.accumulate(scalar_vec, mat, out);
+                return;
+            }
+        }
+
         T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
         for(int k = 0; k < v_in_size; ++k)
         {
+            // the last block of the vector may be partially filled
+            const auto v_size_inner = in_size - k * v_size < v_size ? in_size - k * v_size : v_size;
+
             vec[k].store_aligned(scalar_in);
             for(int i = 0; i < v_out_size; ++i)
             {
-                for(int j = 0; j < v_size; ++j)
+                for(int j = 0; j < v_size_inner; ++j)
                     out[i] += scalar_in[j] * mat[k * v_size + j][i];
             }
         }
@@ -372,6 +507,19 @@ private:
     v_type Ur[out_size][v_out_size];
     v_type Uh[out_size][v_out_size];
 
+    // indices of the non-zero weights, for pruned layers
+    kernel_index_type Wz_index, Wr_index, Wh_index;
+    recurrent_index_type Uz_index, Ur_index, Uh_index;
+
+    // low-rank recurrent weights: the state is projected onto
+    // the columns of U_left, and then multiplied by U*_right
+    int recurrent_rank = 0;
+    v_type U_left[out_size][v_max_recurrent_rank];
+    v_type Uz_right[max_recurrent_rank][v_out_size];
+    v_type Ur_right[max_recurrent_rank][v_out_size];
+    v_type Uh_right[max_recurrent_rank][v_out_size];
+    T recurrent_proj alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_max_recurrent_rank * v_size] {};
+
     // biases
     v_type bz[v_out_size];
     v_type br[v_out_size];
@@ -385,7 +533,7 @@ private:
     v_type ht[v_out_size];
 
     // needed for delays when doing sample rate correction
-    std::vector<std::array<v_type, v_out_size>> outs_delayed;
+    delay_vec_type outs_delayed;
     int delayWriteIdx = 0;
     v_type delayMult = (T)1;
     v_type delayPlus1Mult = (T)0;
@@ -6,20 +6,17 @@ namespace RTNEURAL_NAMESPACE
 template <typename T, typename MathsProvider>
 GRULayer<T, MathsProvider>::GRULayer(int in_size, int out_size)
     : Layer<T>(in_size, out_size)
-    , zWeights(in_size, out_size)
-    , rWeights(in_size, out_size)
-    , cWeights(in_size, out_size)
+    , out_size_padded(simd_padded_size<T>(out_size))
 {
-    ht1.resize(out_size, (T)0);
-    zVec.resize(out_size, (T)0);
-    rVec.resize(out_size, (T)0);
-    cVec.resize(out_size, (T)0);
-    cTmp.resize(out_size, (T)0);
+    ht1.resize(out_size_padded, (T)0);
 
-    prod_in.resize(in_size, (T)0);
-    prod_out.resize(out_size, (T)0);
+    W.resize(in_size * 3 * out_size_padded, (T)0);
+    U.resize(out_size * 3 * out_size_padded, (T)0);
+    bias[0].resize(3 * out_size_padded, (T)0);
+    bias[1].resize(3 * out_size_padded, (T)0);
 
-    ones.resize(out_size, (T)1);
+    kernel_outs.resize(3 * out_size_padded, (T)0);
+    recurrent_outs.resize(3 * out_size_padded, (T)0);
 }
 
 template <typename T, typename MathsProvider>
@@ -43,161 +40,75 @@ GRULayer<T, MathsProvider>& GRULayer<T, MathsProvider>::operator=(const GRULayer
 template <typename T, typename MathsProvider>
 GRULayer<T, MathsProvider>::~GRULayer() = default;
 
-template <typename T, typename MathsProvider>
-GRULayer<T, MathsProvider>::WeightSet::WeightSet(int in_size, int out_size)
-    : out_size(out_size)
-{
-    W = vec2_type(out_size, vec_type(in_size, (T)0));
-    U = vec2_type(out_size, vec_type(out_size, (T)0));
-
-    b[0].resize(out_size, (T)0);
-    b[1].resize(out_size, (T)0);
-}
-
-template <typename T, typename MathsProvider>
-GRULayer<T, MathsProvider>::WeightSet::~WeightSet() = default;
-
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < Layer<T>::in_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.W[k][i] = wVals[i][k];
-            rWeights.W[k][i] = wVals[i][k + Layer<T>::out_size];
-            cWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            W[i * 3 * out_size_padded + gateIndex(k)] = wVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setWVals(T** wVals)
 {
     for(int i = 0; i < Layer<T>::in_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.W[k][i] = wVals[i][k];
-            rWeights.W[k][i] = wVals[i][k + Layer<T>::out_size];
-            cWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            W[i * 3 * out_size_padded + gateIndex(k)] = wVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.U[k][i] = uVals[i][k];
-            rWeights.U[k][i] = uVals[i][k + Layer<T>::out_size];
-            cWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            U[i * 3 * out_size_padded + gateIndex(k)] = uVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setUVals(T** uVals)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.U[k][i] = uVals[i][k];
-            rWeights.U[k][i] = uVals[i][k + Layer<T>::out_size];
-            cWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            U[i * 3 * out_size_padded + gateIndex(k)] = uVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setBVals(const std::vector<std::vector<T>>& bVals)
 {
     for(int i = 0; i < 2; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.b[i][k] = bVals[i][k];
-            rWeights.b[i][k] = bVals[i][k + Layer<T>::out_size];
-            cWeights.b[i][k] = bVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            bias[i][gateIndex(k)] = bVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void GRULayer<T, MathsProvider>::setBVals(T** bVals)
 {
     for(int i = 0; i < 2; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            zWeights.b[i][k] = bVals[i][k];
-            rWeights.b[i][k] = bVals[i][k + Layer<T>::out_size];
-            cWeights.b[i][k] = bVals[i][k + Layer<T>::out_size * 2];
-        }
-    }
+        for(int k = 0; k < 3 * Layer<T>::out_size; ++k)
+            bias[i][gateIndex(k)] = bVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 T GRULayer<T, MathsProvider>::getWVal(int i, int k) const noexcept
 {
-    T** set = zWeights.W;
-    if(k > 2 * Layer<T>::out_size)
-    {
-        k -= 2 * Layer<T>::out_size;
-        set = cWeights.W;
-    }
-    else if(k > Layer<T>::out_size)
-    {
-        k -= Layer<T>::out_size;
-        set = rWeights.W;
-    }
-
-    return set[i][k];
+    return W[i * 3 * out_size_padded + gateIndex(k)];
 }
 
 template <typename T, typename MathsProvider>
 T GRULayer<T, MathsProvider>::getUVal(int i, int k) const noexcept
 {
-    T** set = zWeights.U;
-    if(k > 2 * Layer<T>::out_size)
-    {
-        k -= 2 * Layer<T>::out_size;
-        set = cWeights.U;
-    }
-    else if(k > Layer<T>::out_size)
-    {
-        k -= Layer<T>::out_size;
-        set = rWeights.U;
-    }
-
-    return set[i][k];
+    return U[i * 3 * out_size_padded + gateIndex(k)];
 }
 
 template <typename T, typename MathsProvider>
 T GRULayer<T, MathsProvider>::getBVal(int i, int k) const noexcept
 {
-    T** set = zWeights.b;
-    if(k > 2 * Layer<T>::out_size)
-    {
-        k -= 2 * Layer<T>::out_size;
-        set = cWeights.b;
-    }
-    else if(k > Layer<T>::out_size)
-    {
-        k -= Layer<T>::out_size;
-        set = rWeights.b;
-    }
-
-    return set[i][k];
+    return bias[i][gateIndex(k)];
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::GRULayerT()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::GRULayerT()
 {
     for(int i = 0; i < v_out_size; ++i)
     {
@@ -239,15 +150,28 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::GRULayerT()
             Ur[i][k] = v_type((T)0);
             Uh[i][k] = v_type((T)0);
         }
+
+        for(int k = 0; k < v_max_recurrent_rank; ++k)
+            U_left[i][k] = v_type((T)0);
+    }
+
+    for(int k = 0; k < max_recurrent_rank; ++k)
+    {
+        for(int i = 0; i < v_out_size; ++i)
+        {
+            Uz_right[k][i] = v_type((T)0);
+            Ur_right[k][i] = v_type((T)0);
+            Uh_right[k][i] = v_type((T)0);
+        }
     }
 
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int delaySamples)
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(int delaySamples)
 {
     delayWriteIdx = delaySamples - 1;
     outs_delayed.resize(delayWriteIdx + 1, {});
@@ -255,10 +179,10 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int de
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T delaySamples)
+GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(T delaySamples)
 {
     const auto delayOffFactor = delaySamples - std::floor(delaySamples);
     delayMult = (T)1 - delayOffFactor;
@@ -270,8 +194,8 @@ GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T dela
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::reset()
 {
     if(sampleRateCorr != SampleRateCorrectionMode::None)
     {
@@ -285,8 +209,8 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
 }
 
 // kernel weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < out_size; ++i)
     {
@@ -304,11 +228,15 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(
         Wr_1[j / v_size] = set_value(Wr_1[j / v_size], j % v_size, wVals[0][j + out_size]);
         Wh_1[j / v_size] = set_value(Wh_1[j / v_size], j % v_size, wVals[0][j + 2 * out_size]);
     }
+
+    Wz_index.update(Wz);
+    Wr_index.update(Wr);
+    Wh_index.update(Wh);
 }
 
 // recurrent weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     for(int i = 0; i < out_size; ++i)
     {
@@ -319,11 +247,44 @@ void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(
             Uh[k][i / v_size] = set_value(Uh[k][i / v_size], i % v_size, uVals[k][i + 2 * out_size]);
         }
     }
+
+    Uz_index.update(Uz);
+    Ur_index.update(Ur);
+    Uh_index.update(Uh);
+
+    recurrent_rank = 0;
+}
+
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+{
+    const auto rank = (int)right.size();
+    if(rank > max_recurrent_rank)
+    {
+        setUVals(low_rank::multiply(left, right));
+        return;
+    }
+
+    for(int k = 0; k < out_size; ++k)
+        for(int r = 0; r < rank; ++r)
+            U_left[k][r / v_size] = set_value(U_left[k][r / v_size], r % v_size, left[k][r]);
+
+    for(int r = 0; r < rank; ++r)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            Uz_right[r][i / v_size] = set_value(Uz_right[r][i / v_size], i % v_size, right[r][i]);
+            Ur_right[r][i / v_size] = set_value(Ur_right[r][i / v_size], i % v_size, right[r][i + out_size]);
+            Uh_right[r][i / v_size] = set_value(Uh_right[r][i / v_size], i % v_size, right[r][i + 2 * out_size]);
+        }
+    }
+
+    recurrent_rank = rank;
 }
 
 // biases
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setBVals(const std::vector<std::vector<T>>& bVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void GRULayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setBVals(const std::vector<std::vector<T>>& bVals)
 {
     for(int k = 0; k < out_size; ++k)
     {
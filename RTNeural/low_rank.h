@@ -0,0 +1,212 @@
+#pragma once
+
+#include "config.h"
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <vector>
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Utilities for approximating weight matrices with low-rank factors.
+ *
+ * A matrix W[rows][cols] is approximated by the product
+ * left[rows][rank] * right[rank][cols], so that multiplying by
+ * the matrix costs (rows + cols) * rank operations, rather than
+ * rows * cols operations.
+ */
+namespace low_rank
+{
+    /** Low-rank factors of a matrix, mat ~= left * right. */
+    template <typename T>
+    struct Factors
+    {
+        std::vector<std::vector<T>> left; // left[rows][rank]
+        std::vector<std::vector<T>> right; // right[rank][cols]
+        int rank = 0;
+
+        /** The relative (Frobenius norm) error of the approximation. */
+        double error = 0.0;
+    };
+
+    /** Returns the product of two matrices, left[rows][rank] * right[rank][cols]. */
+    template <typename T>
+    std::vector<std::vector<T>> multiply(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        const auto rows = left.size();
+        const auto rank = right.size();
+        const auto cols = rank > 0 ? right[0].size() : 0;
+
+        std::vector<std::vector<T>> mat(rows, std::vector<T>(cols, (T)0));
+        for(size_t i = 0; i < rows; ++i)
+        {
+            for(size_t k = 0; k < rank; ++k)
+            {
+                for(size_t j = 0; j < cols; ++j)
+                    mat[i][j] += left[i][k] * right[k][j];
+            }
+        }
+
+        return mat;
+    }
+
+#ifndef DOXYGEN
+    namespace detail
+    {
+        /**
+         * Singular value decomposition of a matrix, stored as columns a[n][m],
+         * using one-sided Jacobi rotations. On return, the columns of `a` are
+         * the left singular vectors scaled by the singular values, and the
+         * columns of `v` (stored as v[n][n]) are the right singular vectors.
+         */
+        inline void jacobiSVD(std::vector<std::vector<double>>& a, std::vector<std::vector<double>>& v)
+        {
+            constexpr int max_sweeps = 64;
+            constexpr double eps = 1.0e-15;
+
+            const auto n = a.size();
+            v.assign(n, std::vector<double>(n, 0.0));
+            for(size_t j = 0; j < n; ++j)
+                v[j][j] = 1.0;
+
+            for(int sweep = 0; sweep < max_sweeps; ++sweep)
+            {
+                bool rotated = false;
+                for(size_t p = 0; p + 1 < n; ++p)
+                {
+                    for(size_t q = p + 1; q < n; ++q)
+                    {
+                        auto& ap = a[p];
+                        auto& aq = a[q];
+                        const auto alpha = std::inner_product(ap.begin(), ap.end(), ap.begin(), 0.0);
+                        const auto beta = std::inner_product(aq.begin(), aq.end(), aq.begin(), 0.0);
+                        const auto gamma = std::inner_product(ap.begin(), ap.end(), aq.begin(), 0.0);
+                        if(std::abs(gamma) <= eps * std::sqrt(alpha * beta))
+                            continue;
+
+                        rotated = true;
+                        const auto zeta = (beta - alpha) / (2.0 * gamma);
+                        const auto t = (zeta >= 0.0 ? 1.0 : -1.0) / (std::abs(zeta) + std::sqrt(1.0 + zeta * zeta));
+                        const auto c = 1.0 / std::sqrt(1.0 + t * t);
+                        const auto s = c * t;
+
+                        for(size_t i = 0; i < ap.size(); ++i)
+                        {
+                            const auto x = ap[i];
+                            ap[i] = c * x - s * aq[i];
+                            aq[i] = s * x + c * aq[i];
+                        }
+
+                        for(size_t i = 0; i < n; ++i)
+                        {
+                            const auto x = v[p][i];
+                            v[p][i] = c * x - s * v[q][i];
+                            v[q][i] = s * x + c * v[q][i];
+                        }
+                    }
+                }
+
+                if(!rotated)
+                    break;
+            }
+        }
+
+        /**
+         * Computes the truncated SVD of mat[rows][cols], keeping either
+         * a fixed rank (if rank > 0), or the smallest rank that keeps the
+         * relative error below the given tolerance.
+         */
+        template <typename T>
+        Factors<T> factorize(const std::vector<std::vector<T>>& mat, int rank, double tolerance)
+        {
+            const auto rows = mat.size();
+            const auto cols = rows > 0 ? mat[0].size() : 0;
+
+            // decompose whichever of mat or mat^T has fewer columns,
+            // since the Jacobi sweeps are quadratic in the number of columns
+            const bool transposed = rows < cols;
+            const auto n = transposed ? rows : cols;
+            const auto m = transposed ? cols : rows;
+
+            std::vector<std::vector<double>> a(n, std::vector<double>(m));
+            for(size_t i = 0; i < rows; ++i)
+            {
+                for(size_t j = 0; j < cols; ++j)
+                {
+                    if(transposed)
+                        a[i][j] = (double)mat[i][j];
+                    else
+                        a[j][i] = (double)mat[i][j];
+                }
+            }
+
+            std::vector<std::vector<double>> v;
+            jacobiSVD(a, v);
+
+            std::vector<double> sigma_sq(n);
+            for(size_t j = 0; j < n; ++j)
+                sigma_sq[j] = std::inner_product(a[j].begin(), a[j].end(), a[j].begin(), 0.0);
+
+            std::vector<size_t> order(n);
+            std::iota(order.begin(), order.end(), (size_t)0);
+            std::sort(order.begin(), order.end(), [&sigma_sq](size_t x, size_t y)
+                { return sigma_sq[x] > sigma_sq[y]; });
+
+            // residual[r] is the squared error of the rank-r approximation
+            std::vector<double> residual(n + 1, 0.0);
+            for(size_t r = n; r > 0; --r)
+                residual[r - 1] = residual[r] + sigma_sq[order[r - 1]];
+            const auto total = residual[0] > 0.0 ? residual[0] : 1.0;
+
+            if(rank <= 0)
+            {
+                rank = 1;
+                while(rank < (int)n && std::sqrt(residual[(size_t)rank] / total) > tolerance)
+                    ++rank;
+            }
+            rank = std::min(rank, (int)n);
+
+            Factors<T> factors;
+            factors.rank = rank;
+            factors.error = std::sqrt(residual[(size_t)rank] / total);
+            factors.left.assign(rows, std::vector<T>((size_t)rank));
+            factors.right.assign((size_t)rank, std::vector<T>(cols));
+
+            // mat = sum_k a[k] * v[k]^T, where a[k] is scaled by the k-th singular value
+            for(size_t k = 0; k < (size_t)rank; ++k)
+            {
+                const auto& u_k = a[order[k]];
+                const auto& v_k = v[order[k]];
+                for(size_t i = 0; i < rows; ++i)
+                    factors.left[i][k] = (T)(transposed ? v_k[i] : u_k[i]);
+                for(size_t j = 0; j < cols; ++j)
+                    factors.right[k][j] = (T)(transposed ? u_k[j] : v_k[j]);
+            }
+
+            return factors;
+        }
+    } // namespace detail
+#endif // DOXYGEN
+
+    /**
+     * Approximates a matrix mat[rows][cols] with the rank-r factors
+     * that minimise the approximation error (i.e. a truncated SVD).
+     */
+    template <typename T>
+    Factors<T> factorizeWithRank(const std::vector<std::vector<T>>& mat, int rank)
+    {
+        return detail::factorize(mat, std::max(rank, 1), 0.0);
+    }
+
+    /**
+     * Approximates a matrix mat[rows][cols] with the lowest-rank factors
+     * whose relative error (in the Frobenius norm) is at most `tolerance`.
+     */
+    template <typename T>
+    Factors<T> factorizeWithTolerance(const std::vector<std::vector<T>>& mat, double tolerance)
+    {
+        return detail::factorize(mat, 0, tolerance);
+    }
+} // namespace low_rank
+} // namespace RTNEURAL_NAMESPACE
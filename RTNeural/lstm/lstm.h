@@ -11,6 +11,7 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../low_rank.h"
 #include "../maths/maths_stl.h"
 #include <vector>
 
@@ -50,18 +51,29 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        for(int i = 0; i < Layer<T>::out_size; ++i)
+        const auto out_size = Layer<T>::out_size;
+
+        // compute all four gates with a single pass over each weight matrix
+        std::copy(bias.begin(), bias.end(), gates.begin());
+        vMatVecAccum(W.data(), input, gates.data(), Layer<T>::in_size, 4 * out_size);
+        vMatVecAccum(U.data(), ht1.data(), gates.data(), out_size, 4 * out_size);
+
+        for(int j = 0; j < 3 * out_size; ++j)
+            gates[j] = MathsProvider::sigmoid(gates[j]);
+        for(int j = 3 * out_size; j < 4 * out_size; ++j)
+            gates[j] = MathsProvider::tanh(gates[j]);
+
+        const auto* it = gates.data();
+        const auto* ft = it + out_size;
+        const auto* ot = ft + out_size;
+        const auto* cHat = ot + out_size;
+        for(int i = 0; i < out_size; ++i)
         {
-            fVec[i] = MathsProvider::sigmoid(vMult(fWeights.W[i], input, Layer<T>::in_size) + vMult(fWeights.U[i], ht1, Layer<T>::out_size) + fWeights.b[i]);
-            iVec[i] = MathsProvider::sigmoid(vMult(iWeights.W[i], input, Layer<T>::in_size) + vMult(iWeights.U[i], ht1, Layer<T>::out_size) + iWeights.b[i]);
-            oVec[i] = MathsProvider::sigmoid(vMult(oWeights.W[i], input, Layer<T>::in_size) + vMult(oWeights.U[i], ht1, Layer<T>::out_size) + oWeights.b[i]);
-            ctVec[i] = MathsProvider::tanh(vMult(cWeights.W[i], input, Layer<T>::in_size) + vMult(cWeights.U[i], ht1, Layer<T>::out_size) + cWeights.b[i]);
-            cVec[i] = fVec[i] * ct1[i] + iVec[i] * ctVec[i];
-            h[i] = oVec[i] * MathsProvider::tanh(cVec[i]);
+            ct1[i] = ft[i] * ct1[i] + it[i] * cHat[i];
+            h[i] = ot[i] * MathsProvider::tanh(ct1[i]);
         }
 
-        std::copy(cVec, cVec + Layer<T>::out_size, ct1);
-        std::copy(h, h + Layer<T>::out_size, ht1);
+        std::copy(h, h + out_size, ht1.begin());
     }
 
     /**
@@ -86,31 +98,23 @@ public:
     RTNEURAL_REALTIME void setBVals(const std::vector<T>& bVals);
 
 protected:
-    T* ht1;
-    T* ct1;
-
-    /** Struct to hold layer weights (used internally) */
-    struct WeightSet
+    /** Returns the index of a packed [i | f | o | c] gate, given an index into the [i | f | c | o] weights. */
+    inline int gateIndex(int k) const noexcept
     {
-        WeightSet(int in_size, int out_size);
-        ~WeightSet();
-
-        T** W; // kernel weights
-        T** U; // recurrent weights
-        T* b; // bias
-        const int out_size;
-    };
-
-    WeightSet fWeights;
-    WeightSet iWeights;
-    WeightSet oWeights;
-    WeightSet cWeights;
-
-    T* fVec;
-    T* iVec;
-    T* oVec;
-    T* ctVec;
-    T* cVec;
+        const auto gate = k / Layer<T>::out_size;
+        return (gate == 2 ? 3 : (gate == 3 ? 2 : gate)) * Layer<T>::out_size + k % Layer<T>::out_size;
+    }
+
+    std::vector<T> ht1;
+    std::vector<T> ct1;
+
+    // weights are stored column-major, with the i, f, o, and c gates
+    // packed into each column, so that the sigmoid gates are contiguous
+    std::vector<T> W; // kernel weights: W[in_size][4 * out_size]
+    std::vector<T> U; // recurrent weights: U[out_size][4 * out_size]
+    std::vector<T> bias;
+
+    std::vector<T> gates;
 };
 
 //====================================================
@@ -126,16 +130,27 @@ protected:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class LSTMLayerT
 {
+    // the gates are packed as [i | f | o | c], so that the sigmoid
+    // gates are contiguous, followed by the tanh gate
+    static constexpr auto gates_size = 4 * out_sizet;
+    static constexpr auto sigmoid_gates_size = 3 * out_sizet;
+
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     LSTMLayerT();
 
     /** Returns the name of this layer. */
@@ -158,52 +173,42 @@ public:
     RTNEURAL_REALTIME void reset();
 
     /** Performs forward propagation for this layer. */
-    template <int N = in_size>
-    RTNEURAL_REALTIME inline typename std::enable_if<(N > 1), void>::type
-    forward(const T (&ins)[in_size]) noexcept
+    RTNEURAL_REALTIME inline void forward(const T (&ins)[in_size]) noexcept
     {
-        // compute ft
-        recurrent_mat_mul(outs, Uf, ft);
-        kernel_mat_mul(ins, Wf, kernel_outs);
-        for(int i = 0; i < out_size; ++i)
-            ft[i] = MathsProvider::sigmoid(ft[i] + bf[i] + kernel_outs[i]);
+        // compute all four gates with a single pass over the packed weights
+        std::copy(b, b + gates_size, gates);
 
-        // compute it
-        recurrent_mat_mul(outs, Ui, it);
-        kernel_mat_mul(ins, Wi, kernel_outs);
-        for(int i = 0; i < out_size; ++i)
-            it[i] = MathsProvider::sigmoid(it[i] + bi[i] + kernel_outs[i]);
+        for(int k = 0; k < in_size; ++k)
+            for(int j = 0; j < gates_size; ++j)
+                gates[j] += W[k][j] * ins[k];
 
-        // compute ot
-        recurrent_mat_mul(outs, Uo, ot);
-        kernel_mat_mul(ins, Wo, kernel_outs);
-        for(int i = 0; i < out_size; ++i)
-            ot[i] = MathsProvider::sigmoid(ot[i] + bo[i] + kernel_outs[i]);
+        recurrent_mat_mul(outs);
+
+        for(int j = 0; j < sigmoid_gates_size; ++j)
+            gates[j] = MathsProvider::sigmoid(gates[j]);
+        for(int j = sigmoid_gates_size; j < gates_size; ++j)
+            gates[j] = MathsProvider::tanh(gates[j]);
 
-        computeOutputs(ins);
+        computeOutputs();
     }
 
-    /** Performs forward propagation for this layer. */
-    template <int N = in_size>
-    RTNEURAL_REALTIME inline typename std::enable_if<N == 1, void>::type
-    forward(const T (&ins)[in_size]) noexcept
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
     {
-        // compute ft
-        recurrent_mat_mul(outs, Uf, ft);
-        for(int i = 0; i < out_size; ++i)
-            ft[i] = MathsProvider::sigmoid(ft[i] + bf[i] + (Wf_1[i] * ins[0]));
-
-        // compute it
-        recurrent_mat_mul(outs, Ui, it);
-        for(int i = 0; i < out_size; ++i)
-            it[i] = MathsProvider::sigmoid(it[i] + bi[i] + (Wi_1[i] * ins[0]));
-
-        // compute ot
-        recurrent_mat_mul(outs, Uo, ot);
-        for(int i = 0; i < out_size; ++i)
-            ot[i] = MathsProvider::sigmoid(ot[i] + bo[i] + (Wo_1[i] * ins[0]));
-
-        computeOutputs(ins);
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size];
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(input + n * in_size, input + (n + 1) * in_size, x);
+            forward(x);
+            std::copy(outs, outs + out_size, output + n * out_size);
+        }
     }
 
     /**
@@ -220,6 +225,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][4 * out_size] = left[out_size][rank] * right[rank][4 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -230,50 +247,62 @@ public:
     T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
 
 private:
+    /** Returns the index of a packed [i | f | o | c] gate, given an index into the [i | f | c | o] weights. */
+    static constexpr int gateIndex(int k) noexcept
+    {
+        return (k / out_size == 2 ? 3 : (k / out_size == 3 ? 2 : k / out_size)) * out_size + k % out_size;
+    }
+
+    inline void recurrent_mat_mul(const T (&vec)[out_size]) noexcept
+    {
+        if(recurrent_rank > 0)
+        {
+            // project the state down to the recurrent rank, and then back up to the gates
+            std::fill(recurrent_proj, recurrent_proj + recurrent_rank, (T)0);
+            for(int k = 0; k < out_size; ++k)
+                for(int r = 0; r < recurrent_rank; ++r)
+                    recurrent_proj[r] += U_left[k][r] * vec[k];
+
+            for(int r = 0; r < recurrent_rank; ++r)
+                for(int j = 0; j < gates_size; ++j)
+                    gates[j] += U_right[r][j] * recurrent_proj[r];
+            return;
+        }
+
+        for(int k = 0; k < out_size; ++k)
+            for(int j = 0; j < gates_size; ++j)
+                gates[j] += U[k][j] * vec[k];
+    }
+
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
-    computeOutputs(const T (&ins)[in_size]) noexcept
+    computeOutputs() noexcept
     {
-        computeOutputsInternal(ins, ct, outs);
+        computeOutputsInternal(ct, outs);
     }
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr != SampleRateCorrectionMode::None, void>
-    computeOutputs(const T (&ins)[in_size]) noexcept
+    computeOutputs() noexcept
     {
-        computeOutputsInternal(ins, ct_delayed[delayWriteIdx], outs_delayed[delayWriteIdx]);
+        computeOutputsInternal(ct_delayed[delayWriteIdx], outs_delayed[delayWriteIdx]);
 
         processDelay(ct_delayed, ct, delayWriteIdx);
         processDelay(outs_delayed, outs, delayWriteIdx);
     }
 
-    template <typename VecType, int N = in_size>
-    inline std::enable_if_t<(N > 1), void>
-    computeOutputsInternal(const T (&ins)[in_size], VecType& ctVec, VecType& outsVec) noexcept
-    {
-        // compute ct
-        recurrent_mat_mul(outs, Uc, ht);
-        kernel_mat_mul(ins, Wc, kernel_outs);
-        for(int i = 0; i < out_size; ++i)
-            ctVec[i] = it[i] * MathsProvider::tanh(ht[i] + bc[i] + kernel_outs[i]) + ft[i] * ct[i];
-
-        // compute output
-        for(int i = 0; i < out_size; ++i)
-            outsVec[i] = ot[i] * MathsProvider::tanh(ctVec[i]);
-    }
-
-    template <typename VecType, int N = in_size>
-    inline std::enable_if_t<N == 1, void>
-    computeOutputsInternal(const T (&ins)[in_size], VecType& ctVec, VecType& outsVec) noexcept
+    template <typename VecType>
+    inline void computeOutputsInternal(VecType& ctVec, VecType& outsVec) noexcept
     {
-        // compute ct
-        recurrent_mat_mul(outs, Uc, ht);
-        for(int i = 0; i < out_size; ++i)
-            ctVec[i] = it[i] * MathsProvider::tanh(ht[i] + bc[i] + (Wc_1[i] * ins[0])) + ft[i] * ct[i];
-
-        // compute output
+        const auto* it = gates;
+        const auto* ft = gates + out_size;
+        const auto* ot = gates + 2 * out_size;
+        const auto* cHat = gates + 3 * out_size;
         for(int i = 0; i < out_size; ++i)
+        {
+            ctVec[i] = it[i] * cHat[i] + ft[i] * ct[i];
             outsVec[i] = ot[i] * MathsProvider::tanh(ctVec[i]);
+        }
     }
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
@@ -304,48 +333,19 @@ private:
         }
     }
 
-    static inline void recurrent_mat_mul(const T (&vec)[out_size], const T (&mat)[out_size][out_size], T (&out)[out_size]) noexcept
-    {
-        for(int j = 0; j < out_size; ++j)
-            out[j] = std::inner_product(mat[j], mat[j] + out_size, vec, (T)0);
-    }
-
-    static inline void kernel_mat_mul(const T (&vec)[in_size], const T (&mat)[out_size][in_size], T (&out)[out_size]) noexcept
-    {
-        for(int j = 0; j < out_size; ++j)
-            out[j] = std::inner_product(mat[j], mat[j] + in_size, vec, (T)0);
-    }
+    // packed [i | f | o | c] weights
+    T W alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size][gates_size]; // kernel weights
+    T U alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][gates_size]; // recurrent weights
+    T b alignas(RTNEURAL_DEFAULT_ALIGNMENT)[gates_size]; // biases
 
-    // kernel weights
-    T Wf alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][in_size];
-    T Wi alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][in_size];
-    T Wo alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][in_size];
-    T Wc alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][in_size];
-    T kernel_outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-
-    // single-input kernel weights
-    T Wf_1 alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T Wi_1 alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T Wo_1 alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T Wc_1 alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-
-    // recurrent weights
-    T Uf alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
-    T Ui alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
-    T Uo alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
-    T Uc alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][out_size];
-
-    // biases
-    T bf alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T bi alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T bo alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T bc alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+    // low-rank recurrent weights, with U = U_left * U_right
+    int recurrent_rank = 0;
+    T U_left alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size][max_recurrent_rank] {};
+    T U_right alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_recurrent_rank][gates_size] {};
+    T recurrent_proj alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_recurrent_rank] {};
 
     // intermediate vars
-    T ft alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T it alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T ot alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
-    T ht alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+    T gates alignas(RTNEURAL_DEFAULT_ALIGNMENT)[gates_size];
     T ct alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
 
     // needed for delays when doing sample rate correction
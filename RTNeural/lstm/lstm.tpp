@@ -8,19 +8,15 @@ namespace RTNEURAL_NAMESPACE
 template <typename T, typename MathsProvider>
 LSTMLayer<T, MathsProvider>::LSTMLayer(int in_size, int out_size)
     : Layer<T>(in_size, out_size)
-    , fWeights(in_size, out_size)
-    , iWeights(in_size, out_size)
-    , oWeights(in_size, out_size)
-    , cWeights(in_size, out_size)
 {
-    ht1 = new T[out_size];
-    ct1 = new T[out_size];
-
-    fVec = new T[out_size];
-    iVec = new T[out_size];
-    oVec = new T[out_size];
-    ctVec = new T[out_size];
-    cVec = new T[out_size];
+    ht1.resize(out_size, (T)0);
+    ct1.resize(out_size, (T)0);
+
+    W.resize(in_size * 4 * out_size, (T)0);
+    U.resize(out_size * 4 * out_size, (T)0);
+    bias.resize(4 * out_size, (T)0);
+
+    gates.resize(4 * out_size, (T)0);
 }
 
 template <typename T, typename MathsProvider>
@@ -44,150 +40,66 @@ LSTMLayer<T, MathsProvider>& LSTMLayer<T, MathsProvider>::operator=(const LSTMLa
 }
 
 template <typename T, typename MathsProvider>
-LSTMLayer<T, MathsProvider>::~LSTMLayer()
-{
-    delete[] ht1;
-    delete[] ct1;
-
-    delete[] fVec;
-    delete[] iVec;
-    delete[] oVec;
-    delete[] ctVec;
-    delete[] cVec;
-}
+LSTMLayer<T, MathsProvider>::~LSTMLayer() = default;
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::reset()
 {
-    std::fill(ht1, ht1 + Layer<T>::out_size, (T)0);
-    std::fill(ct1, ct1 + Layer<T>::out_size, (T)0);
-}
-
-template <typename T, typename MathsProvider>
-LSTMLayer<T, MathsProvider>::WeightSet::WeightSet(int in_size, int out_size)
-    : out_size(out_size)
-{
-    W = new T*[out_size];
-    U = new T*[out_size];
-    b = new T[out_size];
-
-    for(int i = 0; i < out_size; ++i)
-    {
-        W[i] = new T[in_size];
-        U[i] = new T[out_size];
-    }
-}
-
-template <typename T, typename MathsProvider>
-LSTMLayer<T, MathsProvider>::WeightSet::~WeightSet()
-{
-    delete[] b;
-
-    for(int i = 0; i < out_size; ++i)
-    {
-        delete[] W[i];
-        delete[] U[i];
-    }
-
-    delete[] W;
-    delete[] U;
+    std::fill(ht1.begin(), ht1.end(), (T)0);
+    std::fill(ct1.begin(), ct1.end(), (T)0);
 }
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < Layer<T>::in_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            iWeights.W[k][i] = wVals[i][k];
-            fWeights.W[k][i] = wVals[i][k + Layer<T>::out_size];
-            cWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 2];
-            oWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 3];
-        }
-    }
+        for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+            W[i * 4 * Layer<T>::out_size + gateIndex(k)] = wVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            iWeights.U[k][i] = uVals[i][k];
-            fWeights.U[k][i] = uVals[i][k + Layer<T>::out_size];
-            cWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 2];
-            oWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 3];
-        }
-    }
+        for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+            U[i * 4 * Layer<T>::out_size + gateIndex(k)] = uVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setBVals(const std::vector<T>& bVals)
 {
-    for(int k = 0; k < Layer<T>::out_size; ++k)
-    {
-        iWeights.b[k] = bVals[k];
-        fWeights.b[k] = bVals[k + Layer<T>::out_size];
-        cWeights.b[k] = bVals[k + Layer<T>::out_size * 2];
-        oWeights.b[k] = bVals[k + Layer<T>::out_size * 3];
-    }
+    for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+        bias[gateIndex(k)] = bVals[k];
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::LSTMLayerT()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::LSTMLayerT()
 {
-    for(int i = 0; i < out_size; ++i)
+    for(int j = 0; j < gates_size; ++j)
     {
-        // single-input kernel weights
-        Wf_1[i] = (T)0;
-        Wi_1[i] = (T)0;
-        Wo_1[i] = (T)0;
-        Wc_1[i] = (T)0;
-
-        // biases
-        bf[i] = (T)0;
-        bi[i] = (T)0;
-        bo[i] = (T)0;
-        bc[i] = (T)0;
-
-        // intermediate vars
-        ft[i] = (T)0;
-        it[i] = (T)0;
-        ot[i] = (T)0;
-        ht[i] = (T)0;
-    }
+        // kernel weights
+        for(int k = 0; k < in_size; ++k)
+            W[k][j] = (T)0;
 
-    for(int i = 0; i < out_size; ++i)
-    {
         // recurrent weights
         for(int k = 0; k < out_size; ++k)
-        {
-            Uf[i][k] = (T)0;
-            Ui[i][k] = (T)0;
-            Uo[i][k] = (T)0;
-            Uc[i][k] = (T)0;
-        }
+            U[k][j] = (T)0;
 
-        // kernel weights
-        for(int k = 0; k < in_size; ++k)
-        {
-            Wf[i][k] = (T)0;
-            Wi[i][k] = (T)0;
-            Wo[i][k] = (T)0;
-            Wc[i][k] = (T)0;
-        }
+        // biases
+        b[j] = (T)0;
+
+        // intermediate vars
+        gates[j] = (T)0;
     }
 
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(int delaySamples)
 {
     delayWriteIdx = delaySamples - 1;
     ct_delayed.resize(delayWriteIdx + 1, {});
@@ -196,10 +108,10 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int d
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(T delaySamples)
 {
     const auto delayOffFactor = delaySamples - std::floor(delaySamples);
     delayMult = (T)1 - delayOffFactor;
@@ -212,8 +124,8 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T del
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::reset()
 {
     if(sampleRateCorr != SampleRateCorrectionMode::None)
     {
@@ -232,54 +144,50 @@ void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
     }
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
-    for(int i = 0; i < in_size; ++i)
-    {
-        for(int j = 0; j < out_size; ++j)
-        {
-            Wi[j][i] = wVals[i][j];
-            Wf[j][i] = wVals[i][j + out_size];
-            Wc[j][i] = wVals[i][j + 2 * out_size];
-            Wo[j][i] = wVals[i][j + 3 * out_size];
-        }
-    }
+    for(int k = 0; k < in_size; ++k)
+        for(int j = 0; j < gates_size; ++j)
+            W[k][gateIndex(j)] = wVals[k][j];
+}
 
-    for(int j = 0; j < out_size; ++j)
-    {
-        Wi_1[j] = wVals[0][j];
-        Wf_1[j] = wVals[0][j + out_size];
-        Wc_1[j] = wVals[0][j + 2 * out_size];
-        Wo_1[j] = wVals[0][j + 3 * out_size];
-    }
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUVals(const std::vector<std::vector<T>>& uVals)
+{
+    for(int k = 0; k < out_size; ++k)
+        for(int j = 0; j < gates_size; ++j)
+            U[k][gateIndex(j)] = uVals[k][j];
+
+    recurrent_rank = 0;
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
 {
-    for(int i = 0; i < out_size; ++i)
+    const auto rank = (int)right.size();
+    if(rank > max_recurrent_rank)
     {
-        for(int j = 0; j < out_size; ++j)
-        {
-            Ui[j][i] = uVals[i][j];
-            Uf[j][i] = uVals[i][j + out_size];
-            Uc[j][i] = uVals[i][j + 2 * out_size];
-            Uo[j][i] = uVals[i][j + 3 * out_size];
-        }
+        setUVals(low_rank::multiply(left, right));
+        return;
     }
+
+    for(int k = 0; k < out_size; ++k)
+        for(int r = 0; r < rank; ++r)
+            U_left[k][r] = left[k][r];
+
+    for(int r = 0; r < rank; ++r)
+        for(int j = 0; j < gates_size; ++j)
+            U_right[r][gateIndex(j)] = right[r][j];
+
+    recurrent_rank = rank;
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setBVals(const std::vector<T>& bVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setBVals(const std::vector<T>& bVals)
 {
-    for(int k = 0; k < out_size; ++k)
-    {
-        bi[k] = bVals[k];
-        bf[k] = bVals[k + out_size];
-        bc[k] = bVals[k + 2 * out_size];
-        bo[k] = bVals[k + 3 * out_size];
-    }
+    for(int j = 0; j < gates_size; ++j)
+        b[gateIndex(j)] = bVals[j];
 }
 
 #endif // !RTNEURAL_USE_EIGEN && !RTNEURAL_USE_XSIMD
@@ -4,6 +4,7 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../low_rank.h"
 #include "../maths/maths_eigen.h"
 
 namespace RTNEURAL_NAMESPACE
@@ -120,10 +121,13 @@ private:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * `block_sparse` is only used by the XSIMD backend (where the layer skips
+ * the all-zero blocks in pruned weights), and is ignored here.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class LSTMLayerT
 {
     using weights_combined_type = Eigen::Matrix<T, 4 * out_sizet, in_sizet + out_sizet + 1>;
@@ -134,10 +138,16 @@ class LSTMLayerT
     using in_type = Eigen::Matrix<T, in_sizet, 1>;
     using out_type = Eigen::Matrix<T, out_sizet, 1>;
 
+    // the sample-rate correction delay lines need an aligned allocator, since out_type may be over-aligned
+    using delay_vec_type = std::vector<out_type, Eigen::aligned_allocator<out_type>>;
+
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     LSTMLayerT();
 
     /** Returns the name of this layer. */
@@ -173,7 +183,10 @@ public:
          * | o  |   | Wo  Uo  Bo  |   | 1     |
          * | ct |   | Wct Uct Bct |
          */
-        fioctsVecs.noalias() = combinedWeights * extendedInHt1Vec;
+        if(recurrent_rank > 0)
+            lowRankGates();
+        else
+            fioctsVecs.noalias() = combinedWeights * extendedInHt1Vec;
 
         fioVecs = MathsProvider::sigmoid(fioctsVecs.segment(0, 3 * out_sizet));
         ctVec = MathsProvider::tanh(fioctsVecs.segment(3 * out_sizet, out_sizet));
@@ -181,6 +194,25 @@ public:
         computeOutputs();
     }
 
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        if(recurrent_rank > 0)
+        {
+            forwardSamples(input, output, num_samples);
+            return;
+        }
+
+        processBlock(input, output, num_samples);
+    }
+
     /**
      * Sets the layer kernel weights.
      *
@@ -195,6 +227,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][4 * out_size] = left[out_size][rank] * right[rank][4 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -247,9 +291,59 @@ private:
         outsVec.noalias() = fioVecs.segment(out_sizet * 2, out_sizet).cwiseProduct(cTanhVec);
     }
 
+    inline void lowRankGates() noexcept
+    {
+        // the kernel weights and biases, followed by the
+        // recurrent weights: U_right * (U_left^T * ht1)
+        fioctsVecs.noalias() = combinedWeights.template leftCols<in_sizet>() * extendedInHt1Vec.template head<in_sizet>();
+        fioctsVecs += combinedWeights.col(in_sizet + out_sizet);
+
+        recurrentProj.head(recurrent_rank).noalias() = recurrentLeft.topRows(recurrent_rank) * extendedInHt1Vec.template segment<out_sizet>(in_sizet);
+        fioctsVecs.noalias() += recurrentRight.leftCols(recurrent_rank) * recurrentProj.head(recurrent_rank);
+    }
+
+    inline void forwardSamples(const T* input, T* output, int num_samples) noexcept
+    {
+        for(int n = 0; n < num_samples; ++n)
+        {
+            forward(Eigen::Map<const in_type>(input + n * in_sizet));
+            Eigen::Map<out_type>(output + n * out_sizet) = outs;
+        }
+    }
+
+    inline void processBlock(const T* input, T* output, int num_samples) noexcept
+    {
+        // the layer state is kept in local variables for the whole block,
+        // and written back to the layer once all the samples are processed
+        extended_in_out_type x = extendedInHt1Vec;
+        out_type c = cVec;
+        four_out_type gates;
+        three_out_type fio;
+        out_type g;
+
+        for(int n = 0; n < num_samples; ++n)
+        {
+            x.template segment<in_sizet>(0) = Eigen::Map<const in_type>(input + n * in_sizet);
+
+            gates.noalias() = combinedWeights * x;
+            fio = MathsProvider::sigmoid(gates.template segment<3 * out_sizet>(0));
+            g = MathsProvider::tanh(gates.template segment<out_sizet>(3 * out_sizet));
+
+            c = fio.template segment<out_sizet>(0).cwiseProduct(c) + fio.template segment<out_sizet>(out_sizet).cwiseProduct(g);
+            g = MathsProvider::tanh(c);
+            x.template segment<out_sizet>(in_sizet) = fio.template segment<out_sizet>(2 * out_sizet).cwiseProduct(g);
+
+            Eigen::Map<out_type>(output + n * out_sizet) = x.template segment<out_sizet>(in_sizet);
+        }
+
+        extendedInHt1Vec = x;
+        cVec = c;
+        outs = x.template segment<out_sizet>(in_sizet);
+    }
+
     template <typename OutVec, SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-    processDelay(std::vector<out_type>& delayVec, OutVec& out, int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, OutVec& out, int delayWriteIndex) noexcept
     {
         out = delayVec[0];
 
@@ -259,7 +353,7 @@ private:
 
     template <typename OutVec, SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-    processDelay(std::vector<out_type>& delayVec, OutVec& out, int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, OutVec& out, int delayWriteIndex) noexcept
     {
         out = delayPlus1Mult * delayVec[0] + delayMult * delayVec[1];
 
@@ -270,6 +364,13 @@ private:
     // kernel weights
     weights_combined_type combinedWeights;
     extended_in_out_type extendedInHt1Vec;
+
+    // low-rank recurrent weights, with U = (recurrentRight * recurrentLeft)^T
+    int recurrent_rank = 0;
+    Eigen::Matrix<T, max_recurrent_rank, out_sizet> recurrentLeft;
+    Eigen::Matrix<T, 4 * out_sizet, max_recurrent_rank> recurrentRight;
+    Eigen::Matrix<T, max_recurrent_rank, 1> recurrentProj;
+
     four_out_type fioctsVecs;
     three_out_type fioVecs;
     out_type cTanhVec;
@@ -279,8 +380,8 @@ private:
     out_type cVec;
 
     // needed for delays when doing sample rate correction
-    std::vector<out_type> ct_delayed;
-    std::vector<out_type> outs_delayed;
+    delay_vec_type ct_delayed;
+    delay_vec_type outs_delayed;
     int delayWriteIdx = 0;
     T delayMult = (T)1;
     T delayPlus1Mult = (T)0;
@@ -94,12 +94,15 @@ void LSTMLayer<T, MathsProvider>::setBVals(const std::vector<T>& bVals)
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::LSTMLayerT()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::LSTMLayerT()
     : outs(outs_internal)
 {
     combinedWeights = weights_combined_type::Zero();
     extendedInHt1Vec = extended_in_out_type::Zero();
+    recurrentLeft.setZero();
+    recurrentRight.setZero();
+    recurrentProj.setZero();
     fioctsVecs = four_out_type::Zero();
     fioVecs = three_out_type::Zero();
 
@@ -109,10 +112,10 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::LSTMLayerT()
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(int delaySamples)
 {
     delayWriteIdx = delaySamples - 1;
     ct_delayed.resize(delayWriteIdx + 1, {});
@@ -121,10 +124,10 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int d
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(T delaySamples)
 {
     const auto delayOffFactor = delaySamples - std::floor(delaySamples);
     delayMult = (T)1 - delayOffFactor;
@@ -137,8 +140,8 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T del
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::reset()
 {
     if(sampleRateCorr != SampleRateCorrectionMode::None)
     {
@@ -158,8 +161,8 @@ void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
 }
 
 // kernel weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < in_size; ++i)
     {
@@ -174,8 +177,8 @@ void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals
 }
 
 // recurrent weights
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     int col;
     for(int i = 0; i < out_size; ++i)
@@ -189,11 +192,40 @@ void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals
             combinedWeights(k + out_sizet * 3, col) = uVals[i][k + out_sizet * 2]; // Uc
         }
     }
+
+    recurrent_rank = 0;
+}
+
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+{
+    const auto rank = (int)right.size();
+    if(rank > max_recurrent_rank)
+    {
+        setUVals(low_rank::multiply(left, right));
+        return;
+    }
+
+    for(int r = 0; r < rank; ++r)
+    {
+        for(int i = 0; i < out_size; ++i)
+            recurrentLeft(r, i) = left[i][r];
+
+        for(int k = 0; k < out_size; ++k)
+        {
+            recurrentRight(k, r) = right[r][k + out_sizet]; // Uf
+            recurrentRight(k + out_sizet, r) = right[r][k]; // Ui
+            recurrentRight(k + out_sizet * 2, r) = right[r][k + out_sizet * 3]; // Uo
+            recurrentRight(k + out_sizet * 3, r) = right[r][k + out_sizet * 2]; // Uc
+        }
+    }
+
+    recurrent_rank = rank;
 }
 
 // biases
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setBVals(const std::vector<T>& bVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setBVals(const std::vector<T>& bVals)
 {
     int col = in_size + out_size;
     for(int k = 0; k < out_size; ++k)
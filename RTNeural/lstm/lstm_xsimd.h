@@ -4,7 +4,10 @@
 #include "../Layer.h"
 #include "../common.h"
 #include "../config.h"
+#include "../dense/dense_sparse_xsimd.h"
+#include "../low_rank.h"
 #include "../maths/maths_xsimd.h"
+#include <algorithm>
 #include <vector>
 
 namespace RTNEURAL_NAMESPACE
@@ -43,35 +46,29 @@ public:
     /** Performs forward propagation for this layer. */
     RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
     {
-        for(int i = 0; i < Layer<T>::out_size; ++i)
+        using b_type = xsimd::simd_type<T>;
+        constexpr auto inc = (int)b_type::size;
+
+        // compute all four gates with a single pass over each weight matrix
+        vCopy(bias.data(), gates.data(), 4 * out_size_padded);
+        vMatVecAccum(W.data(), input, gates.data(), Layer<T>::in_size, 4 * out_size_padded);
+        vMatVecAccum(U.data(), ht1.data(), gates.data(), Layer<T>::out_size, 4 * out_size_padded);
+
+        const auto* gi = gates.data();
+        const auto* gf = gi + out_size_padded;
+        const auto* gc = gf + out_size_padded;
+        const auto* go = gc + out_size_padded;
+        for(int i = 0; i < out_size_padded; i += inc)
         {
-            fVec[i] = vMult(fWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(fWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-            iVec[i] = vMult(iWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(iWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-            oVec[i] = vMult(oWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(oWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
-            ctVec[i] = vMult(cWeights.W[i].data(), input, prod_in.data(), Layer<T>::in_size) + vMult(cWeights.U[i].data(), ht1.data(), prod_out.data(), Layer<T>::out_size);
+            const auto it = MathsProvider::sigmoid(xsimd::load_aligned(&gi[i]));
+            const auto ft = MathsProvider::sigmoid(xsimd::load_aligned(&gf[i]));
+            const auto ot = MathsProvider::sigmoid(xsimd::load_aligned(&go[i]));
+            const auto ct = xsimd::fma(it, MathsProvider::tanh(xsimd::load_aligned(&gc[i])), ft * xsimd::load_aligned(&ct1[i]));
+            xsimd::store_aligned(&ct1[i], ct);
+            xsimd::store_aligned(&ht1[i], ot * MathsProvider::tanh(ct));
         }
 
-        vAdd(fVec.data(), fWeights.b.data(), fVec.data(), Layer<T>::out_size);
-        sigmoid<T, MathsProvider>(fVec.data(), fVec.data(), Layer<T>::out_size);
-
-        vAdd(iVec.data(), iWeights.b.data(), iVec.data(), Layer<T>::out_size);
-        sigmoid<T, MathsProvider>(iVec.data(), iVec.data(), Layer<T>::out_size);
-
-        vAdd(oVec.data(), oWeights.b.data(), oVec.data(), Layer<T>::out_size);
-        sigmoid<T, MathsProvider>(oVec.data(), oVec.data(), Layer<T>::out_size);
-
-        vAdd(ctVec.data(), cWeights.b.data(), ctVec.data(), Layer<T>::out_size);
-        tanh<T, MathsProvider>(ctVec.data(), ctVec.data(), Layer<T>::out_size);
-
-        vProd(fVec.data(), ct1.data(), cVec.data(), Layer<T>::out_size);
-        vProd(iVec.data(), ctVec.data(), prod_out.data(), Layer<T>::out_size);
-        vAdd(cVec.data(), prod_out.data(), cVec.data(), Layer<T>::out_size);
-
-        tanh<T, MathsProvider>(cVec.data(), h, Layer<T>::out_size);
-        vProd(h, oVec.data(), h, Layer<T>::out_size);
-
-        vCopy(cVec.data(), ct1.data(), Layer<T>::out_size);
-        vCopy(h, ht1.data(), Layer<T>::out_size);
+        std::copy(ht1.begin(), ht1.begin() + Layer<T>::out_size, h);
     }
 
     /**
@@ -97,35 +94,25 @@ public:
 
 protected:
     using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
-    using vec2_type = std::vector<vec_type>;
+
+    /** Returns the index of a gate weight in a packed [i | f | c | o] column. */
+    inline int gateIndex(int k) const noexcept
+    {
+        return (k / Layer<T>::out_size) * out_size_padded + (k % Layer<T>::out_size);
+    }
+
+    const int out_size_padded;
 
     vec_type ht1;
     vec_type ct1;
 
-    struct WeightSet
-    {
-        WeightSet(int in_size, int out_size);
-        ~WeightSet();
-
-        vec2_type W; // kernel weights
-        vec2_type U; // recurrent weights
-        vec_type b; // bias
-        const int out_size;
-    };
-
-    WeightSet fWeights;
-    WeightSet iWeights;
-    WeightSet oWeights;
-    WeightSet cWeights;
-
-    vec_type fVec;
-    vec_type iVec;
-    vec_type oVec;
-    vec_type ctVec;
-    vec_type cVec;
-
-    vec_type prod_in;
-    vec_type prod_out;
+    // weights are stored column-major, with the i, f, c, and o
+    // gates packed into each (padded) column: [i | f | c | o]
+    vec_type W; // kernel weights: W[in_size][4 * out_size_padded]
+    vec_type U; // recurrent weights: U[out_size][4 * out_size_padded]
+    vec_type bias;
+
+    vec_type gates;
 };
 
 //====================================================
@@ -141,10 +128,13 @@ protected:
  * behave by default as if the parameter `stateful=True`. A "stateless"
  * GRU can be achieved by calling the `reset()` function in between
  * calls to `forward()`.
+ *
+ * If `block_sparse` is true, the layer skips the all-zero SIMD-width blocks
+ * in its (pruned) weights, once at least half of the blocks are zero.
  */
 template <typename T, int in_sizet, int out_sizet,
     SampleRateCorrectionMode sampleRateCorr = SampleRateCorrectionMode::None,
-    typename MathsProvider = DefaultMathsProvider>
+    typename MathsProvider = DefaultMathsProvider, bool block_sparse = false>
 class LSTMLayerT
 {
     using v_type = xsimd::simd_type<T>;
@@ -152,10 +142,22 @@ class LSTMLayerT
     static constexpr auto v_in_size = ceil_div(in_sizet, v_size);
     static constexpr auto v_out_size = ceil_div(out_sizet, v_size);
 
+    // storage for the sample-rate correction delay lines (SIMD registers must be heap-allocated with an aligned allocator)
+    using delay_type = std::array<v_type, v_out_size>;
+    using delay_vec_type = std::vector<delay_type, xsimd::aligned_allocator<delay_type>>;
+
+    // the gates are packed as [i | f | o | c], so that the sigmoid
+    // gates are contiguous, followed by the tanh gate
+    static constexpr auto v_gates_size = 4 * v_out_size;
+    static constexpr auto v_sigmoid_gates_size = 3 * v_out_size;
+
 public:
     static constexpr auto in_size = in_sizet;
     static constexpr auto out_size = out_sizet;
 
+    /** The largest rank that can be used for low-rank recurrent weights. */
+    static constexpr int max_recurrent_rank = out_sizet / 2 > 0 ? out_sizet / 2 : 1;
+
     LSTMLayerT();
 
     /** Returns the name of this layer. */
@@ -178,52 +180,56 @@ public:
     RTNEURAL_REALTIME void reset();
 
     /** Performs forward propagation for this layer. */
-    template <int N = in_size>
-    RTNEURAL_REALTIME inline typename std::enable_if<(N > 1), void>::type
-    forward(const v_type (&ins)[v_in_size]) noexcept
+    RTNEURAL_REALTIME inline void forward(const v_type (&ins)[v_in_size]) noexcept
     {
-        // compute ft
-        recurrent_mat_mul(outs, Uf, ft);
-        kernel_mat_mul(ins, Wf, kernel_outs);
-        for(int i = 0; i < v_out_size; ++i)
-            ft[i] = MathsProvider::sigmoid(ft[i] + bf[i] + kernel_outs[i]);
+        // compute all four gates with a single pass over the packed weights
+        for(int j = 0; j < v_gates_size; ++j)
+            gates[j] = b[j];
 
-        // compute it
-        recurrent_mat_mul(outs, Ui, it);
-        kernel_mat_mul(ins, Wi, kernel_outs);
-        for(int i = 0; i < v_out_size; ++i)
-            it[i] = MathsProvider::sigmoid(it[i] + bi[i] + kernel_outs[i]);
+        kernel_mat_mul(ins);
+        recurrent_mat_mul(outs);
 
-        // compute ot
-        recurrent_mat_mul(outs, Uo, ot);
-        kernel_mat_mul(ins, Wo, kernel_outs);
-        for(int i = 0; i < v_out_size; ++i)
-            ot[i] = MathsProvider::sigmoid(ot[i] + bo[i] + kernel_outs[i]);
+        for(int j = 0; j < v_sigmoid_gates_size; ++j)
+            gates[j] = MathsProvider::sigmoid(gates[j]);
+        for(int j = v_sigmoid_gates_size; j < v_gates_size; ++j)
+            gates[j] = MathsProvider::tanh(gates[j]);
 
-        computeOutputs(ins);
+        computeOutputs();
     }
 
-    /** Performs forward propagation for this layer. */
-    template <int N = in_size>
-    RTNEURAL_REALTIME inline typename std::enable_if<N == 1, void>::type
-    forward(const v_type (&ins)[v_in_size]) noexcept
+    /**
+     * Performs forward propagation for a block of samples.
+     *
+     * The input must have size input[num_samples][in_size], and the output
+     * will be written with size output[num_samples][out_size].
+     */
+    template <SampleRateCorrectionMode srCorr = sampleRateCorr>
+    RTNEURAL_REALTIME inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
+    forwardBlock(const T* input, T* output, int num_samples) noexcept
     {
-        // compute ft
-        recurrent_mat_mul(outs, Uf, ft);
-        for(int i = 0; i < v_out_size; ++i)
-            ft[i] = MathsProvider::sigmoid(xsimd::fma(Wf_1[i], ins[0], ft[i] + bf[i]));
-
-        // compute it
-        recurrent_mat_mul(outs, Ui, it);
-        for(int i = 0; i < v_out_size; ++i)
-            it[i] = MathsProvider::sigmoid(xsimd::fma(Wi_1[i], ins[0], it[i] + bi[i]));
+        T x_scalar alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size] {};
+        T h_scalar alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
+        v_type x[v_in_size];
+        for(int n = 0; n < num_samples; ++n)
+        {
+            RTNEURAL_IF_CONSTEXPR(in_size == 1)
+            {
+                // single inputs are broadcast, like in ModelT::forward()
+                x[0] = v_type(input[n]);
+            }
+            else
+            {
+                std::copy(input + n * in_size, input + (n + 1) * in_size, x_scalar);
+                for(int i = 0; i < v_in_size; ++i)
+                    x[i] = xsimd::load_aligned(&x_scalar[i * v_size]);
+            }
 
-        // compute ot
-        recurrent_mat_mul(outs, Uo, ot);
-        for(int i = 0; i < v_out_size; ++i)
-            ot[i] = MathsProvider::sigmoid(xsimd::fma(Wo_1[i], ins[0], ot[i] + bo[i]));
+            forward(x);
 
-        computeOutputs(ins);
+            for(int i = 0; i < v_out_size; ++i)
+                outs[i].store_aligned(&h_scalar[i * v_size]);
+            std::copy(h_scalar, h_scalar + out_size, output + n * out_size);
+        }
     }
 
     /**
@@ -240,6 +246,18 @@ public:
      */
     RTNEURAL_REALTIME void setUVals(const std::vector<std::vector<T>>& uVals);
 
+    /**
+     * Sets the layer recurrent weights from low-rank factors, such that
+     * weights[out_size][4 * out_size] = left[out_size][rank] * right[rank][4 * out_size]
+     *
+     * Factors with a rank above max_recurrent_rank are multiplied out
+     * and stored as full-rank weights.
+     */
+    RTNEURAL_REALTIME void setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right);
+
+    /** Returns the rank of the recurrent weights, or 0 for full-rank weights. */
+    int getRecurrentRank() const noexcept { return recurrent_rank; }
+
     /**
      * Sets the layer bias.
      *
@@ -247,58 +265,54 @@ public:
      */
     RTNEURAL_REALTIME void setBVals(const std::vector<T>& bVals);
 
+    /** Returns true if the layer is skipping the zero blocks in its (pruned) weights. */
+    bool isSparse() const noexcept { return W_index.isEnabled() || U_index.isEnabled(); }
+
     v_type outs[v_out_size];
 
 private:
+    static constexpr auto v_max_recurrent_rank = ceil_div(max_recurrent_rank, v_size);
+
+    /** Returns the index of a packed [i | f | o | c] gate, given an index into the [i | f | c | o] weights. */
+    static constexpr int gateIndex(int k) noexcept
+    {
+        return (k / out_size == 2 ? 3 : (k / out_size == 3 ? 2 : k / out_size)) * v_out_size * v_size + k % out_size;
+    }
+
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::None, void>
-    computeOutputs(const v_type (&ins)[v_in_size]) noexcept
+    computeOutputs() noexcept
     {
-        computeOutputsInternal(ins, ct, outs);
+        computeOutputsInternal(ct, outs);
     }
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr != SampleRateCorrectionMode::None, void>
-    computeOutputs(const v_type (&ins)[v_in_size]) noexcept
+    computeOutputs() noexcept
     {
-        computeOutputsInternal(ins, ct_delayed[delayWriteIdx], outs_delayed[delayWriteIdx]);
+        computeOutputsInternal(ct_delayed[delayWriteIdx], outs_delayed[delayWriteIdx]);
 
         processDelay(ct_delayed, ct, delayWriteIdx);
         processDelay(outs_delayed, outs, delayWriteIdx);
     }
 
-    template <typename VecType, int N = in_size>
-    inline std::enable_if_t<(N > 1), void>
-    computeOutputsInternal(const v_type (&ins)[v_in_size], VecType& ctVec, VecType& outsVec) noexcept
+    template <typename VecType>
+    inline void computeOutputsInternal(VecType& ctVec, VecType& outsVec) noexcept
     {
-        // compute ct
-        recurrent_mat_mul(outs, Uc, ht);
-        kernel_mat_mul(ins, Wc, kernel_outs);
-        for(int i = 0; i < v_out_size; ++i)
-            ctVec[i] = xsimd::fma(it[i], MathsProvider::tanh(ht[i] + bc[i] + kernel_outs[i]), ft[i] * ct[i]);
-
-        // compute output
-        for(int i = 0; i < v_out_size; ++i)
-            outsVec[i] = ot[i] * MathsProvider::tanh(ctVec[i]);
-    }
-
-    template <typename VecType, int N = in_size>
-    inline std::enable_if_t<N == 1, void>
-    computeOutputsInternal(const v_type (&ins)[v_in_size], VecType& ctVec, VecType& outsVec) noexcept
-    {
-        // compute ct
-        recurrent_mat_mul(outs, Uc, ht);
-        for(int i = 0; i < v_out_size; ++i)
-            ctVec[i] = xsimd::fma(it[i], MathsProvider::tanh(xsimd::fma(Wc_1[i], ins[0], ht[i] + bc[i])), ft[i] * ct[i]);
-
-        // compute output
+        const auto* it = gates;
+        const auto* ft = gates + v_out_size;
+        const auto* ot = gates + 2 * v_out_size;
+        const auto* cHat = gates + 3 * v_out_size;
         for(int i = 0; i < v_out_size; ++i)
+        {
+            ctVec[i] = xsimd::fma(it[i], cHat[i], ft[i] * ct[i]);
             outsVec[i] = ot[i] * MathsProvider::tanh(ctVec[i]);
+        }
     }
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-    processDelay(std::vector<std::array<v_type, v_out_size>>& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = delayVec[0][i];
@@ -312,7 +326,7 @@ private:
 
     template <SampleRateCorrectionMode srCorr = sampleRateCorr>
     inline std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-    processDelay(std::vector<std::array<v_type, v_out_size>>& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
+    processDelay(delay_vec_type& delayVec, v_type (&out)[v_out_size], int delayWriteIndex) noexcept
     {
         for(int i = 0; i < v_out_size; ++i)
             out[i] = delayPlus1Mult * delayVec[0][i] + delayMult * delayVec[1][i];
@@ -324,80 +338,111 @@ private:
         }
     }
 
-    static inline void recurrent_mat_mul(const v_type (&vec)[v_out_size], const v_type (&mat)[out_size][v_out_size], v_type (&out)[v_out_size]) noexcept
+    inline void recurrent_mat_mul(const v_type (&vec)[v_out_size]) noexcept
     {
+        T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size];
         for(int i = 0; i < v_out_size; ++i)
-            out[i] = v_type(0);
+            vec[i].store_aligned(&scalar_in[i * v_size]);
 
-        T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
-        for(int k = 0; k < v_out_size; ++k)
+        if(recurrent_rank > 0)
         {
-            vec[k].store_aligned(scalar_in);
-            for(int i = 0; i < v_out_size; ++i)
+            // project the state down to the recurrent rank, and then back up to the gates
+            const auto v_rank = ceil_div(recurrent_rank, v_size);
+            v_type proj[v_max_recurrent_rank];
+            for(int i = 0; i < v_rank; ++i)
+                proj[i] = v_type((T)0);
+
+            for(int k = 0; k < out_size; ++k)
+            {
+                const v_type x_k(scalar_in[k]);
+                for(int i = 0; i < v_rank; ++i)
+                    proj[i] = xsimd::fma(U_left[k][i], x_k, proj[i]);
+            }
+
+            T scalar_proj alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_max_recurrent_rank * v_size];
+            for(int i = 0; i < v_rank; ++i)
+                proj[i].store_aligned(&scalar_proj[i * v_size]);
+
+            for(int r = 0; r < recurrent_rank; ++r)
             {
-                for(int j = 0; j < v_size; ++j)
-                    out[i] += scalar_in[j] * mat[k * v_size + j][i];
+                const v_type p_r(scalar_proj[r]);
+                for(int j = 0; j < v_gates_size; ++j)
+                    gates[j] = xsimd::fma(U_right[r][j], p_r, gates[j]);
             }
+            return;
+        }
+
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
+        {
+            if(U_index.isEnabled())
+            {
+                U_index.accumulate(scalar_in, U, gates);
+                return;
+            }
+        }
+
+        for(int k = 0; k < out_size; ++k)
+        {
+            const v_type x_k(scalar_in[k]);
+            for(int j = 0; j < v_gates_size; ++j)
+                gates[j] = xsimd::fma(U[k][j], x_k, gates[j]);
         }
     }
 
-    static inline void kernel_mat_mul(const v_type (&vec)[v_in_size], const v_type (&mat)[in_size][v_out_size], v_type (&out)[v_out_size]) noexcept
+    template <int N = in_size>
+    inline std::enable_if_t<(N > 1), void>
+    kernel_mat_mul(const v_type (&vec)[v_in_size]) noexcept
     {
-        for(int i = 0; i < v_out_size; ++i)
-            out[i] = v_type(0);
+        T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size];
+        for(int i = 0; i < v_in_size; ++i)
+            vec[i].store_aligned(&scalar_in[i * v_size]);
 
-        T scalar_in alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_size] { (T)0 };
-        for(int k = 0; k < v_in_size; ++k)
+        RTNEURAL_IF_CONSTEXPR(block_sparse)
         {
-            vec[k].store_aligned(scalar_in);
-            for(int i = 0; i < v_out_size; ++i)
+            if(W_index.isEnabled())
             {
-                for(int j = 0; j < v_size; ++j)
-                    out[i] += scalar_in[j] * mat[k * v_size + j][i];
+                W_index.accumulate(scalar_in, W, gates);
+                return;
             }
         }
+
+        for(int k = 0; k < in_size; ++k)
+        {
+            const v_type x_k(scalar_in[k]);
+            for(int j = 0; j < v_gates_size; ++j)
+                gates[j] = xsimd::fma(W[k][j], x_k, gates[j]);
+        }
     }
 
-    static inline v_type sigmoid(v_type x) noexcept
+    template <int N = in_size>
+    inline std::enable_if_t<N == 1, void>
+    kernel_mat_mul(const v_type (&vec)[v_in_size]) noexcept
     {
-        return (T)1.0 / ((T)1.0 + xsimd::exp(-x));
+        for(int j = 0; j < v_gates_size; ++j)
+            gates[j] = xsimd::fma(W[0][j], vec[0], gates[j]);
     }
 
-    // kernel weights
-    v_type Wf[in_size][v_out_size];
-    v_type Wi[in_size][v_out_size];
-    v_type Wo[in_size][v_out_size];
-    v_type Wc[in_size][v_out_size];
-    v_type kernel_outs[v_out_size];
-
-    // single-input kernel weights
-    v_type Wf_1[v_out_size];
-    v_type Wi_1[v_out_size];
-    v_type Wo_1[v_out_size];
-    v_type Wc_1[v_out_size];
-
-    // recurrent weights
-    v_type Uf[out_size][v_out_size];
-    v_type Ui[out_size][v_out_size];
-    v_type Uo[out_size][v_out_size];
-    v_type Uc[out_size][v_out_size];
-
-    // biases
-    v_type bf[v_out_size];
-    v_type bi[v_out_size];
-    v_type bo[v_out_size];
-    v_type bc[v_out_size];
+    // packed [i | f | o | c] weights
+    v_type W[in_size][v_gates_size]; // kernel weights
+    v_type U[out_size][v_gates_size]; // recurrent weights
+    v_type b[v_gates_size]; // biases
+
+    // indices of the non-zero weights, for pruned layers
+    SparseBlockIndexT<T, in_size, v_gates_size, block_sparse> W_index;
+    SparseBlockIndexT<T, out_size, v_gates_size, block_sparse> U_index;
+
+    // low-rank recurrent weights, with U = U_left * U_right
+    int recurrent_rank = 0;
+    v_type U_left[out_size][v_max_recurrent_rank];
+    v_type U_right[max_recurrent_rank][v_gates_size];
 
     // intermediate vars
-    v_type ft[v_out_size];
-    v_type it[v_out_size];
-    v_type ot[v_out_size];
-    v_type ht[v_out_size];
+    v_type gates[v_gates_size];
     v_type ct[v_out_size];
 
     // needed for delays when doing sample rate correction
-    std::vector<std::array<v_type, v_out_size>> ct_delayed;
-    std::vector<std::array<v_type, v_out_size>> outs_delayed;
+    delay_vec_type ct_delayed;
+    delay_vec_type outs_delayed;
     int delayWriteIdx = 0;
     v_type delayMult = (T)1;
     v_type delayPlus1Mult = (T)0;
@@ -6,22 +6,16 @@ namespace RTNEURAL_NAMESPACE
 template <typename T, typename MathsProvider>
 LSTMLayer<T, MathsProvider>::LSTMLayer(int in_size, int out_size)
     : Layer<T>(in_size, out_size)
-    , fWeights(in_size, out_size)
-    , iWeights(in_size, out_size)
-    , oWeights(in_size, out_size)
-    , cWeights(in_size, out_size)
+    , out_size_padded(simd_padded_size<T>(out_size))
 {
-    ht1.resize(out_size, (T)0);
-    ct1.resize(out_size, (T)0);
+    ht1.resize(out_size_padded, (T)0);
+    ct1.resize(out_size_padded, (T)0);
 
-    fVec.resize(out_size, (T)0);
-    iVec.resize(out_size, (T)0);
-    oVec.resize(out_size, (T)0);
-    ctVec.resize(out_size, (T)0);
-    cVec.resize(out_size, (T)0);
+    W.resize(in_size * 4 * out_size_padded, (T)0);
+    U.resize(out_size * 4 * out_size_padded, (T)0);
+    bias.resize(4 * out_size_padded, (T)0);
 
-    prod_in.resize(in_size, (T)0);
-    prod_out.resize(out_size, (T)0);
+    gates.resize(4 * out_size_padded, (T)0);
 }
 
 template <typename T, typename MathsProvider>
@@ -52,116 +46,65 @@ void LSTMLayer<T, MathsProvider>::reset()
     std::fill(ct1.begin(), ct1.end(), (T)0);
 }
 
-template <typename T, typename MathsProvider>
-LSTMLayer<T, MathsProvider>::WeightSet::WeightSet(int in_size, int out_size)
-    : out_size(out_size)
-{
-    W = vec2_type(out_size, vec_type(in_size, (T)0));
-    U = vec2_type(out_size, vec_type(out_size, (T)0));
-    b.resize(out_size, (T)0);
-}
-
-template <typename T, typename MathsProvider>
-LSTMLayer<T, MathsProvider>::WeightSet::~WeightSet() = default;
-
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
     for(int i = 0; i < Layer<T>::in_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            iWeights.W[k][i] = wVals[i][k];
-            fWeights.W[k][i] = wVals[i][k + Layer<T>::out_size];
-            cWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 2];
-            oWeights.W[k][i] = wVals[i][k + Layer<T>::out_size * 3];
-        }
-    }
+        for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+            W[i * 4 * out_size_padded + gateIndex(k)] = wVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
 {
     for(int i = 0; i < Layer<T>::out_size; ++i)
-    {
-        for(int k = 0; k < Layer<T>::out_size; ++k)
-        {
-            iWeights.U[k][i] = uVals[i][k];
-            fWeights.U[k][i] = uVals[i][k + Layer<T>::out_size];
-            cWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 2];
-            oWeights.U[k][i] = uVals[i][k + Layer<T>::out_size * 3];
-        }
-    }
+        for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+            U[i * 4 * out_size_padded + gateIndex(k)] = uVals[i][k];
 }
 
 template <typename T, typename MathsProvider>
 void LSTMLayer<T, MathsProvider>::setBVals(const std::vector<T>& bVals)
 {
-    for(int k = 0; k < Layer<T>::out_size; ++k)
-    {
-        iWeights.b[k] = bVals[k];
-        fWeights.b[k] = bVals[k + Layer<T>::out_size];
-        cWeights.b[k] = bVals[k + Layer<T>::out_size * 2];
-        oWeights.b[k] = bVals[k + Layer<T>::out_size * 3];
-    }
+    for(int k = 0; k < 4 * Layer<T>::out_size; ++k)
+        bias[gateIndex(k)] = bVals[k];
 }
 
 //====================================================
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::LSTMLayerT()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::LSTMLayerT()
 {
-    for(int i = 0; i < v_out_size; ++i)
+    for(int j = 0; j < v_gates_size; ++j)
     {
-        // single-input kernel weights
-        Wf_1[i] = v_type((T)0);
-        Wi_1[i] = v_type((T)0);
-        Wo_1[i] = v_type((T)0);
-        Wc_1[i] = v_type((T)0);
+        // kernel weights
+        for(int k = 0; k < in_size; ++k)
+            W[k][j] = v_type((T)0);
+
+        // recurrent weights
+        for(int k = 0; k < out_size; ++k)
+            U[k][j] = v_type((T)0);
 
         // biases
-        bf[i] = v_type((T)0);
-        bi[i] = v_type((T)0);
-        bo[i] = v_type((T)0);
-        bc[i] = v_type((T)0);
+        b[j] = v_type((T)0);
 
         // intermediate vars
-        ft[i] = v_type((T)0);
-        it[i] = v_type((T)0);
-        ot[i] = v_type((T)0);
-        ht[i] = v_type((T)0);
-    }
+        gates[j] = v_type((T)0);
 
-    // kernel weights
-    for(int k = 0; k < in_size; ++k)
-    {
-        for(int i = 0; i < v_out_size; ++i)
-        {
-            Wf[k][i] = v_type((T)0);
-            Wi[k][i] = v_type((T)0);
-            Wo[k][i] = v_type((T)0);
-            Wc[k][i] = v_type((T)0);
-        }
+        // low-rank recurrent weights
+        for(int r = 0; r < max_recurrent_rank; ++r)
+            U_right[r][j] = v_type((T)0);
     }
 
-    // recurrent weights
-    for(int i = 0; i < out_size; ++i)
-    {
-        for(int k = 0; k < v_out_size; ++k)
-        {
-            Uf[i][k] = v_type((T)0);
-            Ui[i][k] = v_type((T)0);
-            Uo[i][k] = v_type((T)0);
-            Uc[i][k] = v_type((T)0);
-        }
-    }
+    for(int k = 0; k < out_size; ++k)
+        for(int i = 0; i < v_max_recurrent_rank; ++i)
+            U_left[k][i] = v_type((T)0);
 
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::NoInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(int delaySamples)
 {
     delayWriteIdx = delaySamples - 1;
     ct_delayed.resize(delayWriteIdx + 1, {});
@@ -170,10 +113,10 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(int d
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
 template <SampleRateCorrectionMode srCorr>
 std::enable_if_t<srCorr == SampleRateCorrectionMode::LinInterp, void>
-LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T delaySamples)
+LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::prepare(T delaySamples)
 {
     const auto delayOffFactor = delaySamples - std::floor(delaySamples);
     delayMult = (T)1 - delayOffFactor;
@@ -186,8 +129,8 @@ LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::prepare(T del
     reset();
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::reset()
 {
     RTNEURAL_IF_CONSTEXPR(sampleRateCorr != SampleRateCorrectionMode::None)
     {
@@ -206,53 +149,71 @@ void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::reset()
     }
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setWVals(const std::vector<std::vector<T>>& wVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setWVals(const std::vector<std::vector<T>>& wVals)
 {
-    for(int i = 0; i < out_size; ++i)
+    for(int k = 0; k < in_size; ++k)
     {
-        for(int k = 0; k < in_size; ++k)
+        for(int j = 0; j < 4 * out_size; ++j)
         {
-            Wi[k][i / v_size] = set_value(Wi[k][i / v_size], i % v_size, wVals[k][i]);
-            Wf[k][i / v_size] = set_value(Wf[k][i / v_size], i % v_size, wVals[k][i + out_size]);
-            Wc[k][i / v_size] = set_value(Wc[k][i / v_size], i % v_size, wVals[k][i + 2 * out_size]);
-            Wo[k][i / v_size] = set_value(Wo[k][i / v_size], i % v_size, wVals[k][i + 3 * out_size]);
+            const auto idx = gateIndex(j);
+            W[k][idx / v_size] = set_value(W[k][idx / v_size], idx % v_size, wVals[k][j]);
         }
     }
 
-    for(int j = 0; j < out_size; ++j)
+    W_index.update(W);
+}
+
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUVals(const std::vector<std::vector<T>>& uVals)
+{
+    for(int k = 0; k < out_size; ++k)
     {
-        Wi_1[j / v_size] = set_value(Wi_1[j / v_size], j % v_size, wVals[0][j]);
-        Wf_1[j / v_size] = set_value(Wf_1[j / v_size], j % v_size, wVals[0][j + out_size]);
-        Wc_1[j / v_size] = set_value(Wc_1[j / v_size], j % v_size, wVals[0][j + 2 * out_size]);
-        Wo_1[j / v_size] = set_value(Wo_1[j / v_size], j % v_size, wVals[0][j + 3 * out_size]);
+        for(int j = 0; j < 4 * out_size; ++j)
+        {
+            const auto idx = gateIndex(j);
+            U[k][idx / v_size] = set_value(U[k][idx / v_size], idx % v_size, uVals[k][j]);
+        }
     }
+
+    U_index.update(U);
+
+    recurrent_rank = 0;
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setUVals(const std::vector<std::vector<T>>& uVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setUFactors(const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
 {
-    for(int i = 0; i < out_size; ++i)
+    const auto rank = (int)right.size();
+    if(rank > max_recurrent_rank)
     {
-        for(int k = 0; k < out_size; ++k)
+        setUVals(low_rank::multiply(left, right));
+        return;
+    }
+
+    for(int k = 0; k < out_size; ++k)
+        for(int r = 0; r < rank; ++r)
+            U_left[k][r / v_size] = set_value(U_left[k][r / v_size], r % v_size, left[k][r]);
+
+    for(int r = 0; r < rank; ++r)
+    {
+        for(int j = 0; j < 4 * out_size; ++j)
         {
-            Ui[k][i / v_size] = set_value(Ui[k][i / v_size], i % v_size, uVals[k][i]);
-            Uf[k][i / v_size] = set_value(Uf[k][i / v_size], i % v_size, uVals[k][i + out_size]);
-            Uc[k][i / v_size] = set_value(Uc[k][i / v_size], i % v_size, uVals[k][i + 2 * out_size]);
-            Uo[k][i / v_size] = set_value(Uo[k][i / v_size], i % v_size, uVals[k][i + 3 * out_size]);
+            const auto idx = gateIndex(j);
+            U_right[r][idx / v_size] = set_value(U_right[r][idx / v_size], idx % v_size, right[r][j]);
         }
     }
+
+    recurrent_rank = rank;
 }
 
-template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider>
-void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider>::setBVals(const std::vector<T>& bVals)
+template <typename T, int in_sizet, int out_sizet, SampleRateCorrectionMode sampleRateCorr, typename MathsProvider, bool block_sparse>
+void LSTMLayerT<T, in_sizet, out_sizet, sampleRateCorr, MathsProvider, block_sparse>::setBVals(const std::vector<T>& bVals)
 {
-    for(int k = 0; k < out_size; ++k)
+    for(int j = 0; j < 4 * out_size; ++j)
     {
-        bi[k / v_size] = set_value(bi[k / v_size], k % v_size, bVals[k]);
-        bf[k / v_size] = set_value(bf[k / v_size], k % v_size, bVals[k + out_size]);
-        bc[k / v_size] = set_value(bc[k / v_size], k % v_size, bVals[k + 2 * out_size]);
-        bo[k / v_size] = set_value(bo[k / v_size], k % v_size, bVals[k + 3 * out_size]);
+        const auto idx = gateIndex(j);
+        b[idx / v_size] = set_value(b[idx / v_size], idx % v_size, bVals[j]);
     }
 }
 
@@ -0,0 +1,415 @@
+#pragma once
+
+#include "../config.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Backend-independent kernels for the approximate MathsProviders, which can be
+ * used in place of DefaultMathsProvider when some accuracy can be traded for speed:
+ *
+ * - PadeMathsProvider: tanh() and sigmoid() from a [7/6] Padé approximant
+ *   (max. error 9.6e-5), and exp() from a bit-shifted power of 2 times a
+ *   degree-5 polynomial (max. relative error 1e-7).
+ * - Exp2MathsProvider: tanh(), sigmoid(), and exp() from a bit-shifted power of 2
+ *   times a degree-3 polynomial (max. relative error of exp() 1e-4, max. error of
+ *   tanh() 5e-5). Usually the fastest of the three.
+ * - PolynomialMathsProvider: tanh() and sigmoid() from piecewise polynomials
+ *   (max. error 4.4e-5), which avoid divisions, and exp() as in PadeMathsProvider.
+ * - LUTMathsProvider<TableSize, Range, Interpolation>: tanh(), sigmoid(), and exp()
+ *   from interpolated lookup tables (see LUTMathsProviderImpl).
+ *
+ * Each backend's maths header defines the providers for that backend, and
+ * bench/maths_bench.cpp measures their speed and accuracy.
+ *
+ * Each kernel is written in terms of a value type V (a scalar, an xsimd batch,
+ * or an Eigen packet), and an Ops struct which provides the operations that
+ * can't be written with arithmetic operators:
+ *
+ * - `Ops::min(a, b)` and `Ops::max(a, b)`
+ * - `Ops::abs(x)`
+ * - `Ops::round(x)`: rounds to the nearest integer
+ * - `Ops::ldexp(x, n)`: computes x * 2^n, where n holds integer values
+ * - `Ops::select_lt(a, b, t, f)`: returns a < b ? t : f
+ * - `Ops::trunc(x)`: rounds a non-negative value down to an integer
+ * - `Ops::gather(table, idx)`: returns table[idx], where idx holds integer values
+ *
+ * The kernels don't use any branches, so that they can be vectorized.
+ */
+namespace approx_maths
+{
+    /** The scalar type of a value type (either a scalar, or a SIMD type with a `value_type`). */
+    template <typename V, typename = void>
+    struct ScalarType
+    {
+        using type = typename V::value_type;
+    };
+
+    template <typename V>
+    struct ScalarType<V, typename std::enable_if<std::is_arithmetic<V>::value>::type>
+    {
+        using type = V;
+    };
+
+    /** Ops for scalar floating-point types. */
+    struct ScalarOps
+    {
+        template <typename T>
+        static T min(T a, T b) noexcept { return a < b ? a : b; }
+
+        template <typename T>
+        static T max(T a, T b) noexcept { return a > b ? a : b; }
+
+        template <typename T>
+        static T abs(T x) noexcept { return std::abs(x); }
+
+        template <typename T>
+        static T round(T x) noexcept { return (T)(int64_t)(x + (x < (T)0 ? (T)-0.5 : (T)0.5)); }
+
+        static float ldexp(float x, float n) noexcept
+        {
+            const auto bits = (uint32_t)((int32_t)n + 127) << 23;
+            float scale;
+            std::memcpy(&scale, &bits, sizeof(float));
+            return x * scale;
+        }
+
+        static double ldexp(double x, double n) noexcept
+        {
+            const auto bits = (uint64_t)((int64_t)n + 1023) << 52;
+            double scale;
+            std::memcpy(&scale, &bits, sizeof(double));
+            return x * scale;
+        }
+
+        template <typename T>
+        static T select_lt(T a, T b, T t, T f) noexcept { return a < b ? t : f; }
+
+        template <typename T>
+        static T trunc(T x) noexcept { return (T)(int64_t)x; }
+
+        template <typename T>
+        static T gather(const T* table, T idx) noexcept { return table[(int64_t)idx]; }
+    };
+
+    /**
+     * Range reduction for exp(x) = 2^n * exp(r), where n = round(x / ln2), and
+     * r = x - n * ln2 is in [-ln2/2, ln2/2]. Returns r, and stores n.
+     */
+    template <typename Ops, typename V>
+    inline V exp_reduce(V x, V& n) noexcept
+    {
+        using S = typename ScalarType<V>::type;
+
+        // Cody-Waite range reduction: ln2 is split into a high part, with enough
+        // trailing zero bits that n * ln2_hi is exact, and a low part.
+        constexpr auto log2e = (S)1.44269504088896341;
+        constexpr auto ln2_hi = (S)0.693145751953125;
+        constexpr auto ln2_lo = (S)1.42860682030941723212e-6;
+
+        // clamp the input, so that 2^n stays a normal floating-point number
+        constexpr auto x_min = std::is_same<S, float>::value ? (S)-87 : (S)-708;
+        constexpr auto x_max = std::is_same<S, float>::value ? (S)88 : (S)709;
+        x = Ops::min(Ops::max(x, V(x_min)), V(x_max));
+        n = Ops::round(x * log2e);
+        return (x - n * ln2_hi) - n * ln2_lo;
+    }
+
+    /**
+     * exp(x) = 2^n * exp(r) (see exp_reduce()), where 2^n is constructed directly
+     * in the exponent bits, and exp(r) is approximated with a polynomial of
+     * degree `Order` (3 or 5).
+     *
+     * Max. relative error: 1.0e-4 (Order = 3), or 1.0e-7 (Order = 5).
+     */
+    template <int Order, typename Ops, typename V>
+    inline V exp_bitshift(V x) noexcept
+    {
+        using S = typename ScalarType<V>::type;
+        static_assert(Order == 3 || Order == 5, "Unsupported polynomial order!");
+
+        V n;
+        const auto r = exp_reduce<Ops>(x, n);
+
+        V p;
+        RTNEURAL_IF_CONSTEXPR(Order == 3)
+        {
+            p = V((S)0.167670119);
+            p = p * r + (S)0.505022284;
+            p = p * r + (S)0.999984929;
+            p = p * r + (S)0.999924557;
+        }
+        else
+        {
+            p = V((S)0.00836914849);
+            p = p * r + (S)0.0419175072;
+            p = p * r + (S)0.166665053;
+            p = p * r + (S)0.499988694;
+            p = p * r + (S)1.00000001;
+            p = p * r + (S)1.00000008;
+        }
+
+        return Ops::ldexp(p, n);
+    }
+
+    /**
+     * [7/6] Padé approximant of tanh(x). The input is clamped to the range
+     * where the approximant is most accurate, and the output to [-1, 1].
+     *
+     * Max. absolute error: 9.6e-5.
+     */
+    template <typename Ops, typename V>
+    inline V tanh_pade(V x) noexcept
+    {
+        using S = typename ScalarType<V>::type;
+        constexpr auto clamp = (S)4.97;
+        x = Ops::min(Ops::max(x, V(-clamp)), V(clamp));
+
+        const auto x2 = x * x;
+        const auto num = x * ((((x2 + (S)378) * x2 + (S)17325) * x2) + (S)135135);
+        const auto den = (((S)28 * x2 + (S)3150) * x2 + (S)62370) * x2 + (S)135135;
+        return Ops::min(Ops::max(num / den, V((S)-1)), V((S)1));
+    }
+
+    /**
+     * Piecewise-polynomial approximation of tanh(x), which doesn't need any
+     * divisions. For |x| < 1.2, tanh(x) is approximated by an odd polynomial,
+     * and for 1.2 <= |x| < 6, by a degree-7 polynomial in |x|, which is held
+     * constant beyond that. The polynomials are Chebyshev interpolants.
+     *
+     * Max. absolute error: 4.4e-5.
+     */
+    template <typename Ops, typename V>
+    inline V tanh_piecewise(V x) noexcept
+    {
+        using S = typename ScalarType<V>::type;
+        const auto a = Ops::abs(x);
+
+        // |x| < 1.2: x * P(x^2)
+        const auto a2 = a * a;
+        auto inner = V((S)-0.00295273302);
+        inner = inner * a2 + (S)0.0168527193;
+        inner = inner * a2 + (S)-0.0520655316;
+        inner = inner * a2 + (S)0.133081382;
+        inner = inner * a2 + (S)-0.333327142;
+        inner = inner * a2 + (S)0.999999997;
+        inner = inner * a;
+
+        // |x| >= 1.2: Q(min(|x|, 6) - 3.6), where Q(6 - 3.6) is within the error bound of 1.
+        // The polynomial is centred on its segment, to avoid cancellation errors.
+        const auto t = Ops::min(a, V((S)6)) - (S)3.6;
+        auto outer = V((S)3.89509396e-05);
+        outer = outer * t + (S)-0.000199645166;
+        outer = outer * t + (S)0.000388496894;
+        outer = outer * t + (S)-0.000753941913;
+        outer = outer * t + (S)0.00197081894;
+        outer = outer * t + (S)-0.00322274474;
+        outer = outer * t + (S)0.00298365538;
+        outer = outer * t + (S)0.998551436;
+        outer = Ops::min(outer, V((S)1));
+
+        const auto y = Ops::select_lt(a, V((S)1.2), inner, outer);
+        return Ops::select_lt(x, V((S)0), -y, y);
+    }
+
+    /** Shared implementation of PadeMathsProvider for the STL and xsimd backends. */
+    template <typename Ops>
+    struct PadeMathsProviderImpl
+    {
+        template <typename T>
+        static T tanh(T x) noexcept
+        {
+            return tanh_pade<Ops>(x);
+        }
+
+        template <typename T>
+        static T sigmoid(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            return (S)0.5 * tanh_pade<Ops>((S)0.5 * x) + (S)0.5;
+        }
+
+        template <typename T>
+        static T exp(T x) noexcept
+        {
+            return exp_bitshift<5, Ops>(x);
+        }
+    };
+
+    /** Shared implementation of Exp2MathsProvider for the STL and xsimd backends. */
+    template <typename Ops>
+    struct Exp2MathsProviderImpl
+    {
+        template <typename T>
+        static T tanh(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            return (S)1 - (S)2 / (exp_bitshift<3, Ops>((S)2 * x) + (S)1);
+        }
+
+        template <typename T>
+        static T sigmoid(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            return (S)1 / ((S)1 + exp_bitshift<3, Ops>(-x));
+        }
+
+        template <typename T>
+        static T exp(T x) noexcept
+        {
+            return exp_bitshift<3, Ops>(x);
+        }
+    };
+
+    /** Shared implementation of PolynomialMathsProvider for the STL and xsimd backends. */
+    template <typename Ops>
+    struct PolynomialMathsProviderImpl
+    {
+        template <typename T>
+        static T tanh(T x) noexcept
+        {
+            return tanh_piecewise<Ops>(x);
+        }
+
+        template <typename T>
+        static T sigmoid(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            return (S)0.5 * tanh_piecewise<Ops>((S)0.5 * x) + (S)0.5;
+        }
+
+        template <typename T>
+        static T exp(T x) noexcept
+        {
+            return exp_bitshift<5, Ops>(x);
+        }
+    };
+
+    /** Interpolation methods for LUTMathsProvider. */
+    enum class LUTInterpolation
+    {
+        Linear,
+        Cubic, // Catmull-Rom spline
+    };
+
+    /**
+     * Interpolates a function from a table of TableSize points, spaced by 1 / inv_step,
+     * starting from x_min. The table must have an extra point before the first point,
+     * and two after the last, for the cubic interpolation. Outside of the table range,
+     * the function is held at the value of the first or last point.
+     */
+    template <int TableSize, LUTInterpolation Interpolation, typename Ops, typename V, typename S>
+    inline V lut_interpolate(const S* table, V x, S x_min, S inv_step) noexcept
+    {
+        const auto pos = Ops::min(Ops::max((x - x_min) * inv_step, V((S)0)), V((S)(TableSize - 1)));
+        const auto idx = Ops::trunc(pos);
+        const auto frac = pos - idx;
+
+        const auto p1 = Ops::gather(table + 1, idx);
+        const auto p2 = Ops::gather(table + 2, idx);
+        RTNEURAL_IF_CONSTEXPR(Interpolation == LUTInterpolation::Linear)
+        {
+            return p1 + frac * (p2 - p1);
+        }
+        else
+        {
+            const auto p0 = Ops::gather(table, idx);
+            const auto p3 = Ops::gather(table + 3, idx);
+            const auto c3 = (S)3 * (p1 - p2) + p3 - p0;
+            const auto c2 = (S)2 * p0 - (S)5 * p1 + (S)4 * p2 - p3;
+            return p1 + (S)0.5 * frac * ((p2 - p0) + frac * (c2 + frac * c3));
+        }
+    }
+
+    /** The lookup tables used by LUTMathsProviderImpl. */
+    template <typename S, int TableSize, int Range>
+    struct LUTTables
+    {
+        static_assert(TableSize >= 2, "The lookup tables need at least two points!");
+        static_assert(Range > 0, "The lookup table range must be positive!");
+
+        static constexpr int padded_size = TableSize + 3;
+
+        LUTTables()
+        {
+            constexpr auto r_max = (S)0.346573590279972655; // ln2 / 2
+            const auto tanh_step = (S)(2 * Range) / (S)(TableSize - 1);
+            const auto exp_step = (S)2 * r_max / (S)(TableSize - 1);
+            tanh_inv_step = (S)1 / tanh_step;
+            exp_inv_step = (S)1 / exp_step;
+
+            for(int i = 0; i < padded_size; ++i)
+            {
+                tanh_table[i] = std::tanh((S)-Range + (S)(i - 1) * tanh_step);
+                exp_table[i] = std::exp(-r_max + (S)(i - 1) * exp_step);
+            }
+        }
+
+        /** Returns the tables, which are computed the first time this is called. */
+        static const LUTTables& get()
+        {
+            static const LUTTables tables;
+            return tables;
+        }
+
+        S tanh_inv_step;
+        S exp_inv_step;
+        S tanh_table[padded_size];
+        S exp_table[padded_size];
+    };
+
+    /**
+     * Computes tanh() and sigmoid() (as 0.5 + 0.5 * tanh(x / 2)) from a lookup table
+     * of tanh() over [-Range, Range], and exp() from a lookup table of exp(r) over
+     * [-ln2/2, ln2/2] (see exp_reduce()). Each table has TableSize points, so the
+     * default settings use 4 kB per table for float.
+     *
+     * With the default settings, the max. error of tanh() is 2.4e-5 for linear
+     * interpolation, and 1e-6 for cubic interpolation.
+     *
+     * The tables are computed the first time that they are used, so call initialise()
+     * before using the provider on the audio thread.
+     */
+    template <typename Ops, int TableSize, int Range, LUTInterpolation Interpolation>
+    struct LUTMathsProviderImpl
+    {
+        /** Computes the lookup tables for the given scalar type. */
+        template <typename S>
+        static void initialise()
+        {
+            LUTTables<S, TableSize, Range>::get();
+        }
+
+        template <typename T>
+        static T tanh(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            const auto& tables = LUTTables<S, TableSize, Range>::get();
+            return lut_interpolate<TableSize, Interpolation, Ops>(tables.tanh_table, x, (S)-Range, tables.tanh_inv_step);
+        }
+
+        template <typename T>
+        static T sigmoid(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            return (S)0.5 * tanh((S)0.5 * x) + (S)0.5;
+        }
+
+        template <typename T>
+        static T exp(T x) noexcept
+        {
+            using S = typename ScalarType<T>::type;
+            const auto& tables = LUTTables<S, TableSize, Range>::get();
+
+            T n;
+            const auto r = exp_reduce<Ops>(x, n);
+            const auto y = lut_interpolate<TableSize, Interpolation, Ops>(tables.exp_table, r, (S)-0.346573590279972655, tables.exp_inv_step);
+            return Ops::ldexp(y, n);
+        }
+    };
+} // namespace approx_maths
+} // namespace RTNEURAL_NAMESPACE
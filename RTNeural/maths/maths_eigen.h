@@ -1,5 +1,7 @@
 #pragma once
 
+#include "maths_approx.h"
+#include <Eigen/Dense>
 #include <cmath>
 
 namespace RTNEURAL_NAMESPACE
@@ -25,4 +27,192 @@ struct DefaultMathsProvider
         return x.array().exp();
     }
 };
-}
+
+namespace approx_maths
+{
+    /** Wraps an Eigen packet, so that it can be used with the arithmetic operators in the approximation kernels. */
+    template <typename Packet>
+    struct EigenPacket
+    {
+        using value_type = typename Eigen::internal::unpacket_traits<Packet>::type;
+
+        EigenPacket() = default;
+        EigenPacket(const Packet& packet) : p(packet) {}
+        EigenPacket(value_type x) : p(Eigen::internal::pset1<Packet>(x)) {}
+
+        friend EigenPacket operator+(const EigenPacket& a, const EigenPacket& b) noexcept { return Eigen::internal::padd(a.p, b.p); }
+        friend EigenPacket operator-(const EigenPacket& a, const EigenPacket& b) noexcept { return Eigen::internal::psub(a.p, b.p); }
+        friend EigenPacket operator*(const EigenPacket& a, const EigenPacket& b) noexcept { return Eigen::internal::pmul(a.p, b.p); }
+        friend EigenPacket operator/(const EigenPacket& a, const EigenPacket& b) noexcept { return Eigen::internal::pdiv(a.p, b.p); }
+        EigenPacket operator-() const noexcept { return Eigen::internal::pnegate(p); }
+
+        Packet p;
+    };
+
+    /** Ops for Eigen packets, and for scalars, which Eigen uses for unvectorized coefficients. */
+    struct EigenOps : ScalarOps
+    {
+        using ScalarOps::abs;
+        using ScalarOps::ldexp;
+        using ScalarOps::max;
+        using ScalarOps::min;
+        using ScalarOps::round;
+        using ScalarOps::select_lt;
+
+        template <typename P>
+        static EigenPacket<P> min(const EigenPacket<P>& a, const EigenPacket<P>& b) noexcept
+        {
+            return Eigen::internal::pmin(a.p, b.p);
+        }
+
+        template <typename P>
+        static EigenPacket<P> max(const EigenPacket<P>& a, const EigenPacket<P>& b) noexcept
+        {
+            return Eigen::internal::pmax(a.p, b.p);
+        }
+
+        template <typename P>
+        static EigenPacket<P> abs(const EigenPacket<P>& x) noexcept
+        {
+            return Eigen::internal::pabs(x.p);
+        }
+
+        template <typename P>
+        static EigenPacket<P> round(const EigenPacket<P>& x) noexcept
+        {
+            return Eigen::internal::print(x.p);
+        }
+
+        template <typename P>
+        static EigenPacket<P> ldexp(const EigenPacket<P>& x, const EigenPacket<P>& n) noexcept
+        {
+            return Eigen::internal::pldexp(x.p, n.p);
+        }
+
+        template <typename P>
+        static EigenPacket<P> select_lt(const EigenPacket<P>& a, const EigenPacket<P>& b, const EigenPacket<P>& t, const EigenPacket<P>& f) noexcept
+        {
+            return Eigen::internal::pselect(Eigen::internal::pcmp_lt(a.p, b.p), t.p, f.p);
+        }
+    };
+
+    /**
+     * Eigen has no packet gathers for the lookup tables of LUTMathsProvider,
+     * so that provider is evaluated one coefficient at a time.
+     */
+    template <typename Impl>
+    struct EigenPacketAccess : std::true_type
+    {
+    };
+
+    template <int TableSize, int Range, LUTInterpolation Interpolation>
+    struct EigenPacketAccess<LUTMathsProviderImpl<EigenOps, TableSize, Range, Interpolation>> : std::false_type
+    {
+    };
+
+    /** Vectorizable Eigen functors, which call one of the provider implementations. */
+    template <typename Impl>
+    struct EigenTanhOp
+    {
+        template <typename T>
+        T operator()(const T& x) const noexcept { return Impl::tanh(x); }
+
+        template <typename Packet>
+        Packet packetOp(const Packet& x) const noexcept { return Impl::tanh(EigenPacket<Packet>(x)).p; }
+    };
+
+    template <typename Impl>
+    struct EigenSigmoidOp
+    {
+        template <typename T>
+        T operator()(const T& x) const noexcept { return Impl::sigmoid(x); }
+
+        template <typename Packet>
+        Packet packetOp(const Packet& x) const noexcept { return Impl::sigmoid(EigenPacket<Packet>(x)).p; }
+    };
+
+    template <typename Impl>
+    struct EigenExpOp
+    {
+        template <typename T>
+        T operator()(const T& x) const noexcept { return Impl::exp(x); }
+
+        template <typename Packet>
+        Packet packetOp(const Packet& x) const noexcept { return Impl::exp(EigenPacket<Packet>(x)).p; }
+    };
+
+    /** Adapts one of the provider implementations to the Eigen MathsProvider interface. */
+    template <typename Impl>
+    struct EigenMathsProvider
+    {
+        /** Computes the lookup tables of LUTMathsProvider for the given scalar type. */
+        template <typename S>
+        static void initialise()
+        {
+            Impl::template initialise<S>();
+        }
+
+        template <typename Matrix>
+        static auto tanh(const Matrix& x)
+        {
+            return x.array().unaryExpr(EigenTanhOp<Impl> {});
+        }
+
+        template <typename Matrix>
+        static auto sigmoid(const Matrix& x)
+        {
+            return x.array().unaryExpr(EigenSigmoidOp<Impl> {});
+        }
+
+        template <typename Matrix>
+        static auto exp(const Matrix& x)
+        {
+            return x.array().unaryExpr(EigenExpOp<Impl> {});
+        }
+    };
+} // namespace approx_maths
+
+// Approximate MathsProviders (see maths_approx.h)
+using PadeMathsProvider = approx_maths::EigenMathsProvider<approx_maths::PadeMathsProviderImpl<approx_maths::EigenOps>>;
+using Exp2MathsProvider = approx_maths::EigenMathsProvider<approx_maths::Exp2MathsProviderImpl<approx_maths::EigenOps>>;
+using PolynomialMathsProvider = approx_maths::EigenMathsProvider<approx_maths::PolynomialMathsProviderImpl<approx_maths::EigenOps>>;
+
+template <int TableSize = 1024, int Range = 8, approx_maths::LUTInterpolation Interpolation = approx_maths::LUTInterpolation::Linear>
+using LUTMathsProvider = approx_maths::EigenMathsProvider<approx_maths::LUTMathsProviderImpl<approx_maths::EigenOps, TableSize, Range, Interpolation>>;
+} // namespace RTNEURAL_NAMESPACE
+
+namespace Eigen
+{
+namespace internal
+{
+    template <typename Impl>
+    struct functor_traits<RTNEURAL_NAMESPACE::approx_maths::EigenTanhOp<Impl>>
+    {
+        enum
+        {
+            Cost = 20 * NumTraits<float>::MulCost,
+            PacketAccess = RTNEURAL_NAMESPACE::approx_maths::EigenPacketAccess<Impl>::value
+        };
+    };
+
+    template <typename Impl>
+    struct functor_traits<RTNEURAL_NAMESPACE::approx_maths::EigenSigmoidOp<Impl>>
+    {
+        enum
+        {
+            Cost = 20 * NumTraits<float>::MulCost,
+            PacketAccess = RTNEURAL_NAMESPACE::approx_maths::EigenPacketAccess<Impl>::value
+        };
+    };
+
+    template <typename Impl>
+    struct functor_traits<RTNEURAL_NAMESPACE::approx_maths::EigenExpOp<Impl>>
+    {
+        enum
+        {
+            Cost = 20 * NumTraits<float>::MulCost,
+            PacketAccess = RTNEURAL_NAMESPACE::approx_maths::EigenPacketAccess<Impl>::value
+        };
+    };
+} // namespace internal
+} // namespace Eigen
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "maths_approx.h"
 #include <cmath>
 
 namespace RTNEURAL_NAMESPACE
@@ -24,4 +25,12 @@ struct DefaultMathsProvider
         return std::exp(x);
     }
 };
+
+// Approximate MathsProviders (see maths_approx.h)
+using PadeMathsProvider = approx_maths::PadeMathsProviderImpl<approx_maths::ScalarOps>;
+using Exp2MathsProvider = approx_maths::Exp2MathsProviderImpl<approx_maths::ScalarOps>;
+using PolynomialMathsProvider = approx_maths::PolynomialMathsProviderImpl<approx_maths::ScalarOps>;
+
+template <int TableSize = 1024, int Range = 8, approx_maths::LUTInterpolation Interpolation = approx_maths::LUTInterpolation::Linear>
+using LUTMathsProvider = approx_maths::LUTMathsProviderImpl<approx_maths::ScalarOps, TableSize, Range, Interpolation>;
 }
@@ -1,5 +1,6 @@
 #pragma once
 
+#include "maths_approx.h"
 #include <cmath>
 
 namespace RTNEURAL_NAMESPACE
@@ -30,4 +31,76 @@ struct DefaultMathsProvider
         return exp(x);
     }
 };
+
+namespace approx_maths
+{
+    /** Ops for xsimd batches, and for scalars, which are used at the end of some loops. */
+    struct XsimdOps : ScalarOps
+    {
+        using ScalarOps::abs;
+        using ScalarOps::gather;
+        using ScalarOps::ldexp;
+        using ScalarOps::max;
+        using ScalarOps::min;
+        using ScalarOps::round;
+        using ScalarOps::select_lt;
+        using ScalarOps::trunc;
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> min(const xsimd::batch<T, A>& a, const xsimd::batch<T, A>& b) noexcept
+        {
+            return xsimd::min(a, b);
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> max(const xsimd::batch<T, A>& a, const xsimd::batch<T, A>& b) noexcept
+        {
+            return xsimd::max(a, b);
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> abs(const xsimd::batch<T, A>& x) noexcept
+        {
+            return xsimd::abs(x);
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> round(const xsimd::batch<T, A>& x) noexcept
+        {
+            return xsimd::nearbyint(x);
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> ldexp(const xsimd::batch<T, A>& x, const xsimd::batch<T, A>& n) noexcept
+        {
+            return xsimd::ldexp(x, xsimd::to_int(n));
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> select_lt(const xsimd::batch<T, A>& a, const xsimd::batch<T, A>& b, const xsimd::batch<T, A>& t, const xsimd::batch<T, A>& f) noexcept
+        {
+            return xsimd::select(a < b, t, f);
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> trunc(const xsimd::batch<T, A>& x) noexcept
+        {
+            return xsimd::to_float(xsimd::to_int(x));
+        }
+
+        template <typename T, typename A>
+        static xsimd::batch<T, A> gather(const T* table, const xsimd::batch<T, A>& idx) noexcept
+        {
+            return xsimd::batch<T, A>::gather(table, xsimd::to_int(idx));
+        }
+    };
+} // namespace approx_maths
+
+// Approximate MathsProviders (see maths_approx.h)
+using PadeMathsProvider = approx_maths::PadeMathsProviderImpl<approx_maths::XsimdOps>;
+using Exp2MathsProvider = approx_maths::Exp2MathsProviderImpl<approx_maths::XsimdOps>;
+using PolynomialMathsProvider = approx_maths::PolynomialMathsProviderImpl<approx_maths::XsimdOps>;
+
+template <int TableSize = 1024, int Range = 8, approx_maths::LUTInterpolation Interpolation = approx_maths::LUTInterpolation::Linear>
+using LUTMathsProvider = approx_maths::LUTMathsProviderImpl<approx_maths::XsimdOps, TableSize, Range, Interpolation>;
 }
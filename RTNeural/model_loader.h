@@ -2,6 +2,7 @@
 
 #include "../modules/json/json.hpp"
 #include "Model.h"
+#include "low_rank.h"
 #include <fstream>
 #include <memory>
 #include <string>
@@ -33,14 +34,13 @@ namespace json_parser
     }
 #endif
 
-    /** Loads weights for a Dense (or DenseT) layer from a json representation of the layer weights. */
-    template <typename T, typename DenseType>
-    void loadDense(DenseType& dense, const nlohmann::json& weights)
+    /** Returns the weights matrix weights[out_size][in_size] from a json representation of Dense layer weights. */
+    template <typename T>
+    std::vector<std::vector<T>> getDenseWeights(int in_size, int out_size, const nlohmann::json& weights)
     {
-        // load weights
-        std::vector<std::vector<T>> denseWeights(dense.out_size);
+        std::vector<std::vector<T>> denseWeights((size_t)out_size);
         for(auto& w : denseWeights)
-            w.resize(dense.in_size, (T)0);
+            w.resize((size_t)in_size, (T)0);
 
         const auto& layerWeights = weights.at(0);
         for(size_t i = 0; i < layerWeights.size(); ++i)
@@ -50,7 +50,15 @@ namespace json_parser
                 denseWeights.at(j).at(i) = lw.at(j).get<T>();
         }
 
-        dense.setWeights(denseWeights);
+        return denseWeights;
+    }
+
+    /** Loads weights for a Dense (or DenseT) layer from a json representation of the layer weights. */
+    template <typename T, typename DenseType>
+    void loadDense(DenseType& dense, const nlohmann::json& weights)
+    {
+        // load weights
+        dense.setWeights(getDenseWeights<T>(dense.in_size, dense.out_size, weights));
 
         // load biases
         RTNEURAL_IF_CONSTEXPR(DenseType::dense_has_bias)
@@ -63,6 +71,61 @@ namespace json_parser
         }
     }
 
+    /**
+     * Loads weights for a LowRankDense (or LowRankDenseT) layer from a json
+     * representation of the layer weights, stored as low-rank factors:
+     * [kernel_in[in_size][rank], kernel_out[rank][out_size], bias[out_size]],
+     * i.e. the weights of two stacked Dense layers.
+     */
+    template <typename T, typename DenseType>
+    void loadLowRankDense(DenseType& dense, const nlohmann::json& weights)
+    {
+        const auto kernelIn = weights.at(0).get<std::vector<std::vector<T>>>();
+        const auto kernelOut = weights.at(1).get<std::vector<std::vector<T>>>();
+        const auto rank = kernelOut.size();
+
+        std::vector<std::vector<T>> left((size_t)dense.out_size, std::vector<T>(rank));
+        std::vector<std::vector<T>> right(rank, std::vector<T>((size_t)dense.in_size));
+        for(size_t r = 0; r < rank; ++r)
+        {
+            for(size_t i = 0; i < (size_t)dense.out_size; ++i)
+                left[i][r] = kernelOut.at(r).at(i);
+            for(size_t k = 0; k < (size_t)dense.in_size; ++k)
+                right[r][k] = kernelIn.at(k).at(r);
+        }
+
+        dense.setFactors(left, right);
+
+        RTNEURAL_IF_CONSTEXPR(DenseType::dense_has_bias)
+        {
+            if(weights.size() >= 3)
+            {
+                std::vector<T> denseBias = weights.at(2).get<std::vector<T>>();
+                dense.setBias(denseBias.data());
+            }
+        }
+    }
+
+    /**
+     * Loads weights for a LowRankDense (or LowRankDenseT) layer from a
+     * json representation of full-rank Dense layer weights, using the
+     * rank-r factors that best approximate the weights.
+     */
+    template <typename T, typename DenseType>
+    void loadLowRankDense(DenseType& dense, const low_rank::Factors<T>& factors, const nlohmann::json& weights)
+    {
+        dense.setFactors(factors.left, factors.right);
+
+        RTNEURAL_IF_CONSTEXPR(DenseType::dense_has_bias)
+        {
+            if(weights.size() >= 2)
+            {
+                std::vector<T> denseBias = weights.at(1).get<std::vector<T>>();
+                dense.setBias(denseBias.data());
+            }
+        }
+    }
+
     /** Creates a Dense layer from a json representation of the layer weights. */
     template <typename T>
     std::unique_ptr<Dense<T>> createDense(int in_size, int out_size, const nlohmann::json& weights)
@@ -72,6 +135,64 @@ namespace json_parser
         return std::move(dense);
     }
 
+    /** Creates a SparseDense layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<SparseDense<T>> createSparseDense(int in_size, int out_size, const nlohmann::json& weights)
+    {
+        auto dense = std::make_unique<SparseDense<T>>(in_size, out_size);
+        loadDense<T>(*dense.get(), weights);
+        return std::move(dense);
+    }
+
+    /** Creates a LowRankDense layer from a json representation of the layer weights, stored as low-rank factors. */
+    template <typename T>
+    std::unique_ptr<LowRankDense<T>> createLowRankDense(int in_size, int out_size, int rank, const nlohmann::json& weights)
+    {
+        auto dense = std::make_unique<LowRankDense<T>>(in_size, out_size, rank);
+        loadLowRankDense<T>(*dense.get(), weights);
+        return std::move(dense);
+    }
+
+    /**
+     * Creates a LowRankDense layer from a json representation of full-rank
+     * Dense layer weights, using the lowest-rank factors that approximate
+     * the weights within the given (relative) tolerance.
+     *
+     * Returns nullptr if the factors would not be cheaper to compute than
+     * the full-rank weights.
+     */
+    template <typename T>
+    std::unique_ptr<LowRankDense<T>> createFactorizedDense(int in_size, int out_size, const nlohmann::json& weights, double tolerance, const bool debug)
+    {
+        const auto factors = low_rank::factorizeWithTolerance(getDenseWeights<T>(in_size, out_size, weights), tolerance);
+        if(factors.rank * (in_size + out_size) >= in_size * out_size)
+            return {};
+
+        debug_print("  low-rank weights: rank " + std::to_string(factors.rank) + ", error " + std::to_string(factors.error), debug);
+        auto dense = std::make_unique<LowRankDense<T>>(in_size, out_size, factors.rank);
+        loadLowRankDense<T>(*dense.get(), factors, weights);
+        return std::move(dense);
+    }
+
+    /** Returns the fraction of zero-valued weights in a json representation of Dense layer weights. */
+    template <typename T>
+    double getDenseSparsity(const nlohmann::json& weights)
+    {
+        size_t num_weights = 0;
+        size_t num_zeros = 0;
+        for(const auto& lw : weights.at(0))
+        {
+            for(const auto& w : lw)
+            {
+                num_weights++;
+                if(w.get<T>() == (T)0)
+                    num_zeros++;
+            }
+        }
+
+        return num_weights > 0 ? (double)num_zeros / (double)num_weights : 0.0;
+    }
+
     /** Checks that a Dense (or DenseT) layer has the given dimensions. */
     template <typename T, typename DenseType>
     bool checkDense(const DenseType& dense, const std::string& type, int layerDims, const bool debug)
@@ -182,6 +303,16 @@ namespace json_parser
         return std::move(conv);
     }
 
+    /** Creates a StridedConv1D layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<StridedConv1D<T>> createStridedConv1D(int in_size, int out_size,
+        int kernel_size, int dilation, int stride, int groups, const nlohmann::json& weights)
+    {
+        auto conv = std::make_unique<StridedConv1D<T>>(in_size, out_size, kernel_size, dilation, stride, groups);
+        loadConv1D<T>(*conv.get(), kernel_size, dilation, weights);
+        return std::move(conv);
+    }
+
     /** Checks that a Conv1D (or Conv1DT) layer has the given dimensions. */
     template <typename T, typename Conv1DType>
     bool checkConv1D(const Conv1DType& conv, const std::string& type, int layerDims,
@@ -220,6 +351,99 @@ namespace json_parser
         return true;
     }
 
+    /**
+     * Loads weights for a ConvTranspose1D (or ConvTranspose1DT) layer from a json representation of the layer weights.
+     *
+     * Unlike regular convolutions, the kernel is not reversed, since tap k of a transposed
+     * convolution already lands k * dilation output frames after its input frame.
+     */
+    template <typename T, typename ConvTranspose1DType>
+    void loadConvTranspose1D(ConvTranspose1DType& conv, int kernel_size, const nlohmann::json& weights)
+    {
+        // In Tensorflow (JSON file): [kernel_size, out_channels, in_size / groups]
+        // In RTNeural ConvTranspose1D::setWeights: [out_channels, in_size / groups, kernel_size]
+        std::vector<std::vector<std::vector<T>>> convWeights(conv.getOutChannels());
+        for(auto& wIn : convWeights)
+        {
+            wIn.resize(conv.in_size / conv.getGroups());
+
+            for(auto& w : wIn)
+                w.resize(kernel_size, (T)0);
+        }
+
+        auto layerWeights = weights.at(0);
+        for(size_t i = 0; i < layerWeights.size(); ++i)
+        {
+            auto lw = layerWeights.at(i);
+            for(size_t j = 0; j < lw.size(); ++j)
+            {
+                auto l = lw.at(j);
+                for(size_t k = 0; k < l.size(); ++k)
+                    convWeights.at(j).at(k).at(i) = l.at(k).get<T>();
+            }
+        }
+
+        conv.setWeights(convWeights);
+
+        // load biases
+        std::vector<T> convBias = weights.at(1).get<std::vector<T>>();
+        conv.setBias(convBias);
+    }
+
+    /** Creates a ConvTranspose1D layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<ConvTranspose1D<T>> createConvTranspose1D(int in_size, int out_channels,
+        int kernel_size, int dilation, int stride, int groups, const nlohmann::json& weights)
+    {
+        auto conv = std::make_unique<ConvTranspose1D<T>>(in_size, out_channels, kernel_size, dilation, stride, groups);
+        loadConvTranspose1D<T>(*conv.get(), kernel_size, weights);
+        return std::move(conv);
+    }
+
+    /** Checks that a ConvTranspose1D (or ConvTranspose1DT) layer has the given dimensions. */
+    template <typename T, typename ConvTranspose1DType>
+    bool checkConvTranspose1D(const ConvTranspose1DType& conv, const std::string& type, int layerDims,
+        int kernel_size, int dilation_rate, int stride, int groups, const bool debug)
+    {
+        if(type != "convtranspose1d")
+        {
+            debug_print("Wrong layer type! Expected: ConvTranspose1D", debug);
+            return false;
+        }
+
+        if(layerDims != conv.getOutChannels())
+        {
+            debug_print("Wrong layer size! Expected: " + std::to_string(conv.getOutChannels()), debug);
+            return false;
+        }
+
+        if(kernel_size != conv.getKernelSize())
+        {
+            debug_print("Wrong kernel size! Expected: " + std::to_string(conv.getKernelSize()), debug);
+            return false;
+        }
+
+        if(dilation_rate != conv.getDilationRate())
+        {
+            debug_print("Wrong dilation_rate! Expected: " + std::to_string(conv.getDilationRate()), debug);
+            return false;
+        }
+
+        if(stride != conv.getStride())
+        {
+            debug_print("Wrong stride! Expected: " + std::to_string(conv.getStride()), debug);
+            return false;
+        }
+
+        if(groups != conv.getGroups())
+        {
+            debug_print("Wrong number of groups! Expected: " + std::to_string(conv.getGroups()), debug);
+            return false;
+        }
+
+        return true;
+    }
+
     template <typename T>
     std::unique_ptr<Conv2D<T>> createConv2D(int num_filters_in, int num_features_in, int num_filters_out,
         int kernel_size_time, int kernel_size_feature, int dilation, int stride, bool valid_pad, const nlohmann::json& weights)
@@ -273,7 +497,86 @@ namespace json_parser
         return true;
     }
 
-    /** Loads weights for a GRULayer (or GRULayerT) from a json representation of the layer weights. */
+    /** Sets the recurrent weights of a layer from low-rank factors, for layers without low-rank support. */
+    template <typename T, typename RecurrentType>
+    void setRecurrentFactors(RecurrentType& layer, const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        layer.setUVals(low_rank::multiply(left, right));
+    }
+
+    /** Sets the recurrent weights of a GRULayerT from low-rank factors. */
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void setRecurrentFactors(GRULayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& gru, const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        gru.setUFactors(left, right);
+    }
+
+    /** Sets the recurrent weights of a LSTMLayerT from low-rank factors. */
+    template <typename T, int in_size, int out_size, SampleRateCorrectionMode mode, typename MathsProvider, bool block_sparse>
+    void setRecurrentFactors(LSTMLayerT<T, in_size, out_size, mode, MathsProvider, block_sparse>& lstm, const std::vector<std::vector<T>>& left, const std::vector<std::vector<T>>& right)
+    {
+        lstm.setUFactors(left, right);
+    }
+
+    /**
+     * Loads the recurrent weights for a recurrent layer, from either
+     * the full-rank weights [out_size][gates_size], or low-rank factors
+     * stored as [left[out_size][rank], right[rank][gates_size]].
+     *
+     * Returns the index of the next entry in the weights (i.e. the bias).
+     */
+    template <typename T, typename RecurrentType>
+    size_t loadRecurrentWeights(RecurrentType& layer, const nlohmann::json& weights, int gates_size, bool low_rank)
+    {
+        if(low_rank)
+        {
+            const auto left = weights.at(1).get<std::vector<std::vector<T>>>();
+            const auto right = weights.at(2).get<std::vector<std::vector<T>>>();
+            setRecurrentFactors<T>(layer, left, right);
+            return 3;
+        }
+
+        std::vector<std::vector<T>> recurrentWeights((size_t)layer.out_size);
+        for(auto& w : recurrentWeights)
+            w.resize((size_t)gates_size, (T)0);
+
+        auto layerWeights = weights.at(1);
+        for(size_t i = 0; i < layerWeights.size(); ++i)
+        {
+            auto lw = layerWeights.at(i);
+            for(size_t j = 0; j < lw.size(); ++j)
+                recurrentWeights.at(i).at(j) = lw.at(j).get<T>();
+        }
+
+        layer.setUVals(recurrentWeights);
+        return 2;
+    }
+
+    /**
+     * Replaces the recurrent weights of a GRULayerT or LSTMLayerT with the
+     * lowest-rank factors that approximate the weights within the given
+     * (relative) tolerance, if the layer supports a low enough rank.
+     */
+    template <typename T, typename RecurrentType>
+    void factorizeRecurrentWeights(RecurrentType& layer, const nlohmann::json& weights, double tolerance, const bool debug)
+    {
+        if(weights.size() != 3) // already factorized
+            return;
+
+        const auto factors = low_rank::factorizeWithTolerance(weights.at(1).get<std::vector<std::vector<T>>>(), tolerance);
+        if(factors.rank > layer.max_recurrent_rank)
+            return;
+
+        debug_print("  low-rank recurrent weights: rank " + std::to_string(factors.rank) + ", error " + std::to_string(factors.error), debug);
+        layer.setUFactors(factors.left, factors.right);
+    }
+
+    /**
+     * Loads weights for a GRULayer (or GRULayerT) from a json representation of the layer weights.
+     *
+     * The weights are stored as [kernel, recurrent, bias], or as
+     * [kernel, recurrent_left, recurrent_right, bias] for low-rank recurrent weights.
+     */
     template <typename T, typename GRUType>
     void loadGRU(GRUType& gru, const nlohmann::json& weights)
     {
@@ -293,26 +596,14 @@ namespace json_parser
         gru.setWVals(kernelWeights);
 
         // load recurrent weights
-        std::vector<std::vector<T>> recurrentWeights(gru.out_size);
-        for(auto& w : recurrentWeights)
-            w.resize(3 * gru.out_size, (T)0);
-
-        auto layerWeights2 = weights.at(1);
-        for(size_t i = 0; i < layerWeights2.size(); ++i)
-        {
-            auto lw = layerWeights2.at(i);
-            for(size_t j = 0; j < lw.size(); ++j)
-                recurrentWeights.at(i).at(j) = lw.at(j).get<T>();
-        }
-
-        gru.setUVals(recurrentWeights);
+        const size_t biasIndex = loadRecurrentWeights<T>(gru, weights, 3 * gru.out_size, weights.size() == 4);
 
         // load biases
         std::vector<std::vector<T>> gruBias(2);
         for(auto& b : gruBias)
             b.resize(3 * gru.out_size, (T)0);
 
-        auto layerBias = weights.at(2);
+        auto layerBias = weights.at(biasIndex);
         for(size_t i = 0; i < layerBias.size(); ++i)
         {
             auto lw = layerBias.at(i);
@@ -351,7 +642,12 @@ namespace json_parser
         return true;
     }
 
-    /** Loads weights for a LSTMLayer (or LSTMLayerT) from a json representation of the layer weights. */
+    /**
+     * Loads weights for a LSTMLayer (or LSTMLayerT) from a json representation of the layer weights.
+     *
+     * The weights are stored as [kernel, recurrent, bias], or as
+     * [kernel, recurrent_left, recurrent_right, bias] for low-rank recurrent weights.
+     */
     template <typename T, typename LSTMType>
     void loadLSTM(LSTMType& lstm, const nlohmann::json& weights)
     {
@@ -371,22 +667,10 @@ namespace json_parser
         lstm.setWVals(kernelWeights);
 
         // load recurrent weights
-        std::vector<std::vector<T>> recurrentWeights(lstm.out_size);
-        for(auto& w : recurrentWeights)
-            w.resize(4 * lstm.out_size, (T)0);
-
-        auto layerWeights2 = weights.at(1);
-        for(size_t i = 0; i < layerWeights2.size(); ++i)
-        {
-            auto lw = layerWeights2.at(i);
-            for(size_t j = 0; j < lw.size(); ++j)
-                recurrentWeights.at(i).at(j) = lw.at(j).get<T>();
-        }
-
-        lstm.setUVals(recurrentWeights);
+        const size_t biasIndex = loadRecurrentWeights<T>(lstm, weights, 4 * lstm.out_size, weights.size() == 4);
 
         // load biases
-        std::vector<T> lstmBias = weights.at(2).get<std::vector<T>>();
+        std::vector<T> lstmBias = weights.at(biasIndex).get<std::vector<T>>();
         lstm.setBVals(lstmBias);
     }
 
@@ -565,6 +849,128 @@ namespace json_parser
         return true;
     }
 
+    /** Creates a LayerNorm or RMSNorm layer from a json representation of the layer weights. */
+    template <typename T>
+    std::unique_ptr<Layer<T>> createLayerNorm(const std::string& type, int size, const nlohmann::json& l)
+    {
+        const auto& weights = l.at("weights");
+        if(type == "rmsnorm")
+        {
+            auto norm = std::make_unique<RMSNorm<T>>(size);
+            norm->setGamma(weights.at(0).get<std::vector<T>>());
+            if(l.contains("epsilon"))
+                norm->setEpsilon(l.at("epsilon").get<T>());
+            return std::move(norm);
+        }
+
+        auto norm = std::make_unique<LayerNorm<T>>(size);
+        norm->setGamma(weights.at(0).get<std::vector<T>>());
+        norm->setBeta(weights.at(1).get<std::vector<T>>());
+        if(l.contains("epsilon"))
+            norm->setEpsilon(l.at("epsilon").get<T>());
+        return std::move(norm);
+    }
+
+    /** Loads weights for a LayerNormT (or RMSNormT) from a json representation of the layer. */
+    template <typename T, typename LayerNormType>
+    void loadLayerNorm(LayerNormType& norm, const nlohmann::json& l)
+    {
+        const auto& weights = l.at("weights");
+        norm.setGamma(weights.at(0).get<std::vector<T>>());
+        if(weights.size() > 1)
+            norm.setBeta(weights.at(1).get<std::vector<T>>());
+        if(l.contains("epsilon"))
+            norm.setEpsilon(l.at("epsilon").get<T>());
+    }
+
+    /** Checks that a LayerNormT (or RMSNormT) has the given dimensions. */
+    template <typename T, typename LayerNormType>
+    bool checkLayerNorm(const LayerNormType& norm, const std::string& type, int layerDims, const bool debug)
+    {
+        if(type != norm.getName())
+        {
+            debug_print("Wrong layer type! Expected: " + norm.getName(), debug);
+            return false;
+        }
+
+        if(layerDims != norm.out_size)
+        {
+            debug_print("Wrong layer size! Expected: " + std::to_string(norm.out_size), debug);
+            return false;
+        }
+
+        return true;
+    }
+
+    /**
+     * Loads weights for a MultiHeadAttention (or MultiHeadAttentionT) layer from a json
+     * representation of the layer weights: the query, key, and value kernel (with size
+     * [embed_dim][3 * embed_dim]), and bias, followed by the output kernel (with size
+     * [embed_dim][embed_dim]), and bias.
+     */
+    template <typename T, typename AttentionType>
+    void loadAttention(AttentionType& attention, const nlohmann::json& weights)
+    {
+        const auto transpose = [](const std::vector<std::vector<T>>& kernel)
+        {
+            std::vector<std::vector<T>> matrix(kernel[0].size(), std::vector<T>(kernel.size()));
+            for(size_t i = 0; i < kernel.size(); ++i)
+                for(size_t j = 0; j < kernel[i].size(); ++j)
+                    matrix[j][i] = kernel[i][j];
+            return matrix;
+        };
+
+        attention.setInputWeights(transpose(weights.at(0).get<std::vector<std::vector<T>>>()), weights.at(1).get<std::vector<T>>());
+        attention.setOutputWeights(transpose(weights.at(2).get<std::vector<std::vector<T>>>()), weights.at(3).get<std::vector<T>>());
+    }
+
+    /** Creates a MultiHeadAttention layer from a json representation of the layer. */
+    template <typename T, typename MathsProvider = DefaultMathsProvider>
+    std::unique_ptr<MultiHeadAttention<T, MathsProvider>> createAttention(int size, const nlohmann::json& l, const bool debug)
+    {
+        const auto num_heads = l.at("num_heads").get<int>();
+        if(num_heads <= 0 || size % num_heads != 0)
+        {
+            debug_print("The attention size must be a multiple of the number of heads!", debug);
+            return {};
+        }
+
+        auto attention = std::make_unique<MultiHeadAttention<T, MathsProvider>>(size, num_heads, l.at("context_length").get<int>());
+        loadAttention<T>(*attention, l.at("weights"));
+        return std::move(attention);
+    }
+
+    /** Checks that a MultiHeadAttentionT has the given dimensions. */
+    template <typename T, typename AttentionType>
+    bool checkAttention(const AttentionType& attention, const std::string& type, int layerDims, const nlohmann::json& l, const bool debug)
+    {
+        if(type != "attention")
+        {
+            debug_print("Wrong layer type! Expected: Attention", debug);
+            return false;
+        }
+
+        if(layerDims != attention.out_size)
+        {
+            debug_print("Wrong layer size! Expected: " + std::to_string(attention.out_size), debug);
+            return false;
+        }
+
+        if(l.at("num_heads").get<int>() != attention.getNumHeads())
+        {
+            debug_print("Wrong number of heads! Expected: " + std::to_string(attention.getNumHeads()), debug);
+            return false;
+        }
+
+        if(l.at("context_length").get<int>() != attention.getContextLength())
+        {
+            debug_print("Wrong context length! Expected: " + std::to_string(attention.getContextLength()), debug);
+            return false;
+        }
+
+        return true;
+    }
+
     /** Creates an activation layer of a given type. */
     template <typename T, typename MathsProvider = DefaultMathsProvider>
     std::unique_ptr<Activation<T>>
@@ -607,12 +1013,143 @@ namespace json_parser
         return true;
     }
 
-    /** Creates a neural network model from a json stream. */
+    /** Returns true if the json layer is a Dense, Conv1D, or Conv2D layer that a following batchnorm can be folded into. */
+    inline bool isBatchNormFoldTarget(const nlohmann::json& l)
+    {
+        const auto type = l.at("type").get<std::string>();
+        if(type != "dense" && type != "time-distributed-dense" && type != "conv1d" && type != "conv2d")
+            return false;
+
+        // low-rank factors, and layers without a bias, can't absorb the batchnorm shift
+        if(l.contains("rank") || l.at("weights").size() < 2)
+            return false;
+
+        return !l.contains("activation") || l.at("activation").get<std::string>().empty();
+    }
+
+    /** Multiplies each element along the last axis of a json weights tensor by the corresponding scale. */
+    template <typename T>
+    void scaleLastAxis(nlohmann::json& tensor, const std::vector<T>& scale)
+    {
+        if(!tensor.at(0).is_array())
+        {
+            for(size_t i = 0; i < tensor.size(); ++i)
+                tensor[i] = tensor[i].get<T>() * scale[i];
+            return;
+        }
+
+        for(auto& sub_tensor : tensor)
+            scaleLastAxis<T>(sub_tensor, scale);
+    }
+
+    /**
+     * Returns a copy of the model json, where each inference-mode batchnorm
+     * (or batchnorm2d) layer that directly follows a Dense, Conv1D, or Conv2D
+     * layer without an activation is folded into that layer's weights and bias:
+     * ```
+     * W' = W * gamma / sqrt(var + epsilon)
+     * b' = (b - mean) * gamma / sqrt(var + epsilon) + beta
+     * ```
+     * The folded batchnorm layers are marked as "folded", and given identity
+     * weights, so that `parseJson()` skips them, and a `ModelT` that still
+     * has a batchnorm layer for them computes the same outputs.
+     */
+    template <typename T>
+    nlohmann::json foldBatchNorms(const nlohmann::json& parent, const bool debug = false)
+    {
+        auto folded = parent;
+        if(!folded.contains("layers") || !folded.at("layers").is_array())
+            return folded;
+
+        auto& layers = folded.at("layers");
+        nlohmann::json* target = nullptr;
+        for(auto& l : layers)
+        {
+            const auto type = l.at("type").get<std::string>();
+            const auto is_batch_norm = type == "batchnorm" || type == "batchnorm2d";
+            const auto has_activation = l.contains("activation") && !l.at("activation").get<std::string>().empty();
+
+            if(!is_batch_norm || target == nullptr || has_activation)
+            {
+                target = isBatchNormFoldTarget(l) ? &l : nullptr;
+                continue;
+            }
+
+            auto& bn_weights = l.at("weights");
+            auto& target_weights = target->at("weights");
+            const auto affine = bn_weights.size() == 4;
+            const auto mean = bn_weights.at(affine ? 2 : 0).get<std::vector<T>>();
+            const auto variance = bn_weights.at(affine ? 3 : 1).get<std::vector<T>>();
+            const auto epsilon = l.at("epsilon").get<T>();
+
+            auto bias = target_weights.at(1).get<std::vector<T>>();
+            if(mean.size() != bias.size())
+            {
+                target = nullptr;
+                continue;
+            }
+
+            std::vector<T> scale(bias.size(), (T)1);
+            std::vector<T> shift(bias.size(), (T)0);
+            for(size_t i = 0; i < bias.size(); ++i)
+            {
+                scale[i] = (affine ? bn_weights.at(0).at(i).get<T>() : (T)1) / std::sqrt(variance[i] + epsilon);
+                shift[i] = affine ? bn_weights.at(1).at(i).get<T>() : (T)0;
+                bias[i] = (bias[i] - mean[i]) * scale[i] + shift[i];
+            }
+
+            scaleLastAxis<T>(target_weights.at(0), scale);
+            target_weights.at(1) = bias;
+
+            // the batchnorm layer becomes an identity
+            const std::vector<T> zeros(bias.size(), (T)0);
+            const std::vector<T> ones(bias.size(), (T)1);
+            if(affine)
+                bn_weights = { ones, zeros, zeros, ones };
+            else
+                bn_weights = { zeros, ones };
+            l["epsilon"] = 0;
+            l["folded"] = true;
+
+            debug_print("Folded " + type + " into the previous " + target->at("type").get<std::string>() + " layer", debug);
+        }
+
+        return folded;
+    }
+
+    /** Returns true if the json layer is a batchnorm layer that has been folded into the previous layer. */
+    inline bool isFoldedBatchNorm(const nlohmann::json& l)
+    {
+        return l.value("folded", false);
+    }
+
+    /**
+     * Creates a neural network model from a json stream.
+     *
+     * Dense layers with at least `sparsity_threshold` zero-valued weights
+     * are created as SparseDense layers. Use a threshold greater than 1
+     * to always create regular Dense layers.
+     *
+     * Dense layers stored as low-rank factors (with a "rank" field) are
+     * created as LowRankDense layers. With a non-zero `low_rank_tolerance`,
+     * the other Dense layers are factorized when loading, if low-rank factors
+     * within that relative error are cheaper to compute than the full weights.
+     *
+     * Batchnorm layers that directly follow a Dense, Conv1D, or Conv2D layer
+     * without an activation are folded into that layer (see `foldBatchNorms()`),
+     * so the model doesn't contain a layer for them.
+     *
+     * Element-wise activations (tanh, relu, sigmoid, and elu) attached to a
+     * Dense, Conv1D, or Conv2D layer are fused into that layer (see
+     * `Dense::setActivation()`), rather than added as a separate layer.
+     */
     template <typename T, typename MathsProvider = DefaultMathsProvider>
-    std::unique_ptr<Model<T>> parseJson(const nlohmann::json& parent, const bool debug = false)
+    std::unique_ptr<Model<T>> parseJson(const nlohmann::json& parent, const bool debug = false,
+        const double sparsity_threshold = default_sparsity_threshold, const double low_rank_tolerance = 0.0)
     {
-        auto shape = parent.at("in_shape");
-        auto layers = parent.at("layers");
+        const nlohmann::json folded = foldBatchNorms<T>(parent, debug);
+        auto shape = folded.at("in_shape");
+        auto layers = folded.at("layers");
 
         if(!shape.is_array() || !layers.is_array())
             return {};
@@ -628,6 +1165,12 @@ namespace json_parser
             const auto type = l.at("type").get<std::string>();
             debug_print("Layer: " + type, debug);
 
+            if(isFoldedBatchNorm(l))
+            {
+                debug_print("  folded into the previous layer", debug);
+                continue;
+            }
+
             const auto layerShape = l.at("shape");
 
             // In case of 4 dimensional input (conv2d): multiply channel axis and feature axis to get layer dim
@@ -651,19 +1194,84 @@ namespace json_parser
                 }
             };
 
+            auto fuse_activation = [=](auto& layer, const nlohmann::json& _l)
+            {
+                const auto activationType = _l.value("activation", std::string {});
+                if(activationType != "tanh" && activationType != "relu" && activationType != "sigmoid" && activationType != "elu")
+                    return false;
+
+                debug_print("  fused activation: " + activationType, debug);
+                layer.setActivation(createActivation<T, MathsProvider>(activationType, layerDims));
+                return true;
+            };
+
             if(type == "dense" || type == "time-distributed-dense")
             {
-                auto dense = createDense<T>(model->getNextInSize(), layerDims, weights);
+                std::unique_ptr<Layer<T>> dense;
+                bool fused = false;
+                if(l.contains("rank"))
+                {
+                    const auto rank = l.at("rank").get<int>();
+                    debug_print("  low-rank weights: rank " + std::to_string(rank), debug);
+                    dense = createLowRankDense<T>(model->getNextInSize(), layerDims, rank, weights);
+                }
+                else
+                {
+                    const auto sparsity = getDenseSparsity<T>(weights);
+                    if(sparsity >= sparsity_threshold)
+                    {
+                        debug_print("  sparse weights: " + std::to_string(sparsity), debug);
+                        dense = createSparseDense<T>(model->getNextInSize(), layerDims, weights);
+                    }
+                    else if(low_rank_tolerance > 0.0)
+                    {
+                        dense = createFactorizedDense<T>(model->getNextInSize(), layerDims, weights, low_rank_tolerance, debug);
+                    }
+
+                    if(dense == nullptr)
+                    {
+                        auto full_dense = createDense<T>(model->getNextInSize(), layerDims, weights);
+                        fused = fuse_activation(*full_dense, l);
+                        dense = std::move(full_dense);
+                    }
+                }
+
                 model->addLayer(dense.release());
-                add_activation(model, l);
+                if(!fused)
+                    add_activation(model, l);
             }
             else if(type == "conv1d")
             {
                 const auto kernel_size = l.at("kernel_size").back().get<int>();
                 const auto dilation = l.at("dilation").back().get<int>();
                 const auto groups = l.value("groups", 1);
+                const auto stride = l.contains("strides") ? l.at("strides").back().get<int>() : 1;
+
+                if(stride > 1)
+                {
+                    // the following layers run at the decimated rate
+                    auto conv = createStridedConv1D<T>(model->getNextInSize(), layerDims, kernel_size, dilation, stride, groups, weights);
+                    model->addLayer(conv.release());
+                    add_activation(model, l);
+                }
+                else
+                {
+                    auto conv = createConv1D<T>(model->getNextInSize(), layerDims, kernel_size, dilation, groups, weights);
+                    const auto fused = fuse_activation(*conv, l);
+                    model->addLayer(conv.release());
+                    if(!fused)
+                        add_activation(model, l);
+                }
+            }
+            else if(type == "convtranspose1d")
+            {
+                const auto kernel_size = l.at("kernel_size").back().get<int>();
+                const auto dilation = l.at("dilation").back().get<int>();
+                const auto stride = l.at("strides").back().get<int>();
+                const auto groups = l.value("groups", 1);
 
-                auto conv = createConv1D<T>(model->getNextInSize(), layerDims, kernel_size, dilation, groups, weights);
+                // the following layers run once for each output frame
+                auto conv = createConvTranspose1D<T>(model->getNextInSize(), layerDims, kernel_size, dilation, stride, groups, weights);
                 model->addLayer(conv.release());
                 add_activation(model, l);
             }
@@ -684,8 +1292,10 @@ namespace json_parser
                 if(!checkConv2D<T>(*conv, "conv2d", layerDims, kernel_size_time, kernel_size_feature, dilation, stride, valid_pad, debug))
                     return {};
 
+                const auto fused = fuse_activation(*conv, l);
                 model->addLayer(conv.release());
-                add_activation(model, l);
+                if(!fused)
+                    add_activation(model, l);
             }
             else if(type == "gru")
             {
@@ -712,6 +1322,19 @@ namespace json_parser
                 auto batch_norm = createBatchNorm2D<T>(l.at("num_filters_in"), l.at("num_features_in"), weights, l.at("epsilon").get<T>());
                 model->addLayer(batch_norm.release());
             }
+            else if(type == "layernorm" || type == "rmsnorm")
+            {
+                auto norm = createLayerNorm<T>(type, model->getNextInSize(), l);
+                model->addLayer(norm.release());
+            }
+            else if(type == "attention")
+            {
+                auto attention = createAttention<T, MathsProvider>(model->getNextInSize(), l, debug);
+                if(attention == nullptr)
+                    return {};
+
+                model->addLayer(attention.release());
+            }
             else if(type == "activation")
             {
                 add_activation(model, l);
@@ -723,11 +1346,192 @@ namespace json_parser
 
     /** Creates a neural network model from a json stream. */
     template <typename T>
-    std::unique_ptr<Model<T>> parseJson(std::ifstream& jsonStream, const bool debug = false)
+    std::unique_ptr<Model<T>> parseJson(std::ifstream& jsonStream, const bool debug = false,
+        const double sparsity_threshold = default_sparsity_threshold, const double low_rank_tolerance = 0.0)
     {
         nlohmann::json parent;
         jsonStream >> parent;
-        return parseJson<T>(parent, debug);
+        return parseJson<T>(parent, debug, sparsity_threshold, low_rank_tolerance);
+    }
+
+    /**
+     * Loads the weights of a WaveNet (or WaveNetT/WaveNetArraysT) layer from a Neural Amp
+     * Modeler (NAM) WaveNet model, such as the "standard" NAM architecture, which has two
+     * chained layer arrays of un-gated tanh layers. The layer must have one layer array for
+     * each NAM layer array. Only models with no head, tanh activations (gated or not), and a
+     * condition input of the same size as the model input can be loaded. The skip outputs of
+     * NAM layers are their activations, so each layer array must have as many skip channels
+     * as residual channels, and the head scale is folded into the output weights of the last
+     * layer array. Returns false if the model can't be loaded.
+     */
+    template <typename T, typename WaveNetType>
+    bool loadNAMWaveNet(WaveNetType& wavenet, const nlohmann::json& modelJson, const bool debug = false)
+    {
+        if(modelJson.value("architecture", std::string {}) != "WaveNet")
+        {
+            debug_print("Not a NAM WaveNet model!", debug);
+            return false;
+        }
+
+        const auto& config = modelJson.at("config");
+        const auto& layerArrays = config.at("layers");
+        if(config.contains("head") && !config.at("head").is_null())
+        {
+            debug_print("Only NAM WaveNet models with no head are supported!", debug);
+            return false;
+        }
+
+        if((int)layerArrays.size() != wavenet.getNumLayerArrays())
+        {
+            debug_print("Wrong number of layer arrays! Expected: " + std::to_string(wavenet.getNumLayerArrays()), debug);
+            return false;
+        }
+
+        int weights_size = 0;
+        for(int a = 0; a < wavenet.getNumLayerArrays(); ++a)
+        {
+            const auto& layerArray = layerArrays.at((size_t)a);
+            const auto in_size = layerArray.at("input_size").get<int>();
+            const auto condition_size = layerArray.at("condition_size").get<int>();
+            const auto head_size = layerArray.at("head_size").get<int>();
+            const auto channels = layerArray.at("channels").get<int>();
+            const auto kernel_size = layerArray.at("kernel_size").get<int>();
+            const auto dilations = layerArray.at("dilations").get<std::vector<int>>();
+            const auto gated = layerArray.value("gated", false);
+            if(layerArray.value("activation", std::string {}) != "Tanh" || condition_size != wavenet.in_size)
+            {
+                debug_print("Only tanh layers, conditioned on the model input, are supported!", debug);
+                return false;
+            }
+
+            if(a > 0 && layerArrays.at((size_t)a - 1).at("head_size").get<int>() != channels)
+            {
+                debug_print("The head size of each layer array must match the channels of the next layer array!", debug);
+                return false;
+            }
+
+            const auto& stack = wavenet.getLayerArray(a);
+            if(in_size != stack.getInputSize() || condition_size != stack.getConditionSize() || head_size != stack.getOutputSize()
+                || channels != stack.getChannels() || channels != stack.getSkipChannels() || kernel_size != stack.getKernelSize()
+                || gated != stack.isGated() || (int)dilations.size() != stack.getNumLayers())
+            {
+                debug_print("Wrong WaveNet dimensions for layer array " + std::to_string(a) + "!", debug);
+                return false;
+            }
+
+            for(int l = 0; l < stack.getNumLayers(); ++l)
+            {
+                if(dilations[(size_t)l] != stack.getDilationRate(l))
+                {
+                    debug_print("Wrong dilation rate for layer " + std::to_string(l) + " of layer array " + std::to_string(a)
+                            + "! Expected: " + std::to_string(stack.getDilationRate(l)),
+                        debug);
+                    return false;
+                }
+            }
+
+            const auto gates = gated ? 2 * channels : channels;
+            const auto layer_weights_size = gates * (channels * kernel_size + 1 + condition_size) + channels * (channels + 1);
+            weights_size += channels * in_size + (int)dilations.size() * layer_weights_size
+                + head_size * (channels + (layerArray.value("head_bias", false) ? 1 : 0));
+        }
+
+        const auto weights = modelJson.at("weights").get<std::vector<T>>();
+        if((int)weights.size() < weights_size)
+        {
+            debug_print("Wrong number of weights! Expected: " + std::to_string(weights_size), debug);
+            return false;
+        }
+
+        auto w = weights.begin();
+        const auto readMatrix = [&w](int rows, int cols)
+        {
+            std::vector<std::vector<T>> matrix((size_t)rows, std::vector<T>((size_t)cols));
+            for(auto& row : matrix)
+                for(auto& x : row)
+                    x = *w++;
+            return matrix;
+        };
+        const auto readVector = [&w](int size)
+        {
+            std::vector<T> vector(w, w + size);
+            w += size;
+            return vector;
+        };
+
+        for(int a = 0; a < wavenet.getNumLayerArrays(); ++a)
+        {
+            auto& stack = wavenet.getLayerArray(a);
+            const auto channels = stack.getChannels();
+            const auto kernel_size = stack.getKernelSize();
+            const auto gates = stack.isGated() ? 2 * channels : channels;
+
+            std::vector<std::vector<T>> skipWeights((size_t)channels, std::vector<T>((size_t)channels, (T)0));
+            for(int i = 0; i < channels; ++i)
+                skipWeights[(size_t)i][(size_t)i] = (T)1;
+
+            stack.setInputWeights(readMatrix(channels, stack.getInputSize()), std::vector<T>((size_t)channels, (T)0));
+            for(int l = 0; l < stack.getNumLayers(); ++l)
+            {
+                // NAM stores the kernel taps oldest first
+                std::vector<std::vector<std::vector<T>>> convWeights((size_t)gates,
+                    std::vector<std::vector<T>>((size_t)channels, std::vector<T>((size_t)kernel_size)));
+                for(auto& kernels : convWeights)
+                    for(auto& kernel : kernels)
+                        for(int k = kernel_size - 1; k >= 0; --k)
+                            kernel[(size_t)k] = *w++;
+
+                const auto convBias = readVector(gates);
+                stack.setConvWeights(l, convWeights, convBias);
+                stack.setMixinWeights(l, readMatrix(gates, stack.getConditionSize()));
+
+                const auto residualWeights = readMatrix(channels, channels);
+                const auto residualBias = readVector(channels);
+                stack.setResidualWeights(l, residualWeights, residualBias);
+                stack.setSkipWeights(l, skipWeights, std::vector<T>((size_t)channels, (T)0));
+            }
+
+            const auto head_size = stack.getOutputSize();
+            auto outputWeights = readMatrix(head_size, channels);
+            auto outputBias = layerArrays.at((size_t)a).value("head_bias", false) ? readVector(head_size) : std::vector<T>((size_t)head_size, (T)0);
+
+            if(a + 1 == wavenet.getNumLayerArrays())
+            {
+                // the head scale is stored after the weights (or else in the config)
+                const auto head_scale = w != weights.end() ? *w : config.value("head_scale", (T)1);
+                for(auto& row : outputWeights)
+                    for(auto& x : row)
+                        x *= head_scale;
+                for(auto& x : outputBias)
+                    x *= head_scale;
+            }
+            stack.setOutputWeights(outputWeights, outputBias);
+        }
+
+        return true;
+    }
+
+    /** Creates a WaveNet layer from a Neural Amp Modeler (NAM) WaveNet model (see `loadNAMWaveNet()`). */
+    template <typename T, typename MathsProvider = DefaultMathsProvider>
+    std::unique_ptr<WaveNet<T, MathsProvider>> createNAMWaveNet(const nlohmann::json& modelJson, const bool debug = false)
+    {
+        if(!modelJson.contains("config") || modelJson.at("config").at("layers").empty())
+            return {};
+
+        const auto& layerArrays = modelJson.at("config").at("layers");
+        std::vector<WaveNetArrayConfig> configs;
+        for(const auto& layerArray : layerArrays)
+        {
+            const auto channels = layerArray.at("channels").get<int>();
+            configs.push_back({ channels, channels, layerArray.at("head_size").get<int>(), layerArray.at("kernel_size").get<int>(),
+                layerArray.at("dilations").get<std::vector<int>>(), layerArray.value("gated", false) });
+        }
+
+        auto wavenet = std::make_unique<WaveNet<T, MathsProvider>>(layerArrays.front().at("input_size").get<int>(), configs.back().head_size, configs);
+        if(!loadNAMWaveNet<T>(*wavenet, modelJson, debug))
+            return {};
+
+        return wavenet;
     }
 
 } // namespace json_parser
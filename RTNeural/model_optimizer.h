@@ -0,0 +1,458 @@
+#pragma once
+
+#include "model_loader.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <random>
+
+namespace RTNEURAL_NAMESPACE
+{
+namespace json_parser
+{
+    /**
+     * An optimization pass, which rewrites the layers of a model's json
+     * representation in-place, and returns the number of rewrites it made.
+     */
+    struct OptimizationPass
+    {
+        std::string name;
+        std::function<int(nlohmann::json& layers, bool debug)> run;
+    };
+
+    /** A summary of the passes that fired while optimizing a model. */
+    struct OptimizationReport
+    {
+        /** The number of rewrites made by each pass that fired, in the order they first fired. */
+        std::vector<std::pair<std::string, int>> passes;
+
+        /** The largest difference between the optimized and unoptimized model outputs. */
+        double max_error = 0.0;
+
+        /** True if the optimized model outputs are within the tolerance of the unoptimized model. */
+        bool verified = false;
+
+        /** Returns the number of rewrites made by a pass. */
+        int getNumRewrites(const std::string& pass) const
+        {
+            for(const auto& p : passes)
+                if(p.first == pass)
+                    return p.second;
+            return 0;
+        }
+
+        /** Adds some rewrites to the report. */
+        void addRewrites(const std::string& pass, int num_rewrites)
+        {
+            for(auto& p : passes)
+            {
+                if(p.first == pass)
+                {
+                    p.second += num_rewrites;
+                    return;
+                }
+            }
+
+            passes.emplace_back(pass, num_rewrites);
+        }
+    };
+
+    /** Default tolerance for verifying an optimized model against the unoptimized model. */
+    constexpr double default_optimization_tolerance = 1.0e-4;
+
+#ifndef DOXYGEN
+    namespace optimizer_detail
+    {
+        inline bool hasActivation(const nlohmann::json& l)
+        {
+            return !l.value("activation", std::string {}).empty();
+        }
+
+        /** Returns true for Dense layers stored as a full kernel (not low-rank factors). */
+        inline bool isFullDense(const nlohmann::json& l)
+        {
+            const auto type = l.at("type").get<std::string>();
+            return (type == "dense" || type == "time-distributed-dense") && !l.contains("rank");
+        }
+
+        /** Returns the number of gates of a recurrent layer (or 0 if the layer is not recurrent). */
+        inline int getNumGates(const nlohmann::json& l)
+        {
+            const auto type = l.at("type").get<std::string>();
+            return type == "gru" ? 3 : (type == "lstm" ? 4 : 0);
+        }
+
+        /** Returns the dense layer bias, which is zero if the layer has no bias. */
+        template <typename T>
+        std::vector<T> getDenseBias(const nlohmann::json& weights, size_t out_size)
+        {
+            if(weights.size() >= 2)
+                return weights.at(1).get<std::vector<T>>();
+            return std::vector<T>(out_size, (T)0);
+        }
+
+        /** Returns the product of a vector and a matrix, vec[rows] * mat[rows][cols]. */
+        template <typename T>
+        std::vector<T> multiply(const std::vector<T>& vec, const std::vector<std::vector<T>>& mat)
+        {
+            std::vector<T> out(mat.empty() ? 0 : mat[0].size(), (T)0);
+            for(size_t i = 0; i < mat.size(); ++i)
+                for(size_t j = 0; j < out.size(); ++j)
+                    out[j] += vec[i] * mat[i][j];
+            return out;
+        }
+
+        /**
+         * Folds an affine transform of a layer's input, x' = W_in * x + b_in,
+         * into the input weights of a Dense, GRU, or LSTM layer, where
+         * kernel[in][out] is the layer's input kernel.
+         */
+        template <typename T>
+        void foldInputTransform(nlohmann::json& l, const std::vector<std::vector<T>>& kernel_in, const std::vector<T>& bias_in)
+        {
+            auto& weights = l.at("weights");
+            const auto kernel = weights.at(0).get<std::vector<std::vector<T>>>();
+            const auto bias_offset = multiply(bias_in, kernel);
+
+            if(getNumGates(l) == 0)
+            {
+                auto bias = getDenseBias<T>(weights, bias_offset.size());
+                for(size_t j = 0; j < bias.size(); ++j)
+                    bias[j] += bias_offset[j];
+                weights = { low_rank::multiply(kernel_in, kernel), bias };
+                return;
+            }
+
+            // only the input bias of the recurrent layer changes
+            weights.at(0) = low_rank::multiply(kernel_in, kernel);
+            auto& bias = weights.at(weights.size() - 1);
+            auto& input_bias = bias.at(0).is_array() ? bias.at(0) : bias;
+            for(size_t j = 0; j < bias_offset.size(); ++j)
+                input_bias[j] = input_bias[j].get<T>() + bias_offset[j];
+        }
+    } // namespace optimizer_detail
+#endif // DOXYGEN
+
+    /**
+     * Merges a Dense layer without an activation into the following Dense
+     * layer, as a single layer with weights `W = W1 * W2`, and bias
+     * `b = b1 * W2 + b2`, if the merged layer is no more expensive to compute.
+     */
+    template <typename T>
+    int mergeLinearLayers(nlohmann::json& layers, const bool debug = false)
+    {
+        using namespace optimizer_detail;
+
+        int num_rewrites = 0;
+        for(size_t i = 0; i + 1 < layers.size();)
+        {
+            const auto& first = layers.at(i);
+            auto& second = layers.at(i + 1);
+            if(!isFullDense(first) || hasActivation(first) || !isFullDense(second))
+            {
+                ++i;
+                continue;
+            }
+
+            const auto kernel1 = first.at("weights").at(0).get<std::vector<std::vector<T>>>();
+            const auto kernel2 = second.at("weights").at(0).get<std::vector<std::vector<T>>>();
+            const auto in_size = kernel1.size();
+            const auto mid_size = kernel2.size();
+            const auto out_size = mid_size > 0 ? kernel2[0].size() : 0;
+            if(in_size == 0 || kernel1[0].size() != mid_size || in_size * out_size > (in_size + out_size) * mid_size)
+            {
+                ++i;
+                continue;
+            }
+
+            foldInputTransform<T>(second, kernel1, getDenseBias<T>(first.at("weights"), mid_size));
+            layers.erase(i);
+            num_rewrites++;
+
+            debug_print("Merged dense (" + std::to_string(in_size) + " -> " + std::to_string(mid_size) + ") into the following dense layer", debug);
+        }
+
+        return num_rewrites;
+    }
+
+    /**
+     * Folds a Dense layer without an activation into the input weights of a
+     * following GRU or LSTM layer, if the folded layer is no more expensive
+     * to compute.
+     */
+    template <typename T>
+    int foldDenseIntoRecurrent(nlohmann::json& layers, const bool debug = false)
+    {
+        using namespace optimizer_detail;
+
+        int num_rewrites = 0;
+        for(size_t i = 0; i + 1 < layers.size();)
+        {
+            const auto& dense = layers.at(i);
+            auto& recurrent = layers.at(i + 1);
+            const auto num_gates = getNumGates(recurrent);
+            if(!isFullDense(dense) || hasActivation(dense) || num_gates == 0)
+            {
+                ++i;
+                continue;
+            }
+
+            const auto dense_kernel = dense.at("weights").at(0).get<std::vector<std::vector<T>>>();
+            const auto& recurrent_kernel = recurrent.at("weights").at(0);
+            const auto in_size = dense_kernel.size();
+            const auto mid_size = recurrent_kernel.size();
+            const auto gates_size = mid_size > 0 ? recurrent_kernel.at(0).size() : 0;
+            if(in_size == 0 || dense_kernel[0].size() != mid_size || in_size * gates_size > (in_size + gates_size) * mid_size)
+            {
+                ++i;
+                continue;
+            }
+
+            foldInputTransform<T>(recurrent, dense_kernel, getDenseBias<T>(dense.at("weights"), mid_size));
+            debug_print("Folded dense (" + std::to_string(in_size) + " -> " + std::to_string(mid_size) + ") into the following "
+                    + recurrent.at("type").get<std::string>() + " layer",
+                debug);
+
+            layers.erase(i);
+            num_rewrites++;
+        }
+
+        return num_rewrites;
+    }
+
+    /**
+     * Folds an inference-mode batchnorm layer that can't be folded into the
+     * previous layer (e.g. because it follows an activation) into the input
+     * weights of a following Dense, GRU, or LSTM layer:
+     * ```
+     * W' = diag(gamma / sqrt(var + epsilon)) * W
+     * b' = b + (beta - mean * gamma / sqrt(var + epsilon)) * W
+     * ```
+     */
+    template <typename T>
+    int foldBatchNormsForward(nlohmann::json& layers, const bool debug = false)
+    {
+        using namespace optimizer_detail;
+
+        int num_rewrites = 0;
+        for(size_t i = 0; i + 1 < layers.size();)
+        {
+            const auto& bn = layers.at(i);
+            auto& next = layers.at(i + 1);
+            if(bn.at("type").get<std::string>() != "batchnorm" || isFoldedBatchNorm(bn) || hasActivation(bn)
+                || !(isFullDense(next) || getNumGates(next) > 0))
+            {
+                ++i;
+                continue;
+            }
+
+            const auto& bn_weights = bn.at("weights");
+            const auto affine = bn_weights.size() == 4;
+            const auto mean = bn_weights.at(affine ? 2 : 0).get<std::vector<T>>();
+            const auto variance = bn_weights.at(affine ? 3 : 1).get<std::vector<T>>();
+            const auto epsilon = bn.at("epsilon").get<T>();
+            if(mean.size() != next.at("weights").at(0).size())
+            {
+                ++i;
+                continue;
+            }
+
+            // the batchnorm is an affine transform with a diagonal kernel
+            std::vector<std::vector<T>> kernel(mean.size(), std::vector<T>(mean.size(), (T)0));
+            std::vector<T> bias(mean.size(), (T)0);
+            for(size_t k = 0; k < mean.size(); ++k)
+            {
+                const auto scale = (affine ? bn_weights.at(0).at(k).get<T>() : (T)1) / std::sqrt(variance[k] + epsilon);
+                kernel[k][k] = scale;
+                bias[k] = (affine ? bn_weights.at(1).at(k).get<T>() : (T)0) - mean[k] * scale;
+            }
+
+            foldInputTransform<T>(next, kernel, bias);
+            debug_print("Folded batchnorm into the following " + next.at("type").get<std::string>() + " layer", debug);
+
+            layers.erase(i);
+            num_rewrites++;
+        }
+
+        return num_rewrites;
+    }
+
+    /**
+     * Removes layers that don't change their inputs: activation layers
+     * without an activation, batchnorm layers that have been folded into
+     * the previous layer, and relu activation layers that follow a layer
+     * whose outputs already went through a relu.
+     */
+    inline int eliminateDeadLayers(nlohmann::json& layers, const bool debug = false)
+    {
+        using namespace optimizer_detail;
+
+        int num_rewrites = 0;
+        for(size_t i = 0; i < layers.size();)
+        {
+            const auto& l = layers.at(i);
+            const auto type = l.at("type").get<std::string>();
+            const auto activation = l.value("activation", std::string {});
+
+            const auto is_identity = (type == "activation" && activation.empty()) || isFoldedBatchNorm(l);
+            const auto is_redundant = type == "activation" && activation == "relu" && i > 0
+                && layers.at(i - 1).value("activation", std::string {}) == "relu";
+            if(!is_identity && !is_redundant)
+            {
+                ++i;
+                continue;
+            }
+
+            debug_print("Removed " + (is_identity ? std::string { "identity " } : std::string { "redundant " }) + type + " layer", debug);
+            layers.erase(i);
+            num_rewrites++;
+        }
+
+        return num_rewrites;
+    }
+
+    /**
+     * Returns the default optimization passes:
+     *  - "fold-batchnorm": see `foldBatchNorms()`
+     *  - "fold-batchnorm-forward": see `foldBatchNormsForward()`
+     *  - "merge-linear": see `mergeLinearLayers()`
+     *  - "fold-into-recurrent": see `foldDenseIntoRecurrent()`
+     *  - "eliminate-dead-layers": see `eliminateDeadLayers()`
+     */
+    template <typename T>
+    std::vector<OptimizationPass> getDefaultOptimizationPasses()
+    {
+        return {
+            { "fold-batchnorm", [](nlohmann::json& layers, bool debug)
+                {
+                    nlohmann::json model;
+                    model["layers"] = layers;
+                    model = foldBatchNorms<T>(model, debug);
+
+                    const auto num_folded = [](const nlohmann::json& ls)
+                    { return (int)std::count_if(ls.begin(), ls.end(), [](const nlohmann::json& l)
+                          { return isFoldedBatchNorm(l); }); };
+                    const auto num_rewrites = num_folded(model.at("layers")) - num_folded(layers);
+                    layers = model.at("layers");
+                    return num_rewrites;
+                } },
+            { "fold-batchnorm-forward", foldBatchNormsForward<T> },
+            { "merge-linear", mergeLinearLayers<T> },
+            { "fold-into-recurrent", foldDenseIntoRecurrent<T> },
+            { "eliminate-dead-layers", eliminateDeadLayers },
+        };
+    }
+
+    /**
+     * Returns a copy of the model json, rewritten by the optimization passes,
+     * before any layers are created from it. The passes are repeated until
+     * none of them fire (up to `max_iterations` times), and each pass that
+     * fired is added to the report.
+     *
+     * The optimized json is meant for `parseJson()`: the layers it removes
+     * would also have to be removed from a `ModelT` that loads it.
+     */
+    template <typename T>
+    nlohmann::json optimizeJson(const nlohmann::json& parent, OptimizationReport& report,
+        const std::vector<OptimizationPass>& passes = getDefaultOptimizationPasses<T>(), const bool debug = false, const int max_iterations = 16)
+    {
+        auto optimized = parent;
+        if(!optimized.contains("layers") || !optimized.at("layers").is_array())
+            return optimized;
+
+        auto& layers = optimized.at("layers");
+        for(int iter = 0; iter < max_iterations; ++iter)
+        {
+            bool fired = false;
+            for(const auto& pass : passes)
+            {
+                const auto num_rewrites = pass.run(layers, debug);
+                if(num_rewrites > 0)
+                {
+                    debug_print("Pass " + pass.name + ": " + std::to_string(num_rewrites) + " rewrite(s)", debug);
+                    report.addRewrites(pass.name, num_rewrites);
+                    fired = true;
+                }
+            }
+
+            if(!fired)
+                break;
+        }
+
+        return optimized;
+    }
+
+    /**
+     * Runs the models described by two json representations on the same
+     * (random) inputs, and returns the largest difference between their
+     * outputs, or infinity if the models can't be compared.
+     */
+    template <typename T, typename MathsProvider = DefaultMathsProvider>
+    double compareModels(const nlohmann::json& reference, const nlohmann::json& other, const int num_frames = 256)
+    {
+        auto referenceModel = parseJson<T, MathsProvider>(reference);
+        auto otherModel = parseJson<T, MathsProvider>(other);
+        if(referenceModel == nullptr || otherModel == nullptr || referenceModel->layers.empty() || otherModel->layers.empty()
+            || referenceModel->getInSize() != otherModel->getInSize() || referenceModel->getOutSize() != otherModel->getOutSize())
+            return std::numeric_limits<double>::infinity();
+
+        referenceModel->reset();
+        otherModel->reset();
+
+#if RTNEURAL_USE_XSIMD
+        std::vector<T, xsimd::aligned_allocator<T>> input((size_t)referenceModel->getInSize());
+#elif RTNEURAL_USE_EIGEN
+        std::vector<T, Eigen::aligned_allocator<T>> input((size_t)referenceModel->getInSize());
+#else
+        std::vector<T> input((size_t)referenceModel->getInSize());
+#endif
+
+        std::mt19937 rng { 0x5eed };
+        std::uniform_real_distribution<T> dist((T)-1, (T)1);
+        double max_error = 0.0;
+        for(int n = 0; n < num_frames; ++n)
+        {
+            for(auto& x : input)
+                x = dist(rng);
+
+            referenceModel->forward(input.data());
+            otherModel->forward(input.data());
+
+            const auto num_outputs = referenceModel->getOutSize() * referenceModel->getNumOutputFrames();
+            for(int i = 0; i < num_outputs; ++i)
+                max_error = std::max(max_error, (double)std::abs(referenceModel->getOutputs()[i] - otherModel->getOutputs()[i]));
+        }
+
+        return max_error;
+    }
+
+    /**
+     * Creates a neural network model from a json stream, after running some
+     * optimization passes over it (the default passes, unless a list of
+     * passes is given, see `optimizeJson()`).
+     *
+     * The optimized model is verified against the unoptimized model on
+     * random inputs: if its outputs differ by more than the tolerance, the
+     * unoptimized model is returned instead, and the report is marked as
+     * not verified.
+     */
+    template <typename T, typename MathsProvider = DefaultMathsProvider>
+    std::unique_ptr<Model<T>> parseOptimizedJson(const nlohmann::json& parent, OptimizationReport& report,
+        const double tolerance = default_optimization_tolerance,
+        const std::vector<OptimizationPass>& passes = getDefaultOptimizationPasses<T>(), const bool debug = false)
+    {
+        const auto optimized = optimizeJson<T>(parent, report, passes, debug);
+
+        report.max_error = compareModels<T, MathsProvider>(parent, optimized);
+        report.verified = report.max_error <= tolerance;
+        if(!report.verified)
+        {
+            debug_print("Optimized model doesn't match the unoptimized model (error: " + std::to_string(report.max_error) + ")!", debug);
+            return parseJson<T, MathsProvider>(parent, debug);
+        }
+
+        return parseJson<T, MathsProvider>(optimized, debug);
+    }
+} // namespace json_parser
+} // namespace RTNEURAL_NAMESPACE
@@ -0,0 +1,425 @@
+#pragma once
+
+#include "../conv1d/conv1d.h"
+
+namespace RTNEURAL_NAMESPACE
+{
+/**
+ * Dynamic implementation of a temporal convolutional network (TCN)
+ * residual block, as used by MicroTCN-style models:
+ * ```
+ * y = prelu(batchnorm(conv(x))) + residual(x)
+ * ```
+ * where `conv` is a dilated causal convolution, and `residual` is a
+ * (possibly grouped) 1x1 convolution, without a bias.
+ *
+ * The block is computed as a single fused layer: the batch norm is folded
+ * into the convolution weights and bias, and the PReLU and residual are
+ * applied in place, to the convolution outputs.
+ */
+template <typename T>
+class TCNBlock final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a TCN block for the given dimensions.
+     *
+     * @param in_size: the input size for the layer
+     * @param out_size: the output size for the layer
+     * @param kernel_size: the size of the convolution kernel
+     * @param dilation: the dilation rate of the convolution
+     * @param residual_groups: the number of groups in the residual 1x1 convolution
+     */
+    TCNBlock(int in_size, int out_size, int kernel_size, int dilation, int residual_groups = 1)
+        : Layer<T>(in_size, out_size)
+        , conv(in_size, out_size, kernel_size, dilation)
+        , residual_groups(residual_groups)
+        , filters_per_group(in_size / residual_groups)
+        , channels_per_group(out_size / residual_groups)
+    {
+        convWeights.resize((size_t)out_size, std::vector<std::vector<T>>((size_t)in_size, std::vector<T>((size_t)kernel_size, (T)0)));
+        convBias.resize((size_t)out_size, (T)0);
+        bnScale.resize((size_t)out_size, (T)1);
+        bnShift.resize((size_t)out_size, (T)0);
+        alpha.resize((size_t)out_size, (T)0);
+        resWeights.resize((size_t)(out_size * filters_per_group), (T)0);
+    }
+
+    TCNBlock(std::initializer_list<int> sizes)
+        : TCNBlock<T>(*sizes.begin(), *(sizes.begin() + 1), *(sizes.begin() + 2),
+            *(sizes.begin() + 3), *(sizes.begin() + 4))
+    {
+    }
+
+    TCNBlock(const TCNBlock& other) = default;
+    TCNBlock& operator=(const TCNBlock& other) = default;
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset() override
+    {
+        conv.reset();
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "tcn_block"; }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* h) noexcept override
+    {
+        conv.forward(input, h);
+
+        for(int g = 0; g < residual_groups; ++g)
+        {
+            const auto* res_ins = input + g * filters_per_group;
+            for(int i = g * channels_per_group; i < (g + 1) * channels_per_group; ++i)
+            {
+                const auto* res_weights = resWeights.data() + i * filters_per_group;
+
+                T res = (T)0;
+                for(int j = 0; j < filters_per_group; ++j)
+                    res += res_weights[j] * res_ins[j];
+
+                h[i] = (h[i] > (T)0 ? h[i] : alpha[(size_t)i] * h[i]) + res;
+            }
+        }
+    }
+
+    /**
+     * Sets the convolution weights.
+     *
+     * The weights vector must have size weights[out_size][in_size][kernel_size]
+     */
+    void setWeights(const std::vector<std::vector<std::vector<T>>>& weights)
+    {
+        convWeights = weights;
+        updateConvWeights();
+    }
+
+    /**
+     * Sets the convolution biases.
+     *
+     * The bias vector must have size bias[out_size]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        std::copy(biasVals.begin(), biasVals.end(), convBias.begin());
+        updateConvWeights();
+    }
+
+    /**
+     * Sets the inference-mode batch norm parameters,
+     * which are folded into the convolution weights and bias.
+     */
+    void setBatchNorm(const std::vector<T>& gamma, const std::vector<T>& beta,
+        const std::vector<T>& runningMean, const std::vector<T>& runningVariance, T epsilon)
+    {
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+        {
+            bnScale[(size_t)i] = gamma[(size_t)i] / std::sqrt(runningVariance[(size_t)i] + epsilon);
+            bnShift[(size_t)i] = beta[(size_t)i] - runningMean[(size_t)i] * bnScale[(size_t)i];
+        }
+        updateConvWeights();
+    }
+
+    /** Sets the PReLU alpha values (either one for each output, or a single shared value). */
+    void setAlphaVals(const std::vector<T>& alphaVals)
+    {
+        if(alphaVals.size() == 1)
+            std::fill(alpha.begin(), alpha.end(), alphaVals[0]);
+        else
+            std::copy(alphaVals.begin(), alphaVals.end(), alpha.begin());
+    }
+
+    /**
+     * Sets the residual 1x1 convolution weights.
+     *
+     * The weights vector must have size weights[out_size][in_size / residual_groups]
+     */
+    void setResidualWeights(const std::vector<std::vector<T>>& weights)
+    {
+        for(int i = 0; i < Layer<T>::out_size; ++i)
+            std::copy(weights[(size_t)i].begin(), weights[(size_t)i].end(), resWeights.begin() + i * filters_per_group);
+    }
+
+    /** Returns the size of the convolution kernel. */
+    RTNEURAL_REALTIME int getKernelSize() const noexcept { return conv.getKernelSize(); }
+
+    /** Returns the convolution dilation rate. */
+    RTNEURAL_REALTIME int getDilationRate() const noexcept { return conv.getDilationRate(); }
+
+    /** Returns the number of groups in the residual convolution. */
+    int getResidualGroups() const noexcept { return residual_groups; }
+
+private:
+    /** Folds the batch norm into the convolution weights and bias. */
+    void updateConvWeights()
+    {
+        auto foldedWeights = convWeights;
+        std::vector<T> foldedBias((size_t)Layer<T>::out_size);
+        for(size_t i = 0; i < foldedWeights.size(); ++i)
+        {
+            for(auto& kernel : foldedWeights[i])
+                for(auto& w : kernel)
+                    w *= bnScale[i];
+
+            foldedBias[i] = convBias[i] * bnScale[i] + bnShift[i];
+        }
+
+        conv.setWeights(foldedWeights);
+        conv.setBias(foldedBias);
+    }
+
+    Conv1D<T> conv;
+
+    const int residual_groups;
+    const int filters_per_group;
+    const int channels_per_group;
+
+    std::vector<std::vector<std::vector<T>>> convWeights;
+    std::vector<T> convBias;
+    std::vector<T> bnScale;
+    std::vector<T> bnShift;
+
+    std::vector<T> alpha;
+    std::vector<T> resWeights;
+};
+
+//====================================================
+/**
+ * Static implementation of a temporal convolutional network (TCN)
+ * residual block (see TCNBlock):
+ * ```
+ * y = prelu(batchnorm(conv(x))) + residual(x)
+ * ```
+ *
+ * The batch norm is folded into the convolution weights and bias, and
+ * the PReLU and residual are applied in place, to the convolution outputs,
+ * so `outs` refers to the outputs of the internal convolution.
+ *
+ * @param in_sizet: the input size for the layer
+ * @param out_sizet: the output size for the layer
+ * @param kernel_size: the size of the convolution kernel
+ * @param dilation_rate: the dilation rate of the convolution
+ * @param residual_groups: the number of groups in the residual 1x1 convolution
+ * @param dynamic_state: use dynamically allocated layer state
+ */
+template <typename T, int in_sizet, int out_sizet, int kernel_size, int dilation_rate, int residual_groups = 1, bool dynamic_state = false>
+class TCNBlockT
+{
+    Conv1DT<T, in_sizet, out_sizet, kernel_size, dilation_rate, 1, dynamic_state> conv;
+
+public:
+    static constexpr auto in_size = in_sizet;
+    static constexpr auto out_size = out_sizet;
+    static constexpr auto filters_per_group = in_size / residual_groups;
+    static constexpr auto channels_per_group = out_size / residual_groups;
+
+    TCNBlockT()
+        : outs(conv.outs)
+    {
+        convWeights.resize((size_t)out_size, std::vector<std::vector<T>>((size_t)in_size, std::vector<T>((size_t)kernel_size, (T)0)));
+        convBias.resize((size_t)out_size, (T)0);
+        bnScale.resize((size_t)out_size, (T)1);
+        bnShift.resize((size_t)out_size, (T)0);
+
+        setAlphaVals({ (T)0 });
+        setResidualWeights(std::vector<std::vector<T>>((size_t)out_size, std::vector<T>((size_t)filters_per_group, (T)0)));
+    }
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "tcn_block"; }
+
+    /** Returns false since the TCN block is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset()
+    {
+        conv.reset();
+    }
+
+    /** Performs forward propagation for this layer. */
+    template <typename Inputs>
+    RTNEURAL_REALTIME inline void forward(const Inputs& ins) noexcept
+    {
+        conv.forward(ins);
+
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_in_size; ++i)
+            ins[i].store_aligned(ins_flat + i * v_size);
+
+        T res alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_out_size * v_size] {};
+        computeResidual(ins_flat, res);
+
+        for(int i = 0; i < v_out_size; ++i)
+        {
+            const auto x = conv.outs[i];
+            conv.outs[i] = xsimd::max(x, v_type((T)0)) + alpha[i] * xsimd::min(x, v_type((T)0))
+                + xsimd::load_aligned(res + i * v_size);
+        }
+#elif RTNEURAL_USE_EIGEN
+        conv.outs = conv.outs.cwiseMax((T)0) + alpha.cwiseProduct(conv.outs.cwiseMin((T)0));
+        for(int g = 0; g < residual_groups; ++g)
+        {
+            conv.outs.template middleRows<channels_per_group>(g * channels_per_group).noalias()
+                += res_weights.template middleRows<channels_per_group>(g * channels_per_group)
+                * ins.template middleRows<filters_per_group>(g * filters_per_group);
+        }
+#else
+        T res alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+        computeResidual(ins, res);
+
+        for(int i = 0; i < out_size; ++i)
+            conv.outs[i] = (conv.outs[i] > (T)0 ? conv.outs[i] : alpha[i] * conv.outs[i]) + res[i];
+#endif
+    }
+
+    /**
+     * Sets the convolution weights.
+     *
+     * The weights vector must have size weights[out_size][in_size][kernel_size]
+     */
+    void setWeights(const std::vector<std::vector<std::vector<T>>>& weights)
+    {
+        convWeights = weights;
+        updateConvWeights();
+    }
+
+    /**
+     * Sets the convolution biases.
+     *
+     * The bias vector must have size bias[out_size]
+     */
+    void setBias(const std::vector<T>& biasVals)
+    {
+        std::copy(biasVals.begin(), biasVals.end(), convBias.begin());
+        updateConvWeights();
+    }
+
+    /**
+     * Sets the inference-mode batch norm parameters,
+     * which are folded into the convolution weights and bias.
+     */
+    void setBatchNorm(const std::vector<T>& gamma, const std::vector<T>& beta,
+        const std::vector<T>& runningMean, const std::vector<T>& runningVariance, T epsilon)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            bnScale[(size_t)i] = gamma[(size_t)i] / std::sqrt(runningVariance[(size_t)i] + epsilon);
+            bnShift[(size_t)i] = beta[(size_t)i] - runningMean[(size_t)i] * bnScale[(size_t)i];
+        }
+        updateConvWeights();
+    }
+
+    /** Sets the PReLU alpha values (either one for each output, or a single shared value). */
+    void setAlphaVals(const std::vector<T>& alphaVals)
+    {
+        T alpha_flat alignas(RTNEURAL_DEFAULT_ALIGNMENT)[padded_out_size] {};
+        for(int i = 0; i < out_size; ++i)
+            alpha_flat[i] = alphaVals.size() == 1 ? alphaVals[0] : alphaVals[(size_t)i];
+
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_out_size; ++i)
+            alpha[i] = xsimd::load_aligned(alpha_flat + i * v_size);
+#elif RTNEURAL_USE_EIGEN
+        std::copy(alpha_flat, alpha_flat + out_size, alpha.data());
+#else
+        std::copy(alpha_flat, alpha_flat + out_size, alpha);
+#endif
+    }
+
+    /**
+     * Sets the residual 1x1 convolution weights.
+     *
+     * The weights vector must have size weights[out_size][in_size / residual_groups]
+     */
+    void setResidualWeights(const std::vector<std::vector<T>>& weights)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            for(int j = 0; j < filters_per_group; ++j)
+#if RTNEURAL_USE_EIGEN
+                res_weights(i, j) = weights[(size_t)i][(size_t)j];
+#else
+                res_weights[i][j] = weights[(size_t)i][(size_t)j];
+#endif
+        }
+    }
+
+    /** Returns the size of the convolution kernel. */
+    RTNEURAL_REALTIME int getKernelSize() const noexcept { return kernel_size; }
+
+    /** Returns the convolution dilation rate. */
+    RTNEURAL_REALTIME int getDilationRate() const noexcept { return dilation_rate; }
+
+    /** Returns the number of groups in the residual convolution. */
+    int getResidualGroups() const noexcept { return residual_groups; }
+
+    /** Reference to the internal layer outputs. */
+    decltype(conv.outs)& outs;
+
+private:
+    /** Folds the batch norm into the convolution weights and bias. */
+    void updateConvWeights()
+    {
+        auto foldedWeights = convWeights;
+        std::vector<T> foldedBias((size_t)out_size);
+        for(size_t i = 0; i < foldedWeights.size(); ++i)
+        {
+            for(auto& kernel : foldedWeights[i])
+                for(auto& w : kernel)
+                    w *= bnScale[i];
+
+            foldedBias[i] = convBias[i] * bnScale[i] + bnShift[i];
+        }
+
+        conv.setWeights(foldedWeights);
+        conv.setBias(foldedBias);
+    }
+
+#if !RTNEURAL_USE_EIGEN
+    /** Computes the (grouped) residual 1x1 convolution. */
+    inline void computeResidual(const T* ins, T* res) const noexcept
+    {
+        for(int g = 0; g < residual_groups; ++g)
+        {
+            const auto* res_ins = ins + g * filters_per_group;
+            for(int i = g * channels_per_group; i < (g + 1) * channels_per_group; ++i)
+            {
+                T sum = (T)0;
+                for(int j = 0; j < filters_per_group; ++j)
+                    sum += res_weights[i][j] * res_ins[j];
+                res[i] = sum;
+            }
+        }
+    }
+#endif
+
+    std::vector<std::vector<std::vector<T>>> convWeights;
+    std::vector<T> convBias;
+    std::vector<T> bnScale;
+    std::vector<T> bnShift;
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = (int)v_type::size;
+    static constexpr auto v_in_size = ceil_div(in_size, v_size);
+    static constexpr auto v_out_size = ceil_div(out_size, v_size);
+    static constexpr auto padded_out_size = v_out_size * v_size;
+
+    v_type alpha[v_out_size];
+    T res_weights[out_size][filters_per_group];
+    T ins_flat alignas(RTNEURAL_DEFAULT_ALIGNMENT)[v_in_size * v_size] {};
+#elif RTNEURAL_USE_EIGEN
+    static constexpr auto padded_out_size = out_size;
+
+    Eigen::Matrix<T, out_size, 1> alpha;
+    Eigen::Matrix<T, out_size, filters_per_group> res_weights;
+#else
+    static constexpr auto padded_out_size = out_size;
+
+    T alpha alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+    T res_weights[out_size][filters_per_group];
+#endif
+};
+} // namespace RTNEURAL_NAMESPACE
@@ -68,6 +68,21 @@ namespace torch_helpers
             for(auto& vec : vec2d)
                 std::swap_ranges(vec.begin(), vec.begin() + size, vec.begin() + size);
         }
+
+        /** Loads the weights of a 1x1 Conv1D layer (or a Linear layer) as a 2D matrix. */
+        template <typename T>
+        std::vector<std::vector<T>> load1x1Weights(const nlohmann::json& weights)
+        {
+            if(!weights.at(0).at(0).is_array())
+                return weights.get<std::vector<std::vector<T>>>();
+
+            const std::vector<std::vector<std::vector<T>>> conv_weights = weights;
+            std::vector<std::vector<T>> matrix(conv_weights.size());
+            for(size_t i = 0; i < conv_weights.size(); ++i)
+                for(const auto& kernel : conv_weights[i])
+                    matrix[i].push_back(kernel.at(0));
+            return matrix;
+        }
     }
 
     /** Loads a Dense layer from a JSON object containing a PyTorch state_dict. */
@@ -92,7 +107,38 @@ namespace torch_helpers
         }
     }
 
-    /** Loads a ConvTranspose1D layer from a JSON object containing a PyTorch state_dict. */
+    /**
+     * Loads a LowRankDense layer from a JSON object containing a PyTorch state_dict,
+     * where the layer weights are stored as factors: weight = weight_u * weight_v,
+     * with weight_u[out_size][rank] and weight_v[rank][in_size].
+     */
+    template <typename T, typename DenseType>
+    void loadLowRankDense(const nlohmann::json& modelJson, const std::string& layerPrefix, DenseType& dense, bool hasBias = true)
+    {
+        const std::vector<std::vector<T>> weight_u = modelJson.at(layerPrefix + "weight_u");
+        const std::vector<std::vector<T>> weight_v = modelJson.at(layerPrefix + "weight_v");
+        dense.setFactors(weight_u, weight_v);
+
+        RTNEURAL_IF_CONSTEXPR(DenseType::dense_has_bias)
+        {
+            if(hasBias)
+            {
+                const std::vector<T> dense_bias = modelJson.at(layerPrefix + "bias");
+                dense.setBias(dense_bias.data());
+            }
+            else
+            {
+                const std::vector<T> dense_bias((size_t)dense.out_size, (T)0);
+                dense.setBias(dense_bias.data());
+            }
+        }
+    }
+
+    /**
+     * Loads a ConvTranspose1D layer from a JSON object containing a PyTorch state_dict.
+     * The layer can be a ConvTranspose1D (or ConvTranspose1DT), or a Conv1D that
+     * is run on the zero-stuffed input.
+     */
     template <typename T, typename Conv1DType>
     void loadConvTranspose1D(const nlohmann::json& modelJson, const std::string& layerPrefix, Conv1DType& conv, bool hasBias = true)
     {
@@ -132,6 +178,184 @@ namespace torch_helpers
         }
     }
 
+    /**
+     * Loads a TCNBlock (or TCNBlockT) layer from a JSON object containing a PyTorch state_dict,
+     * for a block with the sub-modules `conv1` (Conv1d), `bn` (BatchNorm1d), `relu` (PReLU),
+     * and `res` (a 1x1 Conv1d without bias). The convolution bias is optional, and if the
+     * block has no `res` weights, an identity residual connection is used instead.
+     */
+    template <typename T, typename TCNBlockType>
+    void loadTCNBlock(const nlohmann::json& modelJson, const std::string& layerPrefix, TCNBlockType& block, T epsilon = (T)1.0e-5)
+    {
+        std::vector<std::vector<std::vector<T>>> conv_weights = modelJson.at(layerPrefix + "conv1.weight");
+        detail::reverseKernels(conv_weights);
+        block.setWeights(conv_weights);
+
+        const auto out_size = conv_weights.size();
+        if(modelJson.contains(layerPrefix + "conv1.bias"))
+            block.setBias(modelJson.at(layerPrefix + "conv1.bias").template get<std::vector<T>>());
+        else
+            block.setBias(std::vector<T>(out_size, (T)0));
+
+        const std::vector<T> gamma = modelJson.at(layerPrefix + "bn.weight");
+        const std::vector<T> beta = modelJson.at(layerPrefix + "bn.bias");
+        const std::vector<T> runningMean = modelJson.at(layerPrefix + "bn.running_mean");
+        const std::vector<T> runningVariance = modelJson.at(layerPrefix + "bn.running_var");
+        epsilon = modelJson.value(layerPrefix + "bn.eps", epsilon);
+        block.setBatchNorm(gamma, beta, runningMean, runningVariance, epsilon);
+
+        const std::vector<T> alphaVals = modelJson.at(layerPrefix + "relu.weight");
+        block.setAlphaVals(alphaVals);
+
+        const auto filters_per_group = (size_t)(conv_weights[0].size() / (size_t)block.getResidualGroups());
+        std::vector<std::vector<T>> res_weights(out_size, std::vector<T>(filters_per_group, (T)0));
+        if(modelJson.contains(layerPrefix + "res.weight"))
+        {
+            const std::vector<std::vector<std::vector<T>>> res_conv_weights = modelJson.at(layerPrefix + "res.weight");
+            for(size_t i = 0; i < out_size; ++i)
+                for(size_t j = 0; j < filters_per_group; ++j)
+                    res_weights[i][j] = res_conv_weights[i][j][0];
+        }
+        else
+        {
+            for(size_t i = 0; i < out_size; ++i)
+                res_weights[i][i % filters_per_group] = (T)1;
+        }
+        block.setResidualWeights(res_weights);
+    }
+
+    /**
+     * Loads a WaveNet (or WaveNetT) layer with a single layer array from a JSON object
+     * containing a PyTorch state_dict, with the sub-modules `input` (a 1x1 Conv1d), and for each layer `layers.<i>.conv`
+     * (the dilated Conv1d), `layers.<i>.mixin` (an optional 1x1 Conv1d without bias, from
+     * the stack input), `layers.<i>.residual` and `layers.<i>.skip` (1x1 Conv1d's), followed
+     * by `output` (a 1x1 Conv1d). The 1x1 convolutions may also be stored as Linear layers,
+     * the biases are optional, and if a layer has no `skip` weights, its gated activations
+     * are added straight to the skip outputs.
+     */
+    template <typename T, typename WaveNetType>
+    void loadWaveNet(const nlohmann::json& modelJson, const std::string& layerPrefix, WaveNetType& wavenet)
+    {
+        auto& layerArray = wavenet.getLayerArray(0);
+        const auto channels = (size_t)layerArray.getChannels();
+        const auto skip_channels = (size_t)layerArray.getSkipChannels();
+
+        const auto loadBias = [&modelJson](const std::string& name, size_t size)
+        {
+            if(modelJson.contains(name + "bias"))
+                return modelJson.at(name + "bias").template get<std::vector<T>>();
+            return std::vector<T>(size, (T)0);
+        };
+
+        layerArray.setInputWeights(detail::load1x1Weights<T>(modelJson.at(layerPrefix + "input.weight")), loadBias(layerPrefix + "input.", channels));
+
+        for(int l = 0; l < layerArray.getNumLayers(); ++l)
+        {
+            const auto prefix = layerPrefix + "layers." + std::to_string(l) + ".";
+
+            std::vector<std::vector<std::vector<T>>> conv_weights = modelJson.at(prefix + "conv.weight");
+            detail::reverseKernels(conv_weights);
+            layerArray.setConvWeights(l, conv_weights, loadBias(prefix + "conv.", 2 * channels));
+
+            if(modelJson.contains(prefix + "mixin.weight"))
+                layerArray.setMixinWeights(l, detail::load1x1Weights<T>(modelJson.at(prefix + "mixin.weight")));
+
+            if(modelJson.contains(prefix + "residual.weight"))
+                layerArray.setResidualWeights(l, detail::load1x1Weights<T>(modelJson.at(prefix + "residual.weight")), loadBias(prefix + "residual.", channels));
+
+            if(modelJson.contains(prefix + "skip.weight"))
+            {
+                layerArray.setSkipWeights(l, detail::load1x1Weights<T>(modelJson.at(prefix + "skip.weight")), loadBias(prefix + "skip.", skip_channels));
+            }
+            else
+            {
+                std::vector<std::vector<T>> skip_weights(skip_channels, std::vector<T>(channels, (T)0));
+                for(size_t i = 0; i < std::min(channels, skip_channels); ++i)
+                    skip_weights[i][i] = (T)1;
+                layerArray.setSkipWeights(l, skip_weights, std::vector<T>(skip_channels, (T)0));
+            }
+        }
+
+        layerArray.setOutputWeights(detail::load1x1Weights<T>(modelJson.at(layerPrefix + "output.weight")),
+            loadBias(layerPrefix + "output.", (size_t)layerArray.getOutputSize()));
+    }
+
+    /** Loads a LayerNorm (or LayerNormT) layer from a JSON object containing a PyTorch state_dict. */
+    template <typename T, typename LayerNormType>
+    void loadLayerNorm(const nlohmann::json& modelJson, const std::string& layerPrefix, LayerNormType& norm, T epsilon = (T)1.0e-5)
+    {
+        norm.setGamma(modelJson.at(layerPrefix + "weight").template get<std::vector<T>>());
+        if(modelJson.contains(layerPrefix + "bias"))
+            norm.setBeta(modelJson.at(layerPrefix + "bias").template get<std::vector<T>>());
+        norm.setEpsilon(epsilon);
+    }
+
+    /** Loads an RMSNorm (or RMSNormT) layer from a JSON object containing a PyTorch state_dict. */
+    template <typename T, typename RMSNormType>
+    void loadRMSNorm(const nlohmann::json& modelJson, const std::string& layerPrefix, RMSNormType& norm, T epsilon = (T)1.0e-6)
+    {
+        norm.setGamma(modelJson.at(layerPrefix + "weight").template get<std::vector<T>>());
+        norm.setEpsilon(epsilon);
+    }
+
+    /**
+     * Loads a MultiHeadAttention (or MultiHeadAttentionT) layer from a JSON object containing
+     * the state_dict of a PyTorch MultiheadAttention module, with the same embedding size
+     * for the queries, keys, and values. The biases are optional.
+     */
+    template <typename T, typename AttentionType>
+    void loadMultiHeadAttention(const nlohmann::json& modelJson, const std::string& layerPrefix, AttentionType& attention)
+    {
+        const std::vector<std::vector<T>> in_weights = modelJson.at(layerPrefix + "in_proj_weight");
+        const std::vector<std::vector<T>> out_weights = modelJson.at(layerPrefix + "out_proj.weight");
+
+        const auto loadBias = [&modelJson](const std::string& name, size_t size)
+        {
+            if(modelJson.contains(name))
+                return modelJson.at(name).template get<std::vector<T>>();
+            return std::vector<T>(size, (T)0);
+        };
+
+        attention.setInputWeights(in_weights, loadBias(layerPrefix + "in_proj_bias", in_weights.size()));
+        attention.setOutputWeights(out_weights, loadBias(layerPrefix + "out_proj.bias", out_weights.size()));
+    }
+
+    /**
+     * Loads a TransformerBlock (or TransformerBlockT) layer from a JSON object containing the
+     * state_dict of a PyTorch TransformerEncoderLayer (with the ReLU activation), i.e. with
+     * the sub-modules `self_attn` (MultiheadAttention), `linear1` and `linear2` (Linear), and
+     * `norm1` and `norm2` (LayerNorm or RMSNorm). Whether the norms are applied first is
+     * set by the block. The biases are optional.
+     */
+    template <typename T, typename TransformerBlockType>
+    void loadTransformerBlock(const nlohmann::json& modelJson, const std::string& layerPrefix, TransformerBlockType& block, T epsilon = (T)1.0e-5)
+    {
+        const std::vector<std::vector<T>> in_weights = modelJson.at(layerPrefix + "self_attn.in_proj_weight");
+        const std::vector<std::vector<T>> out_weights = modelJson.at(layerPrefix + "self_attn.out_proj.weight");
+        const std::vector<std::vector<T>> ff1_weights = modelJson.at(layerPrefix + "linear1.weight");
+        const std::vector<std::vector<T>> ff2_weights = modelJson.at(layerPrefix + "linear2.weight");
+
+        const auto loadBias = [&modelJson](const std::string& name, size_t size)
+        {
+            if(modelJson.contains(name))
+                return modelJson.at(name).template get<std::vector<T>>();
+            return std::vector<T>(size, (T)0);
+        };
+
+        block.setAttentionInputWeights(in_weights, loadBias(layerPrefix + "self_attn.in_proj_bias", in_weights.size()));
+        block.setAttentionOutputWeights(out_weights, loadBias(layerPrefix + "self_attn.out_proj.bias", out_weights.size()));
+        block.setFeedForwardWeights(ff1_weights, loadBias(layerPrefix + "linear1.bias", ff1_weights.size()),
+            ff2_weights, loadBias(layerPrefix + "linear2.bias", ff2_weights.size()));
+
+        for(int i = 0; i < 2; ++i)
+        {
+            const auto norm_prefix = layerPrefix + "norm" + std::to_string(i + 1) + ".";
+            const std::vector<T> gamma = modelJson.at(norm_prefix + "weight");
+            block.setNormWeights(i, gamma, loadBias(norm_prefix + "bias", gamma.size()));
+        }
+        block.setNormEpsilon(epsilon);
+    }
+
     /**
      * Loads a GRU layer from a JSON object containing a PyTorch state_dict.
      * If your PyTorch GRU has num_layers > 1, you must call this method once
@@ -148,10 +372,24 @@ namespace torch_helpers
         detail::swap_rz(wVals, gru.out_size);
         gru.setWVals(wVals);
 
-        const std::vector<std::vector<T>> gru_hh_weights = modelJson.at(layerPrefix + "weight_hh_l" + std::to_string(layer_index));
-        auto uVals = detail::transpose(gru_hh_weights);
-        detail::swap_rz(uVals, gru.out_size);
-        gru.setUVals(uVals);
+        const auto hh_key = layerPrefix + "weight_hh_l" + std::to_string(layer_index);
+        if(modelJson.contains(hh_key + "_u"))
+        {
+            // low-rank recurrent weights: weight_hh = weight_hh_u * weight_hh_v,
+            // so the (transposed) recurrent weights are weight_hh_v^T * weight_hh_u^T
+            const std::vector<std::vector<T>> gru_hh_u = modelJson.at(hh_key + "_u");
+            const std::vector<std::vector<T>> gru_hh_v = modelJson.at(hh_key + "_v");
+            auto uRight = detail::transpose(gru_hh_u);
+            detail::swap_rz(uRight, gru.out_size);
+            json_parser::setRecurrentFactors<T>(gru, detail::transpose(gru_hh_v), uRight);
+        }
+        else
+        {
+            const std::vector<std::vector<T>> gru_hh_weights = modelJson.at(hh_key);
+            auto uVals = detail::transpose(gru_hh_weights);
+            detail::swap_rz(uVals, gru.out_size);
+            gru.setUVals(uVals);
+        }
 
         // PyTorch stores the GRU bias pretty much the same as TensorFlow as well,
         // just in two separate vectors. And again, we need to swap the "r" and "z" parts.
@@ -184,8 +422,19 @@ namespace torch_helpers
         const std::vector<std::vector<T>> lstm_weights_ih = modelJson.at(layerPrefix + "weight_ih_l" + std::to_string(layer_index));
         lstm.setWVals(detail::transpose(lstm_weights_ih));
 
-        const std::vector<std::vector<T>> lstm_weights_hh = modelJson.at(layerPrefix + "weight_hh_l" + std::to_string(layer_index));
-        lstm.setUVals(detail::transpose(lstm_weights_hh));
+        const auto hh_key = layerPrefix + "weight_hh_l" + std::to_string(layer_index);
+        if(modelJson.contains(hh_key + "_u"))
+        {
+            // low-rank recurrent weights: weight_hh = weight_hh_u * weight_hh_v
+            const std::vector<std::vector<T>> lstm_hh_u = modelJson.at(hh_key + "_u");
+            const std::vector<std::vector<T>> lstm_hh_v = modelJson.at(hh_key + "_v");
+            json_parser::setRecurrentFactors<T>(lstm, detail::transpose(lstm_hh_v), detail::transpose(lstm_hh_u));
+        }
+        else
+        {
+            const std::vector<std::vector<T>> lstm_weights_hh = modelJson.at(hh_key);
+            lstm.setUVals(detail::transpose(lstm_weights_hh));
+        }
 
         if(hasBias)
         {
@@ -0,0 +1,885 @@
+#pragma once
+
+#include "../Layer.h"
+#include "../common.h"
+#include "../config.h"
+#include <algorithm>
+#include <array>
+#include <utility>
+#include <vector>
+
+#if RTNEURAL_USE_EIGEN
+#include "../maths/maths_eigen.h"
+#elif RTNEURAL_USE_XSIMD
+#include "../maths/maths_xsimd.h"
+#else
+#include "../maths/maths_stl.h"
+#endif
+
+namespace RTNEURAL_NAMESPACE
+{
+#ifndef DOXYGEN
+namespace wavenet_detail
+{
+    /** Computes g = tanh(z[:channels]) * sigmoid(z[channels:]), where z holds the two halves one after the other. */
+    template <typename T, typename MathsProvider>
+    inline void gatedActivation(const T* z, T* g, int channels_padded) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using v_type = xsimd::simd_type<T>;
+        for(int i = 0; i < channels_padded; i += (int)v_type::size)
+        {
+            const auto z_tanh = xsimd::load_aligned(z + i);
+            const auto z_sigmoid = xsimd::load_aligned(z + channels_padded + i);
+            xsimd::store_aligned(g + i, MathsProvider::tanh(z_tanh) * MathsProvider::sigmoid(z_sigmoid));
+        }
+#elif RTNEURAL_USE_EIGEN
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        const auto z_tanh = Eigen::Map<const Vector, RTNeuralEigenAlignment>(z, channels_padded);
+        const auto z_sigmoid = Eigen::Map<const Vector, RTNeuralEigenAlignment>(z + channels_padded, channels_padded);
+        Eigen::Map<Vector, RTNeuralEigenAlignment>(g, channels_padded).array() = MathsProvider::tanh(z_tanh) * MathsProvider::sigmoid(z_sigmoid);
+#else
+        for(int i = 0; i < channels_padded; ++i)
+            g[i] = MathsProvider::tanh(z[i]) * MathsProvider::sigmoid(z[channels_padded + i]);
+#endif
+    }
+
+    /** Computes g = tanh(z). */
+    template <typename T, typename MathsProvider>
+    inline void tanhActivation(const T* z, T* g, int channels_padded) noexcept
+    {
+#if RTNEURAL_USE_XSIMD
+        using v_type = xsimd::simd_type<T>;
+        for(int i = 0; i < channels_padded; i += (int)v_type::size)
+            xsimd::store_aligned(g + i, MathsProvider::tanh(xsimd::load_aligned(z + i)));
+#elif RTNEURAL_USE_EIGEN
+        using Vector = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+        Eigen::Map<Vector, RTNeuralEigenAlignment>(g, channels_padded).array() = MathsProvider::tanh(Eigen::Map<const Vector, RTNeuralEigenAlignment>(z, channels_padded));
+#else
+        for(int i = 0; i < channels_padded; ++i)
+            g[i] = MathsProvider::tanh(z[i]);
+#endif
+    }
+
+    /** Returns the number of dilated convolution outputs of a layer, padded. */
+    template <typename T>
+    constexpr int gatesSize(int channels, bool gated) noexcept
+    {
+        return (gated ? 2 : 1) * padded_size<T>(channels);
+    }
+
+    /** Returns the number of packed weights used by each layer of a layer array. */
+    template <typename T>
+    constexpr int layerWeightsSize(int condition_size, int channels, int skip_channels, int kernel_size, bool gated) noexcept
+    {
+        return (kernel_size * channels + condition_size + 1) * gatesSize<T>(channels, gated) // convolution, mixin, and bias
+            + (channels + 1) * padded_size<T>(skip_channels) // skip projection and bias
+            + (channels + 1) * padded_size<T>(channels); // residual projection and bias
+    }
+
+    /** Returns the number of packed weights used by a layer array. */
+    template <typename T>
+    constexpr int weightsSize(int num_inputs, int condition_size, int num_outputs, int channels, int skip_channels,
+        int kernel_size, int num_layers, bool gated) noexcept
+    {
+        return (num_inputs + 1) * padded_size<T>(channels)
+            + num_layers * layerWeightsSize<T>(condition_size, channels, skip_channels, kernel_size, gated)
+            + (skip_channels + 1) * padded_size<T>(num_outputs);
+    }
+
+    /** Returns the state size of a layer array, given the sum of the dilation rates of its layers. */
+    template <typename T>
+    constexpr int stateSize(int channels, int kernel_size, int num_layers, int dilations_sum) noexcept
+    {
+        return ((kernel_size - 1) * dilations_sum + num_layers) * padded_size<T>(channels);
+    }
+
+    /** Returns the scratch size of a layer array. */
+    template <typename T>
+    constexpr int scratchSize(int num_outputs, int channels, int skip_channels, bool gated) noexcept
+    {
+        return gatesSize<T>(channels, gated) + 2 * padded_size<T>(channels) + 2 * padded_size<T>(skip_channels) + padded_size<T>(num_outputs);
+    }
+
+    template <int... values>
+    constexpr int sum() noexcept
+    {
+        int result = 0;
+        for(auto x : { 0, values... })
+            result += x;
+        return result;
+    }
+} // namespace wavenet_detail
+#endif // DOXYGEN
+
+/**
+ * One layer array of a WaveNet layer, shared by the WaveNet and
+ * WaveNetT layers. For an input x, a condition input c (the input
+ * of the WaveNet layer), and the outputs of the previous layer
+ * array (if any), the layer array computes:
+ * ```
+ * h = input(x)
+ * skip = previous outputs
+ * for each layer, with dilation d:
+ *     z = conv_d(h) + mixin(c)
+ *     g = tanh(z[:channels]) * sigmoid(z[channels:]) (or tanh(z), for un-gated layers)
+ *     skip += skip_proj(g)
+ *     h = h + residual_proj(g)
+ * y = output(skip)
+ * ```
+ * where `conv_d` is a dilated causal convolution (channels -> 2 * channels,
+ * or channels -> channels for un-gated layers), and `input`, `mixin` (without
+ * a bias), `skip_proj`, `residual_proj`, and `output` are 1x1 convolutions.
+ * The residual outputs of the last layer are only computed if they are used
+ * as the inputs of the next layer array.
+ *
+ * All of the weights are packed into one aligned array, in the order that
+ * they are used, with each matrix stored column-major, so that every
+ * projection is computed as a sequence of vector multiply-adds. The layer
+ * states are ring buffers, and each layer writes its residual output
+ * straight into the ring buffer of the next layer, so no intermediate
+ * buffers are needed at run-time. The weights, states, and scratch buffers
+ * are owned by the WaveNet layer, which hands each layer array its part
+ * of them.
+ */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class WaveNetStack
+{
+public:
+    /** The run-time data of one layer in the stack. */
+    struct LayerData
+    {
+        int dilation = 1;
+        int state_length = 1;
+        int state_pos = 0;
+        T* state = nullptr;
+        T* conv_weights = nullptr;
+        T* mixin_weights = nullptr;
+        T* conv_bias = nullptr;
+        T* skip_weights = nullptr;
+        T* skip_bias = nullptr;
+        T* residual_weights = nullptr;
+        T* residual_bias = nullptr;
+        bool has_mixin = false;
+        bool identity_skip = false;
+    };
+
+    /**
+     * The storage for a sequence of layer arrays. Each layer array takes
+     * its part of the storage, and moves the pointers past it.
+     */
+    struct Storage
+    {
+        LayerData* layers;
+        T* weights;
+        T* state;
+        T* scratch;
+    };
+
+    /**
+     * Constructs a layer array for the given dimensions.
+     *
+     * @param num_inputs: the input size for the layer array
+     * @param condition_size: the condition input size for the layer array
+     * @param num_outputs: the output size for the layer array
+     * @param channels: the number of residual channels
+     * @param skip_channels: the number of skip channels
+     * @param kernel_size: the size of the dilated convolution kernels
+     * @param dilations: the dilation rate of each layer
+     * @param num_layers: the number of layers
+     * @param gated: true if the layers have gated activations, or false for tanh activations
+     * @param residual_outputs: true if the residual outputs of the last layer are used
+     * @param storage: the storage for the layer array
+     */
+    WaveNetStack(int num_inputs, int condition_size, int num_outputs, int channels, int skip_channels, int kernel_size,
+        const int* dilations, int num_layers, bool gated, bool residual_outputs, Storage& storage)
+        : num_inputs(num_inputs)
+        , condition_size(condition_size)
+        , num_outputs(num_outputs)
+        , channels(channels)
+        , skip_channels(skip_channels)
+        , kernel_size(kernel_size)
+        , num_layers(num_layers)
+        , gated(gated)
+        , residual_outputs(residual_outputs)
+        , channels_padded(padded_size<T>(channels))
+        , skip_padded(padded_size<T>(skip_channels))
+        , outputs_padded(padded_size<T>(num_outputs))
+        , gates_padded(wavenet_detail::gatesSize<T>(channels, gated))
+        , layers(storage.layers)
+    {
+        const auto allocate = [&storage](int size)
+        {
+            auto* data = storage.weights;
+            storage.weights += size;
+            return data;
+        };
+
+        input_weights = allocate(num_inputs * channels_padded);
+        input_bias = allocate(channels_padded);
+
+        for(int l = 0; l < num_layers; ++l)
+        {
+            auto& layer = layers[l];
+            layer.dilation = dilations[l];
+            layer.state_length = (kernel_size - 1) * layer.dilation + 1;
+            layer.state_pos = 0;
+            layer.state = storage.state;
+            storage.state += layer.state_length * channels_padded;
+
+            layer.conv_weights = allocate(kernel_size * channels * gates_padded);
+            layer.mixin_weights = allocate(condition_size * gates_padded);
+            layer.conv_bias = allocate(gates_padded);
+            layer.skip_weights = allocate(channels * skip_padded);
+            layer.skip_bias = allocate(skip_padded);
+            layer.residual_weights = allocate(channels * channels_padded);
+            layer.residual_bias = allocate(channels_padded);
+        }
+
+        output_weights = allocate(skip_channels * outputs_padded);
+        output_bias = allocate(outputs_padded);
+
+        z = storage.scratch;
+        g = z + gates_padded;
+        skip = g + channels_padded;
+        skip_bias = skip + skip_padded;
+        outputs = skip_bias + skip_padded;
+        residual = outputs + outputs_padded;
+
+        storage.layers += num_layers;
+        storage.scratch = residual + channels_padded;
+    }
+
+    /** Resets the layer states. */
+    RTNEURAL_REALTIME void resetState()
+    {
+        for(int l = 0; l < num_layers; ++l)
+        {
+            auto& layer = layers[l];
+            std::fill(layer.state, layer.state + layer.state_length * channels_padded, (T)0);
+            layer.state_pos = 0;
+        }
+    }
+
+    /**
+     * Computes the layer array outputs for one input frame. If this is not the first
+     * layer array, `head` must point to the outputs of the previous layer array,
+     * which are added to the skip outputs. Afterwards, the outputs of the layer array
+     * can be read from getOutputs(), and the residual outputs of its last layer (if
+     * they are used) from getResidualOutputs().
+     */
+    RTNEURAL_REALTIME inline void process(const T* x, const T* c, const T* head) noexcept
+    {
+
+        auto* h = layers[0].state + layers[0].state_pos * channels_padded;
+        std::copy(input_bias, input_bias + channels_padded, h);
+        vMatVecAccum(input_weights, x, h, num_inputs, channels_padded);
+
+        std::copy(skip_bias, skip_bias + skip_padded, skip);
+        if(head != nullptr)
+        {
+            for(int i = 0; i < skip_channels; ++i)
+                skip[i] += head[i];
+        }
+
+        for(int l = 0; l < num_layers; ++l)
+        {
+            auto& layer = layers[l];
+
+            std::copy(layer.conv_bias, layer.conv_bias + gates_padded, z);
+            for(int k = 0; k < kernel_size; ++k)
+            {
+                auto frame = layer.state_pos - k * layer.dilation;
+                if(frame < 0)
+                    frame += layer.state_length;
+                vMatVecAccum(layer.conv_weights + k * channels * gates_padded, layer.state + frame * channels_padded, z, channels, gates_padded);
+            }
+
+            if(layer.has_mixin)
+                vMatVecAccum(layer.mixin_weights, c, z, condition_size, gates_padded);
+
+            if(gated)
+                wavenet_detail::gatedActivation<T, MathsProvider>(z, g, channels_padded);
+            else
+                wavenet_detail::tanhActivation<T, MathsProvider>(z, g, channels_padded);
+
+            if(layer.identity_skip)
+            {
+                for(int i = 0; i < skip_padded; ++i)
+                    skip[i] += g[i];
+            }
+            else
+            {
+                vMatVecAccum(layer.skip_weights, g, skip, channels, skip_padded);
+            }
+
+            if(l + 1 < num_layers || residual_outputs)
+            {
+                // the residual output goes straight into the next layer's state
+                const auto* h_in = layer.state + layer.state_pos * channels_padded;
+                auto* h_out = residual;
+                if(l + 1 < num_layers)
+                    h_out = layers[l + 1].state + layers[l + 1].state_pos * channels_padded;
+
+                for(int i = 0; i < channels_padded; ++i)
+                    h_out[i] = h_in[i] + layer.residual_bias[i];
+                vMatVecAccum(layer.residual_weights, g, h_out, channels, channels_padded);
+            }
+
+            layer.state_pos = layer.state_pos + 1 == layer.state_length ? 0 : layer.state_pos + 1;
+        }
+
+        std::copy(output_bias, output_bias + outputs_padded, outputs);
+        vMatVecAccum(output_weights, skip, outputs, skip_channels, outputs_padded);
+    }
+
+    /** Returns the outputs computed by the last call to process(). */
+    const T* getOutputs() const noexcept { return outputs; }
+
+    /** Returns the residual outputs of the last layer, computed by the last call to process(). */
+    const T* getResidualOutputs() const noexcept { return residual; }
+
+    /**
+     * Sets the input 1x1 convolution weights.
+     *
+     * The weights vector must have size weights[channels][num_inputs],
+     * and the bias vector must have size bias[channels].
+     */
+    void setInputWeights(const std::vector<std::vector<T>>& inputWeights, const std::vector<T>& bias)
+    {
+        packMatrix(inputWeights, input_weights, channels_padded);
+        std::copy(bias.begin(), bias.end(), input_bias);
+    }
+
+    /**
+     * Sets the dilated convolution weights for a layer.
+     *
+     * The weights vector must have size weights[2 * channels][channels][kernel_size]
+     * (with the same kernel order as Conv1D::setWeights()), and the bias vector
+     * must have size bias[2 * channels]. The first `channels` outputs go through
+     * the tanh, and the others through the sigmoid. For un-gated layers, there are
+     * only `channels` outputs.
+     */
+    void setConvWeights(int layer, const std::vector<std::vector<std::vector<T>>>& convWeights, const std::vector<T>& bias)
+    {
+        auto* conv_weights = layers[layer].conv_weights;
+        for(int k = 0; k < kernel_size; ++k)
+        {
+            for(int j = 0; j < channels; ++j)
+            {
+                auto* col = conv_weights + (k * channels + j) * gates_padded;
+                for(int i = 0; i < numGates(); ++i)
+                    col[gateIndex(i)] = convWeights[(size_t)i][(size_t)j][(size_t)k];
+            }
+        }
+
+        auto* conv_bias = layers[layer].conv_bias;
+        for(int i = 0; i < numGates(); ++i)
+            conv_bias[gateIndex(i)] = bias[(size_t)i];
+    }
+
+    /**
+     * Sets the weights of the 1x1 convolution from the condition input to the
+     * dilated convolution outputs of a layer, which has no bias.
+     *
+     * The weights vector must have size weights[2 * channels][condition_size]
+     * (or weights[channels][condition_size] for un-gated layers).
+     */
+    void setMixinWeights(int layer, const std::vector<std::vector<T>>& mixinWeights)
+    {
+        auto& l = layers[layer];
+                l.has_mixin = false;
+        for(int j = 0; j < condition_size; ++j)
+        {
+            auto* col = l.mixin_weights + j * gates_padded;
+            for(int i = 0; i < numGates(); ++i)
+            {
+                col[gateIndex(i)] = mixinWeights[(size_t)i][(size_t)j];
+                l.has_mixin |= mixinWeights[(size_t)i][(size_t)j] != (T)0;
+            }
+        }
+    }
+
+    /**
+     * Sets the residual 1x1 convolution weights for a layer. The last
+     * layer's residual outputs are only used if there is another layer
+     * array after this one.
+     *
+     * The weights vector must have size weights[channels][channels],
+     * and the bias vector must have size bias[channels].
+     */
+    void setResidualWeights(int layer, const std::vector<std::vector<T>>& residualWeights, const std::vector<T>& bias)
+    {
+        const auto& l = layers[layer];
+        packMatrix(residualWeights, l.residual_weights, channels_padded);
+        std::copy(bias.begin(), bias.end(), l.residual_bias);
+    }
+
+    /**
+     * Sets the skip 1x1 convolution weights for a layer.
+     *
+     * The weights vector must have size weights[skip_channels][channels],
+     * and the bias vector must have size bias[skip_channels].
+     */
+    void setSkipWeights(int layer, const std::vector<std::vector<T>>& skipWeights, const std::vector<T>& bias)
+    {
+        auto& l = layers[layer];
+        packMatrix(skipWeights, l.skip_weights, skip_padded);
+        std::copy(bias.begin(), bias.end(), l.skip_bias);
+
+        // identity skip projections (as used by NAM models) are skipped
+        l.identity_skip = skip_channels == channels;
+        for(int i = 0; i < skip_channels; ++i)
+            for(int j = 0; j < channels; ++j)
+                l.identity_skip &= skipWeights[(size_t)i][(size_t)j] == (i == j ? (T)1 : (T)0);
+
+        // the skip biases are all added at once
+        std::fill(skip_bias, skip_bias + skip_padded, (T)0);
+        for(int n = 0; n < num_layers; ++n)
+            for(int i = 0; i < skip_padded; ++i)
+                skip_bias[i] += layers[n].skip_bias[i];
+    }
+
+    /**
+     * Sets the output 1x1 convolution weights.
+     *
+     * The weights vector must have size weights[num_outputs][skip_channels],
+     * and the bias vector must have size bias[num_outputs].
+     */
+    void setOutputWeights(const std::vector<std::vector<T>>& outputWeights, const std::vector<T>& bias)
+    {
+        packMatrix(outputWeights, output_weights, outputs_padded);
+        std::copy(bias.begin(), bias.end(), output_bias);
+    }
+
+    /** Returns the input size of the layer array. */
+    int getInputSize() const noexcept { return num_inputs; }
+
+    /** Returns the condition input size of the layer array. */
+    int getConditionSize() const noexcept { return condition_size; }
+
+    /** Returns the output size of the layer array. */
+    int getOutputSize() const noexcept { return num_outputs; }
+
+    /** Returns the number of layers in the layer array. */
+    int getNumLayers() const noexcept { return num_layers; }
+
+    /** Returns the dilation rate of a layer. */
+    int getDilationRate(int layer) const noexcept { return layers[layer].dilation; }
+
+    /** Returns the number of residual channels. */
+    int getChannels() const noexcept { return channels; }
+
+    /** Returns the number of skip channels. */
+    int getSkipChannels() const noexcept { return skip_channels; }
+
+    /** Returns the size of the dilated convolution kernels. */
+    int getKernelSize() const noexcept { return kernel_size; }
+
+    /** Returns true if the layers have gated activations. */
+    bool isGated() const noexcept { return gated; }
+
+private:
+    int numGates() const noexcept { return gated ? 2 * channels : channels; }
+
+    /** Returns the packed row of a dilated convolution output (tanh outputs first, then sigmoid outputs). */
+    int gateIndex(int i) const noexcept
+    {
+        return i < channels ? i : channels_padded + i - channels;
+    }
+
+    static void packMatrix(const std::vector<std::vector<T>>& matrix, T* data, int rows_padded)
+    {
+        for(size_t i = 0; i < matrix.size(); ++i)
+            for(size_t j = 0; j < matrix[i].size(); ++j)
+                data[j * (size_t)rows_padded + i] = matrix[i][j];
+    }
+
+    int num_inputs;
+    int condition_size;
+    int num_outputs;
+    int channels;
+    int skip_channels;
+    int kernel_size;
+    int num_layers;
+    bool gated;
+    bool residual_outputs;
+
+    int channels_padded;
+    int skip_padded;
+    int outputs_padded;
+    int gates_padded;
+
+    LayerData* layers;
+
+    T* input_weights = nullptr;
+    T* input_bias = nullptr;
+    T* output_weights = nullptr;
+    T* output_bias = nullptr;
+
+    T* z = nullptr;
+    T* g = nullptr;
+    T* skip = nullptr;
+    T* skip_bias = nullptr;
+    T* outputs = nullptr;
+    T* residual = nullptr;
+};
+
+#ifndef DOXYGEN
+namespace wavenet_detail
+{
+    /** Runs a sequence of layer arrays, where each layer array gets the residual and head outputs of the one before. */
+    template <typename T, typename MathsProvider>
+    inline void processLayerArrays(WaveNetStack<T, MathsProvider>* arrays, int num_arrays, const T* x, T* y, int out_size) noexcept
+    {
+        const T* array_in = x;
+        const T* head = nullptr;
+        for(int k = 0; k < num_arrays; ++k)
+        {
+            arrays[k].process(array_in, x, head);
+            array_in = arrays[k].getResidualOutputs();
+            head = arrays[k].getOutputs();
+        }
+        std::copy(head, head + out_size, y);
+    }
+} // namespace wavenet_detail
+#endif // DOXYGEN
+
+/** The dimensions of one layer array in a WaveNet layer (see WaveNetStack). */
+struct WaveNetArrayConfig
+{
+    int channels; // the number of residual channels
+    int skip_channels; // the number of skip channels
+    int head_size; // the output size of the layer array
+    int kernel_size; // the size of the dilated convolution kernels
+    std::vector<int> dilations; // the dilation rate of each layer
+    bool gated = true; // gated activations, or tanh activations
+};
+
+/**
+ * Dynamic implementation of a WaveNet layer: one or more arrays of
+ * dilated convolution layers, with residual and skip connections
+ * (see WaveNetStack). Each layer array after the first one takes the
+ * residual outputs of the previous layer array as its inputs, and adds
+ * the outputs of the previous layer array to its skip outputs, so the
+ * `head_size` of a layer array must equal the `skip_channels` of the
+ * layer array after it. All of the layer arrays are conditioned on the
+ * layer inputs, and the layer outputs are the outputs of the last layer
+ * array, which must have `head_size == out_size`.
+ */
+template <typename T, typename MathsProvider = DefaultMathsProvider>
+class WaveNet final : public Layer<T>
+{
+public:
+    /**
+     * Constructs a WaveNet layer with a single array of gated layers.
+     *
+     * @param in_size: the input size for the layer
+     * @param out_size: the output size for the layer
+     * @param channels: the number of residual channels
+     * @param skip_channels: the number of skip channels
+     * @param kernel_size: the size of the dilated convolution kernels
+     * @param dilations: the dilation rate of each layer
+     */
+    WaveNet(int in_size, int out_size, int channels, int skip_channels, int kernel_size, const std::vector<int>& dilations)
+        : WaveNet(in_size, out_size, { WaveNetArrayConfig { channels, skip_channels, out_size, kernel_size, dilations, true } })
+    {
+    }
+
+    /** Constructs a WaveNet layer with the given layer arrays. */
+    WaveNet(int in_size, int out_size, const std::vector<WaveNetArrayConfig>& layerArrays)
+        : Layer<T>(in_size, out_size)
+    {
+        size_t weights_size = 0;
+        size_t state_size = 0;
+        size_t scratch_size = 0;
+        size_t num_layers = 0;
+        auto num_inputs = in_size;
+        for(const auto& config : layerArrays)
+        {
+            const auto array_layers = (int)config.dilations.size();
+            weights_size += (size_t)wavenet_detail::weightsSize<T>(num_inputs, in_size, config.head_size, config.channels,
+                config.skip_channels, config.kernel_size, array_layers, config.gated);
+            int dilations_sum = 0;
+            for(auto d : config.dilations)
+                dilations_sum += d;
+            state_size += (size_t)wavenet_detail::stateSize<T>(config.channels, config.kernel_size, array_layers, dilations_sum);
+            scratch_size += (size_t)wavenet_detail::scratchSize<T>(config.head_size, config.channels, config.skip_channels, config.gated);
+            num_layers += (size_t)array_layers;
+            num_inputs = config.channels;
+        }
+
+        layers.resize(num_layers);
+        weights.resize(weights_size, (T)0);
+        state.resize(state_size, (T)0);
+        scratch.resize(scratch_size, (T)0);
+
+        typename WaveNetStack<T, MathsProvider>::Storage storage { layers.data(), weights.data(), state.data(), scratch.data() };
+        num_inputs = in_size;
+        arrays.reserve(layerArrays.size());
+        for(const auto& config : layerArrays)
+        {
+            arrays.emplace_back(num_inputs, in_size, config.head_size, config.channels, config.skip_channels, config.kernel_size,
+                config.dilations.data(), (int)config.dilations.size(), config.gated, arrays.size() + 1 < layerArrays.size(), storage);
+            num_inputs = config.channels;
+        }
+    }
+
+    WaveNet(const WaveNet&) = delete;
+    WaveNet& operator=(const WaveNet&) = delete;
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept override { return "wavenet"; }
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset() override
+    {
+        for(auto& layerArray : arrays)
+            layerArray.resetState();
+    }
+
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T* input, T* out) noexcept override
+    {
+        wavenet_detail::processLayerArrays(arrays.data(), (int)arrays.size(), input, out, Layer<T>::out_size);
+    }
+
+    /** Returns the number of layer arrays. */
+    int getNumLayerArrays() const noexcept { return (int)arrays.size(); }
+
+    /** Returns a layer array, to set its weights. */
+    WaveNetStack<T, MathsProvider>& getLayerArray(int index) noexcept { return arrays[(size_t)index]; }
+
+    /** Returns a layer array. */
+    const WaveNetStack<T, MathsProvider>& getLayerArray(int index) const noexcept { return arrays[(size_t)index]; }
+
+private:
+#if RTNEURAL_USE_XSIMD
+    using vec_type = std::vector<T, xsimd::aligned_allocator<T>>;
+#elif RTNEURAL_USE_EIGEN
+    using vec_type = std::vector<T, Eigen::aligned_allocator<T>>;
+#else
+    using vec_type = std::vector<T>;
+#endif
+
+    std::vector<typename WaveNetStack<T, MathsProvider>::LayerData> layers;
+    vec_type weights;
+    vec_type state;
+    vec_type scratch;
+    std::vector<WaveNetStack<T, MathsProvider>> arrays;
+};
+
+//====================================================
+/**
+ * The dimensions of one layer array in a WaveNetArraysT layer.
+ * The dilation rates of the layers are given as a `std::integer_sequence`.
+ *
+ * @param channels: the number of residual channels
+ * @param skip_channels: the number of skip channels
+ * @param head_size: the output size of the layer array
+ * @param kernel_size: the size of the dilated convolution kernels
+ * @param Dilations: the dilation rate of each layer
+ * @param gated: gated activations, or tanh activations
+ */
+template <int channelst, int skip_channelst, int head_sizet, int kernel_sizet, typename Dilations, bool gatedt = true>
+struct WaveNetArrayConfigT;
+
+template <int channelst, int skip_channelst, int head_sizet, int kernel_sizet, int... dilations, bool gatedt>
+struct WaveNetArrayConfigT<channelst, skip_channelst, head_sizet, kernel_sizet, std::integer_sequence<int, dilations...>, gatedt>
+{
+    static constexpr int channels = channelst;
+    static constexpr int skip_channels = skip_channelst;
+    static constexpr int head_size = head_sizet;
+    static constexpr int kernel_size = kernel_sizet;
+    static constexpr int num_layers = (int)sizeof...(dilations);
+    static constexpr int dilations_sum = wavenet_detail::sum<dilations...>();
+    static constexpr bool gated = gatedt;
+    using dilations_type = std::integer_sequence<int, dilations...>;
+};
+
+#ifndef DOXYGEN
+namespace wavenet_detail
+{
+    /** Computes the storage sizes for a sequence of layer arrays, at compile-time. */
+    template <typename T, int num_inputs, int condition_size, int head_size, typename... Arrays>
+    struct layer_arrays_info
+    {
+        static constexpr int out_size = head_size;
+        static constexpr int num_layers = 0;
+        static constexpr int weights_size = 0;
+        static constexpr int state_size = 0;
+        static constexpr int scratch_size = 0;
+    };
+
+    template <typename T, int num_inputs, int condition_size, int head_size, typename Array, typename... Arrays>
+    struct layer_arrays_info<T, num_inputs, condition_size, head_size, Array, Arrays...>
+    {
+        static_assert(head_size == 0 || head_size == Array::skip_channels,
+            "The skip channels of a layer array must match the head size of the previous layer array!");
+
+        using next = layer_arrays_info<T, Array::channels, condition_size, Array::head_size, Arrays...>;
+
+        static constexpr int out_size = next::out_size;
+        static constexpr int num_layers = Array::num_layers + next::num_layers;
+        static constexpr int weights_size = weightsSize<T>(num_inputs, condition_size, Array::head_size, Array::channels,
+                                                Array::skip_channels, Array::kernel_size, Array::num_layers, Array::gated)
+            + next::weights_size;
+        static constexpr int state_size = stateSize<T>(Array::channels, Array::kernel_size, Array::num_layers, Array::dilations_sum)
+            + next::state_size;
+        static constexpr int scratch_size = scratchSize<T>(Array::head_size, Array::channels, Array::skip_channels, Array::gated)
+            + next::scratch_size;
+    };
+} // namespace wavenet_detail
+#endif // DOXYGEN
+
+/**
+ * Static implementation of a WaveNet layer, with one or more layer arrays
+ * (see WaveNet), given as WaveNetArrayConfigT's:
+ * ```
+ * using Dilations = std::integer_sequence<int, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512>;
+ * WaveNetArraysT<float, 1, 1, DefaultMathsProvider,
+ *     WaveNetArrayConfigT<16, 16, 8, 3, Dilations, false>,
+ *     WaveNetArrayConfigT<8, 8, 1, 3, Dilations, false>>
+ * ```
+ * The weights, states, and scratch buffers are stored in fixed-size
+ * arrays, with their sizes computed from the template parameters.
+ *
+ * @param in_sizet: the input size for the layer
+ * @param out_sizet: the output size for the layer
+ * @param Arrays: the dimensions of each layer array
+ */
+template <typename T, int in_sizet, int out_sizet, typename MathsProvider, typename... Arrays>
+class WaveNetArraysT
+{
+    using info = wavenet_detail::layer_arrays_info<T, in_sizet, in_sizet, 0, Arrays...>;
+    static_assert(sizeof...(Arrays) > 0, "A WaveNet layer needs at least one layer array!");
+    static_assert(info::out_size == out_sizet, "The head size of the last layer array must match the layer output size!");
+
+    using Stack = WaveNetStack<T, MathsProvider>;
+    static constexpr int num_arrays = (int)sizeof...(Arrays);
+
+#if RTNEURAL_USE_XSIMD
+    using v_type = xsimd::simd_type<T>;
+    static constexpr auto v_size = (int)v_type::size;
+    static constexpr auto v_in_size = ceil_div(in_sizet, v_size);
+    static constexpr auto v_out_size = ceil_div(out_sizet, v_size);
+#endif
+
+public:
+    static constexpr auto in_size = in_sizet;
+    static constexpr auto out_size = out_sizet;
+
+    WaveNetArraysT()
+#if RTNEURAL_USE_EIGEN
+        : outs(outs_internal)
+#endif
+    {
+#if RTNEURAL_USE_XSIMD
+        for(int i = 0; i < v_out_size; ++i)
+            outs[i] = v_type((T)0);
+#endif
+    }
+
+    WaveNetArraysT(const WaveNetArraysT&) = delete;
+    WaveNetArraysT& operator=(const WaveNetArraysT&) = delete;
+
+    /** Returns the name of this layer. */
+    std::string getName() const noexcept { return "wavenet"; }
+
+    /** Returns false since the WaveNet layer is not an activation layer. */
+    constexpr bool isActivation() const noexcept { return false; }
+
+    /** Resets the layer state. */
+    RTNEURAL_REALTIME void reset()
+    {
+        for(auto& layerArray : arrays)
+            layerArray.resetState();
+    }
+
+    /** Returns the number of layer arrays. */
+    int getNumLayerArrays() const noexcept { return num_arrays; }
+
+    /** Returns a layer array, to set its weights. */
+    Stack& getLayerArray(int index) noexcept { return arrays[(size_t)index]; }
+
+    /** Returns a layer array. */
+    const Stack& getLayerArray(int index) const noexcept { return arrays[(size_t)index]; }
+
+#if RTNEURAL_USE_XSIMD
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const v_type (&ins)[v_in_size]) noexcept
+    {
+        wavenet_detail::processLayerArrays(arrays.data(), num_arrays, reinterpret_cast<const T*>(ins), reinterpret_cast<T*>(outs), out_size);
+    }
+
+    v_type outs[v_out_size];
+#elif RTNEURAL_USE_EIGEN
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const Eigen::Matrix<T, in_size, 1>& ins) noexcept
+    {
+        wavenet_detail::processLayerArrays(arrays.data(), num_arrays, ins.data(), outs.data(), out_size);
+    }
+
+    Eigen::Map<Eigen::Matrix<T, out_size, 1>, RTNeuralEigenAlignment> outs;
+
+private:
+    T outs_internal alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+#else
+    /** Performs forward propagation for this layer. */
+    RTNEURAL_REALTIME inline void forward(const T (&ins)[in_size]) noexcept
+    {
+        wavenet_detail::processLayerArrays(arrays.data(), num_arrays, ins, outs, out_size);
+    }
+
+    T outs alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size] {};
+#endif
+
+private:
+    /** Constructs the layer arrays, each of which takes its part of the storage. */
+    static std::array<Stack, num_arrays> makeArrays(typename Stack::Storage storage)
+    {
+        auto num_inputs = in_size;
+        int index = 0;
+        return { { makeArray<Arrays>(storage, num_inputs, index, typename Arrays::dilations_type {})... } };
+    }
+
+    template <typename Array, int... dilations>
+    static Stack makeArray(typename Stack::Storage& storage, int& num_inputs, int& index, std::integer_sequence<int, dilations...>)
+    {
+        const int dilation_rates[] = { dilations... };
+        Stack layerArray { num_inputs, in_size, Array::head_size, Array::channels, Array::skip_channels, Array::kernel_size,
+            dilation_rates, Array::num_layers, Array::gated, ++index < num_arrays, storage };
+        num_inputs = Array::channels;
+        return layerArray;
+    }
+
+    typename Stack::LayerData layers[info::num_layers];
+    T weights alignas(RTNEURAL_DEFAULT_ALIGNMENT)[info::weights_size] {};
+    T state alignas(RTNEURAL_DEFAULT_ALIGNMENT)[info::state_size] {};
+    T scratch alignas(RTNEURAL_DEFAULT_ALIGNMENT)[info::scratch_size] {};
+    std::array<Stack, num_arrays> arrays = makeArrays({ layers, weights, state, scratch });
+};
+
+/**
+ * Static implementation of a WaveNet layer with a single array of gated
+ * layers (see WaveNet). The dilation rates of the layers are given as a
+ * `std::integer_sequence`:
+ * ```
+ * WaveNetT<float, 1, 1, 16, 16, 3, std::integer_sequence<int, 1, 2, 4, 8, 16>>
+ * ```
+ *
+ * @param in_sizet: the input size for the layer
+ * @param out_sizet: the output size for the layer
+ * @param channels: the number of residual channels
+ * @param skip_channels: the number of skip channels
+ * @param kernel_size: the size of the dilated convolution kernels
+ * @param Dilations: the dilation rate of each layer
+ */
+template <typename T, int in_sizet, int out_sizet, int channels, int skip_channels, int kernel_size, typename Dilations,
+    typename MathsProvider = DefaultMathsProvider>
+class WaveNetT : public WaveNetArraysT<T, in_sizet, out_sizet, MathsProvider,
+                     WaveNetArrayConfigT<channels, skip_channels, out_sizet, kernel_size, Dilations>>
+{
+};
+
+} // namespace RTNEURAL_NAMESPACE
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <cpu_features.h>
+#include <iostream>
 #include <random>
 #include <vector>
 
@@ -29,3 +31,21 @@ std::vector<vec_type> generate_signal(size_t n_samples,
 
     return std::move(signal);
 }
+
+/**
+ * Returns true if the CPU supports the SIMD instruction set that
+ * RTNeural was compiled for, otherwise prints a message so that
+ * the benchmark can exit cleanly.
+ */
+bool check_cpu_support()
+{
+    if(RTNeural::isCompiledArchSupported())
+    {
+        std::cout << "Using SIMD instruction set: " << RTNeural::getCompiledArchName() << std::endl;
+        return true;
+    }
+
+    std::cout << "RTNeural was compiled for " << RTNeural::getCompiledArchName()
+              << ", which is not supported by this CPU. Skipping benchmark..." << std::endl;
+    return false;
+}
@@ -0,0 +1,165 @@
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using T = float;
+using Weights = std::vector<std::vector<std::vector<T>>>;
+
+Weights randomGroupedWeights(int in_size, int out_size, int kernel_size, int groups, std::default_random_engine& rng)
+{
+    std::uniform_real_distribution<T> values((T)-0.5, (T)0.5);
+    Weights weights((size_t)out_size, std::vector<std::vector<T>>((size_t)(in_size / groups), std::vector<T>((size_t)kernel_size)));
+    for(auto& filter : weights)
+        for(auto& channel : filter)
+            for(auto& w : channel)
+                w = values(rng);
+    return weights;
+}
+
+/**
+ * Expands the weights of a grouped convolution into the (block-diagonal)
+ * weights of the equivalent convolution with groups = 1.
+ */
+Weights expandGroupedWeights(const Weights& weights, int in_size, int groups)
+{
+    const auto out_size = (int)weights.size();
+    const auto filters_per_group = in_size / groups;
+    const auto channels_per_group = out_size / groups;
+    const auto kernel_size = weights[0][0].size();
+
+    Weights expanded((size_t)out_size, std::vector<std::vector<T>>((size_t)in_size, std::vector<T>(kernel_size, (T)0)));
+    for(int i = 0; i < out_size; ++i)
+    {
+        const auto ii = (i / channels_per_group) * filters_per_group;
+        for(int f = 0; f < filters_per_group; ++f)
+            expanded[(size_t)i][(size_t)(ii + f)] = weights[(size_t)i][(size_t)f];
+    }
+
+    return expanded;
+}
+
+template <typename Func>
+double timeNanosecondsPerSample(size_t n_samples, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    const auto start = clock_t::now();
+    for(size_t n = 0; n < n_samples; ++n)
+        process(n);
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)n_samples;
+}
+
+void printRow(const std::string& layer, double generic_ns_per_sample, double grouped_ns_per_sample)
+{
+    std::cout << std::left << std::setw(34) << layer
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << generic_ns_per_sample
+              << std::setw(12) << grouped_ns_per_sample
+              << std::setw(10) << std::setprecision(2) << generic_ns_per_sample / grouped_ns_per_sample << "x" << std::endl;
+}
+
+// Conv1D with groups vs. the same convolution as a Conv1D with groups = 1.
+void benchDynamic(int in_size, int out_size, int kernel_size, int dilation, int groups, size_t n_samples)
+{
+    const auto signal = generate_signal(n_samples, (size_t)in_size);
+    std::vector<std::vector<T>> input(n_samples, std::vector<T>((size_t)in_size));
+    for(size_t n = 0; n < n_samples; ++n)
+        std::copy(signal[n].begin(), signal[n].end(), input[n].begin());
+    std::vector<T> output((size_t)out_size);
+
+    std::default_random_engine rng;
+    const auto weights = randomGroupedWeights(in_size, out_size, kernel_size, groups, rng);
+
+    RTNeural::Conv1D<T> generic(in_size, out_size, kernel_size, dilation, 1);
+    generic.setWeights(expandGroupedWeights(weights, in_size, groups));
+    generic.reset();
+    const auto generic_ns = timeNanosecondsPerSample(n_samples, [&](size_t n)
+        { generic.forward(input[n].data(), output.data()); });
+
+    RTNeural::Conv1D<T> grouped(in_size, out_size, kernel_size, dilation, groups);
+    grouped.setWeights(weights);
+    grouped.reset();
+    const auto grouped_ns = timeNanosecondsPerSample(n_samples, [&](size_t n)
+        { grouped.forward(input[n].data(), output.data()); });
+
+    printRow("Conv1D " + std::to_string(in_size) + "->" + std::to_string(out_size)
+            + " k" + std::to_string(kernel_size) + " g" + std::to_string(groups),
+        generic_ns,
+        grouped_ns);
+}
+
+template <typename LayerType>
+double benchTemplatedLayer(const Weights& weights, size_t n_samples)
+{
+    using ModelType = RTNeural::ModelT<T, LayerType::in_size, LayerType::out_size, LayerType>;
+
+    const auto signal = generate_signal(n_samples, (size_t)LayerType::in_size);
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(LayerType::in_size, 16) * 16] {};
+
+    ModelType model;
+    model.template get<0>().setWeights(weights);
+    model.reset();
+
+    return timeNanosecondsPerSample(n_samples, [&](size_t n)
+        {
+            std::copy(signal[n].begin(), signal[n].end(), x);
+            model.forward(x); });
+}
+
+// Conv1DT with groups vs. the same convolution as a Conv1DT with groups = 1.
+template <int in_size, int out_size, int kernel_size, int dilation, int groups>
+void benchTemplated(size_t n_samples)
+{
+    std::default_random_engine rng;
+    const auto weights = randomGroupedWeights(in_size, out_size, kernel_size, groups, rng);
+
+    const auto generic_ns = benchTemplatedLayer<RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation, 1>>(
+        expandGroupedWeights(weights, in_size, groups), n_samples);
+    const auto grouped_ns = benchTemplatedLayer<RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation, groups>>(
+        weights, n_samples);
+
+    printRow("Conv1DT " + std::to_string(in_size) + "->" + std::to_string(out_size)
+            + " k" + std::to_string(kernel_size) + " g" + std::to_string(groups),
+        generic_ns,
+        grouped_ns);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_samples = 48000;
+    if(argc > 1)
+        n_samples = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "Grouped convolutions vs. the equivalent groups = 1 convolution (float):" << std::endl;
+    std::cout << std::left << std::setw(34) << "layer"
+              << std::right << std::setw(12) << "generic ns" << std::setw(12) << "grouped ns"
+              << std::setw(11) << "speedup" << std::endl;
+
+    // depthwise, with and without dilation
+    benchDynamic(32, 32, 3, 2, 32, n_samples);
+    benchDynamic(32, 32, 1, 1, 32, n_samples);
+    benchTemplated<32, 32, 3, 2, 32>(n_samples);
+    benchTemplated<32, 32, 1, 1, 32>(n_samples);
+
+    // depthwise with a channel multiplier
+    benchDynamic(16, 32, 3, 1, 16, n_samples);
+    benchTemplated<16, 32, 3, 1, 16>(n_samples);
+
+    // grouped
+    benchDynamic(32, 32, 3, 1, 8, n_samples);
+    benchDynamic(64, 64, 5, 1, 4, n_samples);
+    benchTemplated<32, 32, 3, 1, 8>(n_samples);
+    benchTemplated<64, 64, 5, 1, 4>(n_samples);
+
+    return 0;
+}
@@ -0,0 +1,119 @@
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using T = float;
+
+template <typename Func>
+double timeNanosecondsPerFrame(size_t n_frames, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    const auto start = clock_t::now();
+    for(size_t n = 0; n < n_frames; ++n)
+        process(n);
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)n_frames;
+}
+
+std::vector<std::vector<std::vector<T>>> randomWeights(int num_filters_in, int num_filters_out, int kernel_size, std::default_random_engine& rng)
+{
+    std::uniform_real_distribution<T> values((T)-0.5, (T)0.5);
+    std::vector<std::vector<std::vector<T>>> weights((size_t)num_filters_out,
+        std::vector<std::vector<T>>((size_t)num_filters_in, std::vector<T>((size_t)kernel_size)));
+    for(auto& filter : weights)
+        for(auto& channel : filter)
+            for(auto& w : channel)
+                w = values(rng);
+    return weights;
+}
+
+std::string layerName(const std::string& type, int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad)
+{
+    return type + " " + std::to_string(num_filters_in) + "x" + std::to_string(num_features_in)
+        + "->" + std::to_string(num_filters_out) + " k" + std::to_string(kernel_size)
+        + " s" + std::to_string(stride) + (valid_pad ? " valid" : " same");
+}
+
+void printRow(const std::string& layer, double ns_per_frame)
+{
+    std::cout << std::left << std::setw(46) << layer
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(14) << ns_per_frame << std::endl;
+}
+
+void benchDynamic(int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad, size_t n_frames)
+{
+    std::default_random_engine rng;
+    RTNeural::Conv1DStateless<T> conv(num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad);
+    conv.setWeights(randomWeights(num_filters_in, num_filters_out, kernel_size, rng));
+
+    const auto signal = generate_signal(n_frames, (size_t)conv.in_size);
+    std::vector<T> input((size_t)conv.in_size);
+    std::vector<T> output((size_t)conv.out_size);
+
+    const auto ns = timeNanosecondsPerFrame(n_frames, [&](size_t n)
+        {
+            std::copy(signal[n].begin(), signal[n].end(), input.begin());
+            std::fill(output.begin(), output.end(), (T)0);
+            conv.forward(input.data(), output.data()); });
+
+    printRow(layerName("Conv1DStateless", num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad), ns);
+}
+
+// Conv1DStatelessT is timed through a Conv2DT with a single time step
+template <int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad>
+void benchTemplated(size_t n_frames)
+{
+    using LayerType = RTNeural::Conv2DT<T, num_filters_in, num_filters_out, num_features_in, 1, kernel_size, 1, stride, valid_pad>;
+    using ModelType = RTNeural::ModelT2D<T, num_filters_in, num_features_in, num_filters_out, LayerType::num_features_out, LayerType>;
+
+    std::default_random_engine rng;
+    ModelType model;
+    model.template get<0>().setWeights({ randomWeights(num_filters_in, num_filters_out, kernel_size, rng) });
+    model.reset();
+
+    const auto signal = generate_signal(n_frames, (size_t)LayerType::in_size);
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[LayerType::in_size] {};
+
+    const auto ns = timeNanosecondsPerFrame(n_frames, [&](size_t n)
+        {
+            std::copy(signal[n].begin(), signal[n].end(), x);
+            model.forward(x); });
+
+    printRow(layerName("Conv1DStatelessT", num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad), ns);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_frames = 2000;
+    if(argc > 1)
+        n_frames = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "Conv1DStateless layers, ns per frame (float):" << std::endl;
+
+    // the layers from examples/conv1d_stateless_example
+    benchDynamic(1, 128, 12, 65, 1, true, n_frames);
+    benchDynamic(12, 64, 8, 33, 1, true, n_frames);
+    benchTemplated<1, 128, 12, 65, 1, true>(n_frames);
+    benchTemplated<12, 64, 8, 33, 1, true>(n_frames);
+
+    // spectrogram-sized Conv2D feature convolutions
+    benchDynamic(8, 128, 16, 5, 1, false, n_frames);
+    benchDynamic(16, 128, 16, 3, 2, false, n_frames);
+    benchDynamic(16, 64, 32, 3, 2, true, n_frames);
+    benchTemplated<8, 128, 16, 5, 1, false>(n_frames);
+    benchTemplated<16, 128, 16, 3, 2, false>(n_frames);
+    benchTemplated<16, 64, 32, 3, 2, true>(n_frames);
+
+    return 0;
+}
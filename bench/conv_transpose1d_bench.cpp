@@ -0,0 +1,100 @@
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using T = float;
+using Weights = std::vector<std::vector<std::vector<T>>>;
+
+Weights randomWeights(int in_size, int out_size, int kernel_size, std::default_random_engine& rng)
+{
+    std::uniform_real_distribution<T> values((T)-0.5, (T)0.5);
+    Weights weights((size_t)out_size, std::vector<std::vector<T>>((size_t)in_size, std::vector<T>((size_t)kernel_size)));
+    for(auto& filter : weights)
+        for(auto& channel : filter)
+            for(auto& w : channel)
+                w = values(rng);
+    return weights;
+}
+
+template <typename Func>
+double timeNanosecondsPerInputFrame(size_t n_frames, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    const auto start = clock_t::now();
+    for(size_t n = 0; n < n_frames; ++n)
+        process(n);
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)n_frames;
+}
+
+void printRow(const std::string& layer, double zero_stuffed_ns, double polyphase_ns)
+{
+    std::cout << std::left << std::setw(34) << layer
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(16) << zero_stuffed_ns
+              << std::setw(14) << polyphase_ns
+              << std::setw(10) << std::setprecision(2) << zero_stuffed_ns / polyphase_ns << "x" << std::endl;
+}
+
+// ConvTranspose1D vs. the same transposed convolution as a Conv1D running on the zero-stuffed input
+void bench(int in_size, int out_size, int kernel_size, int stride, size_t n_frames)
+{
+    const auto signal = generate_signal(n_frames, (size_t)in_size);
+    std::vector<std::vector<T>> input(n_frames, std::vector<T>((size_t)in_size));
+    for(size_t n = 0; n < n_frames; ++n)
+        std::copy(signal[n].begin(), signal[n].end(), input[n].begin());
+    const std::vector<T> zeros((size_t)in_size, (T)0);
+    std::vector<T> output((size_t)(stride * out_size));
+
+    std::default_random_engine rng;
+    const auto weights = randomWeights(in_size, out_size, kernel_size, rng);
+
+    RTNeural::Conv1D<T> zero_stuffed(in_size, out_size, kernel_size, 1, 1);
+    zero_stuffed.setWeights(weights);
+    zero_stuffed.reset();
+    const auto zero_stuffed_ns = timeNanosecondsPerInputFrame(n_frames, [&](size_t n)
+        {
+            zero_stuffed.forward(input[n].data(), output.data());
+            for(int p = 1; p < stride; ++p)
+                zero_stuffed.forward(zeros.data(), output.data() + p * out_size); });
+
+    RTNeural::ConvTranspose1D<T> polyphase(in_size, out_size, kernel_size, 1, stride);
+    polyphase.setWeights(weights);
+    polyphase.reset();
+    const auto polyphase_ns = timeNanosecondsPerInputFrame(n_frames, [&](size_t n)
+        { polyphase.forward(input[n].data(), output.data()); });
+
+    printRow("ConvTranspose1D " + std::to_string(in_size) + "->" + std::to_string(out_size)
+            + " k" + std::to_string(kernel_size) + " s" + std::to_string(stride),
+        zero_stuffed_ns,
+        polyphase_ns);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_frames = 20000;
+    if(argc > 1)
+        n_frames = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "Transposed convolutions, ns per input frame (float):" << std::endl;
+    std::cout << std::left << std::setw(34) << "layer"
+              << std::right << std::setw(16) << "zero-stuffed ns" << std::setw(14) << "polyphase ns"
+              << std::setw(11) << "speedup" << std::endl;
+
+    bench(4, 15, 5, 3, n_frames);
+    bench(16, 16, 4, 2, n_frames);
+    bench(32, 16, 8, 4, n_frames);
+    bench(16, 8, 16, 8, n_frames);
+
+    return 0;
+}
@@ -2,8 +2,17 @@
 #include "layer_creator.hpp"
 #include "templated_bench.hpp"
 #include <RTNeural.h>
+#include <algorithm>
 #include <iostream>
 
+constexpr long max_layer_size = 4096;
+
+// limits the memory used by the generated signal (in samples) for large layers
+constexpr size_t max_signal_size = (size_t)1 << 24;
+
+// number of samples processed at a time when benchmarking block processing
+constexpr size_t block_size = 32;
+
 void help()
 {
     std::cout << "RTNeural layer benchmarks:" << std::endl;
@@ -13,10 +22,16 @@ void help()
     std::cout
         << "    Note that for activation layers the out_size argument is ignored."
         << std::endl;
+    std::cout
+        << "    Layer sizes up to " << max_layer_size << " are supported."
+        << std::endl;
 }
 
 int main(int argc, char* argv[])
 {
+    if(!check_cpu_support())
+        return 0;
+
     if(argc < 4 || argc > 5)
     {
         help();
@@ -34,6 +49,12 @@ int main(int argc, char* argv[])
     const auto length_seconds = std::atof(argv[2]);
     const auto in_size = std::atol(argv[3]);
     const auto out_size = argc == 5 ? std::atol(argv[4]) : in_size;
+    if(in_size < 1 || out_size < 1 || in_size > max_layer_size || out_size > max_layer_size)
+    {
+        help();
+        return 1;
+    }
+
     std::cout << "Benchmarking " << layer_type << " layer, with input size "
               << in_size << " and output size " << out_size
               << ", with signal length " << length_seconds << " seconds"
@@ -47,8 +68,11 @@ int main(int argc, char* argv[])
     // generate audio
     constexpr double sample_rate = 48000.0;
     const auto n_samples = static_cast<size_t>(sample_rate * length_seconds);
-    const auto signal = generate_signal(n_samples, in_size);
-    std::vector<double> output(out_size);
+
+    // for large layers, a shorter signal is generated and then looped
+    const auto n_signal_samples = std::max((size_t)1, std::min(n_samples, max_signal_size / (size_t)in_size));
+    const auto signal = generate_signal(n_signal_samples, in_size);
+    std::vector<double> output(out_size * block_size);
 
     // run benchmark
     using clock_t = std::chrono::high_resolution_clock;
@@ -58,7 +82,7 @@ int main(int argc, char* argv[])
     {
         auto start = clock_t::now();
         for(size_t i = 0; i < n_samples; ++i)
-            layer->forward(signal[i].data(), output.data());
+            layer->forward(signal[i % n_signal_samples].data(), output.data());
         nonTemplatedDur = std::chrono::duration_cast<second_t>(clock_t::now() - start).count();
 
         std::cout << "Processed " << length_seconds << " seconds of signal in "
@@ -66,6 +90,26 @@ int main(int argc, char* argv[])
         std::cout << length_seconds / nonTemplatedDur << "x real-time" << std::endl;
     }
 
+    if(layer_type == "dense")
+    {
+        std::cout << "Testing block processing (block size " << block_size << ")..." << std::endl;
+
+        std::vector<double> block_signal(block_size * in_size);
+        for(size_t n = 0; n < block_size; ++n)
+            std::copy(signal[n % n_signal_samples].begin(), signal[n % n_signal_samples].end(), &block_signal[n * in_size]);
+
+        auto* dense = static_cast<RTNeural::Dense<double>*>(layer.get());
+        auto start = clock_t::now();
+        for(size_t i = 0; i < n_samples; i += block_size)
+            dense->forwardBlock(block_signal.data(), output.data(), (int)std::min(block_size, n_samples - i));
+        const auto blockDur = std::chrono::duration_cast<second_t>(clock_t::now() - start).count();
+
+        std::cout << "Processed " << length_seconds << " seconds of signal in "
+                  << blockDur << " seconds" << std::endl;
+        std::cout << length_seconds / blockDur << "x real-time" << std::endl;
+        std::cout << "Block processing is " << nonTemplatedDur / blockDur << "x faster!" << std::endl;
+    }
+
 #if MODELT_AVAILABLE
     std::cout << "Testing templated implementation..." << std::endl;
     double templatedDur = 0.0;
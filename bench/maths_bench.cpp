@@ -0,0 +1,253 @@
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using T = float;
+using LUTCubicMathsProvider = RTNeural::LUTMathsProvider<1024, 8, RTNeural::approx_maths::LUTInterpolation::Cubic>;
+
+enum class Function
+{
+    Tanh,
+    Sigmoid,
+    Exp,
+};
+
+#if RTNEURAL_USE_XSIMD
+using float_vec = std::vector<T, xsimd::aligned_allocator<T>>;
+#elif RTNEURAL_USE_EIGEN
+using float_vec = std::vector<T, Eigen::aligned_allocator<T>>;
+#else
+using float_vec = std::vector<T>;
+#endif
+
+// Applies the function to a buffer, using the backend's vector types.
+template <typename Provider, Function function>
+void apply(const float_vec& x, float_vec& y)
+{
+#if RTNEURAL_USE_EIGEN
+    using vec_type = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    const Eigen::Map<const vec_type, RTNeural::RTNeuralEigenAlignment> xVec(x.data(), (Eigen::Index)x.size());
+    Eigen::Map<vec_type, RTNeural::RTNeuralEigenAlignment> yVec(y.data(), (Eigen::Index)y.size());
+    if(function == Function::Tanh)
+        yVec = Provider::tanh(xVec);
+    else if(function == Function::Sigmoid)
+        yVec = Provider::sigmoid(xVec);
+    else
+        yVec = Provider::exp(xVec);
+#elif RTNEURAL_USE_XSIMD
+    using b_type = xsimd::simd_type<T>;
+    for(size_t i = 0; i < x.size(); i += b_type::size)
+    {
+        const auto xBatch = xsimd::load_aligned(&x[i]);
+        if(function == Function::Tanh)
+            xsimd::store_aligned(&y[i], Provider::tanh(xBatch));
+        else if(function == Function::Sigmoid)
+            xsimd::store_aligned(&y[i], Provider::sigmoid(xBatch));
+        else
+            xsimd::store_aligned(&y[i], Provider::exp(xBatch));
+    }
+#else
+    for(size_t i = 0; i < x.size(); ++i)
+    {
+        if(function == Function::Tanh)
+            y[i] = Provider::tanh(x[i]);
+        else if(function == Function::Sigmoid)
+            y[i] = Provider::sigmoid(x[i]);
+        else
+            y[i] = Provider::exp(x[i]);
+    }
+#endif
+}
+
+double reference(Function function, double x)
+{
+    if(function == Function::Tanh)
+        return std::tanh(x);
+    if(function == Function::Sigmoid)
+        return 1.0 / (1.0 + std::exp(-x));
+    return std::exp(x);
+}
+
+template <typename Provider, Function function>
+void benchFunction(const std::string& provider_name, const char* function_name, size_t n_iterations)
+{
+    // a multiple of every SIMD size
+    constexpr size_t n_points = 4096;
+    const auto x_range = function == Function::Exp ? 20.0 : 8.0;
+
+    float_vec x(n_points);
+    float_vec y(n_points);
+    for(size_t i = 0; i < n_points; ++i)
+        x[i] = (T)(-x_range + 2.0 * x_range * (double)i / (double)(n_points - 1));
+
+    // speed
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+    const auto start = clock_t::now();
+    for(size_t n = 0; n < n_iterations; ++n)
+        apply<Provider, function>(x, y);
+    const auto duration = std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count();
+
+    // accuracy (relative error for exp, absolute otherwise)
+    double max_error = 0.0;
+    double sum_sq_error = 0.0;
+    for(size_t i = 0; i < n_points; ++i)
+    {
+        const auto expected = reference(function, (double)x[i]);
+        auto error = std::abs((double)y[i] - expected);
+        if(function == Function::Exp)
+            error /= expected;
+
+        max_error = std::max(max_error, error);
+        sum_sq_error += error * error;
+    }
+
+    std::cout << std::left << std::setw(12) << provider_name << std::setw(9) << function_name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(3) << duration / (double)(n_iterations * n_points)
+              << std::setw(14) << std::scientific << std::setprecision(2) << max_error
+              << std::setw(14) << std::sqrt(sum_sq_error / (double)n_points) << std::endl;
+}
+
+template <typename Provider>
+void benchProvider(const std::string& provider_name, size_t n_iterations)
+{
+    benchFunction<Provider, Function::Tanh>(provider_name, "tanh", n_iterations);
+    benchFunction<Provider, Function::Sigmoid>(provider_name, "sigmoid", n_iterations);
+    benchFunction<Provider, Function::Exp>(provider_name, "exp", n_iterations);
+}
+
+// The recurrent models from models/, with the architectures used in the tests.
+template <typename Scalar, typename MP>
+using GRUModel = RTNeural::ModelT<Scalar, 1, 1,
+    RTNeural::DenseT<Scalar, 1, 8>,
+    RTNeural::TanhActivationT<Scalar, 8, MP>,
+    RTNeural::GRULayerT<Scalar, 8, 8, RTNeural::SampleRateCorrectionMode::None, MP>,
+    RTNeural::DenseT<Scalar, 8, 8>,
+    RTNeural::SigmoidActivationT<Scalar, 8, MP>,
+    RTNeural::DenseT<Scalar, 8, 1>>;
+
+template <typename Scalar, typename MP>
+using GRU1DModel = RTNeural::ModelT<Scalar, 1, 1,
+    RTNeural::GRULayerT<Scalar, 1, 8, RTNeural::SampleRateCorrectionMode::None, MP>,
+    RTNeural::DenseT<Scalar, 8, 8>,
+    RTNeural::SigmoidActivationT<Scalar, 8, MP>,
+    RTNeural::DenseT<Scalar, 8, 1>>;
+
+template <typename Scalar, typename MP>
+using LSTMModel = RTNeural::ModelT<Scalar, 1, 1,
+    RTNeural::DenseT<Scalar, 1, 8>,
+    RTNeural::TanhActivationT<Scalar, 8, MP>,
+    RTNeural::LSTMLayerT<Scalar, 8, 8, RTNeural::SampleRateCorrectionMode::None, MP>,
+    RTNeural::DenseT<Scalar, 8, 1>>;
+
+template <typename Scalar, typename MP>
+using LSTM1DModel = RTNeural::ModelT<Scalar, 1, 1,
+    RTNeural::LSTMLayerT<Scalar, 1, 8, RTNeural::SampleRateCorrectionMode::None, MP>,
+    RTNeural::DenseT<Scalar, 8, 1>>;
+
+template <typename Scalar, typename ModelType>
+std::vector<double> runModel(const std::string& model_file, const std::vector<vec_type>& signal, double& ns_per_sample)
+{
+    ModelType model;
+    std::ifstream jsonStream(model_file, std::ifstream::binary);
+    model.parseJson(jsonStream);
+    model.reset();
+
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    std::vector<double> output(signal.size());
+    const auto start = clock_t::now();
+    for(size_t i = 0; i < signal.size(); ++i)
+    {
+        const Scalar input[] = { (Scalar)signal[i][0] };
+        output[i] = (double)model.forward(input);
+    }
+    ns_per_sample = std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)signal.size();
+
+    return output;
+}
+
+template <template <typename, typename> class Model, typename Provider>
+void benchModelProvider(const std::string& model_file, const std::string& provider_name,
+    const std::vector<vec_type>& signal, const std::vector<double>& reference_output)
+{
+    double ns_per_sample = 0.0;
+    const auto output = runModel<T, Model<T, Provider>>(model_file, signal, ns_per_sample);
+
+    double max_error = 0.0;
+    double sum_sq_error = 0.0;
+    for(size_t i = 0; i < output.size(); ++i)
+    {
+        const auto error = std::abs(output[i] - reference_output[i]);
+        max_error = std::max(max_error, error);
+        sum_sq_error += error * error;
+    }
+
+    std::cout << std::left << std::setw(22) << model_file << std::setw(12) << provider_name
+              << std::right << std::setw(12) << std::fixed << std::setprecision(1) << ns_per_sample
+              << std::setw(14) << std::scientific << std::setprecision(2) << max_error
+              << std::setw(14) << std::sqrt(sum_sq_error / (double)output.size()) << std::endl;
+}
+
+template <template <typename, typename> class Model>
+void benchModel(const std::string& model_file, const std::vector<vec_type>& signal)
+{
+    // the reference output is computed in double precision, with the default provider
+    double ns_per_sample = 0.0;
+    const auto reference_output = runModel<double, Model<double, RTNeural::DefaultMathsProvider>>(model_file, signal, ns_per_sample);
+
+    benchModelProvider<Model, RTNeural::DefaultMathsProvider>(model_file, "Default", signal, reference_output);
+    benchModelProvider<Model, RTNeural::PadeMathsProvider>(model_file, "Pade", signal, reference_output);
+    benchModelProvider<Model, RTNeural::Exp2MathsProvider>(model_file, "Exp2", signal, reference_output);
+    benchModelProvider<Model, RTNeural::PolynomialMathsProvider>(model_file, "Polynomial", signal, reference_output);
+    benchModelProvider<Model, RTNeural::LUTMathsProvider<>>(model_file, "LUT", signal, reference_output);
+    benchModelProvider<Model, LUTCubicMathsProvider>(model_file, "LUT-cubic", signal, reference_output);
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    RTNeural::LUTMathsProvider<>::initialise<T>();
+    LUTCubicMathsProvider::initialise<T>();
+
+    size_t n_iterations = 2000;
+    if(argc > 1)
+        n_iterations = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "Activation functions (float), max/RMS error is relative for exp:" << std::endl;
+    std::cout << std::left << std::setw(12) << "provider" << std::setw(9) << "function"
+              << std::right << std::setw(12) << "ns/element" << std::setw(14) << "max error"
+              << std::setw(14) << "RMS error" << std::endl;
+    benchProvider<RTNeural::DefaultMathsProvider>("Default", n_iterations);
+    benchProvider<RTNeural::PadeMathsProvider>("Pade", n_iterations);
+    benchProvider<RTNeural::Exp2MathsProvider>("Exp2", n_iterations);
+    benchProvider<RTNeural::PolynomialMathsProvider>("Polynomial", n_iterations);
+    benchProvider<RTNeural::LUTMathsProvider<>>("LUT", n_iterations);
+    benchProvider<LUTCubicMathsProvider>("LUT-cubic", n_iterations);
+
+    // one second of audio at 48 kHz
+    const auto signal = generate_signal(48000, 1);
+
+    std::cout << std::endl
+              << "Models (float), error vs. the default provider in double precision:" << std::endl;
+    std::cout << std::left << std::setw(22) << "model" << std::setw(12) << "provider"
+              << std::right << std::setw(12) << "ns/sample" << std::setw(14) << "max error"
+              << std::setw(14) << "RMS error" << std::endl;
+    benchModel<GRUModel>("models/gru.json", signal);
+    benchModel<GRU1DModel>("models/gru_1d.json", signal);
+    benchModel<LSTMModel>("models/lstm.json", signal);
+    benchModel<LSTM1DModel>("models/lstm_1d.json", signal);
+
+    return 0;
+}
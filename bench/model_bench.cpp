@@ -29,6 +29,9 @@ double runBench(ModelType& model, double length_seconds)
 
 int main(int argc, char* argv[])
 {
+    if(!check_cpu_support())
+        return 0;
+
     const std::string model_file = "models/full_model.json";
     constexpr double bench_time = 100.0;
     double nonTemplatedDur = 0.0;
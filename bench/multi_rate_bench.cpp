@@ -0,0 +1,151 @@
+#include "../tests/functional/test_helpers.hpp"
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using namespace test_helpers;
+
+using T = float;
+constexpr int stride = 4;
+
+/**
+ * strided conv1d (1 -> 16, k8, tanh) -> gru (16 -> 16) -> dense (16 -> 16),
+ * and optionally convtranspose1d (16 -> 8, k8) -> dense (8 -> 1)
+ */
+nlohmann::json makeModelJson(bool with_decoder)
+{
+    std::default_random_engine rng;
+
+    auto conv = makeLayer("conv1d", 16, "tanh", { randomTensor(rng, { 8, 1, 16 }), randomTensor(rng, { 16 }) });
+    conv["kernel_size"] = { 8 };
+    conv["dilation"] = { 1 };
+    conv["strides"] = { stride };
+
+    auto gru = makeLayer("gru", 16, "", { randomTensor(rng, { 16, 48 }), randomTensor(rng, { 16, 48 }), randomTensor(rng, { 2, 48 }) });
+    auto dense = makeLayer("dense", 16, "", { randomTensor(rng, { 16, 16 }), randomTensor(rng, { 16 }) });
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, 1 };
+    model["layers"] = { conv, gru, dense };
+
+    if(with_decoder)
+    {
+        auto conv_transpose = makeLayer("convtranspose1d", 8, "", { randomTensor(rng, { 8, 8, 16 }), randomTensor(rng, { 8 }) });
+        conv_transpose["kernel_size"] = { 8 };
+        conv_transpose["dilation"] = { 1 };
+        conv_transpose["strides"] = { stride };
+
+        model["layers"].push_back(conv_transpose);
+        model["layers"].push_back(makeLayer("dense", 1, "", { randomTensor(rng, { 8, 1 }), randomTensor(rng, { 1 }) }));
+    }
+
+    return model;
+}
+
+template <typename Func>
+double timeNanosecondsPerSample(const std::vector<T>& signal, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    const auto start = clock_t::now();
+    for(const auto& x : signal)
+        process(x);
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)signal.size();
+}
+
+void printRow(const std::string& model, double ns)
+{
+    std::cout << std::left << std::setw(46) << model
+              << std::right << std::fixed << std::setprecision(1) << std::setw(12) << ns << std::endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_samples = 48000;
+    if(argc > 1)
+        n_samples = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::vector<T> signal(n_samples);
+    const auto signal_d = generate_signal(n_samples, 1);
+    for(size_t n = 0; n < n_samples; ++n)
+        signal[n] = (T)signal_d[n][0];
+
+    std::cout << "Multi-rate models, ns per sample (float, stride " << stride << "):" << std::endl;
+
+    const auto encoder_json = makeModelJson(false);
+    {
+        // every layer runs on every sample, holding the strided outputs in between
+        auto model = RTNeural::json_parser::parseJson<T>(encoder_json);
+        auto& layers = model->layers;
+        std::vector<std::vector<T>> outs;
+        for(auto* l : layers)
+            outs.emplace_back((size_t)l->out_size, (T)0);
+        model->reset();
+
+        const auto ns = timeNanosecondsPerSample(signal, [&](T x)
+            {
+                layers[0]->forward(&x, outs[0].data());
+                for(size_t i = 1; i < layers.size(); ++i)
+                    layers[i]->forward(outs[i - 1].data(), outs[i].data()); });
+        printRow("Encoder, every layer at the input rate", ns);
+    }
+
+    {
+        auto model = RTNeural::json_parser::parseJson<T>(encoder_json);
+        model->reset();
+        const auto ns = timeNanosecondsPerSample(signal, [&](T x)
+            { model->forward(&x); });
+        printRow("Encoder, Model", ns);
+    }
+
+    {
+        RTNeural::ModelT<T, 1, 16,
+            RTNeural::StridedConv1DT<T, 1, 16, 8, 1, stride>,
+            RTNeural::TanhActivationT<T, 16>,
+            RTNeural::GRULayerT<T, 16, 16>,
+            RTNeural::DenseT<T, 16, 16>>
+            model;
+        model.parseJson(encoder_json);
+        model.reset();
+        const auto ns = timeNanosecondsPerSample(signal, [&](T x)
+            { model.forward(&x); });
+        printRow("Encoder, ModelT", ns);
+    }
+
+    const auto encoder_decoder_json = makeModelJson(true);
+    {
+        auto model = RTNeural::json_parser::parseJson<T>(encoder_decoder_json);
+        model->reset();
+        const auto ns = timeNanosecondsPerSample(signal, [&](T x)
+            { model->forward(&x); });
+        printRow("Encoder/decoder, Model", ns);
+    }
+
+    {
+        RTNeural::ModelT<T, 1, 1,
+            RTNeural::StridedConv1DT<T, 1, 16, 8, 1, stride>,
+            RTNeural::TanhActivationT<T, 16>,
+            RTNeural::GRULayerT<T, 16, 16>,
+            RTNeural::DenseT<T, 16, 16>,
+            RTNeural::ConvTranspose1DT<T, 16, 8, 8, 1, stride>,
+            RTNeural::DenseT<T, 8, 1>>
+            model;
+        model.parseJson(encoder_decoder_json);
+        model.reset();
+        const auto ns = timeNanosecondsPerSample(signal, [&](T x)
+            { model.forward(&x); });
+        printRow("Encoder/decoder, ModelT", ns);
+    }
+
+    return 0;
+}
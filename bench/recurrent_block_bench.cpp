@@ -0,0 +1,139 @@
+#include "bench_utils.hpp"
+#include "layer_creator.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iostream>
+
+namespace
+{
+void help()
+{
+    std::cout << "RTNeural recurrent block benchmarks:" << std::endl;
+    std::cout << "Usage: rtneural_recurrent_block_bench <layer_type> <length> <hidden_size> <block_size>"
+              << std::endl;
+    std::cout << "    Supported layer types are gru and lstm, with hidden sizes 4, 8, 16, or 32."
+              << std::endl;
+}
+
+template <typename LayerType>
+void runBench(LayerType& layer, const std::vector<double>& signal, size_t block_size, double length_seconds)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using second_t = std::chrono::duration<double>;
+
+    const auto n_samples = signal.size();
+    std::vector<double> output(n_samples * LayerType::out_size);
+
+    double perSampleDur = 0.0;
+    {
+        layer.reset();
+        auto start = clock_t::now();
+        for(size_t i = 0; i < n_samples; ++i)
+        {
+#if RTNEURAL_USE_XSIMD
+            const xsimd::simd_type<double> x[1] { signal[i] };
+#elif RTNEURAL_USE_EIGEN
+            const Eigen::Matrix<double, 1, 1> x { signal[i] };
+#else
+            const double x[1] { signal[i] };
+#endif
+            layer.forward(x);
+        }
+        perSampleDur = std::chrono::duration_cast<second_t>(clock_t::now() - start).count();
+
+        std::cout << "Per-sample: processed " << length_seconds << " seconds of signal in "
+                  << perSampleDur << " seconds" << std::endl;
+        std::cout << length_seconds / perSampleDur << "x real-time" << std::endl;
+    }
+
+    double blockDur = 0.0;
+    {
+        layer.reset();
+        auto start = clock_t::now();
+        for(size_t i = 0; i < n_samples; i += block_size)
+        {
+            const auto samples_to_process = (int)std::min(block_size, n_samples - i);
+            layer.forwardBlock(&signal[i], &output[i * LayerType::out_size], samples_to_process);
+        }
+        blockDur = std::chrono::duration_cast<second_t>(clock_t::now() - start).count();
+
+        std::cout << "Block: processed " << length_seconds << " seconds of signal in "
+                  << blockDur << " seconds" << std::endl;
+        std::cout << length_seconds / blockDur << "x real-time" << std::endl;
+    }
+
+    std::cout << "Block processing is " << perSampleDur / blockDur << "x faster!" << std::endl;
+}
+
+template <int hidden_size>
+bool runLayerBench(const std::string& layer_type, const std::vector<double>& signal, size_t block_size, double length_seconds)
+{
+    if(layer_type == "gru")
+    {
+        RTNeural::GRULayerT<double, 1, hidden_size> layer;
+        randomise_gru(layer);
+        runBench(layer, signal, block_size, length_seconds);
+        return true;
+    }
+
+    if(layer_type == "lstm")
+    {
+        RTNeural::LSTMLayerT<double, 1, hidden_size> layer;
+        randomise_lstm(layer);
+        runBench(layer, signal, block_size, length_seconds);
+        return true;
+    }
+
+    std::cout << "Layer type not supported!" << std::endl;
+    return false;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    if(argc != 5)
+    {
+        help();
+        return 1;
+    }
+
+    const std::string layer_type = argv[1];
+    const auto length_seconds = std::atof(argv[2]);
+    const auto hidden_size = std::atol(argv[3]);
+    const auto block_size = (size_t)std::atol(argv[4]);
+    std::cout << "Benchmarking " << layer_type << " layer, with hidden size "
+              << hidden_size << " and block size " << block_size
+              << ", with signal length " << length_seconds << " seconds"
+              << std::endl;
+
+    if(block_size == 0)
+    {
+        help();
+        return 1;
+    }
+
+    // generate audio
+    constexpr double sample_rate = 48000.0;
+    const auto n_samples = static_cast<size_t>(sample_rate * length_seconds);
+    const auto signal_frames = generate_signal(n_samples, 1);
+    std::vector<double> signal(n_samples);
+    for(size_t i = 0; i < n_samples; ++i)
+        signal[i] = signal_frames[i][0];
+
+    bool success = false;
+    if(hidden_size == 4)
+        success = runLayerBench<4>(layer_type, signal, block_size, length_seconds);
+    else if(hidden_size == 8)
+        success = runLayerBench<8>(layer_type, signal, block_size, length_seconds);
+    else if(hidden_size == 16)
+        success = runLayerBench<16>(layer_type, signal, block_size, length_seconds);
+    else if(hidden_size == 32)
+        success = runLayerBench<32>(layer_type, signal, block_size, length_seconds);
+    else
+        std::cout << "Hidden size not supported!" << std::endl;
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,186 @@
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using T = float;
+
+// the fraction of non-zero weights (or weight blocks) to benchmark
+constexpr double densities[] = { 1.0, 0.5, 0.3, 0.2, 0.1, 0.05 };
+
+/**
+ * Returns a random weights matrix, with a given fraction of the
+ * weights left non-zero. The zeros are pruned in blocks of
+ * block_size consecutive columns, so that they line up with the
+ * SIMD-width blocks used by the templated layers.
+ */
+std::vector<std::vector<T>> prunedMatrix(int rows, int cols, double density, int block_size, std::default_random_engine& rng)
+{
+    std::uniform_real_distribution<T> values((T)-0.5, (T)0.5);
+    std::bernoulli_distribution keep(density);
+
+    std::vector<std::vector<T>> mat((size_t)rows, std::vector<T>((size_t)cols));
+    for(auto& row : mat)
+    {
+        for(int i = 0; i < cols; i += block_size)
+        {
+            const auto keep_block = keep(rng);
+            for(int j = i; j < std::min(i + block_size, cols); ++j)
+                row[(size_t)j] = keep_block ? values(rng) : (T)0;
+        }
+    }
+
+    return mat;
+}
+
+template <typename Func>
+double timeNanosecondsPerSample(size_t n_samples, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    const auto start = clock_t::now();
+    for(size_t n = 0; n < n_samples; ++n)
+        process(n);
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)n_samples;
+}
+
+void printRow(const std::string& layer, double density, double ns_per_sample, double dense_ns_per_sample)
+{
+    std::cout << std::left << std::setw(26) << layer
+              << std::right << std::setw(9) << std::fixed << std::setprecision(2) << density
+              << std::setw(12) << std::setprecision(1) << ns_per_sample
+              << std::setw(10) << std::setprecision(2) << dense_ns_per_sample / ns_per_sample << "x" << std::endl;
+}
+
+// Dense (dynamic) vs. the CSR SparseDense layer that the json loader picks for sparse weights.
+void benchDynamicDense(int in_size, int out_size, size_t n_samples)
+{
+    const auto signal = generate_signal(n_samples, (size_t)in_size);
+    std::vector<std::vector<T>> input(n_samples, std::vector<T>((size_t)in_size));
+    for(size_t n = 0; n < n_samples; ++n)
+        std::copy(signal[n].begin(), signal[n].end(), input[n].begin());
+    std::vector<T> output((size_t)out_size);
+
+    const auto name = std::to_string(in_size) + "x" + std::to_string(out_size);
+    std::default_random_engine rng;
+    double dense_ns_per_sample = 0.0;
+    for(auto density : densities)
+    {
+        const auto weights = prunedMatrix(out_size, in_size, density, 1, rng);
+
+        RTNeural::Dense<T> dense(in_size, out_size);
+        dense.setWeights(weights);
+        const auto dense_ns = timeNanosecondsPerSample(n_samples, [&](size_t n)
+            { dense.forward(input[n].data(), output.data()); });
+        if(density == 1.0)
+            dense_ns_per_sample = dense_ns;
+        printRow("Dense " + name, density, dense_ns, dense_ns_per_sample);
+
+        RTNeural::SparseDense<T> sparse(in_size, out_size);
+        sparse.setWeights(weights);
+        const auto sparse_ns = timeNanosecondsPerSample(n_samples, [&](size_t n)
+            { sparse.forward(input[n].data(), output.data()); });
+        printRow("SparseDense " + name, density, sparse_ns, dense_ns_per_sample);
+    }
+}
+
+template <int in_size, int out_size, bool block_sparse>
+void setPrunedWeights(RTNeural::DenseT<T, in_size, out_size, true, RTNeural::fused_activation::Identity, block_sparse>& layer,
+    double density, std::default_random_engine& rng)
+{
+    // prune the weights in blocks of consecutive outputs
+    const auto weightsT = prunedMatrix(in_size, out_size, density, 16, rng);
+    std::vector<std::vector<T>> weights((size_t)out_size, std::vector<T>((size_t)in_size));
+    for(size_t i = 0; i < (size_t)out_size; ++i)
+        for(size_t k = 0; k < (size_t)in_size; ++k)
+            weights[i][k] = weightsT[k][i];
+    layer.setWeights(weights);
+}
+
+template <int in_size, int out_size, bool block_sparse>
+void setPrunedWeights(RTNeural::GRULayerT<T, in_size, out_size, RTNeural::SampleRateCorrectionMode::None, RTNeural::DefaultMathsProvider, block_sparse>& layer,
+    double density, std::default_random_engine& rng)
+{
+    layer.setWVals(prunedMatrix(in_size, 3 * out_size, density, 16, rng));
+    layer.setUVals(prunedMatrix(out_size, 3 * out_size, density, 16, rng));
+    layer.setBVals(prunedMatrix(2, 3 * out_size, 1.0, 1, rng));
+}
+
+template <int in_size, int out_size, bool block_sparse>
+void setPrunedWeights(RTNeural::LSTMLayerT<T, in_size, out_size, RTNeural::SampleRateCorrectionMode::None, RTNeural::DefaultMathsProvider, block_sparse>& layer,
+    double density, std::default_random_engine& rng)
+{
+    layer.setWVals(prunedMatrix(in_size, 4 * out_size, density, 16, rng));
+    layer.setUVals(prunedMatrix(out_size, 4 * out_size, density, 16, rng));
+    layer.setBVals(prunedMatrix(1, 4 * out_size, 1.0, 1, rng)[0]);
+}
+
+template <typename LayerType>
+double timeTemplatedLayer(const std::vector<vec_type>& signal, double density, size_t n_samples, std::default_random_engine& rng)
+{
+    using ModelType = RTNeural::ModelT<T, LayerType::in_size, LayerType::out_size, LayerType>;
+
+    ModelType model;
+    setPrunedWeights(model.template get<0>(), density, rng);
+    model.reset();
+
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(LayerType::in_size, 16) * 16] {};
+    return timeNanosecondsPerSample(n_samples, [&](size_t n)
+        {
+            std::copy(signal[n].begin(), signal[n].end(), x);
+            model.forward(x); });
+}
+
+// Templated layers vs. their block-sparse versions, which skip the zero SIMD-width blocks when enough of the weights are pruned.
+template <typename DenseLayerType, typename SparseLayerType>
+void benchTemplatedLayer(const std::string& name, size_t n_samples)
+{
+    const auto signal = generate_signal(n_samples, (size_t)DenseLayerType::in_size);
+
+    std::default_random_engine rng;
+    double dense_ns_per_sample = 0.0;
+    for(auto density : densities)
+    {
+        const auto dense_ns = timeTemplatedLayer<DenseLayerType>(signal, density, n_samples, rng);
+        if(density == 1.0)
+            dense_ns_per_sample = dense_ns;
+        printRow(name, density, dense_ns, dense_ns_per_sample);
+
+        const auto sparse_ns = timeTemplatedLayer<SparseLayerType>(signal, density, n_samples, rng);
+        printRow(name + " sparse", density, sparse_ns, dense_ns_per_sample);
+    }
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_samples = 48000;
+    if(argc > 1)
+        n_samples = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "Speedup of the sparse layers vs. the fully dense weights (float):" << std::endl;
+    std::cout << std::left << std::setw(26) << "layer"
+              << std::right << std::setw(9) << "density" << std::setw(12) << "ns/sample"
+              << std::setw(11) << "speedup" << std::endl;
+
+    benchDynamicDense(64, 64, n_samples);
+    benchDynamicDense(256, 128, n_samples);
+
+    using namespace RTNeural;
+    using Identity = fused_activation::Identity;
+    constexpr auto noCorrection = SampleRateCorrectionMode::None;
+    benchTemplatedLayer<DenseT<T, 64, 64>, DenseT<T, 64, 64, true, Identity, true>>("DenseT 64x64", n_samples);
+    benchTemplatedLayer<DenseT<T, 128, 64>, DenseT<T, 128, 64, true, Identity, true>>("DenseT 128x64", n_samples);
+    benchTemplatedLayer<GRULayerT<T, 16, 64>, GRULayerT<T, 16, 64, noCorrection, DefaultMathsProvider, true>>("GRULayerT 16x64", n_samples);
+    benchTemplatedLayer<LSTMLayerT<T, 16, 64>, LSTMLayerT<T, 16, 64, noCorrection, DefaultMathsProvider, true>>("LSTMLayerT 16x64", n_samples);
+
+    return 0;
+}
@@ -0,0 +1,137 @@
+#include "../tests/functional/test_helpers.hpp"
+#include "bench_utils.hpp"
+#include <RTNeural.h>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+namespace
+{
+using namespace test_helpers;
+
+using T = float;
+
+template <typename Func>
+double timeNanosecondsPerSample(const std::vector<vec_type>& signal, Func&& process)
+{
+    using clock_t = std::chrono::high_resolution_clock;
+    using nanosecond_t = std::chrono::duration<double, std::nano>;
+
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[64] {};
+    const auto start = clock_t::now();
+    for(const auto& frame : signal)
+    {
+        std::copy(frame.begin(), frame.end(), x);
+        process(x);
+    }
+    return std::chrono::duration_cast<nanosecond_t>(clock_t::now() - start).count() / (double)signal.size();
+}
+
+/**
+ * Benchmarks a TCN block, computed as a chain of separate layers:
+ * `prelu(batchnorm(conv(x))) + residual(x)`, and as a single TCNBlockT.
+ */
+template <int in_size, int out_size, int kernel_size, int dilation, int residual_groups>
+void benchTCNBlock(size_t n_samples)
+{
+    std::default_random_engine rng;
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto gamma = randomVector<T>(rng, (size_t)out_size, (T)0.5, (T)1.5);
+    const auto beta = randomVector<T>(rng, (size_t)out_size);
+    const auto mean = randomVector<T>(rng, (size_t)out_size);
+    const auto variance = randomVector<T>(rng, (size_t)out_size, (T)0.5, (T)2);
+    const auto alpha = randomVector<T>(rng, (size_t)out_size, (T)0, (T)0.5);
+    std::vector<std::vector<T>> res_weights;
+    std::vector<std::vector<std::vector<T>>> res_conv_weights;
+    for(int i = 0; i < out_size; ++i)
+    {
+        res_weights.push_back(randomVector<T>(rng, (size_t)(in_size / residual_groups)));
+        res_conv_weights.emplace_back();
+        for(const auto& w : res_weights.back())
+            res_conv_weights.back().push_back({ w });
+    }
+    const T epsilon = (T)1.0e-5;
+
+    const auto signal = generate_signal(n_samples, (size_t)in_size);
+    const auto name = std::to_string(in_size) + " -> " + std::to_string(out_size)
+        + ", k" + std::to_string(kernel_size) + ", d" + std::to_string(dilation)
+        + ", residual groups " + std::to_string(residual_groups);
+
+    double unfused_ns, fused_ns;
+    {
+        RTNeural::ModelT<T, in_size, out_size,
+            RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation>,
+            RTNeural::BatchNorm1DT<T, out_size>,
+            RTNeural::PReLUActivationT<T, out_size>>
+            model;
+        model.template get<0>().setWeights(weights);
+        model.template get<0>().setBias(bias);
+        model.template get<1>().setGamma(gamma);
+        model.template get<1>().setBeta(beta);
+        model.template get<1>().setRunningMean(mean);
+        model.template get<1>().setRunningVariance(variance);
+        model.template get<1>().setEpsilon(epsilon);
+        model.template get<2>().setAlphaVals(alpha);
+        model.reset();
+
+        RTNeural::ModelT<T, in_size, out_size,
+            RTNeural::Conv1DT<T, in_size, out_size, 1, 1, residual_groups>>
+            residual;
+        residual.template get<0>().setWeights(res_conv_weights);
+        residual.template get<0>().setBias(std::vector<T>((size_t)out_size, (T)0));
+        residual.reset();
+
+        T y alignas(RTNEURAL_DEFAULT_ALIGNMENT)[out_size];
+        unfused_ns = timeNanosecondsPerSample(signal, [&](const T* x)
+            {
+                model.forward(x);
+                residual.forward(x);
+                for(int i = 0; i < out_size; ++i)
+                    y[i] = model.getOutputs()[i] + residual.getOutputs()[i]; });
+    }
+
+    {
+        RTNeural::ModelT<T, in_size, out_size,
+            RTNeural::TCNBlockT<T, in_size, out_size, kernel_size, dilation, residual_groups>>
+            model;
+        auto& block = model.template get<0>();
+        block.setWeights(weights);
+        block.setBias(bias);
+        block.setBatchNorm(gamma, beta, mean, variance, epsilon);
+        block.setAlphaVals(alpha);
+        block.setResidualWeights(res_weights);
+        model.reset();
+
+        fused_ns = timeNanosecondsPerSample(signal, [&](const T* x)
+            { model.forward(x); });
+    }
+
+    std::cout << std::left << std::setw(46) << name
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(12) << unfused_ns << std::setw(12) << fused_ns << std::endl;
+}
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    if(!check_cpu_support())
+        return 0;
+
+    size_t n_samples = 48000;
+    if(argc > 1)
+        n_samples = (size_t)std::max(1, std::atoi(argv[1]));
+
+    std::cout << "TCN blocks, ns per sample (float):" << std::endl;
+    std::cout << std::left << std::setw(46) << "Block"
+              << std::right << std::setw(12) << "Unfused" << std::setw(12) << "TCNBlockT" << std::endl;
+
+    // the MicroTCN block from models/microtcn/, and deeper blocks of a MicroTCN stack
+    benchTCNBlock<1, 32, 4, 10, 1>(n_samples);
+    benchTCNBlock<32, 32, 3, 2, 1>(n_samples);
+    benchTCNBlock<32, 32, 3, 10, 32>(n_samples);
+    benchTCNBlock<16, 16, 3, 4, 16>(n_samples);
+
+    return 0;
+}
@@ -18,7 +18,7 @@ double runTemplatedBench(const std::vector<vec_type>& signal, const size_t n_sam
     {
         auto start = clock_t::now();
         for(size_t i = 0; i < n_samples; ++i)
-            layer.forward(signal[i].data());
+            layer.forward(signal[i % signal.size()].data());
         return std::chrono::duration_cast<second_t>(clock_t::now() - start).count();
     };
 
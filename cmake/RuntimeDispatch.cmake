@@ -0,0 +1,108 @@
+option(RTNEURAL_RUNTIME_DISPATCH "Build RTNeural for multiple SIMD instruction sets, selected at runtime" OFF)
+
+# The instruction sets that RTNeural is compiled for when runtime dispatch is enabled.
+# Each one is compiled into its own namespace (e.g. RTNeural_avx2), and linked into
+# its own shared module (see rtneural_add_dispatch_library()).
+set(RTNEURAL_DISPATCH_ARCHS default sse4_1 avx2 avx512)
+set(RTNEURAL_DISPATCH_SOURCE_DIR ${CMAKE_CURRENT_LIST_DIR}/../RTNeural)
+
+function(rtneural_add_dispatch_arch arch)
+    set(arch_flags "")
+    set(arch_definitions RTNEURAL_DEFAULT_ALIGNMENT=16)
+    if(arch STREQUAL "sse4_1")
+        if(NOT MSVC) # MSVC has no flag for SSE4.1, but will use it with SSE2 enabled
+            set(arch_flags -msse4.1)
+        endif()
+        set(arch_definitions RTNEURAL_SSE4_1_ENABLED=1 RTNEURAL_DEFAULT_ALIGNMENT=16)
+    elseif(arch STREQUAL "avx2")
+        if(MSVC)
+            set(arch_flags /arch:AVX2)
+        else()
+            set(arch_flags -mavx2 -mfma)
+        endif()
+        set(arch_definitions RTNEURAL_AVX_ENABLED=1 RTNEURAL_DEFAULT_ALIGNMENT=32)
+    elseif(arch STREQUAL "avx512")
+        if(MSVC)
+            set(arch_flags /arch:AVX512)
+        else()
+            set(arch_flags -mavx512f -mavx512bw -mavx512dq -mavx512vl -mavx2 -mfma)
+        endif()
+        set(arch_definitions RTNEURAL_AVX_ENABLED=1 RTNEURAL_AVX512_ENABLED=1 RTNEURAL_DEFAULT_ALIGNMENT=64)
+    endif()
+
+    if(arch_flags)
+        string(REPLACE ";" " " arch_flags_string "${arch_flags}")
+        CHECK_CXX_COMPILER_FLAG("${arch_flags_string}" RTNEURAL_DISPATCH_${arch}_SUPPORTED)
+        if(NOT RTNEURAL_DISPATCH_${arch}_SUPPORTED)
+            # keep the namespace, so that the set of dispatch symbols doesn't change
+            message(STATUS "RTNeural -- Unable to enable ${arch} flags for ${CMAKE_CXX_COMPILER_ID} compiler! Using default flags instead...")
+            set(arch_flags "")
+            set(arch_definitions RTNEURAL_DEFAULT_ALIGNMENT=16)
+        endif()
+    endif()
+
+    set(target RTNeural_${arch})
+    add_library(${target} STATIC ${RTNEURAL_DISPATCH_SOURCE_DIR}/RTNeural.cpp)
+    set_target_properties(${target} PROPERTIES
+        POSITION_INDEPENDENT_CODE ON
+        CXX_VISIBILITY_PRESET hidden
+        VISIBILITY_INLINES_HIDDEN ON)
+    target_include_directories(${target} PUBLIC $<TARGET_PROPERTY:RTNeural,INTERFACE_INCLUDE_DIRECTORIES>)
+    target_compile_definitions(${target}
+        PUBLIC
+            RTNEURAL_USE_XSIMD=1
+            RTNEURAL_NAMESPACE=${RTNEURAL_NAMESPACE}_${arch}
+            ${arch_definitions}
+    )
+    target_compile_options(${target} PUBLIC ${arch_flags})
+endfunction()
+
+# Compiles the given sources once for each of the RTNEURAL_DISPATCH_ARCHS, and
+# links each build into its own shared module (<target>_<arch>), which can be
+# loaded at runtime with RTNeural::DispatchModule (see RTNeural/dispatch_module.h).
+# The modules only export their entry points (see RTNEURAL_DISPATCH_EXPORT), and
+# bind every other symbol (including the inline code from the standard library,
+# xsimd, etc.) to their own copy, so that code compiled for one instruction set
+# can never be called from the code path for another one. The <target> library
+# links the modules' loader dependencies into the code that uses them.
+#
+# rtneural_add_dispatch_library(TARGET <target> SOURCES <sources>...)
+function(rtneural_add_dispatch_library)
+    set(one_val_args TARGET)
+    set(multi_val_args SOURCES)
+    cmake_parse_arguments(arg "" "${one_val_args}" "${multi_val_args}" ${ARGN})
+
+    set(version_script ${CMAKE_CURRENT_BINARY_DIR}/${arg_TARGET}.map)
+    file(WRITE ${version_script} "{ global: *\; local: _Z*\; }\;\n")
+
+    add_library(${arg_TARGET} INTERFACE)
+    target_link_libraries(${arg_TARGET} INTERFACE RTNeural ${CMAKE_DL_LIBS})
+
+    foreach(arch IN LISTS RTNEURAL_DISPATCH_ARCHS)
+        set(arch_target ${arg_TARGET}_${arch})
+        add_library(${arch_target} MODULE ${arg_SOURCES})
+        set_target_properties(${arch_target} PROPERTIES
+            PREFIX ""
+            CXX_VISIBILITY_PRESET hidden
+            VISIBILITY_INLINES_HIDDEN ON)
+        target_link_libraries(${arch_target} PRIVATE RTNeural_${arch})
+
+        if(UNIX AND NOT APPLE)
+            # the standard library gives its templates default visibility, so
+            # the C++ symbols are also made local when the module is linked
+            target_link_libraries(${arch_target} PRIVATE -Wl,--version-script=${version_script})
+        endif()
+    endforeach()
+endfunction()
+
+if(RTNEURAL_RUNTIME_DISPATCH)
+    if(NOT RTNEURAL_XSIMD)
+        message(FATAL_ERROR "RTNeural -- Runtime dispatch is only supported with the xsimd backend!")
+    endif()
+
+    message(STATUS "RTNeural -- Configuring runtime dispatch for: ${RTNEURAL_DISPATCH_ARCHS}")
+    include(CheckCXXCompilerFlag)
+    foreach(arch IN LISTS RTNEURAL_DISPATCH_ARCHS)
+        rtneural_add_dispatch_arch(${arch})
+    endforeach()
+endif()
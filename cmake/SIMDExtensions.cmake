@@ -1,5 +1,41 @@
 option(RTNEURAL_USE_AVX "Enables AVX SIMD Support" OFF)
-if(NOT RTNEURAL_USE_AVX)
+option(RTNEURAL_USE_AVX512 "Enables AVX-512 SIMD Support" OFF)
+
+set(RTNEURAL_SIMD_FLAGS_ENABLED OFF)
+include(CheckCXXCompilerFlag)
+
+if(RTNEURAL_USE_AVX512)
+    message(STATUS "RTNeural -- Attempting to enable AVX-512...")
+
+    if(MSVC)
+        CHECK_CXX_COMPILER_FLAG("/arch:AVX512" COMPILER_OPT_ARCH_AVX512_SUPPORTED)
+        if(COMPILER_OPT_ARCH_AVX512_SUPPORTED)
+            message(STATUS "RTNeural -- AVX-512 flags enabled for MSVC compiler!")
+            target_compile_options(RTNeural PUBLIC /arch:AVX512)
+            set(RTNEURAL_SIMD_FLAGS_ENABLED ON)
+        endif()
+    else()
+        CHECK_CXX_COMPILER_FLAG("-mavx512f -mavx512bw -mavx512dq -mavx512vl -mavx2 -mfma" COMPILER_OPT_ARCH_AVX512_SUPPORTED)
+        if(COMPILER_OPT_ARCH_AVX512_SUPPORTED)
+            message(STATUS "RTNeural -- AVX-512 flags enabled for ${CMAKE_CXX_COMPILER_ID} compiler!")
+            target_compile_options(RTNeural PUBLIC -mavx512f -mavx512bw -mavx512dq -mavx512vl -mavx2 -mfma)
+            set(RTNEURAL_SIMD_FLAGS_ENABLED ON)
+        endif()
+    endif()
+
+    if(RTNEURAL_SIMD_FLAGS_ENABLED)
+        target_compile_definitions(RTNeural PUBLIC RTNEURAL_AVX_ENABLED=1)
+        target_compile_definitions(RTNeural PUBLIC RTNEURAL_AVX512_ENABLED=1)
+        target_compile_definitions(RTNeural PUBLIC RTNEURAL_DEFAULT_ALIGNMENT=64)
+    else()
+        message(STATUS "RTNeural -- Unable to add AVX-512 flags for ${CMAKE_CXX_COMPILER_ID} compiler! Trying AVX2 instead...")
+        set(RTNEURAL_USE_AVX ON)
+    endif()
+endif()
+
+if(RTNEURAL_SIMD_FLAGS_ENABLED)
+    # AVX-512 flags have already been enabled
+elseif(NOT RTNEURAL_USE_AVX)
     if(CMAKE_SYSTEM_PROCESSOR MATCHES "armv7")
         target_compile_definitions(RTNeural PUBLIC RTNEURAL_DEFAULT_ALIGNMENT=8)
     else()
@@ -8,7 +44,6 @@ if(NOT RTNEURAL_USE_AVX)
 else()
     message(STATUS "RTNeural -- Attempting to enable AVX...")
 
-    include(CheckCXXCompilerFlag)
     if(MSVC)
         CHECK_CXX_COMPILER_FLAG("/arch:AVX2" COMPILER_OPT_ARCH_AVX_SUPPORTED)
         if(COMPILER_OPT_ARCH_AVX_SUPPORTED)
@@ -24,6 +24,10 @@ def save_model_json(model, layers_to_skip=(keras.layers.InputLayer)):
         if isinstance(layer, keras.layers.Dense):
             return 'dense'
 
+        # Conv1DTranspose is a subclass of Conv1D, so it needs to be checked first
+        if isinstance(layer, keras.layers.Conv1DTranspose):
+            return 'convtranspose1d'
+
         if isinstance(layer, keras.layers.Conv1D):
             return 'conv1d'
 
@@ -89,6 +93,12 @@ def save_model_json(model, layers_to_skip=(keras.layers.InputLayer)):
             layer_dict["kernel_size"] = layer.kernel_size
             layer_dict["dilation"] = layer.dilation_rate
             layer_dict["groups"] = layer.groups
+            layer_dict["strides"] = layer.strides
+
+        if layer_dict["type"] == "convtranspose1d":
+            layer_dict["kernel_size"] = layer.kernel_size
+            layer_dict["dilation"] = layer.dilation_rate
+            layer_dict["strides"] = layer.strides
 
         if layer_dict["type"] == "conv2d":
             layer_dict["kernel_size_time"] = layer.kernel_size[0]
@@ -0,0 +1,26 @@
+#pragma once
+
+#include <RTNeural/cpu_features.h>
+#include <gtest/gtest.h>
+
+/**
+ * When RTNeural is compiled for a SIMD instruction set that the host CPU
+ * does not support (e.g. with RTNEURAL_USE_AVX512 on a machine without
+ * AVX-512), running the tests would crash with an illegal instruction.
+ * This environment checks for CPU support at runtime, and skips all of
+ * the tests if the compiled instruction set is not supported.
+ *
+ * This header should be included in exactly one source file per test executable.
+ */
+class CPUSupportEnvironment : public testing::Environment
+{
+public:
+    void SetUp() override
+    {
+        if(!RTNeural::isCompiledArchSupported())
+            GTEST_SKIP() << "RTNeural was compiled for " << RTNeural::getCompiledArchName()
+                         << ", which is not supported by this CPU. Skipping tests...";
+    }
+};
+
+static testing::Environment* const cpuSupportEnvironment = testing::AddGlobalTestEnvironment(new CPUSupportEnvironment);
@@ -0,0 +1,123 @@
+#include <gmock/gmock.h>
+
+#include "../functional/load_csv.hpp"
+#include "../functional/test_configs.hpp"
+#include <RTNeural/RTNeural.h>
+#include <RTNeural/dispatch_module.h>
+#include <algorithm>
+#include <memory>
+
+namespace
+{
+constexpr RTNeural::SIMDArch allArchs[] = {
+    RTNeural::SIMDArch::Default,
+    RTNeural::SIMDArch::SSE4_1,
+    RTNeural::SIMDArch::AVX2,
+    RTNeural::SIMDArch::AVX512,
+};
+
+/** The entry points of the dispatch test module compiled for one instruction set. */
+struct DispatchTestModel
+{
+    explicit DispatchTestModel(RTNeural::SIMDArch arch)
+        : module(DISPATCH_MODULE_DIR, "rtneural_test_dispatch_models", arch)
+        , getArchName(module.getFunction<const char*()>("rtneural_dispatch_test_arch_name"))
+        , processStaticModel(module.getFunction<ProcessFunction>("rtneural_dispatch_test_process_static"))
+        , processDynamicModel(module.getFunction<ProcessFunction>("rtneural_dispatch_test_process_dynamic"))
+    {
+    }
+
+    using ProcessFunction = void(const char*, const double*, double*, int);
+
+    RTNeural::DispatchModule module;
+    const char* (*getArchName)();
+    ProcessFunction* processStaticModel;
+    ProcessFunction* processDynamicModel;
+};
+
+void runDispatchTest(RTNeural::SIMDArch arch)
+{
+    if(!RTNeural::isArchSupported(arch))
+    {
+        EXPECT_FALSE(RTNeural::DispatchModule(DISPATCH_MODULE_DIR, "rtneural_test_dispatch_models", arch).isLoaded());
+        GTEST_SKIP() << RTNeural::getArchName(arch) << " is not supported by this CPU!";
+    }
+
+    // load every module that the CPU supports, so that the code paths for
+    // several instruction sets are live in the process at the same time
+    std::vector<std::unique_ptr<DispatchTestModel>> models;
+    for(auto a : allArchs)
+    {
+        if(RTNeural::isArchSupported(a))
+            models.emplace_back(new DispatchTestModel { a });
+    }
+
+    const auto& model = **std::find_if(models.begin(), models.end(), [arch](const std::unique_ptr<DispatchTestModel>& m)
+        { return m->module.getArch() == arch; });
+    ASSERT_TRUE(model.module.isLoaded());
+    ASSERT_NE(model.getArchName, nullptr);
+    ASSERT_NE(model.processStaticModel, nullptr);
+    ASSERT_NE(model.processDynamicModel, nullptr);
+
+    // the forced code path should be the one compiled for this instruction set
+    // (unless the compiler didn't support the flags for it, in which case the default flags are used)
+    EXPECT_THAT(model.getArchName(), testing::AnyOf(testing::StrEq(RTNeural::getArchName(arch)), testing::StrEq("default")));
+
+    const auto& test = tests.at("gru");
+
+    std::ifstream pythonX(std::string { RTNEURAL_ROOT_DIR } + test.x_data_file);
+    const auto xData = load_csv::loadFile<double>(pythonX);
+
+    std::ifstream pythonY(std::string { RTNEURAL_ROOT_DIR } + test.y_data_file);
+    const auto yRefData = load_csv::loadFile<double>(pythonY);
+
+    const auto model_file = std::string { RTNEURAL_ROOT_DIR } + test.model_file;
+    std::vector<double> yDataStatic(xData.size());
+    std::vector<double> yDataDynamic(xData.size());
+    model.processStaticModel(model_file.c_str(), xData.data(), yDataStatic.data(), (int)xData.size());
+    model.processDynamicModel(model_file.c_str(), xData.data(), yDataDynamic.data(), (int)xData.size());
+
+    using namespace testing;
+    EXPECT_THAT(yDataStatic, Pointwise(DoubleNear(test.threshold), yRefData));
+    EXPECT_THAT(yDataDynamic, Pointwise(DoubleNear(test.threshold), yRefData));
+}
+} // namespace
+
+TEST(TestRuntimeDispatch, bestSupportedArchIsSupported)
+{
+    const auto arch = RTNeural::getBestSupportedArch();
+    EXPECT_TRUE(RTNeural::isArchSupported(arch));
+
+    const DispatchTestModel model { arch };
+    ASSERT_TRUE(model.module.isLoaded());
+    std::cout << "Selected instruction set: " << model.getArchName() << std::endl;
+}
+
+TEST(TestRuntimeDispatch, modulesOnlyExportEntryPoints)
+{
+    const DispatchTestModel model { RTNeural::SIMDArch::Default };
+    ASSERT_TRUE(model.module.isLoaded());
+
+    // the code compiled for one instruction set must not be visible to the others
+    EXPECT_EQ(model.module.getFunction<void()>("_ZN16RTNeural_default13dispatch_test18processStaticModelEPKcPKdPdi"), nullptr);
+}
+
+TEST(TestRuntimeDispatch, defaultPathMatchesPythonImplementation)
+{
+    runDispatchTest(RTNeural::SIMDArch::Default);
+}
+
+TEST(TestRuntimeDispatch, sse4_1PathMatchesPythonImplementation)
+{
+    runDispatchTest(RTNeural::SIMDArch::SSE4_1);
+}
+
+TEST(TestRuntimeDispatch, avx2PathMatchesPythonImplementation)
+{
+    runDispatchTest(RTNeural::SIMDArch::AVX2);
+}
+
+TEST(TestRuntimeDispatch, avx512PathMatchesPythonImplementation)
+{
+    runDispatchTest(RTNeural::SIMDArch::AVX512);
+}
@@ -0,0 +1,60 @@
+#include <RTNeural/RTNeural.h>
+
+// This file is compiled into one module for each instruction set in RTNEURAL_DISPATCH_ARCHS,
+// so each of these functions gets compiled in every one of the RTNeural_<arch> namespaces,
+// and is loaded at runtime through the entry points below.
+namespace RTNEURAL_NAMESPACE
+{
+namespace dispatch_test
+{
+    void processStaticModel(const char* model_file, const double* input, double* output, int num_samples)
+    {
+        ModelT<double, 1, 1,
+            DenseT<double, 1, 8>,
+            TanhActivationT<double, 8>,
+            GRULayerT<double, 8, 8>,
+            DenseT<double, 8, 8>,
+            SigmoidActivationT<double, 8>,
+            DenseT<double, 8, 1>>
+            model;
+
+        std::ifstream jsonStream(model_file, std::ifstream::binary);
+        model.parseJson(jsonStream);
+        model.reset();
+
+        for(int n = 0; n < num_samples; ++n)
+        {
+            const double x[] = { input[n] };
+            output[n] = model.forward(x);
+        }
+    }
+
+    void processDynamicModel(const char* model_file, const double* input, double* output, int num_samples)
+    {
+        std::ifstream jsonStream(model_file, std::ifstream::binary);
+        auto model = json_parser::parseJson<double>(jsonStream);
+        model->reset();
+
+        for(int n = 0; n < num_samples; ++n)
+        {
+            const double x[] = { input[n] };
+            output[n] = model->forward(x);
+        }
+    }
+} // namespace dispatch_test
+} // namespace RTNEURAL_NAMESPACE
+
+RTNEURAL_DISPATCH_EXPORT const char* rtneural_dispatch_test_arch_name()
+{
+    return RTNEURAL_NAMESPACE::getCompiledArchName();
+}
+
+RTNEURAL_DISPATCH_EXPORT void rtneural_dispatch_test_process_static(const char* model_file, const double* input, double* output, int num_samples)
+{
+    RTNEURAL_NAMESPACE::dispatch_test::processStaticModel(model_file, input, output, num_samples);
+}
+
+RTNEURAL_DISPATCH_EXPORT void rtneural_dispatch_test_process_dynamic(const char* model_file, const double* input, double* output, int num_samples)
+{
+    RTNEURAL_NAMESPACE::dispatch_test::processDynamicModel(model_file, input, output, num_samples);
+}
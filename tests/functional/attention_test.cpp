@@ -0,0 +1,397 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <cmath>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 40;
+
+using Matrix = std::vector<std::vector<float>>;
+
+std::vector<float> affine(const Matrix& weights, const std::vector<float>& bias, const std::vector<float>& x)
+{
+    std::vector<float> y = bias;
+    for(size_t i = 0; i < weights.size(); ++i)
+        for(size_t j = 0; j < x.size(); ++j)
+            y[i] += weights[i][j] * x[j];
+    return y;
+}
+
+std::vector<float> layerNorm(const std::vector<float>& x, const std::vector<float>& gamma, const std::vector<float>& beta, float epsilon, bool rms)
+{
+    double mean = 0.0;
+    if(!rms)
+    {
+        for(auto v : x)
+            mean += v;
+        mean /= (double)x.size();
+    }
+
+    double variance = 0.0;
+    for(auto v : x)
+        variance += (v - mean) * (v - mean);
+    variance /= (double)x.size();
+
+    std::vector<float> y(x.size());
+    for(size_t i = 0; i < x.size(); ++i)
+        y[i] = float((x[i] - mean) / std::sqrt(variance + epsilon)) * gamma[i] + (rms ? 0.0f : beta[i]);
+    return y;
+}
+
+/** A naive causal attention layer, which keeps every input frame. */
+struct ReferenceAttention
+{
+    ReferenceAttention(int embed_dim, int num_heads, int context_length, std::mt19937& rng)
+        : embed_dim(embed_dim)
+        , num_heads(num_heads)
+        , context_length(context_length)
+        , in_weights(randomMatrix(rng, 3 * embed_dim, embed_dim))
+        , in_bias(randomVector(rng, 3 * embed_dim))
+        , out_weights(randomMatrix(rng, embed_dim, embed_dim))
+        , out_bias(randomVector(rng, embed_dim))
+    {
+    }
+
+    std::vector<float> process(const std::vector<float>& x)
+    {
+        const auto qkv = affine(in_weights, in_bias, x);
+        keys.emplace_back(qkv.begin() + embed_dim, qkv.begin() + 2 * embed_dim);
+        values.emplace_back(qkv.begin() + 2 * embed_dim, qkv.end());
+
+        const auto head_dim = embed_dim / num_heads;
+        const auto first = (int)keys.size() > context_length ? keys.size() - (size_t)context_length : 0;
+        std::vector<float> heads((size_t)embed_dim, 0.0f);
+        for(int h = 0; h < num_heads; ++h)
+        {
+            std::vector<double> scores;
+            for(size_t t = first; t < keys.size(); ++t)
+            {
+                double score = 0.0;
+                for(int i = h * head_dim; i < (h + 1) * head_dim; ++i)
+                    score += qkv[(size_t)i] * keys[t][(size_t)i];
+                scores.push_back(score / std::sqrt((double)head_dim));
+            }
+
+            const auto max_score = *std::max_element(scores.begin(), scores.end());
+            double exp_sum = 0.0;
+            for(auto& s : scores)
+            {
+                s = std::exp(s - max_score);
+                exp_sum += s;
+            }
+
+            for(size_t t = first; t < keys.size(); ++t)
+                for(int i = h * head_dim; i < (h + 1) * head_dim; ++i)
+                    heads[(size_t)i] += float(scores[t - first] / exp_sum) * values[t][(size_t)i];
+        }
+
+        return affine(out_weights, out_bias, heads);
+    }
+
+    nlohmann::json toJson() const
+    {
+        nlohmann::json layer;
+        layer["type"] = "attention";
+        layer["shape"] = { nullptr, nullptr, embed_dim };
+        layer["num_heads"] = num_heads;
+        layer["context_length"] = context_length;
+        layer["weights"] = { transpose(in_weights), in_bias, transpose(out_weights), out_bias };
+        return layer;
+    }
+
+    int embed_dim, num_heads, context_length;
+    Matrix in_weights;
+    std::vector<float> in_bias;
+    Matrix out_weights;
+    std::vector<float> out_bias;
+    Frames keys, values;
+};
+
+/** A naive transformer encoder block, exported as a PyTorch TransformerEncoderLayer state_dict. */
+struct ReferenceTransformer
+{
+    ReferenceTransformer(int embed_dim, int num_heads, int ff_dim, int context_length, bool norm_first, bool rms_norm, std::mt19937& rng)
+        : attention(embed_dim, num_heads, context_length, rng)
+        , norm_first(norm_first)
+        , rms_norm(rms_norm)
+        , ff1_weights(randomMatrix(rng, ff_dim, embed_dim))
+        , ff1_bias(randomVector(rng, ff_dim))
+        , ff2_weights(randomMatrix(rng, embed_dim, ff_dim))
+        , ff2_bias(randomVector(rng, embed_dim))
+        , norm1_gamma(randomVector(rng, embed_dim, 0.5f, 1.5f))
+        , norm1_beta(randomVector(rng, embed_dim))
+        , norm2_gamma(randomVector(rng, embed_dim, 0.5f, 1.5f))
+        , norm2_beta(randomVector(rng, embed_dim))
+    {
+    }
+
+    std::vector<float> feedForward(const std::vector<float>& x) const
+    {
+        auto f = affine(ff1_weights, ff1_bias, x);
+        for(auto& v : f)
+            v = std::max(v, 0.0f);
+        return affine(ff2_weights, ff2_bias, f);
+    }
+
+    std::vector<float> process(const std::vector<float>& x)
+    {
+        const auto add = [](std::vector<float> a, const std::vector<float>& b)
+        {
+            for(size_t i = 0; i < a.size(); ++i)
+                a[i] += b[i];
+            return a;
+        };
+
+        if(norm_first)
+        {
+            const auto h = add(x, attention.process(layerNorm(x, norm1_gamma, norm1_beta, epsilon, rms_norm)));
+            return add(h, feedForward(layerNorm(h, norm2_gamma, norm2_beta, epsilon, rms_norm)));
+        }
+
+        const auto h = layerNorm(add(x, attention.process(x)), norm1_gamma, norm1_beta, epsilon, rms_norm);
+        return layerNorm(add(h, feedForward(h)), norm2_gamma, norm2_beta, epsilon, rms_norm);
+    }
+
+    nlohmann::json toStateDict(const std::string& prefix) const
+    {
+        nlohmann::json state;
+        state[prefix + "self_attn.in_proj_weight"] = attention.in_weights;
+        state[prefix + "self_attn.in_proj_bias"] = attention.in_bias;
+        state[prefix + "self_attn.out_proj.weight"] = attention.out_weights;
+        state[prefix + "self_attn.out_proj.bias"] = attention.out_bias;
+        state[prefix + "linear1.weight"] = ff1_weights;
+        state[prefix + "linear1.bias"] = ff1_bias;
+        state[prefix + "linear2.weight"] = ff2_weights;
+        state[prefix + "linear2.bias"] = ff2_bias;
+        state[prefix + "norm1.weight"] = norm1_gamma;
+        state[prefix + "norm2.weight"] = norm2_gamma;
+        if(!rms_norm)
+        {
+            state[prefix + "norm1.bias"] = norm1_beta;
+            state[prefix + "norm2.bias"] = norm2_beta;
+        }
+        return state;
+    }
+
+    ReferenceAttention attention;
+    bool norm_first, rms_norm;
+    float epsilon = 1.0e-5f;
+    Matrix ff1_weights;
+    std::vector<float> ff1_bias;
+    Matrix ff2_weights;
+    std::vector<float> ff2_bias;
+    std::vector<float> norm1_gamma, norm1_beta, norm2_gamma, norm2_beta;
+};
+
+} // namespace
+
+TEST(TestAttention, LayerNormMatchesReference)
+{
+    constexpr int size = 7;
+    std::mt19937 rng { 0x1234 };
+    const auto gamma = randomVector(rng, size, 0.5f, 1.5f);
+    const auto beta = randomVector(rng, size);
+    const auto inputs = makeInputs(num_samples, size, 0x5eed);
+
+    RTNeural::LayerNorm<float> layer_norm(size);
+    layer_norm.setGamma(gamma);
+    layer_norm.setBeta(beta);
+
+    RTNeural::RMSNorm<float> rms_norm(size);
+    rms_norm.setGamma(gamma);
+    rms_norm.setEpsilon(1.0e-5f);
+
+    RTNeural::ModelT<float, size, size, RTNeural::LayerNormT<float, size>> layer_norm_t;
+    layer_norm_t.get<0>().setGamma(gamma);
+    layer_norm_t.get<0>().setBeta(beta);
+
+    RTNeural::ModelT<float, size, size, RTNeural::RMSNormT<float, size>> rms_norm_t;
+    rms_norm_t.get<0>().setGamma(gamma);
+    rms_norm_t.get<0>().setEpsilon(1.0e-5f);
+
+    for(const auto& x : inputs)
+    {
+        const auto expected = layerNorm(x, gamma, beta, 1.0e-5f, false);
+        const auto expected_rms = layerNorm(x, gamma, beta, 1.0e-5f, true);
+
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float y[size];
+        layer_norm.forward(x.data(), y);
+        layer_norm_t.forward(AlignedFrame(x).data);
+        for(int i = 0; i < size; ++i)
+        {
+            EXPECT_NEAR(y[i], expected[(size_t)i], 1.0e-5f);
+            EXPECT_NEAR(layer_norm_t.getOutputs()[i], expected[(size_t)i], 1.0e-5f);
+        }
+
+        rms_norm.forward(x.data(), y);
+        rms_norm_t.forward(AlignedFrame(x).data);
+        for(int i = 0; i < size; ++i)
+        {
+            EXPECT_NEAR(y[i], expected_rms[(size_t)i], 1.0e-5f);
+            EXPECT_NEAR(rms_norm_t.getOutputs()[i], expected_rms[(size_t)i], 1.0e-5f);
+        }
+    }
+}
+
+TEST(TestAttention, LayerNormLargeMean)
+{
+    // the variance of inputs with a large mean can't be computed from their sum of squares
+    constexpr int size = 16;
+    std::mt19937 rng { 0x2345 };
+    const auto gamma = randomVector(rng, size, 0.5f, 1.5f);
+    const auto beta = randomVector(rng, size);
+
+    RTNeural::LayerNorm<float> layer_norm(size);
+    layer_norm.setGamma(gamma);
+    layer_norm.setBeta(beta);
+
+    RTNeural::ModelT<float, size, size, RTNeural::LayerNormT<float, size>> layer_norm_t;
+    layer_norm_t.get<0>().setGamma(gamma);
+    layer_norm_t.get<0>().setBeta(beta);
+
+    for(int n = 0; n < num_samples; ++n)
+    {
+        const auto x = randomVector(rng, size, 999.0f, 1001.0f);
+        const auto expected = layerNorm(x, gamma, beta, 1.0e-5f, false);
+
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float y[size];
+        layer_norm.forward(x.data(), y);
+        layer_norm_t.forward(AlignedFrame(x).data);
+        for(int i = 0; i < size; ++i)
+        {
+            EXPECT_NEAR(y[i], expected[(size_t)i], 1.0e-3f);
+            EXPECT_NEAR(layer_norm_t.getOutputs()[i], expected[(size_t)i], 1.0e-3f);
+        }
+    }
+}
+
+TEST(TestAttention, MatchesReference)
+{
+    constexpr int embed_dim = 6;
+    constexpr int num_heads = 2;
+    constexpr int context_length = 5;
+
+    std::mt19937 rng { 0xa77e };
+    ReferenceAttention reference(embed_dim, num_heads, context_length, rng);
+    const auto inputs = makeInputs(num_samples, embed_dim, 0x5eed);
+    const auto expected = referenceOutputs(reference, inputs);
+
+    RTNeural::MultiHeadAttention<float> attention(embed_dim, num_heads, context_length);
+    attention.setInputWeights(reference.in_weights, reference.in_bias);
+    attention.setOutputWeights(reference.out_weights, reference.out_bias);
+
+    // a reset clears the cache, so the outputs are the same the second time around
+    std::vector<float> y((size_t)embed_dim);
+    for(int pass = 0; pass < 2; ++pass)
+    {
+        attention.reset();
+        const auto error = maxError(inputs, expected, [&attention, &y](const float* x)
+            {
+                attention.forward(x, y.data());
+                return y.data(); });
+        EXPECT_LT(error, 2.0e-5f);
+    }
+}
+
+TEST(TestAttention, LoadsAttentionJson)
+{
+    constexpr int embed_dim = 8;
+    constexpr int num_heads = 4;
+    constexpr int context_length = 7;
+
+    std::mt19937 rng { 0x0a77 };
+    ReferenceAttention reference(embed_dim, num_heads, context_length, rng);
+    const auto inputs = makeInputs(num_samples, embed_dim, 0x5eed);
+
+    nlohmann::json modelJson;
+    modelJson["in_shape"] = { nullptr, nullptr, embed_dim };
+    modelJson["layers"] = { reference.toJson() };
+
+    const auto expected = referenceOutputs(reference, inputs);
+
+    auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+    ASSERT_NE(model, nullptr);
+    model->reset();
+    const auto error = maxError(inputs, expected, [&model](const float* x)
+        {
+            model->forward(x);
+            return model->getOutputs(); });
+    EXPECT_LT(error, 2.0e-5f);
+
+    RTNeural::ModelT<float, embed_dim, embed_dim, RTNeural::MultiHeadAttentionT<float, embed_dim, num_heads, context_length>> model_t;
+    model_t.parseJson(modelJson);
+    model_t.reset();
+    const auto templated_error = maxError(inputs, expected, [&model_t](const float* x)
+        {
+            model_t.forward(x);
+            return model_t.getOutputs(); });
+    EXPECT_LT(templated_error, 2.0e-5f);
+
+    // the number of heads must divide the embedding size
+    modelJson["layers"][0]["num_heads"] = 3;
+    EXPECT_EQ(RTNeural::json_parser::parseJson<float>(modelJson), nullptr);
+}
+
+TEST(TestAttention, LoadsTorchTransformerBlock)
+{
+    constexpr int embed_dim = 8;
+    constexpr int num_heads = 2;
+    constexpr int ff_dim = 12;
+    constexpr int context_length = 6;
+    const auto inputs = makeInputs(num_samples, embed_dim, 0x5eed);
+
+    for(const auto norm_first : { true, false })
+    {
+        for(const auto rms_norm : { false, true })
+        {
+            SCOPED_TRACE("norm_first: " + std::to_string(norm_first) + ", rms_norm: " + std::to_string(rms_norm));
+
+            std::mt19937 rng { 0x7f0 };
+            ReferenceTransformer reference(embed_dim, num_heads, ff_dim, context_length, norm_first, rms_norm, rng);
+            const auto stateDict = reference.toStateDict("encoder.");
+
+            const auto expected = referenceOutputs(reference, inputs);
+
+            RTNeural::TransformerBlock<float> block(embed_dim, num_heads, ff_dim, context_length, norm_first, rms_norm);
+            RTNeural::torch_helpers::loadTransformerBlock<float>(stateDict, "encoder.", block);
+            block.reset();
+            std::vector<float> y((size_t)embed_dim);
+            const auto error = maxError(inputs, expected, [&block, &y](const float* x)
+                {
+                    block.forward(x, y.data());
+                    return y.data(); });
+            EXPECT_LT(error, 2.0e-5f);
+        }
+    }
+}
+
+TEST(TestAttention, TransformerBlockTemplated)
+{
+    constexpr int embed_dim = 8;
+    constexpr int num_heads = 2;
+    constexpr int ff_dim = 12;
+    constexpr int context_length = 6;
+    const auto inputs = makeInputs(num_samples, embed_dim, 0x5eed);
+
+    std::mt19937 rng { 0x7f1 };
+    ReferenceTransformer reference(embed_dim, num_heads, ff_dim, context_length, true, false, rng);
+    const auto stateDict = reference.toStateDict("");
+
+    const auto expected = referenceOutputs(reference, inputs);
+
+    RTNeural::ModelT<float, embed_dim, embed_dim,
+        RTNeural::TransformerBlockT<float, embed_dim, num_heads, ff_dim, context_length>>
+        model;
+    RTNeural::torch_helpers::loadTransformerBlock<float>(stateDict, "", model.get<0>());
+    model.reset();
+    const auto error = maxError(inputs, expected, [&model](const float* x)
+        {
+            model.forward(x);
+            return model.getOutputs(); });
+    EXPECT_LT(error, 2.0e-5f);
+}
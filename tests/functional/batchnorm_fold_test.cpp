@@ -0,0 +1,274 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 100;
+
+/**
+ * dense (1 -> 8) -> batchnorm -> tanh -> conv1d (8 -> 6) -> batchnorm (non-affine)
+ * -> conv1d (6 -> 4, tanh) -> batchnorm -> dense (4 -> 1)
+ *
+ * The first two batchnorm layers can be folded, but the last one follows an activation.
+ */
+nlohmann::json makeModelJson()
+{
+    std::mt19937 rng { 0x1234 };
+
+    auto conv1 = makeLayer("conv1d", 6, "", { randomTensor(rng, { 3, 8, 6 }), randomTensor(rng, { 6 }) });
+    conv1["kernel_size"] = { 3 };
+    conv1["dilation"] = { 2 };
+
+    auto conv2 = makeLayer("conv1d", 4, "tanh", { randomTensor(rng, { 2, 6, 4 }), randomTensor(rng, { 4 }) });
+    conv2["kernel_size"] = { 2 };
+    conv2["dilation"] = { 1 };
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, 1 };
+    model["layers"] = {
+        makeLayer("dense", 8, "", { randomTensor(rng, { 1, 8 }), randomTensor(rng, { 8 }) }),
+        makeBatchNorm(rng, 8, true),
+        makeLayer("activation", 8, "tanh", nlohmann::json::array()),
+        conv1,
+        makeBatchNorm(rng, 6, false),
+        conv2,
+        makeBatchNorm(rng, 4, true),
+        makeLayer("dense", 1, "", { randomTensor(rng, { 4, 1 }), randomTensor(rng, { 1 }) }),
+    };
+    return model;
+}
+
+/** Runs the model with a separate layer for each batchnorm. */
+std::vector<float> referenceOutputs(const nlohmann::json& modelJson)
+{
+    using namespace RTNeural::json_parser;
+    const auto& l = modelJson.at("layers");
+
+    RTNeural::Model<float> model(1);
+    model.addLayer(createDense<float>(1, 8, l[0].at("weights")).release());
+    model.addLayer(createBatchNorm<float>(8, l[1].at("weights"), l[1].at("epsilon").get<float>()).release());
+    model.addLayer(new RTNeural::TanhActivation<float>(8));
+    model.addLayer(createConv1D<float>(8, 6, 3, 2, 1, l[3].at("weights")).release());
+    model.addLayer(createBatchNorm<float>(6, l[4].at("weights"), l[4].at("epsilon").get<float>()).release());
+    model.addLayer(createConv1D<float>(6, 4, 2, 1, 1, l[5].at("weights")).release());
+    model.addLayer(new RTNeural::TanhActivation<float>(4));
+    model.addLayer(createBatchNorm<float>(4, l[6].at("weights"), l[6].at("epsilon").get<float>()).release());
+    model.addLayer(createDense<float>(4, 1, l[7].at("weights")).release());
+    model.reset();
+
+    std::vector<float> outputs;
+    for(const auto& x : randomSignal<float>(num_samples, 1))
+        outputs.push_back(model.forward(&x));
+    return outputs;
+}
+
+nlohmann::json makeConv2D(std::mt19937& rng, int num_filters_in, int num_features_in, int num_filters_out, int kernel_size_time, int kernel_size_feature, bool valid_pad)
+{
+    const auto num_features_out = valid_pad ? num_features_in - kernel_size_feature + 1 : num_features_in;
+    auto conv = makeLayer("conv2d", num_filters_out, "",
+        { randomTensor(rng, { kernel_size_time, kernel_size_feature, num_filters_in, num_filters_out }), randomTensor(rng, { num_filters_out }) });
+    conv["shape"] = { nullptr, nullptr, num_features_out, num_filters_out };
+    conv["kernel_size_time"] = kernel_size_time;
+    conv["kernel_size_feature"] = kernel_size_feature;
+    conv["dilation"] = 1;
+    conv["strides"] = 1;
+    conv["num_filters_in"] = num_filters_in;
+    conv["num_features_in"] = num_features_in;
+    conv["num_filters_out"] = num_filters_out;
+    conv["padding"] = valid_pad ? "valid" : "same";
+    return conv;
+}
+
+nlohmann::json makeBatchNorm2D(std::mt19937& rng, int num_filters, int num_features, bool affine)
+{
+    auto bn = makeBatchNorm(rng, num_filters, affine);
+    bn["type"] = "batchnorm2d";
+    bn["shape"] = { nullptr, nullptr, num_features, num_filters };
+    bn["num_filters_in"] = num_filters;
+    bn["num_features_in"] = num_features;
+    return bn;
+}
+
+constexpr int conv2d_num_features_in = 8;
+constexpr int conv2d_out_size = 12;
+
+/**
+ * conv2d (1 x 8 -> 3 x 6, valid padding) -> batchnorm2d
+ * -> conv2d (3 x 6 -> 2 x 6, same padding) -> batchnorm2d (non-affine)
+ *
+ * Both batchnorm2d layers can be folded.
+ */
+nlohmann::json makeConv2DModelJson()
+{
+    std::mt19937 rng { 0x4321 };
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, conv2d_num_features_in, 1 };
+    model["layers"] = {
+        makeConv2D(rng, 1, conv2d_num_features_in, 3, 3, 3, true),
+        makeBatchNorm2D(rng, 3, 6, true),
+        makeConv2D(rng, 3, 6, 2, 2, 2, false),
+        makeBatchNorm2D(rng, 2, 6, false),
+    };
+    return model;
+}
+
+/** Runs a Conv2D model on random input frames, and returns all of the outputs. */
+template <typename ModelType>
+std::vector<float> conv2DModelOutputs(ModelType& model, int out_size)
+{
+    std::mt19937 rng { 0x1357 };
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) float input[conv2d_num_features_in] {};
+
+    std::vector<float> outputs;
+    for(int n = 0; n < num_samples; ++n)
+    {
+        for(auto& x : input)
+            x = dist(rng);
+
+        model.forward(input);
+        outputs.insert(outputs.end(), model.getOutputs(), model.getOutputs() + out_size);
+    }
+    return outputs;
+}
+
+/** Runs the Conv2D model with a separate layer for each batchnorm2d. */
+std::vector<float> conv2DReferenceOutputs(const nlohmann::json& modelJson)
+{
+    using namespace RTNeural::json_parser;
+    const auto& l = modelJson.at("layers");
+
+    RTNeural::Model<float> model(conv2d_num_features_in);
+    model.addLayer(createConv2D<float>(1, conv2d_num_features_in, 3, 3, 3, 1, 1, true, l[0].at("weights")).release());
+    model.addLayer(createBatchNorm2D<float>(3, 6, l[1].at("weights"), l[1].at("epsilon").get<float>()).release());
+    model.addLayer(createConv2D<float>(3, 6, 2, 2, 2, 1, 1, false, l[2].at("weights")).release());
+    model.addLayer(createBatchNorm2D<float>(2, 6, l[3].at("weights"), l[3].at("epsilon").get<float>()).release());
+    model.reset();
+
+    return conv2DModelOutputs(model, conv2d_out_size);
+}
+
+template <typename ModelType>
+std::vector<float> modelOutputs(ModelType& model)
+{
+    std::vector<float> outputs;
+    for(const auto& x : randomSignal<float>(num_samples, 1))
+    {
+        model.forward(&x);
+        outputs.push_back(model.getOutputs()[0]);
+    }
+    return outputs;
+}
+} // namespace
+
+TEST(TestBatchNormFolding, FoldsIntoPreviousLayer)
+{
+    const auto modelJson = makeModelJson();
+    const auto folded = RTNeural::json_parser::foldBatchNorms<float>(modelJson);
+
+    const auto& layers = folded.at("layers");
+    EXPECT_TRUE(RTNeural::json_parser::isFoldedBatchNorm(layers[1]));
+    EXPECT_TRUE(RTNeural::json_parser::isFoldedBatchNorm(layers[4]));
+    EXPECT_FALSE(RTNeural::json_parser::isFoldedBatchNorm(layers[6]));
+}
+
+TEST(TestBatchNormFolding, DynamicModel)
+{
+    const auto modelJson = makeModelJson();
+    const auto expected = referenceOutputs(modelJson);
+
+    auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+    model->reset();
+
+    // only the batchnorm after the conv1d activation is left
+    const auto num_batch_norms = std::count_if(model->layers.begin(), model->layers.end(), [](const auto* l)
+        { return l->getName() == "batchnorm"; });
+    EXPECT_EQ(num_batch_norms, 1);
+    // ...and the conv1d activation is fused into the conv1d layer
+    EXPECT_EQ(model->layers.size(), (size_t)6);
+
+    using namespace testing;
+    EXPECT_THAT(modelOutputs(*model), Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestBatchNormFolding, TemplatedModel)
+{
+    const auto modelJson = makeModelJson();
+    const auto expected = referenceOutputs(modelJson);
+
+    using namespace testing;
+    {
+        // the folded batchnorm layers can be left out of the model
+        RTNeural::ModelT<float, 1, 1,
+            RTNeural::DenseT<float, 1, 8>,
+            RTNeural::TanhActivationT<float, 8>,
+            RTNeural::Conv1DT<float, 8, 6, 3, 2>,
+            RTNeural::Conv1DT<float, 6, 4, 2, 1>,
+            RTNeural::TanhActivationT<float, 4>,
+            RTNeural::BatchNorm1DT<float, 4>,
+            RTNeural::DenseT<float, 4, 1>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        EXPECT_THAT(modelOutputs(model), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+
+    {
+        // or kept, in which case they compute the identity
+        RTNeural::ModelT<float, 1, 1,
+            RTNeural::DenseT<float, 1, 8>,
+            RTNeural::BatchNorm1DT<float, 8>,
+            RTNeural::TanhActivationT<float, 8>,
+            RTNeural::Conv1DT<float, 8, 6, 3, 2>,
+            RTNeural::BatchNorm1DT<float, 6, false>,
+            RTNeural::Conv1DT<float, 6, 4, 2, 1>,
+            RTNeural::TanhActivationT<float, 4>,
+            RTNeural::BatchNorm1DT<float, 4>,
+            RTNeural::DenseT<float, 4, 1>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        EXPECT_THAT(modelOutputs(model), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+}
+
+TEST(TestBatchNormFolding, Conv2DModel)
+{
+    const auto modelJson = makeConv2DModelJson();
+    const auto expected = conv2DReferenceOutputs(modelJson);
+
+    const auto folded = RTNeural::json_parser::foldBatchNorms<float>(modelJson);
+    EXPECT_TRUE(RTNeural::json_parser::isFoldedBatchNorm(folded.at("layers")[1]));
+    EXPECT_TRUE(RTNeural::json_parser::isFoldedBatchNorm(folded.at("layers")[3]));
+
+    using namespace testing;
+    {
+        auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+        ASSERT_NE(model, nullptr);
+        EXPECT_EQ(model->layers.size(), (size_t)2);
+
+        model->reset();
+        EXPECT_THAT(conv2DModelOutputs(*model, conv2d_out_size), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+
+    {
+        RTNeural::ModelT2D<float, 1, conv2d_num_features_in, 2, 6,
+            RTNeural::Conv2DT<float, 1, 3, conv2d_num_features_in, 3, 3, 1, 1, true>,
+            RTNeural::BatchNorm2DT<float, 3, 6>,
+            RTNeural::Conv2DT<float, 3, 2, 6, 2, 2, 1, 1, false>,
+            RTNeural::BatchNorm2DT<float, 2, 6, false>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        EXPECT_THAT(conv2DModelOutputs(model, conv2d_out_size), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+}
@@ -0,0 +1,145 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+/** Block sizes to process, including blocks longer than the layer state. */
+const std::vector<int> blockSizes { 1, 5, 3, 17, 2, 40, 8, 1, 23 };
+
+template <typename T>
+void runDynamicTest(int in_size, int out_size, int kernel_size, int dilation, int groups)
+{
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+
+    RTNeural::Conv1D<T> sampleConv(in_size, out_size, kernel_size, dilation, groups);
+    RTNeural::Conv1D<T> blockConv(in_size, out_size, kernel_size, dilation, groups);
+    for(auto* conv : { &sampleConv, &blockConv })
+    {
+        conv->setWeights(weights);
+        conv->setBias(bias);
+        conv->reset();
+    }
+
+    int num_samples = 0;
+    for(auto size : blockSizes)
+        num_samples += size + 1;
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+
+    // Conv1D::forward() expects aligned inputs
+    constexpr int max_in_size = 64;
+    ASSERT_LE(in_size, max_in_size);
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_in_size] {};
+
+    std::vector<T> expected((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        sampleConv.forward(x, &expected[(size_t)n * out_size]);
+    }
+
+    // process blocks of varying sizes, with a single-sample forward() in between
+    std::vector<T> actual((size_t)num_samples * out_size);
+    int n = 0;
+    for(auto size : blockSizes)
+    {
+        blockConv.forwardBlock(&input[(size_t)n * in_size], &actual[(size_t)n * out_size], size);
+        n += size;
+
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        blockConv.forward(x, &actual[(size_t)n * out_size]);
+        n++;
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+}
+
+template <typename T, int in_size, int out_size, int kernel_size, int dilation, int groups, bool dynamic_state = false>
+void runTemplatedTest()
+{
+    using ModelType = RTNeural::ModelT<T, in_size, out_size, RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation, groups, dynamic_state>>;
+
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+
+    ModelType sampleModel;
+    ModelType blockModel;
+    for(auto* model : { &sampleModel, &blockModel })
+    {
+        model->template get<0>().setWeights(weights);
+        model->template get<0>().setBias(bias);
+        model->reset();
+    }
+
+    int num_samples = 0;
+    for(auto size : blockSizes)
+        num_samples += size + 1;
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+    std::vector<T> expected((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        sampleModel.forward(x);
+        std::copy(sampleModel.getOutputs(), sampleModel.getOutputs() + out_size, &expected[(size_t)n * out_size]);
+    }
+
+    using namespace testing;
+    std::vector<T> actual((size_t)num_samples * out_size);
+    int n = 0;
+    for(auto size : blockSizes)
+    {
+        blockModel.template get<0>().forwardBlock(&input[(size_t)n * in_size], &actual[(size_t)n * out_size], size);
+        n += size;
+
+        // the layer outputs should hold the last output of the block
+        const auto* layerOuts = reinterpret_cast<const T*>(&blockModel.template get<0>().outs[0]);
+        const std::vector<T> lastOutput(layerOuts, layerOuts + out_size);
+        EXPECT_THAT(lastOutput, ElementsAreArray(&actual[(size_t)(n - 1) * out_size], out_size));
+
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        blockModel.forward(x);
+        std::copy(blockModel.getOutputs(), blockModel.getOutputs() + out_size, &actual[(size_t)n * out_size]);
+        n++;
+    }
+
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+}
+} // namespace
+
+TEST(TestConv1DBlock, Dynamic)
+{
+    runDynamicTest<float>(8, 12, 5, 1, 1);
+    runDynamicTest<float>(6, 9, 3, 2, 3);
+    runDynamicTest<float>(20, 10, 4, 3, 2);
+    runDynamicTest<float>(16, 16, 3, 4, 16);
+    runDynamicTest<float>(4, 4, 1, 1, 1);
+    runDynamicTest<double>(5, 7, 2, 6, 1);
+}
+
+TEST(TestConv1DBlock, Templated)
+{
+    runTemplatedTest<float, 8, 12, 5, 1, 1>();
+    runTemplatedTest<float, 6, 9, 3, 2, 3>();
+    runTemplatedTest<float, 20, 10, 4, 3, 2>();
+    runTemplatedTest<float, 16, 16, 3, 4, 16>();
+    runTemplatedTest<float, 4, 4, 1, 1, 1>();
+    runTemplatedTest<double, 5, 7, 2, 6, 1>();
+}
+
+TEST(TestConv1DBlock, TemplatedDynamicState)
+{
+    runTemplatedTest<float, 17, 5, 3, 4, 1, true>();
+    runTemplatedTest<float, 36, 18, 2, 1, 2, true>();
+}
@@ -0,0 +1,135 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+/** Keeps the outputs close to unit magnitude, even for long kernels. */
+template <typename T>
+T weightRange(int filters_per_group, int kernel_size)
+{
+    return (T)1 / std::sqrt((T)(kernel_size * filters_per_group));
+}
+
+template <typename T>
+void runDynamicTest(int in_size, int out_size, int kernel_size, int dilation, int groups)
+{
+    ASSERT_GT(RTNeural::fft_conv::partitionSize(kernel_size, dilation), 0);
+
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size, weightRange<T>(in_size / groups, kernel_size));
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+
+    const auto num_samples = 2 * RTNeural::fft_conv::effectiveLength(kernel_size, dilation) + 123;
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+    const auto expected = referenceConv(input, weights, bias, in_size, out_size, kernel_size, dilation, groups);
+
+    RTNeural::Conv1D<T> conv(in_size, out_size, kernel_size, dilation, groups, true);
+    ASSERT_TRUE(conv.usesFFT());
+    conv.setWeights(weights);
+    conv.setBias(bias);
+
+    using namespace testing;
+
+    // per-sample processing (Conv1D::forward() expects aligned inputs)
+    {
+        conv.reset();
+        constexpr int max_in_size = 16;
+        ASSERT_LE(in_size, max_in_size);
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_in_size] {};
+
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+            conv.forward(x, &actual[(size_t)n * out_size]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)2.0e-4), expected));
+    }
+
+    // block processing, with blocks that don't line up with the FFT partitions
+    {
+        conv.reset();
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples;)
+        {
+            const auto block_size = std::min(num_samples - n, 37 + (n % 101));
+            conv.forwardBlock(&input[(size_t)n * in_size], &actual[(size_t)n * out_size], block_size);
+            n += block_size;
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)2.0e-4), expected));
+    }
+}
+
+template <typename T, int in_size, int out_size, int kernel_size, int dilation, int groups = 1>
+void runTemplatedTest()
+{
+    using ConvType = RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation, groups, false, RTNeural::fused_activation::Identity, true>;
+    using ModelType = RTNeural::ModelT<T, in_size, out_size, ConvType>;
+    static_assert(ConvType::usesFFT(), "Kernel should use FFT convolution!");
+
+    std::mt19937 rng { 0x4321 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size, weightRange<T>(in_size / groups, kernel_size));
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+
+    const auto num_samples = 2 * RTNeural::fft_conv::effectiveLength(kernel_size, dilation) + 123;
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+    const auto expected = referenceConv(input, weights, bias, in_size, out_size, kernel_size, dilation, groups);
+
+    ModelType model;
+    model.template get<0>().setWeights(weights);
+    model.template get<0>().setBias(bias);
+    model.reset();
+
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+    std::vector<T> actual((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        model.forward(x);
+        std::copy(model.getOutputs(), model.getOutputs() + out_size, &actual[(size_t)n * out_size]);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)2.0e-4), expected));
+}
+} // namespace
+
+TEST(TestConv1DFFT, Dynamic)
+{
+    runDynamicTest<float>(2, 3, 1100, 1, 1);
+    runDynamicTest<float>(4, 4, 600, 3, 2);
+    runDynamicTest<double>(1, 2, 2048, 1, 1);
+}
+
+TEST(TestConv1DFFT, Templated)
+{
+    runTemplatedTest<float, 2, 3, 1100, 1>();
+    runTemplatedTest<float, 4, 4, 600, 3, 2>();
+}
+
+TEST(TestConv1DFFT, ShortKernelsUseDirectForm)
+{
+    EXPECT_EQ(RTNeural::fft_conv::partitionSize(64, 1), 0);
+    EXPECT_EQ(RTNeural::fft_conv::partitionSize(3, 512), 0);
+    EXPECT_EQ(RTNeural::fft_conv::directKernelSize(64, 8), 64);
+    EXPECT_EQ(RTNeural::fft_conv::directKernelSize(2048, 1), 2 * RTNeural::fft_conv::partitionSize(2048, 1));
+}
+
+TEST(TestConv1DFFT, IsOptIn)
+{
+    EXPECT_FALSE(RTNeural::Conv1D<float>(2, 3, 1100, 1).usesFFT());
+    static_assert(!RTNeural::Conv1DT<float, 2, 3, 1100, 1>::usesFFT(), "FFT convolution should be opt-in!");
+
+    // copies keep using FFT convolution
+    const RTNeural::Conv1D<float> conv(2, 3, 1100, 1, 1, true);
+    EXPECT_TRUE(RTNeural::Conv1D<float>(conv).usesFFT());
+}
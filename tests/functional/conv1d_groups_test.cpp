@@ -0,0 +1,149 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 100;
+constexpr int block_size = 13;
+
+template <typename T>
+void runDynamicTest(int in_size, int out_size, int kernel_size, int dilation, int groups)
+{
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+    const auto expected = referenceConv(input, weights, bias, in_size, out_size, kernel_size, dilation, groups);
+
+    RTNeural::Conv1D<T> conv(in_size, out_size, kernel_size, dilation, groups);
+    conv.setWeights(weights);
+    conv.setBias(bias);
+
+    using namespace testing;
+
+    // per-sample processing (Conv1D::forward() expects aligned inputs)
+    {
+        conv.reset();
+        constexpr int max_in_size = 32;
+        ASSERT_LE(in_size, max_in_size);
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_in_size] {};
+
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+            conv.forward(x, &actual[(size_t)n * out_size]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+
+    // block processing
+    {
+        conv.reset();
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples; n += block_size)
+            conv.forwardBlock(&input[(size_t)n * in_size], &actual[(size_t)n * out_size], std::min(block_size, num_samples - n));
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+}
+
+template <typename T, int in_size, int out_size, int kernel_size, int dilation, int groups>
+void runTemplatedTest()
+{
+    using ModelType = RTNeural::ModelT<T, in_size, out_size, RTNeural::Conv1DT<T, in_size, out_size, kernel_size, dilation, groups>>;
+
+    std::mt19937 rng { 0x4321 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto input = randomVector<T>(rng, (size_t)num_samples * in_size);
+    const auto expected = referenceConv(input, weights, bias, in_size, out_size, kernel_size, dilation, groups);
+
+    ModelType model;
+    model.template get<0>().setWeights(weights);
+    model.template get<0>().setBias(bias);
+
+    using namespace testing;
+
+    // per-sample processing (ModelT::forward() expects aligned inputs, padded to the SIMD width)
+    {
+        model.reset();
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+            model.forward(x);
+            std::copy(model.getOutputs(), model.getOutputs() + out_size, &actual[(size_t)n * out_size]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+
+    // block processing
+    {
+        model.reset();
+        std::vector<T> actual((size_t)num_samples * out_size);
+        for(int n = 0; n < num_samples; n += block_size)
+            model.template get<0>().forwardBlock(&input[(size_t)n * in_size], &actual[(size_t)n * out_size], std::min(block_size, num_samples - n));
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+}
+} // namespace
+
+TEST(TestConv1DGroups, Depthwise)
+{
+    runDynamicTest<float>(16, 16, 3, 2, 16);
+    runDynamicTest<float>(7, 7, 4, 3, 7);
+    runDynamicTest<double>(5, 5, 2, 1, 5);
+    runTemplatedTest<float, 16, 16, 3, 2, 16>();
+    runTemplatedTest<float, 7, 7, 4, 3, 7>();
+    runTemplatedTest<double, 5, 5, 2, 1, 5>();
+}
+
+TEST(TestConv1DGroups, DepthwiseSingleTap)
+{
+    runDynamicTest<float>(12, 12, 1, 1, 12);
+    runDynamicTest<float>(3, 3, 1, 1, 3);
+    runTemplatedTest<float, 12, 12, 1, 1, 12>();
+    runTemplatedTest<float, 3, 3, 1, 1, 3>();
+}
+
+TEST(TestConv1DGroups, ChannelMultiplier)
+{
+    runDynamicTest<float>(8, 16, 3, 1, 8);
+    runDynamicTest<float>(4, 12, 1, 1, 4);
+    runTemplatedTest<float, 8, 16, 3, 1, 8>();
+    runTemplatedTest<float, 4, 12, 1, 1, 4>();
+}
+
+TEST(TestConv1DGroups, Grouped)
+{
+    runDynamicTest<float>(12, 18, 4, 2, 3);
+    runDynamicTest<float>(8, 8, 1, 1, 4);
+    runDynamicTest<double>(20, 10, 3, 1, 5);
+    runTemplatedTest<float, 12, 18, 4, 2, 3>();
+    runTemplatedTest<float, 8, 8, 1, 1, 4>();
+    runTemplatedTest<double, 20, 10, 3, 1, 5>();
+}
+
+TEST(TestConv1DGroups, GroupedBroadcast)
+{
+    // with at least 8 output channels per group, each input is broadcast
+    // across the output channels of its group (on every backend)
+    static_assert(RTNeural::useGroupedBroadcast(2, 16) && RTNeural::useGroupedBroadcast(4, 8), "");
+    static_assert(!RTNeural::useGroupedBroadcast(3, 6) && !RTNeural::useGroupedBroadcast(1, 32), "");
+
+    runDynamicTest<float>(16, 32, 3, 1, 2);
+    runDynamicTest<float>(32, 32, 3, 2, 4);
+    runTemplatedTest<float, 16, 32, 3, 1, 2>();
+    runTemplatedTest<float, 32, 32, 3, 2, 4>();
+}
@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+/**
+ * Direct-form reference convolution, with input[num_features_in][num_filters_in],
+ * zero-padded following the tensorflow padding rules.
+ */
+template <typename T>
+std::vector<T> referenceStridedConv(const std::vector<T>& input, const Weights<T>& weights,
+    int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad)
+{
+    const auto num_features_out = RTNeural::Conv1DStateless<T>::computeNumFeaturesOut(num_features_in, kernel_size, stride, valid_pad);
+    const auto pad_left = RTNeural::Conv1DStateless<T>::computePadLeft(num_features_in, kernel_size, stride, valid_pad);
+
+    std::vector<T> output((size_t)(num_features_out * num_filters_out));
+    for(int j = 0; j < num_features_out; ++j)
+    {
+        for(int i = 0; i < num_filters_out; ++i)
+        {
+            double sum = 0.0;
+            for(int k = 0; k < kernel_size; ++k)
+            {
+                const auto in_col = j * stride - pad_left + k;
+                if(in_col < 0 || in_col >= num_features_in)
+                    continue;
+
+                for(int c = 0; c < num_filters_in; ++c)
+                    sum += (double)weights[(size_t)i][(size_t)c][(size_t)k] * (double)input[(size_t)(in_col * num_filters_in + c)];
+            }
+            output[(size_t)(j * num_filters_out + i)] = (T)sum;
+        }
+    }
+
+    return output;
+}
+
+template <typename T>
+void runDynamicTest(int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad)
+{
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, num_filters_out, num_filters_in, kernel_size);
+    const auto input = randomVector<T>(rng, (size_t)(num_filters_in * num_features_in));
+    const auto expected = referenceStridedConv(input, weights, num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad);
+
+    RTNeural::Conv1DStateless<T> conv(num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad);
+    conv.setWeights(weights);
+    ASSERT_EQ(conv.out_size, (int)expected.size());
+
+    // Conv1DStateless::forward() accumulates into the output
+    const auto initial_output = randomVector<T>(rng, expected.size());
+    std::vector<T> actual = initial_output;
+    conv.forward(input.data(), actual.data());
+
+    for(size_t i = 0; i < actual.size(); ++i)
+        actual[i] -= initial_output[i];
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+}
+
+template <typename T, int num_filters_in, int num_features_in, int num_filters_out, int kernel_size, int stride, bool valid_pad>
+void runTemplatedTest()
+{
+    // Conv1DStatelessT is tested through a Conv2DT with a single time step
+    using LayerType = RTNeural::Conv2DT<T, num_filters_in, num_filters_out, num_features_in, 1, kernel_size, 1, stride, valid_pad>;
+    constexpr auto num_features_out = LayerType::num_features_out;
+    using ModelType = RTNeural::ModelT2D<T, num_filters_in, num_features_in, num_filters_out, num_features_out, LayerType>;
+
+    std::mt19937 rng { 0x4321 };
+    const auto weights = randomConvWeights<T>(rng, num_filters_out, num_filters_in, kernel_size);
+    const auto input = randomVector<T>(rng, (size_t)(num_filters_in * num_features_in));
+    const auto expected = referenceStridedConv(input, weights, num_filters_in, num_features_in, num_filters_out, kernel_size, stride, valid_pad);
+
+    ModelType model;
+    model.template get<0>().setWeights({ weights });
+    model.template get<0>().setBias(std::vector<T>((size_t)num_filters_out, (T)0));
+    model.reset();
+
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[num_filters_in * num_features_in] {};
+    std::copy(input.begin(), input.end(), x);
+
+    using namespace testing;
+
+    // run twice, to make sure that nothing is left over from the previous frame
+    for(int n = 0; n < 2; ++n)
+    {
+        model.forward(x);
+        const std::vector<T> actual(model.getOutputs(), model.getOutputs() + num_filters_out * num_features_out);
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+}
+} // namespace
+
+TEST(TestConv1DStateless, ValidPadding)
+{
+    runDynamicTest<float>(1, 128, 12, 65, 1, true);
+    runDynamicTest<float>(12, 64, 8, 33, 1, true);
+    runDynamicTest<float>(5, 23, 7, 4, 1, true);
+    runDynamicTest<double>(3, 17, 2, 5, 1, true);
+    runTemplatedTest<float, 1, 128, 12, 65, 1, true>();
+    runTemplatedTest<float, 5, 23, 7, 4, 1, true>();
+    runTemplatedTest<double, 3, 17, 2, 5, 1, true>();
+}
+
+TEST(TestConv1DStateless, SamePadding)
+{
+    runDynamicTest<float>(4, 32, 8, 5, 1, false);
+    runDynamicTest<float>(3, 19, 5, 4, 1, false);
+    runDynamicTest<double>(2, 10, 3, 1, 1, false);
+    runTemplatedTest<float, 4, 32, 8, 5, 1, false>();
+    runTemplatedTest<float, 3, 19, 5, 4, 1, false>();
+    runTemplatedTest<double, 2, 10, 3, 1, 1, false>();
+}
+
+TEST(TestConv1DStateless, Stride)
+{
+    runDynamicTest<float>(4, 33, 6, 5, 2, true);
+    runDynamicTest<float>(3, 29, 5, 4, 3, true);
+    runDynamicTest<float>(4, 33, 6, 5, 2, false);
+    runDynamicTest<float>(3, 29, 5, 4, 3, false);
+    runDynamicTest<float>(2, 20, 3, 2, 4, false);
+    runTemplatedTest<float, 4, 33, 6, 5, 2, true>();
+    runTemplatedTest<float, 3, 29, 5, 4, 3, true>();
+    runTemplatedTest<float, 4, 33, 6, 5, 2, false>();
+    runTemplatedTest<float, 3, 29, 5, 4, 3, false>();
+    runTemplatedTest<float, 2, 20, 3, 2, 4, false>();
+}
@@ -0,0 +1,279 @@
+#include <gmock/gmock.h>
+
+#include "load_csv.hpp"
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+/**
+ * Reference transposed convolution, computed as a causal convolution
+ * of the zero-stuffed input, with input[num_samples][in_size].
+ */
+template <typename T>
+std::vector<T> referenceConvTranspose(const std::vector<T>& input, const Weights<T>& weights, const std::vector<T>& bias,
+    int in_size, int out_size, int kernel_size, int dilation, int stride, int groups)
+{
+    const auto num_samples = (int)input.size() / in_size;
+    const auto filters_per_group = in_size / groups;
+    const auto channels_per_group = out_size / groups;
+
+    std::vector<T> output((size_t)(num_samples * stride * out_size));
+    for(int n = 0; n < num_samples * stride; ++n)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            const auto ii = (i / channels_per_group) * filters_per_group;
+            double sum = bias[(size_t)i];
+            for(int k = 0; k < kernel_size; ++k)
+            {
+                const auto m = n - k * dilation;
+                if(m < 0 || m % stride != 0)
+                    continue;
+
+                for(int c = 0; c < filters_per_group; ++c)
+                    sum += (double)weights[(size_t)i][(size_t)c][(size_t)k] * (double)input[(size_t)((m / stride) * in_size + ii + c)];
+            }
+            output[(size_t)(n * out_size + i)] = (T)sum;
+        }
+    }
+
+    return output;
+}
+
+constexpr int num_samples = 50;
+
+template <typename T>
+void runDynamicTest(int in_size, int out_size, int kernel_size, int dilation, int stride, int groups)
+{
+    std::mt19937 rng { 0x1234 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto input = randomVector<T>(rng, (size_t)(num_samples * in_size));
+    const auto expected = referenceConvTranspose(input, weights, bias, in_size, out_size, kernel_size, dilation, stride, groups);
+
+    RTNeural::ConvTranspose1D<T> conv(in_size, out_size, kernel_size, dilation, stride, groups);
+    ASSERT_EQ(conv.out_size, stride * out_size);
+    conv.setWeights(weights);
+    conv.setBias(bias);
+    conv.reset();
+
+    // ConvTranspose1D::forward() expects aligned inputs
+    constexpr int max_in_size = 32;
+    ASSERT_LE(in_size, max_in_size);
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[max_in_size] {};
+
+    std::vector<T> actual(expected.size());
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)(n * in_size)], &input[(size_t)((n + 1) * in_size)], x);
+        conv.forward(x, &actual[(size_t)(n * conv.out_size)]);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+}
+
+template <typename T, int in_size, int out_size, int kernel_size, int dilation, int stride, int groups>
+void runTemplatedTest()
+{
+    using LayerType = RTNeural::ConvTranspose1DT<T, in_size, out_size, kernel_size, dilation, stride, groups>;
+    using ModelType = RTNeural::ModelT<T, in_size, out_size, LayerType>;
+
+    std::mt19937 rng { 0x4321 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size / groups, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto input = randomVector<T>(rng, (size_t)(num_samples * in_size));
+    const auto expected = referenceConvTranspose(input, weights, bias, in_size, out_size, kernel_size, dilation, stride, groups);
+
+    ModelType model;
+    model.template get<0>().setWeights(weights);
+    model.template get<0>().setBias(bias);
+    model.reset();
+
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+    std::vector<T> actual(expected.size());
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)(n * in_size)], &input[(size_t)((n + 1) * in_size)], x);
+        model.forward(x);
+        ASSERT_EQ(model.getNumOutputFrames(), stride);
+        std::copy(model.getOutputs(), model.getOutputs() + LayerType::out_size, &actual[(size_t)(n * LayerType::out_size)]);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+}
+
+/** Returns a TensorFlow-style JSON model with a single Conv1DTranspose layer, followed by a tanh activation. */
+template <typename T>
+nlohmann::json makeJsonModel(const Weights<T>& weights, const std::vector<T>& bias, int in_size, int out_size,
+    int kernel_size, int dilation, int stride)
+{
+    // TensorFlow kernel: [kernel_size][out_size][in_size]
+    std::vector<std::vector<std::vector<T>>> kernel((size_t)kernel_size, std::vector<std::vector<T>>((size_t)out_size, std::vector<T>((size_t)in_size)));
+    for(int k = 0; k < kernel_size; ++k)
+        for(int i = 0; i < out_size; ++i)
+            for(int j = 0; j < in_size; ++j)
+                kernel[(size_t)k][(size_t)i][(size_t)j] = weights[(size_t)i][(size_t)j][(size_t)k];
+
+    nlohmann::json layer;
+    layer["type"] = "convtranspose1d";
+    layer["activation"] = "tanh";
+    layer["shape"] = { nullptr, nullptr, out_size };
+    layer["kernel_size"] = { kernel_size };
+    layer["dilation"] = { dilation };
+    layer["strides"] = { stride };
+    layer["weights"] = { kernel, bias };
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, in_size };
+    model["layers"] = { layer };
+    return model;
+}
+} // namespace
+
+TEST(TestConvTranspose1D, Polyphase)
+{
+    runDynamicTest<float>(4, 15, 5, 1, 3, 1);
+    runDynamicTest<float>(8, 6, 4, 1, 2, 1);
+    runDynamicTest<float>(3, 5, 2, 1, 4, 1);
+    runDynamicTest<double>(6, 4, 7, 1, 3, 1);
+    runTemplatedTest<float, 4, 15, 5, 1, 3, 1>();
+    runTemplatedTest<float, 8, 6, 4, 1, 2, 1>();
+    runTemplatedTest<float, 3, 5, 2, 1, 4, 1>();
+    runTemplatedTest<double, 6, 4, 7, 1, 3, 1>();
+}
+
+TEST(TestConvTranspose1D, DilationAndGroups)
+{
+    runDynamicTest<float>(4, 6, 3, 2, 3, 1);
+    runDynamicTest<float>(4, 6, 3, 2, 2, 1);
+    runDynamicTest<float>(8, 8, 4, 1, 2, 4);
+    runDynamicTest<float>(6, 12, 3, 3, 2, 2);
+    runTemplatedTest<float, 4, 6, 3, 2, 3, 1>();
+    runTemplatedTest<float, 4, 6, 3, 2, 2, 1>();
+    runTemplatedTest<float, 8, 8, 4, 1, 2, 4>();
+    runTemplatedTest<float, 6, 12, 3, 3, 2, 2>();
+}
+
+TEST(TestConvTranspose1D, StrideOne)
+{
+    runDynamicTest<float>(5, 7, 3, 2, 1, 1);
+    runTemplatedTest<float, 5, 7, 3, 2, 1, 1>();
+}
+
+TEST(TestConvTranspose1D, TorchModel)
+{
+    // see python/convtranspose1d_torch.py
+    using T = double;
+    constexpr int in_size = 4;
+    constexpr int out_size = 15;
+    constexpr int kernel_size = 5;
+    constexpr int padding = 3;
+    constexpr int stride = 3;
+
+    std::ifstream jsonStream(std::string { RTNEURAL_ROOT_DIR } + "models/convtranspose1d_torch.json", std::ifstream::binary);
+    nlohmann::json modelJson;
+    jsonStream >> modelJson;
+
+    RTNeural::ConvTranspose1D<T> conv(in_size, out_size, kernel_size, 1, stride);
+    RTNeural::torch_helpers::loadConvTranspose1D<T>(modelJson, "", conv);
+    conv.reset();
+
+    std::ifstream modelInputsFile { std::string { RTNEURAL_ROOT_DIR } + "test_data/convtranspose1d_torch_x_python.csv" };
+    const auto inputs = RTNeural::torch_helpers::detail::transpose(load_csv::loadFile2d<T>(modelInputsFile));
+    std::ifstream modelOutputsFile { std::string { RTNEURAL_ROOT_DIR } + "test_data/convtranspose1d_torch_y_python.csv" };
+    const auto expected_y = RTNeural::torch_helpers::detail::transpose(load_csv::loadFile2d<T>(modelOutputsFile));
+
+    // one extra (zero) input frame flushes the tail of the kernel
+    std::vector<T> outputs;
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[in_size] {};
+    std::vector<T> frames((size_t)conv.out_size);
+    for(size_t n = 0; n <= inputs.size(); ++n)
+    {
+        if(n < inputs.size())
+            std::copy(inputs[n].begin(), inputs[n].end(), x);
+        else
+            std::fill(std::begin(x), std::end(x), (T)0);
+
+        conv.forward(x, frames.data());
+        outputs.insert(outputs.end(), frames.begin(), frames.end());
+    }
+
+    // PyTorch's padding drops the first "padding" output frames
+    ASSERT_LE((expected_y.size() + padding) * out_size, outputs.size());
+    for(size_t n = 0; n < expected_y.size(); ++n)
+    {
+        for(size_t j = 0; j < (size_t)out_size; ++j)
+            EXPECT_NEAR(outputs[(n + padding) * out_size + j], expected_y[n][j], 2.0e-5);
+    }
+}
+
+TEST(TestConvTranspose1D, JsonLoader)
+{
+    using T = float;
+    constexpr int in_size = 6;
+    constexpr int out_size = 5;
+    constexpr int kernel_size = 4;
+    constexpr int dilation = 1;
+    constexpr int stride = 2;
+
+    std::mt19937 rng { 0x5678 };
+    const auto weights = randomConvWeights<T>(rng, out_size, in_size, kernel_size);
+    const auto bias = randomVector<T>(rng, (size_t)out_size);
+    const auto input = randomVector<T>(rng, (size_t)(num_samples * in_size));
+    auto expected = referenceConvTranspose(input, weights, bias, in_size, out_size, kernel_size, dilation, stride, 1);
+    for(auto& y : expected)
+        y = std::tanh(y);
+
+    const auto modelJson = makeJsonModel(weights, bias, in_size, out_size, kernel_size, dilation, stride);
+
+    using namespace testing;
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[16] {};
+    constexpr int frames_size = stride * out_size;
+
+    {
+        auto model = RTNeural::json_parser::parseJson<T>(modelJson);
+        ASSERT_NE(model, nullptr);
+        ASSERT_EQ(model->getOutSize(), out_size);
+        model->reset();
+
+        std::vector<T> actual(expected.size());
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)(n * in_size)], &input[(size_t)((n + 1) * in_size)], x);
+            model->forward(x);
+            ASSERT_EQ(model->getNumOutputFrames(), stride);
+            std::copy(model->getOutputs(), model->getOutputs() + frames_size, &actual[(size_t)(n * frames_size)]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+
+    {
+        RTNeural::ModelT<T, in_size, out_size,
+            RTNeural::ConvTranspose1DT<T, in_size, out_size, kernel_size, dilation, stride>,
+            RTNeural::TanhActivationT<T, out_size>>
+            model;
+        static_assert(decltype(model)::max_output_frames == stride, "one output frame per phase");
+        model.parseJson(modelJson);
+        model.reset();
+
+        std::vector<T> actual(expected.size());
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)(n * in_size)], &input[(size_t)((n + 1) * in_size)], x);
+            model.forward(x);
+            ASSERT_EQ(model.getNumOutputFrames(), stride);
+            std::copy(model.getOutputs(), model.getOutputs() + frames_size, &actual[(size_t)(n * frames_size)]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+}
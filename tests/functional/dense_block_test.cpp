@@ -0,0 +1,70 @@
+#include <gmock/gmock.h>
+
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+template <typename T>
+void runDenseTest(int in_size, int out_size, int num_samples, T tolerance)
+{
+    std::mt19937 rng { 0x1234 };
+    std::uniform_real_distribution<T> dist((T)-1, (T)1);
+
+    std::vector<std::vector<T>> weights(out_size, std::vector<T>(in_size));
+    for(auto& row : weights)
+        for(auto& w : row)
+            w = dist(rng);
+
+    std::vector<T> bias(out_size);
+    for(auto& b : bias)
+        b = dist(rng);
+
+    RTNeural::Dense<T> dense(in_size, out_size);
+    dense.setWeights(weights);
+    dense.setBias(bias.data());
+
+    using namespace testing;
+    EXPECT_EQ(dense.getWeight(out_size - 1, in_size - 1), weights[out_size - 1][in_size - 1]);
+    EXPECT_EQ(dense.getBias(out_size - 1), bias[out_size - 1]);
+
+    std::vector<T> input((size_t)num_samples * in_size);
+    for(auto& x : input)
+        x = dist(rng);
+
+    // reference output
+    std::vector<T> expected((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            auto y = (double)bias[i];
+            for(int k = 0; k < in_size; ++k)
+                y += (double)weights[i][k] * (double)input[(size_t)n * in_size + k];
+            expected[(size_t)n * out_size + i] = (T)y;
+        }
+    }
+
+    std::vector<T> sampleOutput((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+        dense.forward(&input[(size_t)n * in_size], &sampleOutput[(size_t)n * out_size]);
+    EXPECT_THAT(sampleOutput, Pointwise(FloatNear(tolerance), expected));
+
+    std::vector<T> blockOutput((size_t)num_samples * out_size);
+    dense.forwardBlock(input.data(), blockOutput.data(), num_samples);
+    EXPECT_THAT(blockOutput, Pointwise(FloatNear(tolerance), expected));
+}
+} // namespace
+
+TEST(TestDenseBlock, Small)
+{
+    runDenseTest<float>(24, 13, 7, 1.0e-4f);
+    runDenseTest<double>(24, 13, 7, 1.0e-10);
+}
+
+TEST(TestDenseBlock, Large)
+{
+    // large enough to use the cache-blocked path, with sizes that don't divide evenly into panels
+    runDenseTest<float>(300, 257, 11, 1.0e-3f);
+    runDenseTest<double>(300, 257, 11, 1.0e-10);
+}
@@ -0,0 +1,298 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 100;
+
+nlohmann::json makeConv1D(std::mt19937& rng, int in_size, int out_size, int kernel_size, int dilation, const std::string& activation)
+{
+    auto conv = makeLayer("conv1d", out_size, activation, { randomTensor(rng, { kernel_size, in_size, out_size }), randomTensor(rng, { out_size }) });
+    conv["kernel_size"] = { kernel_size };
+    conv["dilation"] = { dilation };
+    return conv;
+}
+
+/**
+ * dense (1 -> 8, tanh) -> conv1d (8 -> 6, relu) -> dense (6 -> 4) -> prelu
+ * -> conv1d (4 -> 4, elu) -> dense (4 -> 1, sigmoid)
+ */
+nlohmann::json makeModelJson()
+{
+    std::mt19937 rng { 0x4321 };
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, 1 };
+    model["layers"] = {
+        makeLayer("dense", 8, "tanh", { randomTensor(rng, { 1, 8 }), randomTensor(rng, { 8 }) }),
+        makeConv1D(rng, 8, 6, 3, 2, "relu"),
+        makeLayer("dense", 4, "", { randomTensor(rng, { 6, 4 }), randomTensor(rng, { 4 }) }),
+        makeLayer("prelu", 4, "", { { randomTensor(rng, { 4 }) } }),
+        makeConv1D(rng, 4, 4, 2, 1, "elu"),
+        makeLayer("dense", 1, "sigmoid", { randomTensor(rng, { 4, 1 }), randomTensor(rng, { 1 }) }),
+    };
+    return model;
+}
+
+/** Runs the model with a separate layer for each activation. */
+std::vector<float> referenceOutputs(const nlohmann::json& modelJson)
+{
+    using namespace RTNeural::json_parser;
+    const auto& l = modelJson.at("layers");
+
+    RTNeural::Model<float> model(1);
+    model.addLayer(createDense<float>(1, 8, l[0].at("weights")).release());
+    model.addLayer(new RTNeural::TanhActivation<float>(8));
+    model.addLayer(createConv1D<float>(8, 6, 3, 2, 1, l[1].at("weights")).release());
+    model.addLayer(new RTNeural::ReLuActivation<float>(6));
+    model.addLayer(createDense<float>(6, 4, l[2].at("weights")).release());
+    model.addLayer(createPReLU<float>(4, l[3].at("weights")).release());
+    model.addLayer(createConv1D<float>(4, 4, 2, 1, 1, l[4].at("weights")).release());
+    model.addLayer(new RTNeural::ELuActivation<float>(4));
+    model.addLayer(createDense<float>(4, 1, l[5].at("weights")).release());
+    model.addLayer(new RTNeural::SigmoidActivation<float>(1));
+    model.reset();
+
+    std::vector<float> outputs;
+    for(const auto& x : randomSignal<float>(num_samples, 1))
+        outputs.push_back(model.forward(&x));
+    return outputs;
+}
+
+template <typename ModelType>
+std::vector<float> modelOutputs(ModelType& model)
+{
+    std::vector<float> outputs;
+    for(const auto& x : randomSignal<float>(num_samples, 1))
+    {
+        model.forward(&x);
+        outputs.push_back(model.getOutputs()[0]);
+    }
+    return outputs;
+}
+} // namespace
+
+TEST(TestFusedActivation, DynamicModel)
+{
+    const auto modelJson = makeModelJson();
+    const auto expected = referenceOutputs(modelJson);
+
+    auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+    model->reset();
+
+    // only the prelu layer is left as a separate activation layer
+    ASSERT_EQ(model->layers.size(), (size_t)6);
+    EXPECT_NE(dynamic_cast<RTNeural::Dense<float>*>(model->layers[0])->getActivation(), nullptr);
+    EXPECT_NE(dynamic_cast<RTNeural::Conv1D<float>*>(model->layers[1])->getActivation(), nullptr);
+    EXPECT_EQ(dynamic_cast<RTNeural::Dense<float>*>(model->layers[2])->getActivation(), nullptr);
+    EXPECT_EQ(model->layers[3]->getName(), "prelu");
+
+    using namespace testing;
+    EXPECT_THAT(modelOutputs(*model), Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestFusedActivation, TemplatedModel)
+{
+    const auto modelJson = makeModelJson();
+    const auto expected = referenceOutputs(modelJson);
+
+    using namespace testing;
+    namespace fused = RTNeural::fused_activation;
+    {
+        RTNeural::ModelT<float, 1, 1,
+            RTNeural::DenseT<float, 1, 8, true, fused::Tanh<>>,
+            RTNeural::Conv1DT<float, 8, 6, 3, 2, 1, false, fused::ReLu>,
+            RTNeural::DenseT<float, 6, 4, true, fused::PReLU<float, 4>>,
+            RTNeural::Conv1DT<float, 4, 4, 2, 1, 1, false, fused::ELu<>>,
+            RTNeural::DenseT<float, 4, 1, true, fused::Sigmoid<>>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        EXPECT_THAT(modelOutputs(model), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+
+    {
+        // the same model still loads with separate activation layers
+        RTNeural::ModelT<float, 1, 1,
+            RTNeural::DenseT<float, 1, 8>,
+            RTNeural::TanhActivationT<float, 8>,
+            RTNeural::Conv1DT<float, 8, 6, 3, 2>,
+            RTNeural::ReLuActivationT<float, 6>,
+            RTNeural::DenseT<float, 6, 4>,
+            RTNeural::PReLUActivationT<float, 4>,
+            RTNeural::Conv1DT<float, 4, 4, 2, 1>,
+            RTNeural::ELuActivationT<float, 4>,
+            RTNeural::DenseT<float, 4, 1>,
+            RTNeural::SigmoidActivationT<float, 1>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        EXPECT_THAT(modelOutputs(model), Pointwise(FloatNear(1.0e-5f), expected));
+    }
+}
+
+TEST(TestFusedActivation, Conv1DBlock)
+{
+    constexpr int in_size = 4;
+    constexpr int out_size = 8;
+    std::mt19937 rng { 0x1357 };
+    const auto convJson = makeConv1D(rng, in_size, out_size, 3, 2, "tanh");
+    const auto input = randomSignal<float>(num_samples, in_size);
+
+    RTNeural::Conv1DT<float, in_size, out_size, 3, 2, 1, false, RTNeural::fused_activation::Tanh<>> conv;
+    RTNeural::json_parser::loadConv1D<float>(conv, 3, 2, convJson.at("weights"));
+    conv.reset();
+
+    RTNeural::Conv1D<float> reference(in_size, out_size, 3, 2);
+    RTNeural::json_parser::loadConv1D<float>(reference, 3, 2, convJson.at("weights"));
+    reference.setActivation(std::make_unique<RTNeural::TanhActivation<float>>(out_size));
+    reference.reset();
+
+    std::vector<float> expected((size_t)(num_samples * out_size));
+    for(int n = 0; n < num_samples; ++n)
+        reference.forward(&input[(size_t)(n * in_size)], &expected[(size_t)(n * out_size)]);
+
+    std::vector<float> actual((size_t)(num_samples * out_size));
+    conv.forwardBlock(input.data(), actual.data(), num_samples);
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestFusedActivation, Conv2DModel)
+{
+    std::mt19937 rng { 0x8642 };
+
+    // conv2d (1 x 6 -> 2 x 4, tanh) -> conv2d (2 x 4 -> 1 x 4, relu)
+    auto makeConv2D = [&rng](int filters_in, int features_in, int filters_out, int features_out, int kernel_time,
+                          int kernel_feature, bool valid_pad, const std::string& activation)
+    {
+        auto conv = makeLayer("conv2d", 0, activation,
+            { randomTensor(rng, { kernel_time, kernel_feature, filters_in, filters_out }), randomTensor(rng, { filters_out }) });
+        conv["shape"] = { nullptr, nullptr, features_out, filters_out };
+        conv["kernel_size_time"] = { kernel_time };
+        conv["kernel_size_feature"] = { kernel_feature };
+        conv["dilation"] = { 1 };
+        conv["strides"] = { 1 };
+        conv["num_filters_in"] = { filters_in };
+        conv["num_features_in"] = { features_in };
+        conv["num_filters_out"] = { filters_out };
+        conv["padding"] = valid_pad ? "valid" : "same";
+        return conv;
+    };
+
+    nlohmann::json modelJson;
+    modelJson["in_shape"] = { nullptr, nullptr, 6, 1 };
+    modelJson["layers"] = {
+        makeConv2D(1, 6, 2, 4, 3, 3, true, "tanh"),
+        makeConv2D(2, 4, 1, 4, 2, 3, false, "relu"),
+    };
+
+    auto dynamicModel = RTNeural::json_parser::parseJson<float>(modelJson);
+    ASSERT_EQ(dynamicModel->layers.size(), (size_t)2);
+    dynamicModel->reset();
+
+    // reference model with a separate layer for each activation
+    const auto& l = modelJson.at("layers");
+    RTNeural::Model<float> reference(6);
+    reference.addLayer(RTNeural::json_parser::createConv2D<float>(1, 6, 2, 3, 3, 1, 1, true, l[0].at("weights")).release());
+    reference.addLayer(new RTNeural::TanhActivation<float>(8));
+    reference.addLayer(RTNeural::json_parser::createConv2D<float>(2, 4, 1, 2, 3, 1, 1, false, l[1].at("weights")).release());
+    reference.addLayer(new RTNeural::ReLuActivation<float>(4));
+    reference.reset();
+
+    namespace fused = RTNeural::fused_activation;
+    RTNeural::ModelT2D<float, 1, 6, 1, 4,
+        RTNeural::Conv2DT<float, 1, 2, 6, 3, 3, 1, 1, true, fused::Tanh<>>,
+        RTNeural::Conv2DT<float, 2, 1, 4, 2, 3, 1, 1, false, fused::ReLu>>
+        templatedModel;
+    templatedModel.parseJson(modelJson);
+    templatedModel.reset();
+
+    const auto input = randomSignal<float>(num_samples, 6);
+    std::vector<float> expected, dynamicOutputs, templatedOutputs;
+    for(int n = 0; n < num_samples; ++n)
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float x[6];
+        std::copy(&input[(size_t)(n * 6)], &input[(size_t)((n + 1) * 6)], x);
+
+        reference.forward(x);
+        expected.insert(expected.end(), reference.getOutputs(), reference.getOutputs() + 4);
+
+        dynamicModel->forward(x);
+        dynamicOutputs.insert(dynamicOutputs.end(), dynamicModel->getOutputs(), dynamicModel->getOutputs() + 4);
+
+        templatedModel.forward(x);
+        templatedOutputs.insert(templatedOutputs.end(), templatedModel.getOutputs(), templatedModel.getOutputs() + 4);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(dynamicOutputs, Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(templatedOutputs, Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestFusedActivation, Conv2DPReLU)
+{
+    // conv2d (2 x 8 -> 5 x 6) -> prelu, where the number of output filters
+    // is not a multiple of the SIMD width
+    constexpr int num_filters_in = 2;
+    constexpr int num_features_in = 8;
+    constexpr int num_filters_out = 5;
+    constexpr int num_features_out = 6;
+    constexpr int out_size = num_filters_out * num_features_out;
+    std::mt19937 rng { 0x9753 };
+
+    auto conv = makeLayer("conv2d", 0, "", { randomTensor(rng, { 2, 3, num_filters_in, num_filters_out }), randomTensor(rng, { num_filters_out }) });
+    conv["shape"] = { nullptr, nullptr, num_features_out, num_filters_out };
+    conv["kernel_size_time"] = { 2 };
+    conv["kernel_size_feature"] = { 3 };
+    conv["dilation"] = { 1 };
+    conv["strides"] = { 1 };
+    conv["num_filters_in"] = { num_filters_in };
+    conv["num_features_in"] = { num_features_in };
+    conv["num_filters_out"] = { num_filters_out };
+    conv["padding"] = "valid";
+
+    auto prelu = makeLayer("prelu", 0, "", { { randomTensor(rng, { out_size }) } });
+    prelu["shape"] = { nullptr, nullptr, num_features_out, num_filters_out };
+
+    nlohmann::json modelJson;
+    modelJson["in_shape"] = { nullptr, nullptr, num_features_in, num_filters_in };
+    modelJson["layers"] = { conv, prelu };
+
+    auto reference = RTNeural::json_parser::parseJson<float>(modelJson);
+    ASSERT_EQ(reference->layers.size(), (size_t)2);
+    reference->reset();
+
+    namespace fused = RTNeural::fused_activation;
+    RTNeural::ModelT2D<float, num_filters_in, num_features_in, num_filters_out, num_features_out,
+        RTNeural::Conv2DT<float, num_filters_in, num_filters_out, num_features_in, 2, 3, 1, 1, true,
+            fused::PReLU<float, out_size, num_features_out>>>
+        model;
+    model.parseJson(modelJson);
+    model.reset();
+
+    const auto input = randomSignal<float>(num_samples, num_filters_in * num_features_in);
+    std::vector<float> expected, actual;
+    for(int n = 0; n < num_samples; ++n)
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float x[num_filters_in * num_features_in];
+        std::copy(&input[(size_t)(n * num_filters_in * num_features_in)], &input[(size_t)((n + 1) * num_filters_in * num_features_in)], x);
+
+        reference->forward(x);
+        expected.insert(expected.end(), reference->getOutputs(), reference->getOutputs() + out_size);
+
+        model.forward(x);
+        actual.insert(actual.end(), model.getOutputs(), model.getOutputs() + out_size);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-5f), expected));
+}
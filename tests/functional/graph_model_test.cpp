@@ -0,0 +1,248 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 100;
+
+nlohmann::json makeLayer(const std::string& type, const std::string& name, int out_size, const std::string& activation, const nlohmann::json& weights)
+{
+    auto layer = test_helpers::makeLayer(type, out_size, activation, weights);
+    layer["name"] = name;
+    return layer;
+}
+
+nlohmann::json makeOp(const std::string& type, const std::string& name, int out_size, const std::vector<std::string>& inputs)
+{
+    nlohmann::json op;
+    op["type"] = type;
+    op["name"] = name;
+    op["inputs"] = inputs;
+    op["shape"] = { nullptr, nullptr, out_size };
+    return op;
+}
+
+nlohmann::json makeSequential(int in_size, const nlohmann::json& layer)
+{
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, in_size };
+    model["layers"] = { layer };
+    return model;
+}
+
+/**
+ * conv1d (4 -> 4, tanh) -> add (with the input) -> split into two halves,
+ * where the second half is passed through a dense (2 -> 2, sigmoid) layer,
+ * and multiplied by the first -> concat with the residual -> dense (6 -> 1)
+ */
+nlohmann::json makeGraphJson()
+{
+    std::mt19937 rng { 0x2468 };
+
+    auto conv = makeLayer("conv1d", "conv", 4, "tanh", { randomTensor(rng, { 3, 4, 4 }), randomTensor(rng, { 4 }) });
+    conv["kernel_size"] = { 3 };
+    conv["dilation"] = { 1 };
+
+    auto gate = makeLayer("dense", "gate", 2, "sigmoid", { randomTensor(rng, { 2, 2 }), randomTensor(rng, { 2 }) });
+    gate["inputs"] = { "b" };
+
+    auto split_b = makeOp("split", "b", 2, { "res" });
+    split_b["offset"] = 2;
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, 4 };
+    model["layers"] = {
+        conv,
+        makeOp("add", "res", 4, { "conv", "input" }),
+        makeOp("split", "a", 2, { "res" }),
+        split_b,
+        gate,
+        makeOp("multiply", "gated", 2, { "a", "gate" }),
+        makeOp("concat", "cat", 6, { "gated", "res" }),
+        makeLayer("dense", "out", 1, "", { randomTensor(rng, { 6, 1 }), randomTensor(rng, { 1 }) }),
+    };
+    return model;
+}
+
+std::vector<std::array<float, 4>> makeInputs()
+{
+    std::mt19937 rng { 0x1357 };
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+
+    std::vector<std::array<float, 4>> inputs(num_samples);
+    for(auto& x : inputs)
+        for(auto& v : x)
+            v = dist(rng);
+    return inputs;
+}
+
+/** Computes the graph outputs with a sequential model for each of the layers. */
+std::vector<float> computeReference(const nlohmann::json& modelJson, const std::vector<std::array<float, 4>>& inputs)
+{
+    const auto& layers = modelJson.at("layers");
+    auto conv = RTNeural::json_parser::parseJson<float>(makeSequential(4, layers.at(0)));
+    auto gate = RTNeural::json_parser::parseJson<float>(makeSequential(2, layers.at(4)));
+    auto out = RTNeural::json_parser::parseJson<float>(makeSequential(6, layers.at(7)));
+    conv->reset();
+    gate->reset();
+    out->reset();
+
+    std::vector<float> outputs;
+    for(const auto& x : inputs)
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float in[4];
+        std::copy(x.begin(), x.end(), in);
+        conv->forward(in);
+
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float res[4];
+        for(int i = 0; i < 4; ++i)
+            res[i] = conv->getOutputs()[i] + x[(size_t)i];
+
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float b[2] { res[2], res[3] };
+        gate->forward(b);
+
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float cat[6];
+        for(int i = 0; i < 2; ++i)
+            cat[i] = res[i] * gate->getOutputs()[i];
+        std::copy(res, res + 4, cat + 2);
+
+        outputs.push_back(out->forward(cat));
+    }
+    return outputs;
+}
+} // namespace
+
+TEST(TestGraphModel, ParsesGraphJson)
+{
+    const auto modelJson = makeGraphJson();
+    const auto inputs = makeInputs();
+    const auto expected = computeReference(modelJson, inputs);
+
+    auto model = RTNeural::json_parser::parseGraphJson<float>(modelJson);
+    ASSERT_NE(model, nullptr);
+    EXPECT_EQ(model->getInSize(), 4);
+    EXPECT_EQ(model->getOutSize(), 1);
+    model->reset();
+
+    // the branches share buffers where their lifetimes allow
+    EXPECT_LT(model->getNumBuffers(), model->getNumNodes() - 1);
+
+    for(size_t n = 0; n < inputs.size(); ++n)
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float in[4];
+        std::copy(inputs[n].begin(), inputs[n].end(), in);
+        EXPECT_NEAR(model->forward(in), expected[n], 1.0e-6f) << "Sample: " << n;
+    }
+}
+
+TEST(TestGraphModel, ParsesGraphJsonTemplated)
+{
+    const auto modelJson = makeGraphJson();
+    const auto inputs = makeInputs();
+    const auto expected = computeReference(modelJson, inputs);
+
+    RTNeural::GraphModelT<float, 4, 1,
+        RTNeural::GraphLayerT<RTNeural::Conv1DT<float, 4, 4, 3, 1>, 0>, // 1: conv
+        RTNeural::GraphLayerT<RTNeural::TanhActivationT<float, 4>, 1>, // 2
+        RTNeural::GraphAddT<float, 4, 2, 0>, // 3: res
+        RTNeural::GraphSplitT<float, 0, 2, 3>, // 4: a
+        RTNeural::GraphSplitT<float, 2, 2, 3>, // 5: b
+        RTNeural::GraphLayerT<RTNeural::DenseT<float, 2, 2>, 5>, // 6: gate
+        RTNeural::GraphLayerT<RTNeural::SigmoidActivationT<float, 2>, 6>, // 7
+        RTNeural::GraphMultiplyT<float, 2, 4, 7>, // 8: gated
+        RTNeural::GraphConcatT<float, 6, 8, 3>, // 9: cat
+        RTNeural::GraphLayerT<RTNeural::DenseT<float, 6, 1>, 9> // 10: out
+        >
+        model;
+    model.parseJson(modelJson);
+    model.reset();
+
+    for(size_t n = 0; n < inputs.size(); ++n)
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float in[4];
+        std::copy(inputs[n].begin(), inputs[n].end(), in);
+        EXPECT_NEAR(model.forward(in), expected[n], 1.0e-6f) << "Sample: " << n;
+    }
+
+    // "b" is only read by the gate layer, so "gated" can reuse its buffer,
+    // and "cat" can reuse the buffer of "a" once "gated" has read it
+    EXPECT_EQ(model.getNumBuffers(), 3);
+    EXPECT_EQ(model.getNodeData<8>(), model.getNodeData<5>());
+    EXPECT_EQ(model.getNodeData<9>(), model.getNodeData<4>());
+    EXPECT_NE(model.getNodeData<9>(), model.getNodeData<3>());
+}
+
+TEST(TestGraphModel, TemplatedOperationsTakeManyInputs)
+{
+    RTNeural::GraphModelT<float, 2, 6,
+        RTNeural::GraphLayerT<RTNeural::TanhActivationT<float, 2>, 0>, // 1
+        RTNeural::GraphLayerT<RTNeural::SigmoidActivationT<float, 2>, 0>, // 2
+        RTNeural::GraphAddT<float, 2, 0, 1, 2>, // 3
+        RTNeural::GraphMultiplyT<float, 2, 1, 2, 3>, // 4
+        RTNeural::GraphConcatT<float, 6, 3, 0, 4> // 5
+        >
+        model;
+    model.reset();
+
+    for(const auto& x : makeInputs())
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float in[4] { x[0], x[1] }; // padded for the SIMD loads
+        model.forward(in);
+
+        for(int i = 0; i < 2; ++i)
+        {
+            const auto th = std::tanh(in[i]);
+            const auto sig = 1.0f / (1.0f + std::exp(-in[i]));
+            const auto sum = in[i] + th + sig;
+            EXPECT_NEAR(model.getOutputs()[i], sum, 1.0e-6f);
+            EXPECT_NEAR(model.getOutputs()[2 + i], in[i], 1.0e-6f);
+            EXPECT_NEAR(model.getOutputs()[4 + i], th * sig * sum, 1.0e-6f);
+        }
+    }
+}
+
+TEST(TestGraphModel, RejectsBadGraphs)
+{
+    // unknown input
+    auto modelJson = makeGraphJson();
+    modelJson["layers"][1]["inputs"] = { "conv", "nope" };
+    EXPECT_EQ(RTNeural::json_parser::parseGraphJson<float>(modelJson), nullptr);
+
+    // mismatched sizes
+    modelJson = makeGraphJson();
+    modelJson["layers"][5]["inputs"] = { "res", "gate" };
+    EXPECT_EQ(RTNeural::json_parser::parseGraphJson<float>(modelJson), nullptr);
+
+    // split out of range
+    modelJson = makeGraphJson();
+    modelJson["layers"][3]["offset"] = 3;
+    EXPECT_EQ(RTNeural::json_parser::parseGraphJson<float>(modelJson), nullptr);
+}
+
+TEST(TestGraphModel, SelectsOutput)
+{
+    auto modelJson = makeGraphJson();
+    modelJson["output"] = "res";
+
+    auto model = RTNeural::json_parser::parseGraphJson<float>(modelJson);
+    ASSERT_NE(model, nullptr);
+    EXPECT_EQ(model->getOutSize(), 4);
+
+    auto conv = RTNeural::json_parser::parseJson<float>(makeSequential(4, modelJson.at("layers").at(0)));
+    model->reset();
+    conv->reset();
+    for(const auto& x : makeInputs())
+    {
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) float in[4];
+        std::copy(x.begin(), x.end(), in);
+        model->forward(in);
+        conv->forward(in);
+        for(int i = 0; i < 4; ++i)
+            EXPECT_NEAR(model->getOutputs()[i], conv->getOutputs()[i] + in[i], 1.0e-6f);
+    }
+}
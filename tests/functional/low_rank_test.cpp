@@ -0,0 +1,273 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+template <typename LayerType>
+std::vector<float> runBlocks(LayerType& layer, const std::vector<float>& input, int num_samples, int block_size)
+{
+    layer.reset();
+    std::vector<float> output((size_t)num_samples * LayerType::out_size);
+    for(int n = 0; n < num_samples; n += block_size)
+    {
+        const auto samplesToProcess = std::min(block_size, num_samples - n);
+        layer.forwardBlock(&input[(size_t)n * LayerType::in_size], &output[(size_t)n * LayerType::out_size], samplesToProcess);
+    }
+    return output;
+}
+
+nlohmann::json denseLayerJson(const std::vector<std::vector<float>>& weights, const std::vector<float>& bias)
+{
+    // json stores the kernel as kernel[in_size][out_size]
+    nlohmann::json layer;
+    layer["type"] = "dense";
+    layer["shape"] = { nullptr, nullptr, weights.size() };
+    layer["weights"] = { transpose(weights), bias };
+    layer["activation"] = "";
+    return layer;
+}
+
+nlohmann::json modelJson(size_t in_size, const nlohmann::json& layer)
+{
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, in_size };
+    model["layers"] = { layer };
+    return model;
+}
+} // namespace
+
+TEST(TestLowRank, TruncatedSVD)
+{
+    using T = float;
+    std::mt19937 rng { 0x1234 };
+
+    // a rank-3 matrix should be recovered (almost) exactly at rank 3
+    const auto mat = RTNeural::low_rank::multiply(randomMatrix<T>(rng, 20, 3), randomMatrix<T>(rng, 3, 12));
+    for(const auto& m : { mat, transpose(mat) })
+    {
+        const auto factors = RTNeural::low_rank::factorizeWithTolerance(m, 1.0e-4);
+        EXPECT_EQ(factors.rank, 3);
+        EXPECT_LT(factors.error, 1.0e-4);
+
+        const auto approx = RTNeural::low_rank::multiply(factors.left, factors.right);
+        for(size_t i = 0; i < m.size(); ++i)
+            EXPECT_THAT(approx[i], testing::Pointwise(testing::FloatNear(1.0e-5f), m[i]));
+    }
+
+    // a random matrix needs the full rank, and the error decreases with the rank
+    const auto full = randomMatrix<T>(rng, 16, 10);
+    EXPECT_EQ(RTNeural::low_rank::factorizeWithTolerance(full, 1.0e-4).rank, 10);
+    EXPECT_LT(RTNeural::low_rank::factorizeWithRank(full, 10).error, 1.0e-6);
+    EXPECT_GT(RTNeural::low_rank::factorizeWithRank(full, 4).error, RTNeural::low_rank::factorizeWithRank(full, 6).error);
+}
+
+TEST(TestLowRank, LowRankDenseMatchesDense)
+{
+    using T = float;
+    constexpr int in_size = 40;
+    constexpr int out_size = 24;
+    constexpr int rank = 5;
+    constexpr int num_samples = 50;
+
+    std::mt19937 rng { 0x1234 };
+    const auto left = randomMatrix<T>(rng, out_size, rank);
+    const auto right = randomMatrix<T>(rng, rank, in_size);
+    const auto bias = randomMatrix<T>(rng, 1, out_size)[0];
+
+    RTNeural::Model<T> model(in_size);
+    auto* dense = new RTNeural::Dense<T>(in_size, out_size);
+    dense->setWeights(RTNeural::low_rank::multiply(left, right));
+    dense->setBias(bias.data());
+    model.addLayer(dense);
+
+    RTNeural::Model<T> lowRankModel(in_size);
+    auto* lowRankDense = new RTNeural::LowRankDense<T>(in_size, out_size, rank);
+    lowRankDense->setFactors(left, right);
+    lowRankDense->setBias(bias.data());
+    lowRankModel.addLayer(lowRankDense);
+    EXPECT_EQ(lowRankDense->getRank(), rank);
+
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::LowRankDenseT<T, in_size, out_size, rank>> modelT;
+    modelT.get<0>().setFactors(left, right);
+    modelT.get<0>().setBias(bias.data());
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+    const auto expected = runDynamicModel(model, input, num_samples);
+
+    using namespace testing;
+    EXPECT_THAT(runDynamicModel(lowRankModel, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+
+    std::vector<T> blockOutput((size_t)num_samples * out_size);
+    lowRankDense->forwardBlock(input.data(), blockOutput.data(), num_samples);
+    EXPECT_THAT(blockOutput, Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestLowRank, LoaderPicksLowRankDense)
+{
+    using T = float;
+    constexpr int in_size = 32;
+    constexpr int out_size = 16;
+    constexpr int rank = 4;
+    constexpr int num_samples = 20;
+
+    std::mt19937 rng { 0x1234 };
+    const auto left = randomMatrix<T>(rng, out_size, rank);
+    const auto right = randomMatrix<T>(rng, rank, in_size);
+    const auto bias = randomMatrix<T>(rng, 1, out_size)[0];
+    const auto input = randomSignal<T>(num_samples, in_size);
+    const auto weights = RTNeural::low_rank::multiply(left, right);
+
+    auto denseModel = RTNeural::json_parser::parseJson<T>(modelJson(in_size, denseLayerJson(weights, bias)));
+    ASSERT_NE(dynamic_cast<RTNeural::Dense<T>*>(denseModel->layers[0]), nullptr);
+    const auto expected = runDynamicModel(*denseModel, input, num_samples);
+
+    // factors stored in the json, as kernel_in[in_size][rank], kernel_out[rank][out_size]
+    auto layer = denseLayerJson(weights, bias);
+    layer["rank"] = rank;
+    layer["weights"] = { transpose(right), transpose(left), bias };
+    auto factorsModel = RTNeural::json_parser::parseJson<T>(modelJson(in_size, layer));
+    auto* lowRankDense = dynamic_cast<RTNeural::LowRankDense<T>*>(factorsModel->layers[0]);
+    ASSERT_NE(lowRankDense, nullptr);
+    EXPECT_EQ(lowRankDense->getRank(), rank);
+    EXPECT_EQ(lowRankDense->getName(), "dense");
+
+    // full-rank weights in the json, factorized with a truncated SVD
+    auto svdModel = RTNeural::json_parser::parseJson<T>(modelJson(in_size, denseLayerJson(weights, bias)), false,
+        RTNeural::default_sparsity_threshold, 1.0e-4);
+    lowRankDense = dynamic_cast<RTNeural::LowRankDense<T>*>(svdModel->layers[0]);
+    ASSERT_NE(lowRankDense, nullptr);
+    EXPECT_EQ(lowRankDense->getRank(), rank);
+
+    // random weights are full-rank, so should not be factorized
+    auto fullRankModel = RTNeural::json_parser::parseJson<T>(modelJson(in_size, denseLayerJson(randomMatrix<T>(rng, out_size, in_size), bias)), false,
+        RTNeural::default_sparsity_threshold, 1.0e-4);
+    EXPECT_NE(dynamic_cast<RTNeural::Dense<T>*>(fullRankModel->layers[0]), nullptr);
+
+    using namespace testing;
+    EXPECT_THAT(runDynamicModel(*factorsModel, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runDynamicModel(*svdModel, input, num_samples), Pointwise(FloatNear(1.0e-4f), expected));
+
+    // the templated layer factorizes full-rank weights to its own rank
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::LowRankDenseT<T, in_size, out_size, rank>> modelT;
+    modelT.parseJson(modelJson(in_size, denseLayerJson(weights, bias)));
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples), Pointwise(FloatNear(1.0e-4f), expected));
+}
+
+TEST(TestLowRank, LowRankGRU)
+{
+    using T = float;
+    constexpr int in_size = 4;
+    constexpr int out_size = 16;
+    constexpr int rank = 3;
+    constexpr int num_samples = 100;
+
+    std::mt19937 rng { 0x1234 };
+    const auto wVals = randomMatrix<T>(rng, in_size, 3 * out_size);
+    const auto uLeft = randomMatrix<T>(rng, out_size, rank);
+    const auto uRight = randomMatrix<T>(rng, rank, 3 * out_size);
+    const auto bVals = randomMatrix<T>(rng, 2, 3 * out_size);
+
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::GRULayerT<T, in_size, out_size>> modelT;
+    auto& gruT = modelT.get<0>();
+    gruT.setWVals(wVals);
+    gruT.setUFactors(uLeft, uRight);
+    gruT.setBVals(bVals);
+    EXPECT_EQ(gruT.getRecurrentRank(), rank);
+
+    RTNeural::Model<T> model(in_size);
+    auto* gru = new RTNeural::GRULayer<T>(in_size, out_size);
+    gru->setWVals(wVals);
+    gru->setUVals(RTNeural::low_rank::multiply(uLeft, uRight));
+    gru->setBVals(bVals);
+    model.addLayer(gru);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+    const auto expected = runDynamicModel(model, input, num_samples);
+
+    using namespace testing;
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runBlocks(gruT, input, num_samples, 8), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runBlocks(gruT, input, num_samples, 64), Pointwise(FloatNear(1.0e-5f), expected));
+
+    // loading the factors from json, or factorizing the full-rank weights
+    nlohmann::json layer;
+    layer["type"] = "gru";
+    layer["shape"] = { nullptr, nullptr, out_size };
+    layer["weights"] = { wVals, uLeft, uRight, bVals };
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::GRULayerT<T, in_size, out_size>> jsonModel;
+    jsonModel.parseJson(modelJson(in_size, layer));
+    EXPECT_EQ(jsonModel.get<0>().getRecurrentRank(), rank);
+    EXPECT_THAT(runTemplatedModel<T>(jsonModel, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+
+    layer["weights"] = { wVals, RTNeural::low_rank::multiply(uLeft, uRight), bVals };
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::GRULayerT<T, in_size, out_size>> svdModel;
+    svdModel.parseJson(modelJson(in_size, layer), false, {}, 1.0e-4);
+    EXPECT_EQ(svdModel.get<0>().getRecurrentRank(), rank);
+    EXPECT_THAT(runTemplatedModel<T>(svdModel, input, num_samples), Pointwise(FloatNear(1.0e-4f), expected));
+
+    // going back to full-rank weights
+    gruT.setUVals(RTNeural::low_rank::multiply(uLeft, uRight));
+    EXPECT_EQ(gruT.getRecurrentRank(), 0);
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestLowRank, LowRankLSTM)
+{
+    using T = float;
+    constexpr int in_size = 4;
+    constexpr int out_size = 16;
+    constexpr int rank = 3;
+    constexpr int num_samples = 100;
+
+    std::mt19937 rng { 0x1234 };
+    const auto wVals = randomMatrix<T>(rng, in_size, 4 * out_size);
+    const auto uLeft = randomMatrix<T>(rng, out_size, rank);
+    const auto uRight = randomMatrix<T>(rng, rank, 4 * out_size);
+    const auto bVals = randomMatrix<T>(rng, 1, 4 * out_size)[0];
+
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::LSTMLayerT<T, in_size, out_size>> modelT;
+    auto& lstmT = modelT.get<0>();
+    lstmT.setWVals(wVals);
+    lstmT.setUFactors(uLeft, uRight);
+    lstmT.setBVals(bVals);
+    EXPECT_EQ(lstmT.getRecurrentRank(), rank);
+
+    RTNeural::Model<T> model(in_size);
+    auto* lstm = new RTNeural::LSTMLayer<T>(in_size, out_size);
+    lstm->setWVals(wVals);
+    lstm->setUVals(RTNeural::low_rank::multiply(uLeft, uRight));
+    lstm->setBVals(bVals);
+    model.addLayer(lstm);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+    const auto expected = runDynamicModel(model, input, num_samples);
+
+    using namespace testing;
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runBlocks(lstmT, input, num_samples, 8), Pointwise(FloatNear(1.0e-5f), expected));
+    EXPECT_THAT(runBlocks(lstmT, input, num_samples, 64), Pointwise(FloatNear(1.0e-5f), expected));
+
+    nlohmann::json layer;
+    layer["type"] = "lstm";
+    layer["shape"] = { nullptr, nullptr, out_size };
+    layer["weights"] = { wVals, RTNeural::low_rank::multiply(uLeft, uRight), bVals };
+    RTNeural::ModelT<T, in_size, out_size, RTNeural::LSTMLayerT<T, in_size, out_size>> svdModel;
+    svdModel.parseJson(modelJson(in_size, layer), false, {}, 1.0e-4);
+    EXPECT_EQ(svdModel.get<0>().getRecurrentRank(), rank);
+    EXPECT_THAT(runTemplatedModel<T>(svdModel, input, num_samples), Pointwise(FloatNear(1.0e-4f), expected));
+
+    // factors with a rank above max_recurrent_rank are stored as full-rank weights
+    const auto fullLeft = randomMatrix<T>(rng, out_size, out_size);
+    const auto fullRight = randomMatrix<T>(rng, out_size, 4 * out_size);
+    lstmT.setUFactors(fullLeft, fullRight);
+    lstm->setUVals(RTNeural::low_rank::multiply(fullLeft, fullRight));
+    EXPECT_EQ(lstmT.getRecurrentRank(), 0);
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples),
+        Pointwise(FloatNear(1.0e-4f), runDynamicModel(model, input, num_samples)));
+}
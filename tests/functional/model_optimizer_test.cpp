@@ -0,0 +1,158 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+nlohmann::json makeDense(std::mt19937& rng, int in_size, int out_size, const std::string& activation = "")
+{
+    return makeLayer("dense", out_size, activation, { randomTensor(rng, { in_size, out_size }), randomTensor(rng, { out_size }) });
+}
+
+nlohmann::json makeModel(int in_size, const nlohmann::json& layers)
+{
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, in_size };
+    model["layers"] = layers;
+    return model;
+}
+
+std::vector<std::string> getLayerTypes(const nlohmann::json& model)
+{
+    std::vector<std::string> types;
+    for(const auto& l : model.at("layers"))
+        types.push_back(l.at("type").get<std::string>());
+    return types;
+}
+} // namespace
+
+TEST(TestModelOptimizer, OptimizesRecurrentModel)
+{
+    std::mt19937 rng { 0x1234 };
+
+    // dense (2 -> 4) -> dense (4 -> 6, tanh) -> batchnorm -> dense (6 -> 8) -> gru (8 -> 8)
+    // -> dense (8 -> 3, relu) -> relu -> (identity) activation -> dense (3 -> 1)
+    const auto modelJson = makeModel(2,
+        {
+            makeDense(rng, 2, 4),
+            makeDense(rng, 4, 6, "tanh"),
+            makeBatchNorm(rng, 6),
+            makeDense(rng, 6, 8),
+            makeLayer("gru", 8, "", { randomTensor(rng, { 8, 24 }), randomTensor(rng, { 8, 24 }), randomTensor(rng, { 2, 24 }) }),
+            makeDense(rng, 8, 3, "relu"),
+            makeLayer("activation", 3, "relu", nlohmann::json::array()),
+            makeLayer("activation", 3, "", nlohmann::json::array()),
+            makeDense(rng, 3, 1),
+        });
+
+    RTNeural::json_parser::OptimizationReport report;
+    const auto optimized = RTNeural::json_parser::optimizeJson<float>(modelJson, report);
+
+    EXPECT_THAT(getLayerTypes(optimized), testing::ElementsAre("dense", "gru", "dense", "dense"));
+    EXPECT_EQ(report.getNumRewrites("merge-linear"), 1);
+    EXPECT_EQ(report.getNumRewrites("fold-batchnorm-forward"), 1);
+    EXPECT_EQ(report.getNumRewrites("fold-into-recurrent"), 1);
+    EXPECT_EQ(report.getNumRewrites("eliminate-dead-layers"), 2);
+    EXPECT_EQ(report.getNumRewrites("fold-batchnorm"), 0);
+
+    EXPECT_LT(RTNeural::json_parser::compareModels<float>(modelJson, optimized), 1.0e-5);
+
+    RTNeural::json_parser::OptimizationReport parseReport;
+    auto model = RTNeural::json_parser::parseOptimizedJson<float>(modelJson, parseReport);
+    EXPECT_TRUE(parseReport.verified);
+    EXPECT_EQ(model->layers.size(), (size_t)4);
+}
+
+TEST(TestModelOptimizer, FoldsIntoLSTM)
+{
+    std::mt19937 rng { 0x4321 };
+
+    // batchnorm -> lstm (4 -> 4) -> batchnorm -> dense (4 -> 1)
+    const auto modelJson = makeModel(4,
+        {
+            makeBatchNorm(rng, 4),
+            makeLayer("lstm", 4, "", { randomTensor(rng, { 4, 16 }), randomTensor(rng, { 4, 16 }), randomTensor(rng, { 16 }) }),
+            makeBatchNorm(rng, 4),
+            makeDense(rng, 4, 1),
+        });
+
+    RTNeural::json_parser::OptimizationReport report;
+    const auto optimized = RTNeural::json_parser::optimizeJson<float>(modelJson, report);
+
+    EXPECT_THAT(getLayerTypes(optimized), testing::ElementsAre("lstm", "dense"));
+    EXPECT_EQ(report.getNumRewrites("fold-batchnorm-forward"), 2);
+    EXPECT_LT(RTNeural::json_parser::compareModels<float>(modelJson, optimized), 1.0e-5);
+}
+
+TEST(TestModelOptimizer, KeepsCheaperLayers)
+{
+    std::mt19937 rng { 0x2468 };
+
+    // a bottleneck is cheaper than the merged layer: (8 -> 2 -> 8) vs. (8 -> 8)
+    const auto modelJson = makeModel(8, { makeDense(rng, 8, 2), makeDense(rng, 2, 8), makeDense(rng, 8, 8, "tanh") });
+
+    RTNeural::json_parser::OptimizationReport report;
+    const auto optimized = RTNeural::json_parser::optimizeJson<float>(modelJson, report);
+
+    // ... but the last two layers can be merged
+    EXPECT_THAT(getLayerTypes(optimized), testing::ElementsAre("dense", "dense"));
+    EXPECT_EQ(report.getNumRewrites("merge-linear"), 1);
+    EXPECT_EQ(optimized.at("layers").at(1).at("weights").at(0).size(), (size_t)2);
+    EXPECT_LT(RTNeural::json_parser::compareModels<float>(modelJson, optimized), 1.0e-5);
+}
+
+TEST(TestModelOptimizer, RejectsUnverifiedModel)
+{
+    std::mt19937 rng { 0x1357 };
+    const auto modelJson = makeModel(2, { makeDense(rng, 2, 4), makeDense(rng, 4, 1) });
+
+    // a broken pass, which changes the bias of the last layer (once)
+    std::vector<RTNeural::json_parser::OptimizationPass> passes {
+        { "broken", [](nlohmann::json& layers, bool)
+            {
+                auto& last = layers.at(layers.size() - 1);
+                if(last.contains("broken"))
+                    return 0;
+
+                last["broken"] = true;
+                auto& bias = last.at("weights").at(1);
+                bias[0] = bias[0].get<float>() + 1.0f;
+                return 1;
+            } },
+    };
+
+    RTNeural::json_parser::OptimizationReport report;
+    const auto optimized = RTNeural::json_parser::optimizeJson<float>(modelJson, report, passes);
+    EXPECT_EQ(report.getNumRewrites("broken"), 1);
+    EXPECT_GT(RTNeural::json_parser::compareModels<float>(modelJson, optimized), 0.5);
+
+    // the loader rejects the broken pass, and falls back to the unoptimized model
+    RTNeural::json_parser::OptimizationReport brokenReport;
+    auto model = RTNeural::json_parser::parseOptimizedJson<float>(modelJson, brokenReport, 1.0e-5, passes);
+    EXPECT_EQ(brokenReport.getNumRewrites("broken"), 1);
+    EXPECT_FALSE(brokenReport.verified);
+    EXPECT_GT(brokenReport.max_error, 0.5);
+    ASSERT_EQ(model->layers.size(), (size_t)2);
+
+    auto reference = RTNeural::json_parser::parseJson<float>(modelJson);
+    model->reset();
+    reference->reset();
+    const float x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[2] { 0.25f, -0.75f };
+    EXPECT_EQ(model->forward(x), reference->forward(x));
+
+    // the default passes produce a verified model
+    RTNeural::json_parser::OptimizationReport defaultReport;
+    model = RTNeural::json_parser::parseOptimizedJson<float>(modelJson, defaultReport, 1.0e-5);
+    EXPECT_TRUE(defaultReport.verified);
+    EXPECT_EQ(model->layers.size(), (size_t)1);
+
+    // ... unless the tolerance is impossible to meet
+    RTNeural::json_parser::OptimizationReport strictReport;
+    model = RTNeural::json_parser::parseOptimizedJson<float>(modelJson, strictReport, -1.0);
+    EXPECT_FALSE(strictReport.verified);
+    EXPECT_EQ(model->layers.size(), (size_t)2);
+}
@@ -0,0 +1,244 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 200;
+constexpr int stride = 2;
+
+/**
+ * Returns an encoder/decoder model, where the GRU runs at half of the input rate:
+ * strided conv1d (1 -> 4, tanh) -> gru (4 -> 6) -> convtranspose1d (6 -> 3) -> dense (3 -> 1)
+ */
+nlohmann::json makeEncoderDecoderJson(bool with_decoder)
+{
+    std::mt19937 rng { 0x1357 };
+
+    auto conv = makeLayer("conv1d", 4, "tanh", { randomTensor(rng, { 3, 1, 4 }), randomTensor(rng, { 4 }) });
+    conv["kernel_size"] = { 3 };
+    conv["dilation"] = { 1 };
+    conv["strides"] = { stride };
+
+    auto gru = makeLayer("gru", 6, "", { randomTensor(rng, { 4, 18 }), randomTensor(rng, { 6, 18 }), randomTensor(rng, { 2, 18 }) });
+
+    auto conv_transpose = makeLayer("convtranspose1d", 3, "", { randomTensor(rng, { 4, 3, 6 }), randomTensor(rng, { 3 }) });
+    conv_transpose["kernel_size"] = { 4 };
+    conv_transpose["dilation"] = { 1 };
+    conv_transpose["strides"] = { stride };
+
+    auto dense = makeLayer("dense", 1, "", { randomTensor(rng, { with_decoder ? 3 : 6, 1 }), randomTensor(rng, { 1 }) });
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, 1 };
+    if(with_decoder)
+        model["layers"] = { conv, gru, conv_transpose, dense };
+    else
+        model["layers"] = { conv, gru, dense };
+    return model;
+}
+
+/**
+ * Computes the outputs of the encoder/decoder model with single-rate layers:
+ * the input is filtered by a regular convolution and then decimated by `stride`,
+ * the GRU and dense layers run on the decimated frames, and the decoder inserts
+ * `stride - 1` zero frames after each GRU output, and filters them with a regular
+ * convolution using the (reversed) kernel of the transposed convolution.
+ * Also returns the number of model output frames for each input sample.
+ */
+std::vector<float> referenceOutputs(bool with_decoder, std::vector<int>& num_frames)
+{
+    using namespace RTNeural::json_parser;
+    const auto layersJson = makeEncoderDecoderJson(with_decoder).at("layers");
+    const auto input = randomSignal<float>(num_samples, 1);
+
+    // encoder: convolution at the input rate, followed by decimation
+    auto conv = createConv1D<float>(1, 4, 3, 1, 1, layersJson[0].at("weights"));
+    RTNeural::TanhActivation<float> tanh(4);
+    conv->reset();
+
+    std::vector<std::vector<float>> encoded;
+    std::vector<float> conv_out(4);
+    for(size_t n = 0; n < input.size(); ++n)
+    {
+        conv->forward(&input[n], conv_out.data());
+        if(n % stride != 0)
+            continue;
+
+        tanh.forward(conv_out.data(), conv_out.data());
+        encoded.push_back(conv_out);
+    }
+
+    auto gru = createGRU<float>(4, 6, layersJson[1].at("weights"));
+    gru->reset();
+    std::vector<std::vector<float>> hidden;
+    for(const auto& frame : encoded)
+    {
+        hidden.emplace_back(6);
+        gru->forward(frame.data(), hidden.back().data());
+    }
+
+    std::vector<float> outputs;
+    if(!with_decoder)
+    {
+        auto dense = createDense<float>(6, 1, layersJson[2].at("weights"));
+        for(const auto& frame : hidden)
+        {
+            outputs.push_back(0.0f);
+            dense->forward(frame.data(), &outputs.back());
+        }
+
+        for(size_t n = 0; n < input.size(); ++n)
+            num_frames.push_back(n % stride == 0 ? 1 : 0);
+        return outputs;
+    }
+
+    // decoder: zero-stuffing back to the input rate, followed by a convolution
+    // ([kernel][out][in] transposed convolution weights -> [kernel][in][out] reversed)
+    const auto& transposedWeights = layersJson[2].at("weights");
+    constexpr int kernel_size = 4;
+    auto kernel = nlohmann::json::array();
+    for(int k = kernel_size - 1; k >= 0; --k)
+    {
+        auto tap = nlohmann::json::array();
+        for(int i = 0; i < 6; ++i)
+        {
+            auto tap_in = nlohmann::json::array();
+            for(int j = 0; j < 3; ++j)
+                tap_in.push_back(transposedWeights[0][k][j][i]);
+            tap.push_back(tap_in);
+        }
+        kernel.push_back(tap);
+    }
+    auto upsampling_conv = createConv1D<float>(6, 3, kernel_size, 1, 1, { kernel, transposedWeights[1] });
+    auto dense = createDense<float>(3, 1, layersJson[3].at("weights"));
+    upsampling_conv->reset();
+
+    const std::vector<float> zeros(6, 0.0f);
+    std::vector<float> decoded(3);
+    for(size_t n = 0; n < input.size(); ++n)
+    {
+        upsampling_conv->forward(n % stride == 0 ? hidden[n / stride].data() : zeros.data(), decoded.data());
+        outputs.push_back(0.0f);
+        dense->forward(decoded.data(), &outputs.back());
+
+        // all of the output frames for an input frame of the transposed convolution are computed at once
+        num_frames.push_back(n % stride == 0 ? stride : 0);
+    }
+
+    return outputs;
+}
+
+template <typename ModelType>
+std::vector<float> modelOutputs(ModelType& model, std::vector<int>& num_frames)
+{
+    std::vector<float> outputs;
+    for(const auto& x : randomSignal<float>(num_samples, 1))
+    {
+        model.forward(&x);
+        num_frames.push_back(model.getNumOutputFrames());
+        outputs.insert(outputs.end(), model.getOutputs(), model.getOutputs() + model.getNumOutputFrames());
+    }
+    return outputs;
+}
+} // namespace
+
+TEST(TestMultiRateModel, DecimatingModel)
+{
+    const auto modelJson = makeEncoderDecoderJson(false);
+    std::vector<int> expected_frames;
+    const auto expected = referenceOutputs(false, expected_frames);
+    ASSERT_EQ(expected.size(), (size_t)(num_samples / stride));
+
+    using namespace testing;
+    {
+        auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+        ASSERT_EQ(model->layers.front()->getName(), "strided_conv1d");
+        ASSERT_EQ(model->getOutSize(), 1);
+        model->reset();
+
+        std::vector<int> num_frames;
+        const auto actual = modelOutputs(*model, num_frames);
+        EXPECT_EQ(num_frames, expected_frames);
+        EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-6f), expected));
+    }
+
+    {
+        RTNeural::ModelT<float, 1, 1,
+            RTNeural::StridedConv1DT<float, 1, 4, 3, 1, stride>,
+            RTNeural::TanhActivationT<float, 4>,
+            RTNeural::GRULayerT<float, 4, 6>,
+            RTNeural::DenseT<float, 6, 1>>
+            model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        std::vector<int> num_frames;
+        const auto actual = modelOutputs(model, num_frames);
+        EXPECT_EQ(num_frames, expected_frames);
+        EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-5f), expected));
+    }
+}
+
+TEST(TestMultiRateModel, EncoderDecoderModel)
+{
+    const auto modelJson = makeEncoderDecoderJson(true);
+    std::vector<int> expected_frames;
+    const auto expected = referenceOutputs(true, expected_frames);
+    ASSERT_EQ(expected.size(), (size_t)num_samples);
+
+    using namespace testing;
+    {
+        auto model = RTNeural::json_parser::parseJson<float>(modelJson);
+        ASSERT_EQ(model->getOutSize(), 1);
+        model->reset();
+
+        std::vector<int> num_frames;
+        const auto actual = modelOutputs(*model, num_frames);
+        EXPECT_EQ(num_frames, expected_frames);
+        EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-6f), expected));
+    }
+
+    {
+        using ModelType = RTNeural::ModelT<float, 1, 1,
+            RTNeural::StridedConv1DT<float, 1, 4, 3, 1, stride>,
+            RTNeural::TanhActivationT<float, 4>,
+            RTNeural::GRULayerT<float, 4, 6>,
+            RTNeural::ConvTranspose1DT<float, 6, 3, 4, 1, stride>,
+            RTNeural::DenseT<float, 3, 1>>;
+        static_assert(ModelType::max_output_frames == stride, "one output frame per phase");
+
+        ModelType model;
+        model.parseJson(modelJson);
+        model.reset();
+
+        std::vector<int> num_frames;
+        const auto actual = modelOutputs(model, num_frames);
+        EXPECT_EQ(num_frames, expected_frames);
+        EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-5f), expected));
+    }
+}
+
+TEST(TestMultiRateModel, HeldOutputs)
+{
+    auto model = RTNeural::json_parser::parseJson<float>(makeEncoderDecoderJson(false));
+    model->reset();
+
+    // between the decimated frames, the model outputs hold their previous values
+    float x = 0.5f;
+    const auto y = model->forward(&x);
+    EXPECT_EQ(model->getNumOutputFrames(), 1);
+
+    x = -0.5f;
+    EXPECT_EQ(model->forward(&x), y);
+    EXPECT_EQ(model->getNumOutputFrames(), 0);
+
+    model->reset();
+    x = 0.5f;
+    EXPECT_EQ(model->forward(&x), y);
+    EXPECT_EQ(model->getNumOutputFrames(), 1);
+}
@@ -0,0 +1,105 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+template <typename T, int in_size, int out_size>
+void setRandomWeights(RTNeural::GRULayerT<T, in_size, out_size>& layer, std::mt19937& rng)
+{
+    layer.setWVals(randomMatrix<T>(rng, in_size, 3 * out_size));
+    layer.setUVals(randomMatrix<T>(rng, out_size, 3 * out_size));
+    layer.setBVals(randomMatrix<T>(rng, 2, 3 * out_size));
+}
+
+template <typename T, int in_size, int out_size>
+void setRandomWeights(RTNeural::LSTMLayerT<T, in_size, out_size>& layer, std::mt19937& rng)
+{
+    layer.setWVals(randomMatrix<T>(rng, in_size, 4 * out_size));
+    layer.setUVals(randomMatrix<T>(rng, out_size, 4 * out_size));
+    layer.setBVals(randomMatrix<T>(rng, 1, 4 * out_size)[0]);
+}
+
+template <typename T, typename LayerType>
+void runBlockTest(T tolerance)
+{
+    static constexpr int in_size = LayerType::in_size;
+    static constexpr int out_size = LayerType::out_size;
+    static constexpr int num_samples = 200;
+    static constexpr int block_size = 64;
+
+    RTNeural::ModelT<T, in_size, out_size, LayerType> refModel;
+    RTNeural::ModelT<T, in_size, out_size, LayerType> blockModel;
+
+    std::mt19937 weightsRng { 0x1234 };
+    setRandomWeights(refModel.template get<0>(), weightsRng);
+    weightsRng.seed(0x1234);
+    setRandomWeights(blockModel.template get<0>(), weightsRng);
+    refModel.reset();
+    blockModel.reset();
+
+    std::mt19937 signalRng { 0x5678 };
+    std::uniform_real_distribution<T> dist((T)-1, (T)1);
+    std::vector<T> input((size_t)num_samples * in_size);
+    for(auto& x : input)
+        x = dist(signalRng);
+
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+    std::vector<T> refOutput((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        refModel.forward(x);
+        std::copy(refModel.getOutputs(), refModel.getOutputs() + out_size, &refOutput[(size_t)n * out_size]);
+    }
+
+    // process in uneven blocks, to check that the layer state is carried between blocks
+    std::vector<T> blockOutput((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; n += block_size)
+    {
+        const auto samplesToProcess = std::min(block_size, num_samples - n);
+        blockModel.template get<0>().forwardBlock(&input[(size_t)n * in_size], &blockOutput[(size_t)n * out_size], samplesToProcess);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(blockOutput, Pointwise(FloatNear(tolerance), refOutput));
+
+    // the layer state should be written back, so that per-sample processing can continue
+    std::copy(input.begin(), input.begin() + in_size, x);
+    refModel.forward(x);
+    blockModel.forward(x);
+    const auto refOuts = std::vector<T>(refModel.getOutputs(), refModel.getOutputs() + out_size);
+    const auto blockOuts = std::vector<T>(blockModel.getOutputs(), blockModel.getOutputs() + out_size);
+    EXPECT_THAT(blockOuts, Pointwise(FloatNear(tolerance), refOuts));
+}
+} // namespace
+
+TEST(TestRecurrentBlock, GRUSmall)
+{
+    runBlockTest<float, RTNeural::GRULayerT<float, 1, 8>>(1.0e-5f);
+    runBlockTest<double, RTNeural::GRULayerT<double, 1, 8>>(1.0e-12);
+    runBlockTest<float, RTNeural::GRULayerT<float, 4, 6>>(1.0e-5f);
+}
+
+TEST(TestRecurrentBlock, GRULarge)
+{
+    runBlockTest<float, RTNeural::GRULayerT<float, 2, 24>>(1.0e-5f);
+}
+
+TEST(TestRecurrentBlock, LSTMSmall)
+{
+    runBlockTest<float, RTNeural::LSTMLayerT<float, 1, 8>>(1.0e-5f);
+    runBlockTest<double, RTNeural::LSTMLayerT<double, 1, 8>>(1.0e-12);
+    runBlockTest<float, RTNeural::LSTMLayerT<float, 4, 6>>(1.0e-5f);
+}
+
+TEST(TestRecurrentBlock, LSTMLarge)
+{
+    runBlockTest<float, RTNeural::LSTMLayerT<float, 2, 24>>(1.0e-5f);
+}
@@ -0,0 +1,105 @@
+#include <gmock/gmock.h>
+
+#include "../cpu_support_environment.hpp"
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <cstdint>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+bool isAligned(const void* ptr)
+{
+    return reinterpret_cast<std::uintptr_t>(ptr) % RTNEURAL_DEFAULT_ALIGNMENT == 0;
+}
+
+template <typename T>
+void runAlignmentTest(T tolerance)
+{
+    // odd layer sizes, so that none of the layers fill a whole number of SIMD registers
+    static constexpr int in_size = 5;
+    static constexpr int dense_size = 19;
+    static constexpr int gru_size = 11;
+    static constexpr int out_size = 3;
+
+    std::mt19937 rng { 0x1234 };
+    const auto dense1Weights = randomMatrix<T>(rng, dense_size, in_size);
+    const auto dense1Bias = randomMatrix<T>(rng, 1, dense_size)[0];
+    const auto gruW = randomMatrix<T>(rng, dense_size, 3 * gru_size);
+    const auto gruU = randomMatrix<T>(rng, gru_size, 3 * gru_size);
+    const auto gruB = randomMatrix<T>(rng, 2, 3 * gru_size);
+    const auto dense2Weights = randomMatrix<T>(rng, out_size, gru_size);
+    const auto dense2Bias = randomMatrix<T>(rng, 1, out_size)[0];
+
+    RTNeural::ModelT<T, in_size, out_size,
+        RTNeural::DenseT<T, in_size, dense_size>,
+        RTNeural::TanhActivationT<T, dense_size>,
+        RTNeural::GRULayerT<T, dense_size, gru_size>,
+        RTNeural::DenseT<T, gru_size, out_size>>
+        staticModel;
+    staticModel.template get<0>().setWeights(dense1Weights);
+    staticModel.template get<0>().setBias(dense1Bias.data());
+    staticModel.template get<2>().setWVals(gruW);
+    staticModel.template get<2>().setUVals(gruU);
+    staticModel.template get<2>().setBVals(gruB);
+    staticModel.template get<3>().setWeights(dense2Weights);
+    staticModel.template get<3>().setBias(dense2Bias.data());
+    staticModel.reset();
+
+    RTNeural::Model<T> dynamicModel(in_size);
+    auto* dense1 = new RTNeural::Dense<T>(in_size, dense_size);
+    dense1->setWeights(dense1Weights);
+    dense1->setBias(dense1Bias.data());
+    dynamicModel.addLayer(dense1);
+    dynamicModel.addLayer(new RTNeural::TanhActivation<T>(dense_size));
+    auto* gru = new RTNeural::GRULayer<T>(dense_size, gru_size);
+    gru->setWVals(gruW);
+    gru->setUVals(gruU);
+    gru->setBVals(gruB);
+    dynamicModel.addLayer(gru);
+    auto* dense2 = new RTNeural::Dense<T>(gru_size, out_size);
+    dense2->setWeights(dense2Weights);
+    dense2->setBias(dense2Bias.data());
+    dynamicModel.addLayer(dense2);
+    dynamicModel.reset();
+
+    EXPECT_TRUE(isAligned(staticModel.getOutputs()));
+#if RTNEURAL_USE_EIGEN || RTNEURAL_USE_XSIMD // the STL backend does not use aligned allocators
+    EXPECT_TRUE(isAligned(dynamicModel.getOutputs()));
+#endif
+
+    std::uniform_real_distribution<T> dist((T)-1, (T)1);
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T input alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+    for(int n = 0; n < 100; ++n)
+    {
+        for(int i = 0; i < in_size; ++i)
+            input[i] = dist(rng);
+
+        staticModel.forward(input);
+        dynamicModel.forward(input);
+
+        const auto staticOuts = std::vector<T>(staticModel.getOutputs(), staticModel.getOutputs() + out_size);
+        const auto dynamicOuts = std::vector<T>(dynamicModel.getOutputs(), dynamicModel.getOutputs() + out_size);
+        EXPECT_THAT(staticOuts, testing::Pointwise(testing::FloatNear(tolerance), dynamicOuts));
+    }
+}
+} // namespace
+
+TEST(TestSIMDAlignment, alignmentMatchesSIMDBackend)
+{
+#if RTNEURAL_USE_EIGEN
+    EXPECT_EQ((int)RTNeural::RTNeuralEigenAlignment, RTNEURAL_DEFAULT_ALIGNMENT);
+#elif RTNEURAL_USE_XSIMD
+    EXPECT_LE(xsimd::simd_type<float>::size * sizeof(float), (size_t)RTNEURAL_DEFAULT_ALIGNMENT);
+    EXPECT_LE(xsimd::simd_type<double>::size * sizeof(double), (size_t)RTNEURAL_DEFAULT_ALIGNMENT);
+#endif
+}
+
+TEST(TestSIMDAlignment, modelOutputsAreAligned)
+{
+    runAlignmentTest<float>(1.0e-5f);
+    runAlignmentTest<double>(1.0e-12);
+}
@@ -0,0 +1,253 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+/**
+ * Zeros out a fraction of the matrix, in blocks of block_size consecutive
+ * columns. With block_size = 16 (a multiple of every SIMD width), the
+ * pruned blocks line up with the SIMD-width blocks in the templated layers.
+ */
+template <typename T>
+void prune(std::vector<std::vector<T>>& mat, double sparsity, int block_size, std::mt19937& rng)
+{
+    std::bernoulli_distribution dist(sparsity);
+    for(auto& row : mat)
+    {
+        for(size_t i = 0; i < row.size(); i += (size_t)block_size)
+        {
+            if(dist(rng))
+                std::fill(row.begin() + (long)i, row.begin() + (long)std::min(i + (size_t)block_size, row.size()), (T)0);
+        }
+    }
+}
+
+nlohmann::json denseModelJson(const std::vector<std::vector<float>>& weights, const std::vector<float>& bias)
+{
+    // json stores the kernel as kernel[in_size][out_size]
+    const auto out_size = weights.size();
+    const auto in_size = weights[0].size();
+    std::vector<std::vector<float>> kernel(in_size, std::vector<float>(out_size));
+    for(size_t i = 0; i < out_size; ++i)
+        for(size_t k = 0; k < in_size; ++k)
+            kernel[k][i] = weights[i][k];
+
+    nlohmann::json layer;
+    layer["type"] = "dense";
+    layer["shape"] = { nullptr, nullptr, out_size };
+    layer["weights"] = { kernel, bias };
+    layer["activation"] = "";
+
+    nlohmann::json model;
+    model["in_shape"] = { nullptr, nullptr, in_size };
+    model["layers"] = { layer };
+    return model;
+}
+} // namespace
+
+TEST(TestSparseLayers, SparseDenseMatchesDense)
+{
+    using T = float;
+    constexpr int in_size = 40;
+    constexpr int out_size = 24;
+    constexpr int num_samples = 50;
+
+    std::mt19937 rng { 0x1234 };
+    auto weights = randomMatrix<T>(rng, out_size, in_size);
+    prune(weights, 0.8, 1, rng);
+    const auto bias = randomMatrix<T>(rng, 1, out_size)[0];
+
+    RTNeural::Dense<T> dense(in_size, out_size);
+    dense.setWeights(weights);
+    dense.setBias(bias.data());
+
+    RTNeural::SparseDense<T> sparse(in_size, out_size);
+    sparse.setWeights(weights);
+    sparse.setBias(bias.data());
+
+    int num_non_zeros = 0;
+    for(int i = 0; i < out_size; ++i)
+    {
+        for(int k = 0; k < in_size; ++k)
+        {
+            EXPECT_EQ(sparse.getWeight(i, k), weights[i][k]);
+            num_non_zeros += weights[i][k] != (T)0 ? 1 : 0;
+        }
+        EXPECT_EQ(sparse.getBias(i), bias[i]);
+    }
+    EXPECT_EQ(sparse.getNumNonZeros(), num_non_zeros);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+    std::vector<T> expected((size_t)num_samples * out_size);
+    std::vector<T> actual((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        dense.forward(&input[(size_t)n * in_size], &expected[(size_t)n * out_size]);
+        sparse.forward(&input[(size_t)n * in_size], &actual[(size_t)n * out_size]);
+    }
+
+    using namespace testing;
+    EXPECT_THAT(actual, Pointwise(FloatNear(1.0e-5f), expected));
+
+    std::vector<T> blockOutput((size_t)num_samples * out_size);
+    sparse.forwardBlock(input.data(), blockOutput.data(), num_samples);
+    EXPECT_THAT(blockOutput, Pointwise(FloatNear(1.0e-5f), expected));
+}
+
+TEST(TestSparseLayers, LoaderPicksSparseDense)
+{
+    using T = float;
+    constexpr int in_size = 32;
+    constexpr int out_size = 8;
+    constexpr int num_samples = 20;
+
+    std::mt19937 rng { 0x1234 };
+    auto weights = randomMatrix<T>(rng, out_size, in_size);
+    const auto bias = randomMatrix<T>(rng, 1, out_size)[0];
+    const auto input = randomSignal<T>(num_samples, in_size);
+
+    // dense weights should load as a regular Dense layer
+    {
+        auto model = RTNeural::json_parser::parseJson<T>(denseModelJson(weights, bias));
+        EXPECT_NE(dynamic_cast<RTNeural::Dense<T>*>(model->layers[0]), nullptr);
+    }
+
+    prune(weights, 0.98, 1, rng);
+    auto sparseModel = RTNeural::json_parser::parseJson<T>(denseModelJson(weights, bias));
+    ASSERT_NE(dynamic_cast<RTNeural::SparseDense<T>*>(sparseModel->layers[0]), nullptr);
+    EXPECT_EQ(sparseModel->layers[0]->getName(), "dense");
+
+    // a threshold above 1 disables the sparse layers
+    auto denseModel = RTNeural::json_parser::parseJson<T>(denseModelJson(weights, bias), false, 2.0);
+    ASSERT_NE(dynamic_cast<RTNeural::Dense<T>*>(denseModel->layers[0]), nullptr);
+
+    using namespace testing;
+    EXPECT_THAT(runDynamicModel(*sparseModel, input, num_samples),
+        Pointwise(FloatNear(1.0e-5f), runDynamicModel(*denseModel, input, num_samples)));
+}
+
+TEST(TestSparseLayers, BlockSparseDenseT)
+{
+    using T = float;
+    constexpr int in_size = 24;
+    constexpr int out_size = 48;
+    constexpr int num_samples = 50;
+
+    std::mt19937 rng { 0x1234 };
+    auto weights = randomMatrix<T>(rng, out_size, in_size);
+    const auto bias = randomMatrix<T>(rng, 1, out_size)[0];
+
+    // prune blocks of consecutive outputs, for each input
+    std::vector<std::vector<T>> weightsT(in_size, std::vector<T>(out_size));
+    for(int i = 0; i < out_size; ++i)
+        for(int k = 0; k < in_size; ++k)
+            weightsT[k][i] = weights[i][k];
+    prune(weightsT, 0.8, 16, rng);
+    for(int i = 0; i < out_size; ++i)
+        for(int k = 0; k < in_size; ++k)
+            weights[i][k] = weightsT[k][i];
+
+    using BlockSparseDense = RTNeural::DenseT<T, in_size, out_size, true, RTNeural::fused_activation::Identity, true>;
+    RTNeural::ModelT<T, in_size, out_size, BlockSparseDense> modelT;
+    modelT.get<0>().setWeights(weights);
+    modelT.get<0>().setBias(bias.data());
+#if RTNEURAL_USE_XSIMD
+    EXPECT_TRUE(modelT.get<0>().isSparse());
+
+    // layers are only block-sparse when asked for
+    RTNeural::DenseT<T, in_size, out_size> denseT;
+    denseT.setWeights(weights);
+    EXPECT_FALSE(denseT.isSparse());
+#endif
+
+    RTNeural::Model<T> model(in_size);
+    auto* dense = new RTNeural::Dense<T>(in_size, out_size);
+    dense->setWeights(weights);
+    dense->setBias(bias.data());
+    model.addLayer(dense);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+
+    using namespace testing;
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples),
+        Pointwise(FloatNear(1.0e-5f), runDynamicModel(model, input, num_samples)));
+}
+
+TEST(TestSparseLayers, BlockSparseGRU)
+{
+    using T = float;
+    constexpr int in_size = 4;
+    constexpr int out_size = 32;
+    constexpr int num_samples = 100;
+
+    std::mt19937 rng { 0x1234 };
+    auto wVals = randomMatrix<T>(rng, in_size, 3 * out_size);
+    auto uVals = randomMatrix<T>(rng, out_size, 3 * out_size);
+    const auto bVals = randomMatrix<T>(rng, 2, 3 * out_size);
+    prune(wVals, 0.75, 16, rng);
+    prune(uVals, 0.75, 16, rng);
+
+    using BlockSparseGRU = RTNeural::GRULayerT<T, in_size, out_size, RTNeural::SampleRateCorrectionMode::None, RTNeural::DefaultMathsProvider, true>;
+    RTNeural::ModelT<T, in_size, out_size, BlockSparseGRU> modelT;
+    modelT.get<0>().setWVals(wVals);
+    modelT.get<0>().setUVals(uVals);
+    modelT.get<0>().setBVals(bVals);
+#if RTNEURAL_USE_XSIMD
+    EXPECT_TRUE(modelT.get<0>().isSparse());
+#endif
+
+    RTNeural::Model<T> model(in_size);
+    auto* gru = new RTNeural::GRULayer<T>(in_size, out_size);
+    gru->setWVals(wVals);
+    gru->setUVals(uVals);
+    gru->setBVals(bVals);
+    model.addLayer(gru);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+
+    using namespace testing;
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples),
+        Pointwise(FloatNear(1.0e-5f), runDynamicModel(model, input, num_samples)));
+}
+
+TEST(TestSparseLayers, BlockSparseLSTM)
+{
+    using T = float;
+    constexpr int in_size = 4;
+    constexpr int out_size = 32;
+    constexpr int num_samples = 100;
+
+    std::mt19937 rng { 0x1234 };
+    auto wVals = randomMatrix<T>(rng, in_size, 4 * out_size);
+    auto uVals = randomMatrix<T>(rng, out_size, 4 * out_size);
+    const auto bVals = randomMatrix<T>(rng, 1, 4 * out_size)[0];
+    prune(wVals, 0.75, 16, rng);
+    prune(uVals, 0.75, 16, rng);
+
+    using BlockSparseLSTM = RTNeural::LSTMLayerT<T, in_size, out_size, RTNeural::SampleRateCorrectionMode::None, RTNeural::DefaultMathsProvider, true>;
+    RTNeural::ModelT<T, in_size, out_size, BlockSparseLSTM> modelT;
+    modelT.get<0>().setWVals(wVals);
+    modelT.get<0>().setUVals(uVals);
+    modelT.get<0>().setBVals(bVals);
+#if RTNEURAL_USE_XSIMD
+    EXPECT_TRUE(modelT.get<0>().isSparse());
+#endif
+
+    RTNeural::Model<T> model(in_size);
+    auto* lstm = new RTNeural::LSTMLayer<T>(in_size, out_size);
+    lstm->setWVals(wVals);
+    lstm->setUVals(uVals);
+    lstm->setBVals(bVals);
+    model.addLayer(lstm);
+
+    const auto input = randomSignal<T>(num_samples, in_size);
+
+    using namespace testing;
+    EXPECT_THAT(runTemplatedModel<T>(modelT, input, num_samples),
+        Pointwise(FloatNear(1.0e-5f), runDynamicModel(model, input, num_samples)));
+}
@@ -0,0 +1,203 @@
+#include <gmock/gmock.h>
+
+#include "load_csv.hpp"
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+constexpr int num_samples = 100;
+
+/** The parameters of a TCN block, and the unfused reference layers. */
+template <typename T>
+struct TCNBlockParams
+{
+    TCNBlockParams(int in_size, int out_size, int kernel_size, int dilation, int residual_groups)
+        : conv(in_size, out_size, kernel_size, dilation)
+        , bn(out_size)
+        , prelu(out_size)
+        , res(in_size, out_size, 1, 1, residual_groups)
+    {
+        std::mt19937 rng { 0x7531 };
+        weights = randomConvWeights<T>(rng, out_size, in_size, kernel_size);
+        bias = randomVector<T>(rng, (size_t)out_size);
+        gamma = randomVector<T>(rng, (size_t)out_size, (T)0.5, (T)1.5);
+        beta = randomVector<T>(rng, (size_t)out_size);
+        mean = randomVector<T>(rng, (size_t)out_size);
+        variance = randomVector<T>(rng, (size_t)out_size, (T)0.5, (T)2);
+        alpha = randomVector<T>(rng, (size_t)out_size, (T)0, (T)0.5);
+        for(const auto& filter : randomConvWeights<T>(rng, out_size, in_size / residual_groups, 1))
+        {
+            res_weights.emplace_back();
+            for(const auto& channel : filter)
+                res_weights.back().push_back(channel[0]);
+        }
+
+        conv.setWeights(weights);
+        conv.setBias(bias);
+        bn.setGamma(gamma);
+        bn.setBeta(beta);
+        bn.setRunningMean(mean);
+        bn.setRunningVariance(variance);
+        bn.setEpsilon(epsilon);
+        prelu.setAlphaVals(alpha);
+
+        Weights<T> res_conv_weights;
+        for(const auto& filter : res_weights)
+        {
+            res_conv_weights.emplace_back();
+            for(const auto& w : filter)
+                res_conv_weights.back().push_back({ w });
+        }
+        res.setWeights(res_conv_weights);
+        res.setBias(std::vector<T>((size_t)out_size, (T)0));
+    }
+
+    template <typename BlockType>
+    void load(BlockType& block) const
+    {
+        block.setWeights(weights);
+        block.setBias(bias);
+        block.setBatchNorm(gamma, beta, mean, variance, epsilon);
+        block.setAlphaVals(alpha);
+        block.setResidualWeights(res_weights);
+    }
+
+    /** Runs the unfused reference layers. */
+    std::vector<T> reference(const std::vector<T>& input)
+    {
+        const auto in_size = conv.in_size;
+        const auto out_size = conv.out_size;
+        std::vector<T> x((size_t)in_size), y((size_t)out_size), z((size_t)out_size), r((size_t)out_size);
+        std::vector<T> output;
+        conv.reset();
+        res.reset();
+        for(size_t n = 0; n < input.size() / (size_t)in_size; ++n)
+        {
+            std::copy(&input[n * (size_t)in_size], &input[(n + 1) * (size_t)in_size], x.begin());
+            conv.forward(x.data(), y.data());
+            bn.forward(y.data(), z.data());
+            prelu.forward(z.data(), y.data());
+            res.forward(x.data(), r.data());
+            for(int i = 0; i < out_size; ++i)
+                output.push_back(y[(size_t)i] + r[(size_t)i]);
+        }
+        return output;
+    }
+
+    Weights<T> weights;
+    std::vector<T> bias, gamma, beta, mean, variance, alpha;
+    std::vector<std::vector<T>> res_weights;
+    const T epsilon = (T)1.0e-3;
+
+    RTNeural::Conv1D<T> conv;
+    RTNeural::BatchNorm1DLayer<T> bn;
+    RTNeural::PReLUActivation<T> prelu;
+    RTNeural::Conv1D<T> res;
+};
+
+template <typename T, int in_size, int out_size, int kernel_size, int dilation, int residual_groups>
+void testTCNBlock()
+{
+    TCNBlockParams<T> params(in_size, out_size, kernel_size, dilation, residual_groups);
+    std::mt19937 rng { 0x2468 };
+    const auto input = randomVector<T>(rng, (size_t)(num_samples * in_size), (T)-1, (T)1);
+    const auto expected = params.reference(input);
+
+    using namespace testing;
+    {
+        RTNeural::TCNBlock<T> block(in_size, out_size, kernel_size, dilation, residual_groups);
+        params.load(block);
+        block.reset();
+
+        std::vector<T> actual(expected.size());
+        for(int n = 0; n < num_samples; ++n)
+            block.forward(&input[(size_t)(n * in_size)], &actual[(size_t)(n * out_size)]);
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+
+    {
+        RTNeural::ModelT<T, in_size, out_size,
+            RTNeural::TCNBlockT<T, in_size, out_size, kernel_size, dilation, residual_groups>>
+            model;
+        params.load(model.template get<0>());
+        model.reset();
+
+        T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+        std::vector<T> actual(expected.size());
+        for(int n = 0; n < num_samples; ++n)
+        {
+            std::copy(&input[(size_t)(n * in_size)], &input[(size_t)((n + 1) * in_size)], x);
+            model.forward(x);
+            std::copy(model.getOutputs(), model.getOutputs() + out_size, &actual[(size_t)(n * out_size)]);
+        }
+
+        EXPECT_THAT(actual, Pointwise(FloatNear((T)1.0e-5), expected));
+    }
+}
+
+/** Returns the state_dict of the MicroTCN block in models/microtcn/ */
+nlohmann::json loadMicroTCNStateDict()
+{
+    nlohmann::json state_dict;
+    for(const std::string module : { "conv1", "bn", "relu", "res" })
+    {
+        std::ifstream jsonStream(std::string { RTNEURAL_ROOT_DIR } + "models/microtcn/" + module + ".json", std::ifstream::binary);
+        nlohmann::json moduleJson;
+        jsonStream >> moduleJson;
+        for(const auto& param : moduleJson.items())
+            state_dict[module + "." + param.key()] = param.value();
+    }
+    return state_dict;
+}
+
+template <typename T, typename BlockType, typename ProcessFunc>
+void testMicroTCN(BlockType& block, ProcessFunc&& process)
+{
+    RTNeural::torch_helpers::loadTCNBlock<T>(loadMicroTCNStateDict(), "", block);
+    block.reset();
+
+    std::ifstream modelInputsFile { std::string { RTNEURAL_ROOT_DIR } + "test_data/microtcn_x.csv" };
+    const auto inputs = load_csv::loadFile2d<T>(modelInputsFile);
+    std::ifstream modelOutputsFile { std::string { RTNEURAL_ROOT_DIR } + "test_data/microtcn_y.csv" };
+    const auto expected_y = RTNeural::torch_helpers::detail::transpose(load_csv::loadFile2d<T>(modelOutputsFile));
+
+    constexpr int out_size = 32;
+    std::vector<T> outputs(inputs.size() * out_size);
+    for(size_t n = 0; n < inputs.size(); ++n)
+        process(inputs[n][0], &outputs[n * out_size]);
+
+    // PyTorch computes the unpadded convolution, which skips the first (kernel_size - 1) * dilation outputs
+    const size_t crop = 3 * 10;
+    ASSERT_EQ(expected_y.size() + crop, inputs.size());
+    for(size_t n = 0; n < expected_y.size(); ++n)
+    {
+        for(size_t j = 0; j < (size_t)out_size; ++j)
+            EXPECT_NEAR(outputs[(n + crop) * out_size + j], expected_y[n][j], 1.0e-5);
+    }
+}
+} // namespace
+
+TEST(TestTCNBlock, MatchesUnfusedLayers)
+{
+    testTCNBlock<float, 4, 8, 3, 2, 4>();
+    testTCNBlock<float, 4, 8, 3, 2, 1>();
+    testTCNBlock<double, 8, 8, 5, 3, 8>();
+}
+
+TEST(TestTCNBlock, TorchMicroTCN)
+{
+    RTNeural::TCNBlock<float> block(1, 32, 4, 10, 1);
+    testMicroTCN<float>(block, [&block](float x, float* out)
+        { block.forward(&x, out); });
+
+    RTNeural::ModelT<double, 1, 32, RTNeural::TCNBlockT<double, 1, 32, 4, 10>> model;
+    testMicroTCN<double>(model.get<0>(), [&model](double x, double* out)
+        {
+            model.forward(&x);
+            std::copy(model.getOutputs(), model.getOutputs() + 32, out); });
+}
@@ -188,3 +188,55 @@ TEST(TestTemplatedModels, modelOutputMatchesPythonImplementationForLSTM1DWithMat
 
     runTestTemplated<TestType, ModelType>(tests.at("lstm_1d"));
 }
+
+namespace
+{
+TestConfig withThreshold(const TestConfig& test, double threshold)
+{
+    return TestConfig { test.name, test.model_file, test.x_data_file, test.y_data_file, threshold };
+}
+
+template <typename MathsProvider>
+void runApproxMathsProviderTests()
+{
+    // the approximate providers are less accurate than the python reference
+    constexpr double threshold = 2.5e-4;
+
+    using GRUModelType = ModelT<TestType, 1, 1,
+        DenseT<TestType, 1, 8>,
+        TanhActivationT<TestType, 8, MathsProvider>,
+        GRULayerT<TestType, 8, 8, RTNeural::SampleRateCorrectionMode::None, MathsProvider>,
+        DenseT<TestType, 8, 8>,
+        SigmoidActivationT<TestType, 8, MathsProvider>,
+        DenseT<TestType, 8, 1>>;
+    runTestTemplated<TestType, GRUModelType>(withThreshold(tests.at("gru"), threshold));
+
+    using LSTMModelType = ModelT<TestType, 1, 1,
+        DenseT<TestType, 1, 8>,
+        TanhActivationT<TestType, 8, MathsProvider>,
+        LSTMLayerT<TestType, 8, 8, RTNeural::SampleRateCorrectionMode::None, MathsProvider>,
+        DenseT<TestType, 8, 1>>;
+    runTestTemplated<TestType, LSTMModelType>(withThreshold(tests.at("lstm"), threshold));
+}
+} // namespace
+
+TEST(TestTemplatedModels, modelOutputMatchesPythonImplementationWithPadeMathsProvider)
+{
+    runApproxMathsProviderTests<RTNeural::PadeMathsProvider>();
+}
+
+TEST(TestTemplatedModels, modelOutputMatchesPythonImplementationWithExp2MathsProvider)
+{
+    runApproxMathsProviderTests<RTNeural::Exp2MathsProvider>();
+}
+
+TEST(TestTemplatedModels, modelOutputMatchesPythonImplementationWithPolynomialMathsProvider)
+{
+    runApproxMathsProviderTests<RTNeural::PolynomialMathsProvider>();
+}
+
+TEST(TestTemplatedModels, modelOutputMatchesPythonImplementationWithLUTMathsProvider)
+{
+    runApproxMathsProviderTests<RTNeural::LUTMathsProvider<>>();
+    runApproxMathsProviderTests<RTNeural::LUTMathsProvider<512, 8, RTNeural::approx_maths::LUTInterpolation::Cubic>>();
+}
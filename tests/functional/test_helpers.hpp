@@ -0,0 +1,235 @@
+#pragma once
+
+#include <RTNeural/RTNeural.h>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Helpers for generating random weights and inputs, and for running models
+ * against a reference implementation, shared by the functional tests
+ * and the benchmarks (so they must not depend on gtest).
+ */
+namespace test_helpers
+{
+
+template <typename T>
+using Weights = std::vector<std::vector<std::vector<T>>>;
+
+using Frames = std::vector<std::vector<float>>;
+
+//====================================================
+template <typename T = float, typename RNG>
+std::vector<T> randomVector(RNG& rng, size_t size, T min_val = (T)-0.5, T max_val = (T)0.5)
+{
+    std::uniform_real_distribution<T> dist(min_val, max_val);
+    std::vector<T> vec(size);
+    for(auto& x : vec)
+        x = dist(rng);
+    return vec;
+}
+
+template <typename T = float, typename RNG>
+std::vector<std::vector<T>> randomMatrix(RNG& rng, int rows, int cols, T range = (T)0.5)
+{
+    std::vector<std::vector<T>> mat((size_t)rows);
+    for(auto& row : mat)
+        row = randomVector<T>(rng, (size_t)cols, -range, range);
+    return mat;
+}
+
+/** Returns random convolution weights, as weights[out_size][filters_per_group][kernel_size]. */
+template <typename T, typename RNG>
+Weights<T> randomConvWeights(RNG& rng, int out_size, int filters_per_group, int kernel_size, T range = (T)0.5)
+{
+    Weights<T> weights((size_t)out_size);
+    for(auto& filter : weights)
+        filter = randomMatrix<T>(rng, filters_per_group, kernel_size, range);
+    return weights;
+}
+
+/** Returns a random (reproducible) input signal, with input[num_samples][in_size]. */
+template <typename T>
+std::vector<T> randomSignal(int num_samples, int in_size)
+{
+    std::mt19937 rng { 0x5678 };
+    return randomVector<T>(rng, (size_t)(num_samples * in_size), (T)-1, (T)1);
+}
+
+template <typename T>
+std::vector<std::vector<T>> transpose(const std::vector<std::vector<T>>& mat)
+{
+    std::vector<std::vector<T>> matT(mat[0].size(), std::vector<T>(mat.size()));
+    for(size_t i = 0; i < mat.size(); ++i)
+        for(size_t j = 0; j < mat[i].size(); ++j)
+            matT[j][i] = mat[i][j];
+    return matT;
+}
+
+//====================================================
+/** Returns a random tensor, as a (nested) json array of the given shape. */
+template <typename RNG>
+nlohmann::json randomTensor(RNG& rng, const std::vector<int>& shape, float min_val = -0.5f, float max_val = 0.5f, size_t dim = 0)
+{
+    std::uniform_real_distribution<float> dist(min_val, max_val);
+    auto tensor = nlohmann::json::array();
+    for(int i = 0; i < shape[dim]; ++i)
+    {
+        if(dim + 1 == shape.size())
+            tensor.push_back(dist(rng));
+        else
+            tensor.push_back(randomTensor(rng, shape, min_val, max_val, dim + 1));
+    }
+    return tensor;
+}
+
+/** Returns the json for a layer, as exported by the RTNeural python tools. */
+inline nlohmann::json makeLayer(const std::string& type, int out_size, const std::string& activation, const nlohmann::json& weights)
+{
+    nlohmann::json layer;
+    layer["type"] = type;
+    layer["activation"] = activation;
+    layer["shape"] = { nullptr, nullptr, out_size };
+    layer["weights"] = weights;
+    return layer;
+}
+
+/** Returns the json for a batchnorm layer, with random statistics (and optionally random gamma and beta). */
+template <typename RNG>
+nlohmann::json makeBatchNorm(RNG& rng, int size, bool affine = true)
+{
+    auto weights = nlohmann::json::array();
+    if(affine)
+    {
+        weights.push_back(randomTensor(rng, { size }, 0.5f, 1.5f));
+        weights.push_back(randomTensor(rng, { size }));
+    }
+    weights.push_back(randomTensor(rng, { size }));
+    weights.push_back(randomTensor(rng, { size }, 0.5f, 2.0f));
+
+    auto bn = makeLayer("batchnorm", size, "", weights);
+    bn["epsilon"] = 0.001;
+    return bn;
+}
+
+//====================================================
+/** Direct-form reference (grouped and dilated) convolution, with input[num_samples][in_size]. */
+template <typename T>
+std::vector<T> referenceConv(const std::vector<T>& input, const Weights<T>& weights, const std::vector<T>& bias,
+    int in_size, int out_size, int kernel_size, int dilation, int groups)
+{
+    const auto num_samples = (int)input.size() / in_size;
+    const auto filters_per_group = in_size / groups;
+    const auto channels_per_group = out_size / groups;
+
+    std::vector<T> output((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        for(int i = 0; i < out_size; ++i)
+        {
+            const auto ii = (i / channels_per_group) * filters_per_group;
+            double sum = bias[(size_t)i];
+            for(int k = 0; k < kernel_size && n - k * dilation >= 0; ++k)
+                for(int c = 0; c < filters_per_group; ++c)
+                    sum += (double)weights[(size_t)i][(size_t)c][(size_t)k] * (double)input[(size_t)(n - k * dilation) * in_size + ii + c];
+            output[(size_t)n * out_size + i] = (T)sum;
+        }
+    }
+
+    return output;
+}
+
+//====================================================
+/** Runs a dynamic model over an input signal, with input[num_samples][in_size]. */
+template <typename T>
+std::vector<T> runDynamicModel(RTNeural::Model<T>& model, const std::vector<T>& input, int num_samples)
+{
+    const auto in_size = model.getInSize();
+    const auto out_size = model.getOutSize();
+
+    model.reset();
+    std::vector<T> output((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        model.forward(&input[(size_t)n * in_size]);
+        std::copy(model.getOutputs(), model.getOutputs() + out_size, &output[(size_t)n * out_size]);
+    }
+
+    return output;
+}
+
+/** Runs a templated model over an input signal, with input[num_samples][in_size]. */
+template <typename T, typename ModelType>
+std::vector<T> runTemplatedModel(ModelType& model, const std::vector<T>& input, int num_samples)
+{
+    static constexpr int in_size = ModelType::input_size;
+    static constexpr int out_size = ModelType::output_size;
+
+    // ModelT::forward() expects aligned inputs, padded to the SIMD width
+    T x alignas(RTNEURAL_DEFAULT_ALIGNMENT)[RTNeural::ceil_div(in_size, 16) * 16] {};
+
+    model.reset();
+    std::vector<T> output((size_t)num_samples * out_size);
+    for(int n = 0; n < num_samples; ++n)
+    {
+        std::copy(&input[(size_t)n * in_size], &input[(size_t)(n + 1) * in_size], x);
+        model.forward(x);
+        std::copy(model.getOutputs(), model.getOutputs() + out_size, &output[(size_t)n * out_size]);
+    }
+
+    return output;
+}
+
+//====================================================
+/** Returns random (reproducible) input frames, in the range [-1, 1]. */
+inline Frames makeInputs(int num_frames, int size, std::mt19937::result_type seed)
+{
+    std::mt19937 rng { seed };
+    Frames inputs((size_t)num_frames);
+    for(auto& x : inputs)
+        x = randomVector(rng, (size_t)size, -1.0f, 1.0f);
+    return inputs;
+}
+
+/** Copies a frame into an aligned (and padded) array, as the templated models expect. */
+struct AlignedFrame
+{
+    explicit AlignedFrame(const std::vector<float>& x) { std::copy(x.begin(), x.end(), data); }
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) float data[16] {};
+};
+
+/**
+ * Returns the outputs of a (stateful) reference implementation,
+ * where `reference.process(x)` returns the output frame for an input frame.
+ */
+template <typename Reference>
+Frames referenceOutputs(Reference& reference, const Frames& inputs)
+{
+    Frames outputs;
+    for(const auto& x : inputs)
+        outputs.push_back(reference.process(x));
+    return outputs;
+}
+
+/**
+ * Returns the largest difference between the expected output frames and the outputs
+ * of `process(x)`, which is given each input frame as an aligned (and padded) array,
+ * and returns a pointer to the output frame.
+ */
+template <typename ProcessFunc>
+float maxError(const Frames& inputs, const Frames& expected, ProcessFunc&& process)
+{
+    float max_error = 0.0f;
+    for(size_t n = 0; n < inputs.size(); ++n)
+    {
+        const AlignedFrame x { inputs[n] };
+        const auto* y = process(x.data);
+        for(size_t i = 0; i < expected[n].size(); ++i)
+            max_error = std::max(max_error, std::abs(y[i] - expected[n][i]));
+    }
+    return max_error;
+}
+
+} // namespace test_helpers
@@ -39,7 +39,7 @@ void testTorchConv1DGroupModel()
 
     for(size_t i = 0; i < inputs.size(); ++i)
     {
-        alignas(16) T input_copy[input_size + 4] {};
+        alignas(RTNEURAL_DEFAULT_ALIGNMENT) T input_copy[RTNeural::ceil_div(input_size, 16) * 16] {};
         std::copy(inputs[i].begin(), inputs[i].end(), std::begin(input_copy));
         model.forward(input_copy);
         std::copy(model.getOutputs(), model.getOutputs() + output_size, outputs[i].begin());
@@ -0,0 +1,531 @@
+#include <gmock/gmock.h>
+
+#include "test_helpers.hpp"
+#include <RTNeural/RTNeural.h>
+#include <deque>
+#include <random>
+
+namespace
+{
+using namespace test_helpers;
+
+using Matrix = std::vector<std::vector<float>>;
+using Kernel = std::vector<std::vector<std::vector<float>>>;
+
+constexpr int num_samples = 200;
+
+Matrix identity(int size)
+{
+    Matrix m((size_t)size, std::vector<float>((size_t)size, 0.0f));
+    for(int i = 0; i < size; ++i)
+        m[(size_t)i][(size_t)i] = 1.0f;
+    return m;
+}
+
+/** A straightforward implementation of a WaveNet stack, to check the packed layers against. */
+struct ReferenceWaveNet
+{
+    struct LayerWeights
+    {
+        Kernel conv; // [2 * channels][channels][kernel_size], where k is the delay (in units of the dilation)
+        std::vector<float> conv_bias;
+        Matrix mixin;
+        Matrix residual;
+        std::vector<float> residual_bias;
+        Matrix skip;
+        std::vector<float> skip_bias;
+    };
+
+    ReferenceWaveNet(int in_size, int out_size, int channels, int skip_channels, int kernel_size, std::vector<int> dilations,
+        bool identity_skips = false)
+        : in_size(in_size)
+        , out_size(out_size)
+        , channels(channels)
+        , skip_channels(skip_channels)
+        , kernel_size(kernel_size)
+        , dilations(dilations)
+    {
+        std::mt19937 rng { 0x9876 };
+        input_weights = randomMatrix(rng, channels, in_size);
+        input_bias = identity_skips ? std::vector<float>((size_t)channels, 0.0f) : randomVector(rng, channels);
+
+        for(size_t l = 0; l < dilations.size(); ++l)
+        {
+            LayerWeights lw;
+            lw.conv.resize((size_t)(2 * channels));
+            for(auto& kernel : lw.conv)
+                kernel = randomMatrix(rng, channels, kernel_size);
+            lw.conv_bias = randomVector(rng, 2 * channels);
+            lw.mixin = randomMatrix(rng, 2 * channels, in_size);
+            lw.residual = randomMatrix(rng, channels, channels);
+            lw.residual_bias = randomVector(rng, channels);
+            lw.skip = identity_skips ? identity(channels) : randomMatrix(rng, skip_channels, channels);
+            lw.skip_bias = identity_skips ? std::vector<float>((size_t)channels, 0.0f) : randomVector(rng, skip_channels);
+            layers.push_back(lw);
+        }
+
+        output_weights = randomMatrix(rng, out_size, skip_channels);
+        output_bias = randomVector(rng, out_size);
+
+        history.resize(dilations.size());
+    }
+
+    template <typename WaveNetType>
+    void setWeights(WaveNetType& wavenet) const
+    {
+        auto& layerArray = wavenet.getLayerArray(0);
+        layerArray.setInputWeights(input_weights, input_bias);
+        for(size_t l = 0; l < layers.size(); ++l)
+        {
+            layerArray.setConvWeights((int)l, layers[l].conv, layers[l].conv_bias);
+            layerArray.setMixinWeights((int)l, layers[l].mixin);
+            layerArray.setResidualWeights((int)l, layers[l].residual, layers[l].residual_bias);
+            layerArray.setSkipWeights((int)l, layers[l].skip, layers[l].skip_bias);
+        }
+        layerArray.setOutputWeights(output_weights, output_bias);
+    }
+
+    std::vector<float> process(const std::vector<float>& input)
+    {
+        const auto* x = input.data();
+        const auto project = [](const Matrix& w, const std::vector<float>& b, const float* in)
+        {
+            auto out = b;
+            for(size_t i = 0; i < w.size(); ++i)
+                for(size_t j = 0; j < w[i].size(); ++j)
+                    out[i] += w[i][j] * in[j];
+            return out;
+        };
+
+        auto h = project(input_weights, input_bias, x);
+        std::vector<float> skip((size_t)skip_channels, 0.0f);
+        for(size_t l = 0; l < layers.size(); ++l)
+        {
+            const auto& lw = layers[l];
+            history[l].push_front(h);
+
+            auto z = project(lw.mixin, lw.conv_bias, x);
+            for(int k = 0; k < kernel_size; ++k)
+            {
+                const auto delay = (size_t)(k * dilations[l]);
+                if(delay >= history[l].size())
+                    continue;
+
+                for(size_t i = 0; i < z.size(); ++i)
+                    for(int j = 0; j < channels; ++j)
+                        z[i] += lw.conv[i][(size_t)j][(size_t)k] * history[l][delay][(size_t)j];
+            }
+
+            std::vector<float> g((size_t)channels);
+            for(size_t i = 0; i < g.size(); ++i)
+                g[i] = std::tanh(z[i]) * (1.0f / (1.0f + std::exp(-z[i + g.size()])));
+
+            const auto skip_out = project(lw.skip, lw.skip_bias, g.data());
+            for(size_t i = 0; i < skip.size(); ++i)
+                skip[i] += skip_out[i];
+
+            const auto res = project(lw.residual, lw.residual_bias, g.data());
+            for(size_t i = 0; i < h.size(); ++i)
+                h[i] += res[i];
+        }
+
+        return project(output_weights, output_bias, skip.data());
+    }
+
+    const int in_size;
+    const int out_size;
+    const int channels;
+    const int skip_channels;
+    const int kernel_size;
+    const std::vector<int> dilations;
+
+    Matrix input_weights;
+    std::vector<float> input_bias;
+    std::vector<LayerWeights> layers;
+    Matrix output_weights;
+    std::vector<float> output_bias;
+
+    std::vector<std::deque<std::vector<float>>> history;
+};
+
+/** Exports the reference weights as a NAM WaveNet model, with the given head scale. */
+nlohmann::json makeNAMModel(const ReferenceWaveNet& ref, float head_scale)
+{
+    std::vector<float> weights;
+    const auto pushMatrix = [&weights](const Matrix& m, float scale = 1.0f)
+    {
+        for(const auto& row : m)
+            for(auto x : row)
+                weights.push_back(x * scale);
+    };
+    const auto pushVector = [&weights](const std::vector<float>& v, float scale = 1.0f)
+    {
+        for(auto x : v)
+            weights.push_back(x * scale);
+    };
+
+    pushMatrix(ref.input_weights);
+    for(const auto& lw : ref.layers)
+    {
+        // NAM stores the kernel taps oldest first
+        for(const auto& out_kernels : lw.conv)
+            for(const auto& kernel : out_kernels)
+                for(int k = ref.kernel_size - 1; k >= 0; --k)
+                    weights.push_back(kernel[(size_t)k]);
+        pushVector(lw.conv_bias);
+        pushMatrix(lw.mixin);
+        pushMatrix(lw.residual);
+        pushVector(lw.residual_bias);
+    }
+    pushMatrix(ref.output_weights, 1.0f / head_scale);
+    pushVector(ref.output_bias, 1.0f / head_scale);
+    weights.push_back(head_scale);
+
+    nlohmann::json layer_array;
+    layer_array["input_size"] = ref.in_size;
+    layer_array["condition_size"] = ref.in_size;
+    layer_array["head_size"] = ref.out_size;
+    layer_array["channels"] = ref.channels;
+    layer_array["kernel_size"] = ref.kernel_size;
+    layer_array["dilations"] = ref.dilations;
+    layer_array["activation"] = "Tanh";
+    layer_array["gated"] = true;
+    layer_array["head_bias"] = true;
+
+    nlohmann::json model;
+    model["version"] = "0.5.2";
+    model["architecture"] = "WaveNet";
+    model["config"]["layers"] = { layer_array };
+    model["config"]["head"] = nullptr;
+    model["config"]["head_scale"] = head_scale;
+    model["weights"] = weights;
+    return model;
+}
+
+/** Exports the reference weights as a PyTorch state_dict. */
+nlohmann::json makeTorchStateDict(const ReferenceWaveNet& ref, const std::string& prefix)
+{
+    const auto conv1x1 = [](const Matrix& m)
+    {
+        Kernel w(m.size());
+        for(size_t i = 0; i < m.size(); ++i)
+            for(auto x : m[i])
+                w[i].push_back({ x });
+        return w;
+    };
+
+    nlohmann::json state_dict;
+    state_dict[prefix + "input.weight"] = conv1x1(ref.input_weights);
+    state_dict[prefix + "input.bias"] = ref.input_bias;
+    for(size_t l = 0; l < ref.layers.size(); ++l)
+    {
+        const auto& lw = ref.layers[l];
+        const auto layer_prefix = prefix + "layers." + std::to_string(l) + ".";
+
+        // PyTorch stores the kernel taps oldest first
+        auto conv = lw.conv;
+        for(auto& out_kernels : conv)
+            for(auto& kernel : out_kernels)
+                std::reverse(kernel.begin(), kernel.end());
+
+        state_dict[layer_prefix + "conv.weight"] = conv;
+        state_dict[layer_prefix + "conv.bias"] = lw.conv_bias;
+        state_dict[layer_prefix + "mixin.weight"] = conv1x1(lw.mixin);
+        state_dict[layer_prefix + "residual.weight"] = conv1x1(lw.residual);
+        state_dict[layer_prefix + "residual.bias"] = lw.residual_bias;
+        state_dict[layer_prefix + "skip.weight"] = lw.skip; // a Linear-style 2D weight
+        state_dict[layer_prefix + "skip.bias"] = lw.skip_bias;
+    }
+    state_dict[prefix + "output.weight"] = conv1x1(ref.output_weights);
+    state_dict[prefix + "output.bias"] = ref.output_bias;
+    return state_dict;
+}
+
+/**
+ * Makes a NAM WaveNet model with the "standard" NAM architecture (two chained layer arrays
+ * of un-gated tanh layers, with 16 and 8 channels), and random weights.
+ */
+nlohmann::json makeStandardNAMModel()
+{
+    const std::vector<int> dilations { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 };
+
+    nlohmann::json layer_array;
+    layer_array["input_size"] = 1;
+    layer_array["condition_size"] = 1;
+    layer_array["head_size"] = 8;
+    layer_array["channels"] = 16;
+    layer_array["kernel_size"] = 3;
+    layer_array["dilations"] = dilations;
+    layer_array["activation"] = "Tanh";
+    layer_array["gated"] = false;
+    layer_array["head_bias"] = false;
+
+    nlohmann::json model;
+    model["version"] = "0.5.2";
+    model["architecture"] = "WaveNet";
+    model["config"]["layers"] = { layer_array, layer_array };
+    model["config"]["layers"][1]["input_size"] = 16;
+    model["config"]["layers"][1]["head_size"] = 1;
+    model["config"]["layers"][1]["channels"] = 8;
+    model["config"]["layers"][1]["head_bias"] = true;
+    model["config"]["head"] = nullptr;
+    model["config"]["head_scale"] = 0.02f;
+
+    // the same number of weights as a standard NAM model (including the head scale)
+    std::mt19937 rng { 0x4321 };
+    auto weights = randomVector(rng, 13801);
+    weights.push_back(0.02f);
+    model["weights"] = weights;
+    return model;
+}
+
+/**
+ * A straightforward implementation of a NAM WaveNet model, which reads
+ * the weights in the order that NAM exports them.
+ */
+struct ReferenceNAMWaveNet
+{
+    struct Layer
+    {
+        int dilation;
+        std::vector<float> conv; // [out][in][kernel_size], oldest tap first
+        std::vector<float> conv_bias;
+        std::vector<float> mixin; // [out][condition_size]
+        std::vector<float> residual; // [channels][channels]
+        std::vector<float> residual_bias;
+        std::deque<std::vector<float>> history;
+    };
+
+    struct LayerArray
+    {
+        int in_size;
+        int channels;
+        int head_size;
+        int kernel_size;
+        bool gated;
+        std::vector<float> rechannel; // [channels][in_size]
+        std::vector<Layer> layers;
+        std::vector<float> head; // [head_size][channels]
+        std::vector<float> head_bias;
+    };
+
+    explicit ReferenceNAMWaveNet(const nlohmann::json& model)
+    {
+        const auto weights = model.at("weights").get<std::vector<float>>();
+        auto w = weights.begin();
+        const auto read = [&w](int size)
+        {
+            std::vector<float> values(w, w + size);
+            w += size;
+            return values;
+        };
+
+        for(const auto& config : model.at("config").at("layers"))
+        {
+            LayerArray array;
+            array.in_size = config.at("input_size");
+            array.channels = config.at("channels");
+            array.head_size = config.at("head_size");
+            array.kernel_size = config.at("kernel_size");
+            array.gated = config.at("gated");
+
+            const auto gates = array.gated ? 2 * array.channels : array.channels;
+            array.rechannel = read(array.channels * array.in_size);
+            for(int dilation : config.at("dilations"))
+            {
+                Layer layer;
+                layer.dilation = dilation;
+                layer.conv = read(gates * array.channels * array.kernel_size);
+                layer.conv_bias = read(gates);
+                layer.mixin = read(gates * (int)config.at("condition_size"));
+                layer.residual = read(array.channels * array.channels);
+                layer.residual_bias = read(array.channels);
+                array.layers.push_back(layer);
+            }
+            array.head = read(array.head_size * array.channels);
+            array.head_bias = config.at("head_bias") ? read(array.head_size) : std::vector<float>((size_t)array.head_size, 0.0f);
+            arrays.push_back(array);
+        }
+        head_scale = *w++;
+        EXPECT_EQ(w, weights.end());
+    }
+
+    float forward(float x)
+    {
+        std::vector<float> array_in { x };
+        std::vector<float> head_in;
+        for(auto& array : arrays)
+        {
+            const auto channels = (size_t)array.channels;
+            std::vector<float> h(channels, 0.0f);
+            for(size_t i = 0; i < channels; ++i)
+                for(size_t j = 0; j < array_in.size(); ++j)
+                    h[i] += array.rechannel[i * array_in.size() + j] * array_in[j];
+
+            if(head_in.empty())
+                head_in.resize(channels, 0.0f);
+
+            for(auto& layer : array.layers)
+            {
+                layer.history.push_front(h);
+                if((int)layer.history.size() > (array.kernel_size - 1) * layer.dilation + 1)
+                    layer.history.pop_back();
+
+                auto z = layer.conv_bias;
+                for(size_t i = 0; i < z.size(); ++i)
+                {
+                    z[i] += layer.mixin[i] * x;
+                    for(int k = 0; k < array.kernel_size; ++k)
+                    {
+                        const auto delay = (size_t)((array.kernel_size - 1 - k) * layer.dilation);
+                        if(delay >= layer.history.size())
+                            continue;
+
+                        for(size_t j = 0; j < channels; ++j)
+                            z[i] += layer.conv[(i * channels + j) * (size_t)array.kernel_size + (size_t)k] * layer.history[delay][j];
+                    }
+                }
+
+                std::vector<float> a(channels);
+                for(size_t i = 0; i < channels; ++i)
+                    a[i] = array.gated ? std::tanh(z[i]) * (1.0f / (1.0f + std::exp(-z[i + channels]))) : std::tanh(z[i]);
+
+                for(size_t i = 0; i < channels; ++i)
+                {
+                    head_in[i] += a[i];
+                    h[i] += layer.residual_bias[i];
+                    for(size_t j = 0; j < channels; ++j)
+                        h[i] += layer.residual[i * channels + j] * a[j];
+                }
+            }
+
+            auto head_out = array.head_bias;
+            for(size_t i = 0; i < head_out.size(); ++i)
+                for(size_t j = 0; j < channels; ++j)
+                    head_out[i] += array.head[i * channels + j] * head_in[j];
+
+            array_in = h;
+            head_in = head_out;
+        }
+
+        return head_scale * head_in[0];
+    }
+
+    std::vector<LayerArray> arrays;
+    float head_scale = 1.0f;
+};
+
+template <typename Forward>
+void checkAgainstReference(ReferenceWaveNet& ref, Forward&& forward)
+{
+    const auto inputs = makeInputs(num_samples, ref.in_size, 0x1234);
+    EXPECT_LT(maxError(inputs, referenceOutputs(ref, inputs), forward), 2.0e-5f);
+}
+} // namespace
+
+TEST(TestWaveNet, MatchesReference)
+{
+    ReferenceWaveNet ref { 2, 3, 6, 5, 3, { 1, 2, 4, 1 } };
+
+    RTNeural::WaveNet<float> wavenet { 2, 3, 6, 5, 3, { 1, 2, 4, 1 } };
+    ref.setWeights(wavenet);
+    wavenet.reset();
+
+    alignas(RTNEURAL_DEFAULT_ALIGNMENT) float out[8] {};
+    checkAgainstReference(ref, [&](const float* in)
+        {
+            wavenet.forward(in, out);
+            return out; });
+}
+
+TEST(TestWaveNet, MatchesReferenceTemplated)
+{
+    ReferenceWaveNet ref { 1, 1, 6, 5, 3, { 1, 2, 4, 1 } };
+
+    RTNeural::ModelT<float, 1, 1,
+        RTNeural::WaveNetT<float, 1, 1, 6, 5, 3, std::integer_sequence<int, 1, 2, 4, 1>>>
+        model;
+    ref.setWeights(model.get<0>());
+    model.reset();
+
+    checkAgainstReference(ref, [&](const float* in)
+        {
+            model.forward(in);
+            return model.getOutputs(); });
+}
+
+TEST(TestWaveNet, LoadsNAMModel)
+{
+    ReferenceWaveNet ref { 1, 1, 4, 4, 3, { 1, 2, 4, 8, 1, 2 }, true };
+    const auto namModel = makeNAMModel(ref, 0.25f);
+
+    auto model = std::make_unique<RTNeural::Model<float>>(1);
+    auto wavenet = RTNeural::json_parser::createNAMWaveNet<float>(namModel);
+    ASSERT_NE(wavenet, nullptr);
+    model->addLayer(wavenet.release());
+    model->reset();
+
+    checkAgainstReference(ref, [&](const float* in)
+        {
+            model->forward(in);
+            return model->getOutputs(); });
+
+    // the layer dimensions must match the model
+    RTNeural::WaveNet<float> wrongWaveNet { 1, 1, 4, 4, 3, { 1, 2, 4, 8, 1, 1 } };
+    EXPECT_FALSE(RTNeural::json_parser::loadNAMWaveNet<float>(wrongWaveNet, namModel));
+}
+
+TEST(TestWaveNet, LoadsTorchModel)
+{
+    ReferenceWaveNet ref { 1, 1, 6, 3, 2, { 1, 2, 4, 8 } };
+    const auto stateDict = makeTorchStateDict(ref, "wavenet.");
+
+    RTNeural::ModelT<float, 1, 1,
+        RTNeural::WaveNetT<float, 1, 1, 6, 3, 2, std::integer_sequence<int, 1, 2, 4, 8>>>
+        model;
+    RTNeural::torch_helpers::loadWaveNet<float>(stateDict, "wavenet.", model.get<0>());
+    model.reset();
+
+    checkAgainstReference(ref, [&](const float* in)
+        {
+            model.forward(in);
+            return model.getOutputs(); });
+}
+
+TEST(TestWaveNet, LoadsStandardNAMModel)
+{
+    const auto namModel = makeStandardNAMModel();
+    ReferenceNAMWaveNet ref { namModel };
+
+    auto model = std::make_unique<RTNeural::Model<float>>(1);
+    auto wavenet = RTNeural::json_parser::createNAMWaveNet<float>(namModel);
+    ASSERT_NE(wavenet, nullptr);
+    ASSERT_EQ(wavenet->getNumLayerArrays(), 2);
+    model->addLayer(wavenet.release());
+    model->reset();
+
+    using Dilations = std::integer_sequence<int, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512>;
+    RTNeural::ModelT<float, 1, 1,
+        RTNeural::WaveNetArraysT<float, 1, 1, RTNeural::DefaultMathsProvider,
+            RTNeural::WaveNetArrayConfigT<16, 16, 8, 3, Dilations, false>,
+            RTNeural::WaveNetArrayConfigT<8, 8, 1, 3, Dilations, false>>>
+        modelT;
+    ASSERT_TRUE(RTNeural::json_parser::loadNAMWaveNet<float>(modelT.get<0>(), namModel));
+    modelT.reset();
+
+    // long enough for the receptive field of the first layer array to fill up
+    std::mt19937 rng { 0x5678 };
+    std::uniform_real_distribution<float> dist(-1.0f, 1.0f);
+    for(int n = 0; n < 5000; ++n)
+    {
+        float x = dist(rng);
+        const auto expected = ref.forward(x);
+        ASSERT_NEAR(model->forward(&x), expected, 1.0e-5f) << "sample " << n;
+        ASSERT_NEAR(modelT.forward(&x), expected, 1.0e-5f) << "sample " << n;
+    }
+
+    // a gated layer array can't load un-gated weights
+    const std::vector<int> dilations { 1, 2, 4, 8, 16, 32, 64, 128, 256, 512 };
+    RTNeural::WaveNet<float> gatedWaveNet { 1, 1, { { 16, 16, 8, 3, dilations, true }, { 8, 8, 1, 3, dilations, true } } };
+    EXPECT_FALSE(RTNeural::json_parser::loadNAMWaveNet<float>(gatedWaveNet, namModel));
+}
@@ -0,0 +1,32 @@
+#include <gmock/gmock.h>
+
+#include "../cpu_support_environment.hpp"
+
+using namespace testing;
+
+TEST(CPUFeaturesTest, detectedFeaturesAreConsistent)
+{
+    const auto features = RTNeural::getCPUFeatures();
+
+    // each instruction set implies support for the previous one
+    if(features.avx512)
+        EXPECT_TRUE(features.avx2);
+    if(features.avx2)
+        EXPECT_TRUE(features.sse4_1);
+}
+
+TEST(CPUFeaturesTest, compiledArchIsSupported)
+{
+    // if the compiled instruction set was not supported, the CPUSupportEnvironment would skip this test
+    EXPECT_TRUE(RTNeural::isCompiledArchSupported());
+
+#if RTNEURAL_AVX512_ENABLED
+    EXPECT_THAT(RTNeural::getCompiledArchName(), StrEq("AVX-512"));
+    EXPECT_EQ(RTNEURAL_DEFAULT_ALIGNMENT, 64);
+#elif RTNEURAL_AVX_ENABLED
+    EXPECT_THAT(RTNeural::getCompiledArchName(), StrEq("AVX2"));
+    EXPECT_EQ(RTNEURAL_DEFAULT_ALIGNMENT, 32);
+#else
+    EXPECT_THAT(RTNeural::getCompiledArchName(), StrEq("default"));
+#endif
+}
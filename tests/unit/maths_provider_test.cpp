@@ -0,0 +1,134 @@
+#include <gmock/gmock.h>
+
+#include <RTNeural/RTNeural.h>
+#include <cmath>
+#include <vector>
+
+using namespace testing;
+
+namespace
+{
+enum class Function
+{
+    Tanh,
+    Sigmoid,
+    Exp,
+};
+
+// Evaluates the function with the provider, using the backend's vector types.
+template <typename Provider, typename T>
+std::vector<T> evaluate(Function function, const std::vector<T>& x)
+{
+    std::vector<T> y(x.size());
+
+#if RTNEURAL_USE_EIGEN
+    using vec_type = Eigen::Matrix<T, Eigen::Dynamic, 1>;
+    const Eigen::Map<const vec_type> xVec(x.data(), (Eigen::Index)x.size());
+    Eigen::Map<vec_type> yVec(y.data(), (Eigen::Index)y.size());
+    if(function == Function::Tanh)
+        yVec = Provider::tanh(xVec);
+    else if(function == Function::Sigmoid)
+        yVec = Provider::sigmoid(xVec);
+    else
+        yVec = Provider::exp(xVec);
+#elif RTNEURAL_USE_XSIMD
+    using b_type = xsimd::simd_type<T>;
+    size_t i = 0;
+    for(; i + b_type::size <= x.size(); i += b_type::size)
+    {
+        const auto xBatch = xsimd::load_unaligned(&x[i]);
+        const auto yBatch = function == Function::Tanh ? Provider::tanh(xBatch)
+            : function == Function::Sigmoid            ? Provider::sigmoid(xBatch)
+                                                       : Provider::exp(xBatch);
+        xsimd::store_unaligned(&y[i], yBatch);
+    }
+
+    // the scalar path is used at the end of some loops
+    for(; i < x.size(); ++i)
+        y[i] = function == Function::Tanh ? Provider::tanh(x[i]) : function == Function::Sigmoid ? Provider::sigmoid(x[i])
+                                                                                                 : Provider::exp(x[i]);
+#else
+    for(size_t i = 0; i < x.size(); ++i)
+        y[i] = function == Function::Tanh ? Provider::tanh(x[i]) : function == Function::Sigmoid ? Provider::sigmoid(x[i])
+                                                                                                 : Provider::exp(x[i]);
+#endif
+
+    return y;
+}
+
+template <typename T>
+std::vector<T> linspace(T start, T end, int num_points)
+{
+    std::vector<T> x((size_t)num_points);
+    for(int i = 0; i < num_points; ++i)
+        x[(size_t)i] = start + (end - start) * (T)i / (T)(num_points - 1);
+    return x;
+}
+
+template <typename Provider, typename T>
+void checkProvider(double tanh_tolerance, double sigmoid_tolerance, double exp_rel_tolerance)
+{
+    // odd number of points, so that the xsimd scalar path is also tested
+    const auto x = linspace<T>((T)-12, (T)12, 4001);
+
+    const auto yTanh = evaluate<Provider>(Function::Tanh, x);
+    const auto ySigmoid = evaluate<Provider>(Function::Sigmoid, x);
+    for(size_t i = 0; i < x.size(); ++i)
+    {
+        const auto xd = (double)x[i];
+        EXPECT_NEAR((double)yTanh[i], std::tanh(xd), tanh_tolerance) << "x = " << xd;
+        EXPECT_NEAR((double)ySigmoid[i], 1.0 / (1.0 + std::exp(-xd)), sigmoid_tolerance) << "x = " << xd;
+        EXPECT_LE(std::abs((double)yTanh[i]), 1.0);
+    }
+
+    const auto xExp = linspace<T>((T)-60, (T)60, 4001);
+    const auto yExp = evaluate<Provider>(Function::Exp, xExp);
+    for(size_t i = 0; i < xExp.size(); ++i)
+    {
+        const auto expected = std::exp((double)xExp[i]);
+        EXPECT_NEAR((double)yExp[i] / expected, 1.0, exp_rel_tolerance) << "x = " << xExp[i];
+    }
+
+    // saturation outside of the approximation range
+    const auto yLarge = evaluate<Provider>(Function::Exp, std::vector<T> { (T)-1000, (T)1000 });
+    EXPECT_GE(yLarge[0], (T)0);
+    EXPECT_TRUE(std::isfinite(yLarge[1]));
+    const auto tanhLarge = evaluate<Provider>(Function::Tanh, std::vector<T> { (T)-1000, (T)1000 });
+    EXPECT_NEAR((double)tanhLarge[0], -1.0, tanh_tolerance);
+    EXPECT_NEAR((double)tanhLarge[1], 1.0, tanh_tolerance);
+}
+} // namespace
+
+TEST(TestMathsProviders, PadeMathsProviderIsAccurate)
+{
+    checkProvider<RTNeural::PadeMathsProvider, float>(1.0e-4, 5.0e-5, 5.0e-7);
+    checkProvider<RTNeural::PadeMathsProvider, double>(1.0e-4, 5.0e-5, 2.0e-7);
+}
+
+TEST(TestMathsProviders, Exp2MathsProviderIsAccurate)
+{
+    checkProvider<RTNeural::Exp2MathsProvider, float>(1.0e-4, 5.0e-5, 1.1e-4);
+    checkProvider<RTNeural::Exp2MathsProvider, double>(1.0e-4, 5.0e-5, 1.1e-4);
+}
+
+TEST(TestMathsProviders, PolynomialMathsProviderIsAccurate)
+{
+    checkProvider<RTNeural::PolynomialMathsProvider, float>(5.0e-5, 2.5e-5, 5.0e-7);
+    checkProvider<RTNeural::PolynomialMathsProvider, double>(5.0e-5, 2.5e-5, 2.0e-7);
+}
+
+TEST(TestMathsProviders, LUTMathsProviderIsAccurate)
+{
+    using Linear = RTNeural::LUTMathsProvider<>;
+    Linear::initialise<float>();
+    checkProvider<Linear, float>(3.0e-5, 1.5e-5, 5.0e-7);
+    checkProvider<Linear, double>(3.0e-5, 1.5e-5, 1.0e-7);
+
+    using Cubic = RTNeural::LUTMathsProvider<1024, 8, RTNeural::approx_maths::LUTInterpolation::Cubic>;
+    checkProvider<Cubic, float>(2.0e-6, 1.0e-6, 5.0e-7);
+    checkProvider<Cubic, double>(2.0e-6, 1.0e-6, 1.0e-7);
+
+    // a smaller table, which saturates at tanh(+/- 4)
+    using Small = RTNeural::LUTMathsProvider<128, 4, RTNeural::approx_maths::LUTInterpolation::Cubic>;
+    checkProvider<Small, float>(7.0e-4, 3.5e-4, 1.0e-6);
+}